@@ -13,9 +13,33 @@
 #pragma once
 
 #include <drjit-core/traits.h>
+#include <utility>
 
 NAMESPACE_BEGIN(drjit)
 
+/* Binary operations have separate overloads for temporary operands, whose
+   references are handed over to jit_var_op_steal() instead of being released
+   by a separate call to jit_var_dec_ref() (each call acquires a lock). */
+#define DRJIT_ARRAY_BINARY_OP(Result, name, op, func)                          \
+    Result name(const JitArray &v) const & {                                   \
+        return Result::steal(func(m_index, v.m_index));                        \
+    }                                                                          \
+    Result name(JitArray &&v) const & {                                        \
+        Result result = Result::steal(op_steal(op, m_index, v.m_index, 2));    \
+        v.m_index = 0;                                                         \
+        return result;                                                         \
+    }                                                                          \
+    Result name(const JitArray &v) && {                                        \
+        Result result = Result::steal(op_steal(op, m_index, v.m_index, 1));    \
+        m_index = 0;                                                           \
+        return result;                                                         \
+    }                                                                          \
+    Result name(JitArray &&v) && {                                             \
+        Result result = Result::steal(op_steal(op, m_index, v.m_index, 3));    \
+        m_index = v.m_index = 0;                                               \
+        return result;                                                         \
+    }
+
 template <JitBackend Backend_, typename Value_> struct JitArray {
     using Value = Value_;
     using Mask = JitArray<Backend_, bool>;
@@ -91,41 +115,15 @@ template <JitBackend Backend_, typename Value_> struct JitArray {
         return steal(jit_var_not(m_index));
     }
 
-    JitArray operator+(const JitArray &v) const {
-        return steal(jit_var_add(m_index, v.m_index));
-    }
-
-    JitArray operator-(const JitArray &v) const {
-        return steal(jit_var_sub(m_index, v.m_index));
-    }
-
-    JitArray operator*(const JitArray &v) const {
-        return steal(jit_var_mul(m_index, v.m_index));
-    }
-
-    JitArray operator/(const JitArray &v) const {
-        return steal(jit_var_div(m_index, v.m_index));
-    }
-
-    JitArray operator%(const JitArray &v) const {
-        return steal(jit_var_mod(m_index, v.m_index));
-    }
-
-    Mask operator>(const JitArray &v) const {
-        return Mask::steal(jit_var_gt(m_index, v.m_index));
-    }
-
-    Mask operator>=(const JitArray &v) const {
-        return Mask::steal(jit_var_ge(m_index, v.m_index));
-    }
-
-    Mask operator<(const JitArray &v) const {
-        return Mask::steal(jit_var_lt(m_index, v.m_index));
-    }
-
-    Mask operator<=(const JitArray &v) const {
-        return Mask::steal(jit_var_le(m_index, v.m_index));
-    }
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator+, JitOp::Add, jit_var_add)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator-, JitOp::Sub, jit_var_sub)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator*, JitOp::Mul, jit_var_mul)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator/, JitOp::Div, jit_var_div)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator%, JitOp::Mod, jit_var_mod)
+    DRJIT_ARRAY_BINARY_OP(Mask, operator>,  JitOp::Gt, jit_var_gt)
+    DRJIT_ARRAY_BINARY_OP(Mask, operator>=, JitOp::Ge, jit_var_ge)
+    DRJIT_ARRAY_BINARY_OP(Mask, operator<,  JitOp::Lt, jit_var_lt)
+    DRJIT_ARRAY_BINARY_OP(Mask, operator<=, JitOp::Le, jit_var_le)
 
     friend Mask eq(const JitArray &v1, const JitArray &v2) {
         return Mask::steal(jit_var_eq(v1.m_index, v2.m_index));
@@ -145,41 +143,50 @@ template <JitBackend Backend_, typename Value_> struct JitArray {
 
     template <typename T, enable_if_t<std::is_same<T, Value_>::value ||
                                       std::is_same<T, bool>::value> = 0>
-    JitArray operator|(const JitArray<Backend_, T> &v) const {
+    JitArray operator|(const JitArray<Backend_, T> &v) const & {
         return steal(jit_var_or(m_index, v.index()));
     }
 
     template <typename T, enable_if_t<std::is_same<T, Value_>::value ||
                                       std::is_same<T, bool>::value> = 0>
-    JitArray operator&(const JitArray<Backend_, T> &v) const {
-        return steal(jit_var_and(m_index, v.index()));
+    JitArray operator|(const JitArray<Backend_, T> &v) && {
+        JitArray result = steal(op_steal(JitOp::Or, m_index, v.index(), 1));
+        m_index = 0;
+        return result;
     }
 
-    JitArray operator^(const JitArray &v) const {
-        return steal(jit_var_xor(m_index, v.m_index));
+    template <typename T, enable_if_t<std::is_same<T, Value_>::value ||
+                                      std::is_same<T, bool>::value> = 0>
+    JitArray operator&(const JitArray<Backend_, T> &v) const & {
+        return steal(jit_var_and(m_index, v.index()));
     }
 
-    JitArray operator<<(const JitArray &v) const {
-        return steal(jit_var_shl(m_index, v.m_index));
+    template <typename T, enable_if_t<std::is_same<T, Value_>::value ||
+                                      std::is_same<T, bool>::value> = 0>
+    JitArray operator&(const JitArray<Backend_, T> &v) && {
+        JitArray result = steal(op_steal(JitOp::And, m_index, v.index(), 1));
+        m_index = 0;
+        return result;
     }
 
-    JitArray operator>>(const JitArray &v) const {
-        return steal(jit_var_shr(m_index, v.m_index));
-    }
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator^,  JitOp::Xor, jit_var_xor)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator<<, JitOp::Shl, jit_var_shl)
+    DRJIT_ARRAY_BINARY_OP(JitArray, operator>>, JitOp::Shr, jit_var_shr)
 
-    JitArray &operator+=(const JitArray &v) { return operator=(*this + v); }
-    JitArray &operator-=(const JitArray &v) { return operator=(*this - v); }
-    JitArray &operator*=(const JitArray &v) { return operator=(*this * v); }
-    JitArray &operator/=(const JitArray &v) { return operator=(*this / v); }
+    // In-place updates hand over the reference held by the array itself
+    JitArray &operator+=(const JitArray &v) { return operator=(std::move(*this) + v); }
+    JitArray &operator-=(const JitArray &v) { return operator=(std::move(*this) - v); }
+    JitArray &operator*=(const JitArray &v) { return operator=(std::move(*this) * v); }
+    JitArray &operator/=(const JitArray &v) { return operator=(std::move(*this) / v); }
     template <typename T = Value_, enable_if_t<!std::is_same<T, bool>::value> = 0>
-    JitArray &operator|=(const JitArray &v) { return operator=(*this | v); }
+    JitArray &operator|=(const JitArray &v) { return operator=(std::move(*this) | v); }
     template <typename T = Value_, enable_if_t<!std::is_same<T, bool>::value> = 0>
-    JitArray &operator&=(const JitArray &v) { return operator=(*this & v); }
-    JitArray &operator|=(const JitArray<Backend, bool> &v) { return operator=(*this | v); }
-    JitArray &operator&=(const JitArray<Backend, bool> &v) { return operator=(*this & v); }
-    JitArray &operator^=(const JitArray &v) { return operator=(*this ^ v); }
-    JitArray& operator<<=(const JitArray &v) { return operator=(*this << v); }
-    JitArray& operator>>=(const JitArray &v) { return operator=(*this >> v); }
+    JitArray &operator&=(const JitArray &v) { return operator=(std::move(*this) & v); }
+    JitArray &operator|=(const JitArray<Backend, bool> &v) { return operator=(std::move(*this) | v); }
+    JitArray &operator&=(const JitArray<Backend, bool> &v) { return operator=(std::move(*this) & v); }
+    JitArray &operator^=(const JitArray &v) { return operator=(std::move(*this) ^ v); }
+    JitArray& operator<<=(const JitArray &v) { return operator=(std::move(*this) << v); }
+    JitArray& operator>>=(const JitArray &v) { return operator=(std::move(*this) >> v); }
 
     template <typename V = Value, enable_if_t<std::is_same<V, bool>::value> = 0>
     JitArray operator&&(const JitArray &v) const {
@@ -353,9 +360,17 @@ template <JitBackend Backend_, typename Value_> struct JitArray {
 		v.m_index = index;
 	}
 protected:
+    /// Perform 'op' and hand over the references selected by 'steal' (bit mask)
+    static uint32_t op_steal(JitOp op, uint32_t a0, uint32_t a1, uint32_t steal) {
+        uint32_t dep[2] = { a0, a1 };
+        return jit_var_op_steal(op, dep, steal);
+    }
+
     uint32_t m_index = 0;
 };
 
+#undef DRJIT_ARRAY_BINARY_OP
+
 template <typename Array>
 Array empty(size_t size) {
     size_t byte_size = size * sizeof(typename Array::Value);
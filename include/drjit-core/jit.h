@@ -178,7 +178,8 @@ extern JIT_EXPORT int jit_cuda_device_count();
  * The argument must be between 0 and <tt>jit_cuda_device_count() - 1</tt>,
  * which only accounts for Dr.Jit-compatible devices. This is a per-thread
  * property: independent threads can optionally issue computation to different
- * GPUs.
+ * GPUs. Switching does not block the host: work submitted afterwards simply
+ * waits for the work that was previously submitted to the old device.
  */
 extern JIT_EXPORT void jit_cuda_set_device(int device);
 
@@ -227,6 +228,121 @@ extern JIT_EXPORT void jit_cuda_set_target(uint32_t ptx_version,
 /// Look up an CUDA driver function by name
 extern JIT_EXPORT void *jit_cuda_lookup(const char *name);
 
+/**
+ * \brief Begin capturing CUDA work into a graph
+ *
+ * Kernel launches, memory copies, and other operations subsequently issued to
+ * the stream of the current thread are recorded into a CUDA graph instead of
+ * being executed. The captured work runs when the matching call to \ref
+ * jit_cuda_graph_end() launches the graph. This reduces CPU launch overheads
+ * when the same sequence of kernels is issued many times (e.g. in a training
+ * loop).
+ *
+ * The captured region may not synchronize with the device (e.g. by reading
+ * array contents, or via \ref JitFlag::LaunchBlocking). Note that the stream
+ * is shared by all threads using the same device.
+ */
+extern JIT_EXPORT void jit_cuda_graph_begin();
+
+/**
+ * \brief Stop capturing CUDA work and launch the resulting graph
+ *
+ * When the captured graph has the same structure as the one from the previous
+ * capture, the existing executable graph is updated in place: only kernel
+ * parameters (e.g. array addresses) are patched. Otherwise, a new executable
+ * graph is instantiated. The function returns \c 1 in the former case, and
+ * \c 0 in the latter.
+ */
+extern JIT_EXPORT int jit_cuda_graph_end();
+
+/**
+ * \brief Make the stream of the current thread wait for work on \c stream
+ *
+ * Work that is subsequently submitted by Dr.Jit only starts once the work
+ * previously submitted to the foreign CUDA stream \c stream (e.g. by PyTorch
+ * or JAX) has finished. The dependency is established using an event and does
+ * not block the host.
+ */
+extern JIT_EXPORT void jit_cuda_stream_wait(void *stream);
+
+/**
+ * \brief Make \c stream wait for the work on the stream of the current thread
+ *
+ * This is the counterpart of \ref jit_cuda_stream_wait(): work subsequently
+ * submitted to the foreign CUDA stream \c stream only starts once the kernels
+ * previously launched by Dr.Jit have finished.
+ */
+extern JIT_EXPORT void jit_cuda_stream_signal(void *stream);
+
+/**
+ * \brief Import a memory region exported by another API (e.g. Vulkan, D3D12)
+ *
+ * \param handle_type
+ *     Type of the handle, specified using the values of the CUDA driver
+ *     enumeration \c CUexternalMemoryHandleType.
+ *
+ * \param handle
+ *     The OS handle. File descriptors (\c OPAQUE_FD) are passed as
+ *     <tt>(void *) (intptr_t) fd</tt>, and their ownership passes to CUDA.
+ *
+ * \param size
+ *     Size of the memory region in bytes
+ *
+ * \param dedicated
+ *     Must be nonzero if the memory was created as a dedicated allocation.
+ *
+ * \param ptr
+ *     Receives the device address of the mapped memory region, which can then
+ *     be used without copies via \ref jit_var_mem_map() (with <tt>free =
+ *     0</tt>).
+ *
+ * The function returns an opaque handle that must be released using \ref
+ * jit_cuda_external_memory_destroy() once no variable refers to the memory
+ * region anymore.
+ */
+extern JIT_EXPORT void *jit_cuda_external_memory_import(int handle_type,
+                                                        void *handle,
+                                                        size_t size,
+                                                        int dedicated,
+                                                        void **ptr);
+
+/// Release a memory region imported by \ref jit_cuda_external_memory_import()
+extern JIT_EXPORT void jit_cuda_external_memory_destroy(void *memory);
+
+/**
+ * \brief Import a semaphore exported by another API (e.g. Vulkan, D3D12)
+ *
+ * The parameters \c handle_type (taking the values of the CUDA driver
+ * enumeration \c CUexternalSemaphoreHandleType) and \c handle behave as in
+ * \ref jit_cuda_external_memory_import(). The function returns an opaque
+ * handle that must be released using \ref
+ * jit_cuda_external_semaphore_destroy().
+ */
+extern JIT_EXPORT void *jit_cuda_external_semaphore_import(int handle_type,
+                                                           void *handle);
+
+/**
+ * \brief Make the stream of the current thread wait for an external semaphore
+ *
+ * The parameter \c value specifies the fence value of timeline semaphores and
+ * D3D12 fences and is ignored otherwise.
+ */
+extern JIT_EXPORT void jit_cuda_external_semaphore_wait(void *semaphore,
+                                                        uint64_t value);
+
+/**
+ * \brief Signal an external semaphore once the work previously submitted to
+ * the stream of the current thread has finished
+ *
+ * The parameter \c value specifies the fence value of timeline semaphores and
+ * D3D12 fences and is ignored otherwise.
+ */
+extern JIT_EXPORT void jit_cuda_external_semaphore_signal(void *semaphore,
+                                                          uint64_t value);
+
+/// Release a semaphore imported by \ref jit_cuda_external_semaphore_import()
+extern JIT_EXPORT void jit_cuda_external_semaphore_destroy(void *semaphore);
+
 /**
  * \brief Override the target CPU, features, and vector width of the LLVM backend
  *
@@ -250,6 +366,23 @@ extern JIT_EXPORT void jit_llvm_set_target(const char *target_cpu,
                                            const char *target_features,
                                            uint32_t vector_width);
 
+/**
+ * \brief Also write LLVM kernels for another CPU to the kernel cache
+ *
+ * A kernel cache may be shared by machines with different CPUs (e.g., nodes
+ * of a cluster that support AVX2 or AVX-512). When this function was used to
+ * register further targets, each kernel written to the cache is additionally
+ * compiled for them, and a machine thus finds a version matching its own CPU
+ * even if another machine encountered the kernel first. The targets
+ * otherwise resemble the parameters of \ref jit_llvm_set_target().
+ *
+ * Versions share the generated IR, which depends on the vector width: all
+ * machines should therefore use the same width (e.g., 8 for AVX2 and AVX-512).
+ * Passing <tt>nullptr</tt> as \c target_cpu clears the list of targets.
+ */
+extern JIT_EXPORT void jit_llvm_add_target_version(const char *target_cpu,
+                                                   const char *target_features);
+
 /// Get the CPU that is currently targeted by the LLVM backend
 extern JIT_EXPORT const char *jit_llvm_target_cpu();
 
@@ -265,6 +398,53 @@ extern JIT_EXPORT uint32_t jit_llvm_vector_width();
 /// Specify the number of threads that are used to parallelize the computation
 extern JIT_EXPORT void jit_llvm_set_thread_count(uint32_t size);
 
+#if defined(__cplusplus)
+/// NUMA policies of the LLVM backend, see \ref jit_llvm_set_numa_policy()
+enum class NumaPolicy : uint32_t {
+    /// Leave memory placement and thread scheduling to the OS (default)
+    Default = 0,
+
+    /// Interleave the pages of large host allocations across all nodes
+    Interleave = 1,
+
+    /// Pin workers to nodes and keep each part of an array on the same node
+    Local = 2
+};
+#else
+enum NumaPolicy {
+    NumaPolicyDefault = 0,
+    NumaPolicyInterleave = 1,
+    NumaPolicyLocal = 2
+};
+#endif
+
+/**
+ * \brief Configure how the LLVM backend deals with NUMA systems
+ *
+ * On multi-socket machines, memory accesses to a remote node are considerably
+ * slower than accesses to local memory.
+ *
+ * <tt>NumaPolicy::Interleave</tt> spreads the pages of new large host memory
+ * allocations (<tt>AllocType::Host</tt> and <tt>AllocType::HostAsync</tt>)
+ * across all nodes. This balances the memory traffic without requiring any
+ * locality.
+ *
+ * <tt>NumaPolicy::Local</tt> pins the worker threads of the thread pool to the
+ * CPUs of a node (in round-robin order). Each kernel launch then assigns
+ * contiguous ranges of its blocks to nodes, and workers prefer blocks of their
+ * own node. Since the OS places pages on the node that first touches them, a
+ * given part of an array then consistently stays on the same node.
+ *
+ * The function currently only has an effect on Linux.
+ */
+extern JIT_EXPORT void jit_llvm_set_numa_policy(JIT_ENUM NumaPolicy policy);
+
+/// Return the NUMA policy of the LLVM backend
+extern JIT_EXPORT JIT_ENUM NumaPolicy jit_llvm_numa_policy();
+
+/// Return the number of NUMA nodes with CPUs (1 on non-NUMA machines)
+extern JIT_EXPORT uint32_t jit_llvm_numa_nodes();
+
 // ====================================================================
 //                        Logging infrastructure
 // ====================================================================
@@ -369,14 +549,28 @@ enum class AllocType : uint32_t {
      */
     Device,
 
+    /**
+     * Unified memory obtained via <tt>cuMemAllocManaged()</tt> that is
+     * accessible from the host and from all GPUs. Pages migrate on demand,
+     * which makes it possible to process data sets exceeding the memory of
+     * the GPU. Before launching a kernel, Dr.Jit prefetches the managed
+     * memory accessed by it to the device to avoid page faults (see also
+     * \ref jit_malloc_prefetch() and \ref JitFlag::ManagedMemory).
+     *
+     * Managed memory has asynchronous semantics similar to \c HostAsync.
+     */
+    Managed,
+
     /// Number of possible allocation types
     Count
 };
 #else
 enum AllocType {
     AllocTypeHost,
+    AllocTypeHostAsync,
     AllocTypeHostPinned,
     AllocTypeDevice,
+    AllocTypeManaged,
     AllocTypeCount
 };
 #endif
@@ -424,15 +618,359 @@ extern JIT_EXPORT void *jit_malloc(JIT_ENUM AllocType type, size_t size)
  */
 extern JIT_EXPORT void jit_free(void *ptr);
 
+/**
+ * \brief Allocate memory that can later be enlarged in place
+ *
+ * This function behaves like \ref jit_malloc(), except that the returned
+ * memory region can subsequently grow up to \c capacity bytes via \ref
+ * jit_malloc_grow() without copying its contents and without temporarily
+ * requiring memory for two copies. This is useful for output buffers whose
+ * final size is not known in advance, e.g. when compacting arrays via \ref
+ * jit_var_scatter_inc().
+ *
+ * For <tt>AllocType::Device</tt>, Dr.Jit reserves a range of virtual addresses
+ * and maps physical memory into it on demand (this requires support for CUDA
+ * virtual memory management). Other flavors of memory, or devices lacking
+ * this feature, fall back to a regular \ref jit_malloc() call. In that case,
+ * \ref jit_malloc_grow() only succeeds if the requested size already fits.
+ *
+ * The memory is released using \ref jit_free().
+ */
+extern JIT_EXPORT void *jit_malloc_reserve(JIT_ENUM AllocType type,
+                                           size_t size, size_t capacity)
+    JIT_MALLOC;
+
+/**
+ * \brief Try to enlarge a memory region in place
+ *
+ * Returns \c true if the region starting at \c ptr now provides at least \c
+ * size bytes while remaining at the same address. See \ref
+ * jit_malloc_reserve() for details.
+ */
+extern JIT_EXPORT int jit_malloc_grow(void *ptr, size_t size);
+
+/**
+ * \brief Prefetch a managed memory region to a device or to the host
+ *
+ * Asynchronously migrates the pages of the \ref AllocType::Managed allocation
+ * \c ptr to the CUDA device with index \c device, or to the host when \c
+ * device is <tt>-1</tt>. The operation is ordered with respect to the other
+ * work of the calling thread's CUDA stream. It has no effect for other types
+ * of memory, or when the device does not support concurrent managed access.
+ */
+extern JIT_EXPORT void jit_malloc_prefetch(void *ptr, int device);
+
 /// Release all currently unused memory to the GPU / OS
 extern JIT_EXPORT void jit_flush_malloc_cache();
 
-/// Clear the peak memory usage statistics
+/// Clear the peak memory usage statistics (and those of \ref jit_malloc_profile())
 extern JIT_EXPORT void jit_malloc_clear_statistics();
 
+/**
+ * \brief Return a report describing how memory is used
+ *
+ * This function requires that \ref JitFlag::MallocProfile was enabled while
+ * the allocations of interest took place. For each flavor of memory, the
+ * report lists
+ *
+ * - the allocations that were live at the time of peak usage, aggregated by
+ *   the label, index, and hash of the producing variable and kernel,
+ *
+ * - a histogram of the lifetimes of released allocations, and
+ *
+ * - the unused memory held by the allocation cache in several size bins.
+ *
+ * The information can be used to tune array sizes and the flushing of the
+ * allocation cache. The returned string remains valid until the next call.
+ */
+extern JIT_EXPORT const char *jit_malloc_profile();
+
+/**
+ * \brief Set a soft limit on the memory allocated for a given type
+ *
+ * Once the total amount of memory allocated by Dr.Jit for \c type (including
+ * unused blocks held by the allocation cache) would exceed \c limit, Dr.Jit
+ * releases cached blocks (largest ones first) until usage drops to 7/8 of the
+ * limit, and then invokes the memory pressure callback (if any). The limit is
+ * soft: allocations that are still needed afterwards will succeed if the
+ * device/OS can service them. Specify <tt>limit=0</tt> to remove the limit.
+ */
+extern JIT_EXPORT void jit_malloc_set_limit(JIT_ENUM AllocType type,
+                                            size_t limit);
+
+#if defined(__cplusplus)
+/// Page size policies for large host allocations
+enum class HugePagePolicy : uint32_t {
+    /// Use regular (4 KiB) pages
+    Disabled = 0,
+
+    /// Ask the OS to back the memory with transparent huge pages (Linux)
+    Transparent = 1,
+
+    /// Allocate huge/large pages explicitly, falling back to \c Transparent
+    Explicit = 2
+};
+#else
+enum HugePagePolicy {
+    HugePagePolicyDisabled = 0,
+    HugePagePolicyTransparent = 1,
+    HugePagePolicyExplicit = 2
+};
+#endif
+
+/**
+ * \brief Control whether large host allocations use huge pages
+ *
+ * Gather-heavy kernels operating on arrays of hundreds of megabytes spend a
+ * significant amount of time handling TLB misses when the memory is backed by
+ * regular 4 KiB pages. With this setting, <tt>AllocType::Host</tt> and
+ * <tt>AllocType::HostAsync</tt> allocations of at least \c threshold bytes
+ * (2 MiB minimum, the default) are instead placed on 2 MiB pages.
+ *
+ * <tt>HugePagePolicy::Transparent</tt> uses <tt>madvise(MADV_HUGEPAGE)</tt>.
+ * <tt>HugePagePolicy::Explicit</tt> first tries <tt>MAP_HUGETLB</tt>, which
+ * requires a reserved pool of huge pages (<tt>vm.nr_hugepages</tt>) on Linux,
+ * and large pages on Windows, which requires the \c SeLockMemoryPrivilege
+ * privilege. Both fall back to the transparent variant.
+ *
+ * The allocation cache keeps huge page regions separate from other memory,
+ * so that they are only reused to service other large requests. The policy
+ * only affects new allocations. The default is \c Explicit on Linux and \c
+ * Disabled elsewhere. Specify <tt>threshold=0</tt> to keep the current value.
+ */
+extern JIT_EXPORT void jit_set_huge_page_policy(JIT_ENUM HugePagePolicy policy,
+                                                size_t threshold JIT_DEF(0));
+
+/// Callback signature for \ref jit_malloc_set_pressure_callback()
+typedef void (*MemoryPressureCallback)(JIT_ENUM AllocType type, size_t size,
+                                       void *payload);
+
+/**
+ * \brief Register a callback that is invoked under memory pressure
+ *
+ * This happens when an allocation of \c size bytes exceeds the soft limit set
+ * via \ref jit_malloc_set_limit() or fails outright, and releasing unused
+ * memory from the allocation cache did not suffice. The callback can, e.g.,
+ * drop application-level caches of arrays. It is invoked without holding any
+ * internal locks, and may call other Dr.Jit functions. Specify
+ * <tt>callback=nullptr</tt> to unregister it.
+ */
+extern JIT_EXPORT void
+jit_malloc_set_pressure_callback(MemoryPressureCallback callback,
+                                 void *payload);
+
+/**
+ * \brief Warn about kernels whose outputs exceed \c bytes (0: disabled)
+ *
+ * Kernel launches are never split into chunks, hence this threshold does not
+ * bound the memory of an evaluation. Kernels whose outputs exceed it are
+ * only reported with a warning.
+ *
+ * Horizontal reductions (\ref jit_var_reduce()) of unevaluated arrays that
+ * would exceed the threshold when evaluated are instead computed by the
+ * kernel producing their entries, which accumulates partial results in at
+ * most \c bytes of memory. This also applies to the CUDA backend, where it
+ * trades memory for contention of atomic operations.
+ */
+extern JIT_EXPORT void jit_set_eval_memory_warning(size_t bytes);
+
+/// Return the threshold set via \ref jit_set_eval_memory_warning()
+extern JIT_EXPORT size_t jit_eval_memory_warning();
+
 /// Flush internal kernel cache
 extern JIT_EXPORT void jit_flush_kernel_cache();
 
+/**
+ * \brief Limit the size of the in-memory and on-disk kernel caches
+ *
+ * When the in-memory cache exceeds \c max_size bytes (kernel binaries and
+ * sources) or \c max_entries kernels, the least recently launched kernels
+ * are unloaded until the cache has shrunk to 7/8 of these limits. Kernels
+ * referenced by frozen functions are never evicted, and eviction is
+ * postponed while a CUDA graph is being captured.
+ *
+ * The parameters \c max_disk_size and \c max_disk_entries analogously limit
+ * the kernel cache database in the ~/.drjit directory, whose least recently
+ * loaded entries are removed when a process adds a new kernel.
+ *
+ * A value of zero disables the corresponding limit, which is the default.
+ */
+extern JIT_EXPORT void jit_set_kernel_cache_limits(size_t max_size,
+                                                   uint32_t max_entries,
+                                                   size_t max_disk_size,
+                                                   uint32_t max_disk_entries);
+
+#if defined(__cplusplus)
+/// Compression codecs for the on-disk kernel cache
+enum class KernelCacheCodec : uint32_t {
+    /// Fast LZ4 compression (default). The level is the acceleration factor.
+    LZ4 = 0,
+
+    /// High-compression LZ4 with levels 3..12, decompresses equally fast
+    LZ4HC = 1,
+
+    /**
+     * Uncompressed. On Linux and macOS, LLVM kernels are then mapped straight
+     * from the cache file (copy-on-write) instead of being decompressed and
+     * copied, which reduces load times and shares memory between processes
+     * that use the same cache. The level is ignored.
+     */
+    None = 2
+};
+#else
+enum KernelCacheCodec {
+    KernelCacheCodecLZ4 = 0,
+    KernelCacheCodecLZ4HC = 1,
+    KernelCacheCodecNone = 2
+};
+#endif
+
+/**
+ * \brief Select the codec that compresses new entries of the disk cache
+ *
+ * Plain LZ4 is well-suited for local storage. LZ4HC compresses more slowly
+ * but produces smaller files, which reduces load times on network file
+ * systems (e.g. for kernels with large relocation tables). Uncompressed
+ * entries take more space, but LLVM kernels can then be mapped into memory
+ * without decompressing and copying them. The codec is recorded in every
+ * cache entry, hence entries compressed with different codecs can coexist.
+ * A \c level of zero selects the codec's default.
+ */
+extern JIT_EXPORT void jit_set_kernel_cache_codec(JIT_ENUM KernelCacheCodec codec,
+                                                  int level JIT_DEF(0));
+
+/**
+ * \brief Compress disk cache entries using a custom dictionary
+ *
+ * Dr.Jit compresses cache entries using a builtin dictionary that was
+ * trained on typical kernels. Workloads with unusual kernels can benefit
+ * from a dictionary trained on their own kernels. To create one, first
+ * specify a directory via \ref jit_set_kernel_cache_train_path() and run
+ * the workload. Then train a dictionary of at most 64 KiB, e.g. via
+ *
+ * <tt>zstd --train <path>/\*.trn --maxdict=65536 -o kernels.dict</tt>
+ *
+ * and pass the resulting file to this function before any kernels are
+ * loaded. Entries compressed with different dictionaries are stored in
+ * separate databases. Passing \c NULL reverts to the builtin dictionary.
+ */
+extern JIT_EXPORT void jit_set_kernel_cache_dict(const char *filename);
+
+/**
+ * \brief Record training data for \ref jit_set_kernel_cache_dict()
+ *
+ * When set, every kernel written to the disk cache is also stored in
+ * uncompressed form into a <tt>.trn</tt> file in the directory \c path,
+ * which must exist. Passing \c NULL stops recording.
+ */
+extern JIT_EXPORT void jit_set_kernel_cache_train_path(const char *path);
+
+/**
+ * \brief Query kernel cache statistics
+ *
+ * Returns the number of cache hits, soft misses (kernel loaded from the disk
+ * cache), hard misses (kernel compiled from scratch), and in-memory cache
+ * evictions since initialization. Any of the pointers may be \c NULL.
+ */
+extern JIT_EXPORT void jit_kernel_cache_stats(size_t *hits,
+                                              size_t *soft_misses,
+                                              size_t *hard_misses,
+                                              size_t *evictions);
+
+/// Counters reported by \ref jit_stats()
+struct JitStats {
+    /// Number of variables created, and how many of them were deduplicated
+    /// by local value numbering (\ref JitFlag::ValueNumbering)
+    uint64_t variables_created;
+    uint64_t lvn_hits;
+
+    /// Number of jit_eval() calls that launched kernels, and of launched kernels
+    uint64_t evals;
+    uint64_t eval_groups;
+
+    /// Kernel launches, and how many of them found the kernel in memory
+    uint64_t kernel_launches;
+    uint64_t kernel_hits;
+
+    /// Allocations served by the allocation cache, and new allocations
+    uint64_t alloc_reused;
+    uint64_t alloc_fresh;
+
+    /// Memory that is currently held by the allocation cache (in bytes)
+    uint64_t alloc_cached_bytes;
+
+    /// Bytes copied by jit_var_mem_copy(), jit_var_read(), jit_var_write()
+    /// (and their batch versions) between host and CUDA device memory
+    uint64_t bytes_host_to_device;
+    uint64_t bytes_device_to_host;
+
+    /// Reads of individual elements that had to evaluate the array first
+    uint64_t implicit_evals;
+
+    /// Operations that waited for the device to finish (e.g. jit_var_read())
+    uint64_t implicit_syncs;
+};
+
+/**
+ * \brief Query counters describing the activity of Dr.Jit since it was loaded
+ *
+ * The counters are always active and only increase over time (except for
+ * \c alloc_cached_bytes), which makes them suitable for periodic monitoring.
+ */
+extern JIT_EXPORT void jit_stats(struct JitStats *stats);
+
+/**
+ * \brief Record operations that make the host wait for the device
+ *
+ * Reading array entries (\ref jit_var_read()), horizontal boolean
+ * reductions (\ref jit_var_any(), \ref jit_var_all()), the preparation of
+ * virtual function calls (\ref jit_var_vcall_reduce()), and several other
+ * operations wait for all previously submitted work and thereby stall the
+ * pipeline. They sometimes also have to evaluate their input first.
+ *
+ * When \c level is \c 1, every such operation is recorded along with the
+ * label of the accessed variable. Level \c 2 additionally captures a
+ * backtrace (except on Windows), which distinguishes call sites at a larger
+ * cost. Each new site produces a warning, and \ref jit_sync_profile()
+ * reports the most costly ones. Level \c 0 (the default) disables the
+ * profiler.
+ */
+extern JIT_EXPORT void jit_set_sync_profile(int level);
+
+/**
+ * \brief Return a report of the operations recorded by \ref jit_set_sync_profile()
+ *
+ * The sites are sorted by the total time spent in them (including the
+ * evaluation of their input). The returned string remains valid until the
+ * next call.
+ */
+extern JIT_EXPORT const char *jit_sync_profile();
+
+/// Clear the sites recorded by \ref jit_set_sync_profile()
+extern JIT_EXPORT void jit_sync_profile_clear();
+
+/**
+ * \brief Write the hashes of all kernels used so far to a manifest file
+ *
+ * A later process can pass this file to \ref jit_kernel_cache_prefetch() to
+ * load the same kernels from the disk cache ahead of time. Returns the number
+ * of kernels written.
+ */
+extern JIT_EXPORT uint32_t jit_kernel_cache_manifest(const char *filename);
+
+/**
+ * \brief Load the kernels listed in a manifest file in the background
+ *
+ * This function reads a manifest created by \ref jit_kernel_cache_manifest()
+ * and returns immediately. A background task then decompresses the listed
+ * kernels from the disk cache and, on the CUDA backend, also loads their
+ * modules. Later cache lookups by \ref jit_eval() hit in memory this way.
+ * Kernels that are missing from the disk cache are skipped. This function
+ * should be called after initializing the backends. A missing manifest file
+ * is not an error.
+ */
+extern JIT_EXPORT void jit_kernel_cache_prefetch(const char *filename);
+
 /// Query the flavor of a memory allocation made using \ref jit_malloc()
 extern JIT_EXPORT JIT_ENUM AllocType jit_malloc_type(void *ptr);
 
@@ -643,7 +1181,8 @@ extern JIT_EXPORT uint32_t jit_var_literal(JIT_ENUM JitBackend backend,
  * \brief Create a counter variable
  *
  * This operation creates a variable of type \ref VarType::UInt32 that will
- * evaluate to <tt>0, ..., size - 1</tt>.
+ * evaluate to <tt>0, ..., size - 1</tt>. Counters of LLVM arrays with more
+ * than 2^32-1 entries instead use the type \ref VarType::UInt64.
  */
 extern JIT_EXPORT uint32_t jit_var_counter(JIT_ENUM JitBackend backend,
                                            size_t size);
@@ -733,6 +1272,54 @@ enum JitOp {
  */
 extern JIT_EXPORT uint32_t jit_var_op(JIT_ENUM JitOp op, const uint32_t *dep);
 
+/**
+ * \brief Perform an arithmetic operation and release references to operands
+ *
+ * This function behaves like \ref jit_var_op() and then decreases the
+ * reference count of each operand <tt>dep[i]</tt> for which bit \c i of \c
+ * steal is set. This hands over references held by temporaries (e.g., in the
+ * C++ wrapper of long arithmetic expressions) using a single acquisition of
+ * the internal lock instead of one per operation. The references are only
+ * released when the operation succeeds.
+ */
+extern JIT_EXPORT uint32_t jit_var_op_steal(JIT_ENUM JitOp op,
+                                            const uint32_t *dep,
+                                            uint32_t steal);
+
+/// Operand of \ref JitBatchOp that refers to the result of operation \c i
+#define JIT_BATCH_RESULT(i) (0x80000000u | (uint32_t) (i))
+
+/// Operation of a program passed to \ref jit_var_op_batch()
+struct JitBatchOp {
+    /// The operation to be performed
+    JIT_ENUM JitOp op;
+
+    /**
+     * Operands: variable indices, or <tt>JIT_BATCH_RESULT(j)</tt> to refer to
+     * the result of an earlier operation \c j of the same program. Entries
+     * beyond the number of operands of \c op should be zero.
+     */
+    uint32_t dep[3];
+};
+
+/**
+ * \brief Create the variables of a small SSA program at once
+ *
+ * This function is equivalent to calling \ref jit_var_op() for each of the
+ * \c size entries of \c ops in sequence, which is useful for frontends that
+ * trace many operations: the internal lock is only acquired once, and the
+ * hash tables used by variable storage and local value numbering are grown
+ * once for the entire program.
+ *
+ * Upon return, <tt>out[i]</tt> holds a reference to the result of
+ * <tt>ops[i]</tt>. The caller must release the ones that it does not need.
+ * When an operation fails, the references to earlier results are released
+ * and the exception is propagated.
+ */
+extern JIT_EXPORT void jit_var_op_batch(uint32_t size,
+                                        const struct JitBatchOp *ops,
+                                        uint32_t *out);
+
 /// Compute `-a0` and return a variable representing the result
 extern JIT_EXPORT uint32_t jit_var_neg(uint32_t a0);
 
@@ -962,6 +1549,30 @@ extern JIT_EXPORT uint32_t jit_var_scatter_inc(uint32_t *target,
                                                uint32_t index,
                                                uint32_t mask);
 
+/**
+ * \brief Stream compaction of several arrays within a generated kernel
+ *
+ * Given a boolean array \c mask and \c n arrays <tt>in[0..n-1]</tt> of a
+ * compatible size, this function creates \c n new arrays and writes their
+ * indices to <tt>out[0..n-1]</tt>. It then schedules the entries whose mask is
+ * \c true to be written to the beginning of these arrays. The function returns
+ * the index of an unsigned 32-bit scalar counting the number of such entries.
+ *
+ * Unlike \ref jit_compress(), this doesn't evaluate the mask and then gather
+ * from the inputs in separate passes. Instead, the kernel computing the mask
+ * and inputs also writes the output (via \ref jit_var_scatter_inc(), which
+ * aggregates the counter updates per warp or SIMD packet). On the LLVM
+ * backend, the writes become compressing vector stores.
+ *
+ * The returned arrays have the same size as the inputs; only the first
+ * <tt>count</tt> entries are initialized. The relative order of entries is
+ * preserved within each warp/packet, but not globally.
+ *
+ * The caller owns a reference to the counter and to each output array.
+ */
+extern JIT_EXPORT uint32_t jit_var_compact(uint32_t mask, uint32_t n,
+                                           const uint32_t *in, uint32_t *out);
+
 /**
  * \brief Create an identical copy of the given variable
  *
@@ -997,6 +1608,42 @@ extern JIT_EXPORT uint32_t jit_var_mem_map(JIT_ENUM JitBackend backend,
                                            JIT_ENUM VarType type, void *ptr,
                                            size_t size, int free);
 
+/// Tensor exchange format, declared in <dlpack/dlpack.h>
+struct DLManagedTensor;
+
+/**
+ * \brief Create a variable that refers to the memory of a DLPack tensor
+ *
+ * This creates a flat array of the entries of the C-contiguous tensor \c
+ * tensor without copying them. Tensors on the CPU are mapped to the LLVM
+ * backend, and CUDA tensors (which must be located on the current device) to
+ * the CUDA backend. Upon success, Dr.Jit takes ownership of \c tensor and
+ * invokes its deleter once the variable is freed.
+ *
+ * When \c stream is nonzero, it specifies the CUDA stream on which the
+ * producer wrote the tensor, and work subsequently submitted by Dr.Jit waits
+ * for it (see \ref jit_cuda_stream_wait()). Otherwise, the tensor must be
+ * ready to be used.
+ */
+extern JIT_EXPORT uint32_t jit_var_dlpack_import(struct DLManagedTensor *tensor,
+                                                 void *stream);
+
+/**
+ * \brief Export a variable as a one-dimensional DLPack tensor
+ *
+ * This evaluates the variable \c index and returns a tensor that refers to
+ * its memory without copying it. The tensor holds a reference to the
+ * variable until its deleter is invoked by the consumer.
+ *
+ * For CUDA variables, \c stream specifies the CUDA stream on which the
+ * consumer will access the tensor (\c 0 refers to the legacy default
+ * stream). It is made to wait for Dr.Jit's kernels (see \ref
+ * jit_cuda_stream_signal()), which avoids a device-wide synchronization. For
+ * LLVM variables, the function waits until the variable has been computed.
+ */
+extern JIT_EXPORT struct DLManagedTensor *jit_var_dlpack_export(uint32_t index,
+                                                                void *stream);
+
 /**
  * Copy a memory region onto the device and return its variable index. Its
  * reference count is initialized to \c 1.
@@ -1046,7 +1693,12 @@ JIT_INLINE void jit_var_dec_ref(uint32_t index) JIT_NOEXCEPT {
 #define jit_var_inc_ref jit_var_inc_ref_impl
 #endif
 
-/// Check if a variable with a given index exists
+/**
+ * \brief Check if a variable with a given index exists
+ *
+ * Note that the indices of freed variables are reused by subsequently created
+ * variables.
+ */
 extern JIT_EXPORT int jit_var_exists(uint32_t index);
 
 /// Query the a variable's reference count (used by the test suite)
@@ -1055,7 +1707,14 @@ extern JIT_EXPORT uint32_t jit_var_ref(uint32_t index);
 /// Query the pointer variable associated with a given variable
 extern JIT_EXPORT void *jit_var_ptr(uint32_t index);
 
-/// Query the size of a given variable
+/**
+ * \brief Query the size of a given variable
+ *
+ * Variables of the LLVM backend may hold more than 2^32-1 entries, while
+ * the CUDA backend remains limited to 2^32-1 entries. Operations that rely
+ * on 32-bit indices internally (\ref jit_var_compact() and \ref
+ * jit_var_vcall_reduce()) raise an exception when given larger arrays.
+ */
 extern JIT_EXPORT size_t jit_var_size(uint32_t index);
 
 /// Query the type of a given variable
@@ -1075,12 +1734,20 @@ extern JIT_EXPORT int jit_var_is_placeholder(uint32_t index);
  *
  * This function takes a scalar variable as input and changes its size to \c
  * size, potentially creating a new copy in case something already depends on
- * \c index. The returned copy is symbolic form.
+ * \c index. The returned copy is symbolic form: it broadcasts the scalar
+ * within generated kernels and does not allocate memory until it is evaluated
+ * (e.g. because it is the target of a scatter operation).
  *
  * The function increases the reference count of the returned value.
  * When \c index is not a scalar variable and its size exactly matches \c size,
  * the function does nothing and just increases the reference count of
- * \c index. Otherwise, it fails.
+ * \c index.
+ *
+ * As a special case, an evaluated variable without other references whose
+ * memory was allocated via \ref jit_malloc_reserve() (e.g. one created using
+ * \ref jit_var_mem_map()) can be enlarged in place without a copy, as long as
+ * the new size fits into the reserved capacity. The additional entries are
+ * uninitialized. Otherwise, it fails.
  */
 extern JIT_EXPORT uint32_t jit_var_resize(uint32_t index, size_t size);
 
@@ -1101,6 +1768,47 @@ extern JIT_EXPORT uint32_t jit_var_resize(uint32_t index, size_t size);
 extern JIT_EXPORT uint32_t jit_var_migrate(uint32_t index,
                                            JIT_ENUM AllocType type);
 
+/**
+ * \brief Split a CUDA variable into shards that reside on different devices
+ *
+ * The variable \c index is evaluated and split into \c count contiguous
+ * index ranges of (almost) equal size. Shard \c i is asynchronously copied to
+ * device <tt>devices[i]</tt> via a peer-to-peer transfer, and its variable
+ * index is written to <tt>out[i]</tt> (with a reference count of one). The
+ * same device may be specified several times.
+ *
+ * Computation involving the shards can then be evaluated on their devices
+ * using \ref jit_var_unshard() or \ref jit_var_reduce_shards(), which
+ * effectively splits a kernel launch across devices by index range.
+ */
+extern JIT_EXPORT void jit_var_shard(uint32_t index, uint32_t count,
+                                     const int *devices, uint32_t *out);
+
+/**
+ * \brief Evaluate shards on their devices and concatenate them
+ *
+ * Every unevaluated entry of \c indices is evaluated on the device
+ * <tt>devices[i]</tt>. These kernels run concurrently. The shards are then
+ * copied to the current device (\ref jit_cuda_set_device()) and concatenated
+ * into a new variable, whose index is returned.
+ */
+extern JIT_EXPORT uint32_t jit_var_unshard(uint32_t count,
+                                           const uint32_t *indices,
+                                           const int *devices);
+
+/**
+ * \brief Reduce shards on their devices and combine the results
+ *
+ * Shard <tt>indices[i]</tt> is evaluated and reduced on device
+ * <tt>devices[i]</tt>. The partial results are then combined on the current
+ * device, and the index of the resulting (single-element) variable is
+ * returned. The same restrictions as in \ref jit_var_reduce() apply.
+ */
+extern JIT_EXPORT uint32_t jit_var_reduce_shards(JIT_ENUM ReduceOp reduce_op,
+                                                 uint32_t count,
+                                                 const uint32_t *indices,
+                                                 const int *devices);
+
 /// Query the current (or future, if unevaluated) allocation flavor of a variable
 extern JIT_EXPORT JIT_ENUM AllocType jit_var_alloc_type(uint32_t index);
 
@@ -1156,6 +1864,35 @@ extern JIT_EXPORT void jit_var_read(uint32_t index, size_t offset,
 extern JIT_EXPORT uint32_t jit_var_write(uint32_t index, size_t offset,
                                          const void *src);
 
+/**
+ * \brief Read many elements of (possibly different) variables at once
+ *
+ * Equivalent to calling \ref jit_var_read() with <tt>(indices[i],
+ * offsets[i], dst[i])</tt> for each <tt>i < count</tt>, but evaluates the
+ * variables together and fetches all elements using a single gather kernel
+ * followed by one synchronization. All variables must use the same backend.
+ */
+extern JIT_EXPORT void jit_var_read_batch(uint32_t count,
+                                          const uint32_t *indices,
+                                          const size_t *offsets,
+                                          void *const *dst);
+
+/**
+ * \brief Write many elements of (possibly different) variables at once
+ *
+ * Equivalent to calling \ref jit_var_write() with <tt>(indices[i],
+ * offsets[i], src[i])</tt> for each <tt>i < count</tt> and storing the
+ * returned variable index in <tt>indices_out[i]</tt> (each of which holds a
+ * reference). All writes are performed by a single asynchronous scatter
+ * kernel. Writes to the same variable target the same (possibly copied)
+ * array, and writing the same element more than once is not supported.
+ */
+extern JIT_EXPORT void jit_var_write_batch(uint32_t count,
+                                           const uint32_t *indices,
+                                           const size_t *offsets,
+                                           const void *const *src,
+                                           uint32_t *indices_out);
+
 /**
  * \brief Print the specified variable contents from the kernel
  *
@@ -1222,6 +1959,52 @@ extern JIT_EXPORT void
 jit_var_set_callback(uint32_t index, void (*callback)(uint32_t, int, void *),
                      void *callback_data);
 
+/**
+ * \brief Begin recording the kernels launched by the current thread
+ *
+ * All kernels launched between \ref jit_freeze_begin() and \ref
+ * jit_freeze_end() are recorded into a <em>frozen function</em> that can
+ * later be replayed via \ref jit_freeze_replay() with new inputs. A replay
+ * skips tracing, code generation, and kernel cache lookups, and directly
+ * submits the recorded kernels in their original order.
+ *
+ * The \c n_inputs variables in \c inputs are evaluated and identify the arrays
+ * that may be exchanged during a replay. Arrays that are created by
+ * operations other than the recorded kernels (e.g. memory copies, horizontal
+ * reductions, OptiX launches) must not be used within the recording;
+ * \ref jit_freeze_end() raises an exception in this case.
+ *
+ * Replays must provide inputs of the same type and size as the recording.
+ */
+extern JIT_EXPORT void jit_freeze_begin(JIT_ENUM JitBackend backend,
+                                        uint32_t n_inputs,
+                                        const uint32_t *inputs);
+
+/**
+ * \brief Stop recording and return a frozen function
+ *
+ * The \c n_outputs variables in \c outputs are evaluated and become the
+ * outputs of the frozen function. The returned handle must eventually be
+ * released via \ref jit_freeze_destroy(). It references compiled kernels,
+ * hence \ref jit_flush_kernel_cache() cannot be called while it exists.
+ */
+extern JIT_EXPORT void *jit_freeze_end(JIT_ENUM JitBackend backend,
+                                       uint32_t n_outputs,
+                                       const uint32_t *outputs);
+
+/**
+ * \brief Replay a frozen function
+ *
+ * Runs the kernels recorded by \ref jit_freeze_begin() and \ref
+ * jit_freeze_end() using new \c inputs and writes new variable references to
+ * \c outputs. Both arrays must have the same length as during the recording.
+ */
+extern JIT_EXPORT void jit_freeze_replay(void *frozen, const uint32_t *inputs,
+                                         uint32_t *outputs);
+
+/// Release a frozen function created by \ref jit_freeze_end()
+extern JIT_EXPORT void jit_freeze_destroy(void *frozen);
+
 // ====================================================================
 //      Functionality for debug output and GraphViz visualizations
 // ====================================================================
@@ -1311,7 +2094,10 @@ enum class JitFlag : uint32_t {
     /// Record loops instead of unrolling them into wavefronts
     LoopRecord = 4,
 
-    /// Try to detect and remove unnecessary (constant/unreferenced) loop variables
+    /**
+     * \brief Try to detect and remove unnecessary (constant/unreferenced) loop
+     * variables, and move loop-invariant arithmetic in front of the loop
+     */
     LoopOptimize = 8,
 
     /// Record virtual function calls instead of splitting them into many small kernel launches
@@ -1353,6 +2139,155 @@ enum class JitFlag : uint32_t {
     /// Perform a intra-warp/SIMD register reduction before issuing global atomics
     AtomicReduceLocal = 16384,
 
+    /**
+     * \brief Assemble all kernels of a \ref jit_eval() call before launching
+     * any of them, and compile the ones missing from the kernel cache
+     * concurrently using the thread pool (off by default).
+     */
+    ParallelCompile = 32768,
+
+    /**
+     * \brief Launch the kernels of a \ref jit_eval() call on several CUDA
+     * streams so that independent kernels can run concurrently (off by
+     * default).
+     */
+    ParallelStreams = 65536,
+
+    /**
+     * \brief Identify cached kernels by their 128-bit hash alone and skip the
+     * comparison of the full source code on a kernel cache lookup (off by
+     * default). The hash then covers the entire kernel including its
+     * prologue, hence kernels receive different names than without this flag.
+     */
+    KernelHashOnly = 131072,
+
+    /**
+     * \brief Record which variable, label, and kernel produced each memory
+     * allocation, in addition to peak snapshots and lifetime histograms. See
+     * \ref jit_malloc_profile() (off by default).
+     */
+    MallocProfile = 262144,
+
+    /**
+     * \brief Store evaluated CUDA variables in unified memory (\ref
+     * AllocType::Managed) instead of device memory, so that the working set
+     * may exceed the memory of the GPU (off by default).
+     */
+    ManagedMemory = 524288,
+
+    /**
+     * \brief Optimize kernels before generating code: merge equivalent
+     * variables (also across scopes), perform simple algebraic
+     * simplifications, and remove unused variables (off by default).
+     */
+    KernelOptimize = 1048576,
+
+    /**
+     * \brief Compute scalar (size 1) variables within one of the other
+     * kernels of a \ref jit_eval() call instead of launching a separate
+     * kernel, if this is estimated to be cheap. On the LLVM backend, \ref
+     * jit_var_reduce() furthermore accumulates sums (and integer minima or
+     * maxima) of unevaluated inputs within the kernel computing them, so that
+     * the full array is never written to memory (off by default).
+     */
+    KernelFusion = 2097152,
+
+    /**
+     * \brief Let the output of a kernel take over the memory of an input with
+     * the same type and size that is not referenced outside of the kernel,
+     * e.g. in iterative updates of the form <tt>x = f(x)</tt>. Has no effect
+     * when combined with \ref KernelOptimize or while recording a frozen
+     * function (off by default).
+     */
+    BufferReuse = 4194304,
+
+    /**
+     * \brief LLVM backend: compile new kernels quickly with a reduced
+     * optimization level. Kernels that are launched many times are then
+     * recompiled in the background with aggressive optimizations (including
+     * loop/SLP vectorization), and the result replaces the original version.
+     * Only the latter is written to the kernel cache on disk. Requires the
+     * ORCv2 interface of LLVM (off by default).
+     */
+    TieredCompile = 8388608,
+
+    /**
+     * \brief LLVM backend: run tiny kernels (up to a few thousand entries)
+     * directly on the calling thread when all previously submitted work has
+     * finished, which avoids the latency of the thread pool. Such launches
+     * block until the kernel has finished, and they are not used while \ref
+     * KernelHistory is active (off by default).
+     */
+    LaunchInline = 16777216,
+
+    /**
+     * \brief CUDA backend: time the first large launches of every kernel
+     * using a few different block sizes and grid sizes, and then keep using
+     * the fastest configuration. The result is also stored in the kernel
+     * cache on disk. This mainly helps register-heavy kernels containing
+     * loops or virtual function calls (off by default).
+     */
+    LaunchAutotune = 33554432,
+
+    /**
+     * \brief CUDA backend: kernels containing recorded loops use persistent
+     * threads, which fetch the index of their next entry from a global work
+     * counter instead of following a fixed grid-stride schedule. This
+     * balances the work when loops have divergent trip counts (e.g. path
+     * tracing). Not used by OptiX kernels or while recording a frozen
+     * function (off by default).
+     */
+    LoopPersistent = 67108864,
+
+    /**
+     * \brief CUDA backend: sort the entries of recorded virtual function
+     * calls by instance (via \ref jit_mkperm()) when the call is created, and
+     * let the kernel containing the call process its entries in this order.
+     * Warps then mostly encounter a single instance, while the call still
+     * runs in a single kernel launch. Requires an evaluable \c self argument,
+     * i.e., not within recorded loops or other calls (off by default).
+     */
+    VCallCoherent = 134217728,
+
+    /**
+     * \brief Load literal constants referenced by recorded virtual function
+     * calls from the per-instance call data buffer instead of embedding them
+     * into the generated code. Changing such a constant then only updates
+     * the buffer and reuses the previously compiled kernel, at the cost of a
+     * memory load per constant (off by default).
+     */
+    VCallLiteralData = 268435456,
+
+    /**
+     * \brief Profile-guided specialization of recorded virtual function
+     * calls. The first kernels containing a given call count how often each
+     * instance is invoked. Later recordings of the same call then dispatch
+     * the most frequently called instances via a direct call behind a
+     * comparison (which the backend compiler may inline), while the remaining
+     * instances still use an indirect call (off by default).
+     */
+    VCallProfile = 536870912,
+
+    /**
+     * \brief Pass literal constants whose value changes between otherwise
+     * identical kernels through kernel parameters instead of embedding them
+     * into the generated code. Once a literal (e.g. a time step or an
+     * iteration counter) is seen with a different value, later kernels of
+     * the same structure load it as a parameter and therefore reuse a single
+     * compiled kernel. Other literals stay embedded, and \ref jit_var_literal()
+     * with <tt>eval=1</tt> still creates an opaque array (off by default).
+     */
+    LiteralParams = 1073741824,
+
+    /**
+     * \brief Accumulate per-kernel statistics (launch count, code generation,
+     * compilation, and execution time, bytes read and written) keyed by the
+     * kernel hash. Unlike \ref KernelHistory, this doesn't store a copy of
+     * the IR of every launch. See \ref jit_kernel_stats() and \ref
+     * jit_kernel_stats_trace() (off by default).
+     */
+    KernelStats = 2147483648u,
+
     /// Default flags
     Default = (uint32_t) ConstProp | (uint32_t) ValueNumbering |
               (uint32_t) LoopRecord | (uint32_t) LoopOptimize |
@@ -1376,7 +2311,24 @@ enum JitFlag {
     JitFlagKernelHistory       = 2048,
     JitFlagLaunchBlocking      = 4096,
     JitFlagADOptimize          = 8192,
-    JitFlagAtomicReduceLocal = 16384
+    JitFlagAtomicReduceLocal = 16384,
+    JitFlagParallelCompile     = 32768,
+    JitFlagParallelStreams     = 65536,
+    JitFlagKernelHashOnly      = 131072,
+    JitFlagMallocProfile       = 262144,
+    JitFlagManagedMemory       = 524288,
+    JitFlagKernelOptimize      = 1048576,
+    JitFlagKernelFusion        = 2097152,
+    JitFlagBufferReuse         = 4194304,
+    JitFlagTieredCompile       = 8388608,
+    JitFlagLaunchInline        = 16777216,
+    JitFlagLaunchAutotune      = 33554432,
+    JitFlagLoopPersistent      = 67108864,
+    JitFlagVCallCoherent       = 134217728,
+    JitFlagVCallLiteralData    = 268435456,
+    JitFlagVCallProfile        = 536870912,
+    JitFlagLiteralParams       = 1073741824,
+    JitFlagKernelStats         = 2147483648u
 };
 #endif
 
@@ -1526,11 +2478,21 @@ extern JIT_EXPORT uint32_t jit_var_loop_cond(uint32_t loop_init,
                                              size_t n_indices,
                                              uint32_t **indices);
 
+/**
+ * \brief Finish recording a loop
+ *
+ * The optional \c unroll parameter requests that the generated code executes
+ * up to \c unroll iterations per branch back to the loop condition. Each
+ * unrolled iteration still evaluates the loop condition, hence lanes can exit
+ * at any point and no remainder handling is needed. The value is clamped to
+ * the range <tt>[1, 16]</tt>.
+ */
 extern JIT_EXPORT uint32_t jit_var_loop(const char *name, uint32_t loop_init,
                                         uint32_t loop_cond, size_t n_indices,
                                         uint32_t *indices_in,
                                         uint32_t **indices, uint32_t checkpoint,
-                                        int first_round);
+                                        int first_round,
+                                        uint32_t unroll JIT_DEF(1));
 
 /**
  * \brief Pushes a new mask variable onto the mask stack
@@ -1554,7 +2516,7 @@ extern JIT_EXPORT uint32_t jit_var_mask_peek(JIT_ENUM JitBackend backend);
 
 /// Return the default mask for a wavefront of the given \c size
 extern JIT_EXPORT uint32_t jit_var_mask_default(JIT_ENUM JitBackend backend,
-                                                uint32_t size);
+                                                size_t size);
 
 /**
  * \brief Combine the given mask 'index' with the mask stack
@@ -1562,7 +2524,7 @@ extern JIT_EXPORT uint32_t jit_var_mask_default(JIT_ENUM JitBackend backend,
  * On the LLVM backend, a default mask will be created when the mask stack is empty.
  * The \c size parameter determines the size of the associated wavefront.
  */
-extern JIT_EXPORT uint32_t jit_var_mask_apply(uint32_t index, uint32_t size);
+extern JIT_EXPORT uint32_t jit_var_mask_apply(uint32_t index, size_t size);
 
 // ====================================================================
 //                          Horizontal reductions
@@ -1577,6 +2539,38 @@ extern JIT_EXPORT int jit_var_any(uint32_t index);
 /// Reduce a variable to a single value
 extern JIT_EXPORT uint32_t jit_var_reduce(uint32_t index, JIT_ENUM ReduceOp reduce_op);
 
+/// Opaque handle to the pending result of \ref jit_var_reduce_async()
+struct JitFuture;
+
+/**
+ * \brief Reduce a variable to a single value without waiting for the result
+ *
+ * This function is an asynchronous alternative to \ref jit_var_any(), \ref
+ * jit_var_all(), and \ref jit_var_reduce() followed by a read of the result.
+ * Boolean arrays support \c ReduceOp::And and \c ReduceOp::Or, other types
+ * support the remaining operations. The final reduction step writes into
+ * host-pinned memory (CUDA) or host memory (LLVM), hence no separate
+ * transfer is needed once the computation has finished.
+ *
+ * The caller may continue submitting work and can poll the returned handle
+ * via \ref jit_future_ready(). It must eventually call \ref
+ * jit_future_get() to obtain the result and release the handle.
+ */
+extern JIT_EXPORT struct JitFuture *
+jit_var_reduce_async(uint32_t index, JIT_ENUM ReduceOp reduce_op);
+
+/// Check (without blocking) if the result of an asynchronous reduction is ready
+extern JIT_EXPORT int jit_future_ready(struct JitFuture *future);
+
+/**
+ * \brief Wait for the result of an asynchronous reduction and release the
+ * handle
+ *
+ * Writes one value of the reduced variable's type to \c out (a single byte
+ * storing 0 or 1 for boolean arrays).
+ */
+extern JIT_EXPORT void jit_future_get(struct JitFuture *future, void *out);
+
 // ====================================================================
 //  Assortment of tuned kernels for initialization, reductions, etc.
 // ====================================================================
@@ -1589,7 +2583,7 @@ extern JIT_EXPORT uint32_t jit_var_reduce(uint32_t index, JIT_ENUM ReduceOp redu
  * a single int, float, double, etc. (\c isize can be 1, 2, 4, or 8).
  * Runs asynchronously.
  */
-extern JIT_EXPORT void jit_memset_async(JIT_ENUM JitBackend backend, void *ptr, uint32_t size,
+extern JIT_EXPORT void jit_memset_async(JIT_ENUM JitBackend backend, void *ptr, size_t size,
                                         uint32_t isize, const void *src);
 
 /// Perform a synchronous copy operation
@@ -1611,7 +2605,88 @@ extern JIT_EXPORT void jit_memcpy_async(JIT_ENUM JitBackend backend, void *dst,
  */
 extern JIT_EXPORT void jit_reduce(JIT_ENUM JitBackend backend, JIT_ENUM VarType type,
                                   JIT_ENUM ReduceOp rtype,
-                                  const void *in, uint32_t size, void *out);
+                                  const void *in, size_t size, void *out);
+
+/**
+ * \brief Reduce contiguous segments of the given array
+ *
+ * Segment \c i consists of the entries <tt>offsets[i]</tt> to
+ * <tt>offsets[i + 1] - 1</tt> of the input array \c in, hence \c offsets
+ * (a 32 bit unsigned integer array in device memory) must contain \c
+ * segment_count + 1 nondecreasing entries. The reduction of each segment is
+ * written to <tt>out[i]</tt>, and empty segments produce the identity element
+ * of the reduction. Since every segment is reduced by a single thread, this
+ * does not need any atomic operations.
+ *
+ * Only the LLVM backend implements this operation. The CUDA backend raises
+ * an exception.
+ *
+ * Runs asynchronously.
+ */
+extern JIT_EXPORT void jit_segmented_reduce(JIT_ENUM JitBackend backend,
+                                            JIT_ENUM VarType type,
+                                            JIT_ENUM ReduceOp rtype,
+                                            const void *in,
+                                            const uint32_t *offsets,
+                                            uint32_t segment_count, void *out);
+
+/**
+ * \brief Reduce the values associated with runs of equal keys
+ *
+ * Given \c size 32 bit unsigned integer \c keys, where equal keys are
+ * stored next to each other (e.g. because the array is sorted), and an
+ * associated array of \c values of type \c type, this function reduces the
+ * values of each run of equal keys. It writes the key of each run to \c
+ * keys_out and the reduced value to \c values_out, both of which must have
+ * space for up to \c size entries. Returns the number of runs.
+ *
+ * Only the LLVM backend implements this operation. The CUDA backend raises
+ * an exception.
+ *
+ * This function internally performs a synchronization step.
+ */
+extern JIT_EXPORT uint32_t jit_reduce_by_key(JIT_ENUM JitBackend backend,
+                                             JIT_ENUM VarType type,
+                                             JIT_ENUM ReduceOp rtype,
+                                             const uint32_t *keys,
+                                             const void *values, uint32_t size,
+                                             uint32_t *keys_out,
+                                             void *values_out);
+
+/**
+ * \brief Sort an array of unsigned integer keys (in place)
+ *
+ * Sorts \c size keys of type \c type (``VarType::UInt32`` or
+ * ``VarType::UInt64``) in ascending order. The sort is stable. If \c values
+ * is not \c nullptr, the same permutation is applied to this array of 32 bit
+ * values, e.g. to reorder a payload by an associated sort key.
+ *
+ * The implementation is a least significant digit radix sort with 8-bit
+ * digits. Each pass is processed in parallel, and the reordering step is
+ * skipped for passes where all keys share the same digit.
+ *
+ * Only the LLVM backend implements this operation. The CUDA backend raises
+ * an exception.
+ *
+ * Runs asynchronously.
+ */
+extern JIT_EXPORT void jit_radix_sort(JIT_ENUM JitBackend backend,
+                                      JIT_ENUM VarType type, void *keys,
+                                      uint32_t *values, uint32_t size);
+
+/**
+ * \brief Compute the permutation that sorts an array of unsigned integer keys
+ *
+ * Writes the stable sorting permutation of \c size keys of type \c type
+ * (``VarType::UInt32`` or ``VarType::UInt64``) to \c perm, such that
+ * <tt>keys[perm[0]] <= keys[perm[1]] <= ...</tt>. The keys are not modified.
+ * See \ref jit_radix_sort() for details on the implementation.
+ *
+ * Runs asynchronously.
+ */
+extern JIT_EXPORT void jit_argsort(JIT_ENUM JitBackend backend,
+                                   JIT_ENUM VarType type, const void *keys,
+                                   uint32_t size, uint32_t *perm);
 
 /** \brief Compute n prefix sum over the given input array
  *
@@ -1621,7 +2696,8 @@ extern JIT_EXPORT void jit_reduce(JIT_ENUM JitBackend backend, JIT_ENUM VarType
  *
  * The operation is currenly implemented for the following numeric types:
  * ``VarType::Int32``, ``VarType::UInt32``, ``VarType::UInt64``,
- * ``VarType::Float32``, and ``VarType::Float64``.
+ * ``VarType::Float32``, and ``VarType::Float64``. The CUDA backend supports
+ * arrays with up to 2^32-1 entries.
  *
  * Note that the CUDA implementation may round \c size to the maximum of the
  * following three values for performance and implementation-related reasons
@@ -1646,7 +2722,7 @@ extern JIT_EXPORT void jit_reduce(JIT_ENUM JitBackend backend, JIT_ENUM VarType
  */
 extern JIT_EXPORT void jit_prefix_sum(JIT_ENUM JitBackend backend,
                                       JIT_ENUM VarType type, int exclusive,
-                                      const void *in, uint32_t size, void *out);
+                                      const void *in, size_t size, void *out);
 
 /**
  * \brief Compress a mask into a list of nonzero indices
@@ -1753,7 +2829,7 @@ jit_var_vcall_reduce(JIT_ENUM JitBackend backend, const char *domain,
  */
 extern JIT_EXPORT void jit_block_copy(JIT_ENUM JitBackend backend, JIT_ENUM VarType type,
                                       const void *in, void *out,
-                                      uint32_t size, uint32_t block_size);
+                                      size_t size, uint32_t block_size);
 
 /**
  * \brief Sum over elements within blocks
@@ -1765,8 +2841,26 @@ extern JIT_EXPORT void jit_block_copy(JIT_ENUM JitBackend backend, JIT_ENUM VarT
  * and the output array must have space for <tt>size</tt> elements.
  */
 extern JIT_EXPORT void jit_block_sum(JIT_ENUM JitBackend backend, JIT_ENUM VarType type,
-                                     const void *in, void *out, uint32_t size,
+                                     const void *in, void *out, size_t size,
                                      uint32_t block_size);
+
+/**
+ * \brief Prefix sum over elements within blocks (segmented prefix sum)
+ *
+ * This function resembles \ref jit_prefix_sum(), except that the sum restarts
+ * at every contiguous block of size \c block_size. For example, the inclusive
+ * variant turns <tt>a, b, c, d, e</tt> into <tt>a, a+b, c, c+d, e</tt> when
+ * the \c block_size is set to \c 2. Both arrays must contain \c size
+ * elements (the last block may be partial), and \c in may equal \c out.
+ * Supports 32/64 bit integers and floating point values.
+ *
+ * Only the LLVM backend implements this operation. The CUDA backend raises
+ * an exception.
+ */
+extern JIT_EXPORT void jit_block_prefix_sum(JIT_ENUM JitBackend backend,
+                                            JIT_ENUM VarType type, int exclusive,
+                                            const void *in, size_t size,
+                                            uint32_t block_size, void *out);
 /**
  * \brief Insert a function call to a ray tracing functor into the LLVM program
  *
@@ -1857,7 +2951,7 @@ struct KernelHistoryEntry {
     int cache_disk;
 
     /// Launch width / number of array entries that were processed
-    uint32_t size;
+    size_t size;
 
     /// Number of input arrays
     uint32_t input_count;
@@ -1914,6 +3008,41 @@ extern JIT_EXPORT void jit_kernel_history_clear();
  */
 extern JIT_EXPORT struct KernelHistoryEntry *jit_kernel_history();
 
+/**
+ * \brief Return a report of the kernels launched while \c
+ * JitFlag.KernelStats was active
+ *
+ * All launches of a kernel are aggregated into one line that lists the
+ * number of launches and compilations, the mean launch width, the total
+ * time spent on code generation, compilation, and execution (along with the
+ * mean execution time), and the total size of the input and output arrays.
+ * Precompiled kernels (e.g. reductions) are aggregated by their type.
+ *
+ * This function waits for the profiled launches that are still running. The
+ * returned string remains valid until the next call to this function or to
+ * \ref jit_kernel_stats_trace().
+ */
+extern JIT_EXPORT const char *jit_kernel_stats();
+
+/**
+ * \brief Return a timeline of the kernels launched while \c
+ * JitFlag.KernelStats was active
+ *
+ * The result uses the JSON format of the Chrome trace viewer, which can also
+ * be opened by Perfetto. It contains one track per CUDA device (using CUDA
+ * events), one for the LLVM backend, and one for code generation and
+ * compilation on the host. Since the thread pool does not record when a
+ * task starts running, the LLVM spans start at the later of the submission
+ * time and the end of the previous span. At most 2^20 spans are kept.
+ *
+ * The returned string remains valid until the next call to this function or
+ * to \ref jit_kernel_stats().
+ */
+extern JIT_EXPORT const char *jit_kernel_stats_trace();
+
+/// Clear the statistics of \ref jit_kernel_stats() and \ref jit_kernel_stats_trace()
+extern JIT_EXPORT void jit_kernel_stats_clear();
+
 #if defined(__cplusplus)
 }
 
@@ -80,6 +80,26 @@ jit_optix_configure_sbt(const OptixShaderBindingTable *sbt, uint32_t pipeline);
 extern JIT_EXPORT void
 jit_optix_update_sbt(uint32_t index, const OptixShaderBindingTable *sbt);
 
+/**
+ * \brief Overwrite a range of records of an existing Shader Binding Table
+ *
+ * Copies \c count records (each consisting of the packed header and the
+ * record data, i.e. \c hitgroupRecordStrideInBytes or \c
+ * missRecordStrideInBytes bytes) from host memory at \c records into the
+ * hitgroup (<tt>miss == 0</tt>) or miss (<tt>miss != 0</tt>) records of the
+ * table \c index, starting at record \c offset.
+ *
+ * The table stays in device memory. Updates are batched and uploaded right
+ * before the next launch that uses the table, which merges updates of
+ * adjacent records into a single copy. This is considerably cheaper than
+ * rebuilding the table via \ref jit_optix_update_sbt() when only a few
+ * records change (e.g. in animated scenes).
+ */
+extern JIT_EXPORT void jit_optix_update_sbt_records(uint32_t index, int miss,
+                                                    uint32_t offset,
+                                                    uint32_t count,
+                                                    const void *records);
+
 /**
   * \brief Insert a function call to optixTrace into the program
   *
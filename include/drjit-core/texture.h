@@ -1,5 +1,6 @@
 /*
     drjit-core/texture.h -- creating and querying of 1D/2D/3D textures on CUDA
+    and LLVM
 
     Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
 
@@ -37,12 +38,28 @@ extern "C" {
  * <li><tt>wrap_mode == 2</tt>: Mirror</li>
  * <ul>
  *
+ * The \c format parameter selects the storage format of the texels:
+ *
+ * <ul>
+ * <li><tt>format == 0</tt>: Single precision (32 bit) floats</li>
+ * <li><tt>format == 1</tt>: Half precision (16 bit) floats, which halves the
+ * memory footprint and bandwidth of lookups. Copies to and from the texture
+ * still use single precision arrays and are converted on the device.</li>
+ * <ul>
+ *
+ * When \c n_layers is nonzero, the function allocates a layered 1D or 2D
+ * texture (e.g. an atlas of equally-sized images) with \c n_layers layers.
+ * Copies then transfer all layers at once, with the layer being the
+ * outermost dimension, and lookups take an additional layer index.
+ *
  * Further modes (e.g. MIP-mapping) may be added in the future.
  */
 extern JIT_EXPORT void *jit_cuda_tex_create(size_t ndim, const size_t *shape,
                                             size_t n_channels,
                                             int filter_mode JIT_DEF(1),
-                                            int wrap_mode JIT_DEF(0));
+                                            int wrap_mode JIT_DEF(0),
+                                            int format JIT_DEF(0),
+                                            size_t n_layers JIT_DEF(0));
 
 
 /**
@@ -94,7 +111,8 @@ extern JIT_EXPORT void jit_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
  *
  * \param pos
  *     Pointer to a list of <tt>ndim - 1 </tt> float32 variable indices
- *     encoding the position of the texture lookup
+ *     encoding the position of the texture lookup. Layered textures expect
+ *     an additional uint32 variable index (the layer) at <tt>pos[ndim]</tt>.
  *
  * \param out
  *     Pointer to an array of size equal to the number of channels in the
@@ -109,8 +127,8 @@ extern JIT_EXPORT void jit_cuda_tex_lookup(size_t ndim,
  * \brief Fetches the four texels that would be referenced in a texture lookup
  * with bilinear interpolation without actually performing this interpolation.
  *
- * This function exclusively operates on two-dimensional textures. A lower or
- * higher number of dimensions will raise an error.
+ * This function exclusively operates on two-dimensional textures without
+ * layers. A lower or higher number of dimensions will raise an error.
  *
  * \param ndim
  *     Dimensionality of the texture
@@ -135,6 +153,58 @@ extern JIT_EXPORT void jit_cuda_tex_bilerp_fetch(size_t ndim,
 /// Destroys the provided texture handle
 extern JIT_EXPORT void jit_cuda_tex_destroy(void *texture_handle);
 
+/**
+ * \brief Allocate an LLVM texture
+ *
+ * The LLVM counterparts of the functions above accept the same arguments
+ * and return an opaque texture handle that may only be used with the
+ * <tt>jit_llvm_tex_*()</tt> functions. Texels are stored in tiles of
+ * <tt>4x4</tt> (2D) or <tt>4x4x4</tt> (3D) texels to improve the cache
+ * locality of filtered lookups, which are expressed using vectorized gathers.
+ *
+ * In addition to the modes of \ref jit_cuda_tex_create(), <tt>filter_mode ==
+ * 2</tt> selects cubic B-spline interpolation (4 texels per dimension).
+ */
+extern JIT_EXPORT void *jit_llvm_tex_create(size_t ndim, const size_t *shape,
+                                            size_t n_channels,
+                                            int filter_mode JIT_DEF(1),
+                                            int wrap_mode JIT_DEF(0));
+
+/// LLVM version of \ref jit_cuda_tex_get_shape()
+extern JIT_EXPORT void jit_llvm_tex_get_shape(size_t ndim,
+                                              const void *texture_handle,
+                                              size_t *shape);
+
+/**
+ * \brief Copy from host memory to an LLVM texture
+ *
+ * Unlike the CUDA version, this operation waits for queued kernels and then
+ * runs synchronously.
+ */
+extern JIT_EXPORT void jit_llvm_tex_memcpy_d2t(size_t ndim, const size_t *shape,
+                                               const void *src_ptr,
+                                               void *dst_texture_handle);
+
+/// LLVM version of \ref jit_cuda_tex_memcpy_t2d() (runs synchronously)
+extern JIT_EXPORT void jit_llvm_tex_memcpy_t2d(size_t ndim, const size_t *shape,
+                                               const void *src_texture_handle,
+                                               void *dst_ptr);
+
+/// LLVM version of \ref jit_cuda_tex_lookup()
+extern JIT_EXPORT void jit_llvm_tex_lookup(size_t ndim,
+                                           const void *texture_handle,
+                                           const uint32_t *pos,
+                                           uint32_t *out);
+
+/// LLVM version of \ref jit_cuda_tex_bilerp_fetch()
+extern JIT_EXPORT void jit_llvm_tex_bilerp_fetch(size_t ndim,
+                                                 const void *texture_handle,
+                                                 const uint32_t *pos,
+                                                 uint32_t *out);
+
+/// Destroys the provided LLVM texture handle
+extern JIT_EXPORT void jit_llvm_tex_destroy(void *texture_handle);
+
 #if defined(__cplusplus)
 }
 #endif
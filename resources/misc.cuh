@@ -31,6 +31,28 @@ KERNEL void fill_64(uint64_t *out, uint32_t size, uint64_t value) {
         out[i] = value;
 }
 
+struct PokeRecord {
+    void *dst;
+    uint64_t value;
+    uint32_t size;
+    uint32_t unused;
+};
+
+/// Update many individual elements at once (for jit_var_write_batch())
+KERNEL void poke_batch(const PokeRecord *rec_, uint32_t size) {
+    for (uint32_t i = blockIdx.x * blockDim.x + threadIdx.x; i < size;
+         i += blockDim.x * gridDim.x) {
+        PokeRecord rec = rec_[i];
+
+        switch (rec.size) {
+            case 1: *(uint8_t *)  rec.dst = (uint8_t)  rec.value; break;
+            case 2: *(uint16_t *) rec.dst = (uint16_t) rec.value; break;
+            case 4: *(uint32_t *) rec.dst = (uint32_t) rec.value; break;
+            case 8: *(uint64_t *) rec.dst = rec.value; break;
+        }
+    }
+}
+
 struct VCallDataRecord {
     uint32_t offset;
     uint32_t size;
@@ -15,9 +15,14 @@
 #include "registry.h"
 #include "llvm.h"
 #include "cuda_tex.h"
+#include "llvm_tex.h"
 #include "op.h"
 #include "vcall.h"
 #include "loop.h"
+#include "freeze.h"
+#include "numa.h"
+#include "stats.h"
+#include "interop.h"
 #include <thread>
 #include <condition_variable>
 #include <drjit-core/texture.h>
@@ -265,6 +270,58 @@ void jit_cuda_set_target(uint32_t ptx_version, uint32_t compute_capability) {
     ts->compute_capability = compute_capability;
 }
 
+void jit_cuda_graph_begin() {
+    lock_guard guard(state.lock);
+    jitc_cuda_graph_begin();
+}
+
+int jit_cuda_graph_end() {
+    lock_guard guard(state.lock);
+    return jitc_cuda_graph_end();
+}
+
+void jit_cuda_stream_wait(void *stream) {
+    lock_guard guard(state.lock);
+    jitc_cuda_stream_wait(stream);
+}
+
+void jit_cuda_stream_signal(void *stream) {
+    lock_guard guard(state.lock);
+    jitc_cuda_stream_signal(stream);
+}
+
+void *jit_cuda_external_memory_import(int handle_type, void *handle,
+                                      size_t size, int dedicated, void **ptr) {
+    lock_guard guard(state.lock);
+    return jitc_cuda_external_memory_import(handle_type, handle, size,
+                                            dedicated, ptr);
+}
+
+void jit_cuda_external_memory_destroy(void *memory) {
+    lock_guard guard(state.lock);
+    jitc_cuda_external_memory_destroy(memory);
+}
+
+void *jit_cuda_external_semaphore_import(int handle_type, void *handle) {
+    lock_guard guard(state.lock);
+    return jitc_cuda_external_semaphore_import(handle_type, handle);
+}
+
+void jit_cuda_external_semaphore_wait(void *semaphore, uint64_t value) {
+    lock_guard guard(state.lock);
+    jitc_cuda_external_semaphore_wait(semaphore, value);
+}
+
+void jit_cuda_external_semaphore_signal(void *semaphore, uint64_t value) {
+    lock_guard guard(state.lock);
+    jitc_cuda_external_semaphore_signal(semaphore, value);
+}
+
+void jit_cuda_external_semaphore_destroy(void *semaphore) {
+    lock_guard guard(state.lock);
+    jitc_cuda_external_semaphore_destroy(semaphore);
+}
+
 void *jit_cuda_lookup(const char *name) {
     lock_guard guard(state.lock);
     return jitc_cuda_lookup(name);
@@ -274,6 +331,21 @@ void jit_llvm_set_thread_count(uint32_t size) {
     pool_set_size(nullptr, size);
 }
 
+void jit_llvm_set_numa_policy(NumaPolicy policy) {
+    lock_guard guard(state.lock);
+    jitc_numa_set_policy(policy);
+}
+
+NumaPolicy jit_llvm_numa_policy() {
+    lock_guard guard(state.lock);
+    return jitc_numa_policy;
+}
+
+uint32_t jit_llvm_numa_nodes() {
+    lock_guard guard(state.lock);
+    return jitc_numa_node_count();
+}
+
 void jit_llvm_set_target(const char *target_cpu,
                          const char *target_features,
                          uint32_t vector_width) {
@@ -281,6 +353,12 @@ void jit_llvm_set_target(const char *target_cpu,
     jitc_llvm_set_target(target_cpu, target_features, vector_width);
 }
 
+void jit_llvm_add_target_version(const char *target_cpu,
+                                 const char *target_features) {
+    lock_guard guard(state.lock);
+    jitc_llvm_add_target_version(target_cpu, target_features);
+}
+
 const char *jit_llvm_target_cpu() {
     lock_guard guard(state.lock);
     return jitc_llvm_target_cpu;
@@ -325,6 +403,83 @@ void jit_flush_kernel_cache() {
     jitc_flush_kernel_cache();
 }
 
+uint32_t jit_kernel_cache_manifest(const char *filename) {
+    lock_guard guard(state.lock);
+    return jitc_kernel_cache_manifest(filename);
+}
+
+void jit_kernel_cache_prefetch(const char *filename) {
+    lock_guard guard(state.lock);
+    jitc_kernel_cache_prefetch(filename);
+}
+
+void jit_set_kernel_cache_limits(size_t max_size, uint32_t max_entries,
+                                 size_t max_disk_size,
+                                 uint32_t max_disk_entries) {
+    lock_guard guard(state.lock);
+    state.kernel_cache_max_size = max_size;
+    state.kernel_cache_max_entries = max_entries;
+    /* Disk cache settings */ {
+        lock_guard guard_2(state.kernel_cache_lock);
+        state.kernel_cache_max_disk_size = max_disk_size;
+        state.kernel_cache_max_disk_entries = max_disk_entries;
+    }
+    jitc_kernel_cache_trim();
+}
+
+void jit_set_kernel_cache_codec(KernelCacheCodec codec, int level) {
+    lock_guard guard(state.lock);
+    if ((uint32_t) codec > (uint32_t) KernelCacheCodec::None)
+        jitc_raise("jit_set_kernel_cache_codec(): unknown codec %u!",
+                   (uint32_t) codec);
+    lock_guard guard_2(state.kernel_cache_lock);
+    state.kernel_cache_codec = codec;
+    state.kernel_cache_level = level;
+}
+
+void jit_set_kernel_cache_dict(const char *filename) {
+    lock_guard guard(state.lock);
+    jitc_kernel_cache_set_dict(filename);
+}
+
+void jit_set_kernel_cache_train_path(const char *path) {
+    lock_guard guard(state.lock);
+    jitc_kernel_cache_set_train_path(path);
+}
+
+void jit_kernel_cache_stats(size_t *hits, size_t *soft_misses,
+                            size_t *hard_misses, size_t *evictions) {
+    lock_guard guard(state.lock);
+    if (hits)
+        *hits = state.kernel_hits;
+    if (soft_misses)
+        *soft_misses = state.kernel_soft_misses;
+    if (hard_misses)
+        *hard_misses = state.kernel_hard_misses;
+    if (evictions)
+        *evictions = state.kernel_evictions;
+}
+
+void jit_stats(JitStats *stats) {
+    lock_guard guard(state.lock);
+    jitc_stats(stats);
+}
+
+void jit_set_sync_profile(int level) {
+    lock_guard guard(state.lock);
+    jitc_set_sync_profile(level);
+}
+
+const char *jit_sync_profile() {
+    lock_guard guard(state.lock);
+    return jitc_sync_profile();
+}
+
+void jit_sync_profile_clear() {
+    lock_guard guard(state.lock);
+    jitc_sync_profile_clear();
+}
+
 void *jit_malloc(AllocType type, size_t size) {
     lock_guard guard(state.lock);
     return jitc_malloc(type, size);
@@ -335,6 +490,21 @@ void jit_free(void *ptr) {
     jitc_free(ptr);
 }
 
+void *jit_malloc_reserve(AllocType type, size_t size, size_t capacity) {
+    lock_guard guard(state.lock);
+    return jitc_malloc_reserve(type, size, capacity);
+}
+
+int jit_malloc_grow(void *ptr, size_t size) {
+    lock_guard guard(state.lock);
+    return (int) jitc_malloc_grow(ptr, size);
+}
+
+void jit_malloc_prefetch(void *ptr, int device) {
+    lock_guard guard(state.lock);
+    jitc_malloc_prefetch(ptr, device);
+}
+
 void jit_flush_malloc_cache() {
     lock_guard guard(state.lock);
     jitc_flush_malloc_cache(false);
@@ -345,6 +515,38 @@ void jit_malloc_clear_statistics() {
     jitc_malloc_clear_statistics();
 }
 
+void jit_malloc_set_limit(AllocType type, size_t limit) {
+    lock_guard guard(state.lock);
+    jitc_malloc_set_limit(type, limit);
+}
+
+const char *jit_malloc_profile() {
+    lock_guard guard(state.lock);
+    return jitc_malloc_profile();
+}
+
+void jit_set_huge_page_policy(HugePagePolicy policy, size_t threshold) {
+    lock_guard guard(state.lock);
+    jitc_set_huge_page_policy(policy, threshold);
+}
+
+void jit_malloc_set_pressure_callback(MemoryPressureCallback callback,
+                                      void *payload) {
+    lock_guard guard(state.lock);
+    state.alloc_pressure_callback = callback;
+    state.alloc_pressure_payload = payload;
+}
+
+void jit_set_eval_memory_warning(size_t bytes) {
+    lock_guard guard(state.lock);
+    state.eval_memory_warning = bytes;
+}
+
+size_t jit_eval_memory_warning() {
+    lock_guard guard(state.lock);
+    return state.eval_memory_warning;
+}
+
 enum AllocType jit_malloc_type(void *ptr) {
     lock_guard guard(state.lock);
     return jitc_malloc_type(ptr);
@@ -388,6 +590,21 @@ uint32_t jit_var_op(JitOp op, const uint32_t *dep) {
     return jitc_var_op(op, dep);
 }
 
+uint32_t jit_var_op_steal(JitOp op, const uint32_t *dep, uint32_t steal) {
+    lock_guard guard(state.lock);
+    uint32_t result = jitc_var_op(op, dep);
+    for (uint32_t i = 0; steal; ++i, steal >>= 1) {
+        if (steal & 1)
+            jitc_var_dec_ref(dep[i]);
+    }
+    return result;
+}
+
+void jit_var_op_batch(uint32_t size, const JitBatchOp *ops, uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_var_op_batch(size, ops, out);
+}
+
 uint32_t jit_var_gather(uint32_t source, uint32_t index,
                             uint32_t mask) {
     lock_guard guard(state.lock);
@@ -412,6 +629,12 @@ uint32_t jit_var_scatter_inc(uint32_t *target, uint32_t index, uint32_t mask) {
     return jitc_var_scatter_inc(target, index, mask);
 }
 
+uint32_t jit_var_compact(uint32_t mask, uint32_t n, const uint32_t *in,
+                         uint32_t *out) {
+    lock_guard guard(state.lock);
+    return jitc_var_compact(mask, n, in, out);
+}
+
 
 uint32_t jit_var_pointer(JitBackend backend, const void *value,
                              uint32_t dep, int write) {
@@ -442,7 +665,7 @@ int jit_var_exists(uint32_t index) {
     if (index == 0)
         return 0;
     lock_guard guard(state.lock);
-    return state.variables.find(index) != state.variables.end();
+    return jitc_var_maybe(index) != nullptr;
 }
 
 uint32_t jit_var_ref(uint32_t index) {
@@ -539,11 +762,44 @@ void jit_var_set_callback(uint32_t index,
     jitc_var_set_callback(index, callback, payload);
 }
 
+void jit_freeze_begin(JitBackend backend, uint32_t n_inputs,
+                      const uint32_t *inputs) {
+    lock_guard guard(state.lock);
+    jitc_freeze_begin(backend, n_inputs, inputs);
+}
+
+void *jit_freeze_end(JitBackend backend, uint32_t n_outputs,
+                     const uint32_t *outputs) {
+    lock_guard guard(state.lock);
+    return jitc_freeze_end(backend, n_outputs, outputs);
+}
+
+void jit_freeze_replay(void *frozen, const uint32_t *inputs,
+                       uint32_t *outputs) {
+    lock_guard guard(state.lock);
+    jitc_freeze_replay((FrozenFunction *) frozen, inputs, outputs);
+}
+
+void jit_freeze_destroy(void *frozen) {
+    lock_guard guard(state.lock);
+    jitc_freeze_destroy((FrozenFunction *) frozen);
+}
+
 uint32_t jit_var_mem_map(JitBackend backend, VarType type, void *ptr, size_t size, int free) {
     lock_guard guard(state.lock);
     return jitc_var_mem_map(backend, type, ptr, size, free);
 }
 
+uint32_t jit_var_dlpack_import(DLManagedTensor *tensor, void *stream) {
+    lock_guard guard(state.lock);
+    return jitc_var_dlpack_import(tensor, stream);
+}
+
+DLManagedTensor *jit_var_dlpack_export(uint32_t index, void *stream) {
+    lock_guard guard(state.lock);
+    return jitc_var_dlpack_export(index, stream);
+}
+
 uint32_t jit_var_mem_copy(JitBackend backend, AllocType atype, VarType vtype,
                           const void *value, size_t size) {
     lock_guard guard(state.lock);
@@ -560,6 +816,24 @@ uint32_t jit_var_migrate(uint32_t index, AllocType type) {
     return jitc_var_migrate(index, type);
 }
 
+void jit_var_shard(uint32_t index, uint32_t count, const int *devices,
+                   uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_var_shard(index, count, devices, out);
+}
+
+uint32_t jit_var_unshard(uint32_t count, const uint32_t *indices,
+                         const int *devices) {
+    lock_guard guard(state.lock);
+    return jitc_var_unshard(count, indices, devices);
+}
+
+uint32_t jit_var_reduce_shards(ReduceOp reduce_op, uint32_t count,
+                               const uint32_t *indices, const int *devices) {
+    lock_guard guard(state.lock);
+    return jitc_var_reduce_shards(reduce_op, count, indices, devices);
+}
+
 void jit_var_mark_side_effect(uint32_t index) {
     lock_guard guard(state.lock);
     jitc_var_mark_side_effect(index);
@@ -570,7 +844,7 @@ uint32_t jit_var_mask_peek(JitBackend backend) {
     return jitc_var_mask_peek(backend);
 }
 
-uint32_t jit_var_mask_apply(uint32_t index, uint32_t size) {
+uint32_t jit_var_mask_apply(uint32_t index, size_t size) {
     lock_guard guard(state.lock);
     return jitc_var_mask_apply(index, size);
 }
@@ -585,7 +859,7 @@ void jit_var_mask_pop(JitBackend backend) {
     jitc_var_mask_pop(backend);
 }
 
-uint32_t jit_var_mask_default(JitBackend backend, uint32_t size) {
+uint32_t jit_var_mask_default(JitBackend backend, size_t size) {
     lock_guard guard(state.lock);
     return jitc_var_mask_default(backend, size);
 }
@@ -605,6 +879,21 @@ uint32_t jit_var_reduce(uint32_t index, ReduceOp reduce_op) {
     return jitc_var_reduce(index, reduce_op);
 }
 
+JitFuture *jit_var_reduce_async(uint32_t index, ReduceOp reduce_op) {
+    lock_guard guard(state.lock);
+    return jitc_var_reduce_async(index, reduce_op);
+}
+
+int jit_future_ready(JitFuture *future) {
+    lock_guard guard(state.lock);
+    return (int) jitc_future_ready(future);
+}
+
+void jit_future_get(JitFuture *future, void *out) {
+    lock_guard guard(state.lock);
+    jitc_future_get(future, out);
+}
+
 const char *jit_var_whos() {
     lock_guard guard(state.lock);
     return jitc_var_whos();
@@ -630,6 +919,19 @@ uint32_t jit_var_write(uint32_t index, size_t offset, const void *src) {
     return jitc_var_write(index, offset, src);
 }
 
+void jit_var_read_batch(uint32_t count, const uint32_t *indices,
+                        const size_t *offsets, void *const *dst) {
+    lock_guard guard(state.lock);
+    jitc_var_read_batch(count, indices, offsets, dst);
+}
+
+void jit_var_write_batch(uint32_t count, const uint32_t *indices,
+                         const size_t *offsets, const void *const *src,
+                         uint32_t *indices_out) {
+    lock_guard guard(state.lock);
+    jitc_var_write_batch(count, indices, offsets, src, indices_out);
+}
+
 void jit_var_printf(JitBackend backend, uint32_t mask, const char *fmt,
                     uint32_t narg, const uint32_t *arg) {
     lock_guard guard(state.lock);
@@ -666,7 +968,7 @@ void jit_prefix_pop(JitBackend backend) {
     jitc_prefix_pop(backend);
 }
 
-void jit_memset_async(JitBackend backend, void *ptr, uint32_t size, uint32_t isize,
+void jit_memset_async(JitBackend backend, void *ptr, size_t size, uint32_t isize,
                       const void *src) {
     lock_guard guard(state.lock);
     jitc_memset_async(backend, ptr, size, isize, src);
@@ -683,17 +985,45 @@ void jit_memcpy_async(JitBackend backend, void *dst, const void *src, size_t siz
 }
 
 void jit_reduce(JitBackend backend, VarType type, ReduceOp rtype, const void *ptr,
-                uint32_t size, void *out) {
+                size_t size, void *out) {
     lock_guard guard(state.lock);
     jitc_reduce(backend, type, rtype, ptr, size, out);
 }
 
 void jit_prefix_sum(JitBackend backend, VarType type, int exclusive, const void *in,
-              uint32_t size, void *out) {
+              size_t size, void *out) {
     lock_guard guard(state.lock);
     jitc_prefix_sum(backend, type, exclusive != 0, in, size, out);
 }
 
+void jit_segmented_reduce(JitBackend backend, VarType type, ReduceOp rtype,
+                          const void *in, const uint32_t *offsets,
+                          uint32_t segment_count, void *out) {
+    lock_guard guard(state.lock);
+    jitc_segmented_reduce(backend, type, rtype, in, offsets, segment_count, out);
+}
+
+uint32_t jit_reduce_by_key(JitBackend backend, VarType type, ReduceOp rtype,
+                           const uint32_t *keys, const void *values,
+                           uint32_t size, uint32_t *keys_out,
+                           void *values_out) {
+    lock_guard guard(state.lock);
+    return jitc_reduce_by_key(backend, type, rtype, keys, values, size,
+                              keys_out, values_out);
+}
+
+void jit_radix_sort(JitBackend backend, VarType type, void *keys,
+                    uint32_t *values, uint32_t size) {
+    lock_guard guard(state.lock);
+    jitc_radix_sort(backend, type, keys, values, size);
+}
+
+void jit_argsort(JitBackend backend, VarType type, const void *keys,
+                 uint32_t size, uint32_t *perm) {
+    lock_guard guard(state.lock);
+    jitc_argsort(backend, type, keys, size, perm);
+}
+
 uint32_t jit_compress(JitBackend backend, const uint8_t *in, uint32_t size, uint32_t *out) {
     lock_guard guard(state.lock);
     return jitc_compress(backend, in, size, out);
@@ -706,17 +1036,25 @@ uint32_t jit_mkperm(JitBackend backend, const uint32_t *values, uint32_t size,
 }
 
 void jit_block_copy(JitBackend backend, enum VarType type, const void *in, void *out,
-                    uint32_t size, uint32_t block_size) {
+                    size_t size, uint32_t block_size) {
     lock_guard guard(state.lock);
     jitc_block_copy(backend, type, in, out, size, block_size);
 }
 
 void jit_block_sum(JitBackend backend, enum VarType type, const void *in, void *out,
-                   uint32_t size, uint32_t block_size) {
+                   size_t size, uint32_t block_size) {
     lock_guard guard(state.lock);
     jitc_block_sum(backend, type, in, out, size, block_size);
 }
 
+void jit_block_prefix_sum(JitBackend backend, VarType type, int exclusive,
+                          const void *in, size_t size, uint32_t block_size,
+                          void *out) {
+    lock_guard guard(state.lock);
+    jitc_block_prefix_sum(backend, type, exclusive != 0, in, size, block_size,
+                          out);
+}
+
 uint32_t jit_registry_put(JitBackend backend, const char *domain, void *ptr) {
     lock_guard guard(state.lock);
     return jitc_registry_put(backend, domain, ptr);
@@ -728,7 +1066,7 @@ void jit_registry_remove(JitBackend backend, void *ptr) {
 }
 
 uint32_t jit_registry_get_id(JitBackend backend, const void *ptr) {
-    lock_guard guard(state.lock);
+    // Lock-free (see registry.cpp)
     return jitc_registry_get_id(backend, ptr);
 }
 
@@ -738,7 +1076,7 @@ const char *jit_registry_get_domain(JitBackend backend, const void *ptr) {
 }
 
 void *jit_registry_get_ptr(JitBackend backend, const char *domain, uint32_t id) {
-    lock_guard guard(state.lock);
+    // Lock-free (see registry.cpp)
     return jitc_registry_get_ptr(backend, domain, id);
 }
 
@@ -765,7 +1103,11 @@ void jit_registry_set_attr(JitBackend backend, void *self, const char *name,
 
 const void *jit_registry_attr_data(JitBackend backend, const char *domain,
                                    const char *name) {
-    lock_guard guard(state.lock);
+    // Lock-free (see registry.cpp) unless changes must be uploaded first
+    if (state.registry(backend)->dirty) {
+        lock_guard guard(state.lock);
+        jitc_registry_flush(backend);
+    }
     return jitc_registry_attr_data(backend, domain, name);
 }
 
@@ -808,10 +1150,11 @@ uint32_t jit_var_loop_cond(uint32_t loop_init, uint32_t cond, size_t n_indices,
 
 uint32_t jit_var_loop(const char *name, uint32_t loop_init, uint32_t loop_cond,
                       size_t n_indices, uint32_t *indices_in,
-                      uint32_t **indices, uint32_t checkpoint, int first_round) {
+                      uint32_t **indices, uint32_t checkpoint, int first_round,
+                      uint32_t unroll) {
     lock_guard guard(state.lock);
     return jitc_var_loop(name, loop_init, loop_cond, n_indices, indices_in,
-                         indices, checkpoint, first_round);
+                         indices, checkpoint, first_round, unroll);
 }
 
 struct VCallBucket *
@@ -832,6 +1175,23 @@ struct KernelHistoryEntry *jit_kernel_history() {
     return state.kernel_history.get();
 }
 
+const char *jit_kernel_stats() {
+    lock_guard guard(state.lock);
+    jitc_sync_thread();
+    return jitc_kernel_stats();
+}
+
+const char *jit_kernel_stats_trace() {
+    lock_guard guard(state.lock);
+    jitc_sync_thread();
+    return jitc_kernel_stats_trace();
+}
+
+void jit_kernel_stats_clear() {
+    lock_guard guard(state.lock);
+    jitc_kernel_stats_clear();
+}
+
 #if defined(DRJIT_ENABLE_OPTIX)
 OptixDeviceContext jit_optix_context() {
     lock_guard guard(state.lock);
@@ -861,6 +1221,12 @@ void jit_optix_update_sbt(uint32_t index, const OptixShaderBindingTable *sbt) {
     jitc_optix_update_sbt(index, sbt);
 }
 
+void jit_optix_update_sbt_records(uint32_t index, int miss, uint32_t offset,
+                                  uint32_t count, const void *records) {
+    lock_guard guard(state.lock);
+    jitc_optix_update_sbt_records(index, miss, offset, count, records);
+}
+
 void jit_optix_ray_trace(uint32_t nargs, uint32_t *args, uint32_t mask,
                          uint32_t pipeline, uint32_t sbt) {
     lock_guard guard(state.lock);
@@ -876,9 +1242,11 @@ void jit_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
 }
 
 void *jit_cuda_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
-                          int filter_mode, int wrap_mode) {
+                          int filter_mode, int wrap_mode, int format,
+                          size_t n_layers) {
     lock_guard guard(state.lock);
-    return jitc_cuda_tex_create(ndim, shape, n_channels, filter_mode, wrap_mode);
+    return jitc_cuda_tex_create(ndim, shape, n_channels, filter_mode, wrap_mode,
+                                format, n_layers);
 }
 
 void jit_cuda_tex_get_shape(size_t ndim, const void *texture_handle,
@@ -916,6 +1284,47 @@ void jit_cuda_tex_destroy(void *texture) {
     jitc_cuda_tex_destroy(texture);
 }
 
+void *jit_llvm_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
+                          int filter_mode, int wrap_mode) {
+    lock_guard guard(state.lock);
+    return jitc_llvm_tex_create(ndim, shape, n_channels, filter_mode, wrap_mode);
+}
+
+void jit_llvm_tex_get_shape(size_t ndim, const void *texture_handle,
+                            size_t *shape) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_get_shape(ndim, texture_handle, shape);
+}
+
+void jit_llvm_tex_memcpy_d2t(size_t ndim, const size_t *shape,
+                             const void *src_ptr, void *dst_texture) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_memcpy_d2t(ndim, shape, src_ptr, dst_texture);
+}
+
+void jit_llvm_tex_memcpy_t2d(size_t ndim, const size_t *shape,
+                             const void *src_texture, void *dst_ptr) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_memcpy_t2d(ndim, shape, src_texture, dst_ptr);
+}
+
+void jit_llvm_tex_lookup(size_t ndim, const void *texture_handle,
+                         const uint32_t *pos, uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_lookup(ndim, texture_handle, pos, out);
+}
+
+void jit_llvm_tex_bilerp_fetch(size_t ndim, const void *texture_handle,
+                               const uint32_t *pos, uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_bilerp_fetch(ndim, texture_handle, pos, out);
+}
+
+void jit_llvm_tex_destroy(void *texture) {
+    lock_guard guard(state.lock);
+    jitc_llvm_tex_destroy(texture);
+}
+
 uint32_t jit_var_neg(uint32_t a0) {
     lock_guard guard(state.lock);
     return jitc_var_neg(a0);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "cuda_api.h"
+#include "hash.h"
 
 /// Major version of the detected CUDA version
 extern int jitc_cuda_version_major;
@@ -20,6 +21,9 @@ extern int jitc_cuda_version_minor;
 /// Return value of the call to cuInit()
 extern CUresult jitc_cuda_cuinit_result;
 
+/// Identifies the GPU architecture of the current context (for the kernel cache)
+extern uint64_t jitc_cuda_target_tag();
+
 /// Attempt to dynamically load CUDA into the process
 extern bool jitc_llvm_api_init();
 
@@ -40,6 +44,55 @@ struct Kernel;
 /// Compile an IR string
 extern void jitc_cuda_compile(const char *str, size_t size, Kernel &kernel);
 
+/// Load a compiled PTX kernel (in kernel.data) into a module and set it up
+extern void jitc_cuda_load(Kernel &kernel, XXH128_hash_t hash);
+
+struct Device;
+
+/**
+ * \brief Begin an autotuning trial of a CUDA kernel (JitFlag::LaunchAutotune)
+ *
+ * \c entry refers to the kernel cache entry, and \c launch to the copy that
+ * is about to be launched. Each call selects the next candidate configuration
+ * and stores it in \c launch, after which the caller must launch the kernel
+ * followed by jitc_cuda_tune_end(). Trials are timed using CUDA events
+ * without ever waiting for them. Once all candidates have been timed, the
+ * fastest configuration is stored in \c entry and in the disk cache.
+ *
+ * Returns \c false when the kernel should be launched normally, e.g. because
+ * the previous trial is still running or the launch is too small to be
+ * representative.
+ */
+extern bool jitc_cuda_tune_begin(const Device &device, Kernel &entry,
+                                 Kernel &launch, XXH128_hash_t hash,
+                                 uint32_t size, CUstream stream);
+
+/// Finish the autotuning trial started by jitc_cuda_tune_begin()
+extern void jitc_cuda_tune_end(const Kernel &entry, CUstream stream);
+
+/// Release the autotuning state of a kernel (if any)
+extern void jitc_cuda_tune_free(const Kernel &kernel);
+
+/// Start capturing the work submitted to the current stream into a CUDA graph
+extern void jitc_cuda_graph_begin();
+
+/// Stop capturing, instantiate or update the graph, and launch it
+extern int jitc_cuda_graph_end();
+
+
+/**
+ * \brief Return the copy stream of the current device (created on demand),
+ * ordered after the work submitted to the thread's stream so far
+ *
+ * Transfers issued on this stream use the DMA engines asynchronously to
+ * kernels launched on other streams. They must be followed by \ref
+ * jitc_copy_stream_end(), which orders the thread's stream after them.
+ */
+extern CUstream jitc_copy_stream_begin(struct ThreadState *ts);
+
+/// Let the thread's stream wait for the transfers issued on the copy stream
+extern void jitc_copy_stream_end(struct ThreadState *ts);
+
 /// Assert that a CUDA operation is correctly issued
 #define cuda_check(err) cuda_check_impl(err, __FILE__, __LINE__)
 extern void cuda_check_impl(CUresult errval, const char *file, const int line);
@@ -90,3 +143,4 @@ extern CUfunction *jitc_cuda_block_sum [(int) VarType::Count];
 extern CUfunction *jitc_cuda_reductions[(int) ReduceOp::Count]
                                        [(int) VarType::Count];
 extern CUfunction *jitc_cuda_vcall_prepare;
+extern CUfunction *jitc_cuda_poke_batch;
@@ -92,6 +92,7 @@ bool jitc_cuda_api_init() {
         LOAD(cuDriverGetVersion);
         LOAD(cuEventCreate);
         LOAD(cuEventDestroy, "v2");
+        LOAD(cuEventQuery);
         LOAD(cuEventRecord);
         LOAD(cuEventSynchronize);
         LOAD(cuEventElapsedTime);
@@ -108,19 +109,23 @@ bool jitc_cuda_api_init() {
         LOAD(cuMemAdvise);
         LOAD(cuMemAlloc, "v2");
         LOAD(cuMemAllocHost, "v2");
+        LOAD(cuMemAllocManaged);
         LOAD(cuMemFree, "v2");
         LOAD(cuMemFreeHost);
 
         LOAD(cuMemcpy);
         LOAD(cuMemcpyAsync);
+        LOAD(cuMemcpyPeerAsync);
         LOAD(cuMemsetD16Async);
         LOAD(cuMemsetD32Async);
         LOAD(cuMemsetD8Async);
+        LOAD(cuMemsetD2D32Async);
         LOAD(cuModuleGetFunction);
         LOAD(cuModuleLoadData);
         LOAD(cuModuleUnload);
         LOAD(cuOccupancyMaxPotentialBlockSize);
         LOAD(cuCtxPushCurrent, "v2");
+        LOAD(cuCtxGetDevice);
         LOAD(cuCtxPopCurrent, "v2");
         LOAD(cuStreamCreate);
         LOAD(cuStreamDestroy, "v2");
@@ -153,6 +158,63 @@ bool jitc_cuda_api_init() {
     cuMemFreeAsync =
         decltype(cuMemFreeAsync)(dlsym(jitc_cuda_handle, "cuMemFreeAsync"));
 
+    // Prefetching of managed memory is optional
+    cuMemPrefetchAsync =
+        decltype(cuMemPrefetchAsync)(dlsym(jitc_cuda_handle, "cuMemPrefetchAsync"));
+
+    // CUDA graph support is optional as well (used by jit_cuda_graph_*())
+    #define LOAD_OPTIONAL(name, symbol) \
+        name = decltype(name)(dlsym(jitc_cuda_handle, symbol))
+    LOAD_OPTIONAL(cuStreamBeginCapture, "cuStreamBeginCapture_v2");
+    LOAD_OPTIONAL(cuStreamEndCapture, "cuStreamEndCapture");
+    LOAD_OPTIONAL(cuGraphInstantiateWithFlags, "cuGraphInstantiateWithFlags");
+    LOAD_OPTIONAL(cuGraphExecUpdate, "cuGraphExecUpdate");
+    LOAD_OPTIONAL(cuGraphLaunch, "cuGraphLaunch");
+    LOAD_OPTIONAL(cuGraphDestroy, "cuGraphDestroy");
+    LOAD_OPTIONAL(cuGraphExecDestroy, "cuGraphExecDestroy");
+    #undef LOAD_OPTIONAL
+
+    if (!cuStreamBeginCapture || !cuStreamEndCapture ||
+        !cuGraphInstantiateWithFlags || !cuGraphExecUpdate || !cuGraphLaunch ||
+        !cuGraphDestroy || !cuGraphExecDestroy)
+        cuStreamBeginCapture = nullptr;
+
+    // Virtual memory management (used by jit_malloc_reserve()) is optional
+    #define LOAD_OPTIONAL(name) \
+        name = decltype(name)(dlsym(jitc_cuda_handle, #name))
+    LOAD_OPTIONAL(cuMemAddressReserve);
+    LOAD_OPTIONAL(cuMemAddressFree);
+    LOAD_OPTIONAL(cuMemCreate);
+    LOAD_OPTIONAL(cuMemRelease);
+    LOAD_OPTIONAL(cuMemMap);
+    LOAD_OPTIONAL(cuMemUnmap);
+    LOAD_OPTIONAL(cuMemSetAccess);
+    LOAD_OPTIONAL(cuMemGetAllocationGranularity);
+    #undef LOAD_OPTIONAL
+
+    if (!cuMemAddressReserve || !cuMemAddressFree || !cuMemCreate ||
+        !cuMemRelease || !cuMemMap || !cuMemUnmap || !cuMemSetAccess ||
+        !cuMemGetAllocationGranularity)
+        cuMemAddressReserve = nullptr;
+
+    // Interop with external memory and semaphores (Vulkan, D3D) is optional
+    #define LOAD_OPTIONAL(name) \
+        name = decltype(name)(dlsym(jitc_cuda_handle, #name))
+    LOAD_OPTIONAL(cuImportExternalMemory);
+    LOAD_OPTIONAL(cuExternalMemoryGetMappedBuffer);
+    LOAD_OPTIONAL(cuDestroyExternalMemory);
+    LOAD_OPTIONAL(cuImportExternalSemaphore);
+    LOAD_OPTIONAL(cuSignalExternalSemaphoresAsync);
+    LOAD_OPTIONAL(cuWaitExternalSemaphoresAsync);
+    LOAD_OPTIONAL(cuDestroyExternalSemaphore);
+    #undef LOAD_OPTIONAL
+
+    if (!cuImportExternalMemory || !cuExternalMemoryGetMappedBuffer ||
+        !cuDestroyExternalMemory || !cuImportExternalSemaphore ||
+        !cuSignalExternalSemaphoresAsync || !cuWaitExternalSemaphoresAsync ||
+        !cuDestroyExternalSemaphore)
+        cuImportExternalMemory = nullptr;
+
     return true;
 }
 
@@ -165,20 +227,33 @@ void jitc_cuda_api_shutdown() {
     Z(cuDeviceGet); Z(cuDeviceGetAttribute); Z(cuDeviceGetCount);
     Z(cuDeviceGetName); Z(cuDevicePrimaryCtxRelease);
     Z(cuDevicePrimaryCtxRetain); Z(cuDeviceTotalMem); Z(cuDriverGetVersion);
-    Z(cuEventCreate); Z(cuEventDestroy); Z(cuEventRecord);
+    Z(cuEventCreate); Z(cuEventDestroy); Z(cuEventQuery); Z(cuEventRecord);
     Z(cuEventSynchronize); Z(cuEventElapsedTime); Z(cuFuncSetAttribute);
     Z(cuGetErrorName); Z(cuGetErrorString); Z(cuInit); Z(cuLaunchHostFunc);
     Z(cuLaunchKernel); Z(cuLinkAddData); Z(cuLinkComplete); Z(cuLinkCreate);
     Z(cuLinkDestroy); Z(cuMemAdvise); Z(cuMemAlloc); Z(cuMemAllocHost);
+    Z(cuMemAllocManaged); Z(cuMemPrefetchAsync);
     Z(cuMemFree); Z(cuMemFreeHost); Z(cuMemcpy); Z(cuMemcpyAsync);
+    Z(cuMemcpyPeerAsync);
     Z(cuMemsetD16Async); Z(cuMemsetD32Async); Z(cuMemsetD8Async);
+    Z(cuMemsetD2D32Async);
     Z(cuModuleGetFunction); Z(cuModuleLoadData); Z(cuModuleUnload);
-    Z(cuOccupancyMaxPotentialBlockSize); Z(cuCtxPushCurrent);
+    Z(cuOccupancyMaxPotentialBlockSize); Z(cuCtxPushCurrent); Z(cuCtxGetDevice);
     Z(cuCtxPopCurrent); Z(cuStreamCreate); Z(cuStreamDestroy);
     Z(cuStreamSynchronize); Z(cuStreamWaitEvent); Z(cuPointerGetAttribute);
     Z(cuArrayCreate); Z(cuArray3DCreate); Z(cuArray3DGetDescriptor);
     Z(cuArrayDestroy); Z(cuTexObjectCreate); Z(cuTexObjectGetResourceDesc);
     Z(cuTexObjectDestroy); Z(cuMemcpy2DAsync); Z(cuMemcpy3DAsync);
+    Z(cuMemAllocAsync); Z(cuMemFreeAsync); Z(cuStreamBeginCapture);
+    Z(cuStreamEndCapture); Z(cuGraphInstantiateWithFlags);
+    Z(cuGraphExecUpdate); Z(cuGraphLaunch); Z(cuGraphDestroy);
+    Z(cuGraphExecDestroy); Z(cuMemAddressReserve); Z(cuMemAddressFree);
+    Z(cuMemCreate); Z(cuMemRelease); Z(cuMemMap); Z(cuMemUnmap);
+    Z(cuMemSetAccess); Z(cuMemGetAllocationGranularity);
+    Z(cuImportExternalMemory); Z(cuExternalMemoryGetMappedBuffer);
+    Z(cuDestroyExternalMemory); Z(cuImportExternalSemaphore);
+    Z(cuSignalExternalSemaphoresAsync); Z(cuWaitExternalSemaphoresAsync);
+    Z(cuDestroyExternalSemaphore);
     #undef Z
 
 #if !defined(_WIN32)
@@ -34,6 +34,8 @@ extern void *jitc_cuda_lookup(const char *name);
 #  define CU_DEVICE_ATTRIBUTE_UNIFIED_ADDRESSING 41
 #  define CU_DEVICE_ATTRIBUTE_TCC_DRIVER 35
 #  define CU_DEVICE_ATTRIBUTE_COMPUTE_PREEMPTION_SUPPORTED 90
+#  define CU_DEVICE_ATTRIBUTE_VIRTUAL_MEMORY_MANAGEMENT_SUPPORTED 102
+#  define CU_DEVICE_ATTRIBUTE_CONCURRENT_MANAGED_ACCESS 89
 
 #  define CU_DEVICE_CPU -1
 
@@ -56,11 +58,16 @@ extern void *jitc_cuda_lookup(const char *name);
 #  define CU_LAUNCH_PARAM_END (void *) 0
 
 #  define CU_MEM_ATTACH_GLOBAL 1
+#  define CU_MEM_ALLOCATION_TYPE_PINNED 1
+#  define CU_MEM_LOCATION_TYPE_DEVICE 1
+#  define CU_MEM_ACCESS_FLAGS_PROT_READWRITE 3
+#  define CU_MEM_ALLOC_GRANULARITY_MINIMUM 0
 #  define CU_MEM_ADVISE_SET_READ_MOSTLY 1
 #  define CU_SHAREDMEM_CARVEOUT_MAX_L1 0
 
 #  define CU_STREAM_DEFAULT 0
 #  define CU_STREAM_NON_BLOCKING 1
+#  define CU_STREAM_CAPTURE_MODE_RELAXED 2
 #  define CU_EVENT_DEFAULT 0
 #  define CU_EVENT_DISABLE_TIMING 2
 #  define CU_MEMORYTYPE_HOST 1
@@ -70,6 +77,7 @@ extern void *jitc_cuda_lookup(const char *name);
 #  define CUDA_ERROR_NOT_INITIALIZED 3
 #  define CUDA_ERROR_DEINITIALIZED 4
 #  define CUDA_ERROR_NOT_FOUND 500
+#  define CUDA_ERROR_NOT_READY 600
 #  define CUDA_ERROR_OUT_OF_MEMORY 2
 #  define CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED 704
 #  define CUDA_SUCCESS 0
@@ -84,10 +92,16 @@ extern void *jitc_cuda_lookup(const char *name);
 #define CU_MEMORYTYPE_DEVICE 2
 #define CU_MEMORYTYPE_ARRAY 3
 
+#define CU_AD_FORMAT_HALF 0x10
 #define CU_AD_FORMAT_FLOAT 0x20
+#define CU_RES_VIEW_FORMAT_HALF_1X16 0x13
+#define CU_RES_VIEW_FORMAT_HALF_2X16 0x14
+#define CU_RES_VIEW_FORMAT_HALF_4X16 0x15
 #define CU_RES_VIEW_FORMAT_FLOAT_1X32 0x16
 #define CU_RES_VIEW_FORMAT_FLOAT_2X32 0x17
 #define CU_RES_VIEW_FORMAT_FLOAT_4X32 0x18
+#define CUDA_ARRAY3D_LAYERED 0x01
+#define CUDA_EXTERNAL_MEMORY_DEDICATED 0x1
 
 using CUcontext    = struct CUctx_st *;
 using CUmodule     = struct CUmod_st *;
@@ -97,10 +111,40 @@ using CUstream     = struct CUstream_st *;
 using CUevent      = struct CUevent_st *;
 using CUarray      = struct CUarray_st *;
 using CUtexObject  = struct CUtexObject_st *;
+using CUgraph      = struct CUgraph_st *;
+using CUgraphExec  = struct CUgraphExec_st *;
+using CUgraphNode  = struct CUgraphNode_st *;
+using CUgraphExecUpdateResult = int;
 using CUresult     = int;
 using CUdevice     = int;
 using CUdeviceptr  = void *;
 using CUjit_option = int;
+using CUmemGenericAllocationHandle = unsigned long long;
+using CUexternalMemory    = struct CUextMemory_st *;
+using CUexternalSemaphore = struct CUextSemaphore_st *;
+
+struct CUmemLocation {
+    int type;
+    int id;
+};
+
+struct CUmemAllocationProp {
+    int type;
+    int requestedHandleTypes;
+    CUmemLocation location;
+    void *win32HandleMetaData;
+    struct {
+        unsigned char compressionType;
+        unsigned char gpuDirectRDMACapable;
+        unsigned short usage;
+        unsigned char reserved[4];
+    } allocFlags;
+};
+
+struct CUmemAccessDesc {
+    CUmemLocation location;
+    int flags;
+};
 
 struct CUDA_ARRAY_DESCRIPTOR {
     size_t Width;
@@ -199,6 +243,58 @@ struct CUDA_MEMCPY3D {
     size_t Depth;
 };
 
+struct CUDA_EXTERNAL_MEMORY_HANDLE_DESC {
+    int type;
+    union {
+        int fd;
+        struct { void *handle; const void *name; } win32;
+        const void *nvSciBufObject;
+    } handle;
+    unsigned long long size;
+    unsigned int flags;
+    unsigned int reserved[16];
+};
+
+struct CUDA_EXTERNAL_MEMORY_BUFFER_DESC {
+    unsigned long long offset;
+    unsigned long long size;
+    unsigned int flags;
+    unsigned int reserved[16];
+};
+
+struct CUDA_EXTERNAL_SEMAPHORE_HANDLE_DESC {
+    int type;
+    union {
+        int fd;
+        struct { void *handle; const void *name; } win32;
+        const void *nvSciSyncObj;
+    } handle;
+    unsigned int flags;
+    unsigned int reserved[16];
+};
+
+struct CUDA_EXTERNAL_SEMAPHORE_SIGNAL_PARAMS {
+    struct {
+        struct { unsigned long long value; } fence;
+        union { void *fence; unsigned long long reserved; } nvSciSync;
+        struct { unsigned long long key; } keyedMutex;
+        unsigned int reserved[12];
+    } params;
+    unsigned int flags;
+    unsigned int reserved[16];
+};
+
+struct CUDA_EXTERNAL_SEMAPHORE_WAIT_PARAMS {
+    struct {
+        struct { unsigned long long value; } fence;
+        union { void *fence; unsigned long long reserved; } nvSciSync;
+        struct { unsigned long long key; unsigned int timeoutMs; } keyedMutex;
+        unsigned int reserved[10];
+    } params;
+    unsigned int flags;
+    unsigned int reserved[16];
+};
+
 #if !defined(DR_CUDA_SYM)
 #  define DR_CUDA_SYM(x) extern x;
 #endif
@@ -217,6 +313,7 @@ DR_CUDA_SYM(CUresult (*cuDeviceTotalMem)(size_t *, CUdevice));
 DR_CUDA_SYM(CUresult (*cuDriverGetVersion)(int *));
 DR_CUDA_SYM(CUresult (*cuEventCreate)(CUevent *, unsigned int));
 DR_CUDA_SYM(CUresult (*cuEventDestroy)(CUevent));
+DR_CUDA_SYM(CUresult (*cuEventQuery)(CUevent));
 DR_CUDA_SYM(CUresult (*cuEventRecord)(CUevent, CUstream));
 DR_CUDA_SYM(CUresult (*cuEventSynchronize)(CUevent));
 DR_CUDA_SYM(CUresult (*cuEventElapsedTime)(float *, CUevent, CUevent));
@@ -238,19 +335,25 @@ DR_CUDA_SYM(CUresult (*cuPointerGetAttribute)(void* data, int, void*));
 DR_CUDA_SYM(CUresult (*cuMemAdvise)(void *, size_t, int, CUdevice));
 DR_CUDA_SYM(CUresult (*cuMemAlloc)(void **, size_t));
 DR_CUDA_SYM(CUresult (*cuMemAllocHost)(void **, size_t));
+DR_CUDA_SYM(CUresult (*cuMemAllocManaged)(CUdeviceptr *, size_t, unsigned int));
 DR_CUDA_SYM(CUresult (*cuMemFree)(void *));
 DR_CUDA_SYM(CUresult (*cuMemFreeHost)(void *));
 DR_CUDA_SYM(CUresult (*cuMemcpy)(void *, const void *, size_t));
 DR_CUDA_SYM(CUresult (*cuMemcpyAsync)(void *, const void *, size_t, CUstream));
+DR_CUDA_SYM(CUresult (*cuMemcpyPeerAsync)(void *, CUcontext, const void *,
+                                          CUcontext, size_t, CUstream));
 DR_CUDA_SYM(CUresult (*cuMemsetD16Async)(void *, unsigned short, size_t, CUstream));
 DR_CUDA_SYM(CUresult (*cuMemsetD32Async)(void *, unsigned int, size_t, CUstream));
 DR_CUDA_SYM(CUresult (*cuMemsetD8Async)(void *, unsigned char, size_t, CUstream));
+DR_CUDA_SYM(CUresult (*cuMemsetD2D32Async)(void *, size_t, unsigned int, size_t,
+                                           size_t, CUstream));
 DR_CUDA_SYM(CUresult (*cuModuleGetFunction)(CUfunction *, CUmodule, const char *));
 DR_CUDA_SYM(CUresult (*cuModuleLoadData)(CUmodule *, const void *));
 DR_CUDA_SYM(CUresult (*cuModuleUnload)(CUmodule));
 DR_CUDA_SYM(CUresult (*cuOccupancyMaxPotentialBlockSize)(int *, int *, CUfunction,
                                                          void *, size_t, int));
 DR_CUDA_SYM(CUresult (*cuCtxPushCurrent)(CUcontext));
+DR_CUDA_SYM(CUresult (*cuCtxGetDevice)(CUdevice *));
 DR_CUDA_SYM(CUresult (*cuCtxPopCurrent)(CUcontext*));
 DR_CUDA_SYM(CUresult (*cuStreamCreate)(CUstream *, unsigned int));
 DR_CUDA_SYM(CUresult (*cuStreamDestroy)(CUstream));
@@ -258,6 +361,32 @@ DR_CUDA_SYM(CUresult (*cuStreamSynchronize)(CUstream));
 DR_CUDA_SYM(CUresult (*cuStreamWaitEvent)(CUstream, CUevent, unsigned int));
 DR_CUDA_SYM(CUresult (*cuMemAllocAsync)(CUdeviceptr *, size_t, CUstream));
 DR_CUDA_SYM(CUresult (*cuMemFreeAsync)(CUdeviceptr, CUstream));
+DR_CUDA_SYM(CUresult (*cuMemPrefetchAsync)(CUdeviceptr, size_t, CUdevice, CUstream));
+DR_CUDA_SYM(CUresult (*cuStreamBeginCapture)(CUstream, int));
+DR_CUDA_SYM(CUresult (*cuStreamEndCapture)(CUstream, CUgraph *));
+DR_CUDA_SYM(CUresult (*cuGraphInstantiateWithFlags)(CUgraphExec *, CUgraph,
+                                                    unsigned long long));
+DR_CUDA_SYM(CUresult (*cuGraphExecUpdate)(CUgraphExec, CUgraph, CUgraphNode *,
+                                          CUgraphExecUpdateResult *));
+DR_CUDA_SYM(CUresult (*cuGraphLaunch)(CUgraphExec, CUstream));
+DR_CUDA_SYM(CUresult (*cuGraphDestroy)(CUgraph));
+DR_CUDA_SYM(CUresult (*cuGraphExecDestroy)(CUgraphExec));
+
+DR_CUDA_SYM(CUresult (*cuMemAddressReserve)(CUdeviceptr *, size_t, size_t,
+                                            CUdeviceptr, unsigned long long));
+DR_CUDA_SYM(CUresult (*cuMemAddressFree)(CUdeviceptr, size_t));
+DR_CUDA_SYM(CUresult (*cuMemCreate)(CUmemGenericAllocationHandle *, size_t,
+                                    const CUmemAllocationProp *,
+                                    unsigned long long));
+DR_CUDA_SYM(CUresult (*cuMemRelease)(CUmemGenericAllocationHandle));
+DR_CUDA_SYM(CUresult (*cuMemMap)(CUdeviceptr, size_t, size_t,
+                                 CUmemGenericAllocationHandle,
+                                 unsigned long long));
+DR_CUDA_SYM(CUresult (*cuMemUnmap)(CUdeviceptr, size_t));
+DR_CUDA_SYM(CUresult (*cuMemSetAccess)(CUdeviceptr, size_t,
+                                       const CUmemAccessDesc *, size_t));
+DR_CUDA_SYM(CUresult (*cuMemGetAllocationGranularity)(
+    size_t *, const CUmemAllocationProp *, int));
 
 DR_CUDA_SYM(CUresult (*cuArrayCreate)(CUarray *, const CUDA_ARRAY_DESCRIPTOR *));
 DR_CUDA_SYM(CUresult (*cuArray3DCreate)(CUarray *, const CUDA_ARRAY3D_DESCRIPTOR *));
@@ -271,4 +400,19 @@ DR_CUDA_SYM(CUresult (*cuTexObjectGetResourceDesc)(CUDA_RESOURCE_DESC *,
                                                    CUtexObject));
 DR_CUDA_SYM(CUresult (*cuMemcpy3DAsync)(const CUDA_MEMCPY3D *, CUstream));
 DR_CUDA_SYM(CUresult (*cuMemcpy2DAsync)(const CUDA_MEMCPY2D *, CUstream));
+
+DR_CUDA_SYM(CUresult (*cuImportExternalMemory)(
+    CUexternalMemory *, const CUDA_EXTERNAL_MEMORY_HANDLE_DESC *));
+DR_CUDA_SYM(CUresult (*cuExternalMemoryGetMappedBuffer)(
+    CUdeviceptr *, CUexternalMemory, const CUDA_EXTERNAL_MEMORY_BUFFER_DESC *));
+DR_CUDA_SYM(CUresult (*cuDestroyExternalMemory)(CUexternalMemory));
+DR_CUDA_SYM(CUresult (*cuImportExternalSemaphore)(
+    CUexternalSemaphore *, const CUDA_EXTERNAL_SEMAPHORE_HANDLE_DESC *));
+DR_CUDA_SYM(CUresult (*cuSignalExternalSemaphoresAsync)(
+    const CUexternalSemaphore *, const CUDA_EXTERNAL_SEMAPHORE_SIGNAL_PARAMS *,
+    unsigned int, CUstream));
+DR_CUDA_SYM(CUresult (*cuWaitExternalSemaphoresAsync)(
+    const CUexternalSemaphore *, const CUDA_EXTERNAL_SEMAPHORE_WAIT_PARAMS *,
+    unsigned int, CUstream));
+DR_CUDA_SYM(CUresult (*cuDestroyExternalSemaphore)(CUexternalSemaphore));
 #endif
@@ -5,6 +5,7 @@
 #include "internal.h"
 #include "io.h"
 #include "optix.h"
+#include "profiler.h"
 #include "../resources/kernels.h"
 #include <lz4.h>
 
@@ -38,6 +39,7 @@ CUfunction *jitc_cuda_block_sum [(int) VarType::Count] { };
 CUfunction *jitc_cuda_reductions[(int) ReduceOp::Count]
                                 [(int) VarType::Count] = { };
 CUfunction *jitc_cuda_vcall_prepare = nullptr;
+CUfunction *jitc_cuda_poke_batch = nullptr;
 
 void jitc_cuda_compile(const char *buf, size_t buf_size, Kernel &kernel) {
     const uintptr_t log_size = 16384;
@@ -93,6 +95,130 @@ void jitc_cuda_compile(const char *buf, size_t buf_size, Kernel &kernel) {
     cuda_check(cuLinkDestroy(link_state));
 }
 
+/* The kernel cache stores the machine code produced by the driver's PTX
+   compiler. It targets the architecture of the device, which the PTX
+   '.target' directive does not always identify (e.g. 'sm_90' on newer GPUs). */
+uint64_t jitc_cuda_target_tag() {
+    CUdevice device = 0;
+    int cc_minor = 0, cc_major = 0;
+    cuda_check(cuCtxGetDevice(&device));
+    cuda_check(cuDeviceGetAttribute(&cc_minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, device));
+    cuda_check(cuDeviceGetAttribute(&cc_major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device));
+    return (uint64_t) (cc_major * 10 + cc_minor) * 0x9e3779b97f4a7c15ull;
+}
+
+uint32_t jitc_cuda_arg_limit(const ThreadState *ts) {
+    bool large = jitc_cuda_version_major > 12 ||
+                 (jitc_cuda_version_major == 12 && jitc_cuda_version_minor >= 1);
+    return large && ts->compute_capability >= 70 ? DRJIT_CUDA_ARG_LIMIT_LARGE
+                                                 : DRJIT_CUDA_ARG_LIMIT;
+}
+
+void jitc_cuda_load(Kernel &kernel, XXH128_hash_t hash) {
+    CUresult ret = (CUresult) 0;
+    /* Unlock while synchronizing */ {
+        unlock_guard guard(state.lock);
+        ret = cuModuleLoadData(&kernel.cuda.mod, kernel.data);
+    }
+    if (ret == CUDA_ERROR_OUT_OF_MEMORY) {
+        jitc_flush_malloc_cache(true);
+        /* Unlock while synchronizing */ {
+            unlock_guard guard(state.lock);
+            ret = cuModuleLoadData(&kernel.cuda.mod, kernel.data);
+        }
+    }
+    cuda_check(ret);
+
+    // Locate the kernel entry point
+    char name[39];
+    snprintf(name, sizeof(name), "drjit_%016llx%016llx",
+             (unsigned long long) hash.high64,
+             (unsigned long long) hash.low64);
+    cuda_check(cuModuleGetFunction(&kernel.cuda.func, kernel.cuda.mod, name));
+
+    // Determine a suitable thread count to maximize occupancy
+    int unused, block_size;
+    cuda_check(cuOccupancyMaxPotentialBlockSize(
+        &unused, &block_size,
+        kernel.cuda.func, nullptr, 0, 0));
+    kernel.cuda.block_size = (uint32_t) block_size;
+
+    // DrJit doesn't use shared memory at all, prefer to have more L1 cache.
+    cuda_check(cuFuncSetAttribute(
+        kernel.cuda.func, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, 0));
+    cuda_check(cuFuncSetAttribute(
+        kernel.cuda.func, CU_FUNC_ATTRIBUTE_PREFERRED_SHARED_MEMORY_CARVEOUT,
+        CU_SHAREDMEM_CARVEOUT_MAX_L1));
+
+    free(kernel.data);
+    kernel.data = nullptr;
+}
+
+void jitc_cuda_graph_begin() {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    if (ts->graph_capture)
+        jitc_raise("jit_cuda_graph_begin(): a capture is already in progress!");
+
+#if defined(DRJIT_DYNAMIC_CUDA)
+    if (!cuStreamBeginCapture)
+        jitc_raise("jit_cuda_graph_begin(): the CUDA driver does not support "
+                   "the required CUDA graph API!");
+#endif
+
+    jitc_log(Debug, "jit_cuda_graph_begin()");
+
+    scoped_set_context guard(ts->context);
+    cuda_check(cuStreamBeginCapture(ts->stream, CU_STREAM_CAPTURE_MODE_RELAXED));
+    ts->graph_capture = true;
+}
+
+/// Try to update an executable graph so that it matches 'graph'
+static bool jitc_cuda_graph_update(CUgraphExec graph_exec, CUgraph graph) {
+#if !defined(DRJIT_DYNAMIC_CUDA) && CUDA_VERSION >= 12000
+    CUgraphExecUpdateResultInfo info;
+    return cuGraphExecUpdate(graph_exec, graph, &info) == CUDA_SUCCESS;
+#else
+    CUgraphNode error_node = nullptr;
+    CUgraphExecUpdateResult result;
+    return cuGraphExecUpdate(graph_exec, graph, &error_node, &result) ==
+           CUDA_SUCCESS;
+#endif
+}
+
+int jitc_cuda_graph_end() {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    if (!ts->graph_capture)
+        jitc_raise("jit_cuda_graph_end(): no capture is in progress!");
+
+    scoped_set_context guard(ts->context);
+
+    CUgraph graph = nullptr;
+    ts->graph_capture = false;
+    cuda_check(cuStreamEndCapture(ts->stream, &graph));
+    jitc_temp_graph_end(ts);
+
+    /* Kernel parameters and launch configurations may differ from the previous
+       capture, which the update handles. A change of the graph structure
+       instead requires a new instantiation. */
+    bool updated =
+        ts->graph_exec && jitc_cuda_graph_update(ts->graph_exec, graph);
+
+    if (!updated) {
+        if (ts->graph_exec)
+            cuda_check(cuGraphExecDestroy(ts->graph_exec));
+        ts->graph_exec = nullptr;
+        cuda_check(cuGraphInstantiateWithFlags(&ts->graph_exec, graph, 0));
+    }
+
+    cuda_check(cuGraphDestroy(graph));
+    cuda_check(cuGraphLaunch(ts->graph_exec, ts->stream));
+
+    jitc_log(Debug, "jit_cuda_graph_end(): %s graph.",
+             updated ? "updated existing" : "instantiated new");
+
+    return (int) updated;
+}
+
 void cuda_check_impl(CUresult errval, const char *file, const int line) {
     if (unlikely(errval != CUDA_SUCCESS && errval != CUDA_ERROR_DEINITIALIZED)) {
         const char *name = nullptr, *msg = nullptr;
@@ -103,11 +229,175 @@ void cuda_check_impl(CUresult errval, const char *file, const int line) {
     }
 }
 
+static ProfilerRegion profiler_region_cuda_init("jit_cuda_init");
+static ProfilerRegion profiler_region_cuda_builtins("jit_cuda_init: loading builtin kernels");
+
+/* Decompressing, compiling (on a cache miss) and loading the builtin kernels
+   accounts for most of the time spent in jitc_cuda_init(). This is therefore
+   postponed until a thread state first binds to the device. */
+void jitc_cuda_load_builtins(const Device &device) {
+    int i = device.id;
+    if (jitc_cuda_module[i])
+        return;
+
+    ProfilerPhase profiler(profiler_region_cuda_builtins);
+    scoped_set_context guard(device.context);
+
+    int cc_minor = 0, cc_major = 0,
+        shared_memory_bytes = (int) device.shared_memory_bytes;
+    cuda_check(cuDeviceGetAttribute(&cc_minor, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR, i));
+    cuda_check(cuDeviceGetAttribute(&cc_major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, i));
+    int cc = cc_major * 10 + cc_minor;
+    char name[256];
+
+    jitc_lz4_init();
+
+    // Choose an appropriate set of builtin kernels
+    const char *kernels           = cc >= 70 ? kernels_70 : kernels_50;
+    int kernels_size_uncompressed = cc >= 70 ? kernels_70_size_uncompressed
+                                             : kernels_50_size_uncompressed;
+    int kernels_size_compressed   = cc >= 70 ? kernels_70_size_compressed
+                                             : kernels_50_size_compressed;
+    XXH128_hash_t kernels_hash;
+    kernels_hash.low64  = cc >= 70 ? kernels_70_hash_low64  : kernels_50_hash_low64;
+    kernels_hash.high64 = cc >= 70 ? kernels_70_hash_high64 : kernels_50_hash_high64;
+
+    // Decompress the supplemental PTX content
+    char *uncompressed =
+        (char *) malloc_check(size_t(kernels_size_uncompressed) + jitc_lz4_dict_size + 1);
+    memcpy(uncompressed, jitc_lz4_dict, jitc_lz4_dict_size);
+    char *uncompressed_ptx = uncompressed + jitc_lz4_dict_size;
+
+    if (LZ4_decompress_safe_usingDict(
+            kernels, uncompressed_ptx, kernels_size_compressed,
+            kernels_size_uncompressed, uncompressed,
+            jitc_lz4_dict_size) != kernels_size_uncompressed)
+        jitc_fail("jit_cuda_init(): decompression of builtin kernels failed!");
+
+    uncompressed_ptx[kernels_size_uncompressed] = '\0';
+
+    hash_combine((size_t &) kernels_hash.low64, (size_t) cc);
+    hash_combine((size_t &) kernels_hash.high64, (size_t) cc);
+
+    Kernel kernel;
+    if (!jitc_kernel_load(uncompressed_ptx, kernels_size_uncompressed,
+                          JitBackend::CUDA, kernels_hash, kernel)) {
+        jitc_cuda_compile(uncompressed_ptx, kernels_size_uncompressed,
+                          kernel);
+        jitc_kernel_write(uncompressed_ptx, kernels_size_uncompressed,
+                          JitBackend::CUDA, kernels_hash, kernel);
+    }
+
+    free(uncompressed);
+
+    // .. and register it with CUDA
+    CUmodule m;
+    cuda_check(cuModuleLoadData(&m, kernel.data));
+    free(kernel.data);
+    jitc_cuda_module[i] = m;
+
+    #define LOAD(name)                                                       \
+        cuda_check(cuModuleGetFunction(&jitc_cuda_##name[i], m, #name))
+
+    LOAD(fill_64);
+    LOAD(mkperm_phase_1_tiny);
+    LOAD(mkperm_phase_1_small);
+    LOAD(mkperm_phase_1_large);
+    LOAD(mkperm_phase_3);
+    LOAD(mkperm_phase_4_tiny);
+    LOAD(mkperm_phase_4_small);
+    LOAD(mkperm_phase_4_large);
+    LOAD(transpose);
+    LOAD(prefix_sum_large_init);
+    LOAD(compress_small);
+    LOAD(compress_large);
+    LOAD(vcall_prepare);
+
+    #undef LOAD
+
+    #define MAXIMIZE_SHARED(name)                                            \
+        cuda_check(cuFuncSetAttribute(                                       \
+            jitc_cuda_##name[i],                                             \
+            CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,                 \
+            shared_memory_bytes))
+
+    // Max out the amount of shared memory available to the following kernels
+    MAXIMIZE_SHARED(mkperm_phase_1_tiny);
+    MAXIMIZE_SHARED(mkperm_phase_1_small);
+    MAXIMIZE_SHARED(mkperm_phase_4_tiny);
+    MAXIMIZE_SHARED(mkperm_phase_4_small);
+
+    #undef MAXIMIZE_SHARED
+
+    // Used by jit_var_write_batch() (optional)
+    if (strstr(kernels_list, "poke_batch"))
+        cuda_check(cuModuleGetFunction(&jitc_cuda_poke_batch[i], m,
+                                       "poke_batch"));
+
+    CUfunction func;
+    for (uint32_t k = 0; k < (uint32_t) VarType::Count; k++) {
+        snprintf(name, sizeof(name), "poke_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_poke[k][i] = func;
+        }
+
+        snprintf(name, sizeof(name), "block_copy_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_block_copy[k][i] = func;
+        }
+
+        snprintf(name, sizeof(name), "block_sum_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_block_sum[k][i] = func;
+        }
+
+        for (uint32_t j = 0; j < (uint32_t) ReduceOp::Count; j++) {
+            snprintf(name, sizeof(name), "reduce_%s_%s", reduction_name[j],
+                     type_name_short[k]);
+            if (strstr(kernels_list, name)) {
+                cuda_check(cuModuleGetFunction(&func, m, name));
+                jitc_cuda_reductions[j][k][i] = func;
+            }
+        }
+
+        snprintf(name, sizeof(name), "prefix_sum_exc_small_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_prefix_sum_exc_small[k][i] = func;
+        }
+
+        snprintf(name, sizeof(name), "prefix_sum_inc_small_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_prefix_sum_inc_small[k][i] = func;
+        }
+
+        snprintf(name, sizeof(name), "prefix_sum_exc_large_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_prefix_sum_exc_large[k][i] = func;
+        }
+
+        snprintf(name, sizeof(name), "prefix_sum_inc_large_%s", type_name_short[k]);
+        if (strstr(kernels_list, name)) {
+            cuda_check(cuModuleGetFunction(&func, m, name));
+            jitc_cuda_prefix_sum_inc_large[k][i] = func;
+        }
+    }
+
+    jitc_log(Debug, "jit_cuda_init(): loaded builtin kernels for device %i.", i);
+}
+
 bool jitc_cuda_init() {
     /// Was the CUDA backend already initialized?
     if (jitc_cuda_module)
         return true;
 
+    ProfilerPhase profiler(profiler_region_cuda_init);
+
     // First, dynamically load CUDA into the process
     if (!jitc_cuda_api_init())
         return false;
@@ -155,16 +445,29 @@ bool jitc_cuda_init() {
         for (uint32_t j = 0; j < (uint32_t) ReduceOp::Count; j++)
             jitc_cuda_reductions[j][k] = (CUfunction *) malloc_check_zero(asize);
     }
+    jitc_cuda_fill_64 = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_1_tiny = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_1_small = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_1_large = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_3 = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_4_tiny = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_4_small = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_mkperm_phase_4_large = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_transpose = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_prefix_sum_large_init = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_compress_small = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_compress_large = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_vcall_prepare = (CUfunction *) malloc_check_zero(asize);
+    jitc_cuda_poke_batch = (CUfunction *) malloc_check_zero(asize);
 
     jitc_cuda_module =
         (CUmodule *) malloc_check_zero(sizeof(CUmodule) * device_count);
 
-    jitc_lz4_init();
-
     for (int i = 0; i < device_count; ++i) {
         int pci_bus_id = 0, pci_dom_id = 0, pci_dev_id = 0, num_sm = 0,
             unified_addr = 0, shared_memory_bytes = 0, cc_minor = 0,
-            cc_major = 0, memory_pool = 0;
+            cc_major = 0, memory_pool = 0, virtual_memory = 0,
+            managed_access = 0;
         bool preemptable = true;
         size_t mem_total = 0;
         char name[256];
@@ -187,6 +490,12 @@ bool jitc_cuda_init() {
         if (jitc_cuda_version_major > 11 || (jitc_cuda_version_major == 11 && jitc_cuda_version_minor >= 2))
             cuda_check(cuDeviceGetAttribute(&memory_pool, CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED, i));
 
+        if (cuMemAddressReserve)
+            cuda_check(cuDeviceGetAttribute(&virtual_memory, CU_DEVICE_ATTRIBUTE_VIRTUAL_MEMORY_MANAGEMENT_SUPPORTED, i));
+
+        if (cuMemPrefetchAsync)
+            cuda_check(cuDeviceGetAttribute(&managed_access, CU_DEVICE_ATTRIBUTE_CONCURRENT_MANAGED_ACCESS, i));
+
         // Determine the device compute capability
         int cc = cc_major * 10 + cc_minor;
 
@@ -218,146 +527,14 @@ bool jitc_cuda_init() {
             continue;
         }
 
-        // Choose an appropriate set of builtin kernels
-        const char *kernels           = cc >= 70 ? kernels_70 : kernels_50;
-        int kernels_size_uncompressed = cc >= 70 ? kernels_70_size_uncompressed
-                                                 : kernels_50_size_uncompressed;
-        int kernels_size_compressed   = cc >= 70 ? kernels_70_size_compressed
-                                                 : kernels_50_size_compressed;
-        XXH128_hash_t kernels_hash;
-        kernels_hash.low64  = cc >= 70 ? kernels_70_hash_low64  : kernels_50_hash_low64;
-        kernels_hash.high64 = cc >= 70 ? kernels_70_hash_high64 : kernels_50_hash_high64;
-
-        // Decompress the supplemental PTX content
-        char *uncompressed =
-            (char *) malloc_check(size_t(kernels_size_uncompressed) + jitc_lz4_dict_size + 1);
-        memcpy(uncompressed, jitc_lz4_dict, jitc_lz4_dict_size);
-        char *uncompressed_ptx = uncompressed + jitc_lz4_dict_size;
-
-        if (LZ4_decompress_safe_usingDict(
-                kernels, uncompressed_ptx, kernels_size_compressed,
-                kernels_size_uncompressed, uncompressed,
-                jitc_lz4_dict_size) != kernels_size_uncompressed)
-            jitc_fail("jit_cuda_init(): decompression of builtin kernels failed!");
-
-        uncompressed_ptx[kernels_size_uncompressed] = '\0';
-
-        hash_combine((size_t &) kernels_hash.low64, (size_t) cc);
-        hash_combine((size_t &) kernels_hash.high64, (size_t) cc);
-
-        Kernel kernel;
-        if (!jitc_kernel_load(uncompressed_ptx, kernels_size_uncompressed,
-                              JitBackend::CUDA, kernels_hash, kernel)) {
-            jitc_cuda_compile(uncompressed_ptx, kernels_size_uncompressed,
-                              kernel);
-            jitc_kernel_write(uncompressed_ptx, kernels_size_uncompressed,
-                              JitBackend::CUDA, kernels_hash, kernel);
-        }
-
-        free(uncompressed);
-
-        // .. and register it with CUDA
-        CUmodule m;
-        cuda_check(cuModuleLoadData(&m, kernel.data));
-        free(kernel.data);
-        jitc_cuda_module[i] = m;
-
-        #define LOAD(name)                                                       \
-            if (i == 0)                                                          \
-                jitc_cuda_##name = (CUfunction *) malloc_check(                  \
-                    sizeof(CUfunction) * device_count);                          \
-            cuda_check(cuModuleGetFunction(&jitc_cuda_##name[i], m, #name))
-
-        LOAD(fill_64);
-        LOAD(mkperm_phase_1_tiny);
-        LOAD(mkperm_phase_1_small);
-        LOAD(mkperm_phase_1_large);
-        LOAD(mkperm_phase_3);
-        LOAD(mkperm_phase_4_tiny);
-        LOAD(mkperm_phase_4_small);
-        LOAD(mkperm_phase_4_large);
-        LOAD(transpose);
-        LOAD(prefix_sum_large_init);
-        LOAD(compress_small);
-        LOAD(compress_large);
-        LOAD(vcall_prepare);
-
-        #undef LOAD
-
-        #define MAXIMIZE_SHARED(name)                                            \
-            cuda_check(cuFuncSetAttribute(                                       \
-                jitc_cuda_##name[i],                                             \
-                CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,                 \
-                shared_memory_bytes))
-
-        // Max out the amount of shared memory available to the following kernels
-        MAXIMIZE_SHARED(mkperm_phase_1_tiny);
-        MAXIMIZE_SHARED(mkperm_phase_1_small);
-        MAXIMIZE_SHARED(mkperm_phase_4_tiny);
-        MAXIMIZE_SHARED(mkperm_phase_4_small);
-
-        #undef MAXIMIZE_SHARED
-
-        CUfunction func;
-        for (uint32_t k = 0; k < (uint32_t) VarType::Count; k++) {
-            snprintf(name, sizeof(name), "poke_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_poke[k][i] = func;
-            }
-
-            snprintf(name, sizeof(name), "block_copy_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_block_copy[k][i] = func;
-            }
-
-            snprintf(name, sizeof(name), "block_sum_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_block_sum[k][i] = func;
-            }
-
-            for (uint32_t j = 0; j < (uint32_t) ReduceOp::Count; j++) {
-                snprintf(name, sizeof(name), "reduce_%s_%s", reduction_name[j],
-                         type_name_short[k]);
-                if (strstr(kernels_list, name)) {
-                    cuda_check(cuModuleGetFunction(&func, m, name));
-                    jitc_cuda_reductions[j][k][i] = func;
-                }
-            }
-
-            snprintf(name, sizeof(name), "prefix_sum_exc_small_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_prefix_sum_exc_small[k][i] = func;
-            }
-
-            snprintf(name, sizeof(name), "prefix_sum_inc_small_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_prefix_sum_inc_small[k][i] = func;
-            }
-
-            snprintf(name, sizeof(name), "prefix_sum_exc_large_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_prefix_sum_exc_large[k][i] = func;
-            }
-
-            snprintf(name, sizeof(name), "prefix_sum_inc_large_%s", type_name_short[k]);
-            if (strstr(kernels_list, name)) {
-                cuda_check(cuModuleGetFunction(&func, m, name));
-                jitc_cuda_prefix_sum_inc_large[k][i] = func;
-            }
-        }
-
         Device device;
         device.id = i;
         device.compute_capability = cc_major * 10 + cc_minor;
         device.shared_memory_bytes = (uint32_t) shared_memory_bytes;
         device.num_sm = (uint32_t) num_sm;
         device.memory_pool = memory_pool != 0;
+        device.virtual_memory = virtual_memory != 0;
+        device.managed_prefetch = managed_access != 0;
         device.preemptable = preemptable;
         device.compute_capability = 50;
         device.ptx_version = 60;
@@ -411,9 +588,26 @@ void jitc_cuda_shutdown() {
 #if defined(DRJIT_ENABLE_OPTIX)
             jitc_optix_context_destroy(dev);
 #endif
-            cuda_check(cuModuleUnload(jitc_cuda_module[dev.id]));
+            if (jitc_cuda_module[dev.id])
+                cuda_check(cuModuleUnload(jitc_cuda_module[dev.id]));
             cuda_check(cuStreamDestroy(dev.stream));
             cuda_check(cuEventDestroy(dev.event));
+            for (CUstream stream : dev.aux_stream) {
+                if (stream)
+                    cuda_check(cuStreamDestroy(stream));
+            }
+            for (CUevent event : dev.aux_events)
+                cuda_check(cuEventDestroy(event));
+            if (dev.copy_stream) {
+                cuda_check(cuStreamDestroy(dev.copy_stream));
+                cuda_check(cuEventDestroy(dev.copy_event));
+                for (int i = 0; i < DRJIT_MIGRATE_RING_SIZE; ++i) {
+                    if (!dev.copy_ring[i])
+                        continue;
+                    cuda_check(cuMemFreeHost(dev.copy_ring[i]));
+                    cuda_check(cuEventDestroy(dev.copy_ring_event[i]));
+                }
+            }
         }
         cuda_check(cuDevicePrimaryCtxRelease(dev.id));
     }
@@ -430,9 +624,11 @@ void jitc_cuda_shutdown() {
     Z(jitc_cuda_mkperm_phase_4_small);
     Z(jitc_cuda_mkperm_phase_4_large);
     Z(jitc_cuda_transpose);
+    Z(jitc_cuda_poke_batch);
     Z(jitc_cuda_prefix_sum_large_init);
     Z(jitc_cuda_compress_small);
     Z(jitc_cuda_compress_large);
+    Z(jitc_cuda_vcall_prepare);
     Z(jitc_cuda_module);
 
     for (uint32_t k = 0; k < (uint32_t) VarType::Count; k++) {
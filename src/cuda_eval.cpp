@@ -49,8 +49,10 @@
     } while (0);
 
 // Forward declarations
-static void jitc_cuda_render_stmt(uint32_t index, const Variable *v);
 static void jitc_cuda_render_var(uint32_t index, Variable *v);
+static void jitc_cuda_render_half(const char *op, const Variable *v,
+                                  const Variable *a0,
+                                  const Variable *a1 = nullptr);
 static void jitc_cuda_render_scatter(const Variable *v, const Variable *ptr,
                                      const Variable *value, const Variable *index,
                                      const Variable *mask);
@@ -69,7 +71,7 @@ static void jitc_cuda_render_trace(uint32_t index, const Variable *v,
 
 void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
                         uint32_t n_regs, uint32_t n_params) {
-    bool params_global = !uses_optix && n_params > DRJIT_CUDA_ARG_LIMIT;
+    bool params_global = !uses_optix && n_params > jitc_cuda_arg_limit(ts);
     bool print_labels  = std::max(state.log_level_stderr,
                                  state.log_level_callback) >= LogLevel::Trace ||
                         (jitc_flags() & (uint32_t) JitFlag::PrintIR);
@@ -88,7 +90,7 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
     /* Special registers:
 
          %r0   :  Index
-         %r1   :  Step
+         %r1   :  Step (unused with persistent threads)
          %r2   :  Size
          %p0   :  Stopping predicate
          %rd0  :  Temporary for parameter pointers
@@ -96,12 +98,20 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
 
          %b3, %w3, %r3, %rd3, %f3, %d3, %p3: reserved for use in compound
          statements that must write a temporary result to a register.
+
+         %f1, %f2: reserved for half precision operations that are
+         evaluated in single precision (see jitc_cuda_render_half()).
     */
 
+    // Parameter lists larger than 4 KiB require PTX ISA 8.1
+    uint32_t ptx_version = ts->ptx_version;
+    if (!uses_optix && !params_global && n_params > DRJIT_CUDA_ARG_LIMIT)
+        ptx_version = std::max(ptx_version, 81u);
+
     fmt(".version $u.$u\n"
         ".target sm_$u\n"
         ".address_size 64\n\n",
-        ts->ptx_version / 10, ts->ptx_version % 10,
+        ptx_version / 10, ptx_version % 10,
         ts->compute_capability);
 
     if (!uses_optix) {
@@ -115,15 +125,69 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
     }
 
     fmt("    .reg.b8   %b <$u>; .reg.b16 %w<$u>; .reg.b32 %r<$u>;\n"
-        "    .reg.b64  %rd<$u>; .reg.f32 %f<$u>; .reg.f64 %d<$u>;\n"
-        "    .reg.pred %p <$u>;\n\n",
-        n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs);
+        "    .reg.b64  %rd<$u>; .reg.f16 %h<$u>; .reg.f32 %f<$u>;\n"
+        "    .reg.f64  %d <$u>; .reg.pred %p<$u>;\n\n",
+        n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs);
 
-    if (!uses_optix) {
-        put("    mov.u32 %r0, %ctaid.x;\n"
+    // Small scatter-reduction targets are accumulated in shared memory
+    jitc_private_scan(group, DRJIT_PRIVATE_LIMIT_CUDA);
+
+    for (uint32_t i = 0; i < (uint32_t) private_targets.size(); ++i) {
+        uint32_t count = private_targets[i].count;
+        fmt("    .shared .align 4 .b8 priv_$u[$u];\n"
+            "    mov.u32 %r3, %tid.x;\n"
+            "    mov.u32 %r1, %ntid.x;\n"
+            "    mov.u64 %rd2, priv_$u;\n"
+            "\n"
+            "priv_$u_init:\n"
+            "    setp.ge.u32 %p3, %r3, $u;\n"
+            "    @%p3 bra priv_$u_ready;\n"
+            "    mad.wide.u32 %rd3, %r3, 4, %rd2;\n"
+            "    st.shared.u32 [%rd3], 0;\n"
+            "    add.u32 %r3, %r3, %r1;\n"
+            "    bra priv_$u_init;\n"
+            "\n"
+            "priv_$u_ready:\n",
+            i, count * 4, i, i, count, i, i, i);
+    }
+
+    if (!private_targets.empty())
+        put("    bar.sync 0;\n\n");
+
+    /* With a permutation (JitFlag::VCallCoherent), the schedule below
+       computes the position '%r4' within it, and '%r0' is looked up */
+    const char *idx = kernel_perm ? "%r4" : "%r0";
+
+    if (!uses_optix && kernel_work_counter) {
+        /* Persistent threads (JitFlag::LoopPersistent): instead of following
+           a fixed grid-stride schedule, every thread fetches its next index
+           from a global counter (the 2nd parameter). Threads whose loops
+           finish early thus pick up more work, and no block waits for
+           a few long-running entries while others are still pending. */
+        if (likely(!params_global)) {
+            put("    ld.param.u32 %r2, [params];\n"
+                "\n"
+                "fetch:\n"
+                "    ld.param.u64 %rd0, [params+8];\n");
+        } else {
+            put("    ld.param.u64 %rd1, [params];\n"
+                "    ldu.global.u32 %r2, [%rd1];\n"
+                "\n"
+                "fetch:\n"
+                "    ldu.global.u64 %rd0, [%rd1+8];\n");
+        }
+
+        fmt("    atom.global.add.u32 $s, [%rd0], 1;\n"
+            "    setp.ge.u32 %p0, $s, %r2;\n"
+            "    @%p0 bra done;\n"
+            "\n", idx, idx);
+
+        fmt("body: // sm_$u\n", state.devices[ts->device].compute_capability);
+    } else if (!uses_optix) {
+        fmt("    mov.u32 $s, %ctaid.x;\n"
             "    mov.u32 %r1, %ntid.x;\n"
             "    mov.u32 %r2, %tid.x;\n"
-            "    mad.lo.u32 %r0, %r0, %r1, %r2;\n");
+            "    mad.lo.u32 $s, $s, %r1, %r2;\n", idx, idx, idx);
 
         if (likely(!params_global)) {
            put("    ld.param.u32 %r2, [params];\n");
@@ -132,15 +196,28 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
                "    ldu.global.u32 %r2, [%rd1];\n");
         }
 
-        put("    setp.ge.u32 %p0, %r0, %r2;\n"
+        fmt("    setp.ge.u32 %p0, $s, %r2;\n"
             "    @%p0 bra done;\n"
             "\n"
             "    mov.u32 %r3, %nctaid.x;\n"
             "    mul.lo.u32 %r1, %r3, %r1;\n"
-            "\n");
+            "\n", idx);
 
         fmt("body: // sm_$u\n", state.devices[ts->device].compute_capability);
-    } else {
+    }
+
+    if (!uses_optix && kernel_perm) {
+        uint32_t offset = kernel_work_counter ? 16 : 8;
+        if (likely(!params_global))
+            fmt("    ld.param.u64 %rd0, [params+$u];\n", offset);
+        else
+            fmt("    ldu.global.u64 %rd0, [%rd1+$u];\n", offset);
+        put("    mad.wide.u32 %rd0, %r4, 4, %rd0;\n"
+            "    ld.global.u32 %r0, [%rd0];\n"
+            "\n");
+    }
+
+    if (uses_optix) {
         put("    call (%r0), _optix_get_launch_index_x, ();\n"
             "    ld.const.u32 %r1, [params + 4];\n"
             "    add.u32 %r0, %r0, %r1;\n\n"
@@ -153,18 +230,21 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
     if (uses_optix) {
         params_type = "const";
     } else if (params_global) {
+        // Read-only, and the same address for all threads
         params_base = "%rd1";
-        params_type = "global";
+        params_type = "global.nc";
     }
 
     for (uint32_t gi = group.start; gi != group.end; ++gi) {
         uint32_t index = schedule[gi].index;
         Variable *v = jitc_var(index);
         const uint32_t vti = v->type,
-                       size = v->size;
+                       size = (uint32_t) v->size;
         const VarType vt = (VarType) vti;
-        ParamType ptype = (ParamType) v->param_type;
-        bool assemble = false;
+        const VariableScratch *vs = jitc_var_scratch(v);
+        if (unlikely(vs->elide))
+            continue; // See jitc_optimize_group()
+        ParamType ptype = (ParamType) vs->param_type;
 
         if (unlikely(v->extra)) {
             auto it = state.extra.find(index);
@@ -180,15 +260,24 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
 
             if (extra.assemble) {
                 extra.assemble(v, extra);
-                assemble = true;
                 v = jitc_var(index); // The address of 'v' can change
             }
         }
 
         if (likely(ptype == ParamType::Input)) {
-            if (v->is_literal()) {
+            if (v->is_literal() && vt == VarType::Pointer) {
                 fmt("    ld.$s.u64 $v, [$s+$o];\n", params_type, v, params_base, v);
                 continue;
+            } else if (v->is_literal()) {
+                // Literal value stored in the parameter slot (JitFlag::LiteralParams)
+                if (vt != VarType::Bool)
+                    fmt("    ld.$s.$b $v, [$s+$o];\n", params_type, v, v,
+                        params_base, v);
+                else
+                    fmt("    ld.$s.u8 %w0, [$s+$o];\n"
+                        "    setp.ne.u16 $v, %w0, 0;\n",
+                        params_type, params_base, v, v);
+                continue;
             } else {
                 fmt("    ld.$s.u64 %rd0, [$s+$o];\n", params_type, params_base, v);
             }
@@ -197,7 +286,7 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
                 fmt("    mad.wide.u32 %rd0, %r0, $a, %rd0;\n", v);
 
             if (vt != VarType::Bool) {
-                fmt("    $s$t $v, [%rd0];\n",
+                fmt("    $s$b $v, [%rd0];\n",
                     size > 1 ? "ld.global.cs." : "ldu.global.", v, v);
             } else {
                 fmt("    $s %w0, [%rd0];\n"
@@ -205,10 +294,8 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
                     size > 1 ? "ld.global.cs.u8" : "ldu.global.u8", v);
             }
             continue;
-        } else if (!v->is_stmt()) {
+        } else {
             jitc_cuda_render_var(index, v);
-        } else if (likely(!assemble)) {
-            jitc_cuda_render_stmt(index, v);
         }
 
         if (ptype == ParamType::Output) {
@@ -218,12 +305,28 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
                For simple operations producing an output though, `v` should remain valid.
             */
             assert(v == jitc_var(index));
+
+            if (unlikely(size != group.size)) {
+                // Scalar output of a fused kernel, written by the first thread
+                fmt("    ld.$s.u64 %rd0, [$s+$o];\n"
+                    "    setp.eq.u32 %p3, %r0, 0;\n",
+                    params_type, params_base, v);
+
+                if (vt != VarType::Bool) {
+                    fmt("    @%p3 st.global.$b [%rd0], $v;\n", v, v);
+                } else {
+                    fmt("    selp.u16 %w0, 1, 0, $v;\n"
+                        "    @%p3 st.global.u8 [%rd0], %w0;\n", v);
+                }
+                continue;
+            }
+
             fmt("    ld.$s.u64 %rd0, [$s+$o];\n"
                 "    mad.wide.u32 %rd0, %r0, $a, %rd0;\n",
                 params_type, params_base, v, v);
 
             if (vt != VarType::Bool) {
-                fmt("    st.global.cs.$t [%rd0], $v;\n", v, v);
+                fmt("    st.global.cs.$b [%rd0], $v;\n", v, v);
             } else {
                 fmt("    selp.u16 %w0, 1, 0, $v;\n"
                     "    st.global.cs.u8 [%rd0], %w0;\n", v);
@@ -231,13 +334,47 @@ void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
         }
     }
 
-    if (!uses_optix) {
+    if (!uses_optix && kernel_work_counter) {
         put("\n"
-            "    add.u32 %r0, %r0, %r1;\n"
-            "    setp.ge.u32 %p0, %r0, %r2;\n"
-            "    @!%p0 bra body;\n"
+            "    bra fetch;\n"
             "\n"
             "done:\n");
+    } else if (!uses_optix) {
+        fmt("\n"
+            "    add.u32 $s, $s, %r1;\n"
+            "    setp.ge.u32 %p0, $s, %r2;\n"
+            "    @!%p0 bra body;\n"
+            "\n"
+            "done:\n", idx, idx, idx);
+    }
+
+    if (!private_targets.empty())
+        put("    bar.sync 0;\n"
+            "    mov.u32 %r1, %ntid.x;\n");
+
+    // Flush the block-local part of privatized scatter-reductions
+    for (uint32_t i = 0; i < (uint32_t) private_targets.size(); ++i) {
+        const PrivateTarget &pt = private_targets[i];
+        const Variable *ptr = jitc_var(pt.ptr_index),
+                       *target = jitc_var(pt.target_index);
+
+        fmt("    ld.$s.u64 %rd0, [$s+$o];\n"
+            "    mov.u32 %r3, %tid.x;\n"
+            "    mov.u64 %rd2, priv_$u;\n"
+            "\n"
+            "priv_$u_flush:\n"
+            "    setp.ge.u32 %p3, %r3, $u;\n"
+            "    @%p3 bra priv_$u_done;\n"
+            "    mad.wide.u32 %rd3, %r3, 4, %rd2;\n"
+            "    ld.shared.b32 %r2, [%rd3];\n"
+            "    setp.ne.b32 %p3, %r2, 0;\n"
+            "    mad.wide.u32 %rd3, %r3, 4, %rd0;\n"
+            "    @%p3 red.global.add.$t [%rd3], %r2;\n"
+            "    add.u32 %r3, %r3, %r1;\n"
+            "    bra priv_$u_flush;\n"
+            "\n"
+            "priv_$u_done:\n",
+            params_type, params_base, ptr, i, i, pt.count, i, target, i, i);
     }
 
     put("    ret;\n"
@@ -315,9 +452,9 @@ void jitc_cuda_assemble_func(const char *name, uint32_t inst_id,
         ") {\n"
         "    // VCall: $s\n"
         "    .reg.b8   %b <$u>; .reg.b16 %w<$u>; .reg.b32 %r<$u>;\n"
-        "    .reg.b64  %rd<$u>; .reg.f32 %f<$u>; .reg.f64 %d<$u>;\n"
-        "    .reg.pred %p <$u>;\n\n",
-        name, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs);
+        "    .reg.b64  %rd<$u>; .reg.f16 %h<$u>; .reg.f32 %f<$u>;\n"
+        "    .reg.f64  %d <$u>; .reg.pred %p<$u>;\n\n",
+        name, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs, n_regs);
 
     for (ScheduledVariable &sv : schedule) {
         Variable *v = jitc_var(sv.index);
@@ -345,12 +482,13 @@ void jitc_cuda_assemble_func(const char *name, uint32_t inst_id,
 
         if (v->vcall_iface) {
             if (vt != VarType::Bool) {
-                fmt("    ld.param.$t $v, [params+$o];\n", v, v, v);
+                fmt("    ld.param.$b $v, [params+$o];\n", v, v, v);
             } else {
                 fmt("    ld.param.u8 %w0, [params+$o];\n"
                     "    setp.ne.u16 $v, %w0, 0;\n", v, v);
             }
-        } else if (v->is_data() || vt == VarType::Pointer) {
+        } else if (v->is_data() || vt == VarType::Pointer ||
+                   jitc_vcall_literal_data(data_map, inst_id, sv.index, v)) {
             uint64_t key = (uint64_t) sv.index + (((uint64_t) inst_id) << 32);
             auto it = data_map.find(key);
 
@@ -368,7 +506,7 @@ void jitc_cuda_assemble_func(const char *name, uint32_t inst_id,
                     "is happening now). This is not allowed.", sv.index);
 
             if (vt != VarType::Bool)
-                fmt("    ld.global.$t $v, [data+$u];\n",
+                fmt("    ld.global.$b $v, [data+$u];\n",
                     v, v, it->second - data_offset);
             else
                 fmt("    ld.global.u8 %w0, [data+$u];\n"
@@ -376,10 +514,8 @@ void jitc_cuda_assemble_func(const char *name, uint32_t inst_id,
                     it->second - data_offset, v);
         } else if (v->is_literal()) {
             fmt("    mov.$b $v, $l;\n", v, v, v);
-        } else if (v->is_node()) {
-            jitc_cuda_render_var(sv.index, v);
         } else {
-            jitc_cuda_render_stmt(sv.index, v);
+            jitc_cuda_render_var(sv.index, v);
         }
     }
 
@@ -392,7 +528,7 @@ void jitc_cuda_assemble_func(const char *name, uint32_t inst_id,
         uint32_t vti = v->type;
 
         if ((VarType) vti != VarType::Bool) {
-            fmt("    st.param.$t [result+$u], $v;\n", v, offset, v);
+            fmt("    st.param.$b [result+$u], $v;\n", v, offset, v);
         } else {
             fmt("    selp.u16 %w0, 1, 0, $v;\n"
                 "    st.param.u8 [result+$u], %w0;\n",
@@ -426,7 +562,9 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Neg:
-            if (jitc_is_uint(v))
+            if (jitc_is_half(v))
+                fmt("    xor.b16 $v, $v, 0x8000;\n", v, a0);
+            else if (jitc_is_uint(v))
                 fmt("    neg.s$u $v, $v;\n", type_size[v->type]*8, v, a0);
             else
                 fmt(jitc_is_single(v) ? "    neg.ftz.$t $v, $v;\n"
@@ -439,12 +577,18 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Sqrt:
-            fmt(jitc_is_single(v) ? "    sqrt.approx.ftz.$t $v, $v;\n"
-                                  : "    sqrt.rn.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("sqrt.approx.ftz", v, a0);
+            else
+                fmt(jitc_is_single(v) ? "    sqrt.approx.ftz.$t $v, $v;\n"
+                                      : "    sqrt.rn.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Abs:
-            fmt("    abs.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                fmt("    and.b16 $v, $v, 0x7FFF;\n", v, a0);
+            else
+                fmt("    abs.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Add:
@@ -462,7 +606,7 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
         case VarKind::Mul:
             if (jitc_is_single(v))
                 stmt = "    mul.ftz.$t $v, $v, $v;\n";
-            else if (jitc_is_double(v))
+            else if (jitc_is_float(v))
                 stmt = "    mul.$t $v, $v, $v;\n";
             else
                 stmt = "    mul.lo.$t $v, $v, $v;\n";
@@ -470,7 +614,10 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Div:
-            if (jitc_is_single(v))
+            if (jitc_is_half(v)) {
+                jitc_cuda_render_half("div.approx.ftz", v, a0, a1);
+                break;
+            } else if (jitc_is_single(v))
                 stmt = "    div.approx.ftz.$t $v, $v, $v;\n";
             else if (jitc_is_double(v))
                 stmt = "    div.rn.$t $v, $v, $v;\n";
@@ -490,7 +637,7 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
         case VarKind::Fma:
             if (jitc_is_single(v))
                 stmt = "    fma.rn.ftz.$t $v, $v, $v, $v;\n";
-            else if (jitc_is_double(v))
+            else if (jitc_is_float(v))
                 stmt = "    fma.rn.$t $v, $v, $v, $v;\n";
             else
                 stmt = "    mad.lo.$t $v, $v, $v, $v;\n";
@@ -498,15 +645,23 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Min:
-            fmt(jitc_is_single(v) ? "    min.ftz.$t $v, $v, $v;\n"
-                                  : "    min.$t $v, $v, $v;\n",
-                                    v, v, a0, a1);
+            // Native half precision min() requires sm_80
+            if (jitc_is_half(v) && thread_state_cuda->compute_capability < 80)
+                jitc_cuda_render_half("min.ftz", v, a0, a1);
+            else
+                fmt(jitc_is_single(v) ? "    min.ftz.$t $v, $v, $v;\n"
+                                      : "    min.$t $v, $v, $v;\n",
+                                        v, v, a0, a1);
             break;
 
         case VarKind::Max:
-            fmt(jitc_is_single(v) ? "    max.ftz.$t $v, $v, $v;\n"
-                                  : "    max.$t $v, $v, $v;\n",
-                                    v, v, a0, a1);
+            // Native half precision max() requires sm_80
+            if (jitc_is_half(v) && thread_state_cuda->compute_capability < 80)
+                jitc_cuda_render_half("max.ftz", v, a0, a1);
+            else
+                fmt(jitc_is_single(v) ? "    max.ftz.$t $v, $v, $v;\n"
+                                      : "    max.$t $v, $v, $v;\n",
+                                        v, v, a0, a1);
             break;
 
         case VarKind::Ceil:
@@ -566,7 +721,7 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
 
         case VarKind::Select:
             if (!jitc_is_bool(a1)) {
-                fmt("    selp.$t $v, $v, $v, $v;\n", v, v, a1, a2, a0);
+                fmt("    selp.$b $v, $v, $v, $v;\n", v, v, a1, a2, a0);
             } else {
                 fmt("    and.pred %p3, $v, $v;\n"
                     "    and.pred %p2, !$v, $v;\n"
@@ -636,12 +791,17 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Rcp:
-            fmt(jitc_is_single(v) ? "    rcp.approx.ftz.$t $v, $v;\n"
-                                  : "    rcp.rn.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("rcp.approx.ftz", v, a0);
+            else
+                fmt(jitc_is_single(v) ? "    rcp.approx.ftz.$t $v, $v;\n"
+                                      : "    rcp.rn.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Rsqrt:
-            if (jitc_is_single(v))
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("rsqrt.approx.ftz", v, a0);
+            else if (jitc_is_single(v))
                 fmt("    rsqrt.approx.ftz.$t $v, $v;\n", v, v, a0);
             else
                 fmt("    rcp.rn.$t $v, $v;\n"
@@ -649,27 +809,45 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             break;
 
         case VarKind::Sin:
-            fmt("    sin.approx.ftz.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("sin.approx.ftz", v, a0);
+            else
+                fmt("    sin.approx.ftz.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Cos:
-            fmt("    cos.approx.ftz.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("cos.approx.ftz", v, a0);
+            else
+                fmt("    cos.approx.ftz.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Exp2:
-            fmt("    ex2.approx.ftz.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("ex2.approx.ftz", v, a0);
+            else
+                fmt("    ex2.approx.ftz.$t $v, $v;\n", v, v, a0);
             break;
 
         case VarKind::Log2:
-            fmt("    lg2.approx.ftz.$t $v, $v;\n", v, v, a0);
+            if (jitc_is_half(v))
+                jitc_cuda_render_half("lg2.approx.ftz", v, a0);
+            else
+                fmt("    lg2.approx.ftz.$t $v, $v;\n", v, v, a0);
             break;
 
 
         case VarKind::Cast:
-            if (jitc_is_bool(v)) {
+            if (jitc_is_bool(v) && jitc_is_half(a0)) {
+                // No half precision immediates, test the non-sign bits
+                fmt("    and.b16 %w3, $v, 0x7FFF;\n"
+                    "    setp.ne.u16 $v, %w3, 0;\n", a0, v);
+            } else if (jitc_is_bool(v)) {
                 fmt(jitc_is_float(a0) ? "    setp.ne.$t $v, $v, 0.0;\n"
                                       : "    setp.ne.$t $v, $v, 0;\n",
                     a0, v, a0);
+            } else if (jitc_is_bool(a0) && jitc_is_half(v)) {
+                fmt("    selp.b16 $v, 0x3C00, 0, $v;\n", v, a0);
             } else if (jitc_is_bool(a0)) {
                 fmt(jitc_is_float(v) ? "    selp.$t $v, 1.0, 0.0, $v;\n"
                                      : "    selp.$t $v, 1, 0, $v;\n",
@@ -697,7 +875,8 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
                 bool is_bool = v->type == (uint32_t) VarType::Bool;
 
                 if (!unmasked)
-                    fmt("    @!$v bra l_$u_masked;\n", a2, v->reg_index);
+                    fmt("    @!$v bra l_$u_masked;\n", a2,
+                        jitc_var_scratch(v)->reg_index);
 
                 if (index_zero) {
                     fmt("    mov.u64 %rd3, $v;\n", a0);
@@ -713,15 +892,16 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
                     fmt("    ld.global.nc.u8 %w0, [%rd3];\n"
                         "    setp.ne.u16 $v, %w0, 0;\n", v);
                 } else {
-                    fmt("    ld.global.nc.$t $v, [%rd3];\n", v, v);
+                    fmt("    ld.global.nc.$b $v, [%rd3];\n", v, v);
                 }
 
                 if (!unmasked)
                     fmt("    bra.uni l_$u_done;\n\n"
                         "l_$u_masked:\n"
                         "    mov.$b $v, 0;\n\n"
-                        "l_$u_done:\n", v->reg_index,
-                        v->reg_index, v, v, v->reg_index);
+                        "l_$u_done:\n", jitc_var_scratch(v)->reg_index,
+                        jitc_var_scratch(v)->reg_index, v, v,
+                        jitc_var_scratch(v)->reg_index);
             }
             break;
 
@@ -752,13 +932,21 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
 
         case VarKind::Dispatch:
             jitc_var_vcall_assemble((VCall *) state.extra[index].callback_data,
-                                    a0->reg_index, a1->reg_index, a2->reg_index,
-                                    a3 ? a3->reg_index : 0);
+                                    jitc_var_scratch(a0)->reg_index,
+                                    jitc_var_scratch(a1)->reg_index,
+                                    jitc_var_scratch(a2)->reg_index,
+                                    a3 ? jitc_var_scratch(a3)->reg_index : 0);
             break;
 
         case VarKind::TexLookup:
             fmt("    .reg.f32 $v_out_<4>;\n", v);
-            if (a3)
+            if (v->literal && a3) // Layered 2D texture, layer index in a3
+                fmt("    tex.a2d.v4.f32.f32 {$v_out_0, $v_out_1, $v_out_2, $v_out_3}, [$v, {$v, $v, $v, $v}];\n",
+                    v, v, v, v, a0, a3, a1, a2, a2);
+            else if (v->literal) // Layered 1D texture, layer index in a2
+                fmt("    tex.a1d.v4.f32.f32 {$v_out_0, $v_out_1, $v_out_2, $v_out_3}, [$v, {$v, $v}];\n",
+                    v, v, v, v, a0, a2, a1);
+            else if (a3)
                 fmt("    tex.3d.v4.f32.f32 {$v_out_0, $v_out_1, $v_out_2, $v_out_3}, [$v, {$v, $v, $v, $v}];\n",
                     v, v, v, v, a0, a1, a2, a3, a3);
             else if (a2)
@@ -785,12 +973,32 @@ static void jitc_cuda_render_var(uint32_t index, Variable *v) {
             fmt("    mov.$b $v, $v_out_$u;\n", v, v, a0, (uint32_t) v->literal);
             break;
 
+        case VarKind::Copy:
+            fmt("    mov.$b $v, $v;\n", v, v, a0);
+            break;
+
         default:
             jitc_fail("jitc_cuda_render_var(): unhandled variable kind \"%s\"!",
                       var_kind_name[(uint32_t) v->kind]);
     }
 }
 
+/**
+ * Half precision operations that PTX lacks (or that require a recent GPU) are
+ * evaluated in single precision: the operands are widened into the reserved
+ * registers %f1 and %f2, and the result is rounded back to half precision.
+ */
+static void jitc_cuda_render_half(const char *op, const Variable *v,
+                                  const Variable *a0, const Variable *a1) {
+    fmt("    cvt.f32.f16 %f1, $v;\n", a0);
+    if (a1)
+        fmt("    cvt.f32.f16 %f2, $v;\n"
+            "    $s.f32 %f1, %f1, %f2;\n", a1, op);
+    else
+        fmt("    $s.f32 %f1, %f1;\n", op);
+    fmt("    cvt.rn.f16.f32 $v, %f1;\n", v);
+}
+
 static void jitc_cuda_render_scatter(const Variable *v,
                                      const Variable *ptr,
                                      const Variable *value,
@@ -801,7 +1009,20 @@ static void jitc_cuda_render_scatter(const Variable *v,
     bool is_bool = value->type == (uint32_t) VarType::Bool;
 
     if (!unmasked)
-        fmt("    @!$v bra l_$u_done;\n", mask, v->reg_index);
+        fmt("    @!$v bra l_$u_done;\n", mask, jitc_var_scratch(v)->reg_index);
+
+    // Accumulate into shared memory (see jitc_private_scan())
+    int priv = callable_depth == 0 ? jitc_private_find(ptr) : -1;
+    if (priv >= 0) {
+        fmt("    mov.u64 %rd3, priv_$u;\n", (uint32_t) priv);
+        if (!index_zero)
+            fmt("    mad.wide.$t %rd3, $v, 4, %rd3;\n", index, index);
+        fmt("    red.shared.add.$t [%rd3], $v;\n", value, value);
+
+        if (!unmasked)
+            fmt("\nl_$u_done:\n", jitc_var_scratch(v)->reg_index);
+        return;
+    }
 
     if (index_zero) {
         fmt("    mov.u64 %rd3, $v;\n", ptr);
@@ -905,13 +1126,16 @@ static void jitc_cuda_render_scatter(const Variable *v,
             fmt("    selp.u16 %w0, 1, 0, $v;\n"
                 "    $s.global$s$s.u8 [%rd3], %w0;\n",
                 value, op_type, v->literal ? "." : "", op);
+        else if (!v->literal)
+            fmt("    st.global.$b [%rd3], $v;\n", value, value);
         else
-            fmt("    $s.global$s$s.$t [%rd3], $v;\n", op_type,
-                v->literal ? "." : "", op, value, value);
+            fmt("    red.global.$s$s.$t [%rd3], $v;\n", op,
+                jitc_is_half(value) && (ReduceOp) v->literal == ReduceOp::Add
+                    ? ".noftz" : "", value, value);
     }
 
     if (!unmasked)
-        fmt("\nl_$u_done:\n", v->reg_index);
+        fmt("\nl_$u_done:\n", jitc_var_scratch(v)->reg_index);
 }
 
 static void jitc_cuda_render_scatter_inc(Variable *v,
@@ -949,7 +1173,7 @@ static void jitc_cuda_render_scatter_inc(Variable *v,
         "}\n");
 
     if (!unmasked)
-        fmt("    @!$v bra l_$u_done;\n", mask, v->reg_index);
+        fmt("    @!$v bra l_$u_done;\n", mask, jitc_var_scratch(v)->reg_index);
 
     if (index_zero) {
         fmt("    mov.u64 %rd3, $v;\n", ptr);
@@ -964,7 +1188,7 @@ static void jitc_cuda_render_scatter_inc(Variable *v,
         "    }\n", v);
 
     if (!unmasked)
-        fmt("\nl_$u_done:\n", v->reg_index);
+        fmt("\nl_$u_done:\n", jitc_var_scratch(v)->reg_index);
 
     v->consumed = 1;
 }
@@ -981,7 +1205,7 @@ static void jitc_cuda_render_scatter_kahan(const Variable *v, uint32_t v_index)
     bool unmasked = mask->is_literal() && mask->literal == 1;
 
     if (!unmasked)
-        fmt("    @!$v bra l_$u_done;\n", mask, v->reg_index);
+        fmt("    @!$v bra l_$u_done;\n", mask, jitc_var_scratch(v)->reg_index);
 
     fmt("    mad.wide.$t %rd2, $v, $a, $v;\n"
         "    mad.wide.$t %rd3, $v, $a, $v;\n",
@@ -1024,7 +1248,7 @@ static void jitc_cuda_render_scatter_kahan(const Variable *v, uint32_t v_index)
         value);
 
     if (!unmasked)
-        fmt("\nl_$u_done:\n", v->reg_index);
+        fmt("\nl_$u_done:\n", jitc_var_scratch(v)->reg_index);
 }
 
 static void jitc_cuda_render_printf(uint32_t index, const Variable *v,
@@ -1150,7 +1374,7 @@ static void jitc_cuda_render_trace(uint32_t index, const Variable *v,
 
     bool masked = !valid->is_literal() || valid->literal != 1;
     if (masked)
-        fmt("    @!$v bra l_masked_$u;\n", valid, v->reg_index);
+        fmt("    @!$v bra l_masked_$u;\n", valid, jitc_var_scratch(v)->reg_index);
 
     fmt("    .reg.u32 $v_payload_type, $v_payload_count;\n"
         "    mov.u32 $v_payload_type, 0;\n"
@@ -1176,69 +1400,17 @@ static void jitc_cuda_render_trace(uint32_t index, const Variable *v,
     put(");\n");
 
     if (masked)
-        fmt("\nl_masked_$u:\n", v->reg_index);
+        fmt("\nl_masked_$u:\n", jitc_var_scratch(v)->reg_index);
 }
 #endif
 
-/// Convert an IR template with '$' expressions into valid IR
-static void jitc_cuda_render_stmt(uint32_t index, const Variable *v) {
-    const char *s = v->stmt;
-    if (unlikely(*s == '\0'))
-        return;
-    put("    ");
-    char c;
-    do {
-        const char *start = s;
-        while (c = *s, c != '\0' && c != '$')
-            s++;
-        put(start, s - start);
-
-        if (c == '$') {
-            s++;
-            const char **prefix_table = nullptr, type = *s++;
-            switch (type) {
-                case 'n': put(";\n    "); continue;
-                case 't': prefix_table = type_name_ptx; break;
-                case 'b': prefix_table = type_name_ptx_bin; break;
-                case 's': prefix_table = type_size_str; break;
-                case 'r': prefix_table = type_prefix; break;
-                default:
-                    jitc_fail("jit_cuda_render_stmt(): encountered invalid \"$\" "
-                              "expression (unknown type \"%c\") in \"%s\"!", type, v->stmt);
-            }
-
-            uint32_t arg_id = *s++ - '0';
-            if (unlikely(arg_id > 4))
-                jitc_fail("jit_cuda_render_stmt(%s): encountered invalid \"$\" "
-                          "expression (argument out of bounds)!", v->stmt);
-
-            uint32_t dep_id = arg_id == 0 ? index : v->dep[arg_id - 1];
-            if (unlikely(dep_id == 0))
-                jitc_fail("jit_cuda_render_stmt(%s): encountered invalid \"$\" "
-                          "expression (referenced variable %u is missing)!", v->stmt, arg_id);
-
-            const Variable *dep = jitc_var(dep_id);
-            const char *prefix = prefix_table[(int) dep->type];
-            put(prefix, strlen(prefix));
-
-            if (type == 'r') {
-                buffer.put_u32(dep->reg_index);
-                if (unlikely(dep->reg_index == 0))
-                    jitc_fail("jitc_cuda_render_stmt(): variable has no register index!");
-            }
-        }
-    } while (c != '\0');
-
-    put(";\n");
-}
-
 /// Virtual function call code generation -- CUDA/PTX-specific bits
 void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
                                   uint32_t self_reg, uint32_t mask_reg,
                                   uint32_t offset_reg, uint32_t data_reg,
-                                  uint32_t n_out, uint32_t in_size,
-                                  uint32_t in_align, uint32_t out_size,
-                                  uint32_t out_align) {
+                                  uint32_t profile_reg, uint32_t n_out,
+                                  uint32_t in_size, uint32_t in_align,
+                                  uint32_t out_size, uint32_t out_align) {
 
     // =====================================================
     // 1. Conditional branch
@@ -1259,6 +1431,12 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
         "        cvt.u32.u64 %r3, %rd3;\n",
         self_reg, offset_reg);
 
+    // Count the calls of each instance (JitFlag::VCallProfile)
+    if (profile_reg)
+        fmt("        mad.wide.u32 %rd2, %r$u, 4, %rd$u;\n"
+            "        red.global.add.u32 [%rd2], 1;\n",
+            self_reg, profile_reg);
+
     // =====================================================
     // 3. Turn callable ID into a function pointer
     // =====================================================
@@ -1288,16 +1466,15 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
 
     // Special handling for predicates
     for (uint32_t in : vcall->in) {
-        auto it = state.variables.find(in);
-        if (it == state.variables.end())
+        const Variable *v2 = jitc_var_maybe(in);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
 
         if ((VarType) v2->type != VarType::Bool)
             continue;
 
         fmt("        selp.u16 %w$u, 1, 0, %p$u;\n",
-            v2->reg_index, v2->reg_index);
+            jitc_var_scratch(v2)->reg_index, jitc_var_scratch(v2)->reg_index);
     }
 
     put("        {\n");
@@ -1333,10 +1510,9 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
 
     uint32_t offset = 0;
     for (uint32_t in : vcall->in) {
-        auto it = state.variables.find(in);
-        if (it == state.variables.end())
+        const Variable *v2 = jitc_var_maybe(in);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
         uint32_t size = type_size[v2->type];
 
         const char *tname = type_name_ptx[v2->type],
@@ -1349,44 +1525,97 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
         }
 
         fmt("            st.param.$s [in+$u], $s$u;\n", tname, offset, prefix,
-            v2->reg_index);
+            jitc_var_scratch(v2)->reg_index);
 
         offset += size;
     }
 
-    if (vcall->use_self) {
-        fmt("            call $s%rd2, (%r$u$s$s), proto;\n",
-            out_size ? "(out), " : "", self_reg,
-            data_reg ? ", %rd3" : "",
-            in_size ? ", in" : "");
-    } else {
-        fmt("            call $s%rd2, ($s$s$s), proto;\n",
-            out_size ? "(out), " : "", data_reg ? "%rd3" : "",
-            data_reg && in_size ? ", " : "", in_size ? "in" : "");
+    // Call the callable of 'hash', or the function pointer in %rd2
+    auto put_call = [&](const XXH128_hash_t *hash) {
+        fmt("            call $s", out_size ? "(out), " : "");
+        if (hash)
+            fmt("func_$Q$Q, ", hash->high64, hash->low64);
+        else
+            put("%rd2, ");
+
+        if (vcall->use_self)
+            fmt("(%r$u$s$s)", self_reg, data_reg ? ", %rd3" : "",
+                in_size ? ", in" : "");
+        else
+            fmt("($s$s$s)", data_reg ? "%rd3" : "",
+                data_reg && in_size ? ", " : "", in_size ? "in" : "");
+
+        fmt("$s", hash ? ";\n" : ", proto;\n");
+    };
+
+    /* Frequently called instances (JitFlag::VCallProfile) use a direct call
+       that ptxas may inline. The callable must be declared before that. */
+    uint32_t n_direct = 0;
+    for (uint32_t id : vcall->hot) {
+        auto it = std::find(vcall->inst_id.begin(), vcall->inst_id.end(), id);
+        if (callable_depth != 0 || uses_optix || it == vcall->inst_id.end())
+            break;
+        const XXH128_hash_t &hash = vcall->inst_hash[it - vcall->inst_id.begin()];
+
+        size_t decl_start = buffer.size(),
+               decl_target =
+                   (char *) strstr(buffer.get(), ".address_size 64\n\n") -
+                   buffer.get() + 18;
+
+        put(".visible .func");
+        if (out_size)
+            fmt(" (.param .align $u .b8 result[$u])", out_align, out_size);
+        fmt(" func_$Q$Q(", hash.high64, hash.low64);
+        if (vcall->use_self)
+            fmt(".reg .u32 self$s", data_reg || in_size ? ", " : "");
+        if (data_reg)
+            fmt(".reg .u64 data$s", in_size ? ", " : "");
+        if (in_size)
+            fmt(".param .align $u .b8 params[$u]", in_align, in_size);
+        put(");\n");
+
+        // Only declare each callable once
+        const char *decl = strstr(buffer.get(), buffer.get() + decl_start);
+        if (decl == buffer.get() + decl_start)
+            buffer.move_suffix(decl_start, decl_target);
+        else
+            buffer.rewind_to(decl_start);
+
+        fmt("            setp.ne.u32 %p3, %r$u, $u;\n"
+            "            @%p3 bra l_direct_$u_$u;\n",
+            self_reg, id, vcall_reg, n_direct);
+        put_call(&hash);
+        fmt("            bra l_direct_$u_done;\n\n"
+            "        l_direct_$u_$u:\n",
+            vcall_reg, vcall_reg, n_direct);
+        n_direct++;
     }
 
+    put_call(nullptr);
+
+    if (n_direct)
+        fmt("\n        l_direct_$u_done:\n", vcall_reg);
+
     // =====================================================
     // 5.2. Read back the output arguments
     // =====================================================
 
     offset = 0;
     for (uint32_t i = 0; i < n_out; ++i) {
-        uint32_t index = vcall->out_nested[i],
-                 index_2 = vcall->out[i];
-        auto it = state.variables.find(index);
-        if (it == state.variables.end())
+        uint32_t index = vcall->out_nested[i];
+        const Variable *v = jitc_var_maybe(index);
+        if (!v)
             continue;
-        uint32_t size = type_size[it->second.type],
+        uint32_t size = type_size[v->type],
                  load_offset = offset;
         offset += size;
 
         // Skip if expired
-        auto it2 = state.variables.find(index_2);
-        if (it2 == state.variables.end())
+        const Variable *v2 = jitc_var(vcall->out[i]);
+        if (!v2)
             continue;
-
-        const Variable *v2 = &it2.value();
-        if (v2->reg_index == 0 || v2->param_type == ParamType::Input)
+        const VariableScratch *vs2 = jitc_var_scratch(v2);
+        if (vs2->reg_index == 0 || vs2->param_type == ParamType::Input)
             continue;
 
         const char *tname = type_name_ptx[v2->type],
@@ -1399,7 +1628,7 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
         }
 
         fmt("            ld.param.$s $s$u, [out+$u];\n",
-            tname, prefix, v2->reg_index, load_offset);
+            tname, prefix, vs2->reg_index, load_offset);
     }
 
     put("        }\n\n");
@@ -1408,19 +1637,19 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
     // 6. Special handling for predicates return value(s)
     // =====================================================
 
-    for (uint32_t out : vcall->out) {
-        auto it = state.variables.find(out);
-        if (it == state.variables.end())
+    for (WeakRef out : vcall->out) {
+        const Variable *v2 = jitc_var(out);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
         if ((VarType) v2->type != VarType::Bool)
             continue;
-        if (v2->reg_index == 0 || v2->param_type == ParamType::Input)
+        const VariableScratch *vs2 = jitc_var_scratch(v2);
+        if (vs2->reg_index == 0 || vs2->param_type == ParamType::Input)
             continue;
 
         // Special handling for predicates
         fmt("        setp.ne.u16 %p$u, %w$u, 0;\n",
-            v2->reg_index, v2->reg_index);
+            vs2->reg_index, vs2->reg_index);
     }
 
 
@@ -1432,12 +1661,12 @@ void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
     // =====================================================
 
     fmt("\nl_masked_$u:\n", vcall_reg);
-    for (uint32_t out : vcall->out) {
-        auto it = state.variables.find(out);
-        if (it == state.variables.end())
+    for (WeakRef out : vcall->out) {
+        const Variable *v2 = jitc_var(out);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
-        if (v2->reg_index == 0 || v2->param_type == ParamType::Input)
+        const VariableScratch *vs2 = jitc_var_scratch(v2);
+        if (vs2->reg_index == 0 || vs2->param_type == ParamType::Input)
             continue;
 
         fmt("    mov.$b $v, 0;\n", v2, v2);
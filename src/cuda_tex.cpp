@@ -4,6 +4,7 @@
 #include "var.h"
 #include "op.h"
 #include "eval.h"
+#include "util.h"
 #include <string.h>
 #include <memory>
 #include <atomic>
@@ -12,6 +13,8 @@ using StagingAreaDeleter = void (*)(void *);
 
 struct DrJitCudaTexture {
     size_t n_channels; /// Total number of channels
+    size_t n_layers; /// Number of layers (0 if the texture is not layered)
+    size_t elem_size; /// Size of a channel in bytes (4: float32, 2: float16)
     size_t n_textures; /// Number of texture objects
     std::atomic_size_t n_referenced_textures; /// Number of referenced textures
     std::unique_ptr<CUtexObject[]> textures; /// Array of CUDA texture objects
@@ -25,8 +28,9 @@ struct DrJitCudaTexture {
      * struct variables and defines the numbers of CUDA textures to be used for
      * the given number of channels.
      */
-    DrJitCudaTexture(size_t n_channels)
-        : n_channels(n_channels), n_textures(1 + ((n_channels - 1) / 4)),
+    DrJitCudaTexture(size_t n_channels, size_t n_layers, size_t elem_size)
+        : n_channels(n_channels), n_layers(n_layers), elem_size(elem_size),
+          n_textures(1 + ((n_channels - 1) / 4)),
           n_referenced_textures(n_textures),
           textures(std::make_unique<CUtexObject[]>(n_textures)),
           indices(std::make_unique<uint32_t[]>(n_textures)),
@@ -81,11 +85,18 @@ struct TextureReleasePayload {
 };
 
 void *jitc_cuda_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
-                           int filter_mode, int wrap_mode) {
+                           int filter_mode, int wrap_mode, int format,
+                           size_t n_layers) {
     if (ndim < 1 || ndim > 3)
         jitc_raise("jit_cuda_tex_create(): invalid texture dimension!");
     else if (n_channels == 0)
         jitc_raise("jit_cuda_tex_create(): must have at least 1 channel!");
+    else if (format != 0 && format != 1)
+        jitc_raise("jit_cuda_tex_create(): invalid format!");
+    else if (n_layers > 0 && ndim == 3)
+        jitc_raise("jit_cuda_tex_create(): 3D textures cannot be layered!");
+
+    bool half = format == 1;
 
     ThreadState *ts = thread_state(JitBackend::CUDA);
     scoped_set_context guard(ts->context);
@@ -133,28 +144,33 @@ void *jitc_cuda_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
     view_desc.width = shape[0];
     view_desc.height = (ndim >= 2) ? shape[1] : 1;
     view_desc.depth = (ndim == 3) ? shape[2] : 0;
+    if (n_layers > 0)
+        view_desc.lastLayer = (unsigned int) n_layers - 1;
 
-    DrJitCudaTexture *texture = new DrJitCudaTexture(n_channels);
+    DrJitCudaTexture *texture =
+        new DrJitCudaTexture(n_channels, n_layers, half ? 2 : 4);
     for (size_t tex = 0; tex < texture->n_textures; ++tex) {
         const size_t tex_channels = texture->channels_internal(tex);
 
         CUarray array = nullptr;
-        if (ndim == 1 || ndim == 2) {
+        if ((ndim == 1 || ndim == 2) && n_layers == 0) {
             CUDA_ARRAY_DESCRIPTOR array_desc;
             memset(&array_desc, 0, sizeof(CUDA_ARRAY_DESCRIPTOR));
             array_desc.Width = shape[0];
             array_desc.Height = (ndim == 2) ? shape[1] : 1;
-            array_desc.Format = CU_AD_FORMAT_FLOAT;
+            array_desc.Format = half ? CU_AD_FORMAT_HALF : CU_AD_FORMAT_FLOAT;
             array_desc.NumChannels = (unsigned int) tex_channels;
             cuda_check(cuArrayCreate(&array, &array_desc));
         } else {
+            // Layered textures store their layers along the depth axis
             CUDA_ARRAY3D_DESCRIPTOR array_desc;
             memset(&array_desc, 0, sizeof(CUDA_ARRAY3D_DESCRIPTOR));
             array_desc.Width = shape[0];
-            array_desc.Height = shape[1];
-            array_desc.Depth = shape[2];
-            array_desc.Format = CU_AD_FORMAT_FLOAT;
+            array_desc.Height = (ndim >= 2) ? shape[1] : 0;
+            array_desc.Depth = (ndim == 3) ? shape[2] : n_layers;
+            array_desc.Format = half ? CU_AD_FORMAT_HALF : CU_AD_FORMAT_FLOAT;
             array_desc.NumChannels = (unsigned int) tex_channels;
+            array_desc.Flags = n_layers > 0 ? CUDA_ARRAY3D_LAYERED : 0;
             cuda_check(cuArray3DCreate(&array, &array_desc));
         }
 
@@ -162,11 +178,14 @@ void *jitc_cuda_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
         texture->arrays[tex] = array;
 
         if (tex_channels == 1)
-            view_desc.format = CU_RES_VIEW_FORMAT_FLOAT_1X32;
+            view_desc.format = half ? CU_RES_VIEW_FORMAT_HALF_1X16
+                                    : CU_RES_VIEW_FORMAT_FLOAT_1X32;
         else if (tex_channels == 2)
-            view_desc.format = CU_RES_VIEW_FORMAT_FLOAT_2X32;
+            view_desc.format = half ? CU_RES_VIEW_FORMAT_HALF_2X16
+                                    : CU_RES_VIEW_FORMAT_FLOAT_2X32;
         else
-            view_desc.format = CU_RES_VIEW_FORMAT_FLOAT_4X32;
+            view_desc.format = half ? CU_RES_VIEW_FORMAT_HALF_4X16
+                                    : CU_RES_VIEW_FORMAT_FLOAT_4X32;
 
         cuda_check(cuTexObjectCreate(&(texture->textures[tex]), &res_desc,
                                      &tex_desc, &view_desc));
@@ -230,7 +249,7 @@ jitc_cuda_tex_alloc_staging_area(size_t n_texels,
                                  const DrJitCudaTexture &texture) {
     // Each texture except for the last one will need exactly 4 channels
     size_t staging_area_size =
-        sizeof(float) * n_texels *
+        texture.elem_size * n_texels *
         ((texture.n_textures - 1) * 4 +
          texture.channels_internal(texture.n_textures - 1));
     void *staging_area = jitc_malloc(AllocType::Device, staging_area_size);
@@ -238,6 +257,15 @@ jitc_cuda_tex_alloc_staging_area(size_t n_texels,
     return std::unique_ptr<void, StagingAreaDeleter>(staging_area, jitc_free);
 }
 
+/// Number of texels (over all layers) and extents of the memory copies
+static size_t jitc_cuda_tex_extent(size_t ndim, const size_t *shape,
+                                   const DrJitCudaTexture &texture,
+                                   size_t &height, size_t &depth) {
+    height = (ndim >= 2) ? shape[1] : 1;
+    depth = (ndim == 3) ? shape[2] : texture.n_layers;
+    return shape[0] * height * std::max(depth, (size_t) 1);
+}
+
 /*
  * \brief Copy texture to a staging area that is pitched over the channels, such
  * that the data for each underlying CUDA texture is partitioned.
@@ -248,13 +276,14 @@ static void jitc_cuda_tex_memcpy_d2s(
     size_t n_texels, const void *src_ptr, const DrJitCudaTexture &dst_texture) {
     scoped_set_context guard(ts->context);
 
-    size_t texel_size = dst_texture.n_channels * sizeof(float);
+    size_t elem_size = dst_texture.elem_size,
+           texel_size = dst_texture.n_channels * elem_size;
 
     CUDA_MEMCPY2D op;
     memset(&op, 0, sizeof(CUDA_MEMCPY2D));
 
     for (size_t tex = 0; tex < dst_texture.n_textures; ++tex) {
-        size_t texel_offset = tex * 4 * sizeof(float);
+        size_t texel_offset = tex * 4 * elem_size;
 
         op.srcXInBytes = texel_offset;
         op.srcMemoryType = CU_MEMORYTYPE_DEVICE;
@@ -264,9 +293,9 @@ static void jitc_cuda_tex_memcpy_d2s(
         op.dstXInBytes = n_texels * texel_offset;
         op.dstMemoryType = CU_MEMORYTYPE_DEVICE;
         op.dstDevice = (CUdeviceptr) staging_area.get();
-        op.dstPitch = dst_texture.channels_internal(tex) * sizeof(float);
+        op.dstPitch = dst_texture.channels_internal(tex) * elem_size;
 
-        op.WidthInBytes = dst_texture.channels(tex) * sizeof(float);
+        op.WidthInBytes = dst_texture.channels(tex) * elem_size;
         op.Height = n_texels;
 
         cuda_check(cuMemcpy2DAsync(&op, ts->stream));
@@ -283,9 +312,20 @@ void jitc_cuda_tex_memcpy_d2t(size_t ndim, const size_t *shape,
 
     DrJitCudaTexture &dst_texture = *((DrJitCudaTexture *) dst_texture_handle);
 
-    size_t n_texels = shape[0];
-    for (size_t dim = 1; dim < ndim; ++dim)
-        n_texels *= shape[dim];
+    size_t height, depth,
+           n_texels = jitc_cuda_tex_extent(ndim, shape, dst_texture, height, depth),
+           elem_size = dst_texture.elem_size;
+
+    // Half precision textures: convert the single precision input first
+    Ref src_half;
+    if (elem_size == 2) {
+        Ref src = steal(jitc_var_mem_map(JitBackend::CUDA, VarType::Float32,
+                                         (void *) src_ptr,
+                                         n_texels * dst_texture.n_channels, 0));
+        src_half = steal(jitc_var_cast(src, VarType::Float16, 0));
+        jitc_var_eval(src_half);
+        src_ptr = jitc_var(src_half)->data;
+    }
 
     StagingAreaDeleter noop = [](void *) {};
     std::unique_ptr<void, StagingAreaDeleter> staging_area(nullptr, noop);
@@ -297,44 +337,45 @@ void jitc_cuda_tex_memcpy_d2t(size_t ndim, const size_t *shape,
                                  dst_texture);
     }
 
-    if (ndim == 1 || ndim == 2) {
+    if (depth == 0) {
         CUDA_MEMCPY2D op;
         memset(&op, 0, sizeof(CUDA_MEMCPY2D));
 
         for (size_t tex = 0; tex < dst_texture.n_textures; ++tex) {
             size_t pitch =
-                shape[0] * dst_texture.channels_internal(tex) * sizeof(float);
+                shape[0] * dst_texture.channels_internal(tex) * elem_size;
 
             op.srcMemoryType = CU_MEMORYTYPE_DEVICE;
             op.srcDevice = (CUdeviceptr) src_ptr;
             op.srcPitch = pitch;
             if (needs_staging_area) {
                 op.srcDevice = (CUdeviceptr) staging_area.get();
-                op.srcXInBytes = tex * n_texels * 4 * sizeof(float);
+                op.srcXInBytes = tex * n_texels * 4 * elem_size;
             }
 
             op.dstMemoryType = CU_MEMORYTYPE_ARRAY;
             op.dstArray = dst_texture.arrays[tex];
 
             op.WidthInBytes = pitch;
-            op.Height = (ndim == 2) ? shape[1] : 1;
+            op.Height = height;
 
             cuda_check(cuMemcpy2DAsync(&op, ts->stream));
         }
     } else {
+        // 3D textures, and all layers of a layered texture at once
         CUDA_MEMCPY3D op;
-        memset(&op, 0, sizeof(CUDA_MEMCPY2D));
+        memset(&op, 0, sizeof(CUDA_MEMCPY3D));
 
         for (size_t tex = 0; tex < dst_texture.n_textures; ++tex) {
             size_t pitch =
-                shape[0] * dst_texture.channels_internal(tex) * sizeof(float);
+                shape[0] * dst_texture.channels_internal(tex) * elem_size;
 
             op.srcMemoryType = CU_MEMORYTYPE_DEVICE;
             op.srcDevice = (CUdeviceptr) src_ptr;
             op.srcPitch = pitch;
-            op.srcHeight = shape[1];
+            op.srcHeight = height;
             if (needs_staging_area) {
-                op.srcXInBytes = tex * n_texels * 4 * sizeof(float);
+                op.srcXInBytes = tex * n_texels * 4 * elem_size;
                 op.srcDevice = (CUdeviceptr) staging_area.get();
             }
 
@@ -342,8 +383,8 @@ void jitc_cuda_tex_memcpy_d2t(size_t ndim, const size_t *shape,
             op.dstArray = dst_texture.arrays[tex];
 
             op.WidthInBytes = pitch;
-            op.Height = shape[1];
-            op.Depth = shape[2];
+            op.Height = height;
+            op.Depth = depth;
 
             cuda_check(cuMemcpy3DAsync(&op, ts->stream));
         }
@@ -360,25 +401,26 @@ static void jitc_cuda_tex_memcpy_s2d(
     size_t n_texels, const void *dst_ptr, const DrJitCudaTexture &src_texture) {
     scoped_set_context guard(ts->context);
 
-    size_t texel_size = src_texture.n_channels * sizeof(float);
+    size_t elem_size = src_texture.elem_size,
+           texel_size = src_texture.n_channels * elem_size;
 
     CUDA_MEMCPY2D op;
     memset(&op, 0, sizeof(CUDA_MEMCPY2D));
 
     for (size_t tex = 0; tex < src_texture.n_textures; ++tex) {
-        size_t texel_offset = tex * 4 * sizeof(float);
+        size_t texel_offset = tex * 4 * elem_size;
 
         op.srcXInBytes = n_texels * texel_offset;
         op.srcMemoryType = CU_MEMORYTYPE_DEVICE;
         op.srcDevice = (CUdeviceptr) staging_area.get();
-        op.srcPitch = src_texture.channels_internal(tex) * sizeof(float);
+        op.srcPitch = src_texture.channels_internal(tex) * elem_size;
 
         op.dstXInBytes = texel_offset;
         op.dstMemoryType = CU_MEMORYTYPE_DEVICE;
         op.dstDevice = (CUdeviceptr) dst_ptr;
         op.dstPitch = texel_size;
 
-        op.WidthInBytes = src_texture.channels(tex) * sizeof(float);
+        op.WidthInBytes = src_texture.channels(tex) * elem_size;
         op.Height = n_texels;
 
         cuda_check(cuMemcpy2DAsync(&op, ts->stream));
@@ -395,9 +437,15 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
 
     DrJitCudaTexture &src_texture = *((DrJitCudaTexture *) src_texture_handle);
 
-    size_t n_texels = shape[0];
-    for (size_t dim = 1; dim < ndim; ++dim)
-        n_texels *= shape[dim];
+    size_t height, depth,
+           n_texels = jitc_cuda_tex_extent(ndim, shape, src_texture, height, depth),
+           elem_size = src_texture.elem_size;
+
+    // Half precision textures: copy into a temporary, then convert
+    void *dst_final = dst_ptr;
+    if (elem_size == 2)
+        dst_ptr = jitc_malloc(AllocType::Device,
+                              n_texels * src_texture.n_channels * elem_size);
 
     auto noop = [](void *) {};
     std::unique_ptr<void, StagingAreaDeleter> staging_area(nullptr, noop);
@@ -407,13 +455,13 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
         staging_area = jitc_cuda_tex_alloc_staging_area(n_texels, src_texture);
     }
 
-    if (ndim == 1 || ndim == 2) {
+    if (depth == 0) {
         CUDA_MEMCPY2D op;
         memset(&op, 0, sizeof(CUDA_MEMCPY2D));
 
         for (size_t tex = 0; tex < src_texture.n_textures; ++tex) {
             size_t pitch =
-                shape[0] * src_texture.channels_internal(tex) * sizeof(float);
+                shape[0] * src_texture.channels_internal(tex) * elem_size;
 
             op.srcMemoryType = CU_MEMORYTYPE_ARRAY;
             op.srcArray = src_texture.arrays[tex];
@@ -422,12 +470,12 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
             op.dstDevice = (CUdeviceptr) dst_ptr;
             op.dstPitch = pitch;
             if (needs_staging_area) {
-                op.dstXInBytes = tex * n_texels * 4 * sizeof(float);
+                op.dstXInBytes = tex * n_texels * 4 * elem_size;
                 op.dstDevice = (CUdeviceptr) staging_area.get();
             }
 
             op.WidthInBytes = pitch;
-            op.Height = (ndim == 2) ? shape[1] : 1;
+            op.Height = height;
 
             cuda_check(cuMemcpy2DAsync(&op, ts->stream));
         }
@@ -437,7 +485,7 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
 
         for (size_t tex = 0; tex < src_texture.n_textures; ++tex) {
             size_t pitch =
-                shape[0] * src_texture.channels_internal(tex) * sizeof(float);
+                shape[0] * src_texture.channels_internal(tex) * elem_size;
 
             op.srcMemoryType = CU_MEMORYTYPE_ARRAY;
             op.srcArray = src_texture.arrays[tex];
@@ -445,15 +493,15 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
             op.dstMemoryType = CU_MEMORYTYPE_DEVICE;
             op.dstDevice = (CUdeviceptr) dst_ptr;
             op.dstPitch = pitch;
-            op.dstHeight = shape[1];
+            op.dstHeight = height;
             if (needs_staging_area) {
-                op.dstXInBytes = tex * n_texels * 4 * sizeof(float);
+                op.dstXInBytes = tex * n_texels * 4 * elem_size;
                 op.dstDevice = (CUdeviceptr) staging_area.get();
             }
 
             op.WidthInBytes = pitch;
-            op.Height = shape[1];
-            op.Depth = shape[2];
+            op.Height = height;
+            op.Depth = depth;
 
             cuda_check(cuMemcpy3DAsync(&op, ts->stream));
         }
@@ -462,30 +510,43 @@ void jitc_cuda_tex_memcpy_t2d(size_t ndim, const size_t *shape,
     if (needs_staging_area)
         jitc_cuda_tex_memcpy_s2d(ts, staging_area, n_texels, dst_ptr,
                                  src_texture);
+
+    if (elem_size == 2) {
+        size_t size = n_texels * src_texture.n_channels;
+        Ref dst_half = steal(jitc_var_mem_map(JitBackend::CUDA, VarType::Float16,
+                                              dst_ptr, size, 1)),
+            dst = steal(jitc_var_cast(dst_half, VarType::Float32, 0));
+        jitc_var_eval(dst);
+        jitc_memcpy_async(JitBackend::CUDA, dst_final, jitc_var(dst)->data,
+                          size * sizeof(float));
+    }
 }
 
-Variable jitc_cuda_tex_check(size_t ndim, const uint32_t *pos) {
+/// Validate the lookup position. Layered textures expect a trailing layer index
+Variable jitc_cuda_tex_check(size_t ndim, const uint32_t *pos, bool layered) {
     // Validate input types, determine size of the operation
-    uint32_t size = 0;
+    size_t size = 0;
     bool dirty = false, placeholder = false;
     JitBackend backend = JitBackend::Invalid;
 
     if (ndim < 1 || ndim > 3)
         jitc_raise("jit_cuda_tex_check(): invalid texture dimension!");
 
-    for (size_t i = 0; i < ndim; ++i) {
+    size_t n_args = ndim + (layered ? 1 : 0);
+    for (size_t i = 0; i < n_args; ++i) {
         const Variable *v = jitc_var(pos[i]);
-        if ((VarType) v->type != VarType::Float32)
+        VarType expected = i < ndim ? VarType::Float32 : VarType::UInt32;
+        if ((VarType) v->type != expected)
             jitc_raise("jit_cuda_tex_check(): type mismatch for arg. %zu (got "
                        "%s, expected %s)", i, type_name[v->type],
-                       type_name[(int) VarType::Float32]);
+                       type_name[(int) expected]);
         size = std::max(size, v->size);
         dirty |= v->is_dirty();
         placeholder |= (bool) v->placeholder;
         backend = (JitBackend) v->backend;
     }
 
-    for (uint32_t i = 0; i < ndim; ++i) {
+    for (size_t i = 0; i < n_args; ++i) {
         const Variable *v = jitc_var(pos[i]);
         if (v->size != 1 && v->size != size)
             jitc_raise("jit_cuda_tex_check(): arithmetic involving arrays of "
@@ -494,7 +555,7 @@ Variable jitc_cuda_tex_check(size_t ndim, const uint32_t *pos) {
 
     if (dirty) {
         jitc_eval(thread_state(backend));
-        for (size_t i = 0; i < ndim; ++i) {
+        for (size_t i = 0; i < n_args; ++i) {
             if (jitc_var(pos[i])->is_dirty())
                 jitc_fail("jit_cuda_tex_check(): operand r%u remains dirty "
                           "following evaluation!", pos[i]);
@@ -512,16 +573,18 @@ Variable jitc_cuda_tex_check(size_t ndim, const uint32_t *pos) {
 void jitc_cuda_tex_lookup(size_t ndim, const void *texture_handle,
                           const uint32_t *pos, uint32_t *out) {
     DrJitCudaTexture &tex = *((DrJitCudaTexture *) texture_handle);
-    Variable v = jitc_cuda_tex_check(ndim, pos);
+    bool layered = tex.n_layers > 0;
+    Variable v = jitc_cuda_tex_check(ndim, pos, layered);
+    size_t n_args = ndim + (layered ? 1 : 0);
 
     for (size_t ti = 0; ti < tex.n_textures; ++ti) {
         // Perform a fetch per texture ..
         v.kind = VarKind::TexLookup;
-        v.literal = 0;
+        v.literal = layered ? 1 : 0;
         memset(v.dep, 0, sizeof(v.dep));
         v.dep[0] = tex.indices[ti];
         jitc_var_inc_ref(tex.indices[ti]);
-        for (size_t j = 0; j < ndim; ++j) {
+        for (size_t j = 0; j < n_args; ++j) {
             v.dep[j + 1] = pos[j];
             jitc_var_inc_ref(pos[j]);
         }
@@ -545,7 +608,9 @@ void jitc_cuda_tex_bilerp_fetch(size_t ndim, const void *texture_handle,
         jitc_raise("jitc_cuda_tex_bilerp_fetch(): only 2D textures are supported!");
 
     DrJitCudaTexture &tex = *((DrJitCudaTexture *) texture_handle);
-    Variable v = jitc_cuda_tex_check(ndim, pos);
+    if (tex.n_layers > 0)
+        jitc_raise("jitc_cuda_tex_bilerp_fetch(): layered textures are not supported!");
+    Variable v = jitc_cuda_tex_check(ndim, pos, false);
 
     for (size_t ti = 0; ti < tex.n_textures; ++ti) {
         for (size_t ch = 0; ch < tex.channels(ti); ++ch) {
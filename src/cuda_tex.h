@@ -2,7 +2,7 @@
 
 extern void *jitc_cuda_tex_create(size_t ndim, const size_t *shape,
                                   size_t n_channels, int filter_mode,
-                                  int wrap_mode);
+                                  int wrap_mode, int format, size_t n_layers);
 extern void jitc_cuda_tex_get_shape(size_t ndim, const void *texture_handle,
                                     size_t *shape);
 extern void jitc_cuda_tex_memcpy_d2t(size_t ndim, const size_t *shape,
@@ -0,0 +1,142 @@
+/*
+    src/cuda_tune.cpp -- Autotuning of CUDA launch configurations
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "cuda.h"
+#include "internal.h"
+#include "log.h"
+#include "io.h"
+
+/// A launch configuration relative to the occupancy-based default
+struct CudaTuneCandidate {
+    /// Right shift applied to the preferred block size of the kernel
+    uint32_t thread_shift;
+
+    /// Maximum number of blocks per SM
+    uint32_t blocks_per_sm;
+};
+
+/* The first entry matches the configuration used by untuned kernels. Smaller
+   blocks and larger grids tend to help register-heavy kernels (loops, virtual
+   function calls), whose occupancy is low either way. */
+static const CudaTuneCandidate jitc_cuda_tune_candidates[] = {
+    { 0, 4 }, { 0, 16 }, { 1, 8 }, { 1, 32 }, { 2, 16 }, { 2, 64 }
+};
+
+static const uint32_t jitc_cuda_tune_count =
+    sizeof(jitc_cuda_tune_candidates) / sizeof(CudaTuneCandidate);
+
+/// Timing state of a kernel that is currently being tuned
+struct CudaTuneState {
+    /// Events enclosing the trial that is in flight
+    CUevent start = nullptr, end = nullptr;
+
+    /// Candidate timed by the trial in flight (or jitc_cuda_tune_count)
+    uint32_t pending = jitc_cuda_tune_count;
+
+    /// Size of the trial in flight
+    uint32_t pending_size = 0;
+
+    /// Next candidate that should be timed
+    uint32_t next = 0;
+
+    /// Measured time per element of each candidate
+    float cost[jitc_cuda_tune_count] { };
+};
+
+/// Kernels being tuned, indexed by their CUfunction
+static tsl::robin_map<uint64_t, CudaTuneState, UInt64Hasher> jitc_cuda_tune_state;
+
+static uint64_t jitc_cuda_tune_key(const Kernel &kernel) {
+    return (uint64_t) (uintptr_t) kernel.cuda.func;
+}
+
+static void jitc_cuda_tune_apply(Kernel &kernel, uint32_t candidate) {
+    const CudaTuneCandidate &c = jitc_cuda_tune_candidates[candidate];
+    uint32_t threads = (kernel.cuda.block_size >> c.thread_shift) & ~31u;
+    kernel.cuda.tuned_threads = (uint16_t) std::max(threads, 32u);
+    kernel.cuda.tuned_blocks_per_sm = (uint16_t) c.blocks_per_sm;
+}
+
+bool jitc_cuda_tune_begin(const Device &device, Kernel &entry, Kernel &launch,
+                          XXH128_hash_t hash, uint32_t size, CUstream stream) {
+    CudaTuneState &s = jitc_cuda_tune_state[jitc_cuda_tune_key(entry)];
+
+    if (s.pending != jitc_cuda_tune_count) {
+        // Don't wait for the previous trial, launch normally instead
+        CUresult rv = cuEventQuery(s.end);
+        if (rv == CUDA_ERROR_NOT_READY)
+            return false;
+        cuda_check(rv);
+
+        float ms = 0.f;
+        cuda_check(cuEventElapsedTime(&ms, s.start, s.end));
+        s.cost[s.pending] = ms / (float) s.pending_size;
+        s.pending = jitc_cuda_tune_count;
+    }
+
+    if (s.next == jitc_cuda_tune_count) {
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < jitc_cuda_tune_count; ++i) {
+            if (s.cost[i] < s.cost[best])
+                best = i;
+        }
+
+        jitc_cuda_tune_apply(entry, best);
+        launch.cuda.tuned_threads = entry.cuda.tuned_threads;
+        launch.cuda.tuned_blocks_per_sm = entry.cuda.tuned_blocks_per_sm;
+        jitc_kernel_cache_tune(JitBackend::CUDA, hash, entry);
+
+        jitc_log(Debug,
+                 "jit_cuda_tune(): kernel %016llx uses %u threads and up to %u "
+                 "blocks per SM (%.2fx faster than the default).",
+                 (unsigned long long) hash.high64,
+                 (uint32_t) entry.cuda.tuned_threads,
+                 (uint32_t) entry.cuda.tuned_blocks_per_sm,
+                 s.cost[best] > 0.f ? s.cost[0] / s.cost[best] : 1.f);
+
+        jitc_cuda_tune_free(entry);
+        return false;
+    }
+
+    // Launches that don't fill the device are not representative
+    if (size < device.num_sm * entry.cuda.block_size)
+        return false;
+
+    if (!s.start) {
+        cuda_check(cuEventCreate(&s.start, CU_EVENT_DEFAULT));
+        cuda_check(cuEventCreate(&s.end, CU_EVENT_DEFAULT));
+    }
+
+    jitc_cuda_tune_apply(launch, s.next);
+    s.pending = s.next++;
+    s.pending_size = size;
+    cuda_check(cuEventRecord(s.start, stream));
+
+    return true;
+}
+
+void jitc_cuda_tune_end(const Kernel &entry, CUstream stream) {
+    auto it = jitc_cuda_tune_state.find(jitc_cuda_tune_key(entry));
+    if (it != jitc_cuda_tune_state.end())
+        cuda_check(cuEventRecord(it.value().end, stream));
+}
+
+void jitc_cuda_tune_free(const Kernel &kernel) {
+    auto it = jitc_cuda_tune_state.find(jitc_cuda_tune_key(kernel));
+    if (it == jitc_cuda_tune_state.end())
+        return;
+
+    const CudaTuneState &s = it.value();
+    if (s.start) {
+        cuda_check(cuEventDestroy(s.start));
+        cuda_check(cuEventDestroy(s.end));
+    }
+
+    jitc_cuda_tune_state.erase(it);
+}
@@ -13,9 +13,15 @@
 #include "eval.h"
 #include "profiler.h"
 #include "util.h"
+#include "stats.h"
 #include "optix.h"
 #include "loop.h"
-#include <tsl/robin_set.h>
+#include "freeze.h"
+#include "numa.h"
+#include "vcall.h"
+#include "optimize.h"
+#include "traverse.h"
+#include "registry.h"
 
 // ====================================================================
 //  The following data structures are temporarily used during program
@@ -29,8 +35,12 @@ std::vector<ScheduledVariable> schedule;
 /// Groups of variables with the same size
 std::vector<ScheduledGroup> schedule_groups;
 
-/// Auxiliary data structure needed to compute 'schedule_sizes' and 'schedule'
-static tsl::robin_set<std::pair<uint32_t, uint32_t>, pair_hash> visited;
+/// Auxiliary data structures needed to compute 'schedule_sizes' and 'schedule'
+static VisitedSet visited, visited_any;
+static std::vector<DFSFrame> traverse_stack;
+
+/// Roots (size, index) of the traversal performed by jitc_eval()
+static std::vector<std::pair<size_t, uint32_t>> traverse_roots;
 
 /// Kernel parameter buffer and device copy
 static std::vector<void *> kernel_params;
@@ -41,11 +51,35 @@ static uint32_t kernel_param_count = 0;
 GlobalsMap globals_map;
 
 /// StringBuffer for global definitions (intrinsics, callables, etc.)
-StringBuffer globals { 1000 };
+thread_local StringBuffer globals { 1000 };
 
 /// Temporary scratch space for scheduled tasks (LLVM only)
 static std::vector<Task *> scheduled_tasks;
 
+/// Memory region accessed by a kernel of the current jitc_eval() call
+struct KernelAccess {
+    const void *ptr;
+    bool write;
+};
+
+/// Memory regions accessed by the assembled kernels, ordered by group
+static std::vector<KernelAccess> kernel_access;
+
+/// Start offset into 'kernel_access' for each assembled group
+static std::vector<uint32_t> kernel_access_offset;
+
+/// Does 'kernel_access' contain any write access (i.e., a scatter)?
+static bool kernel_access_write = false;
+
+/// Tasks that the next kernel launch depends on (LLVM only)
+static std::vector<Task *> kernel_deps;
+
+/// Stream used by the next kernel launch (CUDA only, 'nullptr' = ts->stream)
+static CUstream kernel_stream = nullptr;
+
+/// Stream used by each kernel of the current jitc_eval() (JitFlag::ParallelStreams)
+static std::vector<CUstream> kernel_streams;
+
 /// Hash code of the last generated kernel
 XXH128_hash_t kernel_hash { 0, 0 };
 
@@ -58,6 +92,12 @@ static uint32_t n_ops_total = 0;
 /// Are we recording an OptiX kernel?
 bool uses_optix = false;
 
+/// Work counter of a CUDA kernel with persistent threads (JitFlag::LoopPersistent)
+void *kernel_work_counter = nullptr;
+
+/// Order in which a CUDA kernel processes its entries (JitFlag::VCallCoherent)
+const void *kernel_perm = nullptr;
+
 /// Size and alignment of auxiliary buffer needed by virtual function calls
 int32_t alloca_size = -1;
 int32_t alloca_align = -1;
@@ -71,43 +111,393 @@ uint32_t callable_count_unique = 0;
 /// Specifies the nesting level of virtual calls being compiled
 uint32_t callable_depth = 0;
 
+/// Scatter-reduction targets that are privatized in the kernel being compiled
+std::vector<PrivateTarget> private_targets;
+
 /// Information about the kernel launch to go in the kernel launch history
 KernelHistoryEntry kernel_history_entry;
 
+/// Total size of the input and output arrays of the kernel (JitFlag::KernelStats)
+uint64_t kernel_bytes_in = 0, kernel_bytes_out = 0;
+
+/// Snapshot of a kernel that was assembled ahead of its launch
+struct AssembledKernel {
+    ScheduledGroup group;
+
+    /// Copy of the generated source code (malloc-allocated)
+    char *source;
+    size_t source_size;
+
+    /// Saved copies of the global variables written by jitc_assemble()
+    XXH128_hash_t hash;
+    char name[sizeof(kernel_name)];
+    std::vector<void *> params;
+    uint8_t *params_global;
+    uint32_t param_count;
+    uint32_t callable_count_unique;
+    bool uses_optix;
+    void *work_counter;
+    KernelHistoryEntry history;
+    uint64_t bytes_in, bytes_out;
+
+    /// LLVM backend: functions to be resolved, see jitc_llvm_compile_symbols()
+    std::vector<std::string> symbols;
+
+    /// Precompiled kernel, valid when 'status' != Status::Pending
+    Kernel kernel;
+    enum class Status { Pending, Loaded, Compiled } status;
+
+    AssembledKernel(ScheduledGroup group) : group(group) { }
+};
+
+/// Kernels assembled by jitc_eval() when JitFlag::ParallelCompile is active
+static std::vector<AssembledKernel> assembled_kernels;
+
 // ====================================================================
 
-/// Recursively traverse the computation graph to find variables needed by a computation
-static void jitc_var_traverse(uint32_t size, uint32_t index) {
-    if (!visited.emplace(size, index).second)
+/**
+ * \brief Traverse the computation graph to find variables needed by a computation
+ *
+ * 'visited' records the variables scheduled with size 'size', and the caller
+ * must clear it when switching to a different size. 'visited_any' records
+ * variables scheduled with any size.
+ */
+static void jitc_var_traverse(size_t size, uint32_t index) {
+    jitc_var_dfs(
+        index, visited, traverse_stack, [](uint32_t) { return true; },
+        [size](uint32_t index, const Variable *v) {
+            // If we're really visiting this variable the first time, no matter its size
+            if (visited_any.insert(index))
+                jitc_var_scratch(v)->output_flag = false;
+
+            schedule.emplace_back(size, v->scope, index, v->counter);
+        });
+}
+
+/// Order variables into groups of matching size, and by scope within groups
+static void jitc_schedule_partition() {
+    std::stable_sort(
+        schedule.begin(), schedule.end(),
+        [](const ScheduledVariable &a, const ScheduledVariable &b) {
+            if (a.size > b.size)
+                return true;
+            else if (a.size < b.size)
+                return false;
+            else if (a.scope > b.scope)
+                return false;
+            else if (a.scope < b.scope)
+                return true;
+            else
+                return false;
+        });
+
+    // Partition into groups of matching size
+    schedule_groups.clear();
+    if (schedule[0].size == schedule[schedule.size() - 1].size) {
+        schedule_groups.emplace_back(schedule[0].size, 0,
+                                     (uint32_t) schedule.size());
+    } else {
+        uint32_t cur = 0;
+        for (uint32_t i = 1; i < (uint32_t) schedule.size(); ++i) {
+            if (schedule[i - 1].size != schedule[i].size) {
+                schedule_groups.emplace_back(schedule[cur].size, cur, i);
+                cur = i;
+            }
+        }
+
+        schedule_groups.emplace_back(schedule[cur].size,
+                                     cur, (uint32_t) schedule.size());
+    }
+}
+
+/**
+ * \brief Move the scalar (size 1) computation into one of the other kernels
+ *
+ * Values computed by the scalar kernel are uniform, hence every thread of a
+ * larger kernel can recompute them, and the first one writes the scalar
+ * outputs. This saves a kernel launch. The cost estimate is the number of
+ * scalar operations that the larger kernel does not already perform, times
+ * its size. The kernel with the lowest cost is chosen if the cost is below
+ * \ref DRJIT_FUSION_WORK_LIMIT.
+ */
+static void jitc_schedule_fuse_scalars() {
+    if (schedule_groups.size() < 2 || schedule_groups.back().size != 1)
+        return;
+
+    const ScheduledGroup scalar = schedule_groups.back();
+
+    for (uint32_t i = scalar.start; i != scalar.end; ++i) {
+        uint32_t index = schedule[i].index;
+        const Variable *v = jitc_var(index);
+
+        // Side effects, control flow, and ops whose value depends on the lane
+        if (jitc_optimize_opaque(index, v) ||
+            (VarKind) v->kind == VarKind::Counter ||
+            (VarKind) v->kind == VarKind::DefaultMask)
+            return;
+    }
+
+    auto collect = [](const ScheduledGroup &group) {
+        visited.clear();
+        for (uint32_t i = group.start; i != group.end; ++i)
+            visited.insert(schedule[i].index);
+    };
+
+    uint64_t best_cost = (uint64_t) -1;
+    uint32_t best = 0;
+
+    for (uint32_t i = 0; i + 1 < (uint32_t) schedule_groups.size(); ++i) {
+        const ScheduledGroup &group = schedule_groups[i];
+        collect(group);
+
+        uint64_t n_ops = 0;
+        for (uint32_t j = scalar.start; j != scalar.end; ++j) {
+            uint32_t index = schedule[j].index;
+            const Variable *v = jitc_var(index);
+            if (!visited.contains(index) && !v->is_literal() && !v->is_data())
+                n_ops++;
+        }
+
+        uint64_t cost = n_ops * group.size;
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+
+    if (best_cost > DRJIT_FUSION_WORK_LIMIT)
         return;
 
-    Variable *v = jitc_var(index);
-    for (int i = 0; i < 4; ++i) {
-        uint32_t index2 = v->dep[i];
-        if (index2 == 0)
-            break;
-        jitc_var_traverse(size, index2);
+    size_t size = schedule_groups[best].size;
+    collect(schedule_groups[best]);
+
+    /* Variables that the target kernel already computes are dropped, and
+       the remaining ones join it. The subsequent sort places them after
+       the variables of the same scope, which respects all dependencies. */
+    uint32_t n_moved = 0, n_dropped = 0, out = scalar.start;
+    for (uint32_t i = scalar.start; i != scalar.end; ++i) {
+        ScheduledVariable sv = schedule[i];
+        if (visited.contains(sv.index)) {
+            n_dropped++;
+            continue;
+        }
+        sv.size = size;
+        schedule[out++] = sv;
+        n_moved++;
     }
+    schedule.erase(schedule.begin() + out, schedule.end());
+
+    jitc_schedule_partition();
+    for (ScheduledGroup &group : schedule_groups) {
+        if (group.size == size)
+            group.scalar_outputs = true;
+    }
+
+    jitc_log(Debug,
+             "jit_eval(): fused the scalar kernel into the kernel of size %zu "
+             "(%u variables moved, %u already computed there).",
+             size, n_moved, n_dropped);
+}
+
+/// Variables of the kernel being assembled, and inputs that may donate memory
+static VisitedSet reuse_group, reuse_visited;
+
+/// Can the evaluated variable 'v' donate its memory to an output?
+static bool jitc_assemble_is_donor(const Variable *v, size_t size) {
+    return v->is_data() && v->ref_count == 1 && !v->retain_data &&
+           !v->unaligned && !v->extra && v->size == size;
+}
+
+/**
+ * \brief Find an input whose memory the output variable 'index' can reuse
+ *
+ * This is possible when the output depends on an evaluated variable of the
+ * same type and size that is not referenced outside of the kernel. Each
+ * thread loads its entry of that input into a register before computing
+ * (and storing) the entry of the output at the same position, hence the
+ * kernel may overwrite the input in place. Outputs that depend on custom
+ * code generation (loops, calls) are skipped, since such code may access
+ * inputs differently. The donor relinquishes ownership via 'retain_data' and
+ * expires once the kernel has been launched (see \ref JitFlag::BufferReuse).
+ */
+static void *jitc_assemble_donor(const ThreadState *ts, uint32_t index,
+                                 const Variable *v, size_t dsize) {
+    if (!v->is_node() || v->extra || v->side_effect)
+        return nullptr;
+
+    uint32_t donor = 0;
+    bool unsafe = false;
+
+    reuse_visited.clear();
+    jitc_var_dfs(
+        index, reuse_visited, traverse_stack,
+        [](uint32_t index_2) { return reuse_group.contains(index_2); },
+        [&](uint32_t index_2, const Variable *v2) {
+            unsafe |= v2->extra || v2->side_effect;
+            if (!donor && v2->type == v->type &&
+                jitc_assemble_is_donor(v2, v->size))
+                donor = index_2;
+        });
+
+    if (!donor || unsafe)
+        return nullptr;
+
+    Variable *d = jitc_var(donor);
+
+    // Only reuse memory that is compatible with a freshly allocated output
+    auto it = state.alloc_used.find((uintptr_t) d->data);
+    if (it == state.alloc_used.end() || it->second.requested < dsize)
+        return nullptr;
+
+    auto [size, atype, device] = alloc_info_decode(it->second.info);
+    (void) size;
+    if (atype != jitc_malloc_var_type(ts->backend) ||
+        (ts->backend == JitBackend::CUDA && device != ts->device))
+        return nullptr;
+
+    d->retain_data = true;
+    jitc_trace("jit_assemble(): r%u reuses the memory of r%u.", index, donor);
+    return d->data;
+}
+
+/// Should a CUDA kernel use persistent threads? (see JitFlag::LoopPersistent)
+static bool jitc_assemble_persistent(ThreadState *ts, ScheduledGroup group) {
+    // Frozen functions replay the launch without resetting the counter
+    if (!jit_flag(JitFlag::LoopPersistent) || uses_optix || ts->freeze)
+        return false;
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        if (jitc_var(schedule[gi].index)->kind == (uint32_t) VarKind::LoopPhi)
+            return true;
+    }
+
+    return false;
+}
+
+/// Return the permutation of a coherent vcall in the group, if any
+static const void *jitc_assemble_perm(ScheduledGroup group) {
+    if (uses_optix)
+        return nullptr;
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        uint32_t index = schedule[gi].index;
+        const Variable *v = jitc_var(index);
+        if (v->kind != (uint32_t) VarKind::Dispatch || !v->extra)
+            continue;
 
-    if (unlikely(v->extra)) {
         auto it = state.extra.find(index);
-        if (it == state.extra.end())
-            jitc_fail("jit_var_traverse(): could not find matching 'extra' record!");
+        const VCall *vcall = it != state.extra.end()
+                                 ? (const VCall *) it->second.callback_data
+                                 : nullptr;
+        if (!vcall || !vcall->perm)
+            continue;
 
-        const Extra &extra = it->second;
-        for (uint32_t i = 0; i < extra.n_dep; ++i) {
-            uint32_t index2 = extra.dep[i];
-            if (index2 == 0)
-                continue;
-            jitc_var_traverse(size, index2);
+        const Variable *v_perm = jitc_var(vcall->perm);
+        if (v_perm->size == group.size)
+            return v_perm->data;
+    }
+
+    return nullptr;
+}
+
+/// Literals of previously assembled kernels with the same structure
+struct LiteralSite {
+    /// Values of the literals, in the order of the schedule
+    std::vector<uint64_t> values;
+
+    /// Which of them changed at some point (and are passed as parameters)
+    std::vector<bool> hot;
+};
+
+/// Literal sites indexed by a hash of the kernel structure (JitFlag::LiteralParams)
+static tsl::robin_map<uint64_t, LiteralSite, UInt64Hasher> literal_sites;
+
+/// Temporary scratch space used by jitc_assemble_literals()
+static std::vector<uint64_t> literal_key;
+static std::vector<uint64_t> literal_values;
+
+/// Can the literal 'v' be loaded from a kernel parameter instead?
+static bool jitc_assemble_literal_ok(const Variable *v) {
+    VarType vt = (VarType) v->type;
+    return v->is_literal() && vt != VarType::Void && vt != VarType::Pointer;
+}
+
+/**
+ * \brief Mark the literals of 'group' that should be passed through kernel
+ * parameters (see \ref JitFlag::LiteralParams)
+ *
+ * Kernels are identified by a hash of their structure that leaves out the
+ * value of literals. A literal is passed as a parameter once its value
+ * differs from the one seen in the previous kernel with the same structure.
+ * The hash is only a heuristic: it may confuse two different kernels, which
+ * causes unnecessary parameters but never incorrect code.
+ */
+static void jitc_assemble_literals(ScheduledGroup group, uint32_t n_regs) {
+    literal_key.clear();
+    literal_values.clear();
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        const Variable *v = jitc_var(schedule[gi].index);
+        VariableScratch *vs = jitc_var_scratch(v);
+
+        // Provisional register index (the same as assigned by jitc_assemble())
+        vs->reg_index = n_regs + (gi - group.start);
+        vs->literal_param = false;
+
+        uint32_t dep[4];
+        for (int i = 0; i < 4; ++i)
+            dep[i] = v->dep[i] ? jitc_var_scratch(jitc_var(v->dep[i]))->reg_index : 0;
+
+        literal_key.push_back((uint64_t) v->kind | ((uint64_t) v->type << 8) |
+                              ((uint64_t) (v->size == 1) << 16) |
+                              ((uint64_t) vs->output_flag << 17));
+        literal_key.push_back((uint64_t) dep[0] | ((uint64_t) dep[1] << 32));
+        literal_key.push_back((uint64_t) dep[2] | ((uint64_t) dep[3] << 32));
+
+        if (jitc_assemble_literal_ok(v))
+            literal_values.push_back(v->literal);
+        else if (!v->is_literal())
+            literal_key.push_back(v->literal);
+    }
+
+    if (literal_values.empty())
+        return;
+
+    uint64_t key = (uint64_t) XXH3_64bits(literal_key.data(),
+                                          literal_key.size() * sizeof(uint64_t));
+    LiteralSite &site = literal_sites[key];
+    size_t n = literal_values.size();
+
+    if (site.values.size() != n) {
+        site.values = literal_values;
+        site.hot.assign(n, false);
+        return;
+    }
+
+    uint32_t n_hot = 0, n_new = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!site.hot[i] && site.values[i] != literal_values[i]) {
+            site.hot[i] = true;
+            n_new++;
         }
+        site.values[i] = literal_values[i];
+        n_hot += site.hot[i];
     }
 
-    // If we're really visiting this variable the first time, no matter its size
-    if (visited.emplace(0, index).second)
-        v->output_flag = false;
+    if (!n_hot)
+        return;
+
+    if (n_new)
+        jitc_log(Debug, "jit_assemble(): %u literal%s changed, passing %u "
+                 "literal%s of this kernel as parameters.", n_new,
+                 n_new == 1 ? "" : "s", n_hot, n_hot == 1 ? "" : "s");
 
-    schedule.emplace_back(size, v->scope, index);
+    size_t i = 0;
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        const Variable *v = jitc_var(schedule[gi].index);
+        if (jitc_assemble_literal_ok(v))
+            jitc_var_scratch(v)->literal_param = site.hot[i++];
+    }
 }
 
 void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
@@ -120,6 +510,9 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
     callable_count = 0;
     callable_count_unique = 0;
     kernel_history_entry = { };
+    kernel_bytes_in = kernel_bytes_out = 0;
+    kernel_work_counter = nullptr;
+    kernel_perm = nullptr;
 
 #if defined(DRJIT_ENABLE_OPTIX)
     uses_optix = ts->backend == JitBackend::CUDA &&
@@ -132,21 +525,63 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
              n_regs         = 0;
 
     if (backend == JitBackend::CUDA) {
-        uintptr_t size = 0;
-        memcpy(&size, &group.size, sizeof(uint32_t));
-        kernel_params.push_back((void *) size);
+        kernel_params.push_back((void *) (uintptr_t) (uint32_t) group.size);
+
+        // The second parameter (if present) points to the work counter
+        if (jitc_assemble_persistent(ts, group)) {
+            kernel_work_counter =
+                jitc_temp_malloc(ts, AllocType::Device, sizeof(uint32_t));
+            kernel_params.push_back(kernel_work_counter);
+        }
 
-        // The first 3 variables are reserved on the CUDA backend
-        n_regs = 4;
+        // The next one (if present) specifies the order of the entries
+        kernel_perm = jitc_assemble_perm(group);
+        if (kernel_perm)
+            kernel_params.push_back((void *) kernel_perm);
+
+        // The first 3 variables are reserved on the CUDA backend (one more
+        // holds the unpermuted index when the kernel uses a permutation)
+        n_regs = kernel_perm ? 5 : 4;
     } else {
-        // First 3 parameters reserved for: kernel ptr, size, ITT identifier
-        for (int i = 0; i < 3; ++i)
+        // First 4 parameters reserved for: kernel ptr, size, ITT identifier,
+        // and block size
+        for (int i = 0; i < 4; ++i)
             kernel_params.push_back(nullptr);
         n_regs = 1;
     }
 
     (void) timer();
 
+    if (jit_flag(JitFlag::LoopOptimize))
+        jitc_var_loop_hoist(group);
+
+    kernel_access_offset.push_back((uint32_t) kernel_access.size());
+
+    /* A frozen function would replay the kernel with a separate output slot.
+       The LLVM backend marks loads and stores as non-aliasing, which is only
+       safe because the stored value depends on the loaded one. Algebraic
+       simplification by jitc_optimize_group() could remove this dependence. */
+    bool buffer_reuse = jit_flag(JitFlag::BufferReuse) &&
+                        !jit_flag(JitFlag::KernelOptimize) && !ts->freeze &&
+                        group.size > 1;
+    uint32_t n_reused = 0;
+
+    if (buffer_reuse) {
+        bool has_donor = false;
+        reuse_group.clear();
+        for (uint32_t gi = group.start; gi != group.end; ++gi) {
+            uint32_t index = schedule[gi].index;
+            reuse_group.insert(index);
+            has_donor |= jitc_assemble_is_donor(jitc_var(index), group.size);
+        }
+        buffer_reuse = has_donor;
+    }
+
+    // Frozen functions replay kernels with the parameters of the recording
+    bool literal_params = jit_flag(JitFlag::LiteralParams) && !ts->freeze;
+    if (literal_params)
+        jitc_assemble_literals(group, n_regs);
+
     for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
         ScheduledVariable &sv = schedule[group_index];
         uint32_t index = sv.index;
@@ -159,42 +594,65 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
             jitc_fail("jit_assemble(): schedule contains unreferenced variable r%u!", index);
         if (unlikely(v->size != 1 && v->size != group.size))
             jitc_fail("jit_assemble(): schedule contains variable r%u with incompatible size "
-                     "(%u and %u)!", index, v->size, group.size);
+                     "(%zu and %zu)!", index, v->size, group.size);
         if (unlikely(v->is_dirty()))
             jitc_fail("jit_assemble(): dirty variable r%u encountered!", index);
 
-        v->param_offset = (uint32_t) kernel_params.size() * sizeof(void *);
-        v->reg_index = n_regs++;
+        VariableScratch *vs = jitc_var_scratch(v);
+        vs->param_offset = (uint32_t) kernel_params.size() * sizeof(void *);
+        vs->reg_index = n_regs++;
+        vs->elide = false;
 
         if (v->is_data()) {
             n_params_in++;
-            v->param_type = ParamType::Input;
+            vs->param_type = ParamType::Input;
             kernel_params.push_back(v->data);
-        } else if (v->output_flag && v->size == group.size) {
+            kernel_access.push_back({ v->data, false });
+            kernel_bytes_in += (uint64_t) v->size * type_size[v->type];
+        } else if (vs->output_flag &&
+                   (v->size == group.size ||
+                    (v->size == 1 && group.scalar_outputs))) {
             n_params_out++;
-            v->param_type = ParamType::Output;
+            vs->param_type = ParamType::Output;
 
             size_t isize = (size_t) type_size[v->type],
-                   dsize = (size_t) group.size * isize;
+                   dsize = (size_t) v->size * isize;
 
             // Padding to support out-of-bounds accesses in LLVM gather operations
             if (backend == JitBackend::LLVM && isize < 4)
                 dsize += 4 - isize;
+            kernel_bytes_out += dsize;
+
+            void *donor = nullptr;
+            if (buffer_reuse && v->size == group.size)
+                donor = jitc_assemble_donor(ts, index, v, dsize);
 
-            sv.data = jitc_malloc(
-                backend == JitBackend::CUDA ? AllocType::Device
-                                            : AllocType::HostAsync,
-                dsize); // Note: unsafe to access 'v' after jitc_malloc().
+            if (donor) {
+                sv.data = donor;
+                n_reused++;
+            } else {
+                sv.data = jitc_malloc(
+                    jitc_malloc_var_type(backend),
+                    dsize); // Note: unsafe to access 'v' after jitc_malloc().
+            }
 
             kernel_params.push_back(sv.data);
+        } else if (literal_params && vs->literal_param) {
+            // The value is stored in the parameter slot itself
+            n_params_in++;
+            vs->param_type = ParamType::Input;
+            kernel_params.push_back((void *) (uintptr_t) v->literal);
         } else if (v->is_literal() && (VarType) v->type == VarType::Pointer) {
             n_params_in++;
-            v->param_type = ParamType::Input;
+            vs->param_type = ParamType::Input;
             kernel_params.push_back((void *) v->literal);
+            kernel_access.push_back({ (const void *) v->literal,
+                                      (bool) v->write_ptr });
+            kernel_access_write |= (bool) v->write_ptr;
         } else {
             n_side_effects += (uint32_t) v->side_effect;
-            v->param_type = ParamType::Register;
-            v->param_offset = 0xFFFF;
+            vs->param_type = ParamType::Register;
+            vs->param_offset = 0xFFFF;
 
             #if defined(DRJIT_ENABLE_OPTIX)
                 uses_optix |= v->optix;
@@ -216,18 +674,44 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
                  "periodically running jit_eval() to break the computation "
                  "into smaller chunks.", kernel_params.size());
 
+    if (unlikely(state.eval_memory_warning &&
+                 kernel_bytes_out > state.eval_memory_warning))
+        jitc_log(Warn, "jit_assemble(): the outputs of this kernel (%s) exceed "
+                 "the threshold set via jit_set_eval_memory_warning().",
+                 jitc_mem_string((size_t) kernel_bytes_out));
+
+    if (n_reused)
+        jitc_log(Debug, "jit_assemble(): %u output%s reuse%s the memory of an "
+                 "input.", n_reused, n_reused == 1 ? "" : "s",
+                 n_reused == 1 ? "s" : "");
+
     kernel_param_count = (uint32_t) kernel_params.size();
     n_ops_total = n_regs;
 
+    if (jit_flag(JitFlag::KernelOptimize))
+        n_ops_total -= jitc_optimize_group(group);
+
+    /* Migrate the pages of managed inputs and outputs to the device ahead of
+       the launch instead of faulting them in one by one */
+    if (backend == JitBackend::CUDA &&
+        unlikely(state.alloc_usage[(int) AllocType::Managed] != 0)) {
+        uint32_t n_prefetch = 0;
+        for (size_t i = 1; i < kernel_params.size(); ++i)
+            n_prefetch += (uint32_t) jitc_malloc_prefetch_async(
+                ts, kernel_params[i], ts->device);
+        if (n_prefetch)
+            jitc_trace("jit_assemble(): prefetching %u managed array%s.",
+                       n_prefetch, n_prefetch == 1 ? "" : "s");
+    }
+
     // Pass parameters through global memory if too large or using OptiX
     if (backend == JitBackend::CUDA &&
-        (uses_optix || kernel_param_count > DRJIT_CUDA_ARG_LIMIT)) {
+        (uses_optix || kernel_param_count > jitc_cuda_arg_limit(ts))) {
         size_t size = kernel_param_count * sizeof(void *);
-        uint8_t *tmp = (uint8_t *) jitc_malloc(AllocType::HostPinned, size);
-        kernel_params_global = (uint8_t *) jitc_malloc(AllocType::Device, size);
+        uint8_t *tmp = (uint8_t *) jitc_temp_malloc(ts, AllocType::HostPinned, size);
+        kernel_params_global = (uint8_t *) jitc_temp_malloc(ts, AllocType::Device, size);
         memcpy(tmp, kernel_params.data(), size);
         jitc_memcpy_async(backend, kernel_params_global, tmp, size);
-        jitc_free(tmp);
         kernel_params.clear();
         kernel_params.push_back(kernel_params_global);
     }
@@ -240,27 +724,30 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
         for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
             uint32_t index = schedule[group_index].index;
             Variable *v = jitc_var(index);
+            const VariableScratch *vs = jitc_var_scratch(v);
 
             buffer.fmt("   - %s%u -> r%u: ", type_prefix[v->type],
-                       v->reg_index, index);
+                       vs->reg_index, index);
 
             const char *label = jitc_var_label(index);
             if (label)
                 buffer.fmt("label=\"%s\", ", label);
-            if (v->param_type == ParamType::Input)
-                buffer.fmt("in, offset=%u, ", v->param_offset);
-            if (v->param_type == ParamType::Output)
-                buffer.fmt("out, offset=%u, ", v->param_offset);
+            if (vs->param_type == ParamType::Input)
+                buffer.fmt("in, offset=%u, ", vs->param_offset);
+            if (vs->param_type == ParamType::Output)
+                buffer.fmt("out, offset=%u, ", vs->param_offset);
             if (v->is_literal())
                 buffer.put("literal, ");
-            if (v->size == 1 && v->param_type != ParamType::Output)
+            if (v->size == 1 && vs->param_type != ParamType::Output)
                 buffer.put("scalar, ");
+            if (vs->elide)
+                buffer.put("elided, ");
             if (v->side_effect)
                 buffer.put("side effects, ");
             buffer.rewind_to(buffer.size() - 2);
             buffer.put('\n');
         }
-        jitc_trace("jit_assemble(size=%u): register map:\n%s",
+        jitc_trace("jit_assemble(size=%zu): register map:\n%s",
                   group.size, buffer.get());
     }
 
@@ -270,8 +757,14 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
     else
         jitc_llvm_assemble(ts, group);
 
-    // Replace '^'s in '__raygen__^^^..' or 'drjit_^^^..' with hash
-    kernel_hash = hash_kernel(buffer.get());
+    // Replace '^'s in '__raygen__^^^..' or 'drjit_^^^..' with hash. The
+    // attribute group of LLVM kernels is left out (see jitc_llvm_target_tag())
+    kernel_hash = hash_kernel(buffer.get(),
+                              backend == JitBackend::LLVM
+                                  ? jitc_llvm_attributes_offset(buffer.get(),
+                                                                buffer.size())
+                                  : buffer.size(),
+                              jit_flag(JitFlag::KernelHashOnly));
 
     size_t hash_offset = strchr(buffer.get(), '^') - buffer.get(),
            end_offset = buffer.size(),
@@ -294,24 +787,38 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
 
     if (n_side_effects)
         jitc_log(
-            Info, "  -> launching %016llx (%sn=%u, in=%u, out=%u, se=%u, ops=%u, jit=%s):",
+            Info, "  -> launching %016llx (%sn=%zu, in=%u, out=%u, se=%u, ops=%u, jit=%s):",
             (unsigned long long) kernel_hash.high64,
             uses_optix ? "via OptiX, " : "", group.size, n_params_in,
             n_params_out, n_side_effects, n_ops_total, jitc_time_string(codegen_time));
     else
         jitc_log(
-            Info, "  -> launching %016llx (%sn=%u, in=%u, out=%u, ops=%u, jit=%s):",
+            Info, "  -> launching %016llx (%sn=%zu, in=%u, out=%u, ops=%u, jit=%s):",
             (unsigned long long) kernel_hash.high64,
             uses_optix ? "via OptiX, " : "", group.size, n_params_in,
             n_params_out, n_ops_total, jitc_time_string(codegen_time));
 
-    if (unlikely(jit_flag(JitFlag::KernelHistory))) {
+    if (unlikely(jit_flag(JitFlag::MallocProfile))) {
+        // Let the allocation profiler know where the outputs came from
+        for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
+            const ScheduledVariable &sv = schedule[group_index];
+            if (jitc_var_scratch(jitc_var(sv.index))->param_type == ParamType::Output)
+                jitc_malloc_profile_tag(sv.data, sv.index,
+                                        jitc_var_label(sv.index),
+                                        kernel_hash.high64);
+        }
+    }
+
+    if (unlikely(jit_flags() & ((uint32_t) JitFlag::KernelHistory |
+                                (uint32_t) JitFlag::KernelStats))) {
         kernel_history_entry.backend = backend;
         kernel_history_entry.type = KernelType::JIT;
         kernel_history_entry.hash[0] = kernel_hash.low64;
         kernel_history_entry.hash[1] = kernel_hash.high64;
-        kernel_history_entry.ir = (char *) malloc_check(buffer.size() + 1);
-        memcpy(kernel_history_entry.ir, buffer.get(), buffer.size() + 1);
+        if (jit_flag(JitFlag::KernelHistory)) {
+            kernel_history_entry.ir = (char *) malloc_check(buffer.size() + 1);
+            memcpy(kernel_history_entry.ir, buffer.get(), buffer.size() + 1);
+        }
         kernel_history_entry.uses_optix = uses_optix;
         kernel_history_entry.size = group.size;
         kernel_history_entry.input_count = n_params_in;
@@ -321,10 +828,183 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
     }
 }
 
+/// Run one block of an LLVM kernel launched by jitc_launch_kernel()
+static void jitc_llvm_run_block(uint32_t index, void *ptr) {
+    void **params = (void **) ptr;
+    LLVMKernelFunction kernel = (LLVMKernelFunction) params[0];
+    size_t size       = (size_t) params[1],
+           block_size = (size_t) params[3],
+           start      = (size_t) index * block_size,
+           end        = std::min(start + block_size, size);
+
+#if defined(DRJIT_ENABLE_ITTNOTIFY)
+    // Signal start of kernel
+    __itt_task_begin(drjit_domain, __itt_null, __itt_null,
+                     (__itt_string_handle *) params[2]);
+#endif
+    // Perform the main computation
+    kernel(start, end, params);
+
+#if defined(DRJIT_ENABLE_ITTNOTIFY)
+    // Signal termination of kernel
+    __itt_task_end(drjit_domain);
+#endif
+}
+
+/// Number of pointer-sized payload entries preceding the parameters
+static constexpr size_t jitc_numa_header_size =
+    sizeof(NumaSchedule) / sizeof(void *);
+
+/// Variant of jitc_llvm_run_block() preferring blocks of the worker's node
+static void jitc_llvm_run_block_numa(uint32_t, void *ptr) {
+    NumaSchedule *s = (NumaSchedule *) ptr;
+    uint32_t index = jitc_numa_schedule_claim(s, jitc_numa_thread_node());
+    jitc_llvm_run_block(index, (void **) ptr + jitc_numa_header_size);
+}
+
+/**
+ * \brief Number of entries per work unit of an LLVM kernel launch
+ *
+ * Large launches use blocks of \ref DRJIT_POOL_BLOCK_SIZE entries. Smaller
+ * ones are split more finely so that every worker thread receives several
+ * blocks, which also evens out the load when the cost per entry varies (e.g.
+ * due to loops or virtual function calls). Blocks consist of whole packets,
+ * since the generated code assumes aligned packet accesses.
+ */
+static uint32_t jitc_llvm_block_size(size_t size) {
+    uint32_t width = jitc_llvm_vector_width,
+             target_blocks = std::max(pool_size(), 1u) * 4;
+
+    size_t block_size = (size + target_blocks - 1) / target_blocks;
+    block_size = std::min(std::max(block_size, (size_t) DRJIT_POOL_BLOCK_SIZE_MIN),
+                          (size_t) DRJIT_POOL_BLOCK_SIZE);
+
+    return (uint32_t) ((block_size + width - 1) / width * width);
+}
+
+/// Launches up to this size may run on the calling thread (JitFlag::LaunchInline)
+static const uint32_t jitc_llvm_inline_size = 4 * DRJIT_POOL_BLOCK_SIZE_MIN;
+
+/**
+ * \brief Can an LLVM kernel of the given size run on the calling thread?
+ *
+ * This is only the case when all previously submitted work that the kernel
+ * depends on has finished. Kernel launches recorded in the history (or the
+ * kernel statistics) instead need a task to measure their execution time.
+ */
+static bool jitc_llvm_launch_inline(size_t size, Task *const *deps,
+                                    uint32_t dep_count) {
+    if (size > jitc_llvm_inline_size || !jit_flag(JitFlag::LaunchInline) ||
+        jit_flag(JitFlag::KernelHistory) || jit_flag(JitFlag::KernelStats))
+        return false;
+
+    for (uint32_t i = 0; i < dep_count; ++i) {
+        if (deps[i])
+            return false;
+    }
+
+    return true;
+}
+
+Task *jitc_launch_kernel(ThreadState *ts, const Kernel &kernel, size_t size,
+                         std::vector<void *> &params, CUstream stream,
+                         Task *const *deps, uint32_t dep_count) {
+    Task* ret_task = nullptr;
+    if (ts->backend == JitBackend::CUDA) {
+        size_t buffer_size = params.size() * sizeof(void *);
+
+        void *config[] = {
+            CU_LAUNCH_PARAM_BUFFER_POINTER,
+            params.data(),
+            CU_LAUNCH_PARAM_BUFFER_SIZE,
+            &buffer_size,
+            CU_LAUNCH_PARAM_END
+        };
+
+        uint32_t max_threads = kernel.cuda.block_size, max_blocks_per_sm = 4;
+        if (kernel.cuda.tuned_threads) {
+            // Configuration found by jitc_cuda_tune_begin()
+            max_threads = kernel.cuda.tuned_threads;
+            max_blocks_per_sm = kernel.cuda.tuned_blocks_per_sm;
+        }
+
+        uint32_t block_count, thread_count;
+        const Device &device = state.devices[ts->device];
+        device.get_launch_config(&block_count, &thread_count, (uint32_t) size,
+                                 max_threads, max_blocks_per_sm);
+
+        cuda_check(cuLaunchKernel(kernel.cuda.func, block_count, 1, 1,
+                                  thread_count, 1, 1, 0, stream,
+                                  nullptr, config));
+
+        if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
+            cuda_check(cuStreamSynchronize(stream));
+    } else {
+        size_t packets =
+            (size + jitc_llvm_vector_width - 1) / jitc_llvm_vector_width;
+
+        uint32_t block_size = jitc_llvm_block_size(size),
+                 blocks = (uint32_t) ((size + block_size - 1) / block_size);
+
+        params[0] = (void *) kernel.llvm.reloc[0];
+        params[1] = (void *) size;
+        params[3] = (void *) (uintptr_t) block_size;
+
+#if defined(DRJIT_ENABLE_ITTNOTIFY)
+        params[2] = kernel.llvm.itt;
+#endif
+
+        jitc_trace("jit_run(): scheduling %zu packet%s in %u block%s of %u "
+                   "entries ..", packets, packets == 1 ? "" : "s", blocks,
+                   blocks == 1 ? "" : "s", block_size);
+        (void) packets; // jitc_trace may be disabled
+
+        if (jitc_llvm_launch_inline(size, deps, dep_count)) {
+            // Skip the thread pool, the caller tolerates a missing task
+            for (uint32_t i = 0; i < blocks; ++i)
+                jitc_llvm_run_block(i, params.data());
+        } else if (jitc_numa_policy == NumaPolicy::Local && jitc_numa_nodes > 1 &&
+            blocks > 1) {
+            // Prefix the parameters with a block-to-node assignment
+            std::vector<void *> payload(jitc_numa_header_size + params.size());
+            NumaSchedule *s = new (payload.data()) NumaSchedule();
+            jitc_numa_schedule_init(s, blocks);
+            memcpy(payload.data() + jitc_numa_header_size, params.data(),
+                   params.size() * sizeof(void *));
+
+            ret_task = task_submit_dep(
+                nullptr, deps, dep_count, blocks,
+                jitc_llvm_run_block_numa, payload.data(),
+                (uint32_t) (payload.size() * sizeof(void *)),
+                nullptr
+            );
+        } else {
+            ret_task = task_submit_dep(
+                nullptr, deps, dep_count, blocks,
+                jitc_llvm_run_block, params.data(),
+                (uint32_t) (params.size() * sizeof(void *)),
+                nullptr
+            );
+        }
+
+        if (unlikely(jit_flag(JitFlag::LaunchBlocking)) && ret_task)
+            task_wait(ret_task);
+    }
+
+    return ret_task;
+}
+
 static ProfilerRegion profiler_region_backend_compile("jit_eval: compiling");
+
+/// Kernels awaiting recompilation (JitFlag::TieredCompile) skip the disk cache
+static bool jitc_kernel_is_final(JitBackend backend, const Kernel &kernel) {
+    return backend != JitBackend::LLVM ||
+           kernel.llvm.tier != (uint32_t) LLVMTier::Fast;
+}
 static ProfilerRegion profiler_region_backend_load("jit_eval: loading");
 
-Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
+Task *jitc_run(ThreadState *ts, ScheduledGroup group,
+               AssembledKernel *ak = nullptr) {
     uint64_t flags = 0;
 
 #if defined(DRJIT_ENABLE_OPTIX)
@@ -339,24 +1019,38 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
     }
 #endif
 
-    KernelKey kernel_key((char *) buffer.get(), ts->device, flags);
+    KernelKey kernel_key((char *) buffer.get(), buffer.size(), kernel_hash,
+                         ts->device, flags,
+                         jit_flag(JitFlag::KernelHashOnly));
     auto it = state.kernel_cache.find(
         kernel_key,
         KernelHash::compute_hash(kernel_hash.high64, ts->device, flags));
-    Kernel kernel;
+    Kernel kernel, *entry = nullptr;
     memset(&kernel, 0, sizeof(Kernel)); // quench uninitialized variable warning on MSVC
 
     if (it == state.kernel_cache.end()) {
-        bool cache_hit = false;
+        bool cache_hit = false,
+             precompiled = ak && ak->status != AssembledKernel::Status::Pending;
 
-        if (!uses_optix)
+        if (precompiled) {
+            // Already loaded or compiled by jitc_precompile()
+            kernel = ak->kernel;
+            cache_hit = ak->status == AssembledKernel::Status::Loaded;
+        } else if (!uses_optix) {
+            unlock_guard guard(state.lock);
             cache_hit = jitc_kernel_load(buffer.get(), (uint32_t) buffer.size(),
                                          ts->backend, kernel_hash, kernel);
+        }
 
-        if (!cache_hit) {
+        if (!cache_hit && !precompiled) {
             ProfilerPhase profiler(profiler_region_backend_compile);
+
+            /* Other threads may keep tracing while the backend compiles the
+               kernel. 'state.eval_lock' (held by the caller) protects the
+               assembly buffer and the remaining codegen state. */
             if (ts->backend == JitBackend::CUDA) {
                 if (!uses_optix) {
+                    unlock_guard guard(state.lock);
                     jitc_cuda_compile(buffer.get(), buffer.size(), kernel);
                 } else {
 #if defined(DRJIT_ENABLE_OPTIX)
@@ -366,13 +1060,28 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
                     jitc_fail("jit_run(): OptiX support was not enabled in DrJit.");
 #endif
                 }
+            } else if (jitc_llvm_compile_is_concurrent()) {
+                // Use a pooled compiler instance, the main one isn't reentrant
+                std::vector<std::string> names = jitc_llvm_compile_symbols();
+                LLVMTier tier = jitc_llvm_tier_initial();
+                unlock_guard guard(state.lock);
+                jitc_llvm_compile_ir(buffer.get(), buffer.size(), names,
+                                     kernel, tier);
             } else {
-                jitc_llvm_compile(kernel);
+                jitc_llvm_compile(kernel, jitc_llvm_tier_initial());
             }
 
-            if (kernel.data)
-                jitc_kernel_write(buffer.get(), (uint32_t) buffer.size(),
-                                  ts->backend, kernel_hash, kernel);
+            if (kernel.data && jitc_kernel_is_final(ts->backend, kernel)) {
+                /* Unlock while writing */ {
+                    unlock_guard guard(state.lock);
+                    jitc_kernel_write(buffer.get(), (uint32_t) buffer.size(),
+                                      ts->backend, kernel_hash, kernel);
+                }
+                if (ts->backend == JitBackend::LLVM)
+                    jitc_llvm_write_versions(buffer.get(), buffer.size(),
+                                             kernel_hash,
+                                             jitc_llvm_compile_symbols());
+            }
         }
 
         ProfilerPhase profiler(profiler_region_backend_load);
@@ -380,44 +1089,7 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
         if (ts->backend == JitBackend::LLVM) {
             jitc_llvm_disasm(kernel);
         } else if (!uses_optix) {
-            CUresult ret = (CUresult) 0;
-            /* Unlock while synchronizing */ {
-                unlock_guard guard(state.lock);
-                ret = cuModuleLoadData(&kernel.cuda.mod, kernel.data);
-            }
-            if (ret == CUDA_ERROR_OUT_OF_MEMORY) {
-                jitc_flush_malloc_cache(true);
-                /* Unlock while synchronizing */ {
-                    unlock_guard guard(state.lock);
-                    ret = cuModuleLoadData(&kernel.cuda.mod, kernel.data);
-                }
-            }
-            cuda_check(ret);
-
-            // Locate the kernel entry point
-            size_t offset = buffer.size();
-            buffer.fmt_cuda(2, "drjit_$Q$Q", kernel_hash.high64,
-                            kernel_hash.low64);
-            cuda_check(cuModuleGetFunction(&kernel.cuda.func, kernel.cuda.mod,
-                                           buffer.get() + offset));
-            buffer.rewind_to(offset);
-
-            // Determine a suitable thread count to maximize occupancy
-            int unused, block_size;
-            cuda_check(cuOccupancyMaxPotentialBlockSize(
-                &unused, &block_size,
-                kernel.cuda.func, nullptr, 0, 0));
-            kernel.cuda.block_size = (uint32_t) block_size;
-
-            // DrJit doesn't use shared memory at all, prefer to have more L1 cache.
-            cuda_check(cuFuncSetAttribute(
-                kernel.cuda.func, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, 0));
-            cuda_check(cuFuncSetAttribute(
-                kernel.cuda.func, CU_FUNC_ATTRIBUTE_PREFERRED_SHARED_MEMORY_CARVEOUT,
-                CU_SHAREDMEM_CARVEOUT_MAX_L1));
-
-            free(kernel.data);
-            kernel.data = nullptr;
+            jitc_cuda_load(kernel, kernel_hash);
         }
 
         float link_time = timer();
@@ -428,15 +1100,30 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
                 std::string(jitc_mem_string(kernel.size)).c_str());
 
         kernel_key.str = (char *) malloc_check(buffer.size() + 1);
+        kernel_key.hash_only = false;
         memcpy(kernel_key.str, buffer.get(), buffer.size() + 1);
-        state.kernel_cache.emplace(kernel_key, kernel);
+        kernel.pins = 0;
+        kernel.last_use = ++state.kernel_cache_timestamp;
+        auto result = state.kernel_cache.emplace(kernel_key, kernel);
+
+        if (likely(result.second)) {
+            state.kernel_cache_size += kernel.size + kernel_key.size;
+        } else {
+            // Another thread (e.g. jit_kernel_cache_prefetch()) was faster
+            jitc_kernel_free(ts->device, kernel);
+            free(kernel_key.str);
+            kernel_key.str = result.first->first.str;
+            kernel = result.first.value();
+        }
+        entry = &result.first.value();
 
         if (cache_hit)
             state.kernel_soft_misses++;
         else
             state.kernel_hard_misses++;
 
-        if (unlikely(jit_flag(JitFlag::KernelHistory))) {
+        if (unlikely(jit_flags() & ((uint32_t) JitFlag::KernelHistory |
+                                    (uint32_t) JitFlag::KernelStats))) {
             kernel_history_entry.cache_disk = cache_hit;
             kernel_history_entry.cache_hit = cache_hit;
             if (!cache_hit)
@@ -444,116 +1131,382 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
         }
     } else {
         kernel_history_entry.cache_hit = true;
+        it.value().last_use = ++state.kernel_cache_timestamp;
+        if (ts->backend == JitBackend::LLVM && jitc_llvm_tier_count(it.value()))
+            jitc_llvm_tier_up(it->first, it.value(),
+                              ak ? ak->symbols : jitc_llvm_compile_symbols());
         kernel = it.value();
+        entry = &it.value();
         state.kernel_hits++;
     }
     state.kernel_launches++;
 
+    CUstream stream = kernel_stream ? kernel_stream : ts->stream;
+
     if (unlikely(jit_flag(JitFlag::KernelHistory) &&
                  ts->backend == JitBackend::CUDA)) {
         auto &e = kernel_history_entry;
         cuda_check(cuEventCreate((CUevent *) &e.event_start, CU_EVENT_DEFAULT));
         cuda_check(cuEventCreate((CUevent *) &e.event_end, CU_EVENT_DEFAULT));
-        cuda_check(cuEventRecord((CUevent) e.event_start, ts->stream));
+        cuda_check(cuEventRecord((CUevent) e.event_start, stream));
+    }
+
+    KernelStatsLaunch stats_launch;
+    bool stats = jit_flag(JitFlag::KernelStats);
+    if (unlikely(stats)) {
+        const KernelHistoryEntry &e = kernel_history_entry;
+        stats_launch.backend = ts->backend;
+        stats_launch.type = KernelType::JIT;
+        stats_launch.hash[0] = e.hash[0];
+        stats_launch.hash[1] = e.hash[1];
+        stats_launch.device = ts->device;
+        stats_launch.size = group.size;
+        stats_launch.bytes_in = kernel_bytes_in;
+        stats_launch.bytes_out = kernel_bytes_out;
+        stats_launch.codegen_time = e.codegen_time * 1e3f;
+        stats_launch.backend_time = e.backend_time * 1e3f;
+        jitc_kernel_stats_begin(stats_launch, stream);
     }
 
+    if (unlikely(ts->freeze))
+        jitc_freeze_record(ts, group, kernel_key, kernel, kernel_params,
+                           kernel_params_global != nullptr);
+
     Task* ret_task = nullptr;
-    if (ts->backend == JitBackend::CUDA) {
 #if defined(DRJIT_ENABLE_OPTIX)
-        if (unlikely(uses_optix))
-            jitc_optix_launch(ts, kernel, group.size, kernel_params_global,
-                              kernel_param_count);
+    if (unlikely(uses_optix)) {
+        jitc_optix_launch(ts, kernel, (uint32_t) group.size, kernel_params_global,
+                          kernel_param_count);
+
+        if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
+            cuda_check(cuStreamSynchronize(stream));
+    }
 #endif
 
-        if (!uses_optix) {
-            size_t buffer_size = kernel_params.size() * sizeof(void *);
+    // Try a different launch configuration (not while capturing a graph)
+    bool tune = false;
+    if (unlikely(jit_flag(JitFlag::LaunchAutotune)) &&
+        ts->backend == JitBackend::CUDA && !uses_optix && !ts->graph_capture &&
+        !kernel.cuda.tuned_threads)
+        tune = jitc_cuda_tune_begin(state.devices[ts->device], *entry, kernel,
+                                    kernel_hash, (uint32_t) group.size, stream);
 
-            void *config[] = {
-                CU_LAUNCH_PARAM_BUFFER_POINTER,
-                kernel_params.data(),
-                CU_LAUNCH_PARAM_BUFFER_SIZE,
-                &buffer_size,
-                CU_LAUNCH_PARAM_END
-            };
+    // Persistent threads start by fetching the first index
+    if (kernel_work_counter)
+        cuda_check(cuMemsetD32Async(kernel_work_counter, 0, 1, stream));
 
-            uint32_t block_count, thread_count, size = group.size;
-            const Device &device = state.devices[ts->device];
-            device.get_launch_config(&block_count, &thread_count, size,
-                                     (uint32_t) kernel.cuda.block_size);
+    if (!uses_optix)
+        ret_task = jitc_launch_kernel(ts, kernel, group.size, kernel_params,
+                                      stream, kernel_deps.data(),
+                                      (uint32_t) kernel_deps.size());
 
-            cuda_check(cuLaunchKernel(kernel.cuda.func, block_count, 1, 1,
-                                      thread_count, 1, 1, 0, ts->stream,
-                                      nullptr, config));
+    if (tune)
+        jitc_cuda_tune_end(*entry, stream);
+
+    if (unlikely(jit_flag(JitFlag::KernelHistory))) {
+        if (ts->backend == JitBackend::CUDA) {
+            cuda_check(cuEventRecord((CUevent) kernel_history_entry.event_end,
+                                     stream));
+        } else {
+            task_retain(ret_task);
+            kernel_history_entry.task = ret_task;
         }
 
-        if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
-            cuda_check(cuStreamSynchronize(ts->stream));
-    } else {
-        uint32_t packets =
-            (group.size + jitc_llvm_vector_width - 1) / jitc_llvm_vector_width;
+        state.kernel_history.append(kernel_history_entry);
+    }
 
-        auto callback = [](uint32_t index, void *ptr) {
-            void **params = (void **) ptr;
-            LLVMKernelFunction kernel = (LLVMKernelFunction) params[0];
-            uint32_t size       = (uint32_t) (uintptr_t) params[1],
-                     block_size = (uint32_t) ((uintptr_t) params[1] >> 32),
-                     start      = index * block_size,
-                     end        = std::min(start + block_size, size);
+    if (unlikely(stats))
+        jitc_kernel_stats_end(stats_launch, stream, ret_task);
 
-#if defined(DRJIT_ENABLE_ITTNOTIFY)
-            // Signal start of kernel
-            __itt_task_begin(drjit_domain, __itt_null, __itt_null,
-                             (__itt_string_handle *) params[2]);
-#endif
-            // Perform the main computation
-            kernel(start, end, params);
+    return ret_task;
+}
 
-#if defined(DRJIT_ENABLE_ITTNOTIFY)
-            // Signal termination of kernel
-            __itt_task_end(drjit_domain);
-#endif
-        };
+/// Check if two groups access the same memory region, with at least one write
+static bool jitc_kernel_conflict(uint32_t g1, uint32_t g2) {
+    uint32_t n = (uint32_t) kernel_access_offset.size(),
+             s1 = kernel_access_offset[g1],
+             e1 = g1 + 1 < n ? kernel_access_offset[g1 + 1] : (uint32_t) kernel_access.size(),
+             s2 = kernel_access_offset[g2],
+             e2 = g2 + 1 < n ? kernel_access_offset[g2 + 1] : (uint32_t) kernel_access.size();
+
+    for (uint32_t i = s1; i < e1; ++i) {
+        const KernelAccess &a = kernel_access[i];
+        for (uint32_t j = s2; j < e2; ++j) {
+            const KernelAccess &b = kernel_access[j];
+            if ((a.write || b.write) && a.ptr == b.ptr)
+                return true;
+        }
+    }
 
-        uint32_t block_size = DRJIT_POOL_BLOCK_SIZE,
-                 blocks = (group.size + block_size - 1) / block_size;
+    return false;
+}
 
-        kernel_params[0] = (void *) kernel.llvm.reloc[0];
-        kernel_params[1] = (void *) ((((uintptr_t) block_size) << 32) +
-                                     (uintptr_t) group.size);
+/**
+ * \brief Collect the tasks that the LLVM kernel of group \c id must wait for
+ *
+ * Kernels of the same jitc_eval() call generally touch disjoint memory. They
+ * only depend on previously submitted work ('jitc_task') and run side by side.
+ * A scatter may however target a buffer that another group reads or writes,
+ * in which case the kernel must also wait for the earlier group.
+ */
+static void jitc_kernel_deps(uint32_t id) {
+    kernel_deps.clear();
+    kernel_deps.push_back(jitc_task);
+
+    if (!kernel_access_write)
+        return;
 
-#if defined(DRJIT_ENABLE_ITTNOTIFY)
-        kernel_params[2] = kernel.llvm.itt;
-#endif
+    for (uint32_t i = 0; i < id; ++i) {
+        if (jitc_kernel_conflict(id, i))
+            kernel_deps.push_back(scheduled_tasks[i]);
+    }
 
-        jitc_trace("jit_run(): scheduling %u packet%s in %u block%s ..",
-                   packets, packets == 1 ? "" : "s", blocks,
-                   blocks == 1 ? "" : "s");
-        (void) packets; // jitc_trace may be disabled
+    if (kernel_deps.size() > 1)
+        jitc_log(Debug, "jit_eval(): kernel %u has %zu dependencies due to "
+                 "overlapping memory accesses.", id, kernel_deps.size() - 1);
+}
 
-        ret_task = task_submit_dep(
-            nullptr, &jitc_task, 1, blocks,
-            callback, kernel_params.data(),
-            (uint32_t) (kernel_params.size() * sizeof(void *)),
-            nullptr
-        );
+/// Save the result of jitc_assemble() so that the kernel can be launched later
+static void jitc_assemble_save(ThreadState *ts, AssembledKernel &ak) {
+    ak.source_size = buffer.size();
+    ak.source = (char *) malloc_check(ak.source_size + 1);
+    memcpy(ak.source, buffer.get(), ak.source_size + 1);
+    ak.hash = kernel_hash;
+    memcpy(ak.name, kernel_name, sizeof(kernel_name));
+    ak.params = kernel_params;
+    ak.params_global = kernel_params_global;
+    ak.param_count = kernel_param_count;
+    ak.callable_count_unique = callable_count_unique;
+    ak.uses_optix = uses_optix;
+    ak.work_counter = kernel_work_counter;
+    ak.history = kernel_history_entry;
+    ak.bytes_in = kernel_bytes_in;
+    ak.bytes_out = kernel_bytes_out;
+    if (ts->backend == JitBackend::LLVM)
+        ak.symbols = jitc_llvm_compile_symbols();
+    memset(&ak.kernel, 0, sizeof(Kernel));
+    ak.status = AssembledKernel::Status::Pending;
+    kernel_params_global = nullptr;
+}
 
-        if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
-            task_wait(ret_task);
+/// Reverse of jitc_assemble_save(): restore the globals used by jitc_run()
+static void jitc_assemble_restore(const AssembledKernel &ak) {
+    buffer.clear();
+    buffer.put(ak.source, ak.source_size);
+    kernel_hash = ak.hash;
+    memcpy(kernel_name, ak.name, sizeof(kernel_name));
+    kernel_params = ak.params;
+    kernel_params_global = ak.params_global;
+    kernel_param_count = ak.param_count;
+    callable_count_unique = ak.callable_count_unique;
+    uses_optix = ak.uses_optix;
+    kernel_work_counter = ak.work_counter;
+    kernel_history_entry = ak.history;
+    kernel_bytes_in = ak.bytes_in;
+    kernel_bytes_out = ak.bytes_out;
+}
+
+static ProfilerRegion profiler_region_precompile("jit_eval: compiling (parallel)");
+
+/**
+ * \brief Load or compile all assembled kernels that are missing from the
+ * in-memory kernel cache.
+ *
+ * PTX compilation via the CUDA linker is thread-safe and runs concurrently on
+ * the thread pool. The same is true for the LLVM backend when ORCv2 is
+ * available, where each worker thread uses its own compiler instance (LLVM
+ * context, target machine, JIT, and memory manager). The MCJIT fallback
+ * compiles into shared state and therefore processes its kernels one at a
+ * time. OptiX kernels are skipped and compiled by jitc_run() as usual.
+ */
+static void jitc_precompile(ThreadState *ts) {
+    std::vector<AssembledKernel *> todo;
+
+    for (size_t i = 0; i < assembled_kernels.size(); ++i) {
+        AssembledKernel &ak = assembled_kernels[i];
+        if (ak.uses_optix)
+            continue;
+
+        KernelKey kernel_key(ak.source, ak.source_size, ak.hash, ts->device, 0,
+                             jit_flag(JitFlag::KernelHashOnly));
+        auto it = state.kernel_cache.find(
+            kernel_key, KernelHash::compute_hash(ak.hash.high64, ts->device, 0));
+        if (it != state.kernel_cache.end())
+            continue;
+
+        // Identical kernels in the same jit_eval() only need to be built once
+        bool duplicate = false;
+        for (size_t j = 0; j < i && !duplicate; ++j) {
+            const AssembledKernel &ak2 = assembled_kernels[j];
+            duplicate = ak2.hash.high64 == ak.hash.high64 &&
+                        ak2.hash.low64 == ak.hash.low64 &&
+                        ak2.source_size == ak.source_size &&
+                        strcmp(ak2.source, ak.source) == 0;
+        }
+        if (duplicate)
+            continue;
+
+        bool loaded;
+        /* Unlock while reading the disk cache */ {
+            unlock_guard guard(state.lock);
+            loaded = jitc_kernel_load(ak.source, (uint32_t) ak.source_size,
+                                      ts->backend, ak.hash, ak.kernel);
+        }
+
+        if (loaded)
+            ak.status = AssembledKernel::Status::Loaded;
+        else
+            todo.push_back(&ak);
     }
 
-    if (unlikely(jit_flag(JitFlag::KernelHistory))) {
-        if (ts->backend == JitBackend::CUDA) {
-            cuda_check(cuEventRecord((CUevent) kernel_history_entry.event_end,
-                                     ts->stream));
-        } else {
-            task_retain(ret_task);
-            kernel_history_entry.task = ret_task;
+    if (todo.empty())
+        return;
+
+    ProfilerPhase profiler(profiler_region_precompile);
+    (void) timer();
+
+    if (ts->backend == JitBackend::CUDA) {
+        CUcontext context = ts->context;
+        unlock_guard guard(state.lock);
+        drjit::parallel_for(
+            drjit::blocked_range<size_t>(0, todo.size(), 1),
+            [&](drjit::blocked_range<size_t> range) {
+                scoped_set_context guard_2(context);
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    AssembledKernel *ak = todo[i];
+                    jitc_cuda_compile(ak->source, ak->source_size, ak->kernel);
+                }
+            });
+    } else if (jitc_llvm_compile_is_concurrent()) {
+        LLVMTier tier = jitc_llvm_tier_initial();
+        unlock_guard guard(state.lock);
+        drjit::parallel_for(
+            drjit::blocked_range<size_t>(0, todo.size(), 1),
+            [&](drjit::blocked_range<size_t> range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    AssembledKernel *ak = todo[i];
+                    jitc_llvm_compile_ir(ak->source, ak->source_size,
+                                         ak->symbols, ak->kernel, tier);
+                }
+            });
+    } else {
+        for (AssembledKernel *ak : todo)
+            jitc_llvm_compile_ir(ak->source, ak->source_size, ak->symbols,
+                                 ak->kernel);
+    }
+
+    for (AssembledKernel *ak : todo) {
+        ak->status = AssembledKernel::Status::Compiled;
+        if (ak->kernel.data && jitc_kernel_is_final(ts->backend, ak->kernel)) {
+            /* Unlock while writing */ {
+                unlock_guard guard(state.lock);
+                jitc_kernel_write(ak->source, (uint32_t) ak->source_size,
+                                  ts->backend, ak->hash, ak->kernel);
+            }
+            if (ts->backend == JitBackend::LLVM)
+                jitc_llvm_write_versions(ak->source, ak->source_size, ak->hash,
+                                         ak->symbols);
         }
+    }
 
-        state.kernel_history.append(kernel_history_entry);
+    jitc_log(Info, "jit_eval(): compiled %zu kernel%s in %s.", todo.size(),
+             todo.size() == 1 ? "" : "s",
+             std::string(jitc_time_string(timer())).c_str());
+}
+
+/// Return an event from the pool of device 'dev', creating it if needed
+static CUevent jitc_aux_event(Device &dev, size_t index) {
+    while (dev.aux_events.size() <= index) {
+        CUevent event = nullptr;
+        cuda_check(cuEventCreate(&event, CU_EVENT_DISABLE_TIMING));
+        dev.aux_events.push_back(event);
     }
+    return dev.aux_events[index];
+}
 
-    return ret_task;
+/**
+ * \brief Select the CUDA stream for the kernel of group \c id and make it
+ * wait for the work that the kernel depends on (JitFlag::ParallelStreams)
+ *
+ * Kernels are distributed over the auxiliary streams of the device in a
+ * round-robin fashion. Each one waits for the work issued on the main stream
+ * so far (which includes parameter and virtual function call table uploads)
+ * and for earlier kernels accessing the same memory. Event 0 of the pool
+ * marks the state of the main stream, and event 'i + 1' the completion of
+ * kernel 'i'.
+ */
+static void jitc_stream_begin(ThreadState *ts, uint32_t id) {
+    Device &dev = state.devices[ts->device];
+
+    CUstream &stream = dev.aux_stream[id % DRJIT_CUDA_STREAM_COUNT];
+    if (!stream)
+        cuda_check(cuStreamCreate(&stream, CU_STREAM_DEFAULT));
+
+    CUevent main_event = jitc_aux_event(dev, 0);
+    cuda_check(cuEventRecord(main_event, ts->stream));
+    cuda_check(cuStreamWaitEvent(stream, main_event, 0));
+
+    for (uint32_t i = 0; i < id && kernel_access_write; ++i) {
+        if (kernel_streams[i] != stream && jitc_kernel_conflict(id, i))
+            cuda_check(cuStreamWaitEvent(stream, jitc_aux_event(dev, i + 1), 0));
+    }
+
+    kernel_stream = stream;
+}
+
+/// Signal completion of the kernel of group \c id (JitFlag::ParallelStreams)
+static void jitc_stream_end(ThreadState *ts, uint32_t id) {
+    Device &dev = state.devices[ts->device];
+    cuda_check(cuEventRecord(jitc_aux_event(dev, id + 1), kernel_stream));
+    kernel_streams.push_back(kernel_stream);
+    kernel_stream = nullptr;
+}
+
+/// Make the main stream wait for all auxiliary streams (JitFlag::ParallelStreams)
+static void jitc_stream_join(ThreadState *ts) {
+    Device &dev = state.devices[ts->device];
+
+    // The last kernel on each stream implies completion of all prior ones
+    for (size_t i = 0; i < kernel_streams.size(); ++i) {
+        CUstream stream = kernel_streams[i];
+        bool last = stream != ts->stream;
+        for (size_t j = i + 1; j < kernel_streams.size() && last; ++j)
+            last = kernel_streams[j] != stream;
+        if (last)
+            cuda_check(cuStreamWaitEvent(ts->stream, dev.aux_events[i + 1], 0));
+    }
+
+    kernel_streams.clear();
+}
+
+/// Launch the kernel of the most recently assembled or restored group
+static void jitc_launch(ThreadState *ts, ScheduledGroup group,
+                        AssembledKernel *ak, bool parallel_streams) {
+    uint32_t id = (uint32_t) scheduled_tasks.size();
+
+    if (ts->backend == JitBackend::LLVM) {
+        jitc_kernel_deps(id);
+    } else if (parallel_streams) {
+        // OptiX launches are always issued on the main stream
+        if (uses_optix) {
+            for (uint32_t i = 0; i < id && kernel_access_write; ++i) {
+                if (kernel_streams[i] != ts->stream && jitc_kernel_conflict(id, i))
+                    cuda_check(cuStreamWaitEvent(
+                        ts->stream, jitc_aux_event(state.devices[ts->device], i + 1), 0));
+            }
+            kernel_stream = ts->stream;
+        } else {
+            jitc_stream_begin(ts, id);
+        }
+    }
+
+    scheduled_tasks.push_back(jitc_run(ts, group, ak));
+
+    if (ts->backend == JitBackend::CUDA) {
+        if (parallel_streams)
+            jitc_stream_end(ts, id);
+        kernel_params_global = nullptr;
+    }
 }
 
 static ProfilerRegion profiler_region_eval("jit_eval");
@@ -563,6 +1516,10 @@ void jitc_eval(ThreadState *ts) {
     if (!ts || (ts->scheduled.empty() && ts->side_effects.empty()))
         return;
 
+    // Kernels may access registry attributes, upload pending changes first
+    if (ts->backend == JitBackend::CUDA)
+        jitc_registry_flush(JitBackend::CUDA);
+
     ProfilerPhase profiler(profiler_region_eval);
 
     /* The function 'jitc_eval()' modifies several global data structures
@@ -579,93 +1536,124 @@ void jitc_eval(ThreadState *ts) {
 
     jitc_var_loop_simplify();
 
-    visited.clear();
+    visited_any.clear();
     schedule.clear();
+    traverse_roots.clear();
 
-    // Collect variables that must be computed along with their dependencies
-    for (int j = 0; j < 2; ++j) {
-        auto &source = j == 0 ? ts->scheduled : ts->side_effects;
-        for (size_t i = 0; i < source.size(); ++i) {
-            uint32_t index = source[i];
-            auto it = state.variables.find(index);
-            if (it == state.variables.end())
-                continue;
+    // Collect variables that must be computed
+    auto collect = [](uint32_t index, Variable *v) {
+        // Skip expired variables and ones that are already evaluated
+        if (!v || v->is_data())
+            return;
 
-            Variable *v = &it.value();
+        traverse_roots.emplace_back(v->size, index);
+    };
 
-            // Skip variables that are already evaluated
-            if (v->is_data())
-                continue;
+    for (size_t i = 0; i < ts->scheduled.size(); ++i) {
+        WeakRef ref = ts->scheduled[i];
+        collect(ref.index, jitc_var(ref));
+    }
+    ts->scheduled.clear();
 
-            jitc_var_traverse(v->size, index);
-            v->output_flag = (VarType) v->type != VarType::Void;
+    for (size_t i = 0; i < ts->side_effects.size(); ++i) {
+        uint32_t index = ts->side_effects[i];
+        collect(index, jitc_var_maybe(index));
+    }
+    ts->side_effects.clear();
+
+    /* Find their dependencies. Roots of the same size are processed together,
+       so that 'visited' only needs to track a single size at a time. The
+       schedule is sorted by size below, hence this does not change it. */
+    std::stable_sort(traverse_roots.begin(), traverse_roots.end(),
+                     [](const std::pair<size_t, uint32_t> &a,
+                        const std::pair<size_t, uint32_t> &b) {
+                         return a.first > b.first;
+                     });
+
+    size_t traverse_size = 0;
+    for (const std::pair<size_t, uint32_t> &root : traverse_roots) {
+        if (root.first != traverse_size) {
+            visited.clear();
+            traverse_size = root.first;
         }
 
-        source.clear();
+        jitc_var_traverse(root.first, root.second);
+        Variable *v = jitc_var(root.second);
+        jitc_var_scratch(v)->output_flag = (VarType) v->type != VarType::Void;
     }
 
     if (schedule.empty())
         return;
 
-    // Order variables into groups of matching size
-    std::stable_sort(
-        schedule.begin(), schedule.end(),
-        [](const ScheduledVariable &a, const ScheduledVariable &b) {
-            if (a.size > b.size)
-                return true;
-            else if (a.size < b.size)
-                return false;
-            else if (a.scope > b.scope)
-                return false;
-            else if (a.scope < b.scope)
-                return true;
-            else
-                return false;
-        });
+    jitc_schedule_partition();
 
-    // Partition into groups of matching size
-    schedule_groups.clear();
-    if (schedule[0].size == schedule[schedule.size() - 1].size) {
-        schedule_groups.emplace_back(schedule[0].size, 0,
-                                     (uint32_t) schedule.size());
-    } else {
-        uint32_t cur = 0;
-        for (uint32_t i = 1; i < (uint32_t) schedule.size(); ++i) {
-            if (schedule[i - 1].size != schedule[i].size) {
-                schedule_groups.emplace_back(schedule[cur].size, cur, i);
-                cur = i;
-            }
-        }
-
-        schedule_groups.emplace_back(schedule[cur].size,
-                                     cur, (uint32_t) schedule.size());
-    }
+    if (jit_flag(JitFlag::KernelFusion))
+        jitc_schedule_fuse_scalars();
 
     jitc_log(Info, "jit_eval(): launching %zu kernel%s.",
             schedule_groups.size(),
             schedule_groups.size() == 1 ? "" : "s");
+    jitc_stat(Stat::Evals);
+    jitc_stat(Stat::EvalGroups, schedule_groups.size());
 
     scoped_set_context_maybe guard2(ts->context);
     scheduled_tasks.clear();
+    kernel_access.clear();
+    kernel_access_offset.clear();
+    kernel_access_write = false;
+    kernel_streams.clear();
+
+    bool parallel_streams = ts->backend == JitBackend::CUDA &&
+                            schedule_groups.size() > 1 &&
+                            jit_flag(JitFlag::ParallelStreams);
+
+    if (jit_flag(JitFlag::ParallelCompile) && schedule_groups.size() > 1) {
+        /* Assemble all kernels first, compile the missing ones concurrently,
+           and then launch everything in the original order */
+        assembled_kernels.clear();
+        for (ScheduledGroup &group : schedule_groups) {
+            jitc_assemble(ts, group);
+            assembled_kernels.emplace_back(group);
+            jitc_assemble_save(ts, assembled_kernels.back());
+        }
 
-    for (ScheduledGroup &group : schedule_groups) {
-        jitc_assemble(ts, group);
-
-        scheduled_tasks.push_back(jitc_run(ts, group));
+        jitc_precompile(ts);
+        (void) timer();
 
-        if (ts->backend == JitBackend::CUDA) {
-            jitc_free(kernel_params_global);
-            kernel_params_global = nullptr;
+        for (AssembledKernel &ak : assembled_kernels) {
+            jitc_assemble_restore(ak);
+            free(ak.source);
+            ak.source = nullptr;
+            jitc_launch(ts, ak.group, &ak, parallel_streams);
+        }
+        assembled_kernels.clear();
+    } else {
+        for (ScheduledGroup &group : schedule_groups) {
+            jitc_assemble(ts, group);
+            jitc_launch(ts, group, nullptr, parallel_streams);
         }
     }
 
+    if (parallel_streams)
+        jitc_stream_join(ts);
+
     if (ts->backend == JitBackend::LLVM) {
-        if (scheduled_tasks.size() == 1) {
+        if (unlikely(scheduled_tasks.empty()))
+            jitc_fail("jit_eval(): no tasks generated!");
+
+        // Kernels that ran on the calling thread (JitFlag::LaunchInline)
+        scheduled_tasks.erase(std::remove(scheduled_tasks.begin(),
+                                          scheduled_tasks.end(), nullptr),
+                              scheduled_tasks.end());
+
+        if (scheduled_tasks.empty()) {
+            // Everything has finished, including previously submitted work
+            task_release(jitc_task);
+            jitc_task = nullptr;
+        } else if (scheduled_tasks.size() == 1) {
             task_release(jitc_task);
             jitc_task = scheduled_tasks[0];
         } else {
-            if (unlikely(scheduled_tasks.empty()))
-                jitc_fail("jit_eval(): no tasks generated!");
 
             // Insert a barrier task
             Task *new_task = task_submit_dep(nullptr, scheduled_tasks.data(),
@@ -675,8 +1663,13 @@ void jitc_eval(ThreadState *ts) {
                 task_release(t);
             jitc_task = new_task;
         }
+
+        jitc_llvm_tier_eval_done();
     }
 
+    // Temporaries of this evaluation become reusable once its work finishes
+    jitc_temp_reset(ts);
+
     /* Variables and their dependencies are now computed, hence internal edges
        between them can be removed. This will cause many variables to expire. */
     jitc_log(Debug, "jit_eval(): cleaning up..");
@@ -684,13 +1677,13 @@ void jitc_eval(ThreadState *ts) {
     for (ScheduledVariable sv : schedule) {
         uint32_t index = sv.index;
 
-        auto it = state.variables.find(index);
-        if (it == state.variables.end())
+        Variable *v = jitc_var(WeakRef(index, sv.counter));
+        if (!v)
             continue;
 
-        Variable *v = &it.value();
-        v->reg_index = 0;
-        if (!(v->output_flag || v->side_effect))
+        VariableScratch *vs = jitc_var_scratch(v);
+        vs->reg_index = 0;
+        if (!(vs->output_flag || v->side_effect))
             continue;
 
         if (unlikely(v->is_literal()))
@@ -699,16 +1692,10 @@ void jitc_eval(ThreadState *ts) {
 
         jitc_lvn_drop(index, v);
 
-        if (v->free_stmt) {
-            free(v->stmt);
-            v->stmt = nullptr;
-            v->free_stmt = false;
-        }
-
-        if (v->output_flag && v->size == sv.size) {
+        if (vs->output_flag && sv.data) {
             v->kind = (uint32_t) VarKind::Data;
             v->data = sv.data;
-            v->output_flag = false;
+            vs->output_flag = false;
             v->consumed = false;
         }
 
@@ -743,6 +1730,8 @@ void jitc_eval(ThreadState *ts) {
             jitc_var_dec_ref(dep[j]);
     }
 
+    jitc_kernel_cache_trim();
+
     jitc_log(Info, "jit_eval(): done.");
 }
 
@@ -759,6 +1748,7 @@ jitc_assemble_func(ThreadState *ts, const char *name, uint32_t inst_id,
     ProfilerPhase profiler(profiler_region_assemble_func);
 
     visited.clear();
+    visited_any.clear();
     schedule.clear();
 
     for (uint32_t i = 0; i < n_in; ++i) {
@@ -767,7 +1757,7 @@ jitc_assemble_func(ThreadState *ts, const char *name, uint32_t inst_id,
 
         const Variable *v = jitc_var(in[i]);
         if (!v->is_literal())
-            visited.emplace(1, in[i]);
+            visited.insert(in[i]);
     }
 
     auto traverse = [](uint32_t index) {
@@ -775,7 +1765,7 @@ jitc_assemble_func(ThreadState *ts, const char *name, uint32_t inst_id,
             return;
         jitc_var_traverse(1, index);
         Variable *v = jitc_var(index);
-        v->output_flag = (VarType) v->type != VarType::Void;
+        jitc_var_scratch(v)->output_flag = (VarType) v->type != VarType::Void;
     };
 
     for (uint32_t i = 0; i < n_out; ++i)
@@ -794,7 +1784,7 @@ jitc_assemble_func(ThreadState *ts, const char *name, uint32_t inst_id,
 
     for (auto &sv : schedule) {
         Variable *v = jitc_var(sv.index);
-        v->reg_index = n_regs++;
+        jitc_var_scratch(v)->reg_index = n_regs++;
     }
 
     size_t kernel_offset = buffer.size();
@@ -848,3 +1838,85 @@ void jitc_register_global(const char *str) {
                             GlobalValue(globals.size(), length)).second)
         globals.put(str, length);
 }
+
+/**
+ * Histograms and similar accumulations into small arrays contend heavily on
+ * the atomics of the target memory. When the scatter-reductions of a kernel
+ * ('Add' of 32-bit values) refer to targets with at most 'limit' bytes in
+ * total, the backends instead accumulate into memory that is local to a CUDA
+ * thread block (shared memory) or an LLVM work unit (stack), and flush the
+ * partial result once at the end using atomics. Targets that are also
+ * accessed in any other way are left alone.
+ */
+void jitc_private_scan(ScheduledGroup group, uint32_t limit) {
+    private_targets.clear();
+
+    if (uses_optix ||
+        !(jitc_flags() & (uint32_t) JitFlag::AtomicReduceLocal))
+        return;
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        const Variable *v = jitc_var(schedule[gi].index);
+        if (jitc_var_scratch(v)->elide)
+            continue;
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            if (!v->dep[i])
+                continue;
+
+            const Variable *ptr = jitc_var(v->dep[i]);
+            if (!ptr->is_literal() || (VarType) ptr->type != VarType::Pointer)
+                continue;
+
+            bool eligible = false;
+            if (i == 0 && (VarKind) v->kind == VarKind::Scatter &&
+                (ReduceOp) v->literal == ReduceOp::Add && ptr->dep[3]) {
+                VarType vt = (VarType) jitc_var(v->dep[1])->type;
+                eligible = vt == VarType::Float32 || vt == VarType::Int32 ||
+                           vt == VarType::UInt32;
+            }
+
+            PrivateTarget *target = nullptr;
+            for (PrivateTarget &pt : private_targets) {
+                if (pt.address == ptr->literal) {
+                    target = &pt;
+                    break;
+                }
+            }
+
+            if (!target) {
+                uint32_t count =
+                    ptr->dep[3] ? (uint32_t) std::min(jitc_var(ptr->dep[3])->size,
+                                                      (size_t) UINT32_MAX)
+                                : 0;
+                private_targets.push_back(PrivateTarget{
+                    ptr->literal, v->dep[i], ptr->dep[3], count, false });
+                target = &private_targets.back();
+            }
+
+            target->excluded |= !eligible;
+        }
+    }
+
+    /* Only worthwhile if the kernel performs many more scatters than there
+       are entries to flush at the end */
+    uint32_t total = 0;
+    size_t j = 0;
+    for (const PrivateTarget &pt : private_targets) {
+        if (pt.excluded || pt.count == 0 || pt.count > (limit - total) / 4 ||
+            group.size < 16ull * pt.count)
+            continue;
+        total += pt.count * 4;
+        private_targets[j++] = pt;
+    }
+
+    private_targets.resize(j);
+}
+
+int jitc_private_find(const Variable *ptr) {
+    for (size_t i = 0; i < private_targets.size(); ++i) {
+        if (private_targets[i].address == ptr->literal)
+            return (int) i;
+    }
+    return -1;
+}
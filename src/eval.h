@@ -15,23 +15,29 @@
 
 /// A single variable that is scheduled to execute for a launch with 'size' entries
 struct ScheduledVariable {
-    uint32_t size;
+    size_t size;
     uint32_t index;
     uint32_t scope;
+    uint32_t counter;
     void *data;
 
-    ScheduledVariable(uint32_t size, uint32_t scope, uint32_t index)
-        : size(size), index(index), scope(scope), data(nullptr) { }
+    ScheduledVariable(size_t size, uint32_t scope, uint32_t index,
+                      uint32_t counter)
+        : size(size), index(index), scope(scope), counter(counter),
+          data(nullptr) { }
 };
 
 /// Start and end index of a group of variables that will be merged into the same kernel
 struct ScheduledGroup {
-    uint32_t size;
+    size_t size;
     uint32_t start;
     uint32_t end;
 
-    ScheduledGroup(uint32_t size, uint32_t start, uint32_t end)
-        : size(size), start(start), end(end) { }
+    /// Does the kernel also produce scalar outputs? (see \ref JitFlag::KernelFusion)
+    bool scalar_outputs;
+
+    ScheduledGroup(size_t size, uint32_t start, uint32_t end)
+        : size(size), start(start), end(end), scalar_outputs(false) { }
 };
 
 struct GlobalKey {
@@ -52,6 +58,24 @@ struct GlobalKey {
     }
 };
 
+/// Target of a scatter-reduction that is accumulated block-locally
+struct PrivateTarget {
+    /// Address of the target array
+    uint64_t address;
+
+    /// Pointer variable referencing the target in the kernel being compiled
+    uint32_t ptr_index;
+
+    /// Variable that owns the target array
+    uint32_t target_index;
+
+    /// Number of entries of the target array
+    uint32_t count;
+
+    /// Is the address also accessed by other operations in the kernel?
+    bool excluded;
+};
+
 struct GlobalValue {
     /// Offset and length for the 'globals' buffer
     size_t start, length;
@@ -67,7 +91,7 @@ struct GlobalValue {
 using GlobalsMap = std::map<GlobalKey, GlobalValue>;
 
 /// StringBuffer for global definitions (intrinsics, callables, etc.)
-extern StringBuffer globals;
+extern thread_local StringBuffer globals;
 
 /// Mapping that describes the contents of the 'globals' buffer
 extern GlobalsMap globals_map;
@@ -78,6 +102,12 @@ extern char kernel_name[52];
 /// Are we recording an OptiX kernel?
 extern bool uses_optix;
 
+/// Work counter of a CUDA kernel with persistent threads (JitFlag::LoopPersistent)
+extern void *kernel_work_counter;
+
+/// Order in which a CUDA kernel processes its entries (JitFlag::VCallCoherent)
+extern const void *kernel_perm;
+
 /// Size and alignment of auxiliary buffer needed by virtual function calls
 extern int32_t alloca_size;
 extern int32_t alloca_align;
@@ -91,6 +121,9 @@ extern uint32_t callable_count_unique;
 /// Specifies the nesting level of virtual calls being compiled
 extern uint32_t callable_depth;
 
+/// Scatter-reduction targets that are privatized in the kernel being compiled
+extern std::vector<PrivateTarget> private_targets;
+
 /// Ordered list of variables that should be computed
 extern std::vector<ScheduledVariable> schedule;
 
@@ -134,5 +167,17 @@ jitc_llvm_assemble_func(const char *name, uint32_t inst_id,
                         uint32_t n_out, const uint32_t *out_nested,
                         bool use_self);
 
+/// Launch a compiled kernel (used by jitc_run() and frozen function replays)
+extern Task *jitc_launch_kernel(ThreadState *ts, const Kernel &kernel,
+                                size_t size, std::vector<void *> &params,
+                                CUstream stream, Task *const *deps,
+                                uint32_t dep_count);
+
+/// Detect scatter-reductions of 'group' into small targets (see PrivateTarget)
+extern void jitc_private_scan(ScheduledGroup group, uint32_t limit);
+
+/// Return the index of the privatized target referenced by 'ptr', or -1
+extern int jitc_private_find(const Variable *ptr);
+
 /// Register a global declaration that will be included in the final program
 extern void jitc_register_global(const char *str);
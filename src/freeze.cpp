@@ -0,0 +1,366 @@
+/*
+    src/freeze.cpp -- Record a sequence of kernel launches and replay it later
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+
+    A frozen function stores the kernels that were launched between
+    jit_freeze_begin() and jit_freeze_end(), along with a description of how
+    their parameters relate to the function inputs and to the arrays created
+    by earlier kernels of the recording. Replaying it skips tracing, code
+    generation, and kernel cache lookups entirely: it only allocates memory
+    and submits the recorded kernels in their original order.
+*/
+
+#include "freeze.h"
+#include "eval.h"
+#include "var.h"
+#include "log.h"
+#include "malloc.h"
+#include "llvm.h"
+
+/// Memory region created by one of the recorded kernels
+struct FrozenSlot {
+    VarType type;
+    size_t size;
+    AllocType atype;
+    size_t dsize;
+};
+
+/// Describes how to compute a kernel parameter during a replay
+struct FrozenParam {
+    enum class Kind : uint32_t { Input, Slot, Constant } kind;
+    uint32_t index;
+    void *value;
+};
+
+/// A single recorded kernel launch
+struct FrozenKernel {
+    /// Key of the (pinned) kernel cache entry
+    KernelKey key;
+    Kernel kernel;
+    size_t size;
+    std::vector<FrozenParam> params;
+};
+
+struct FrozenFunction {
+    JitBackend backend;
+
+    /// Variable indices of the inputs (only valid while recording)
+    std::vector<uint32_t> inputs;
+
+    /// Expected types and sizes of the inputs
+    std::vector<VarType> input_types;
+    std::vector<size_t> input_sizes;
+
+    /// Memory regions allocated by the recorded kernels
+    std::vector<FrozenSlot> slots;
+
+    /// Recorded kernel launches
+    std::vector<FrozenKernel> kernels;
+
+    /// Origin of each output (an input or a slot)
+    std::vector<FrozenParam> outputs;
+
+    /// Only used while recording: maps data pointers to inputs and slots
+    tsl::robin_map<uintptr_t, uint32_t, UInt64Hasher> input_map, slot_map;
+
+    /// Set when the recording contains an operation that cannot be replayed
+    const char *error = nullptr;
+};
+
+/// Number of leading kernel parameters that are recomputed at launch time
+static uint32_t jitc_freeze_reserved(JitBackend backend) {
+    return backend == JitBackend::CUDA ? 1 : 4;
+}
+
+void jitc_freeze_begin(JitBackend backend, uint32_t n_inputs,
+                       const uint32_t *inputs) {
+    ThreadState *ts = thread_state(backend);
+    if (unlikely(ts->freeze))
+        jitc_raise("jit_freeze_begin(): a recording is already in progress!");
+
+    // Evaluate inputs so that the recording only refers to memory regions
+    for (uint32_t i = 0; i < n_inputs; ++i)
+        jitc_var_eval(inputs[i]);
+
+    FrozenFunction *f = new FrozenFunction();
+    f->backend = backend;
+
+    for (uint32_t i = 0; i < n_inputs; ++i) {
+        uint32_t index = inputs[i];
+        const Variable *v = jitc_var(index);
+
+        if (unlikely((JitBackend) v->backend != backend || !v->is_data())) {
+            for (uint32_t j : f->inputs)
+                jitc_var_dec_ref(j);
+            delete f;
+            jitc_raise("jit_freeze_begin(): input r%u must be an evaluated "
+                       "array of the selected backend!", index);
+        }
+
+        // Hold a reference so that the memory region cannot be reused
+        jitc_var_inc_ref(index);
+        f->inputs.push_back(index);
+        f->input_types.push_back((VarType) v->type);
+        f->input_sizes.push_back(v->size);
+        f->input_map[(uintptr_t) v->data] = i;
+    }
+
+    ts->freeze = f;
+    jitc_log(Debug, "jit_freeze_begin(): recording with %u input%s.",
+             n_inputs, n_inputs == 1 ? "" : "s");
+}
+
+/// Unpin the kernels of a frozen function and delete it
+static void jitc_freeze_release(FrozenFunction *f) {
+    for (FrozenKernel &fk : f->kernels) {
+        auto it = state.kernel_cache.find(fk.key);
+        if (it != state.kernel_cache.end())
+            it.value().pins--;
+    }
+    delete f;
+}
+
+void jitc_freeze_record(ThreadState *ts, const ScheduledGroup &group,
+                        const KernelKey &key, const Kernel &kernel,
+                        const std::vector<void *> &params,
+                        bool params_global) {
+    FrozenFunction *f = ts->freeze;
+    if (f->error)
+        return;
+
+    if (params_global) {
+        f->error = "kernels that pass their parameters through global memory "
+                   "(OptiX, or too many arrays) cannot be replayed";
+        return;
+    }
+
+    // Register the arrays created by this kernel
+    for (uint32_t i = group.start; i != group.end; ++i) {
+        const ScheduledVariable &sv = schedule[i];
+        if (!sv.data)
+            continue;
+
+        const Variable *v = jitc_var(sv.index);
+        size_t isize = (size_t) type_size[v->type],
+               dsize = (size_t) v->size * isize;
+
+        if (ts->backend == JitBackend::LLVM && isize < 4)
+            dsize += 4 - isize;
+
+        FrozenSlot slot;
+        slot.type = (VarType) v->type;
+        slot.size = v->size; // Differs from 'group.size' for scalar outputs
+        slot.atype = jitc_malloc_var_type(ts->backend);
+        slot.dsize = dsize;
+
+        // Memory may be recycled within a recording: the latest one wins
+        f->slot_map[(uintptr_t) sv.data] = (uint32_t) f->slots.size();
+        f->slots.push_back(slot);
+    }
+
+    // Pin the kernel so that it is not evicted from the kernel cache
+    auto it_k = state.kernel_cache.find(key);
+    if (unlikely(it_k == state.kernel_cache.end())) {
+        f->error = "a kernel is missing from the kernel cache";
+        return;
+    }
+
+    FrozenKernel fk { it_k->first, kernel, group.size, { } };
+
+    for (size_t i = jitc_freeze_reserved(ts->backend); i < params.size(); ++i) {
+        uintptr_t ptr = (uintptr_t) params[i];
+        FrozenParam p { FrozenParam::Kind::Constant, 0, params[i] };
+
+        auto it = f->slot_map.find(ptr);
+        if (it != f->slot_map.end()) {
+            p.kind = FrozenParam::Kind::Slot;
+            p.index = it->second;
+        } else if ((it = f->input_map.find(ptr)) != f->input_map.end()) {
+            p.kind = FrozenParam::Kind::Input;
+            p.index = it->second;
+        } else if (state.alloc_used.find(ptr) != state.alloc_used.end()) {
+            // Any other Dr.Jit allocation would be stale during a replay
+            f->error = "a kernel accesses an array that is neither an input "
+                       "nor computed within the recording";
+            return;
+        }
+
+        fk.params.push_back(p);
+    }
+
+    it_k.value().pins++;
+    f->kernels.push_back(std::move(fk));
+}
+
+FrozenFunction *jitc_freeze_end(JitBackend backend, uint32_t n_outputs,
+                                const uint32_t *outputs) {
+    ThreadState *ts = thread_state(backend);
+    FrozenFunction *f = ts->freeze;
+    if (unlikely(!f))
+        jitc_raise("jit_freeze_end(): no recording in progress!");
+
+    const char *error = nullptr;
+    try {
+        for (uint32_t i = 0; i < n_outputs; ++i)
+            jitc_var_eval(outputs[i]);
+    } catch (...) {
+        error = "evaluation of the outputs failed";
+    }
+
+    ts->freeze = nullptr;
+
+    for (uint32_t i = 0; !error && i < n_outputs; ++i) {
+        const Variable *v = jitc_var(outputs[i]);
+        uintptr_t ptr = (uintptr_t) v->data;
+        FrozenParam p { FrozenParam::Kind::Constant, 0, nullptr };
+
+        auto it = f->slot_map.find(ptr);
+        if (v->is_data() && it != f->slot_map.end()) {
+            p.kind = FrozenParam::Kind::Slot;
+            p.index = it->second;
+        } else if (v->is_data() &&
+                   (it = f->input_map.find(ptr)) != f->input_map.end()) {
+            p.kind = FrozenParam::Kind::Input;
+            p.index = it->second;
+        } else {
+            error = "an output was not computed by the recorded kernels";
+            break;
+        }
+
+        f->outputs.push_back(p);
+    }
+
+    for (uint32_t index : f->inputs)
+        jitc_var_dec_ref(index);
+    f->inputs.clear();
+    f->input_map.clear();
+    f->slot_map.clear();
+
+    if (!error)
+        error = f->error;
+
+    if (unlikely(error)) {
+        jitc_freeze_release(f);
+        jitc_raise("jit_freeze_end(): the recorded function cannot be "
+                   "frozen: %s.", error);
+    }
+
+    state.frozen_functions++;
+    jitc_log(Debug,
+             "jit_freeze_end(): recorded %zu kernel%s, %zu intermediate "
+             "array%s, %u output%s.",
+             f->kernels.size(), f->kernels.size() == 1 ? "" : "s",
+             f->slots.size(), f->slots.size() == 1 ? "" : "s", n_outputs,
+             n_outputs == 1 ? "" : "s");
+
+    return f;
+}
+
+void jitc_freeze_replay(FrozenFunction *f, const uint32_t *inputs,
+                        uint32_t *outputs) {
+    JitBackend backend = f->backend;
+    ThreadState *ts = thread_state(backend);
+
+    if (unlikely(ts->freeze))
+        jitc_raise("jit_freeze_replay(): cannot replay while recording!");
+
+    uint32_t n_inputs = (uint32_t) f->input_types.size();
+    std::vector<void *> input_ptrs(n_inputs);
+
+    for (uint32_t i = 0; i < n_inputs; ++i)
+        jitc_var_eval(inputs[i]);
+
+    for (uint32_t i = 0; i < n_inputs; ++i) {
+        const Variable *v = jitc_var(inputs[i]);
+        if (unlikely((JitBackend) v->backend != backend || !v->is_data() ||
+                     (VarType) v->type != f->input_types[i] ||
+                     v->size != f->input_sizes[i]))
+            jitc_raise("jit_freeze_replay(): input %u (r%u) does not match "
+                       "the recording (expected an array of type %s and "
+                       "size %zu)!", i, inputs[i],
+                       type_name[(int) f->input_types[i]], f->input_sizes[i]);
+        input_ptrs[i] = v->data;
+    }
+
+    std::vector<void *> slot_ptrs(f->slots.size());
+    for (size_t i = 0; i < f->slots.size(); ++i)
+        slot_ptrs[i] = jitc_malloc(f->slots[i].atype, f->slots[i].dsize);
+
+    uint32_t reserved = jitc_freeze_reserved(backend);
+    std::vector<void *> params;
+
+    for (const FrozenKernel &fk : f->kernels) {
+        params.clear();
+        if (backend == JitBackend::CUDA)
+            params.push_back((void *) (uintptr_t) (uint32_t) fk.size);
+        else
+            params.resize(reserved, nullptr);
+
+        for (const FrozenParam &p : fk.params) {
+            switch (p.kind) {
+                case FrozenParam::Kind::Input:
+                    params.push_back(input_ptrs[p.index]);
+                    break;
+                case FrozenParam::Kind::Slot:
+                    params.push_back(slot_ptrs[p.index]);
+                    break;
+                default:
+                    params.push_back(p.value);
+                    break;
+            }
+        }
+
+        if (backend == JitBackend::CUDA) {
+            jitc_launch_kernel(ts, fk.kernel, fk.size, params, ts->stream,
+                               nullptr, 0);
+        } else {
+            Task *task = jitc_launch_kernel(ts, fk.kernel, fk.size, params,
+                                            nullptr, &jitc_task, 1);
+            task_release(jitc_task);
+            jitc_task = task;
+        }
+
+        state.kernel_launches++;
+    }
+
+    // Wrap slots that are returned to the caller, release the others
+    std::vector<uint32_t> slot_index(f->slots.size(), 0);
+    for (size_t i = 0; i < f->outputs.size(); ++i) {
+        const FrozenParam &p = f->outputs[i];
+        uint32_t index;
+
+        if (p.kind == FrozenParam::Kind::Input) {
+            index = inputs[p.index];
+            jitc_var_inc_ref(index);
+        } else if (slot_index[p.index]) {
+            index = slot_index[p.index];
+            jitc_var_inc_ref(index);
+        } else {
+            const FrozenSlot &slot = f->slots[p.index];
+            index = jitc_var_mem_map(backend, slot.type, slot_ptrs[p.index],
+                                     slot.size, 1);
+            slot_index[p.index] = index;
+        }
+
+        outputs[i] = index;
+    }
+
+    for (size_t i = 0; i < f->slots.size(); ++i) {
+        if (!slot_index[i])
+            jitc_free(slot_ptrs[i]);
+    }
+
+    jitc_log(Debug, "jit_freeze_replay(): launched %zu kernel%s.",
+             f->kernels.size(), f->kernels.size() == 1 ? "" : "s");
+}
+
+void jitc_freeze_destroy(FrozenFunction *f) {
+    if (!f)
+        return;
+    state.frozen_functions--;
+    jitc_freeze_release(f);
+}
@@ -0,0 +1,35 @@
+/*
+    src/freeze.h -- Record a sequence of kernel launches and replay it later
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+struct ScheduledGroup;
+
+/// Begin recording the kernels launched by the current thread
+extern void jitc_freeze_begin(JitBackend backend, uint32_t n_inputs,
+                              const uint32_t *inputs);
+
+/// Stop recording and return a handle to the frozen function
+extern FrozenFunction *jitc_freeze_end(JitBackend backend, uint32_t n_outputs,
+                                       const uint32_t *outputs);
+
+/// Replay a frozen function with new inputs
+extern void jitc_freeze_replay(FrozenFunction *f, const uint32_t *inputs,
+                               uint32_t *outputs);
+
+/// Release a frozen function
+extern void jitc_freeze_destroy(FrozenFunction *f);
+
+/// Used by jitc_run() to record a kernel launch
+extern void jitc_freeze_record(ThreadState *ts, const ScheduledGroup &group,
+                               const KernelKey &key, const Kernel &kernel,
+                               const std::vector<void *> &params,
+                               bool params_global);
@@ -106,7 +106,16 @@ inline size_t hash_str(const char *str) {
     return hash(str, strlen(str));
 }
 
-inline XXH128_hash_t hash_kernel(const char *str) {
+/**
+ * Hash the body of a kernel, skipping its prologue (parameter declarations,
+ * register counts, etc.). Set 'full' to also cover the prologue, which is
+ * needed when cache lookups trust the hash (\ref JitFlag::KernelHashOnly).
+ */
+inline XXH128_hash_t hash_kernel(const char *str, size_t size,
+                                 bool full = false) {
+    if (full)
+        return XXH128(str, size, 0);
+
     const char *offset = strstr(str, "body:");
     if (unlikely(!offset)) {
         offset = strchr(str, '{');
@@ -114,5 +123,9 @@ inline XXH128_hash_t hash_kernel(const char *str) {
             jitc_fail("hash_kernel(): invalid input!");
     }
 
-    return XXH128(offset, strlen(offset), 0);
+    return XXH128(offset, size - (size_t) (offset - str), 0);
+}
+
+inline XXH128_hash_t hash_kernel(const char *str) {
+    return hash_kernel(str, strlen(str));
 }
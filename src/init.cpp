@@ -13,7 +13,9 @@
 #include "log.h"
 #include "registry.h"
 #include "var.h"
+#include "vcall.h"
 #include "profiler.h"
+#include "stats.h"
 #include <sys/stat.h>
 
 #if defined(DRJIT_ENABLE_OPTIX)
@@ -52,12 +54,16 @@ __itt_domain *drjit_domain = __itt_domain_create("drjit");
 #endif
 
 static_assert(
-    sizeof(VariableKey) == 9 * sizeof(uint32_t),
+    sizeof(VariableKey) == 10 * sizeof(uint32_t),
     "VariableKey: incorrect size, likely an issue with padding/packing!");
 
 static_assert(
-    sizeof(tsl::detail_robin_hash::bucket_entry<VariableMap::value_type, false>) == 64,
-    "VariableMap: incorrect bucket size, likely an issue with padding/packing!");
+    sizeof(Variable) == 13 * sizeof(uint32_t),
+    "Variable: incorrect size, likely an issue with padding/packing!");
+
+static_assert(
+    sizeof(VariableScratch) == 3 * sizeof(uint32_t),
+    "VariableScratch: incorrect size, likely an issue with padding/packing!");
 
 static ProfilerRegion profiler_region_init("jit_init");
 
@@ -128,11 +134,12 @@ void jitc_init(uint32_t backends) {
     if ((backends & (uint32_t) JitBackend::CUDA) && jitc_cuda_init())
         state.backends |= (uint32_t) JitBackend::CUDA;
 
-    state.variable_index = 1;
+    state.variable_counter = 1;
     state.variable_watermark = 0;
 
     state.kernel_hard_misses = state.kernel_soft_misses = 0;
     state.kernel_hits = state.kernel_launches = 0;
+    state.kernel_evictions = state.kernel_disk_evictions = 0;
 }
 
 void* jitc_cuda_stream() {
@@ -155,6 +162,8 @@ void* jitc_cuda_pop_context() {
 
 /// Release all resources used by the JIT compiler, and report reference leaks.
 void jitc_shutdown(int light) {
+    jitc_kernel_cache_prefetch_wait();
+
     // Synchronize with everything
     for (ThreadState *ts : state.tss) {
         if (ts->backend == JitBackend::CUDA) {
@@ -175,6 +184,9 @@ void jitc_shutdown(int light) {
         }
     }
 
+    jitc_llvm_tier_shutdown();
+    jitc_vcall_shutdown();
+
     if (!state.kernel_cache.empty()) {
         jitc_log(Info, "jit_shutdown(): releasing %zu kernel%s ..",
                 state.kernel_cache.size(),
@@ -186,9 +198,12 @@ void jitc_shutdown(int light) {
         }
 
         state.kernel_cache.clear();
+        state.kernel_cache_size = 0;
     }
 
     state.kernel_history.clear();
+    jitc_kernel_stats_clear();
+    jitc_sync_profile_clear();
 
     // CUDA: Try to already free some memory asynchronously (faster)
     if (thread_state_cuda && thread_state_cuda->memory_pool) {
@@ -242,13 +257,19 @@ void jitc_shutdown(int light) {
                 free(ts->prefix);
             }
 
+            if (ts->graph_exec) {
+                scoped_set_context guard(ts->context);
+                cuda_check(cuGraphExecDestroy(ts->graph_exec));
+            }
+
+            jitc_temp_release(ts);
             delete ts;
         }
 
-        if (state.variables.empty() && !state.lvn_map.empty()) {
+        if (jitc_var_count() == 0 && !state.lvn_map.empty()) {
             for (auto &kv: state.lvn_map)
                 jitc_log(Warn,
-                        " - id=%u: size=%u, type=%s, dep=[%u, "
+                        " - id=%u: size=%zu, type=%s, dep=[%u, "
                         "%u, %u, %u]",
                         kv.second, kv.first.size, type_name[kv.first.type],
                         kv.first.dep[0], kv.first.dep[1], kv.first.dep[2],
@@ -267,24 +288,27 @@ void jitc_shutdown(int light) {
 
     if (std::max(state.log_level_stderr, state.log_level_callback) >= LogLevel::Warn) {
         uint32_t n_leaked = 0;
-        for (auto &var : state.variables) {
+        for (uint32_t index = 1; index < (uint32_t) state.variables.size(); ++index) {
+            const Variable &var = state.variables[index];
+            if (var.is_unused())
+                continue;
             if (n_leaked == 0)
                 jitc_log(Warn, "jit_shutdown(): detected variable leaks:");
             if (n_leaked < 10)
                 jitc_log(Warn,
                          " - variable r%u is still being referenced! "
-                         "(ref=%u, ref_se=%u, type=%s, size=%u, "
-                         "stmt=\"%s\", dep=[%u, %u, %u, %u])",
-                         var.first,
-                         (uint32_t) var.second.ref_count,
-                         (uint32_t) var.second.ref_count_se,
-                         type_name[var.second.type],
-                         var.second.size,
-                         var.second.is_literal()
+                         "(ref=%u, ref_se=%u, type=%s, size=%zu, "
+                         "kind=%s, dep=[%u, %u, %u, %u])",
+                         index,
+                         (uint32_t) var.ref_count,
+                         (uint32_t) var.ref_count_se,
+                         type_name[var.type],
+                         var.size,
+                         var.is_literal()
                              ? "<value>"
-                             : (var.second.stmt ? var.second.stmt : "<null>"),
-                         var.second.dep[0], var.second.dep[1],
-                         var.second.dep[2], var.second.dep[3]);
+                             : var_kind_name[var.kind],
+                         var.dep[0], var.dep[1],
+                         var.dep[2], var.dep[3]);
             else if (n_leaked == 10)
                 jitc_log(Warn, " - (skipping remainder)");
             ++n_leaked;
@@ -293,7 +317,7 @@ void jitc_shutdown(int light) {
         if (n_leaked > 0)
             jitc_log(Warn, "jit_shutdown(): %u variables are still referenced!", n_leaked);
 
-        if (state.variables.empty() && !state.extra.empty()) {
+        if (n_leaked == 0 && !state.extra.empty()) {
             jitc_log(Warn,
                     "jit_shutdown(): %zu 'extra' records were not cleaned up:",
                     state.extra.size());
@@ -308,6 +332,13 @@ void jitc_shutdown(int light) {
         }
     }
 
+    // Release the variable storage unless there are leaks
+    if (jitc_var_count() == 0) {
+        VariableVector().swap(state.variables);
+        std::vector<VariableScratch>().swap(state.variables_scratch);
+        std::vector<uint32_t>().swap(state.unused_variables);
+    }
+
     jitc_registry_shutdown();
     jitc_malloc_shutdown();
 
@@ -321,6 +352,10 @@ void jitc_shutdown(int light) {
 #endif
     }
 
+    /* Close the disk cache */ {
+        lock_guard guard(state.kernel_cache_lock);
+        jitc_kernel_cache_close();
+    }
     free(jitc_temp_path);
     jitc_temp_path = nullptr;
 
@@ -380,6 +415,7 @@ ThreadState *jitc_init_thread_state(JitBackend backend) {
         }
 
         Device &device = state.devices[0];
+        jitc_cuda_load_builtins(device);
         ts->device = 0;
         ts->context = device.context;
         ts->compute_capability = device.compute_capability;
@@ -426,11 +462,26 @@ void jitc_cuda_set_device(int device_id) {
 
     jitc_log(Info, "jit_cuda_set_device(%i)", device_id);
 
+    jitc_cuda_bind_device(ts, device_id, true);
+}
+
+void jitc_cuda_bind_device(ThreadState *ts, int device_id, bool order) {
+    if (ts->device == device_id)
+        return;
+
+    if (unlikely(ts->graph_capture))
+        jitc_raise("jit_cuda_set_device(): cannot switch devices while the "
+                   "stream is being captured (see jit_cuda_graph_begin())!");
+
     Device &device = state.devices[device_id];
+    jitc_cuda_load_builtins(device);
 
-    if (ts->stream) {
+    /* Instead of waiting on the host, let the new stream wait for the work
+       submitted to the previous one. This keeps other devices busy. */
+    if (order && ts->stream) {
         scoped_set_context guard(ts->context);
-        cuda_check(cuStreamSynchronize(ts->stream));
+        cuda_check(cuEventRecord(ts->event, ts->stream));
+        cuda_check(cuStreamWaitEvent(device.stream, ts->event, 0));
     }
 
     /* Associate with new context */ {
@@ -448,23 +499,27 @@ void jitc_sync_thread(ThreadState *ts) {
     if (!ts)
         return;
     if (ts->backend == JitBackend::CUDA) {
+        if (unlikely(ts->graph_capture))
+            jitc_raise("jit_sync_thread(): cannot synchronize while the "
+                       "stream is being captured (see jit_cuda_graph_begin())!");
         scoped_set_context guard(ts->context);
         CUstream stream = ts->stream;
         unlock_guard guard_2(state.lock);
         cuda_check(cuStreamSynchronize(stream));
     } else {
         Task *task = jitc_task;
-        if (!task)
-            return;
-        {
+        uint32_t evals = jitc_llvm_tier_evals_done();
+        if (task) {
             unlock_guard guard(state.lock);
             task_wait(task);
         }
         // Clear 'jitc_task' if no work was added in the meantime
-        if (task == jitc_task) {
+        if (task && task == jitc_task) {
             jitc_task = nullptr;
             task_release(task);
         }
+        // Superseded kernels (JitFlag::TieredCompile) are no longer running
+        jitc_llvm_tier_release(evals);
     }
 }
 
@@ -630,7 +685,8 @@ void *jitc_find_library(const char *fname, const char *glob_pat,
 }
 
 void jitc_set_flags(uint32_t flags) {
-    pool_set_profile(int(flags & (uint32_t) JitFlag::KernelHistory));
+    pool_set_profile(int((flags & ((uint32_t) JitFlag::KernelHistory |
+                                   (uint32_t) JitFlag::KernelStats)) != 0));
     jitc_flags_v = flags;
 }
 
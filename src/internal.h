@@ -15,7 +15,9 @@
 #include "llvm.h"
 #include "alloc.h"
 #include "io.h"
+#include "kernel_stats.h"
 #include <deque>
+#include <atomic>
 #include <string.h>
 #include <inttypes.h>
 #include <nanothread/nanothread.h>
@@ -23,9 +25,34 @@
 /// Number of entries to process per work unit in the parallel LLVM backend
 #define DRJIT_POOL_BLOCK_SIZE 16384
 
+/// Smallest work unit of an LLVM kernel launch (see jitc_llvm_block_size())
+#define DRJIT_POOL_BLOCK_SIZE_MIN 1024
+
 /// Can't pass more than 4096 bytes of parameter data to a CUDA kernel
 #define DRJIT_CUDA_ARG_LIMIT 512
 
+/// .. or 32764 bytes with CUDA 12.1+ on Volta and newer (see jitc_cuda_arg_limit())
+#define DRJIT_CUDA_ARG_LIMIT_LARGE 4095
+
+/// Number of auxiliary streams per device used by JitFlag::ParallelStreams
+#define DRJIT_CUDA_STREAM_COUNT 4
+
+/// Chunk size and number of pinned staging buffers of host->device migrations
+#define DRJIT_MIGRATE_CHUNK_SIZE (8 * 1024 * 1024)
+#define DRJIT_MIGRATE_RING_SIZE 3
+
+/// Min. size of async. host<->device copies that are issued on the copy stream
+#define DRJIT_COPY_STREAM_THRESHOLD (1024 * 1024)
+
+/// Max. estimated extra work of moving a scalar kernel into another one
+#define DRJIT_FUSION_WORK_LIMIT (1024 * 1024)
+
+/// Max. total size of scatter-reduction targets accumulated in shared memory (CUDA) ..
+#define DRJIT_PRIVATE_LIMIT_CUDA (16 * 1024)
+
+/// .. or in a stack buffer of each work unit (LLVM, see jitc_private_scan())
+#define DRJIT_PRIVATE_LIMIT_LLVM (4 * 1024)
+
 #define DRJIT_PTR "<0x%" PRIxPTR ">"
 
 enum VarKind : uint32_t {
@@ -35,9 +62,6 @@ enum VarKind : uint32_t {
     // An evaluated node representing data
     Data,
 
-    // Legacy string-based IR statement
-    Stmt,
-
     // A literal constant
     // (note: this must be the last enumeration entry before the regular nodes start)
     Literal,
@@ -117,10 +141,28 @@ enum VarKind : uint32_t {
     // Extract a component from an operation that produced multiple results
     Extract,
 
+    // Copy of another variable that must remain a separate register
+    Copy,
+
+    // Phi node of a loop state variable (LLVM), see \ref LoopPhiType
+    LoopPhi,
+
     // Denotes the number of different node types
     Count
 };
 
+/// Variants of the \ref VarKind::LoopPhi node, stored in 'Variable::literal'
+enum class LoopPhiType : uint32_t {
+    // Loop header, the back edge provides the register suffixed with '_final'
+    Header,
+
+    // Loop header of a loop-invariant variable (the back edge is the node itself)
+    HeaderInvariant,
+
+    // Beginning of the loop body, reached from the loop condition
+    Body
+};
+
 #pragma pack(push, 1)
 
 /// Central variable data structure, which represents an assignment in SSA form
@@ -172,20 +214,14 @@ struct Variable {
 
         /// Pointer to device memory. Used when kind == VarKind::Data
         void *data;
-
-        // Legacy string-based IR (to be removed)
-        char *stmt;
     };
 
     /// Number of entries
-    uint32_t size;
-
-    /// Unused, to be eventually used to upgrade to 64 bit array sizes
-    uint32_t unused;
+    size_t size;
 
     // ================  Essential flags used in the LVN key  =================
 
-    // Variable kind (IR statement / literal constant / data)
+    // Variable kind (IR node / literal constant / data)
     uint32_t kind : 8;
 
     /// Backend associated with this variable
@@ -197,9 +233,6 @@ struct Variable {
     /// Is this a pointer variable that is used to write to some array?
     uint32_t write_ptr : 1;
 
-    /// Free the 'stmt' variables at destruction time?
-    uint32_t free_stmt : 1;
-
     // =======================  Miscellaneous fields =========================
 
     /// If set, 'data' will not be deallocated when the variable is destructed
@@ -223,84 +256,105 @@ struct Variable {
     /// If set, evaluation will have side effects on other variables
     uint32_t side_effect : 1;
 
-    // =========== Entries that are temporarily used in jitc_eval() ============
-
-    /// Argument type
-    uint32_t param_type : 2;
-
-    /// Is this variable marked as an output?
-    uint32_t output_flag : 1;
-
     /// Consumed bit for operations that should only be executed once
     uint32_t consumed : 1;
 
     /// Unused for now
-    uint32_t unused_2 : 5;
-
-    /// Offset of the argument in the list of kernel parameters
-    uint32_t param_offset;
-
-    /// Register index
-    uint32_t reg_index;
+    uint32_t unused_2 : 9;
 
     // ========================  Side effect tracking  =========================
 
     /// Number of queued side effects
     uint32_t ref_count_se;
 
+    /// Creation counter, distinguishes reused variable indices (see \ref WeakRef)
+    uint32_t counter;
+
     // =========================   Helper functions   ==========================
 
     bool is_data()    const { return kind == (uint32_t) VarKind::Data;    }
     bool is_literal() const { return kind == (uint32_t) VarKind::Literal; }
-    bool is_stmt()    const { return kind == (uint32_t) VarKind::Stmt;    }
     bool is_node()    const { return (uint32_t) kind > VarKind::Literal; }
     bool is_dirty()   const { return ref_count_se > 0; }
+
+    /// Unused entries of 'State::variables' have an invalid backend
+    bool is_unused()  const { return backend == (uint32_t) JitBackend::Invalid; }
+};
+
+/**
+ * \brief Reference to a variable that does not keep it alive
+ *
+ * The index of a variable is recycled once it is freed. A weak reference also
+ * records the variable's creation counter so that it is not mistaken for a
+ * newer variable at the same index. Use \ref jitc_var(WeakRef) to resolve it.
+ */
+struct WeakRef {
+    uint32_t index = 0;
+    uint32_t counter = 0;
+
+    WeakRef() = default;
+    WeakRef(uint32_t index, uint32_t counter) : index(index), counter(counter) { }
+};
+
+/**
+ * \brief Entries of a variable that are only temporarily used in jitc_eval()
+ *
+ * They are stored in 'State::variables_scratch' at the same index as the
+ * associated entry of 'State::variables', which keeps the latter compact
+ * during tracing and graph traversal. Use \ref jitc_var_scratch() to access
+ * them.
+ */
+struct VariableScratch {
+    /// Offset of the argument in the list of kernel parameters
+    uint32_t param_offset;
+
+    /// Register index
+    uint32_t reg_index;
+
+    /// Argument type
+    uint32_t param_type : 2;
+
+    /// Is this variable marked as an output?
+    uint32_t output_flag : 1;
+
+    /// Skip code generation (computed by another variable, or unused)
+    uint32_t elide : 1;
+
+    /// Pass this literal through a kernel parameter (JitFlag::LiteralParams)
+    uint32_t literal_param : 1;
+
+    /// Unused for now
+    uint32_t unused : 27;
 };
 
 /// Abbreviated version of the Variable data structure
 struct VariableKey {
-    uint32_t size;
+    size_t size;
     uint32_t scope;
     uint32_t dep[4];
     uint32_t kind      : 8;
     uint32_t backend   : 2;
     uint32_t type      : 4;
     uint32_t write_ptr : 1;
-    uint32_t free_stmt : 1;
-    uint32_t unused    : 16;
-
-    union {
-        uint64_t literal;
-        char *stmt;
-    };
+    uint32_t unused    : 17;
+    uint64_t literal;
 
     VariableKey(const Variable &v) {
         size = v.size;
         scope = v.scope;
         for (int i = 0; i < 4; ++i)
             dep[i] = v.dep[i];
-        if (v.is_stmt())
-            stmt = v.stmt;
-        else
-            literal = v.literal;
-
+        literal = v.literal;
         kind = v.kind;
         backend = v.backend;
         type = v.type;
         write_ptr = v.write_ptr;
-        free_stmt = v.free_stmt;
         unused = 0;
     }
 
     bool operator==(const VariableKey &v) const {
-        if (memcmp(this, &v, 7 * sizeof(uint32_t)) != 0)
-            return false;
-        if ((VarKind) kind != VarKind::Stmt)
-            return literal == v.literal;
-        else if (!free_stmt)
-            return stmt == v.stmt;
-        else
-            return stmt == v.stmt || strcmp(stmt, v.stmt) == 0;
+        return memcmp(this, &v, 8 * sizeof(uint32_t)) == 0 &&
+               literal == v.literal;
     }
 };
 
@@ -309,18 +363,10 @@ struct VariableKey {
 /// Helper class to hash VariableKey instances
 struct VariableKeyHasher {
     size_t operator()(const VariableKey &k) const {
-        uint64_t hash_1;
-        if ((VarKind) k.kind != VarKind::Stmt)
-            hash_1 = k.literal;
-        else if (!k.free_stmt)
-            hash_1 = (uintptr_t) k.stmt;
-        else
-            hash_1 = hash_str(k.stmt);
-
-        uint32_t buf[7];
-        size_t size = 7 * sizeof(uint32_t);
+        uint32_t buf[8];
+        size_t size = 8 * sizeof(uint32_t);
         memcpy(buf, &k, size);
-        return hash(buf, size, hash_1);
+        return hash(buf, size, k.literal);
     }
 };
 
@@ -342,6 +388,22 @@ struct Device {
     /// A CUDA event for synchronization purposes
     CUevent event = nullptr;
 
+    /// Auxiliary streams for concurrent kernel launches (created on demand)
+    CUstream aux_stream[DRJIT_CUDA_STREAM_COUNT] { };
+
+    /// Events that order kernels launched on the auxiliary streams
+    std::vector<CUevent> aux_events;
+
+    /// Copy stream of host->device migrations (created on demand)
+    CUstream copy_stream = nullptr;
+
+    /// Orders the copy stream relative to the main stream and vice versa
+    CUevent copy_event = nullptr;
+
+    /// Ring of pinned staging buffers used by migrations, with one event each
+    void *copy_ring[DRJIT_MIGRATE_RING_SIZE] { };
+    CUevent copy_ring_event[DRJIT_MIGRATE_RING_SIZE] { };
+
     /// CUDA device ID
     int id;
 
@@ -360,6 +422,12 @@ struct Device {
     // Support for stream-ordered memory allocations (async alloc/free)
     bool memory_pool;
 
+    /// Support for reserving/mapping virtual memory (jit_malloc_reserve())
+    bool virtual_memory;
+
+    /// Support for prefetching managed memory (jit_malloc_prefetch())
+    bool managed_prefetch;
+
     /** \brief If preemptable is false, long-running kernels might freeze
      * the OS GUI and time out after 2 sec */
     bool preemptable;
@@ -434,7 +502,11 @@ struct OptixPipelineData {
 };
 #endif
 
+struct FrozenFunction;
+
 /// Represents a single stream of a parallel communication
+struct TempArena;
+
 struct ThreadState {
     /// Backend type
     JitBackend backend;
@@ -443,7 +515,7 @@ struct ThreadState {
      * List of variables that are scheduled for evaluation (via
      * jitc_var_schedule()) that will take place at the next call to jitc_eval().
      */
-    std::vector<uint32_t> scheduled;
+    std::vector<WeakRef> scheduled;
 
     /**
      * List of special variables of type VarType::Void, whose evaluation will
@@ -487,6 +559,20 @@ struct ThreadState {
     /// A CUDA event for synchronization purposes
     CUevent event = nullptr;
 
+    /// Is the stream currently being captured into a CUDA graph?
+    bool graph_capture = false;
+
+    /// Executable graph of the last capture (updated in place when possible)
+    CUgraphExec graph_exec = nullptr;
+
+    /// ----------------------------------------------------------------------
+
+    /// Arena for temporaries needed by jitc_eval() (see jitc_temp_malloc())
+    TempArena *temp_arena = nullptr;
+
+    /// Frozen function being recorded by this thread (if any)
+    FrozenFunction *freeze = nullptr;
+
     /**
      * \brief DrJit device ID associated with this device
      *
@@ -513,30 +599,41 @@ struct ThreadState {
 #endif
 };
 
-/// Maps from variable ID to a Variable instance
-using VariableMap =
-    tsl::robin_map<uint32_t, Variable, UInt32Hasher,
-                   std::equal_to<uint32_t>,
-                   aligned_allocator<std::pair<uint32_t, Variable>, 64>,
-                   /* StoreHash = */ false>;
-
-/// Key data structure for kernel source code & device ID
+/// Dense storage of all variables, addressed by their index
+using VariableVector = std::vector<Variable, aligned_allocator<Variable, 64>>;
+
+/**
+ * \brief Key data structure for kernel source code & device ID
+ *
+ * The key carries the 128-bit hash and length of the source code, which are
+ * compared before falling back to a full comparison of the source. When
+ * 'hash_only' is set (see \ref JitFlag::KernelHashOnly), matching hashes are
+ * trusted and the source is not compared at all.
+ */
 struct KernelKey {
     char *str = nullptr;
+    size_t size = 0;
+    XXH128_hash_t hash { 0, 0 };
     int device = 0;
     uint64_t flags = 0;
+    bool hash_only = false;
 
-    KernelKey(char *str, int device, uint64_t flags) : str(str), device(device), flags(flags) { }
+    KernelKey(char *str, size_t size, XXH128_hash_t hash, int device,
+              uint64_t flags, bool hash_only = false)
+        : str(str), size(size), hash(hash), device(device), flags(flags),
+          hash_only(hash_only) { }
 
     bool operator==(const KernelKey &k) const {
-        return strcmp(k.str, str) == 0 && device == k.device && flags == k.flags;
+        return hash.high64 == k.hash.high64 && hash.low64 == k.hash.low64 &&
+               size == k.size && device == k.device && flags == k.flags &&
+               (hash_only || k.hash_only || memcmp(k.str, str, size) == 0);
     }
 };
 
 /// Helper class to hash KernelKey instances
 struct KernelHash {
     size_t operator()(const KernelKey &k) const {
-        return compute_hash(hash_kernel(k.str).high64, k.device, k.flags);
+        return compute_hash(k.hash.high64, k.device, k.flags);
     }
 
     static size_t compute_hash(size_t kernel_hash, int device, uint64_t flags) {
@@ -567,24 +664,72 @@ private:
     size_t m_capacity;
 };
 
-// Key associated with a pointer registered in DrJit's pointer registry
+/**
+ * Key associated with a pointer registered in DrJit's pointer registry. The
+ * domain string must be interned (see \ref RegistryDomain), which permits
+ * comparing it by address.
+ */
 struct RegistryKey {
     const char *domain;
     uint32_t id;
     RegistryKey(const char *domain, uint32_t id) : domain(domain), id(id) { }
 
     bool operator==(const RegistryKey &k) const {
-        return id == k.id && strcmp(domain, k.domain) == 0;
+        return id == k.id && domain == k.domain;
     }
 
     /// Helper class to hash RegistryKey instances
     struct Hasher {
         size_t operator()(const RegistryKey &k) const {
-            return hash_str(k.domain, k.id);
+            size_t result = UInt64Hasher()((uint64_t) (uintptr_t) k.domain);
+            hash_combine(result, k.id);
+            return result;
         }
     };
 };
 
+/// Dense array mapping the IDs of a registry domain to pointers
+struct RegistryTable {
+    uint32_t size = 0;
+    std::unique_ptr<std::atomic<void *>[]> ptr;
+};
+
+/// Open-addressing hash table mapping registered pointers to IDs
+struct RegistryRevTable {
+    struct Entry {
+        std::atomic<const void *> ptr { nullptr };
+        /// Zero once the pointer was removed from the registry
+        std::atomic<uint32_t> id { 0 };
+    };
+
+    /// Number of entries (a power of two)
+    uint32_t capacity = 0;
+    /// Number of entries that are occupied (including removed pointers)
+    uint32_t used = 0;
+    std::unique_ptr<Entry[]> entries;
+};
+
+/// Attribute buffer of a registry domain (read without holding the lock)
+struct RegistryAttr {
+    char *name = nullptr;
+    std::atomic<void *> ptr { nullptr };
+    RegistryAttr *next = nullptr;
+};
+
+/**
+ * \brief Interned registry domain
+ *
+ * Records are created by \c jitc_registry_put() and persist until the
+ * registry shuts down. They form a linked list that is only ever extended at
+ * the front, hence readers can traverse it without acquiring 'state.lock'.
+ */
+struct RegistryDomain {
+    char *name = nullptr;
+    std::atomic<RegistryTable *> table { nullptr };
+    std::atomic<RegistryAttr *> attrs { nullptr };
+    RegistryDomain *next = nullptr;
+};
+
 struct AttributeKey {
     const char *domain;
     const char *name;
@@ -607,6 +752,12 @@ struct AttributeValue {
     uint32_t isize = 0;
     uint32_t count = 0;
     void *ptr = nullptr;
+
+    /// CUDA: host copy of 'ptr', whose changes are uploaded in batches
+    void *host = nullptr;
+
+    /// CUDA: ID ranges [start, end) of 'host' that still need to be uploaded
+    std::vector<std::pair<uint32_t, uint32_t>> dirty;
 };
 
 struct Registry {
@@ -630,6 +781,15 @@ struct Registry {
 
     /// Per-pointer attributes provided by the pointer registry
     AttributeMap attributes;
+
+    /// Interned domains with dense lookup tables (lock-free reads)
+    std::atomic<RegistryDomain *> domains { nullptr };
+
+    /// Reverse lookup table (lock-free reads)
+    std::atomic<RegistryRevTable *> rev_table { nullptr };
+
+    /// Are there attribute changes that haven't been uploaded yet?
+    std::atomic<bool> dirty { false };
 };
 
 struct Extra {
@@ -657,14 +817,43 @@ using ExtraMap = tsl::robin_map<uint32_t, Extra, UInt32Hasher>;
 
 /// Records the full JIT compiler state (most frequently two used entries at top)
 struct State {
-    /// Must be held to access members
+    /**
+     * \brief Must be held to access members
+     *
+     * This lock covers the variable table, the in-memory kernel cache and
+     * most of the allocator. \ref jitc_run() releases it while the backend
+     * compiles a kernel and while the disk cache is accessed. The variable
+     * table and the code generation state ('buffer', the schedule, the
+     * globals map) remain under this lock and 'eval_lock', respectively.
+     */
     Lock lock;
 
     /// Must be held to access 'state.alloc_free'
     Lock alloc_free_lock;
 
-    /// Stores the mapping from variable indices to variables
-    VariableMap variables;
+    /**
+     * \brief Must be held to access the disk kernel cache (see io.cpp)
+     *
+     * Also protects the 'kernel_cache_max_disk_*', 'kernel_cache_codec',
+     * 'kernel_cache_level', and 'kernel_disk_evictions' members. It may be
+     * acquired while holding 'lock', but not the other way around.
+     */
+    Lock kernel_cache_lock;
+
+    /**
+     * \brief Stores all variables, addressed by their index
+     *
+     * Entry 0 is never used. Freed entries are marked via \ref
+     * Variable::is_unused() and their indices are recycled via
+     * 'unused_variables'.
+     */
+    VariableVector variables;
+
+    /// Indices of unused entries of 'variables' (most recently freed at the end)
+    std::vector<uint32_t> unused_variables;
+
+    /// Eval-temporary entries of 'variables', see \ref VariableScratch
+    std::vector<VariableScratch> variables_scratch;
 
     /// Counter to create variable scopes that enforce a variable ordering
     uint32_t scope_ctr = 0;
@@ -702,19 +891,50 @@ struct State {
     /// Map of currently unused memory regions
     AllocInfoMap alloc_free;
 
+    /// Allocation profiler (only active with JitFlag::MallocProfile)
+    AllocProfile alloc_profile;
+
+    /// Growable device allocations created by jitc_malloc_reserve()
+    AllocGrowableMap alloc_growable;
+
+    /// Released growable allocations awaiting jitc_flush_malloc_cache()
+    std::vector<std::pair<void *, AllocGrowable>> alloc_growable_free;
+
     /// Keep track of current memory usage and a maximum watermark
     size_t alloc_usage    [(int) AllocType::Count] { 0 },
            alloc_allocated[(int) AllocType::Count] { 0 },
            alloc_watermark[(int) AllocType::Count] { 0 };
 
+    /// Bytes requested by live allocations. The difference to 'alloc_usage'
+    /// is internal fragmentation due to size classes.
+    size_t alloc_requested[(int) AllocType::Count] { 0 };
+
+    /// Page size policy for large host allocations (jit_set_huge_page_policy())
+#if defined(__linux__)
+    HugePagePolicy huge_page_policy = HugePagePolicy::Explicit;
+#else
+    HugePagePolicy huge_page_policy = HugePagePolicy::Disabled;
+#endif
+    size_t huge_page_threshold = 2 * 1024 * 1024;
+
+    /// Soft limits on 'alloc_allocated' (0 = unlimited)
+    size_t alloc_limit[(int) AllocType::Count] { 0 };
+
+    /// Application callback invoked when memory runs low
+    MemoryPressureCallback alloc_pressure_callback = nullptr;
+    void *alloc_pressure_payload = nullptr;
+
+    /// Output size that triggers warnings (see jit_set_eval_memory_warning())
+    size_t eval_memory_warning = 0;
+
     /// Keep track of the number of created JIT variables
     uint32_t variable_watermark = 0;
 
     /// Maps from variable ID to extra information for a fraction of variables
     ExtraMap extra;
 
-    /// Current variable index
-    uint32_t variable_index = 1;
+    /// Creation counter of the next variable (see \ref Variable::counter)
+    uint32_t variable_counter = 1;
 
     /// Limit the output of jit_var_str()?
     uint32_t print_limit = 20;
@@ -724,13 +944,35 @@ struct State {
     size_t kernel_soft_misses = 0;
     size_t kernel_hits = 0;
     size_t kernel_launches = 0;
+    size_t kernel_evictions = 0;
+    size_t kernel_disk_evictions = 0;
 
     /// Cache of previously compiled kernels
     KernelCache kernel_cache;
 
+    /// Number of frozen functions referencing kernels of 'kernel_cache'
+    uint32_t frozen_functions = 0;
+
+    /// Total size of the kernels in 'kernel_cache' (binaries and sources)
+    size_t kernel_cache_size = 0;
+
+    /// Counter used to order kernels by their last launch
+    uint64_t kernel_cache_timestamp = 0;
+
+    /// Limits of the in-memory and disk kernel caches (0 = unlimited)
+    size_t kernel_cache_max_size = 0, kernel_cache_max_disk_size = 0;
+    uint32_t kernel_cache_max_entries = 0, kernel_cache_max_disk_entries = 0;
+
+    /// Codec and level (0 = default) for compressing disk cache entries
+    KernelCacheCodec kernel_cache_codec = KernelCacheCodec::LZ4;
+    int kernel_cache_level = 0;
+
     /// Kernel launch history
     KernelHistory kernel_history = KernelHistory();
 
+    /// Aggregated kernel statistics (only active with JitFlag::KernelStats)
+    KernelStats kernel_stats;
+
 #if defined(DRJIT_ENABLE_OPTIX)
     /// Default OptiX pipeline for testcases etc.
     OptixPipelineData *optix_default_pipeline = nullptr;
@@ -748,12 +990,14 @@ struct State {
     State() {
         lock_init(lock);
         lock_init(alloc_free_lock);
+        lock_init(kernel_cache_lock);
         lock_init(eval_lock);
     }
 
     ~State() {
         lock_destroy(lock);
         lock_destroy(alloc_free_lock);
+        lock_destroy(kernel_cache_lock);
         lock_destroy(eval_lock);
     }
 };
@@ -784,6 +1028,11 @@ inline ThreadState *thread_state(uint32_t backend) {
 
 extern State state;
 
+/// Access the eval-temporary entries of a variable stored in 'state.variables'
+inline VariableScratch *jitc_var_scratch(const Variable *v) {
+    return &state.variables_scratch[(size_t) (v - state.variables.data())];
+}
+
 #if !defined(_WIN32)
   extern char *jitc_temp_path;
 #else
@@ -799,6 +1048,21 @@ extern void jitc_shutdown(int light);
 /// Set the currently active device & stream
 extern void jitc_cuda_set_device(int device);
 
+/**
+ * \brief Associate a thread state with another device (without logging or
+ * synchronizing on the host)
+ *
+ * When \c order is set, work submitted to the new device's stream waits for
+ * the work that was previously submitted to the thread's stream.
+ */
+extern void jitc_cuda_bind_device(ThreadState *ts, int device, bool order);
+
+/// Maximum number of parameters passed directly to a kernel on this device
+extern uint32_t jitc_cuda_arg_limit(const ThreadState *ts);
+
+/// Load the builtin kernels of a device unless this was already done
+extern void jitc_cuda_load_builtins(const Device &device);
+
 /// Wait for all computation on the current stream to finish
 extern void jitc_sync_thread();
 
@@ -876,6 +1140,7 @@ inline bool jitc_is_float(VarType type) {
            type == VarType::Float64;
 }
 
+inline bool jitc_is_half(VarType type) { return type == VarType::Float16; }
 inline bool jitc_is_single(VarType type) { return type == VarType::Float32; }
 inline bool jitc_is_double(VarType type) { return type == VarType::Float64; }
 inline bool jitc_is_bool(VarType type) { return type == VarType::Bool; }
@@ -904,6 +1169,7 @@ inline bool jitc_is_void(VarType type) {
 
 inline bool jitc_is_arithmetic(const Variable *v) { return jitc_is_arithmetic((VarType) v->type); }
 inline bool jitc_is_float(const Variable *v) { return jitc_is_float((VarType) v->type); }
+inline bool jitc_is_half(const Variable *v) { return jitc_is_half((VarType) v->type); }
 inline bool jitc_is_single(const Variable *v) { return jitc_is_single((VarType) v->type); }
 inline bool jitc_is_double(const Variable *v) { return jitc_is_double((VarType) v->type); }
 inline bool jitc_is_sint(const Variable *v) { return jitc_is_sint((VarType) v->type); }
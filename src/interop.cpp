@@ -0,0 +1,406 @@
+/*
+    src/interop.cpp -- Zero-copy exchange of memory with other frameworks/APIs
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+
+    Memory is shared with frameworks such as PyTorch or JAX via DLPack tensors,
+    and with graphics APIs (Vulkan, D3D12) via the external memory interface
+    of the CUDA driver. In both cases, the accesses of the two parties are
+    ordered using events or semaphores on their CUDA streams, which avoids
+    synchronizing the device at the framework boundary.
+*/
+
+#include "internal.h"
+#include "interop.h"
+#include "var.h"
+#include "log.h"
+
+// Stable ABI of DLPack (dlpack/dlpack.h, version 0.x)
+struct DLDevice { int32_t device_type; int32_t device_id; };
+struct DLDataType { uint8_t code; uint8_t bits; uint16_t lanes; };
+
+struct DLTensor {
+    void *data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t *shape;
+    int64_t *strides;
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void *manager_ctx;
+    void (*deleter)(DLManagedTensor *self);
+};
+
+enum { kDLCPU = 1, kDLCUDA = 2, kDLCUDAHost = 3, kDLCUDAManaged = 13 };
+enum { kDLInt = 0, kDLUInt = 1, kDLFloat = 2, kDLBool = 6 };
+
+/// Tensor created by jitc_var_dlpack_export()
+struct DLPackExport {
+    DLManagedTensor tensor;
+    int64_t shape[1];
+    uint32_t index;
+};
+
+/// Memory imported by jitc_cuda_external_memory_import()
+struct ExternalMemory {
+    CUexternalMemory handle;
+    CUdeviceptr ptr;
+};
+
+/// Raise an exception if a CUDA call for external resources failed
+static void jitc_cuda_interop_check(const char *func, CUresult rv) {
+    if (rv == CUDA_SUCCESS)
+        return;
+
+    const char *name = nullptr;
+    cuGetErrorName(rv, &name);
+    jitc_raise("%s(): CUDA API error %i (%s)!", func, (int) rv,
+               name ? name : "unknown");
+}
+
+static void jitc_cuda_interop_require(const char *func) {
+#if defined(DRJIT_DYNAMIC_CUDA)
+    if (!cuImportExternalMemory)
+        jitc_raise("%s(): the CUDA driver does not support the external "
+                   "memory and semaphore API!", func);
+#else
+    (void) func;
+#endif
+}
+
+/// Make 'target' wait for the work previously submitted to 'source'
+static void jitc_cuda_stream_order(CUstream source, CUstream target) {
+    CUevent event;
+    cuda_check(cuEventCreate(&event, CU_EVENT_DISABLE_TIMING));
+    cuda_check(cuEventRecord(event, source));
+    cuda_check(cuStreamWaitEvent(target, event, 0));
+    cuda_check(cuEventDestroy(event));
+}
+
+void jitc_cuda_stream_wait(void *stream) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    if ((CUstream) stream == ts->stream)
+        return;
+
+    scoped_set_context guard(ts->context);
+    jitc_cuda_stream_order((CUstream) stream, ts->stream);
+}
+
+void jitc_cuda_stream_signal(void *stream) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    if ((CUstream) stream == ts->stream)
+        return;
+
+    scoped_set_context guard(ts->context);
+    jitc_cuda_stream_order(ts->stream, (CUstream) stream);
+}
+
+void *jitc_cuda_external_memory_import(int handle_type, void *handle,
+                                       size_t size, int dedicated,
+                                       void **ptr) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    jitc_cuda_interop_require("jit_cuda_external_memory_import");
+
+    CUDA_EXTERNAL_MEMORY_HANDLE_DESC desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.type = (decltype(desc.type)) handle_type;
+    if (handle_type == 1 /* CU_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD */)
+        desc.handle.fd = (int) (intptr_t) handle;
+    else
+        desc.handle.win32.handle = handle;
+    desc.size = (unsigned long long) size;
+    desc.flags = dedicated ? CUDA_EXTERNAL_MEMORY_DEDICATED : 0;
+
+    CUDA_EXTERNAL_MEMORY_BUFFER_DESC buffer_desc;
+    memset(&buffer_desc, 0, sizeof(buffer_desc));
+    buffer_desc.size = (unsigned long long) size;
+
+    scoped_set_context guard(ts->context);
+    ExternalMemory *memory = new ExternalMemory();
+    CUresult rv = cuImportExternalMemory(&memory->handle, &desc);
+    if (rv == CUDA_SUCCESS) {
+        rv = cuExternalMemoryGetMappedBuffer(&memory->ptr, memory->handle,
+                                             &buffer_desc);
+        if (rv != CUDA_SUCCESS)
+            cuDestroyExternalMemory(memory->handle);
+    }
+
+    if (rv != CUDA_SUCCESS) {
+        delete memory;
+        jitc_cuda_interop_check("jit_cuda_external_memory_import", rv);
+    }
+
+    jitc_log(Debug, "jit_cuda_external_memory_import(): mapped %s to " DRJIT_PTR,
+             jitc_mem_string(size), (uintptr_t) memory->ptr);
+
+    *ptr = (void *) memory->ptr;
+    return memory;
+}
+
+void jitc_cuda_external_memory_destroy(void *memory_) {
+    if (!memory_)
+        return;
+
+    ExternalMemory *memory = (ExternalMemory *) memory_;
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+
+    // Kernels of Dr.Jit may still access the memory region
+    jitc_sync_thread(ts);
+
+    /* Unmap and release */ {
+        scoped_set_context guard(ts->context);
+        cuda_check(cuMemFree(memory->ptr));
+        cuda_check(cuDestroyExternalMemory(memory->handle));
+    }
+
+    delete memory;
+}
+
+void *jitc_cuda_external_semaphore_import(int handle_type, void *handle) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    jitc_cuda_interop_require("jit_cuda_external_semaphore_import");
+
+    CUDA_EXTERNAL_SEMAPHORE_HANDLE_DESC desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.type = (decltype(desc.type)) handle_type;
+    if (handle_type == 1 /* CU_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD */ ||
+        handle_type == 9 /* .. TIMELINE_SEMAPHORE_FD */)
+        desc.handle.fd = (int) (intptr_t) handle;
+    else
+        desc.handle.win32.handle = handle;
+
+    scoped_set_context guard(ts->context);
+    CUexternalSemaphore semaphore = nullptr;
+    jitc_cuda_interop_check("jit_cuda_external_semaphore_import",
+                            cuImportExternalSemaphore(&semaphore, &desc));
+    return (void *) semaphore;
+}
+
+void jitc_cuda_external_semaphore_wait(void *semaphore, uint64_t value) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    CUexternalSemaphore sem = (CUexternalSemaphore) semaphore;
+
+    CUDA_EXTERNAL_SEMAPHORE_WAIT_PARAMS params;
+    memset(&params, 0, sizeof(params));
+    params.params.fence.value = (unsigned long long) value;
+
+    scoped_set_context guard(ts->context);
+    jitc_cuda_interop_check(
+        "jit_cuda_external_semaphore_wait",
+        cuWaitExternalSemaphoresAsync(&sem, &params, 1, ts->stream));
+}
+
+void jitc_cuda_external_semaphore_signal(void *semaphore, uint64_t value) {
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    CUexternalSemaphore sem = (CUexternalSemaphore) semaphore;
+
+    CUDA_EXTERNAL_SEMAPHORE_SIGNAL_PARAMS params;
+    memset(&params, 0, sizeof(params));
+    params.params.fence.value = (unsigned long long) value;
+
+    scoped_set_context guard(ts->context);
+    jitc_cuda_interop_check(
+        "jit_cuda_external_semaphore_signal",
+        cuSignalExternalSemaphoresAsync(&sem, &params, 1, ts->stream));
+}
+
+void jitc_cuda_external_semaphore_destroy(void *semaphore) {
+    if (!semaphore)
+        return;
+
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    jitc_sync_thread(ts);
+
+    scoped_set_context guard(ts->context);
+    cuda_check(cuDestroyExternalSemaphore((CUexternalSemaphore) semaphore));
+}
+
+/// Map a DLPack data type to a Dr.Jit variable type
+static VarType jitc_dlpack_type(DLDataType dtype) {
+    if (dtype.lanes == 1) {
+        switch (dtype.code) {
+            case kDLBool:
+                if (dtype.bits == 8) return VarType::Bool;
+                break;
+
+            case kDLInt:
+                switch (dtype.bits) {
+                    case 8:  return VarType::Int8;
+                    case 16: return VarType::Int16;
+                    case 32: return VarType::Int32;
+                    case 64: return VarType::Int64;
+                }
+                break;
+
+            case kDLUInt:
+                switch (dtype.bits) {
+                    case 8:  return VarType::UInt8;
+                    case 16: return VarType::UInt16;
+                    case 32: return VarType::UInt32;
+                    case 64: return VarType::UInt64;
+                }
+                break;
+
+            case kDLFloat:
+                switch (dtype.bits) {
+                    case 16: return VarType::Float16;
+                    case 32: return VarType::Float32;
+                    case 64: return VarType::Float64;
+                }
+                break;
+        }
+    }
+
+    jitc_raise("jit_var_dlpack_import(): unsupported data type (code %u, "
+               "%u bits, %u lanes)!", (uint32_t) dtype.code,
+               (uint32_t) dtype.bits, (uint32_t) dtype.lanes);
+}
+
+static void jitc_var_dlpack_callback(uint32_t, int free, void *payload) {
+    if (free) {
+        DLManagedTensor *tensor = (DLManagedTensor *) payload;
+        if (tensor->deleter)
+            tensor->deleter(tensor);
+    }
+}
+
+uint32_t jitc_var_dlpack_import(DLManagedTensor *tensor, void *stream) {
+    const DLTensor &t = tensor->dl_tensor;
+
+    JitBackend backend;
+    switch (t.device.device_type) {
+        case kDLCPU:
+        case kDLCUDAHost:
+            backend = JitBackend::LLVM;
+            break;
+
+        case kDLCUDA:
+        case kDLCUDAManaged:
+            backend = JitBackend::CUDA;
+            break;
+
+        default:
+            jitc_raise("jit_var_dlpack_import(): unsupported device type %i!",
+                       (int) t.device.device_type);
+    }
+
+    VarType type = jitc_dlpack_type(t.dtype);
+
+    // Only C-contiguous tensors can be represented by a flat array
+    size_t size = 1;
+    int64_t expected_stride = 1;
+    for (int32_t i = t.ndim - 1; i >= 0; --i) {
+        if (t.strides && t.shape[i] != 1 && t.strides[i] != expected_stride)
+            jitc_raise("jit_var_dlpack_import(): the tensor must be "
+                       "C-contiguous!");
+        expected_stride *= t.shape[i];
+        size *= (size_t) t.shape[i];
+    }
+
+    if (backend == JitBackend::CUDA) {
+        ThreadState *ts = thread_state(backend);
+        int device = state.devices[ts->device].id;
+        if (t.device.device_type == kDLCUDA && t.device.device_id != device)
+            jitc_raise("jit_var_dlpack_import(): the tensor is located on "
+                       "CUDA device %i, while the current device is %i!",
+                       (int) t.device.device_id, device);
+        if (stream)
+            jitc_cuda_stream_wait(stream);
+    }
+
+    void *ptr = (uint8_t *) t.data + t.byte_offset;
+    uint32_t index = jitc_var_mem_map(backend, type, ptr, size, 0);
+
+    if (!index) {
+        jitc_var_dlpack_callback(0, 1, tensor);
+        return 0;
+    }
+
+    jitc_var_set_callback(index, jitc_var_dlpack_callback, tensor);
+
+    jitc_log(Debug, "jit_var_dlpack_import(): created r%u (%zu entries)",
+             index, size);
+
+    return index;
+}
+
+static void jitc_var_dlpack_deleter(DLManagedTensor *tensor) {
+    DLPackExport *e = (DLPackExport *) tensor->manager_ctx;
+    jit_var_dec_ref(e->index);
+    delete e;
+}
+
+DLManagedTensor *jitc_var_dlpack_export(uint32_t index, void *stream) {
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+
+    DLDataType dtype;
+    dtype.lanes = 1;
+    dtype.bits = (uint8_t) (type_size[(int) type] * 8);
+    switch (type) {
+        case VarType::Bool:
+            dtype.code = kDLBool;
+            break;
+
+        case VarType::Int8:
+        case VarType::Int16:
+        case VarType::Int32:
+        case VarType::Int64:
+            dtype.code = kDLInt;
+            break;
+
+        case VarType::UInt8:
+        case VarType::UInt16:
+        case VarType::UInt32:
+        case VarType::UInt64:
+            dtype.code = kDLUInt;
+            break;
+
+        case VarType::Float16:
+        case VarType::Float32:
+        case VarType::Float64:
+            dtype.code = kDLFloat;
+            break;
+
+        default:
+            jitc_raise("jit_var_dlpack_export(r%u): unsupported variable type!",
+                       index);
+    }
+
+    void *ptr = jitc_var_ptr(index);
+    v = jitc_var(index);
+
+    DLPackExport *e = new DLPackExport();
+    DLTensor &t = e->tensor.dl_tensor;
+    t.data = ptr;
+    t.ndim = 1;
+    t.dtype = dtype;
+    t.shape = e->shape;
+    t.strides = nullptr;
+    t.byte_offset = 0;
+    e->shape[0] = (int64_t) v->size;
+    e->index = index;
+    e->tensor.manager_ctx = e;
+    e->tensor.deleter = jitc_var_dlpack_deleter;
+
+    ThreadState *ts = thread_state(backend);
+    if (backend == JitBackend::CUDA) {
+        t.device = { kDLCUDA, state.devices[ts->device].id };
+        jitc_cuda_stream_signal(stream);
+    } else {
+        t.device = { kDLCPU, 0 };
+        jitc_sync_thread(ts);
+    }
+
+    jitc_var_inc_ref(index);
+
+    return &e->tensor;
+}
@@ -0,0 +1,42 @@
+/*
+    src/interop.h -- Zero-copy exchange of memory with other frameworks/APIs
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <drjit-core/jit.h>
+
+/// Order the current thread's stream after the work submitted to 'stream'
+extern void jitc_cuda_stream_wait(void *stream);
+
+/// Order 'stream' after the work submitted to the current thread's stream
+extern void jitc_cuda_stream_signal(void *stream);
+
+/// Import memory of another API and map it into the address space
+extern void *jitc_cuda_external_memory_import(int handle_type, void *handle,
+                                              size_t size, int dedicated,
+                                              void **ptr);
+
+/// Release memory imported using jitc_cuda_external_memory_import()
+extern void jitc_cuda_external_memory_destroy(void *memory);
+
+/// Import a semaphore of another API
+extern void *jitc_cuda_external_semaphore_import(int handle_type, void *handle);
+
+/// Wait for/signal an external semaphore on the current thread's stream
+extern void jitc_cuda_external_semaphore_wait(void *semaphore, uint64_t value);
+extern void jitc_cuda_external_semaphore_signal(void *semaphore, uint64_t value);
+
+/// Release a semaphore imported using jitc_cuda_external_semaphore_import()
+extern void jitc_cuda_external_semaphore_destroy(void *semaphore);
+
+/// Create a variable referring to the memory of a DLPack tensor
+extern uint32_t jitc_var_dlpack_import(DLManagedTensor *tensor, void *stream);
+
+/// Export a variable as a DLPack tensor
+extern DLManagedTensor *jitc_var_dlpack_export(uint32_t index, void *stream);
@@ -19,31 +19,47 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <lz4.h>
+#include <lz4hc.h>
+#include <algorithm>
 
 #if defined(_WIN32)
 #  include <windows.h>
 #else
 #  include <unistd.h>
 #  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <time.h>
 #endif
 
 /// Version number for cache files
-#define DRJIT_CACHE_VERSION 5
-
-// Uncomment to write out training data for creating a compression dictionary
-// #define DRJIT_CACHE_TRAIN 1
+#define DRJIT_CACHE_VERSION 7
 
 #pragma pack(push)
 #pragma pack(1)
 struct CacheFileHeader {
     uint8_t version;
+    /// Compression codec (a 'KernelCacheCodec' value)
+    uint8_t codec;
+    /// Identifies the dictionary used for compression (0: builtin)
+    uint32_t dict_id;
     uint32_t compressed_size;
     uint32_t source_size;
     uint32_t kernel_size;
     uint32_t reloc_size;
+    /// Tuned launch configuration of CUDA kernels (see jitc_kernel_cache_tune())
+    uint32_t launch_config;
 };
 #pragma pack(pop)
 
+/// Encode the tuned launch configuration of a kernel
+static uint32_t jitc_kernel_launch_config(JitBackend backend,
+                                          const Kernel &kernel) {
+    if (backend != JitBackend::CUDA)
+        return 0;
+    return (uint32_t) kernel.cuda.tuned_threads |
+           ((uint32_t) kernel.cuda.tuned_blocks_per_sm << 16);
+}
+
 char jitc_lz4_dict[jitc_lz4_dict_size];
 static bool jitc_lz4_dict_ready = false;
 
@@ -63,6 +79,23 @@ void jitc_lz4_init() {
     jitc_lz4_dict_ready = true;
 }
 
+/// Dictionary for compressing cache entries (defaults to 'jitc_lz4_dict')
+static char *jitc_cache_dict = nullptr;
+static uint32_t jitc_cache_dict_size = 0;
+static uint32_t jitc_cache_dict_id = 0;
+
+/// Directory receiving training data for new dictionaries (if set)
+static char *jitc_cache_train_path = nullptr;
+
+static void jitc_cache_dict_init() {
+    jitc_lz4_init();
+    if (!jitc_cache_dict) {
+        jitc_cache_dict = jitc_lz4_dict;
+        jitc_cache_dict_size = jitc_lz4_dict_size;
+        jitc_cache_dict_id = 0;
+    }
+}
+
 /* Computes padding to align cache file content to a multiple of sizeof(void*).
    This prevents undefiend behavior due to misaligned memory reads/writes. */
 static uint32_t compute_padding(const CacheFileHeader &header) {
@@ -72,90 +105,578 @@ static uint32_t compute_padding(const CacheFileHeader &header) {
     return padding_size;
 }
 
-bool jitc_kernel_load(const char *source, uint32_t source_size,
-                      JitBackend backend, XXH128_hash_t hash, Kernel &kernel) {
-    jitc_lz4_init();
-
 #if !defined(_WIN32)
+/* The kernel cache is stored in a single append-only database file per cache
+   directory. It begins with a 'CacheDBHeader' followed by a sequence of
+   records, each consisting of a 'CacheDBRecord' and the LZ4-compressed
+   payload (source, kernel, relocations) padded to a multiple of 8 bytes.
+   Uncompressed LLVM records are preceded by padding that places the machine
+   code at a page boundary, so that it can be mapped directly.
+
+   The file is memory-mapped, and an in-memory index maps kernel hashes to
+   record offsets. Processes serialize appends using an exclusive advisory
+   lock (which also works on NFS), and readers take a shared lock while
+   indexing new records.
+
+   When the database exceeds its size limits, the writer holding the lock
+   copies the most recently used records into a new file that atomically
+   replaces the old one. Other processes notice this the next time they lock
+   the database and reopen it. */
+
+#define DRJIT_CACHE_DB_MAGIC "DRJITDB"
+#define DRJIT_CACHE_DB_LAYOUT 5
+#define DRJIT_CACHE_DB_RECORD_MAGIC 0x4452434Bu
+
+struct CacheDBHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t layout;
+};
+
+struct CacheDBRecord {
+    uint32_t magic;
+    uint32_t backend;
+    uint64_t hash_high;
+    uint64_t hash_low;
+    /// Time of the last load in seconds since the epoch (for LRU eviction)
+    uint64_t last_use;
+    uint32_t codec;
+    uint32_t dict_id;
+    uint32_t compressed_size;
+    uint32_t source_size;
+    uint32_t kernel_size;
+    uint32_t reloc_size;
+    /// Updated in place when a kernel has been tuned
+    uint32_t launch_config;
+    /// Number of bytes between the record and its payload
+    uint32_t padding;
+};
+
+static_assert(sizeof(CacheDBHeader) % 8 == 0 && sizeof(CacheDBRecord) % 8 == 0,
+              "Kernel cache database records must be 8-byte aligned!");
+
+struct CacheDBKey {
+    uint64_t high64, low64;
+    uint32_t backend;
+
+    bool operator==(const CacheDBKey &k) const {
+        return high64 == k.high64 && low64 == k.low64 && backend == k.backend;
+    }
+};
+
+struct CacheDBKeyHasher {
+    size_t operator()(const CacheDBKey &k) const {
+        size_t hash = (size_t) k.high64;
+        hash_combine(hash, (size_t) k.low64 + k.backend);
+        return hash;
+    }
+};
+
+struct CacheDB {
+    /// Was the filename initialized? Did opening the database fail?
+    bool init = false, disabled = false;
+
+    /// Can records be appended? Was the header checked? Is the file damaged?
+    bool writable = false, validated = false, corrupt = false;
+
+    /// File descriptor and read-only mapping of the database
+    int fd = -1;
+    const uint8_t *map = nullptr;
+    size_t map_size = 0;
+
+    /// Offset of the first record that has not been indexed yet
+    size_t scan_end = sizeof(CacheDBHeader);
+
+    /// Maps kernel hashes to record offsets
+    tsl::robin_map<CacheDBKey, size_t, CacheDBKeyHasher> index;
+
     char filename[512];
-    if (unlikely(snprintf(filename, sizeof(filename), "%s/%016llx%016llx.%s.bin",
-                          jitc_temp_path, (unsigned long long) hash.high64,
-                          (unsigned long long) hash.low64,
-                          backend == JitBackend::CUDA ? "cuda" : "llvm") < 0))
-        jitc_fail("jit_kernel_load(): scratch space for filename insufficient!");
+};
+
+static CacheDB cache_db;
+
+static size_t jitc_cache_db_align(size_t size) {
+    return (size + 7) & ~(size_t) 7;
+}
+
+static size_t jitc_cache_db_record_size(const CacheDBRecord *r) {
+    return sizeof(CacheDBRecord) +
+           jitc_cache_db_align((size_t) r->padding + r->compressed_size);
+}
+
+static CacheDBHeader jitc_cache_db_header() {
+    CacheDBHeader header;
+    memset(&header, 0, sizeof(CacheDBHeader));
+    memcpy(header.magic, DRJIT_CACHE_DB_MAGIC, sizeof(DRJIT_CACHE_DB_MAGIC));
+    header.version = DRJIT_CACHE_VERSION;
+    header.layout = DRJIT_CACHE_DB_LAYOUT;
+    return header;
+}
+
+/// Write a memory region at the given offset, retrying as needed
+static bool jitc_cache_db_write(int fd, const void *data, size_t size,
+                                size_t offset, const char *filename) {
+    const uint8_t *ptr = (const uint8_t *) data;
+    while (size > 0) {
+        ssize_t n_written = pwrite(fd, ptr, size, (off_t) offset);
+        if (n_written <= 0) {
+            if (errno == EINTR)
+                continue;
+            jitc_log(Warn,
+                     "jit_kernel_write(): I/O error while writing compiled "
+                     "kernel to \"%s\": %s", filename, strerror(errno));
+            return false;
+        }
+        ptr += n_written;
+        offset += (size_t) n_written;
+        size -= (size_t) n_written;
+    }
+    return true;
+}
+
+/// Acquire (F_RDLCK, F_WRLCK) or release (F_UNLCK) the advisory file lock
+static bool jitc_cache_db_lock(short type) {
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = type;
+    fl.l_whence = SEEK_SET;
+
+    while (fcntl(cache_db.fd, F_SETLKW, &fl) == -1) {
+        if (errno != EINTR) {
+            jitc_log(Warn, "jit_kernel_cache(): could not lock \"%s\": %s",
+                     cache_db.filename, strerror(errno));
+            return false;
+        }
+    }
 
-    int fd = open(filename, O_RDONLY);
-    if (fd == -1)
+    return true;
+}
+
+/// Close the database file and forget its contents
+static void jitc_cache_db_reset() {
+    if (cache_db.map)
+        munmap((void *) cache_db.map, cache_db.map_size);
+    if (cache_db.fd != -1)
+        close(cache_db.fd);
+
+    cache_db.fd = -1;
+    cache_db.map = nullptr;
+    cache_db.map_size = 0;
+    cache_db.scan_end = sizeof(CacheDBHeader);
+    cache_db.validated = cache_db.corrupt = false;
+    cache_db.index.clear();
+}
+
+/// Map records appended since the last call (by any process) and index them
+static void jitc_cache_db_refresh() {
+    struct stat st;
+    if (cache_db.corrupt || fstat(cache_db.fd, &st) != 0 ||
+        (size_t) st.st_size <= cache_db.map_size)
+        return;
+
+    size_t size = (size_t) st.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, cache_db.fd, 0);
+    if (map == MAP_FAILED) {
+        jitc_log(Warn, "jit_kernel_cache(): could not mmap() \"%s\": %s",
+                 cache_db.filename, strerror(errno));
+        return;
+    }
+
+    if (cache_db.map)
+        munmap((void *) cache_db.map, cache_db.map_size);
+    cache_db.map = (const uint8_t *) map;
+    cache_db.map_size = size;
+
+    while (cache_db.scan_end + sizeof(CacheDBRecord) <= size) {
+        const CacheDBRecord *r =
+            (const CacheDBRecord *) (cache_db.map + cache_db.scan_end);
+
+        if (r->magic != DRJIT_CACHE_DB_RECORD_MAGIC) {
+            jitc_log(Warn,
+                     "jit_kernel_cache(): database \"%s\" is damaged at "
+                     "offset %zu, ignoring the remainder. You may want to "
+                     "wipe your ~/.drjit directory.",
+                     cache_db.filename, cache_db.scan_end);
+            cache_db.corrupt = true;
+            break;
+        }
+
+        // Stop at records that are incomplete (e.g. due to a crash)
+        size_t total = jitc_cache_db_record_size(r);
+        if (cache_db.scan_end + total > size)
+            break;
+
+        cache_db.index[CacheDBKey{ r->hash_high, r->hash_low, r->backend }] =
+            cache_db.scan_end;
+        cache_db.scan_end += total;
+    }
+}
+
+/**
+ * \brief Atomically replace the database by a new file containing the
+ * records at the given offsets. The caller must hold the exclusive lock.
+ */
+static bool jitc_cache_db_replace(const std::vector<size_t> &offsets) {
+    char filename_tmp[530];
+    snprintf(filename_tmp, sizeof(filename_tmp), "%s.tmp", cache_db.filename);
+
+    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    int fd = open(filename_tmp, O_CREAT | O_TRUNC | O_WRONLY, mode);
+    if (fd == -1) {
+        jitc_log(Warn, "jit_kernel_cache(): could not create \"%s\": %s",
+                 filename_tmp, strerror(errno));
         return false;
+    }
 
-    auto read_retry = [&](uint8_t* data, size_t data_size) {
-        while (data_size > 0) {
-            ssize_t n_read = read(fd, data, data_size);
-            if (n_read <= 0) {
-                if (errno == EINTR) {
+    CacheDBHeader header = jitc_cache_db_header();
+    size_t offset = sizeof(CacheDBHeader);
+    bool success = jitc_cache_db_write(fd, &header, sizeof(CacheDBHeader), 0,
+                                       filename_tmp);
+
+    for (size_t i = 0; success && i < offsets.size(); ++i) {
+        const CacheDBRecord *r =
+            (const CacheDBRecord *) (cache_db.map + offsets[i]);
+        size_t total = jitc_cache_db_record_size(r);
+        success = jitc_cache_db_write(fd, r, total, offset, filename_tmp);
+        offset += total;
+    }
+
+    close(fd);
+
+    if (success && rename(filename_tmp, cache_db.filename) != 0) {
+        jitc_log(Warn, "jit_kernel_cache(): could not replace \"%s\": %s",
+                 cache_db.filename, strerror(errno));
+        success = false;
+    }
+
+    if (!success)
+        unlink(filename_tmp);
+
+    return success;
+}
+
+/**
+ * \brief Open the database (if needed), lock it, and index new records
+ *
+ * This function also detects databases that were replaced by another process
+ * and replaces files from other versions of Dr.Jit.
+ */
+static bool jitc_cache_db_acquire(short type) {
+    if (!cache_db.init) {
+        cache_db.init = true;
+        // Entries compressed with different dictionaries are kept apart
+        int rv = jitc_cache_dict_id
+            ? snprintf(cache_db.filename, sizeof(cache_db.filename),
+                       "%s/kernels-%08x.db", jitc_temp_path, jitc_cache_dict_id)
+            : snprintf(cache_db.filename, sizeof(cache_db.filename),
+                       "%s/kernels.db", jitc_temp_path);
+        if (unlikely(rv < 0 || rv >= (int) sizeof(cache_db.filename)))
+            jitc_fail("jit_kernel_cache(): scratch space for filename insufficient!");
+    }
+
+    for (int attempt = 0; attempt < 4 && !cache_db.disabled; ++attempt) {
+        if (cache_db.fd == -1) {
+            mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+            cache_db.fd = open(cache_db.filename, O_RDWR | O_CREAT, mode);
+            cache_db.writable = cache_db.fd != -1;
+            if (!cache_db.writable)
+                cache_db.fd = open(cache_db.filename, O_RDONLY);
+
+            if (cache_db.fd == -1) {
+                jitc_log(Warn, "jit_kernel_cache(): could not open \"%s\": %s",
+                         cache_db.filename, strerror(errno));
+                cache_db.disabled = true;
+                return false;
+            }
+        }
+
+        // Validate the header under an exclusive lock (upgrading a shared
+        // lock could deadlock with other processes doing the same)
+        bool validate = !cache_db.validated && cache_db.writable;
+        if ((type == F_WRLCK && !cache_db.writable) ||
+            !jitc_cache_db_lock(validate ? F_WRLCK : type))
+            return false;
+
+        // Was the file replaced by another process in the meantime?
+        struct stat st_fd, st_path;
+        if (fstat(cache_db.fd, &st_fd) != 0 ||
+            stat(cache_db.filename, &st_path) != 0 ||
+            st_fd.st_ino != st_path.st_ino || st_fd.st_dev != st_path.st_dev) {
+            jitc_cache_db_reset();
+            continue;
+        }
+
+        if (!cache_db.validated) {
+            CacheDBHeader header, header_ref = jitc_cache_db_header();
+            ssize_t n_read = pread(cache_db.fd, &header, sizeof(CacheDBHeader), 0);
+
+            if (n_read == (ssize_t) sizeof(CacheDBHeader) &&
+                memcmp(&header, &header_ref, sizeof(CacheDBHeader)) == 0) {
+                cache_db.validated = true;
+            } else if (n_read == 0 && cache_db.writable) {
+                cache_db.validated = jitc_cache_db_write(
+                    cache_db.fd, &header_ref, sizeof(CacheDBHeader), 0,
+                    cache_db.filename);
+            } else if (cache_db.writable) {
+                jitc_log(Info,
+                         "jit_kernel_cache(): replacing \"%s\", which is "
+                         "damaged or from an incompatible version of Dr.Jit.",
+                         cache_db.filename);
+                bool replaced = jitc_cache_db_replace({ });
+                jitc_cache_db_reset();
+                if (replaced)
                     continue;
-                } else {
-                    jitc_raise("jit_kernel_load(): I/O error while while "
-                              "reading compiled kernel from cache "
-                              "file \"%s\": %s",
-                              filename, strerror(errno));
-                }
+            } else {
+                jitc_log(Warn,
+                         "jit_kernel_cache(): \"%s\" is damaged or from an "
+                         "incompatible version of Dr.Jit. You may want to "
+                         "wipe your ~/.drjit directory.", cache_db.filename);
+                jitc_cache_db_reset();
+            }
+
+            if (!cache_db.validated) {
+                jitc_cache_db_reset();
+                cache_db.disabled = true;
+                return false;
+            }
+
+            // Downgrading an exclusive lock cannot deadlock
+            if (validate && type != F_WRLCK && !jitc_cache_db_lock(type)) {
+                jitc_cache_db_reset();
+                return false;
             }
-            data += n_read;
-            data_size -= n_read;
         }
-    };
-#else
-    wchar_t filename_w[512];
-    char filename[512];
 
-    int rv = _snwprintf(filename_w, sizeof(filename_w) / sizeof(wchar_t),
-                        L"%s\\%016llx%016llx.%s.bin",
-                        jitc_temp_path, (unsigned long long) hash.high64,
-                        (unsigned long long) hash.low64,
-                        backend == JitBackend::CUDA ? L"cuda" : L"llvm");
+        jitc_cache_db_refresh();
+        return true;
+    }
 
-    if (rv < 0 || rv == sizeof(filename) ||
-        wcstombs(filename, filename_w, sizeof(filename)) == sizeof(filename))
-        jitc_fail("jit_kernel_load(): scratch space for filename insufficient!");
+    return false;
+}
 
-    HANDLE fd = CreateFileW(filename_w, GENERIC_READ,
-        FILE_SHARE_READ, nullptr, OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL, nullptr);
+/**
+ * \brief Evict the least recently used records if the database exceeds its
+ * limits. The caller must hold the exclusive lock. Returns \c true if the
+ * database was replaced, in which case it has also been closed.
+ */
+static bool jitc_cache_db_trim() {
+    size_t max_size = state.kernel_cache_max_disk_size;
+    uint32_t max_entries = state.kernel_cache_max_disk_entries;
+
+    if ((!max_size || cache_db.scan_end <= max_size) &&
+        (!max_entries || cache_db.index.size() <= max_entries))
+        return false;
 
-    if (fd == INVALID_HANDLE_VALUE)
+    std::vector<std::pair<uint64_t, size_t>> records;
+    records.reserve(cache_db.index.size());
+    for (auto &kv : cache_db.index) {
+        const CacheDBRecord *r =
+            (const CacheDBRecord *) (cache_db.map + kv.second);
+        records.emplace_back(r->last_use, kv.second);
+    }
+
+    // Most recently used records first (ties go to the most recently added)
+    std::sort(records.begin(), records.end(),
+              [](const std::pair<uint64_t, size_t> &a,
+                 const std::pair<uint64_t, size_t> &b) {
+                  return a > b;
+              });
+
+    // Shrink to 7/8 of the limits so that this does not happen on every write
+    size_t target_size = max_size - max_size / 8,
+           target_entries = max_entries - max_entries / 8,
+           size = sizeof(CacheDBHeader);
+
+    std::vector<size_t> keep;
+    for (auto &rec : records) {
+        size_t total = jitc_cache_db_record_size(
+            (const CacheDBRecord *) (cache_db.map + rec.second));
+        if ((max_size && size + total > target_size) ||
+            (max_entries && keep.size() >= target_entries))
+            break;
+        keep.push_back(rec.second);
+        size += total;
+    }
+
+    // Preserve the original order of the records
+    std::sort(keep.begin(), keep.end());
+
+    if (!jitc_cache_db_replace(keep))
         return false;
 
-    auto read_retry = [&](uint8_t* data, size_t data_size) {
-        while (data_size > 0) {
-            DWORD n_read = 0;
-            if (!ReadFile(fd, data, (DWORD) data_size, &n_read, nullptr) || n_read == 0)
-                jitc_raise("jit_kernel_load(): I/O error while while "
-                           "reading compiled kernel from cache "
-                           "file \"%s\": %u", filename, GetLastError());
+    size_t evicted = cache_db.index.size() - keep.size();
+    state.kernel_disk_evictions += evicted;
+    jitc_log(Debug, "jit_kernel_cache(): evicted %zu kernel%s from \"%s\" "
+             "(%zu remaining, %s).", evicted, evicted == 1 ? "" : "s",
+             cache_db.filename, keep.size(), jitc_mem_string(size));
 
-            data += n_read;
-            data_size -= n_read;
+    jitc_cache_db_reset();
+    return true;
+}
+
+/// Append a compressed kernel to the database unless it is already present
+static bool jitc_cache_db_append(JitBackend backend, XXH128_hash_t hash,
+                                 const CacheFileHeader &header,
+                                 const uint8_t *compressed) {
+    if (!jitc_cache_db_acquire(F_WRLCK))
+        return false;
+
+    CacheDBKey key { hash.high64, hash.low64, (uint32_t) backend };
+    bool success = !cache_db.corrupt;
+
+    if (success && cache_db.index.find(key) == cache_db.index.end()) {
+        // Drop the incomplete tail left behind by a crashed process
+        struct stat st;
+        if (fstat(cache_db.fd, &st) == 0 &&
+            (size_t) st.st_size > cache_db.scan_end) {
+            munmap((void *) cache_db.map, cache_db.map_size);
+            cache_db.map = nullptr;
+            cache_db.map_size = 0;
+            success = ftruncate(cache_db.fd, (off_t) cache_db.scan_end) == 0;
         }
-    };
-#endif
 
-    char *compressed = nullptr, *uncompressed = nullptr;
+        // Place the code of uncompressed LLVM kernels at a page boundary
+        size_t padding = 0;
+        if (backend == JitBackend::LLVM &&
+            header.codec == (uint8_t) KernelCacheCodec::None) {
+            size_t page = (size_t) sysconf(_SC_PAGESIZE),
+                   code = cache_db.scan_end + sizeof(CacheDBRecord) +
+                          header.source_size;
+            padding = (page - code % page) % page;
+        }
 
-    CacheFileHeader header;
+        size_t total = sizeof(CacheDBRecord) +
+                       jitc_cache_db_align(padding + header.compressed_size);
+        uint8_t *buf = (uint8_t *) malloc_check(total);
+        memset(buf, 0, total);
+
+        CacheDBRecord *r = (CacheDBRecord *) buf;
+        r->magic = DRJIT_CACHE_DB_RECORD_MAGIC;
+        r->backend = (uint32_t) backend;
+        r->hash_high = hash.high64;
+        r->hash_low = hash.low64;
+        r->last_use = (uint64_t) time(nullptr);
+        r->codec = header.codec;
+        r->dict_id = header.dict_id;
+        r->compressed_size = header.compressed_size;
+        r->source_size = header.source_size;
+        r->kernel_size = header.kernel_size;
+        r->reloc_size = header.reloc_size;
+        r->launch_config = header.launch_config;
+        r->padding = (uint32_t) padding;
+        memcpy((uint8_t *) (r + 1) + padding, compressed, header.compressed_size);
+
+        if (success)
+            success = jitc_cache_db_write(cache_db.fd, buf, total,
+                                          cache_db.scan_end, cache_db.filename);
+
+        free(buf);
+        jitc_cache_db_refresh();
+    }
+
+    // Evict old records if the database has become too large
+    if (!jitc_cache_db_trim())
+        jitc_cache_db_lock(F_UNLCK);
+
+    return success;
+}
+
+void jitc_kernel_cache_close() {
+    jitc_cache_db_reset();
+    cache_db = CacheDB();
+}
+
+/**
+ * \brief Map the code of an uncompressed LLVM kernel straight from the
+ * database
+ *
+ * \c code must point into the memory-mapped database. The pages are mapped
+ * copy-on-write, hence only the ones that are subsequently patched (e.g., to
+ * store the address of the \c @callables table) are duplicated. The result
+ * is writable until the caller changes the protection via \c mprotect().
+ * Returns \c nullptr when the file cannot be mapped as executable memory
+ * (e.g., on a file system mounted with \c noexec), or when the code does not
+ * begin at a page boundary. The sections of the kernel were laid out relative
+ * to a page-aligned base, and aligned loads from them would fault otherwise.
+ * (Records lose their alignment when jitc_cache_db_replace() moves them.)
+ */
+static void *jitc_kernel_map(const char *code, size_t size) {
+    const char *map = (const char *) cache_db.map;
+    if (!map || code < map || code + size > map + cache_db.map_size)
+        return nullptr;
+
+    size_t page = (size_t) sysconf(_SC_PAGESIZE),
+           offset = (size_t) (code - map),
+           start = offset & ~(page - 1),
+           length = size + (offset - start);
+
+    if (offset != start)
+        return nullptr;
+
+    // Request executable memory right away to detect 'noexec' mounts
+    void *ptr = mmap(nullptr, length, PROT_READ | PROT_EXEC, MAP_PRIVATE,
+                     cache_db.fd, (off_t) start);
+    if (ptr == MAP_FAILED) {
+        jitc_log(Debug, "jit_kernel_load(): could not map kernel from \"%s\": "
+                 "%s", cache_db.filename, strerror(errno));
+        return nullptr;
+    }
+
+    if (mprotect(ptr, length, PROT_READ | PROT_WRITE) == -1) {
+        munmap(ptr, length);
+        return nullptr;
+    }
+
+    return (uint8_t *) ptr + (offset - start);
+}
+
+/// Page-aligned memory region containing the code of an LLVM kernel
+static void jitc_kernel_pages(const Kernel &kernel, void **base, size_t *size) {
+    uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE),
+              start = (uintptr_t) kernel.data & ~(page - 1);
+    *base = (void *) start;
+    *size = kernel.size + ((uintptr_t) kernel.data - start);
+}
+#else
+void jitc_kernel_cache_close() { }
+#endif
+
+/**
+ * \brief Decompress a cache entry and reconstruct the kernel that it contains
+ *
+ * When \c source is \c nullptr, the stored source code is not validated but
+ * returned instead via \c source_out (as a zero-terminated string that must be
+ * released using \c free()).
+ */
+static bool jitc_kernel_decode(const char *source, uint32_t source_size,
+                               JitBackend backend, XXH128_hash_t hash,
+                               const CacheFileHeader &header,
+                               const char *compressed, const char *filename,
+                               Kernel &kernel, char **source_out = nullptr) {
+    char *uncompressed = nullptr;
     uint32_t padding_size = 0;
     bool success = true;
-    std::vector<void *> func;
 
     try {
-        read_retry((uint8_t *) &header, sizeof(CacheFileHeader));
-
         if (header.version != DRJIT_CACHE_VERSION)
             jitc_raise("jit_kernel_load(): cache file \"%s\" is from an "
                        "incompatible version of Dr.Jit. You may want to wipe "
                        "your ~/.drjit directory.", filename);
 
-        if (header.source_size != source_size)
+        if (header.codec != (uint8_t) KernelCacheCodec::LZ4 &&
+            header.codec != (uint8_t) KernelCacheCodec::LZ4HC &&
+            header.codec != (uint8_t) KernelCacheCodec::None)
+            jitc_raise("jit_kernel_load(): cache file \"%s\" uses an unknown "
+                       "compression codec (%u).", filename,
+                       (uint32_t) header.codec);
+
+        if (header.dict_id != jitc_cache_dict_id)
+            jitc_raise("jit_kernel_load(): cache file \"%s\" was compressed "
+                       "using a different dictionary.", filename);
+
+        if (!source)
+            source_size = header.source_size;
+        else if (header.source_size != source_size)
             jitc_raise("jit_kernel_load(): cache collision in file \"%s\": size "
                        "mismatch (%u vs %u bytes).",
                        filename, header.source_size, source_size);
@@ -164,28 +685,38 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
         uint32_t uncompressed_size =
             header.source_size + header.kernel_size + padding_size + header.reloc_size;
 
-        compressed = (char *) malloc_check(header.compressed_size);
-        uncompressed = (char *) malloc_check(size_t(uncompressed_size) + jitc_lz4_dict_size);
-        memcpy(uncompressed, jitc_lz4_dict, jitc_lz4_dict_size);
-
-        read_retry((uint8_t *) compressed, header.compressed_size);
-
-        uint32_t rv_2 = (uint32_t) LZ4_decompress_safe_usingDict(
-            compressed, uncompressed + jitc_lz4_dict_size,
-            (int) header.compressed_size, (int) uncompressed_size,
-            (char *) uncompressed, jitc_lz4_dict_size);
-
-        if (rv_2 != uncompressed_size)
-            jitc_raise("jit_kernel_load(): cache file \"%s\" is malformed.",
-                       filename);
+        if (header.codec == (uint8_t) KernelCacheCodec::None) {
+            if (header.compressed_size != uncompressed_size)
+                jitc_raise("jit_kernel_load(): cache file \"%s\" is malformed.",
+                           filename);
+        } else {
+            // LZ4HC produces regular LZ4 blocks, which decompress the same way
+            uncompressed = (char *) malloc_check(size_t(uncompressed_size) + jitc_cache_dict_size);
+            memcpy(uncompressed, jitc_cache_dict, jitc_cache_dict_size);
+
+            uint32_t rv_2 = (uint32_t) LZ4_decompress_safe_usingDict(
+                compressed, uncompressed + jitc_cache_dict_size,
+                (int) header.compressed_size, (int) uncompressed_size,
+                (char *) uncompressed, (int) jitc_cache_dict_size);
+
+            if (rv_2 != uncompressed_size)
+                jitc_raise("jit_kernel_load(): cache file \"%s\" is malformed.",
+                           filename);
+        }
     } catch (const std::exception &e) {
         jitc_log(Warn, "%s", e.what());
         success = false;
     }
 
-    char *uncompressed_data = uncompressed + jitc_lz4_dict_size;
+    // Uncompressed entries are used in place
+    const char *uncompressed_data =
+        uncompressed ? uncompressed + jitc_cache_dict_size : compressed;
 
-    if (success && memcmp(uncompressed_data, source, source_size) != 0) {
+    if (success && !source) {
+        *source_out = (char *) malloc_check(size_t(source_size) + 1);
+        memcpy(*source_out, uncompressed_data, source_size);
+        (*source_out)[source_size] = '\0';
+    } else if (success && memcmp(uncompressed_data, source, source_size) != 0) {
         jitc_log(Warn, "jit_kernel_load(): cache collision in file \"%s\".", filename);
         success = false;
     }
@@ -196,15 +727,23 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
         if (backend == JitBackend::CUDA) {
             kernel.data = malloc_check(header.kernel_size);
             memcpy(kernel.data, uncompressed_data + source_size, header.kernel_size);
+            kernel.cuda.tuned_threads = (uint16_t) header.launch_config;
+            kernel.cuda.tuned_blocks_per_sm = (uint16_t) (header.launch_config >> 16);
         } else {
 #if !defined(_WIN32)
-            kernel.data = mmap(nullptr, header.kernel_size, PROT_READ | PROT_WRITE,
-                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-            if (kernel.data == MAP_FAILED)
-                jitc_fail("jit_llvm_load(): could not mmap() memory: %s",
-                         strerror(errno));
-
-            memcpy(kernel.data, uncompressed_data + source_size, header.kernel_size);
+            const char *code = uncompressed_data + source_size;
+            kernel.data = uncompressed ? nullptr
+                                       : jitc_kernel_map(code, header.kernel_size);
+
+            if (!kernel.data) {
+                kernel.data = mmap(nullptr, header.kernel_size, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (kernel.data == MAP_FAILED)
+                    jitc_fail("jit_llvm_load(): could not mmap() memory: %s",
+                             strerror(errno));
+
+                memcpy(kernel.data, code, header.kernel_size);
+            }
 #else
             kernel.data = VirtualAlloc(nullptr, header.kernel_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
             if (!kernel.data)
@@ -212,7 +751,7 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
             memcpy(kernel.data, uncompressed_data + source_size, header.kernel_size);
 
 #endif
-            uintptr_t *reloc = (uintptr_t *) (uncompressed_data + header.source_size + padding_size + header.kernel_size);
+            const uintptr_t *reloc = (const uintptr_t *) (uncompressed_data + header.source_size + padding_size + header.kernel_size);
             kernel.llvm.n_reloc = header.reloc_size / sizeof(void *);
             kernel.llvm.reloc = (void **) malloc(header.reloc_size);
             for (uint32_t i = 0; i < kernel.llvm.n_reloc; ++i)
@@ -223,7 +762,10 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
                 *((void **) kernel.llvm.reloc[1]) = kernel.llvm.reloc + 1;
 
 #if !defined(_WIN32)
-            if (mprotect(kernel.data, header.kernel_size, PROT_READ | PROT_EXEC) == -1)
+            void *base;
+            size_t size;
+            jitc_kernel_pages(kernel, &base, &size);
+            if (mprotect(base, size, PROT_READ | PROT_EXEC) == -1)
                 jitc_fail("jit_llvm_load(): mprotect() failed: %s", strerror(errno));
 #else
             DWORD unused;
@@ -240,62 +782,224 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
 #endif
         }
     }
+    (void) hash;
 
-    free(compressed);
     free(uncompressed);
 
+    return success;
+}
+
+/**
+ * \brief Return the hash that identifies a kernel in the disk cache
+ *
+ * LLVM kernels compiled for different targets share their hash, hence it is
+ * combined with the target of 'source' (or that of the current target when
+ * \c source is \c nullptr). See jitc_llvm_target_tag() for details.
+ */
+static XXH128_hash_t jitc_kernel_cache_key(JitBackend backend,
+                                           XXH128_hash_t hash,
+                                           const char *source,
+                                           uint32_t source_size) {
+    if (backend == JitBackend::LLVM)
+        hash.low64 ^= jitc_llvm_target_tag(source, source_size);
+    else
+        hash.low64 ^= jitc_cuda_target_tag();
+    return hash;
+}
+
+/**
+ * \brief Locate the cache entry of a kernel
+ *
+ * On success, \c compressed points to the compressed payload. It either
+ * refers to the memory-mapped database or to a buffer that the caller must
+ * release via <tt>free(*owned)</tt>.
+ */
+static bool jitc_kernel_find(JitBackend backend, XXH128_hash_t hash,
+                             CacheFileHeader &header, const char **compressed,
+                             char **owned, const char **filename) {
+    *owned = nullptr;
+
 #if !defined(_WIN32)
-    close(fd);
+    CacheDBKey key { hash.high64, hash.low64, (uint32_t) backend };
+    auto it = cache_db.index.find(key);
+
+    if (it == cache_db.index.end()) {
+        // Another process may have compiled this kernel in the meantime
+        if (!jitc_cache_db_acquire(F_RDLCK))
+            return false;
+        jitc_cache_db_lock(F_UNLCK);
+
+        it = cache_db.index.find(key);
+        if (it == cache_db.index.end())
+            return false;
+    }
+
+    // Decompress straight from the memory-mapped database
+    size_t offset = it->second;
+    const CacheDBRecord *r = (const CacheDBRecord *) (cache_db.map + offset);
+
+    // Update the time of the last use (for LRU eviction)
+    uint64_t now = (uint64_t) time(nullptr);
+    if (cache_db.writable && r->last_use != now &&
+        pwrite(cache_db.fd, &now, sizeof(uint64_t),
+               (off_t) (offset + offsetof(CacheDBRecord, last_use))) !=
+            (ssize_t) sizeof(uint64_t))
+        jitc_log(Debug, "jit_kernel_load(): could not update \"%s\".",
+                 cache_db.filename);
+
+    header.version = DRJIT_CACHE_VERSION;
+    header.codec = (uint8_t) r->codec;
+    header.dict_id = r->dict_id;
+    header.compressed_size = r->compressed_size;
+    header.source_size = r->source_size;
+    header.kernel_size = r->kernel_size;
+    header.reloc_size = r->reloc_size;
+    header.launch_config = r->launch_config;
+    *compressed = (const char *) (r + 1) + r->padding;
+    *filename = cache_db.filename;
+
+    return true;
 #else
+    wchar_t filename_w[512];
+    static char filename_s[512];
+    *filename = filename_s;
+
+    int rv = _snwprintf(filename_w, sizeof(filename_w) / sizeof(wchar_t),
+                        L"%s\\%016llx%016llx.%s.bin",
+                        jitc_temp_path, (unsigned long long) hash.high64,
+                        (unsigned long long) hash.low64,
+                        backend == JitBackend::CUDA ? L"cuda" : L"llvm");
+
+    if (rv < 0 || rv == sizeof(filename_s) ||
+        wcstombs(filename_s, filename_w, sizeof(filename_s)) == sizeof(filename_s))
+        jitc_fail("jit_kernel_load(): scratch space for filename insufficient!");
+
+    HANDLE fd = CreateFileW(filename_w, GENERIC_READ,
+        FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (fd == INVALID_HANDLE_VALUE)
+        return false;
+
+    auto read_retry = [&](uint8_t* data, size_t data_size) {
+        while (data_size > 0) {
+            DWORD n_read = 0;
+            if (!ReadFile(fd, data, (DWORD) data_size, &n_read, nullptr) || n_read == 0)
+                jitc_raise("jit_kernel_load(): I/O error while while "
+                           "reading compiled kernel from cache "
+                           "file \"%s\": %u", filename_s, GetLastError());
+
+            data += n_read;
+            data_size -= n_read;
+        }
+    };
+
+    bool success = true;
+    try {
+        read_retry((uint8_t *) &header, sizeof(CacheFileHeader));
+        if (header.version == DRJIT_CACHE_VERSION) {
+            *owned = (char *) malloc_check(header.compressed_size);
+            read_retry((uint8_t *) *owned, header.compressed_size);
+        }
+    } catch (const std::exception &e) {
+        jitc_log(Warn, "%s", e.what());
+        success = false;
+    }
+
+    *compressed = *owned;
     CloseHandle(fd);
+
+    return success;
 #endif
+}
 
+bool jitc_kernel_load(const char *source, uint32_t source_size,
+                      JitBackend backend, XXH128_hash_t hash, Kernel &kernel) {
+    lock_guard guard(state.kernel_cache_lock);
+    jitc_cache_dict_init();
+
+    CacheFileHeader header;
+    const char *compressed = nullptr, *filename = nullptr;
+    char *owned = nullptr;
+
+    bool success = jitc_kernel_find(
+        backend, jitc_kernel_cache_key(backend, hash, source, source_size),
+        header, &compressed, &owned, &filename);
+    if (success)
+        success = jitc_kernel_decode(source, source_size, backend, hash,
+                                     header, compressed, filename, kernel);
+
+    free(owned);
     return success;
 }
 
 bool jitc_kernel_write(const char *source, uint32_t source_size,
                        JitBackend backend, XXH128_hash_t hash,
                        const Kernel &kernel) {
-    jitc_lz4_init();
+    lock_guard guard(state.kernel_cache_lock);
+    jitc_cache_dict_init();
+    hash = jitc_kernel_cache_key(backend, hash, source, source_size);
 
-#if !defined(_WIN32)
-    char filename[512], filename_tmp[512];
-    if (unlikely(snprintf(filename, sizeof(filename), "%s/%016llx%016llx.%s.bin",
-                          jitc_temp_path, (unsigned long long) hash.high64,
-                          (unsigned long long) hash.low64,
-                          backend == JitBackend::CUDA ? "cuda" : "llvm") < 0))
-        jitc_fail("jit_kernel_write(): scratch space for filename insufficient!");
+    CacheFileHeader header;
+    header.version = DRJIT_CACHE_VERSION;
+    header.codec = (uint8_t) state.kernel_cache_codec;
+    header.dict_id = jitc_cache_dict_id;
+    header.source_size = source_size;
+    header.kernel_size = kernel.size;
+    header.reloc_size = 0;
+    header.launch_config = jitc_kernel_launch_config(backend, kernel);
 
-    if (unlikely(snprintf(filename_tmp, sizeof(filename_tmp), "%s.tmp",
-                          filename) < 0))
-        jitc_fail("jit_kernel_write(): scratch space for filename insufficient!");
+    if (backend == JitBackend::LLVM)
+        header.reloc_size = kernel.llvm.n_reloc * sizeof(void *);
 
-    mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-    int fd = open(filename_tmp, O_CREAT | O_EXCL | O_WRONLY, mode);
-    if (fd == -1) {
-        jitc_log(Warn,
-                "jit_kernel_write(): could not write compiled kernel "
-                "to cache file \"%s\": %s", filename_tmp, strerror(errno));
-        return false;
+    uint32_t padding_size = compute_padding(header);
+    uint32_t in_size = header.source_size + header.kernel_size
+                     + padding_size + header.reloc_size,
+             out_size = LZ4_compressBound(in_size);
+
+    uint8_t *temp_in  = (uint8_t *) malloc_check(in_size),
+            *temp_out = (uint8_t *) malloc_check(out_size);
+
+    memcpy(temp_in, source, header.source_size);
+    memcpy(temp_in + source_size, kernel.data, header.kernel_size);
+    memset(temp_in + header.source_size + header.kernel_size, 0, padding_size);
+
+    if (backend == JitBackend::LLVM) {
+        uintptr_t *reloc_out = (uintptr_t *) (temp_in + header.source_size +
+                                              header.kernel_size + padding_size);
+        for (uint32_t i = 0; i < kernel.llvm.n_reloc; ++i)
+            reloc_out[i] = (uintptr_t) kernel.llvm.reloc[i] - (uintptr_t) kernel.data;
     }
 
-    auto write_retry = [&](const uint8_t *data, size_t data_size) {
-        while (data_size > 0) {
-            ssize_t n_written = write(fd, data, data_size);
-            if (n_written <= 0) {
-                if (errno == EINTR) {
-                    continue;
-                } else {
-                    jitc_raise("jit_kernel_write(): I/O error while while "
-                              "writing compiled kernel to cache "
-                              "file \"%s\": %s",
-                              filename_tmp, strerror(errno));
-                }
-            }
-            data += n_written;
-            data_size -= n_written;
-        }
-    };
+    int level = state.kernel_cache_level;
+    if (state.kernel_cache_codec == KernelCacheCodec::None) {
+        memcpy(temp_out, temp_in, in_size);
+        header.compressed_size = in_size;
+    } else if (state.kernel_cache_codec == KernelCacheCodec::LZ4HC) {
+        // Slower compression, smaller files (e.g. for network file systems)
+        LZ4_streamHC_t *stream = LZ4_createStreamHC();
+        if (!stream)
+            jitc_fail("jit_kernel_write(): could not allocate LZ4HC state!");
+        LZ4_resetStreamHC_fast(stream, level > 0 ? level : LZ4HC_CLEVEL_DEFAULT);
+        LZ4_loadDictHC(stream, jitc_cache_dict, (int) jitc_cache_dict_size);
+        header.compressed_size = (uint32_t) LZ4_compress_HC_continue(
+            stream, (const char *) temp_in, (char *) temp_out, (int) in_size,
+            (int) out_size);
+        LZ4_freeStreamHC(stream);
+    } else {
+        // The level specifies the acceleration factor of LZ4
+        LZ4_stream_t stream;
+        memset(&stream, 0, sizeof(LZ4_stream_t));
+        LZ4_resetStream_fast(&stream);
+        LZ4_loadDict(&stream, jitc_cache_dict, (int) jitc_cache_dict_size);
+        header.compressed_size = (uint32_t) LZ4_compress_fast_continue(
+            &stream, (const char *) temp_in, (char *) temp_out, (int) in_size,
+            (int) out_size, level > 0 ? level : 1);
+    }
+
+#if !defined(_WIN32)
+    const char *filename = cache_db.filename;
+    bool success = jitc_cache_db_append(backend, hash, header, temp_out);
 #else
     wchar_t filename_w[512], filename_tmp_w[512];
     char filename[512], filename_tmp[512];
@@ -325,6 +1029,8 @@ bool jitc_kernel_write(const char *source, uint32_t source_size,
         jitc_log(Warn,
             "jit_kernel_write(): could not write compiled kernel "
             "to cache file \"%s\": %u", filename_tmp, GetLastError());
+        free(temp_out);
+        free(temp_in);
         return false;
     }
 
@@ -341,44 +1047,6 @@ bool jitc_kernel_write(const char *source, uint32_t source_size,
             data_size -= n_written;
         }
     };
-#endif
-
-    CacheFileHeader header;
-    header.version = DRJIT_CACHE_VERSION;
-    header.source_size = source_size;
-    header.kernel_size = kernel.size;
-    header.reloc_size = 0;
-
-    if (backend == JitBackend::LLVM)
-        header.reloc_size = kernel.llvm.n_reloc * sizeof(void *);
-
-    uint32_t padding_size = compute_padding(header);
-    uint32_t in_size = header.source_size + header.kernel_size
-                     + padding_size + header.reloc_size,
-             out_size = LZ4_compressBound(in_size);
-
-    uint8_t *temp_in  = (uint8_t *) malloc_check(in_size),
-            *temp_out = (uint8_t *) malloc_check(out_size);
-
-    memcpy(temp_in, source, header.source_size);
-    memcpy(temp_in + source_size, kernel.data, header.kernel_size);
-    memset(temp_in + header.source_size + header.kernel_size, 0, padding_size);
-
-    if (backend == JitBackend::LLVM) {
-        uintptr_t *reloc_out = (uintptr_t *) (temp_in + header.source_size +
-                                              header.kernel_size + padding_size);
-        for (uint32_t i = 0; i < kernel.llvm.n_reloc; ++i)
-            reloc_out[i] = (uintptr_t) kernel.llvm.reloc[i] - (uintptr_t) kernel.data;
-    }
-
-    LZ4_stream_t stream;
-    memset(&stream, 0, sizeof(LZ4_stream_t));
-    LZ4_resetStream_fast(&stream);
-    LZ4_loadDict(&stream, jitc_lz4_dict, jitc_lz4_dict_size);
-
-    header.compressed_size = (uint32_t) LZ4_compress_fast_continue(
-        &stream, (const char *) temp_in, (char *) temp_out, (int) in_size,
-        (int) out_size, 1);
 
     bool success = true;
     try {
@@ -389,31 +1057,6 @@ bool jitc_kernel_write(const char *source, uint32_t source_size,
         success = false;
     }
 
-    bool log = std::max(state.log_level_stderr,
-                        state.log_level_callback) >= LogLevel::Trace;
-    if (success && log)
-        jitc_trace("jit_kernel_write(\"%s\"): compressed %s to %s", filename,
-                  std::string(jitc_mem_string(size_t(source_size) + kernel.size)).c_str(),
-                  std::string(jitc_mem_string(header.compressed_size)).c_str());
-
-#if !defined(_WIN32)
-    close(fd);
-
-    if (link(filename_tmp, filename) != 0) {
-        jitc_log(Warn,
-            "jit_kernel_write(): could not link cache "
-            "file \"%s\" into file system: %s",
-            filename, strerror(errno));
-        success = false;
-    }
-
-    if (unlink(filename_tmp) != 0) {
-        jitc_raise("jit_kernel_write(): could not unlink temporary "
-            "file \"%s\": %s",
-            filename_tmp, strerror(errno));
-        success = false;
-    }
-#else
     CloseHandle(fd);
 
     if (MoveFileW(filename_tmp_w, filename_w) == 0)
@@ -423,17 +1066,27 @@ bool jitc_kernel_write(const char *source, uint32_t source_size,
                 filename, GetLastError());
 #endif
 
-#if DRJIT_CACHE_TRAIN == 1
-    snprintf(filename, sizeof(filename), "%s/.drjit/%016llx%016llx.%s.trn",
-             getenv("HOME"), (unsigned long long) hash.high64,
-             (unsigned long long) hash.low64,
-             backend == JitBackend::CUDA ? "cuda" : "llvm");
-    fd = open(filename, O_CREAT | O_WRONLY, mode);
-    if (fd) {
-        write_retry(temp_in, in_size);
-        close(fd);
+    bool log = std::max(state.log_level_stderr,
+                        state.log_level_callback) >= LogLevel::Trace;
+    if (success && log)
+        jitc_trace("jit_kernel_write(\"%s\"): compressed %s to %s", filename,
+                  std::string(jitc_mem_string(size_t(source_size) + kernel.size)).c_str(),
+                  std::string(jitc_mem_string(header.compressed_size)).c_str());
+    (void) filename;
+
+    if (jitc_cache_train_path) {
+        char filename_trn[512];
+        snprintf(filename_trn, sizeof(filename_trn), "%s/%016llx%016llx.%s.trn",
+                 jitc_cache_train_path, (unsigned long long) hash.high64,
+                 (unsigned long long) hash.low64,
+                 backend == JitBackend::CUDA ? "cuda" : "llvm");
+        FILE *f_trn = fopen(filename_trn, "wb");
+        if (!f_trn || fwrite(temp_in, 1, in_size, f_trn) != in_size)
+            jitc_log(Warn, "jit_kernel_write(): could not write \"%s\"",
+                     filename_trn);
+        if (f_trn)
+            fclose(f_trn);
     }
-#endif
 
     free(temp_out);
     free(temp_in);
@@ -446,7 +1099,10 @@ void jitc_kernel_free(int device_id, const Kernel &kernel) {
         if (kernel.llvm.n_reloc)
             free(kernel.llvm.reloc);
 #if !defined(_WIN32)
-        if (munmap((void *) kernel.data, kernel.size) == -1)
+        void *base;
+        size_t size;
+        jitc_kernel_pages(kernel, &base, &size);
+        if (munmap(base, size) == -1)
             jitc_fail("jit_kernel_free(): munmap() failed!");
 #else
         if (VirtualFree((void*) kernel.data, 0, MEM_RELEASE) == 0)
@@ -456,6 +1112,7 @@ void jitc_kernel_free(int device_id, const Kernel &kernel) {
         const Device &device = state.devices.at(device_id);
         if (kernel.size) {
             scoped_set_context guard(device.context);
+            jitc_cuda_tune_free(kernel);
             cuda_check(cuModuleUnload(kernel.cuda.mod));
             free(kernel.data);
         } else {
@@ -467,6 +1124,15 @@ void jitc_kernel_free(int device_id, const Kernel &kernel) {
 }
 
 void jitc_flush_kernel_cache() {
+    if (unlikely(state.frozen_functions))
+        jitc_raise("jit_flush_kernel_cache(): cannot flush the kernel cache "
+                   "while %u frozen function%s reference%s it!",
+                   state.frozen_functions,
+                   state.frozen_functions == 1 ? "" : "s",
+                   state.frozen_functions == 1 ? "s" : "");
+
+    jitc_llvm_tier_shutdown();
+
     jitc_log(Info, "jit_flush_kernel_cache(): releasing %zu kernel%s ..",
             state.kernel_cache.size(),
             state.kernel_cache.size() > 1 ? "s" : "");
@@ -477,4 +1143,311 @@ void jitc_flush_kernel_cache() {
     }
 
     state.kernel_cache.clear();
+    state.kernel_cache_size = 0;
+}
+
+void jitc_kernel_cache_trim() {
+    size_t max_size = state.kernel_cache_max_size;
+    uint32_t max_entries = state.kernel_cache_max_entries;
+
+    if ((!max_size || state.kernel_cache_size <= max_size) &&
+        (!max_entries || state.kernel_cache.size() <= max_entries))
+        return;
+
+    // Kernels cannot be unloaded while they are captured into a CUDA graph
+    for (ThreadState *ts : state.tss) {
+        if (ts->graph_capture)
+            return;
+    }
+
+    // Evicted kernels might still be running. Releases the lock briefly.
+    jitc_sync_all_devices();
+
+    /* Evict down to 7/8 of the limits so that the synchronization above
+       isn't needed again for the next few kernels */
+    size_t target_size = max_size - max_size / 8,
+           target_entries = max_entries - max_entries / 8;
+
+    std::vector<std::pair<uint64_t, KernelKey>> candidates;
+    for (auto &v : state.kernel_cache) {
+        if (v.second.pins == 0)
+            candidates.emplace_back(v.second.last_use, v.first);
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<uint64_t, KernelKey> &a,
+                 const std::pair<uint64_t, KernelKey> &b) {
+                  return a.first < b.first;
+              });
+
+    size_t evicted = 0;
+    for (auto &c : candidates) {
+        if ((!max_size || state.kernel_cache_size <= target_size) &&
+            (!max_entries || state.kernel_cache.size() <= target_entries))
+            break;
+
+        auto it = state.kernel_cache.find(c.second);
+        Kernel kernel = it.value();
+        state.kernel_cache.erase(it);
+        state.kernel_cache_size -= kernel.size + c.second.size;
+        jitc_kernel_free(c.second.device, kernel);
+        free(c.second.str);
+        evicted++;
+    }
+
+    state.kernel_evictions += evicted;
+    jitc_log(Debug, "jit_kernel_cache_trim(): evicted %zu kernel%s (%zu "
+             "remaining, %s).", evicted, evicted == 1 ? "" : "s",
+             state.kernel_cache.size(),
+             jitc_mem_string(state.kernel_cache_size));
+}
+
+uint32_t jitc_kernel_cache_manifest(const char *filename) {
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        jitc_raise("jit_kernel_cache_manifest(): could not open \"%s\": %s",
+                   filename, strerror(errno));
+
+    uint32_t count = 0;
+    for (auto &v : state.kernel_cache) {
+        const KernelKey &k = v.first;
+
+        // OptiX kernels are not part of the disk cache
+        if (k.flags || (k.device != -1 && v.second.size == 0))
+            continue;
+
+        fprintf(f, "%s %016llx%016llx\n", k.device == -1 ? "llvm" : "cuda",
+                (unsigned long long) k.hash.high64,
+                (unsigned long long) k.hash.low64);
+        count++;
+    }
+
+    fclose(f);
+
+    jitc_log(Info, "jit_kernel_cache_manifest(): wrote %u kernel%s to \"%s\".",
+             count, count == 1 ? "" : "s", filename);
+
+    return count;
+}
+
+struct PrefetchEntry {
+    JitBackend backend;
+    XXH128_hash_t hash;
+};
+
+struct PrefetchPayload {
+    std::vector<PrefetchEntry> entries;
+    int device = 0;
+    CUcontext context = nullptr;
+};
+
+/// Background task that is launched by jitc_kernel_cache_prefetch()
+void jitc_kernel_cache_tune(JitBackend backend, XXH128_hash_t hash,
+                            const Kernel &kernel) {
+#if !defined(_WIN32)
+    lock_guard guard(state.kernel_cache_lock);
+    hash = jitc_kernel_cache_key(backend, hash, nullptr, 0);
+    CacheDBKey key { hash.high64, hash.low64, (uint32_t) backend };
+    auto it = cache_db.index.find(key);
+    if (!cache_db.writable || it == cache_db.index.end())
+        return;
+
+    uint32_t config = jitc_kernel_launch_config(backend, kernel);
+    if (pwrite(cache_db.fd, &config, sizeof(uint32_t),
+               (off_t) (it->second + offsetof(CacheDBRecord, launch_config))) !=
+        (ssize_t) sizeof(uint32_t))
+        jitc_log(Debug, "jit_kernel_cache_tune(): could not update \"%s\".",
+                 cache_db.filename);
+#else
+    // Cache files are immutable, the tuning result only persists in memory
+    (void) backend; (void) hash; (void) kernel;
+#endif
+}
+
+static Task *jitc_prefetch_task = nullptr;
+
+/// Tells the background task to stop early
+static bool jitc_prefetch_stop = false;
+
+static void jitc_kernel_cache_prefetch_run(uint32_t, void *ptr) {
+    PrefetchPayload *p = (PrefetchPayload *) ptr;
+    uint32_t loaded = 0;
+
+    for (const PrefetchEntry &e : p->entries) {
+        // Only hold the lock while processing a single kernel
+        lock_guard guard(state.lock);
+        if (jitc_prefetch_stop)
+            break;
+
+        int device = e.backend == JitBackend::CUDA ? p->device : -1;
+        scoped_set_context_maybe guard_2(device != -1 ? p->context : nullptr);
+        size_t hash = KernelHash::compute_hash(e.hash.high64, device, 0);
+
+        CacheFileHeader header;
+        const char *compressed = nullptr, *filename = nullptr;
+        char *owned = nullptr, *source = nullptr;
+        Kernel kernel;
+        memset(&kernel, 0, sizeof(Kernel));
+
+        bool success;
+        /* Access the disk cache */ {
+            lock_guard guard_3(state.kernel_cache_lock);
+            success =
+                jitc_kernel_find(e.backend,
+                                 jitc_kernel_cache_key(e.backend, e.hash, nullptr, 0),
+                                 header, &compressed, &owned, &filename) &&
+                jitc_kernel_decode(nullptr, 0, e.backend, e.hash, header,
+                                   compressed, filename, kernel, &source);
+        }
+        free(owned);
+        if (!success)
+            continue;
+
+        KernelKey key(source, header.source_size, e.hash, device, 0);
+        bool loaded_cuda = false;
+
+        if (state.kernel_cache.find(key, hash) == state.kernel_cache.end() &&
+            e.backend == JitBackend::CUDA) {
+            try {
+                jitc_cuda_load(kernel, e.hash); // temporarily releases the lock
+                loaded_cuda = true;
+            } catch (const std::exception &ex) {
+                jitc_log(Warn, "jit_kernel_cache_prefetch(): %s", ex.what());
+                success = false;
+            }
+        }
+
+        // The kernel may have been created while the lock was released
+        if (success &&
+            state.kernel_cache.find(key, hash) == state.kernel_cache.end()) {
+            state.kernel_cache.emplace(key, kernel);
+            state.kernel_cache_size += kernel.size + key.size;
+            loaded++;
+            continue;
+        }
+
+        if (e.backend == JitBackend::LLVM || loaded_cuda)
+            jitc_kernel_free(device, kernel);
+        else
+            free(kernel.data);
+        free(source);
+    }
+
+    jitc_log(Info, "jit_kernel_cache_prefetch(): loaded %u/%zu kernel%s.",
+             loaded, p->entries.size(), p->entries.size() == 1 ? "" : "s");
+}
+
+void jitc_kernel_cache_prefetch(const char *filename) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        jitc_log(Info, "jit_kernel_cache_prefetch(): could not open \"%s\".",
+                 filename);
+        return;
+    }
+
+    jitc_kernel_cache_prefetch_wait();
+    /* Load the default dictionary */ {
+        lock_guard guard(state.kernel_cache_lock);
+        jitc_cache_dict_init();
+    }
+
+    PrefetchPayload *p = new PrefetchPayload();
+    bool has_cuda = state.backends & (uint32_t) JitBackend::CUDA,
+         has_llvm = state.backends & (uint32_t) JitBackend::LLVM;
+
+    if (has_cuda) {
+        ThreadState *ts = thread_state(JitBackend::CUDA);
+        p->device = ts->device;
+        p->context = ts->context;
+    }
+
+    char backend[5];
+    unsigned long long high64, low64;
+    while (fscanf(f, "%4s %16llx%16llx", backend, &high64, &low64) == 3) {
+        PrefetchEntry e;
+        e.backend = strcmp(backend, "cuda") == 0 ? JitBackend::CUDA
+                                                 : JitBackend::LLVM;
+        e.hash.high64 = (uint64_t) high64;
+        e.hash.low64 = (uint64_t) low64;
+
+        if (e.backend == JitBackend::CUDA ? has_cuda : has_llvm)
+            p->entries.push_back(e);
+    }
+    fclose(f);
+
+    jitc_log(Info, "jit_kernel_cache_prefetch(): loading %zu kernel%s in the "
+             "background ..", p->entries.size(),
+             p->entries.size() == 1 ? "" : "s");
+
+    jitc_prefetch_task = task_submit_dep(
+        nullptr, nullptr, 0, 1, jitc_kernel_cache_prefetch_run, p, 0,
+        [](void *ptr) { delete (PrefetchPayload *) ptr; });
+}
+
+void jitc_kernel_cache_prefetch_wait() {
+    Task *task = jitc_prefetch_task;
+    if (!task)
+        return;
+
+    jitc_prefetch_task = nullptr;
+    jitc_prefetch_stop = true;
+    /* Unlock while synchronizing */ {
+        unlock_guard guard(state.lock);
+        task_wait_and_release(task);
+    }
+    jitc_prefetch_stop = false;
+}
+
+void jitc_kernel_cache_set_dict(const char *filename) {
+    jitc_lz4_init();
+
+    char *dict = nullptr;
+    uint32_t dict_size = 0;
+
+    if (filename) {
+        FILE *f = fopen(filename, "rb");
+        if (!f)
+            jitc_raise("jit_set_kernel_cache_dict(): could not open \"%s\": %s",
+                       filename, strerror(errno));
+
+        // LZ4 only references the last 64 KiB of its input
+        dict = (char *) malloc_check(jitc_lz4_dict_size);
+        dict_size = (uint32_t) fread(dict, 1, jitc_lz4_dict_size, f);
+        bool too_large = fgetc(f) != EOF;
+        fclose(f);
+
+        if (dict_size == 0 || too_large) {
+            free(dict);
+            jitc_raise("jit_set_kernel_cache_dict(): \"%s\" must be a "
+                       "non-empty file of at most %i bytes.", filename,
+                       jitc_lz4_dict_size);
+        }
+    }
+
+    // Finish using the current dictionary before switching
+    jitc_kernel_cache_prefetch_wait();
+    lock_guard guard(state.kernel_cache_lock);
+    jitc_kernel_cache_close();
+
+    if (jitc_cache_dict != jitc_lz4_dict)
+        free(jitc_cache_dict);
+
+    if (dict) {
+        XXH128_hash_t hash = XXH128(dict, dict_size, 0);
+        jitc_cache_dict = dict;
+        jitc_cache_dict_size = dict_size;
+        jitc_cache_dict_id = (uint32_t) hash.low64 | 1u;
+        jitc_log(Info, "jit_set_kernel_cache_dict(): using dictionary \"%s\" "
+                 "(%u bytes, id %08x).", filename, dict_size,
+                 jitc_cache_dict_id);
+    } else {
+        jitc_cache_dict = nullptr;
+        jitc_cache_dict_init();
+    }
+}
+
+void jitc_kernel_cache_set_train_path(const char *path) {
+    lock_guard guard(state.kernel_cache_lock);
+    free(jitc_cache_train_path);
+    jitc_cache_train_path = path ? strdup(path) : nullptr;
 }
@@ -23,6 +23,13 @@ enum class JitBackend: uint32_t;
 struct Kernel {
     void *data;
     uint32_t size;
+
+    /// Number of frozen functions using this kernel (these prevent eviction)
+    uint32_t pins;
+
+    /// Timestamp of the last launch (for LRU eviction from the kernel cache)
+    uint64_t last_use;
+
     union {
         /// 1. CUDA
         struct {
@@ -34,6 +41,9 @@ struct Kernel {
 
             // Preferred block size to maximize occupancy
             uint32_t block_size;
+
+            /// Launch configuration found by the autotuner (0: not tuned)
+            uint16_t tuned_threads, tuned_blocks_per_sm;
         } cuda;
 
         /// 2. LLVM
@@ -44,6 +54,12 @@ struct Kernel {
             /// Length of the 'reloc' table
             uint32_t n_reloc;
 
+            /// Optimization tier of the generated code (an \ref LLVMTier)
+            uint32_t tier;
+
+            /// Launches since compilation (only tracked for LLVMTier::Fast)
+            uint32_t launches;
+
 #if defined(DRJIT_ENABLE_ITTNOTIFY)
             void *itt;
 #endif
@@ -78,4 +94,29 @@ extern bool jitc_kernel_write(const char *source, uint32_t source_size,
 
 extern void jitc_kernel_free(int device_id, const Kernel &kernel);
 
+/// Record the tuned launch configuration of a CUDA kernel in the disk cache
+extern void jitc_kernel_cache_tune(JitBackend backend, XXH128_hash_t hash,
+                                   const Kernel &kernel);
+
 extern void jitc_flush_kernel_cache();
+
+/// Evict the least recently used kernels if the kernel cache exceeds its limits
+extern void jitc_kernel_cache_trim();
+
+/// Close the on-disk kernel cache database (if open), needs 'kernel_cache_lock'
+extern void jitc_kernel_cache_close();
+
+/// Compress new cache entries using a custom dictionary (NULL: builtin)
+extern void jitc_kernel_cache_set_dict(const char *filename);
+
+/// Record training data for dictionaries in the given directory (NULL: stop)
+extern void jitc_kernel_cache_set_train_path(const char *path);
+
+/// Write the hashes of all kernels in the in-memory cache to a manifest file
+extern uint32_t jitc_kernel_cache_manifest(const char *filename);
+
+/// Load the kernels listed in a manifest file in the background
+extern void jitc_kernel_cache_prefetch(const char *filename);
+
+/// Stop and wait for a pending jitc_kernel_cache_prefetch() operation
+extern void jitc_kernel_cache_prefetch_wait();
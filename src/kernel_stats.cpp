@@ -0,0 +1,320 @@
+/*
+    src/kernel_stats.cpp -- Aggregated kernel statistics and trace export
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+
+    Unlike the kernel history, which stores a record (including a copy of the
+    IR) per launch, the kernel profiler merges all launches of a kernel into
+    a single set of counters. The execution time of a launch is only known
+    once it has finished, hence launches are first queued and then resolved
+    in batches, or when a report is requested. Resolved launches are also
+    kept as spans (up to a limit) for the Chrome trace export.
+*/
+
+#include "internal.h"
+#include "kernel_stats.h"
+#include "log.h"
+#include "strbuf.h"
+#include <algorithm>
+#include <chrono>
+
+static StringBuffer kernel_stats_buffer(0);
+
+/// Microseconds since the start of the profile
+static double jitc_kernel_stats_time() {
+    uint64_t now = (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    KernelStats &s = state.kernel_stats;
+    if (s.epoch == 0)
+        s.epoch = now;
+
+    return (double) (now - s.epoch);
+}
+
+/// Create a CUDA event that is suitable for timing
+static CUevent jitc_kernel_stats_event() {
+    CUevent event;
+    cuda_check(cuEventCreate(&event, CU_EVENT_DEFAULT));
+    return event;
+}
+
+static void jitc_kernel_stats_add_span(uint32_t record, uint32_t track,
+                                       uint32_t kind, size_t size,
+                                       double start, double duration) {
+    KernelStats &s = state.kernel_stats;
+    if (s.spans.size() >= DRJIT_KERNEL_TRACE_LIMIT) {
+        s.spans_dropped++;
+        return;
+    }
+    s.spans.push_back({ record, track, kind, size, start, duration });
+}
+
+void jitc_kernel_stats_begin(KernelStatsLaunch &l, CUstream stream) {
+    KernelStats &s = state.kernel_stats;
+    l.time = jitc_kernel_stats_time();
+    l.event_start = l.event_end = nullptr;
+    l.task = nullptr;
+
+    if (l.backend == JitBackend::CUDA) {
+        // Per device, record a reference event to relate GPU and host time
+        size_t device = (size_t) l.device;
+        if (device >= s.cuda_ref.size()) {
+            s.cuda_ref.resize(device + 1, nullptr);
+            s.cuda_ref_time.resize(device + 1, 0.0);
+        }
+
+        if (!s.cuda_ref[device]) {
+            s.cuda_ref[device] = jitc_kernel_stats_event();
+            cuda_check(cuEventRecord(s.cuda_ref[device], stream));
+            s.cuda_ref_time[device] = l.time;
+        }
+
+        l.event_start = jitc_kernel_stats_event();
+        l.event_end = jitc_kernel_stats_event();
+        cuda_check(cuEventRecord(l.event_start, stream));
+    }
+}
+
+/// Wait for the 'count' oldest pending launches, and add them to the profile
+static void jitc_kernel_stats_resolve(size_t count) {
+    KernelStats &s = state.kernel_stats;
+    count = std::min(count, s.pending.size());
+
+    for (size_t i = 0; i < count; ++i) {
+        KernelStatsLaunch &l = s.pending[i];
+        KernelStatsRecord &r = s.records[l.record];
+        double start, duration;
+        uint32_t track;
+
+        if (l.backend == JitBackend::CUDA) {
+            float offset = 0.f, elapsed = 0.f;
+            cuda_check(cuEventSynchronize(l.event_end));
+            cuda_check(cuEventElapsedTime(&offset, s.cuda_ref[l.device],
+                                          l.event_start));
+            cuda_check(cuEventElapsedTime(&elapsed, l.event_start,
+                                          l.event_end));
+            cuda_check(cuEventDestroy(l.event_start));
+            cuda_check(cuEventDestroy(l.event_end));
+
+            track = 2 + (uint32_t) l.device;
+            start = s.cuda_ref_time[l.device] + offset * 1000.0;
+            duration = elapsed * 1000.0;
+        } else {
+            duration = 0.0;
+            if (l.task) {
+                task_wait(l.task);
+                duration = task_time(l.task) * 1000.0;
+                task_release(l.task);
+            }
+
+            /* The thread pool doesn't report when a task started. Launches of
+               a thread run one after the other, hence the span starts at the
+               later of the submission time and the end of the last span. */
+            track = 1;
+            start = l.time;
+            if (s.track_end.size() > track)
+                start = std::max(start, s.track_end[track]);
+        }
+
+        if (s.track_end.size() <= track)
+            s.track_end.resize(track + 1, 0.0);
+        s.track_end[track] = std::max(s.track_end[track], start + duration);
+
+        r.execution_time += duration;
+        jitc_kernel_stats_add_span(l.record, track, 2, l.size, start, duration);
+    }
+
+    s.pending.erase(s.pending.begin(), s.pending.begin() + count);
+}
+
+void jitc_kernel_stats_end(KernelStatsLaunch &l, CUstream stream, Task *task) {
+    KernelStats &s = state.kernel_stats;
+
+    if (l.backend == JitBackend::CUDA) {
+        cuda_check(cuEventRecord(l.event_end, stream));
+    } else if (task) {
+        task_retain(task);
+        l.task = task;
+    }
+
+    uint64_t key = l.hash[1];
+    if (l.type != KernelType::JIT)
+        key = ((uint64_t) l.backend << 8 | (uint64_t) l.type) + 1;
+
+    auto result = s.record_map.try_emplace(key, (uint32_t) s.records.size());
+    if (result.second) {
+        KernelStatsRecord r;
+        r.backend = l.backend;
+        r.type = l.type;
+        r.hash[0] = l.hash[0];
+        r.hash[1] = l.hash[1];
+        s.records.push_back(r);
+    }
+
+    l.record = result.first->second;
+    KernelStatsRecord &r = s.records[l.record];
+    r.launches++;
+    r.compilations += l.backend_time > 0.f;
+    r.size += l.size;
+    r.bytes_in += l.bytes_in;
+    r.bytes_out += l.bytes_out;
+    r.codegen_time += l.codegen_time;
+    r.backend_time += l.backend_time;
+
+    // Host work immediately preceded the submission of the kernel
+    double t = l.time - l.backend_time;
+    if (l.backend_time > 0.f)
+        jitc_kernel_stats_add_span(l.record, 0, 1, l.size, t, l.backend_time);
+    if (l.codegen_time > 0.f)
+        jitc_kernel_stats_add_span(l.record, 0, 0, l.size,
+                                   t - l.codegen_time, l.codegen_time);
+
+    s.pending.push_back(l);
+    if (s.pending.size() >= DRJIT_KERNEL_STATS_PENDING)
+        jitc_kernel_stats_resolve(s.pending.size() / 2);
+}
+
+/// Name of a kernel in the report and trace
+static const char *jitc_kernel_stats_name(const KernelStatsRecord &r) {
+    static char name[32];
+    switch (r.type) {
+        case KernelType::JIT:
+            snprintf(name, sizeof(name), "%016llx",
+                     (unsigned long long) r.hash[1]);
+            return name;
+        case KernelType::Reduce: return "reduce";
+        case KernelType::VCallReduce: return "vcall_reduce";
+        default: return "other";
+    }
+}
+
+const char *jitc_kernel_stats() {
+    KernelStats &s = state.kernel_stats;
+    StringBuffer &buf = kernel_stats_buffer;
+    buf.clear();
+
+    jitc_kernel_stats_resolve(s.pending.size());
+
+    buf.put("\n  Kernel statistics\n");
+    buf.put("  =================\n");
+
+    if (!(jitc_flags() & (uint32_t) JitFlag::KernelStats))
+        buf.put("\n  Note: JitFlag::KernelStats is currently disabled.\n");
+
+    if (s.records.empty()) {
+        buf.put("\n  No kernels were launched.\n");
+        return buf.get();
+    }
+
+    std::vector<uint32_t> order(s.records.size());
+    for (uint32_t i = 0; i < (uint32_t) order.size(); ++i)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return s.records[a].execution_time > s.records[b].execution_time;
+    });
+
+    uint64_t launches = 0;
+    double execution_time = 0;
+    for (const KernelStatsRecord &r : s.records) {
+        launches += r.launches;
+        execution_time += r.execution_time;
+    }
+
+    buf.fmt("\n  Kernels: %zu, launches: %llu, ", s.records.size(),
+            (unsigned long long) launches);
+    buf.fmt("execution time: %s.\n\n", jitc_time_string((float) execution_time));
+
+    buf.put("    Kernel             Backend  Launches   Compiled  Mean size   "
+            "Codegen    Backend    Execution  Mean exec.  Input      Output\n");
+    buf.put("    ----------------------------------------------------------------"
+            "-----------------------------------------------------------------\n");
+
+    for (size_t i = 0; i < order.size() && i < 50; ++i) {
+        const KernelStatsRecord &r = s.records[order[i]];
+        double n = (double) r.launches;
+
+        buf.fmt("    %-18s %-8s %-10llu %-9llu %-11llu ",
+                jitc_kernel_stats_name(r),
+                r.backend == JitBackend::CUDA ? "cuda" : "llvm",
+                (unsigned long long) r.launches,
+                (unsigned long long) r.compilations,
+                (unsigned long long) (r.size / r.launches));
+        buf.fmt("%-10s ", jitc_time_string((float) r.codegen_time));
+        buf.fmt("%-10s ", jitc_time_string((float) r.backend_time));
+        buf.fmt("%-10s ", jitc_time_string((float) r.execution_time));
+        buf.fmt("%-11s ", jitc_time_string((float) (r.execution_time / n)));
+        buf.fmt("%-10s ", jitc_mem_string((size_t) r.bytes_in));
+        buf.fmt("%s\n", jitc_mem_string((size_t) r.bytes_out));
+    }
+
+    if (order.size() > 50)
+        buf.fmt("    (%zu more)\n", order.size() - 50);
+
+    return buf.get();
+}
+
+const char *jitc_kernel_stats_trace() {
+    KernelStats &s = state.kernel_stats;
+    StringBuffer &buf = kernel_stats_buffer;
+    buf.clear();
+
+    jitc_kernel_stats_resolve(s.pending.size());
+
+    buf.put("{\n  \"displayTimeUnit\": \"ms\",\n");
+    buf.fmt("  \"otherData\": { \"dropped_spans\": %zu },\n", s.spans_dropped);
+    buf.put("  \"traceEvents\": [\n");
+
+    uint32_t track_count = 2 + (uint32_t) s.cuda_ref.size();
+    for (uint32_t i = 0; i < track_count; ++i) {
+        buf.fmt("    { \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"name\": "
+                "\"thread_name\", \"args\": { \"name\": \"", i);
+        if (i == 0)
+            buf.put("Host (codegen, compilation)");
+        else if (i == 1)
+            buf.put("LLVM");
+        else
+            buf.fmt("CUDA device %u", i - 2);
+        buf.put("\" } },\n");
+    }
+
+    const char *kind_name[] = { "codegen", "compile", "kernel" };
+    for (const KernelTraceSpan &span : s.spans) {
+        const KernelStatsRecord &r = s.records[span.record];
+        buf.fmt("    { \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"name\": \"%s\", "
+                "\"cat\": \"%s\", \"ts\": %.3f, \"dur\": %.3f, \"args\": "
+                "{ \"size\": %zu } },\n",
+                span.track, jitc_kernel_stats_name(r), kind_name[span.kind],
+                span.start, span.duration, span.size);
+    }
+
+    // Remove the trailing comma
+    buf.rewind_to(buf.size() - 2);
+    buf.put("\n  ]\n}\n");
+
+    return buf.get();
+}
+
+void jitc_kernel_stats_clear() {
+    KernelStats &s = state.kernel_stats;
+
+    for (KernelStatsLaunch &l : s.pending) {
+        if (l.backend == JitBackend::CUDA) {
+            cuEventDestroy(l.event_start);
+            cuEventDestroy(l.event_end);
+        } else if (l.task) {
+            task_release(l.task);
+        }
+    }
+
+    for (CUevent event : s.cuda_ref) {
+        if (event)
+            cuEventDestroy(event);
+    }
+
+    s = KernelStats();
+}
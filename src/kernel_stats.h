@@ -0,0 +1,127 @@
+/*
+    src/kernel_stats.h -- Aggregated kernel statistics and trace export
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <drjit-core/jit.h>
+#include "cuda.h"
+#include <vector>
+
+struct Task;
+
+/// Maximum number of spans that are kept for jitc_kernel_stats_trace()
+#define DRJIT_KERNEL_TRACE_LIMIT (1u << 20)
+
+/// Number of unresolved launches that triggers their resolution
+#define DRJIT_KERNEL_STATS_PENDING 1024
+
+/// Counters of all launches of one kernel (JitFlag::KernelStats)
+struct KernelStatsRecord {
+    JitBackend backend;
+    KernelType type;
+    uint64_t hash[2];
+
+    /// Number of launches, and how many of them compiled the kernel
+    uint64_t launches = 0, compilations = 0;
+
+    /// Total number of processed array entries
+    uint64_t size = 0;
+
+    /// Total size of the input and output arrays in bytes
+    uint64_t bytes_in = 0, bytes_out = 0;
+
+    /// Accumulated times in microseconds
+    double codegen_time = 0, backend_time = 0, execution_time = 0;
+};
+
+/// Information about a kernel launch, passed to jitc_kernel_stats_end()
+struct KernelStatsLaunch {
+    JitBackend backend;
+    KernelType type;
+    uint64_t hash[2];
+    int device;
+    size_t size;
+    uint64_t bytes_in, bytes_out;
+
+    /// Time (us) spent generating the IR and compiling the kernel
+    float codegen_time, backend_time;
+
+    // Set by jitc_kernel_stats_begin()/end()
+    // ======================================
+
+    /// Submission time in microseconds relative to KernelStats::epoch
+    double time;
+
+    /// CUDA events for measuring the runtime of the kernel
+    CUevent event_start, event_end;
+
+    /// nanothread task handle (LLVM)
+    Task *task;
+
+    /// Index of the associated KernelStatsRecord
+    uint32_t record;
+};
+
+/// Resolved execution of a kernel, or a span of host work (trace export)
+struct KernelTraceSpan {
+    /// Index of the associated KernelStatsRecord
+    uint32_t record;
+
+    /// 0: host (codegen/compilation), 1: LLVM, 2+i: CUDA device i
+    uint32_t track;
+
+    /// 0: code generation, 1: compilation, 2: execution
+    uint32_t kind;
+
+    /// Launch width
+    size_t size;
+
+    /// Start and duration in microseconds
+    double start, duration;
+};
+
+/// State of the kernel profiler (only active with JitFlag::KernelStats)
+struct KernelStats {
+    /// Per-kernel counters, and a map from kernel hashes to them
+    std::vector<KernelStatsRecord> records;
+    tsl::robin_map<uint64_t, uint32_t, UInt64Hasher> record_map;
+
+    /// Launches that still have to be timed
+    std::vector<KernelStatsLaunch> pending;
+
+    /// Spans of resolved launches in order of submission
+    std::vector<KernelTraceSpan> spans;
+    size_t spans_dropped = 0;
+
+    /// Start of the profile (us since an arbitrary point in time)
+    uint64_t epoch = 0;
+
+    /// Per CUDA device: recorded event at host time 'cuda_ref_time'
+    std::vector<CUevent> cuda_ref;
+    std::vector<double> cuda_ref_time;
+
+    /// End of the last span per track (LLVM spans are reconstructed)
+    std::vector<double> track_end;
+};
+
+/// Note the submission of a kernel (before it is launched on 'stream')
+extern void jitc_kernel_stats_begin(KernelStatsLaunch &launch, CUstream stream);
+
+/// Note that a kernel was launched, and accumulate its statistics
+extern void jitc_kernel_stats_end(KernelStatsLaunch &launch, CUstream stream,
+                                  Task *task);
+
+/// Return a report of the per-kernel statistics
+extern const char *jitc_kernel_stats();
+
+/// Return a Chrome trace (JSON) of the profiled kernel launches
+extern const char *jitc_kernel_stats_trace();
+
+/// Clear the kernel statistics and trace
+extern void jitc_kernel_stats_clear();
@@ -12,10 +12,76 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <vector>
+#include <string>
+#include "hash.h"
 
 // Forward declarations
 struct Task;
 struct Kernel;
+struct KernelKey;
+struct StringBuffer;
+
+/**
+ * \brief Optimization tier of a kernel compiled by the LLVM backend
+ *
+ * See \ref JitFlag::TieredCompile. Kernels that are loaded from the disk
+ * cache or compiled without this flag use \ref LLVMTier::Default.
+ */
+enum class LLVMTier : uint32_t {
+    /// Standard optimization pipeline (O2)
+    Default = 0,
+
+    /// Quick compilation (O1), eligible for a tier-up
+    Fast = 1,
+
+    /// Like \ref Fast, but an optimized version is being compiled
+    Compiling = 2,
+
+    /// Aggressive optimization (O3 with loop and SLP vectorization)
+    Optimized = 3
+};
+
+/// Output buffer of a memory manager that receives code generated by LLVM
+struct LLVMMemMgr {
+    /// Internal storage
+    uint8_t *data = nullptr;
+
+    /// Current position within 'data'
+    size_t offset = 0;
+
+    /// Size of the buffer backing 'data'
+    size_t size = 0;
+
+    /// Was a global offset table (GOT) generated?
+    bool got = false;
+};
+
+/**
+ * \brief Self-contained instance of the LLVM compilation pipeline
+ *
+ * Bundles the LLVM context, target machine, JIT engine, and memory manager
+ * used to turn LLVM IR into machine code. The main instance is used by
+ * jitc_llvm_compile(Kernel &). When ORCv2 is available, worker threads obtain
+ * further instances from a pool so that several kernels can be compiled at
+ * the same time (see jitc_llvm_compile_ir()).
+ */
+struct LLVMCompiler {
+    /// LLVM context that owns the parsed modules (LLVMContextRef)
+    void *context = nullptr;
+
+    /// Target machine used by the optimization passes (LLVMTargetMachineRef)
+    void *tm = nullptr;
+
+    /// ORCv2 JIT instance and its main library (LLVMOrcLLJITRef, LLVMOrcJITDylibRef)
+    void *lljit = nullptr;
+    void *dylib = nullptr;
+
+    /// Receives the generated machine code
+    LLVMMemMgr memmgr;
+
+    /// Value of 'jitc_llvm_target_id' when this instance was created
+    uint32_t target_id = 0;
+};
 
 /// Current top-level task in the task queue
 extern Task *jitc_task;
@@ -37,6 +103,9 @@ extern bool jitc_llvm_api_has_orcv2();
 extern bool jitc_llvm_api_has_pb_legacy();
 extern bool jitc_llvm_api_has_pb_new();
 
+/// Can modules be serialized to bitcode and their attributes be edited?
+extern bool jitc_llvm_api_has_bitcode();
+
 /// String describing the LLVM target
 extern char *jitc_llvm_target_triple;
 
@@ -49,6 +118,12 @@ extern char *jitc_llvm_target_features;
 /// Vector width of code generated by the LLVM backend
 extern uint32_t jitc_llvm_vector_width;
 
+/// SVE register size in multiples of 128 bit (or zero when SVE is not used)
+extern uint32_t jitc_llvm_vscale;
+
+/// Is the given feature (e.g. "avx512f") enabled in 'jitc_llvm_target_features'?
+extern bool jitc_llvm_has_feature(const char *name);
+
 /// Should the LLVM IR use typed (e.g., "i8*") or untyped ("ptr") pointers?
 extern bool jitc_llvm_opaque_pointers;
 
@@ -74,14 +149,91 @@ extern bool jitc_llvm_orcv2_init();
 extern void jitc_llvm_mcjit_shutdown();
 extern void jitc_llvm_orcv2_shutdown();
 
-/// Run the MCJIT/ORCv2-based compiler on the given module
-extern void jitc_llvm_mcjit_compile(void *llvm_module,
+/// Set up/release the ORCv2 JIT of a compiler instance
+extern bool jitc_llvm_orcv2_create(LLVMCompiler &c);
+extern void jitc_llvm_orcv2_destroy(LLVMCompiler &c);
+
+/// Run the MCJIT/ORCv2-based compiler on the given module and resolve 'names'
+extern void jitc_llvm_mcjit_compile(LLVMCompiler &c, void *llvm_module,
+                                    const std::vector<std::string> &names,
                                     std::vector<uint8_t *> &symbols);
-extern void jitc_llvm_orcv2_compile(void *llvm_module,
+extern void jitc_llvm_orcv2_compile(LLVMCompiler &c, void *llvm_module,
+                                    const std::vector<std::string> &names,
                                     std::vector<uint8_t *> &symbols);
 
 /// Compile the current IR string and store the resulting kernel into `kernel`
-extern void jitc_llvm_compile(Kernel &kernel);
+extern void jitc_llvm_compile(Kernel &kernel,
+                              LLVMTier tier = LLVMTier::Default);
+
+/**
+ * \brief Return the names of the functions that jitc_llvm_compile() must
+ * resolve for the current IR string
+ *
+ * The kernel entry point comes first, followed by the \c @callables table
+ * and the functions it references. This information is derived from global
+ * state written by jitc_assemble(), hence it must be captured before the
+ * next kernel is assembled if the kernel is compiled later on.
+ */
+extern std::vector<std::string> jitc_llvm_compile_symbols();
+
+/// Can jitc_llvm_compile_ir() be called from several threads at once?
+extern bool jitc_llvm_compile_is_concurrent();
+
+/**
+ * \brief Compile the given IR string and store the resulting kernel into
+ * `kernel`
+ *
+ * In contrast to jitc_llvm_compile(Kernel &), this function does not access
+ * global state written by jitc_assemble(). When
+ * jitc_llvm_compile_is_concurrent() returns \c true, each call uses a
+ * compiler instance from a pool, and the function may be called from several
+ * threads at once without holding 'state.lock'. Otherwise (MCJIT), it uses the
+ * main compiler instance and requires 'state.lock'.
+ */
+extern void jitc_llvm_compile_ir(const char *source, size_t size,
+                                 const std::vector<std::string> &names,
+                                 Kernel &kernel,
+                                 LLVMTier tier = LLVMTier::Default);
+
+/// Return the tier used to compile new kernels (see \ref JitFlag::TieredCompile)
+extern LLVMTier jitc_llvm_tier_initial();
+
+/**
+ * \brief Count a launch of a cached kernel, and return \c true if it should
+ * now be recompiled using jitc_llvm_tier_up()
+ */
+extern bool jitc_llvm_tier_count(Kernel &kernel);
+
+/**
+ * \brief Recompile the kernel cache entry (key, kernel) using \ref
+ * LLVMTier::Optimized in the background
+ *
+ * 'names' specifies the functions to be resolved (see
+ * jitc_llvm_compile_symbols()). The optimized code replaces the cache entry
+ * once it is ready, and it is also written to the disk cache. The previous
+ * version may still be running and is released by jitc_llvm_tier_release()
+ * or jitc_llvm_tier_shutdown().
+ */
+extern void jitc_llvm_tier_up(const KernelKey &key, Kernel &kernel,
+                              const std::vector<std::string> &names);
+
+/// Count a finished LLVM evaluation (its tasks are part of 'jitc_task')
+extern void jitc_llvm_tier_eval_done();
+
+/// Return the number of finished LLVM evaluations
+extern uint32_t jitc_llvm_tier_evals_done();
+
+/**
+ * \brief Release superseded kernels that can no longer be running
+ *
+ * 'evals' is the value of \ref jitc_llvm_tier_evals_done() at the time when
+ * the caller captured 'jitc_task', and the caller must have waited for that
+ * task to finish.
+ */
+extern void jitc_llvm_tier_release(uint32_t evals);
+
+/// Wait for pending recompilations and release superseded kernels
+extern void jitc_llvm_tier_shutdown();
 
 /// Dump disassembly for the given kernel
 extern void jitc_llvm_disasm(const Kernel &kernel);
@@ -91,6 +243,38 @@ extern void jitc_llvm_set_target(const char *target_cpu,
                                  const char *target_features,
                                  uint32_t vector_width);
 
+/// Append the attribute group for the given target (the last line of the IR)
+extern void jitc_llvm_put_attributes(StringBuffer &buf, const char *cpu,
+                                     const char *features);
+
+/// Return the offset of the attribute group within an IR string
+extern size_t jitc_llvm_attributes_offset(const char *source, size_t size);
+
+/**
+ * \brief Identify the target of an IR string by hashing its attribute group
+ *
+ * Kernel hashes don't cover the attribute group, so that kernels compiled for
+ * different CPUs share their name and hash. The disk cache instead combines
+ * the hash with this value. When \c source is \c nullptr, the function
+ * returns the value for the current target.
+ */
+extern uint64_t jitc_llvm_target_tag(const char *source, size_t size);
+
+/// Also write kernels for the given target to the disk cache (nullptr: clear)
+extern void jitc_llvm_add_target_version(const char *target_cpu,
+                                         const char *target_features);
+
+/**
+ * \brief Compile the IR string for the targets registered via
+ * jitc_llvm_add_target_version() and write the results to the disk cache
+ *
+ * 'names' and 'tier' match the parameters of jitc_llvm_compile_ir().
+ */
+extern void jitc_llvm_write_versions(const char *source, size_t size,
+                                     XXH128_hash_t hash,
+                                     const std::vector<std::string> &names,
+                                     LLVMTier tier = LLVMTier::Default);
+
 /// Insert a ray tracing function call into the LLVM program
 extern void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
                                 const uint32_t *in, uint32_t *out);
@@ -39,6 +39,7 @@ bool jitc_llvm_api_has_mcjit() { return true; }
 bool jitc_llvm_api_has_orcv2() { return LLVM_VERSION_MAJOR >= 16; }
 bool jitc_llvm_api_has_pb_legacy() { return LLVM_VERSION_MAJOR < 17; }
 bool jitc_llvm_api_has_pb_new() { return LLVM_VERSION_MAJOR >= 15; }
+bool jitc_llvm_api_has_bitcode() { return true; }
 int jitc_llvm_version_major = LLVM_VERSION_MAJOR;
 int jitc_llvm_version_minor = LLVM_VERSION_MINOR;
 int jitc_llvm_version_patch = LLVM_VERSION_PATCH;
@@ -53,6 +54,7 @@ static bool jitc_llvm_has_mcjit = false;
 static bool jitc_llvm_has_orcv2 = false;
 static bool jitc_llvm_has_pb_legacy = false;
 static bool jitc_llvm_has_pb_new = false;
+static bool jitc_llvm_has_bitcode = false;
 
 int jitc_llvm_version_major = -1;
 int jitc_llvm_version_minor = -1;
@@ -94,6 +96,7 @@ bool jitc_llvm_api_init() {
     jitc_llvm_has_orcv2 = true;
     jitc_llvm_has_pb_legacy = true;
     jitc_llvm_has_pb_new = true;
+    jitc_llvm_has_bitcode = true;
     jitc_llvm_version_major = -1;
     jitc_llvm_version_minor = -1;
     jitc_llvm_version_patch = -1;
@@ -111,6 +114,8 @@ bool jitc_llvm_api_init() {
     LOAD(core, LLVMGetHostCPUName);
     LOAD(core, LLVMGetHostCPUFeatures);
     LOAD(core, LLVMGetGlobalContext);
+    LOAD(core, LLVMContextCreate);
+    LOAD(core, LLVMContextDispose);
     LOAD(core, LLVMCreateDisasm);
     LOAD(core, LLVMDisasmDispose);
     LOAD(core, LLVMSetDisasmOptions);
@@ -127,6 +132,16 @@ bool jitc_llvm_api_init() {
 
     LOAD(version, LLVMGetVersion);
 
+    LOAD(bitcode, LLVMWriteBitcodeToMemoryBuffer);
+    LOAD(bitcode, LLVMParseBitcodeInContext2);
+    LOAD(bitcode, LLVMDisposeMemoryBuffer);
+    LOAD(bitcode, LLVMGetFirstFunction);
+    LOAD(bitcode, LLVMGetNextFunction);
+    LOAD(bitcode, LLVMGetStringAttributeAtIndex);
+    LOAD(bitcode, LLVMCreateStringAttribute);
+    LOAD(bitcode, LLVMAddAttributeAtIndex);
+    LOAD(bitcode, LLVMRemoveStringAttributeAtIndex);
+
     LOAD(pb_legacy, LLVMCreatePassManager);
     LOAD(pb_legacy, LLVMRunPassManager);
     LOAD(pb_legacy, LLVMDisposePassManager);
@@ -252,6 +267,8 @@ void jitc_llvm_api_shutdown() {
     CLEAR(LLVMGetHostCPUName);
     CLEAR(LLVMGetHostCPUFeatures);
     CLEAR(LLVMGetGlobalContext);
+    CLEAR(LLVMContextCreate);
+    CLEAR(LLVMContextDispose);
     CLEAR(LLVMCreateDisasm);
     CLEAR(LLVMDisasmDispose);
     CLEAR(LLVMSetDisasmOptions);
@@ -269,6 +286,17 @@ void jitc_llvm_api_shutdown() {
     // Version
     CLEAR(LLVMGetVersion);
 
+    // Bitcode
+    CLEAR(LLVMWriteBitcodeToMemoryBuffer);
+    CLEAR(LLVMParseBitcodeInContext2);
+    CLEAR(LLVMDisposeMemoryBuffer);
+    CLEAR(LLVMGetFirstFunction);
+    CLEAR(LLVMGetNextFunction);
+    CLEAR(LLVMGetStringAttributeAtIndex);
+    CLEAR(LLVMCreateStringAttribute);
+    CLEAR(LLVMAddAttributeAtIndex);
+    CLEAR(LLVMRemoveStringAttributeAtIndex);
+
     // Legacy pass manager
     CLEAR(LLVMCreatePassManager);
     CLEAR(LLVMRunPassManager);
@@ -324,6 +352,7 @@ void jitc_llvm_api_shutdown() {
     jitc_llvm_has_orcv2 = false;
     jitc_llvm_has_pb_legacy = false;
     jitc_llvm_has_pb_new = false;
+    jitc_llvm_has_bitcode = false;
     jitc_llvm_version_major = -1;
     jitc_llvm_version_minor = -1;
     jitc_llvm_version_patch = -1;
@@ -334,5 +363,6 @@ bool jitc_llvm_api_has_mcjit() { return jitc_llvm_has_mcjit; }
 bool jitc_llvm_api_has_orcv2() { return jitc_llvm_has_orcv2; }
 bool jitc_llvm_api_has_pb_legacy() { return jitc_llvm_has_pb_legacy; }
 bool jitc_llvm_api_has_pb_new() { return jitc_llvm_has_pb_new; }
+bool jitc_llvm_api_has_bitcode() { return jitc_llvm_has_bitcode; }
 
 #endif
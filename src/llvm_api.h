@@ -28,6 +28,8 @@
 #  include <llvm-c/ExecutionEngine.h>
 #  include <llvm-c/Disassembler.h>
 #  include <llvm-c/IRReader.h>
+#  include <llvm-c/BitReader.h>
+#  include <llvm-c/BitWriter.h>
 #  include <llvm-c/Analysis.h>
 #  if LLVM_VERSION_MAJOR >= 15
 #    include <llvm-c/Transforms/PassBuilder.h>
@@ -46,12 +48,15 @@
 #  define LLVMCodeGenLevelAggressive 3
 #  define LLVMRelocPIC 2
 #  define LLVMCodeModelSmall 3
+#  define LLVMAttributeFunctionIndex (~0u)
 
 /// LLVM API
 using LLVMBool = int;
 using LLVMDisasmContextRef = void *;
 using LLVMExecutionEngineRef = void *;
 using LLVMModuleRef = void *;
+using LLVMValueRef = void *;
+using LLVMAttributeRef = void *;
 using LLVMMemoryBufferRef = void *;
 using LLVMContextRef = void *;
 using LLVMPassManagerRef = void *;
@@ -109,6 +114,8 @@ DR_LLVM_SYM(char *(*LLVMGetDefaultTargetTriple)());
 DR_LLVM_SYM(char *(*LLVMGetHostCPUName)());
 DR_LLVM_SYM(char *(*LLVMGetHostCPUFeatures)());
 DR_LLVM_SYM(LLVMContextRef (*LLVMGetGlobalContext)());
+DR_LLVM_SYM(LLVMContextRef (*LLVMContextCreate)());
+DR_LLVM_SYM(void (*LLVMContextDispose)(LLVMContextRef));
 DR_LLVM_SYM(LLVMDisasmContextRef (*LLVMCreateDisasm)(const char *, void *, int,
                                                      void *, void *));
 DR_LLVM_SYM(void (*LLVMDisasmDispose)(LLVMDisasmContextRef));
@@ -132,6 +139,23 @@ DR_LLVM_SYM(bool (*LLVMVerifyModule)(LLVMModuleRef, int action, char **msg));
 DR_LLVM_SYM(void (*LLVMGetVersion)(unsigned *, unsigned *, unsigned *));
 DR_LLVM_SYM(void (*LLVMDisposeTargetMachine)(LLVMTargetMachineRef));
 
+// Bitcode and function attributes (used to reuse parsed kernels)
+DR_LLVM_SYM(LLVMMemoryBufferRef (*LLVMWriteBitcodeToMemoryBuffer)(LLVMModuleRef));
+DR_LLVM_SYM(LLVMBool (*LLVMParseBitcodeInContext2)(LLVMContextRef,
+                                                   LLVMMemoryBufferRef,
+                                                   LLVMModuleRef *));
+DR_LLVM_SYM(void (*LLVMDisposeMemoryBuffer)(LLVMMemoryBufferRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetFirstFunction)(LLVMModuleRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetNextFunction)(LLVMValueRef));
+DR_LLVM_SYM(LLVMAttributeRef (*LLVMGetStringAttributeAtIndex)(
+    LLVMValueRef, unsigned, const char *, unsigned));
+DR_LLVM_SYM(LLVMAttributeRef (*LLVMCreateStringAttribute)(
+    LLVMContextRef, const char *, unsigned, const char *, unsigned));
+DR_LLVM_SYM(void (*LLVMAddAttributeAtIndex)(LLVMValueRef, unsigned,
+                                            LLVMAttributeRef));
+DR_LLVM_SYM(void (*LLVMRemoveStringAttributeAtIndex)(LLVMValueRef, unsigned,
+                                                     const char *, unsigned));
+
 // Legacy pass manager
 DR_LLVM_SYM(LLVMPassManagerRef (*LLVMCreatePassManager)());
 DR_LLVM_SYM(void (*LLVMRunPassManager)(LLVMPassManagerRef, LLVMModuleRef));
@@ -14,6 +14,14 @@
 #  include <sys/mman.h>
 #endif
 
+#if defined(__aarch64__) && defined(__linux__)
+#  include <sys/prctl.h>
+#  if !defined(PR_SVE_GET_VL)
+#    define PR_SVE_GET_VL 51
+#    define PR_SVE_VL_LEN_MASK 0xffff
+#  endif
+#endif
+
 #include "llvm.h"
 #include "llvm_api.h"
 #include "llvm_memmgr.h"
@@ -28,7 +36,6 @@ static bool jitc_llvm_init_success    = false;
 static bool jitc_llvm_use_orcv2       = false;
 
 static LLVMDisasmContextRef jitc_llvm_disasm_ctx = nullptr;
-static LLVMContextRef jitc_llvm_context = nullptr;
 
 /// String describing the LLVM target
 char *jitc_llvm_target_triple = nullptr;
@@ -42,6 +49,9 @@ char *jitc_llvm_target_features = nullptr;
 /// Vector width of code generated by the LLVM backend
 uint32_t jitc_llvm_vector_width = 0;
 
+/// SVE register size in multiples of 128 bit (or zero when SVE is not used)
+uint32_t jitc_llvm_vscale = 0;
+
 /// Should the LLVM IR use typed (e.g., "i8*") or untyped ("ptr") pointers?
 bool jitc_llvm_opaque_pointers = false;
 
@@ -51,15 +61,57 @@ char **jitc_llvm_ones_str = nullptr;
 /// Current top-level task in the task queue
 Task *jitc_task = nullptr;
 
-/// Reference to the target machine used for compilation
-LLVMTargetMachineRef jitc_llvm_tm = nullptr;
+/// Compiler instance used by jitc_llvm_compile(Kernel &)
+LLVMCompiler jitc_llvm_compiler;
+
+/// Idle compiler instances used by jitc_llvm_compile_ir()
+static std::vector<LLVMCompiler *> jitc_llvm_compiler_pool;
+static Lock jitc_llvm_compiler_pool_lock;
+
+/* Bitcode of the last kernel parsed by this thread (prior to optimization)
+   while target versions were registered. jitc_llvm_write_versions() parses it
+   instead of the textual IR, which is considerably faster. */
+static thread_local LLVMMemoryBufferRef jitc_llvm_bitcode = nullptr;
+
+/// Hash of the textual IR (excluding attributes) that 'jitc_llvm_bitcode' encodes
+static thread_local uint64_t jitc_llvm_bitcode_tag = 0;
+
+static void jitc_llvm_bitcode_release() {
+    if (jitc_llvm_bitcode) {
+        LLVMDisposeMemoryBuffer(jitc_llvm_bitcode);
+        jitc_llvm_bitcode = nullptr;
+    }
+}
+
+/// Incremented whenever the target changes, which invalidates pooled compilers
+static uint32_t jitc_llvm_target_id = 0;
+
+/// Additional (CPU, features) pairs for which kernels are written to the disk cache
+static std::vector<std::pair<std::string, std::string>> jitc_llvm_target_versions;
 
 void jitc_llvm_update_strings();
+static void jitc_llvm_compiler_pool_clear();
+
+bool jitc_llvm_has_feature(const char *name) {
+    const char *features = jitc_llvm_target_features;
+    if (!features)
+        return false;
+
+    // Comma-separated list of the form "+feature1,-feature2,..."
+    size_t len = strlen(name);
+    for (const char *p = features; (p = strstr(p, name)) != nullptr; p += len) {
+        if (p > features && p[-1] == '+' && (p[len] == ',' || p[len] == '\0'))
+            return true;
+    }
+
+    return false;
+}
 
 bool jitc_llvm_init() {
     if (jitc_llvm_init_attempted)
         return jitc_llvm_init_success;
     jitc_llvm_init_attempted = true;
+    lock_init(jitc_llvm_compiler_pool_lock);
 
     if (!jitc_llvm_api_init())
         return false;
@@ -89,7 +141,7 @@ bool jitc_llvm_init() {
     jitc_llvm_target_triple = LLVMGetDefaultTargetTriple();
     jitc_llvm_target_cpu = LLVMGetHostCPUName();
     jitc_llvm_target_features = LLVMGetHostCPUFeatures();
-    jitc_llvm_context = LLVMGetGlobalContext();
+    jitc_llvm_compiler.context = LLVMGetGlobalContext();
 
     jitc_llvm_disasm_ctx =
         LLVMCreateDisasm(jitc_llvm_target_triple, nullptr, 0, nullptr, nullptr);
@@ -122,10 +174,37 @@ bool jitc_llvm_init() {
     if (strstr(jitc_llvm_target_features, "+avx512vl"))
         jitc_llvm_vector_width = 16;
 
+#if defined(__aarch64__)
+    /* NEON is part of the AArch64 baseline. Each Dr.Jit vector spans two
+       128-bit registers, which gives the wide out-of-order cores of recent
+       server CPUs (Neoverse, etc.) independent instructions to overlap. */
+    jitc_llvm_vector_width = 8;
+    jitc_llvm_vscale = 0;
+
+#  if defined(__linux__)
+    /* When the SVE registers are wider than 128 bit (e.g., Graviton3, A64FX),
+       LLVM maps Dr.Jit's fixed-width vectors onto SVE instructions, provided
+       that the 'vscale_range' function attribute pins the vector length. */
+    if (jitc_llvm_has_feature("sve") && jitc_llvm_version_major >= 13) {
+        int vl = prctl(PR_SVE_GET_VL);
+        uint32_t bits = vl > 0 ? (uint32_t) (vl & PR_SVE_VL_LEN_MASK) * 8 : 0;
+        if (bits > 128) {
+            jitc_llvm_vscale = bits / 128;
+            jitc_llvm_vector_width = bits >= 512 ? 16 : bits / 32;
+        }
+    }
+#  endif
+#endif
+
 #if defined(__APPLE__) && defined(__aarch64__)
     jitc_llvm_vector_width = 4;
-    LLVMDisposeMessage(jitc_llvm_target_cpu);
-    jitc_llvm_target_cpu = LLVMCreateMessage("apple-a14");
+
+    // Older LLVM versions don't recognize Apple silicon and report a generic CPU
+    if (strcmp(jitc_llvm_target_cpu, "generic") == 0 ||
+        strcmp(jitc_llvm_target_cpu, "cyclone") == 0) {
+        LLVMDisposeMessage(jitc_llvm_target_cpu);
+        jitc_llvm_target_cpu = LLVMCreateMessage("apple-a14");
+    }
 #endif
 
     jitc_llvm_init_success = jitc_llvm_vector_width > 1;
@@ -162,12 +241,12 @@ bool jitc_llvm_init() {
         snprintf(patch_str, sizeof(patch_str), "%i", jitc_llvm_version_patch);
 
     jitc_log(Info,
-             "jit_llvm_init(): found LLVM %s.%s.%s (%s), target=%s, cpu=%s, %s pointers, width=%u.",
+             "jit_llvm_init(): found LLVM %s.%s.%s (%s), target=%s, cpu=%s, %s pointers, width=%u%s.",
              major_str, minor_str, patch_str,
              jitc_llvm_use_orcv2 ? "ORCv2" : "MCJIT",
              jitc_llvm_target_triple, jitc_llvm_target_cpu,
              jitc_llvm_opaque_pointers ? "opaque" : "typed",
-             jitc_llvm_vector_width);
+             jitc_llvm_vector_width, jitc_llvm_vscale ? " (SVE)" : "");
 
     return jitc_llvm_init_success;
 }
@@ -178,7 +257,9 @@ void jitc_llvm_shutdown() {
 
     jitc_log(Info, "jit_llvm_shutdown()");
 
-    jitc_llvm_memmgr_shutdown();
+    jitc_llvm_compiler_pool_clear();
+    jitc_llvm_bitcode_release();
+    jitc_llvm_memmgr_shutdown(jitc_llvm_compiler.memmgr);
     jitc_llvm_orcv2_shutdown();
     jitc_llvm_mcjit_shutdown();
 
@@ -193,7 +274,8 @@ void jitc_llvm_shutdown() {
     jitc_llvm_target_cpu = nullptr;
     jitc_llvm_target_features = nullptr;
     jitc_llvm_vector_width = 0;
-    jitc_llvm_context = nullptr;
+    jitc_llvm_vscale = 0;
+    jitc_llvm_compiler.context = nullptr;
 
     if (jitc_llvm_ones_str) {
         for (uint32_t i = 0; i < (uint32_t) VarType::Count; ++i)
@@ -204,6 +286,7 @@ void jitc_llvm_shutdown() {
 
     jitc_llvm_init_success = false;
     jitc_llvm_init_attempted = false;
+    lock_destroy(jitc_llvm_compiler_pool_lock);
 
     jitc_llvm_api_shutdown();
 }
@@ -264,6 +347,8 @@ void jitc_llvm_set_target(const char *target_cpu,
         jitc_llvm_target_features = nullptr;
     }
 
+    jitc_llvm_compiler_pool_clear();
+
     jitc_llvm_vector_width = vector_width;
     jitc_llvm_target_cpu = LLVMCreateMessage((char *) target_cpu);
     if (target_features)
@@ -272,6 +357,120 @@ void jitc_llvm_set_target(const char *target_cpu,
     jitc_llvm_update_strings();
 }
 
+/// Append the value of the "target-features" function attribute
+static void jitc_llvm_put_features(StringBuffer &buf, const char *features) {
+#if !defined(__aarch64__)
+    buf.put("-vzeroupper");
+    if (features)
+        buf.put(',');
+#endif
+
+    if (features)
+        buf.put(features, strlen(features));
+}
+
+void jitc_llvm_put_attributes(StringBuffer &buf, const char *cpu,
+                              const char *features) {
+    buf.fmt("attributes #0 = { norecurse nounwind \"frame-pointer\"=\"none\" "
+            "\"no-builtins\" \"no-stack-arg-probe\" \"target-cpu\"=\"%s\" "
+            "\"target-features\"=\"", cpu);
+    jitc_llvm_put_features(buf, features);
+    buf.put('"');
+
+#if !defined(__aarch64__)
+    /* Some targets (e.g. 'skylake-avx512', 'sapphirerapids') prefer 256-bit
+       vectors, and the X86 backend then legalizes wider vectors by splitting
+       them unless told otherwise. Dr.Jit's vectors have the intended width. */
+    buf.fmt(" \"min-legal-vector-width\"=\"%u\"", jitc_llvm_vector_width * 32);
+#endif
+
+    // Fixed-length SVE code generation (see jitc_llvm_init())
+    if (jitc_llvm_vscale)
+        buf.fmt(" vscale_range(%u,%u)", jitc_llvm_vscale, jitc_llvm_vscale);
+
+    buf.put(" }");
+}
+
+size_t jitc_llvm_attributes_offset(const char *source, size_t size) {
+    size_t offset = size;
+    while (offset > 0 && source[offset - 1] != '\n')
+        offset--;
+    return offset;
+}
+
+uint64_t jitc_llvm_target_tag(const char *source, size_t size) {
+    if (source) {
+        size_t offset = jitc_llvm_attributes_offset(source, size);
+        return (uint64_t) XXH3_64bits(source + offset, size - offset);
+    }
+
+    StringBuffer buf;
+    jitc_llvm_put_attributes(buf, jitc_llvm_target_cpu,
+                             jitc_llvm_target_features);
+    return (uint64_t) XXH3_64bits(buf.get(), buf.size());
+}
+
+void jitc_llvm_add_target_version(const char *target_cpu,
+                                  const char *target_features) {
+    if (!target_cpu) {
+        jitc_llvm_target_versions.clear();
+        return;
+    }
+
+    jitc_llvm_target_versions.emplace_back(
+        target_cpu, target_features ? target_features : "");
+}
+
+static void jitc_llvm_compile_bitcode(const char *source, size_t size,
+                                      const std::vector<std::string> &names,
+                                      Kernel &kernel, LLVMTier tier,
+                                      const char *cpu, const char *features);
+
+void jitc_llvm_write_versions(const char *source, size_t size,
+                              XXH128_hash_t hash,
+                              const std::vector<std::string> &names,
+                              LLVMTier tier) {
+    if (jitc_llvm_target_versions.empty())
+        return;
+
+    size_t offset = jitc_llvm_attributes_offset(source, size);
+    uint64_t tag = jitc_llvm_target_tag(source, size);
+    bool reuse = jitc_llvm_bitcode &&
+                 jitc_llvm_bitcode_tag == (uint64_t) XXH3_64bits(source, offset);
+    StringBuffer buf;
+
+    for (const auto &v : jitc_llvm_target_versions) {
+        // Only the attribute group differs between versions
+        buf.clear();
+        buf.put(source, offset);
+        jitc_llvm_put_attributes(buf, v.first.c_str(),
+                                 v.second.empty() ? nullptr : v.second.c_str());
+        if (jitc_llvm_target_tag(buf.get(), buf.size()) == tag)
+            continue;
+
+        Kernel kernel;
+        memset(&kernel, 0, sizeof(Kernel));
+        try {
+            if (reuse)
+                jitc_llvm_compile_bitcode(
+                    buf.get(), buf.size(), names, kernel, tier, v.first.c_str(),
+                    v.second.empty() ? nullptr : v.second.c_str());
+            else
+                jitc_llvm_compile_ir(buf.get(), buf.size(), names, kernel, tier);
+        } catch (const std::exception &e) {
+            jitc_log(Warn, "jit_llvm_write_versions(): could not compile for "
+                     "target \"%s\": %s", v.first.c_str(), e.what());
+            continue;
+        }
+
+        jitc_kernel_write(buf.get(), (uint32_t) buf.size(), JitBackend::LLVM,
+                          hash, kernel);
+        jitc_kernel_free(-1, kernel);
+    }
+
+    jitc_llvm_bitcode_release();
+}
+
 /// Dump assembly representation
 void jitc_llvm_disasm(const Kernel &kernel) {
     if (std::max(state.log_level_stderr, state.log_level_callback) <
@@ -317,50 +516,79 @@ void jitc_llvm_disasm(const Kernel &kernel) {
 
 static ProfilerRegion profiler_region_llvm_compile("jit_llvm_compile");
 
-void jitc_llvm_compile(Kernel &kernel) {
-    ProfilerPhase phase(profiler_region_llvm_compile);
-
-    jitc_llvm_memmgr_prepare(buffer.size());
+/// Compile the IR string 'source' using the compiler instance 'c'
+/**
+ * Compile the textual IR 'source', or 'llvm_module' if specified (in which
+ * case 'source' is only used for diagnostics)
+ */
+static void jitc_llvm_compile_impl(LLVMCompiler &c, const char *source,
+                                   size_t size,
+                                   const std::vector<std::string> &names,
+                                   Kernel &kernel, LLVMTier tier,
+                                   LLVMModuleRef llvm_module = nullptr) {
+    LLVMMemMgr &m = c.memmgr;
+    jitc_llvm_memmgr_prepare(m, size);
 
-    LLVMMemoryBufferRef llvm_buf = LLVMCreateMemoryBufferWithMemoryRange(
-        buffer.get(), buffer.size(), kernel_name, 0);
-    if (unlikely(!llvm_buf))
-        jitc_fail("jit_run_compile(): could not create memory buffer!");
-
-    // 'buf' is consumed by this function.
-    LLVMModuleRef llvm_module = nullptr;
     char *error = nullptr;
-    LLVMParseIRInContext(jitc_llvm_context, llvm_buf, &llvm_module, &error);
-    if (unlikely(error))
-        jitc_fail("jit_llvm_compile(): parsing failed. Please see the LLVM "
-                  "IR and error message below:\n\n%s\n\n%s", buffer.get(), error);
-    LLVMDisposeMessage(error);
+    bool parsed = !llvm_module;
+
+    if (parsed) {
+        LLVMMemoryBufferRef llvm_buf = LLVMCreateMemoryBufferWithMemoryRange(
+            source, size, names[0].c_str(), 0);
+        if (unlikely(!llvm_buf))
+            jitc_fail("jit_run_compile(): could not create memory buffer!");
+
+        // 'buf' is consumed by this function.
+        LLVMParseIRInContext((LLVMContextRef) c.context, llvm_buf, &llvm_module,
+                             &error);
+        if (unlikely(error))
+            jitc_fail("jit_llvm_compile(): parsing failed. Please see the LLVM "
+                      "IR and error message below:\n\n%s\n\n%s", source, error);
+        LLVMDisposeMessage(error);
+        error = nullptr;
+    }
 
 #if !defined(NDEBUG)
     bool status = LLVMVerifyModule(llvm_module, LLVMReturnStatusAction, &error);
     if (unlikely(status))
         jitc_fail("jit_llvm_compile(): module could not be verified! Please "
                   "see the LLVM IR and error message below:\n\n%s\n\n%s",
-                  buffer.get(), error);
+                  source, error);
 #endif
     LLVMDisposeMessage(error);
 
+    // Keep the unoptimized module around for jitc_llvm_write_versions()
+    if (parsed && !jitc_llvm_target_versions.empty() &&
+        jitc_llvm_api_has_bitcode()) {
+        jitc_llvm_bitcode_release();
+        jitc_llvm_bitcode = LLVMWriteBitcodeToMemoryBuffer(llvm_module);
+        jitc_llvm_bitcode_tag = (uint64_t) XXH3_64bits(
+            source, jitc_llvm_attributes_offset(source, size));
+    }
+
     #define DRJIT_RUN_LEGACY_PASS_MANAGER()                                   \
         LLVMPassManagerRef jitc_llvm_pass_manager = LLVMCreatePassManager();  \
         LLVMAddLICMPass(jitc_llvm_pass_manager);                              \
         LLVMRunPassManager(jitc_llvm_pass_manager, llvm_module);              \
         LLVMDisposePassManager(jitc_llvm_pass_manager);
 
+    /* Disable some things we won't need for typical Dr.Jit programs (they
+       are already vectorized, and we don't want to make the generated code
+       even larger by unrolling it). Optimized kernels of the tiered
+       compilation mode are the exception and may use the vectorizers. */
+    bool vectorize = tier == LLVMTier::Optimized;
+    const char *pipeline = tier == LLVMTier::Fast ? "default<O1>" :
+                           (vectorize ? "default<O3>" : "default<O2>");
+    (void) vectorize; (void) pipeline;
+
     #define DRJIT_RUN_NEW_PASS_MANAGER()                                      \
         LLVMPassBuilderOptionsRef pb_opt = LLVMCreatePassBuilderOptions();    \
-        /* Disable some things we won't need for typical Dr.Jit programs */   \
-        /* (they are already vectorized, and we don't want to make the */     \
-        /* generated code even larger by unrolling it */                      \
         LLVMPassBuilderOptionsSetLoopUnrolling(pb_opt, 0);                    \
-        LLVMPassBuilderOptionsSetLoopVectorization(pb_opt, 0);                \
-        LLVMPassBuilderOptionsSetSLPVectorization(pb_opt, 0);                 \
+        LLVMPassBuilderOptionsSetLoopVectorization(pb_opt, vectorize);        \
+        LLVMPassBuilderOptionsSetSLPVectorization(pb_opt, vectorize);         \
         LLVMErrorRef error_ref =                                              \
-            LLVMRunPasses(llvm_module, "default<O2>", jitc_llvm_tm, pb_opt);  \
+            LLVMRunPasses(llvm_module, pipeline,                              \
+                          (LLVMTargetMachineRef) c.tm, pb_opt);               \
         if (error_ref)                                                        \
             jitc_fail(                                                        \
                 "jit_llvm_compile(): failed to run optimization passes: %s!", \
@@ -386,60 +614,226 @@ void jitc_llvm_compile(Kernel &kernel) {
     }
 #endif
 
-    std::vector<uint8_t *> reloc(
-        callable_count_unique ? (callable_count_unique + 2) : 1);
+    std::vector<uint8_t *> reloc(names.size());
 
     if (jitc_llvm_use_orcv2)
-        jitc_llvm_orcv2_compile(llvm_module, reloc);
+        jitc_llvm_orcv2_compile(c, llvm_module, names, reloc);
     else
-        jitc_llvm_mcjit_compile(llvm_module, reloc);
+        jitc_llvm_mcjit_compile(c, llvm_module, names, reloc);
 
-    if (jitc_llvm_memmgr_got)
+    if (m.got)
         jitc_fail(
             "jit_llvm_compile(): a global offset table was generated by LLVM, "
             "which typically means that a compiler intrinsic was not supported "
             "by the target architecture. DrJit cannot handle this case "
             "and will terminate the application now. For reference, the "
             "following kernel code was responsible for this problem:\n\n%s",
-            buffer.get());
+            source);
 
 #if !defined(_WIN32)
-    void *ptr = mmap(nullptr, jitc_llvm_memmgr_offset, PROT_READ | PROT_WRITE,
+    void *ptr = mmap(nullptr, m.offset, PROT_READ | PROT_WRITE,
                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (ptr == MAP_FAILED)
         jitc_fail("jit_llvm_compile(): could not mmap() memory: %s",
                   strerror(errno));
 #else
-    void *ptr = VirtualAlloc(nullptr, jitc_llvm_memmgr_offset,
+    void *ptr = VirtualAlloc(nullptr, m.offset,
                              MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
     if (!ptr)
         jitc_fail("jit_llvm_compile(): could not VirtualAlloc() memory: %u", GetLastError());
 #endif
-    memcpy(ptr, jitc_llvm_memmgr_data, jitc_llvm_memmgr_offset);
+    memcpy(ptr, m.data, m.offset);
 
     kernel.data = ptr;
-    kernel.size = (uint32_t) jitc_llvm_memmgr_offset;
+    kernel.size = (uint32_t) m.offset;
     kernel.llvm.n_reloc = (uint32_t) reloc.size();
+    kernel.llvm.tier = (uint32_t) tier;
+    kernel.llvm.launches = 0;
     kernel.llvm.reloc = (void **) malloc_check(sizeof(void *) * reloc.size());
 
     // Relocate function pointers
     for (size_t i = 0; i < reloc.size(); ++i)
-        kernel.llvm.reloc[i] = (uint8_t *) ptr + (reloc[i] - jitc_llvm_memmgr_data);
+        kernel.llvm.reloc[i] = (uint8_t *) ptr + (reloc[i] - m.data);
 
     // Write address of @callables
     if (kernel.llvm.n_reloc > 1)
         *((void **) kernel.llvm.reloc[1]) = kernel.llvm.reloc + 1;
 
 #if defined(DRJIT_ENABLE_ITTNOTIFY)
-    kernel.llvm.itt = __itt_string_handle_create(kernel_name);
+    kernel.llvm.itt = __itt_string_handle_create(names[0].c_str());
 #endif
 
 #if !defined(_WIN32)
-    if (mprotect(ptr, jitc_llvm_memmgr_offset, PROT_READ | PROT_EXEC) == -1)
+    if (mprotect(ptr, m.offset, PROT_READ | PROT_EXEC) == -1)
         jitc_fail("jit_llvm_compile(): mprotect() failed: %s", strerror(errno));
 #else
     DWORD unused;
-    if (VirtualProtect(ptr, jitc_llvm_memmgr_offset, PAGE_EXECUTE_READ, &unused) == 0)
+    if (VirtualProtect(ptr, m.offset, PAGE_EXECUTE_READ, &unused) == 0)
         jitc_fail("jit_llvm_compile(): VirtualProtect() failed: %u", GetLastError());
 #endif
 }
+
+void jitc_llvm_compile(Kernel &kernel, LLVMTier tier) {
+    ProfilerPhase phase(profiler_region_llvm_compile);
+    jitc_llvm_compile_impl(jitc_llvm_compiler, buffer.get(), buffer.size(),
+                           jitc_llvm_compile_symbols(), kernel, tier);
+}
+
+std::vector<std::string> jitc_llvm_compile_symbols() {
+    std::vector<std::string> names;
+    names.reserve(callable_count_unique ? (callable_count_unique + 2) : 1);
+    names.emplace_back(kernel_name);
+
+    /// Does the kernel perform virtual function calls via @callables?
+    if (callable_count_unique) {
+        names.emplace_back("callables");
+
+        for (auto const &kv: globals_map) {
+            if (!kv.first.callable)
+                continue;
+
+            char name_buf[38];
+            snprintf(name_buf, sizeof(name_buf), "func_%016llx%016llx",
+                     (unsigned long long) kv.first.hash.high64,
+                     (unsigned long long) kv.first.hash.low64);
+            names.emplace_back(name_buf);
+        }
+    }
+
+    return names;
+}
+
+bool jitc_llvm_compile_is_concurrent() { return jitc_llvm_use_orcv2; }
+
+/// Release a compiler instance created by jitc_llvm_compiler_acquire()
+static void jitc_llvm_compiler_destroy(LLVMCompiler *c) {
+    jitc_llvm_orcv2_destroy(*c);
+    jitc_llvm_memmgr_shutdown(c->memmgr);
+    if (c->context)
+        LLVMContextDispose((LLVMContextRef) c->context);
+    delete c;
+}
+
+/// Fetch an idle compiler instance from the pool, or create a new one
+static LLVMCompiler *jitc_llvm_compiler_acquire() {
+    uint32_t target_id;
+    {
+        lock_guard guard(jitc_llvm_compiler_pool_lock);
+        if (!jitc_llvm_compiler_pool.empty()) {
+            LLVMCompiler *c = jitc_llvm_compiler_pool.back();
+            jitc_llvm_compiler_pool.pop_back();
+            return c;
+        }
+        target_id = jitc_llvm_target_id;
+    }
+
+    LLVMCompiler *c = new LLVMCompiler();
+    c->context = LLVMContextCreate();
+    c->target_id = target_id;
+    if (!jitc_llvm_orcv2_create(*c))
+        jitc_fail("jit_llvm_compile(): could not create a compiler instance!");
+    jitc_trace("jit_llvm_compile(): created compiler instance " DRJIT_PTR ".",
+               (uintptr_t) c);
+    return c;
+}
+
+/// Return a compiler instance to the pool
+static void jitc_llvm_compiler_release(LLVMCompiler *c) {
+    {
+        lock_guard guard(jitc_llvm_compiler_pool_lock);
+        if (c->target_id == jitc_llvm_target_id) {
+            jitc_llvm_compiler_pool.push_back(c);
+            return;
+        }
+    }
+
+    // The target changed in the meantime
+    jitc_llvm_compiler_destroy(c);
+}
+
+static void jitc_llvm_compiler_pool_clear() {
+    std::vector<LLVMCompiler *> pool;
+    {
+        lock_guard guard(jitc_llvm_compiler_pool_lock);
+        pool.swap(jitc_llvm_compiler_pool);
+        jitc_llvm_target_id++;
+    }
+
+    for (LLVMCompiler *c : pool)
+        jitc_llvm_compiler_destroy(c);
+}
+
+void jitc_llvm_compile_ir(const char *source, size_t size,
+                          const std::vector<std::string> &names,
+                          Kernel &kernel, LLVMTier tier) {
+    ProfilerPhase phase(profiler_region_llvm_compile);
+
+    // MCJIT: there is only a single compiler instance
+    if (!jitc_llvm_use_orcv2) {
+        jitc_llvm_compile_impl(jitc_llvm_compiler, source, size, names,
+                               kernel, tier);
+        return;
+    }
+
+    LLVMCompiler *c = jitc_llvm_compiler_acquire();
+    try {
+        jitc_llvm_compile_impl(*c, source, size, names, kernel, tier);
+    } catch (...) {
+        jitc_llvm_compiler_destroy(c);
+        throw;
+    }
+    jitc_llvm_compiler_release(c);
+}
+
+/// Replace a string attribute of all functions that define it
+static void jitc_llvm_replace_attribute(LLVMContextRef ctx, LLVMModuleRef module,
+                                        const char *key, const char *value,
+                                        size_t value_size) {
+    unsigned key_size = (unsigned) strlen(key),
+             index = (unsigned) LLVMAttributeFunctionIndex;
+    LLVMAttributeRef attr = LLVMCreateStringAttribute(
+        ctx, key, key_size, value, (unsigned) value_size);
+
+    for (LLVMValueRef f = LLVMGetFirstFunction(module); f;
+         f = LLVMGetNextFunction(f)) {
+        if (!LLVMGetStringAttributeAtIndex(f, index, key, key_size))
+            continue;
+        LLVMRemoveStringAttributeAtIndex(f, index, key, key_size);
+        LLVMAddAttributeAtIndex(f, index, attr);
+    }
+}
+
+/// Compile 'jitc_llvm_bitcode' for another target (see jitc_llvm_write_versions())
+static void jitc_llvm_compile_bitcode(const char *source, size_t size,
+                                      const std::vector<std::string> &names,
+                                      Kernel &kernel, LLVMTier tier,
+                                      const char *cpu, const char *features) {
+    ProfilerPhase phase(profiler_region_llvm_compile);
+
+    // MCJIT: there is only a single compiler instance
+    LLVMCompiler *c = jitc_llvm_use_orcv2 ? jitc_llvm_compiler_acquire()
+                                          : &jitc_llvm_compiler;
+    try {
+        LLVMContextRef ctx = (LLVMContextRef) c->context;
+        LLVMModuleRef llvm_module = nullptr;
+        if (LLVMParseBitcodeInContext2(ctx, jitc_llvm_bitcode, &llvm_module))
+            jitc_raise("jit_llvm_compile(): could not parse bitcode!");
+
+        StringBuffer buf;
+        jitc_llvm_put_features(buf, features);
+        jitc_llvm_replace_attribute(ctx, llvm_module, "target-cpu", cpu,
+                                    strlen(cpu));
+        jitc_llvm_replace_attribute(ctx, llvm_module, "target-features",
+                                    buf.get(), buf.size());
+
+        jitc_llvm_compile_impl(*c, source, size, names, kernel, tier,
+                               llvm_module);
+    } catch (...) {
+        if (jitc_llvm_use_orcv2)
+            jitc_llvm_compiler_destroy(c);
+        throw;
+    }
+
+    if (jitc_llvm_use_orcv2)
+        jitc_llvm_compiler_release(c);
+}
@@ -80,7 +80,6 @@
     } while (0)
 
 // Forward declaration
-static void jitc_llvm_render_stmt(uint32_t index, const Variable *v, bool in_function);
 static void jitc_llvm_render_var(uint32_t index, Variable *v);
 static void jitc_llvm_render_scatter(const Variable *v, const Variable *ptr,
                                      const Variable *value, const Variable *index,
@@ -109,13 +108,22 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
         "body:\n"
         "    %index = phi i64 [ %index_next, %suffix ], [ %start, %entry ]\n");
 
+    // Small scatter-reduction targets are accumulated in a stack buffer
+    jitc_private_scan(group, DRJIT_PRIVATE_LIMIT_LLVM);
+
     for (uint32_t gi = group.start; gi != group.end; ++gi) {
         uint32_t index = schedule[gi].index;
         Variable *v = jitc_var(index);
         uint32_t vti = v->type;
         VarType vt = (VarType) vti;
-        ParamType ptype = (ParamType) v->param_type;
-        uint32_t size = v->size;
+        const VariableScratch *vs = jitc_var_scratch(v);
+        if (unlikely(vs->elide))
+            continue; // See jitc_optimize_group()
+        ParamType ptype = (ParamType) vs->param_type;
+        size_t size = v->size;
+
+        // Scalar output of a fused kernel (see JitFlag::KernelFusion)
+        bool scalar_output = ptype == ParamType::Output && size != group.size;
 
         /// If a variable has a custom code generation hook, call it
         if (unlikely(v->extra)) {
@@ -142,8 +150,13 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
             fmt("    $v_p1 = getelementptr inbounds {i8*}, {i8**} %params, i32 $o\n"
                 "    $v = load {i8*}, {i8**} $v_p1, align 8, !alias.scope !2\n",
                 v, v, v, v);
+        } else if (ptype == ParamType::Input && v->is_literal()) {
+            // Case 2: literal value stored in the parameter slot (JitFlag::LiteralParams)
+            fmt("    $v_p{1|3} = getelementptr inbounds {i8*}, {i8**} %params, i32 $o\n"
+                "{    $v_p3 = bitcast i8** $v_p1 to $m*\n|}",
+                v, v, v, v, v);
         } else if (ptype != ParamType::Register) {
-            // Case 2: read an input/output parameter
+            // Case 3: read an input/output parameter
 
             fmt( "    $v_p1 = getelementptr inbounds {i8*}, {i8**} %params, i32 $o\n"
                  "    $v_p{2|3} = load {i8*}, {i8**} $v_p1, align 8, !alias.scope !2\n"
@@ -151,17 +164,17 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
                 v, v, v, v, v, v, v);
 
             // For output parameters and non-scalar inputs
-            if (ptype != ParamType::Input || size != 1)
+            if ((ptype != ParamType::Input || size != 1) && !scalar_output)
                 fmt( "    $v_p{4|5} = getelementptr inbounds $m, {$m*} $v_p3, i64 %index\n"
                     "{    $v_p5 = bitcast $m* $v_p4 to $M*\n|}",
                     v, v, v, v, v, v, v, v);
         }
 
         if (likely(ptype == ParamType::Input)) {
-            if (v->is_literal())
+            if (v->is_literal() && vt == VarType::Pointer)
                 continue;
 
-            if (size != 1) {
+            if (size != 1 && !v->is_literal()) {
                 // Load a packet of values
                 fmt("    $v$s = load $M, {$M*} $v_p5, align $A, !alias.scope !2, !nontemporal !3\n",
                     v, vt == VarType::Bool ? "_0" : "", v, v, v, v);
@@ -188,10 +201,8 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
                 "    $v = shufflevector $T $v_1, $T undef, <$w x i32> $z\n",
                 v, v, v, v,
                 v, v, v, v);
-        } else if (!v->is_stmt()) {
-            jitc_llvm_render_var(index, v);
         } else {
-            jitc_llvm_render_stmt(index, v, false);
+            jitc_llvm_render_var(index, v);
         }
 
         if (ptype == ParamType::Output) {
@@ -202,7 +213,24 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
             */
             assert(v == jitc_var(index));
 
-            if (vt != VarType::Bool) {
+            if (unlikely(scalar_output)) {
+                // Written by the packet containing the first entry
+                fmt("    $v_s0 = extractelement $V, i32 0\n", v, v);
+                if (vt == VarType::Bool)
+                    fmt("    $v_s1 = zext i1 $v_s0 to i8\n", v, v);
+
+                fmt("    $v_first = icmp eq i64 %index, 0\n"
+                    "    br i1 $v_first, label %l$u_store, label %l$u_stored\n\n"
+                    "l$u_store:\n"
+                    "    store $m $v_s$u, {$m*} $v_p3, align $a, !noalias !2\n"
+                    "    br label %l$u_stored\n\n"
+                    "l$u_stored:\n",
+                    v, vs->reg_index, vs->reg_index,
+                    vs->reg_index,
+                    v, v, vt == VarType::Bool ? 1u : 0u, v, v, v,
+                    vs->reg_index,
+                    vs->reg_index);
+            } else if (vt != VarType::Bool) {
                 fmt("    store $V, {$T*} $v_p5, align $A, !noalias !2, !nontemporal !3\n",
                     v, v, v, v);
             } else {
@@ -219,13 +247,70 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
     fmt("    %index_next = add i64 %index, $w\n");
     put("    %cond = icmp uge i64 %index_next, %end\n"
         "    br i1 %cond, label %done, label %body, !llvm.loop !4\n\n"
-        "done:\n"
-        "    ret void\n"
+        "done:\n");
+
+    // Flush the partial result of privatized scatter-reductions
+    for (uint32_t i = 0; i < (uint32_t) private_targets.size(); ++i) {
+        const PrivateTarget &pt = private_targets[i];
+        const Variable *ptr = jitc_var(pt.ptr_index),
+                       *target = jitc_var(pt.target_index);
+        bool is_float = jitc_is_float(target);
+
+        fmt("    br label %privb_$u\n"
+            "\n"
+            "privb_$u:\n"
+            "    %priv_$u_p1 = getelementptr inbounds {i8*}, {i8**} %params, i32 $o\n"
+            "    %priv_$u_p{2|3} = load {i8*}, {i8**} %priv_$u_p1, align 8, !alias.scope !2\n"
+            "{    %priv_$u_p3 = bitcast i8* %priv_$u_p2 to $t*\n|}"
+            "    br label %privb_$u_loop\n"
+            "\n"
+            "privb_$u_loop:\n"
+            "    %priv_$u_i = phi i32 [ 0, %privb_$u ], [ %priv_$u_next, %privb_$u_skip ]\n"
+            "    %priv_$u_src = getelementptr inbounds $t, {$t*} %priv_$u, i32 %priv_$u_i\n"
+            "    %priv_$u_val = load $t, {$t*} %priv_$u_src, align 4\n"
+            "    %priv_$u_nz = $s $t %priv_$u_val, $s\n"
+            "    br i1 %priv_$u_nz, label %privb_$u_flush, label %privb_$u_skip\n"
+            "\n"
+            "privb_$u_flush:\n"
+            "    %priv_$u_dst = getelementptr inbounds $t, {$t*} %priv_$u_p3, i32 %priv_$u_i\n"
+            "    atomicrmw $s {$t*} %priv_$u_dst, $t %priv_$u_val monotonic\n"
+            "    br label %privb_$u_skip\n"
+            "\n"
+            "privb_$u_skip:\n"
+            "    %priv_$u_next = add nuw nsw i32 %priv_$u_i, 1\n"
+            "    %priv_$u_cond = icmp eq i32 %priv_$u_next, $u\n"
+            "    br i1 %priv_$u_cond, label %privb_$u_done, label %privb_$u_loop\n"
+            "\n"
+            "privb_$u_done:\n",
+            i,
+            i,
+            i, ptr,
+            i, i,
+            i, i, target,
+            i,
+            i,
+            i, i, i, i,
+            i, target, target, i, i,
+            i, target, target, i,
+            i, is_float ? "fcmp une" : "icmp ne", target, i, is_float ? "0.0" : "0",
+            i, i, i,
+            i,
+            i, target, target, i, i,
+            is_float ? "fadd" : "add", target, i, target, i,
+            i,
+            i,
+            i, i,
+            i, i, pt.count,
+            i, i, i,
+            i);
+    }
+
+    put("    ret void\n"
         "}\n");
 
     /* The program requires extra memory or uses callables. Insert
        setup code the top of the function to accomplish this */
-    if (callable_count > 0 || alloca_size >= 0) {
+    if (callable_count > 0 || alloca_size >= 0 || !private_targets.empty()) {
         size_t suffix_start = buffer.size(),
                suffix_target = (char *) strchr(buffer.get(), ':') - buffer.get() + 2;
 
@@ -236,9 +321,22 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
             fmt("    %buffer = alloca i8, i32 $u, align $u\n",
                 alloca_size, alloca_align);
 
+        for (uint32_t i = 0; i < (uint32_t) private_targets.size(); ++i) {
+            const Variable *target = jitc_var(private_targets[i].target_index);
+            uint32_t bytes = private_targets[i].count * 4;
+
+            fmt("    %priv_$u{_0|} = alloca i8, i32 $u, align 64\n"
+                "    call void @llvm.memset.p0{i8|}.i32({i8*} %priv_$u{_0|}, i8 0, i32 $u, i1 false)\n"
+                "{    %priv_$u = bitcast i8* %priv_$u_0 to $t*\n|}",
+                i, bytes, i, bytes, i, i, target);
+        }
+
         buffer.move_suffix(suffix_start, suffix_target);
     }
 
+    if (!private_targets.empty())
+        fmt_intrinsic("declare void @llvm.memset.p0{i8|}.i32({i8*}, i8, i32, i1)");
+
     uint32_t ctr = 0;
     for (auto &it : globals_map) {
         put('\n');
@@ -256,20 +354,8 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
         "!3 = !{i32 1}\n"
         "!4 = !{!\"llvm.loop.unroll.disable\", !\"llvm.loop.vectorize.enable\", i1 0}\n\n");
 
-    fmt("attributes #0 = ${ norecurse nounwind \"frame-pointer\"=\"none\" "
-        "\"no-builtins\" \"no-stack-arg-probe\" \"target-cpu\"=\"$s\" "
-        "\"target-features\"=\"", jitc_llvm_target_cpu);
-
-#if !defined(__aarch64__)
-    put("-vzeroupper");
-    if (jitc_llvm_target_features)
-        put(",");
-#endif
-
-    if (jitc_llvm_target_features)
-        put(jitc_llvm_target_features, strlen(jitc_llvm_target_features));
-
-    put("\" }");
+    jitc_llvm_put_attributes(buffer, jitc_llvm_target_cpu,
+                             jitc_llvm_target_features);
 
     jitc_vcall_upload(ts);
 }
@@ -284,10 +370,10 @@ void jitc_llvm_assemble_func(const char *name, uint32_t inst_id,
                         (jitc_flags() & (uint32_t) JitFlag::PrintIR);
     uint32_t width = jitc_llvm_vector_width, callables_local = callable_count;
     if (use_self)
-        fmt("define void @func_^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^("
+        fmt("define dso_local void @func_^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^("
                     "<$w x i1> %mask, <$w x i32> %self, {i8*} noalias %params");
     else
-        fmt("define void @func_^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^("
+        fmt("define dso_local void @func_^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^("
                     "<$w x i1> %mask, {i8*} noalias %params");
 
     if (!data_map.empty()) {
@@ -330,14 +416,15 @@ void jitc_llvm_assemble_func(const char *name, uint32_t inst_id,
             fmt( "    $v_i{0|1} = getelementptr inbounds i8, {i8*} %params, i64 $u\n"
                 "{    $v_i1 = bitcast i8* $v_i0 to $M*\n|}"
                  "    $v$s = load $M, {$M*} $v_i1, align $A\n",
-                v, v->param_offset * width,
+                v, jitc_var_scratch(v)->param_offset * width,
                 v, v, v,
                 v, vt == VarType::Bool ? "_i2" : "", v, v, v, v);
 
             if (vt == VarType::Bool)
                 fmt("    $v = trunc $M $v_i2 to $T\n",
                     v, v, v, v);
-        } else if (v->is_data() || vt == VarType::Pointer) {
+        } else if (v->is_data() || vt == VarType::Pointer ||
+                   jitc_vcall_literal_data(data_map, inst_id, sv.index, v)) {
             uint64_t key = (uint64_t) sv.index + (((uint64_t) inst_id) << 32);
             auto it = data_map.find(key);
             if (unlikely(it == data_map.end()))
@@ -374,10 +461,8 @@ void jitc_llvm_assemble_func(const char *name, uint32_t inst_id,
             else if (vt == VarType::Bool)
                 fmt("    $v = trunc <$w x i8> $v_p4 to <$w x i1>\n",
                     v, v);
-        } else if (!v->is_stmt()) {
-            jitc_llvm_render_var(sv.index, v);
         } else {
-            jitc_llvm_render_stmt(sv.index, v, true);
+            jitc_llvm_render_var(sv.index, v);
         }
     }
 
@@ -778,7 +863,8 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
 
                 if (is_bool) { // Restore
                     v->type = (uint32_t) VarType::Bool;
-                    fmt("    $v = trunc <$w x i8> %b$u_2 to <$w x i1>\n", v, v->reg_index);
+                    fmt("    $v = trunc <$w x i8> %b$u_2 to <$w x i1>\n", v,
+                        jitc_var_scratch(v)->reg_index);
                 }
             }
             break;
@@ -803,22 +889,27 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
             fmt("    $v = bitcast <$w x i32> %self to <$w x i32>\n", v);
             break;
 
-        case VarKind::Counter:
-            fmt("    $v_0 = trunc i64 %index to $t\n"
-                "    $v_1 = insertelement $T undef, $t $v_0, i32 0\n"
-                "    $v_2 = shufflevector $V_1, $T undef, <$w x i32> $z\n"
-                "    $v = add $V_2, <",
-                v, v, v, v, v, v, v, v, v, v, v);
-            for (uint32_t i = 0; i < jitc_llvm_vector_width; ++i)
-                fmt("i32 $u$s", i, i + 1 < jitc_llvm_vector_width ? ", " : ">\n");
+        case VarKind::Counter: {
+                // Arrays with more than 2^32-1 entries use a 64-bit counter
+                const char *cast = (VarType) v->type == VarType::UInt64 ? "bitcast" : "trunc";
+                fmt("    $v_0 = $s i64 %index to $t\n"
+                    "    $v_1 = insertelement $T undef, $t $v_0, i32 0\n"
+                    "    $v_2 = shufflevector $V_1, $T undef, <$w x i32> $z\n"
+                    "    $v = add $V_2, <",
+                    v, cast, v, v, v, v, v, v, v, v, v, v);
+                for (uint32_t i = 0; i < jitc_llvm_vector_width; ++i)
+                    fmt("$t $u$s", v, i, i + 1 < jitc_llvm_vector_width ? ", " : ">\n");
+            }
             break;
 
-        case VarKind::DefaultMask:
-            fmt("    $v_0 = trunc i64 %end to i32\n"
-                "    $v_1 = insertelement <$w x i32> undef, i32 $v_0, i32 0\n"
-                "    $v_2 = shufflevector <$w x i32> $v_1, <$w x i32> undef, <$w x i32> zeroinitializer\n"
-                "    $v = icmp ult <$w x i32> $v, $v_2\n",
-                v, v, v, v, v, v, a0, v);
+        case VarKind::DefaultMask: {
+                const char *cast = (VarType) a0->type == VarType::UInt64 ? "bitcast" : "trunc";
+                fmt("    $v_0 = $s i64 %end to $t\n"
+                    "    $v_1 = insertelement $T undef, $t $v_0, i32 0\n"
+                    "    $v_2 = shufflevector $T $v_1, $T undef, <$w x i32> zeroinitializer\n"
+                    "    $v = icmp ult $V, $v_2\n",
+                    v, cast, a0, v, a0, a0, v, v, a0, v, a0, v, a0, v);
+            }
             break;
 
         case VarKind::Printf:
@@ -827,8 +918,10 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
 
         case VarKind::Dispatch:
             jitc_var_vcall_assemble((VCall *) state.extra[index].callback_data,
-                                    a0->reg_index, a1->reg_index, a2->reg_index,
-                                    a3 ? a3->reg_index : 0);
+                                    jitc_var_scratch(a0)->reg_index,
+                                    jitc_var_scratch(a1)->reg_index,
+                                    jitc_var_scratch(a2)->reg_index,
+                                    a3 ? jitc_var_scratch(a3)->reg_index : 0);
             break;
 
         case VarKind::TraceRay:
@@ -840,6 +933,32 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
                 (uint32_t) v->literal, v);
             break;
 
+        case VarKind::Copy:
+            fmt("    $v = bitcast $V to $T\n", v, a0, v);
+            break;
+
+        case VarKind::LoopPhi: {
+                // 'a1' is the loop initialization node that defines the labels
+                uint32_t loop_reg = jitc_var_scratch(a1)->reg_index;
+                switch ((LoopPhiType) v->literal) {
+                    case LoopPhiType::Header:
+                        fmt("    $v = phi $T [ $v_final, %l_$u_tail ], [ $v, %l_$u_start ]\n",
+                            v, v, v, loop_reg, a0, loop_reg);
+                        break;
+
+                    case LoopPhiType::HeaderInvariant:
+                        fmt("    $v = phi $T [ $v, %l_$u_tail ], [ $v, %l_$u_start ]\n",
+                            v, v, v, loop_reg, a0, loop_reg);
+                        break;
+
+                    case LoopPhiType::Body:
+                        fmt("    $v = phi $T [ $v, %l_$u_cond ]\n",
+                            v, v, a0, loop_reg);
+                        break;
+                }
+            }
+            break;
+
         default:
             jitc_fail("jitc_llvm_render_var(): unhandled node kind \"%s\"!",
                       var_kind_name[(uint32_t) v->kind]);
@@ -851,6 +970,71 @@ static void jitc_llvm_render_scatter(const Variable *v,
                                      const Variable *value,
                                      const Variable *index,
                                      const Variable *mask) {
+    // Accumulate into a stack buffer (see jitc_private_scan())
+    int priv = callable_depth == 0 ? jitc_private_find(ptr) : -1;
+    if (priv >= 0) {
+        const char *op = jitc_is_float(value) ? "fadd" : "add";
+
+        fmt_intrinsic(
+            "define internal void @reduce_local_$s_$h(<$w x {$t*}> %ptr, $T %value, <$w x i1> %active) #0 ${\n"
+            "L0:\n"
+            "   br label %L1\n\n"
+            "L1:\n"
+            "   %index = phi i32 [ 0, %L0 ], [ %index_next, %L3 ]\n"
+            "   %active_i = extractelement <$w x i1> %active, i32 %index\n"
+            "   br i1 %active_i, label %L2, label %L3\n\n"
+            "L2:\n"
+            "   %ptr_i = extractelement <$w x {$t*}> %ptr, i32 %index\n"
+            "   %value_i = extractelement $T %value, i32 %index\n"
+            "   %before = load $t, {$t*} %ptr_i, align 4\n"
+            "   %after = $s $t %before, %value_i\n"
+            "   store $t %after, {$t*} %ptr_i, align 4\n"
+            "   br label %L3\n\n"
+            "L3:\n"
+            "   %index_next = add nuw nsw i32 %index, 1\n"
+            "   %cond = icmp eq i32 %index_next, $w\n"
+            "   br i1 %cond, label %L4, label %L1\n\n"
+            "L4:\n"
+            "   ret void\n"
+            "$}",
+            op, value, value, value, value, value, value, value, op, value,
+            value, value);
+
+        fmt("    $v_1 = getelementptr $t, {$t*} %priv_$u, $V\n"
+            "    call void @reduce_local_$s_$h(<$w x {$t*}> $v_1, $V, $V)\n",
+            v, value, value, (uint32_t) priv, index,
+            op, value, value, v, value, mask);
+        return;
+    }
+
+    /* The slots obtained by jitc_llvm_render_scatter_inc() are consecutive
+       in lane order. A scatter to them using the same mask (as created by
+       jitc_var_compact()) is therefore a compressing store starting at the
+       slot of the first active lane */
+    if (!v->literal && callable_depth == 0 &&
+        (VarKind) index->kind == VarKind::ScatterInc &&
+        index->dep[2] == v->dep[3] && !jitc_is_bool(value)) {
+        fmt_intrinsic("declare i32 @llvm.experimental.vector.reduce.umin.v$wi32(<$w x i32>)");
+        fmt_intrinsic("declare void @llvm.masked.compressstore.v$w$h($T, {$t*}, $T)",
+                      value, value, value, mask);
+
+        fmt("    $v_2 = insertelement <$w x i32> undef, i32 -1, i32 0\n"
+            "    $v_3 = shufflevector <$w x i32> $v_2, <$w x i32> undef, <$w x i32> $z\n"
+            "    $v_4 = select $V, $V, <$w x i32> $v_3\n"
+            "    $v_5 = call i32 @llvm.experimental.vector.reduce.umin.v$wi32(<$w x i32> $v_4)\n"
+            "{    $v_0 = bitcast i8* $v to $t*\n|}"
+            "    $v_1 = getelementptr $t, {$t*} {$v_0|$v}, i32 $v_5\n"
+            "    call void @llvm.masked.compressstore.v$w$h($V, {$t*} $v_1, $V)\n",
+            v,
+            v, v,
+            v, mask, index, v,
+            v, v,
+            v, ptr, value,
+            v, value, value, v, ptr, v,
+            value, value, value, v, mask);
+        return;
+    }
+
     fmt("{    $v_0 = bitcast $<i8*$> $v to $<$t*$>\n|}"
          "    $v_1 = getelementptr $t, $<{$t*}$> {$v_0|$v}, $V\n",
         v, ptr, value,
@@ -865,7 +1049,11 @@ static void jitc_llvm_render_scatter(const Variable *v,
         const char *op, *zero_elem = nullptr, *intrinsic_name = nullptr;
         switch ((ReduceOp) v->literal) {
             case ReduceOp::Add:
-                if (jitc_is_single(value)) {
+                if (jitc_is_half(value)) {
+                    op = "fadd";
+                    zero_elem = "half -0.0, ";
+                    intrinsic_name = "v2.fadd.f16";
+                } else if (jitc_is_single(value)) {
                     op = "fadd";
                     zero_elem = "float -0.0, ";
                     intrinsic_name = "v2.fadd.f32";
@@ -879,7 +1067,11 @@ static void jitc_llvm_render_scatter(const Variable *v,
                 break;
 
             case ReduceOp::Mul:
-                if (jitc_is_single(value)) {
+                if (jitc_is_half(value)) {
+                    op = "fmul";
+                    zero_elem = "half -0.0, ";
+                    intrinsic_name = "v2.fmul.f16";
+                } else if (jitc_is_single(value)) {
                     op = "fmul";
                     zero_elem = "float -0.0, ";
                     intrinsic_name = "v2.fmul.f32";
@@ -924,6 +1116,13 @@ static void jitc_llvm_render_scatter(const Variable *v,
 
         const char *reassoc = jitc_is_float(value) ? "reassoc " : "";
 
+        // 'atomicrmw' refers to signed minima/maxima as 'min'/'max'
+        const char *atomic_op = op;
+        if (op && strcmp(op, "smin") == 0)
+            atomic_op = "min";
+        else if (op && strcmp(op, "smax") == 0)
+            atomic_op = "max";
+
         fmt_intrinsic(
             "define internal void @reduce_$s_$h(<$w x {$t*}> %ptr, $T %value, <$w x i1> %active_in) #0 ${\n"
             "L0:\n"
@@ -954,7 +1153,7 @@ static void jitc_llvm_render_scatter(const Variable *v,
             "   ret void\n"
             "$}",
             op, value, value, value, value, value, value, value, value, value, value, value, reassoc,
-            value, intrinsic_name, value, zero_elem ? zero_elem : "", value, op, value, value
+            value, intrinsic_name, value, zero_elem ? zero_elem : "", value, atomic_op, value, value
         );
 
         fmt("    call void @reduce_$s_$h(<$w x {$t*}> $v_1, $V, $V)\n",
@@ -977,6 +1176,47 @@ static void jitc_llvm_render_scatter_inc(Variable *v,
         v, ptr, v,
         v, v, v, v, mask);
 
+    if (jitc_llvm_has_feature("avx512vpopcntdq") && jitc_llvm_vector_width <= 16) {
+        /* Count the active preceding lanes of every lane via a vector
+           population count (vpopcntd) instead of a loop over the lanes */
+        std::string lane_masks = "<";
+        for (uint32_t i = 0; i < jitc_llvm_vector_width; ++i) {
+            lane_masks += "i32 " + std::to_string((1ull << i) - 1);
+            lane_masks += i + 1 < jitc_llvm_vector_width ? ", " : ">";
+        }
+
+        fmt_intrinsic("declare <$w x i32> @llvm.ctpop.v$wi32(<$w x i32>)");
+        fmt_intrinsic("declare i32 @llvm.ctpop.i32(i32)");
+
+        fmt_intrinsic(
+            "define internal <$w x i32> @reduce_inc_u32({i32*} %ptr, <$w x i1> %active) #0 ${\n"
+            "L0:\n"
+            "   %bits_0 = bitcast <$w x i1> %active to i$w\n"
+            "   %bits_1 = zext i$w %bits_0 to i32\n"
+            "   %bits_2 = insertelement <$w x i32> undef, i32 %bits_1, i32 0\n"
+            "   %bits_3 = shufflevector <$w x i32> %bits_2, <$w x i32> undef, <$w x i32> $z\n"
+            "   %prefix_0 = and <$w x i32> %bits_3, $s\n"
+            "   %prefix = call <$w x i32> @llvm.ctpop.v$wi32(<$w x i32> %prefix_0)\n"
+            "   %sum = call i32 @llvm.ctpop.i32(i32 %bits_1)\n"
+            "   %cond = icmp eq i32 %sum, 0\n"
+            "   br i1 %cond, label %L2, label %L1\n\n"
+            "L1:\n"
+            "   %old_1 = atomicrmw add {i32*} %ptr, i32 %sum monotonic\n"
+            "   %old_2 = insertelement <$w x i32> undef, i32 %old_1, i32 0\n"
+            "   %old_3 = shufflevector <$w x i32> %old_2, <$w x i32> undef, <$w x i32> $z\n"
+            "   %prefix_final = add <$w x i32> %prefix, %old_3\n"
+            "   br label %L2;\n\n"
+            "L2:\n"
+            "   %prefix_combined = phi <$w x i32> [ %prefix, %L0 ], [ %prefix_final, %L1 ]\n"
+            "   ret <$w x i32> %prefix_combined\n"
+            "$}",
+            lane_masks.c_str()
+        );
+
+        v->consumed = 1;
+        return;
+    }
+
     fmt_intrinsic(
         "define internal <$w x i32> @reduce_inc_u32({i32*} %ptr, <$w x i1> %active) #0 ${\n"
         "L0:\n"
@@ -1111,7 +1351,7 @@ static void jitc_llvm_render_printf(uint32_t index, const Variable *v,
     jitc_register_global(buffer.get() + buffer_offset);
     buffer.rewind_to(buffer_offset);
 
-    uint32_t idx = v->reg_index;
+    uint32_t idx = jitc_var_scratch(v)->reg_index;
 
     fmt("    br label %l$u_start\n\n"
         "l$u_start: ; ---- printf_async() ----\n"
@@ -1165,82 +1405,6 @@ static void jitc_llvm_render_printf(uint32_t index, const Variable *v,
         idx, idx, v, v, v, v, v, idx, idx, idx);
 }
 
-/// Convert an IR template with '$' expressions into valid IR
-static void jitc_llvm_render_stmt(uint32_t index, const Variable *v, bool in_function) {
-    const char *s = v->stmt;
-    if (unlikely(!s || *s == '\0'))
-        return;
-    put("    ");
-    char c;
-    size_t intrinsic_start = 0;
-    do {
-        const char *start = s;
-        while (c = *s, c != '\0' && c != '$')
-            s++;
-        put(start, s - start);
-
-        if (c == '$') {
-            s++;
-            const char **prefix_table = nullptr, tname = *s++;
-            switch (tname) {
-                case '[':
-                    intrinsic_start = buffer.size();
-                    continue;
-
-                case ']':
-                    jitc_register_global(buffer.get() + intrinsic_start);
-                    buffer.rewind_to(intrinsic_start);
-                    continue;
-
-                case 'n': put("\n    "); continue;
-                case 'z': put("zeroinitializer"); continue;
-                case 'w': buffer.put_u32(jitc_llvm_vector_width); continue;
-                case 't': prefix_table = type_name_llvm; break;
-                case 'T': prefix_table = type_name_llvm_big; break;
-                case 'b': prefix_table = type_name_llvm_bin; break;
-                case 'a': prefix_table = type_name_llvm_abbrev; break;
-                case 's': prefix_table = type_size_str; break;
-                case 'r': prefix_table = type_prefix; break;
-                case 'i': prefix_table = nullptr; break;
-                case '<': if (in_function) {
-                              put('<');
-                              buffer.put_u32(jitc_llvm_vector_width);
-                              put(" x ");
-                           }
-                           continue;
-                case '>': if (in_function)
-                              put('>');
-                           continue;
-                case 'o': prefix_table = (const char **) jitc_llvm_ones_str; break;
-                default:
-                    jitc_fail("jit_render_stmt_llvm(): encountered invalid \"$\" "
-                              "expression (unknown character \"%c\") in \"%s\"!", tname, v->stmt);
-            }
-
-            uint32_t arg_id = *s++ - '0';
-            if (unlikely(arg_id > 4))
-                jitc_fail("jit_render_stmt_llvm(%s): encountered invalid \"$\" "
-                          "expression (argument out of bounds)!", v->stmt);
-
-            uint32_t dep_id = arg_id == 0 ? index : v->dep[arg_id - 1];
-            if (unlikely(dep_id == 0))
-                jitc_fail("jit_render_stmt_llvm(%s): encountered invalid \"$\" "
-                          "expression (referenced variable %u is missing)!", v->stmt, arg_id);
-
-            const Variable *dep = jitc_var(dep_id);
-            if (likely(prefix_table)) {
-                const char *prefix = prefix_table[(int) dep->type];
-                put(prefix, strlen(prefix));
-            }
-
-            if (tname == 'r' || tname == 'i')
-                buffer.put_u32(dep->reg_index);
-        }
-    } while (c != '\0');
-
-    put('\n');
-}
-
 void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
                          const uint32_t *in, uint32_t *out) {
     const uint32_t n_args = 14;
@@ -1253,7 +1417,7 @@ void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
                      VarType::UInt32, VarType::UInt32 };
 
     bool placeholder = false, dirty = false;
-    uint32_t size = 0;
+    size_t size = 0;
     for (uint32_t i = 0; i < n_args; ++i) {
         const Variable *v = jitc_var(in[i]);
         if ((VarType) v->type != types[i])
@@ -1299,7 +1463,7 @@ void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
         valid = steal(jitc_var_select(valid, minus_one, zero));
     }
 
-    jitc_log(InfoSym, "jitc_llvm_ray_trace(): tracing %u %sray%s%s", size,
+    jitc_log(InfoSym, "jitc_llvm_ray_trace(): tracing %zu %sray%s%s", size,
              shadow_ray ? "shadow " : "", size != 1 ? "s" : "",
              placeholder ? " (part of a recorded computation)" : "");
 
@@ -1436,6 +1600,8 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
     } else {
         fmt_intrinsic("declare i64 @llvm.experimental.vector.reduce.umax.v$wi64(<$w x i64>)");
 
+        uint32_t idx = jitc_var_scratch(v)->reg_index;
+
         // =====================================================
         // 1. Prepare the loop for the ray tracing calls
         // =====================================================
@@ -1450,9 +1616,9 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
              "    $v_func_ptr = inttoptr i64 $v_func_i64 to {i8*}\n"
              "    $v_tfar_{0|1} = getelementptr inbounds i8, {i8*} %buffer, i32 $u\n"
             "{    $v_tfar_1 = bitcast i8* $v_tfar_0 to <$w x $s> *\n|}",
-            v->reg_index,
-            v->reg_index,
-            v, func->reg_index,
+            idx,
+            idx,
+            v, jitc_var_scratch(func)->reg_index,
             v, v,
             v, offset_tfar,
             v, v, tname_tfar);
@@ -1465,7 +1631,7 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
         // Get original mask, to be overwritten at every iteration
         fmt("    $v_mask_value = load <$w x i32>, {<$w x i32>*} $v_in_0_1, align 64\n"
             "    br label %l$u_check\n",
-            v, v, v->reg_index);
+            v, v, idx);
 
         // =====================================================
         // 2. Move on to the next instance & check if finished
@@ -1478,13 +1644,13 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
             "    $v_next = inttoptr i64 $v_next_i64 to {i8*}\n"
             "    $v_valid = icmp ne {i8*} $v_next, null\n"
             "    br i1 $v_valid, label %l$u_call, label %l$u_end\n",
-            v->reg_index,
-            v, scene->reg_index, v->reg_index, v, v->reg_index,
+            idx,
+            v, jitc_var_scratch(scene)->reg_index, idx, v, idx,
             v, v,
             v, v,
             v, v,
             v, v,
-            v, v->reg_index, v->reg_index);
+            v, idx, idx);
 
         // =====================================================
         // 3. Perform ray tracing call to each unique instance
@@ -1498,7 +1664,7 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
             "    $v_active = icmp eq <$w x {i8*}> $v_scene, $v_bcast_2\n"
             "    $v_active_2 = select <$w x i1> $v_active, <$w x i32> $v_mask_value, <$w x i32> $z\n"
             "    store <$w x i32> $v_active_2, {<$w x i32>*} $v_in_0_1, align 64\n",
-            v->reg_index,
+            idx,
             v, tname_tfar, tname_tfar, v, float_size * width,
             v, v,
             v, v,
@@ -1524,7 +1690,7 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
             v, v, tname_tfar, v, tname_tfar, v,
             tname_tfar, v, tname_tfar, v, float_size * width,
             v, v, v,
-            v->reg_index, v->reg_index);
+            idx, idx);
     }
 
     offset = (8 * float_size + 4) * width;
@@ -1554,9 +1720,9 @@ static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
 void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
                                   uint32_t self_reg, uint32_t mask_reg,
                                   uint32_t offset_reg, uint32_t data_reg,
-                                  uint32_t n_out, uint32_t in_size,
-                                  uint32_t in_align, uint32_t out_size,
-                                  uint32_t out_align) {
+                                  uint32_t profile_reg, uint32_t n_out,
+                                  uint32_t in_size, uint32_t in_align,
+                                  uint32_t out_size, uint32_t out_align) {
 
     uint32_t width = jitc_llvm_vector_width;
     alloca_size  = std::max(alloca_size, (int32_t) ((in_size + out_size) * width));
@@ -1610,10 +1776,9 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
     uint32_t offset = 0;
     for (uint32_t i = 0; i < (uint32_t) vcall->in.size(); ++i) {
         uint32_t index = vcall->in[i];
-        auto it = state.variables.find(index);
-        if (it == state.variables.end())
+        const Variable *v2 = jitc_var_maybe(index);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
 
         fmt(
              "    %u$u_in_$u_{0|1} = getelementptr inbounds i8, {i8*} %buffer, i32 $u\n"
@@ -1642,10 +1807,9 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
     offset = 0;
     for (uint32_t i = 0; i < n_out; ++i) {
         uint32_t index = vcall->out_nested[i];
-        auto it = state.variables.find(index);
-        if (it == state.variables.end())
+        const Variable *v2 = jitc_var_maybe(index);
+        if (!v2)
             continue;
-        const Variable *v2 = &it->second;
 
         fmt( "    %u$u_tmp_$u_{0|1} = getelementptr inbounds i8, {i8*} %u$u_out, i64 $u\n"
             "{    %u$u_tmp_$u_1 = bitcast i8* %u$u_tmp_$u_0 to $M*\n|}"
@@ -1661,12 +1825,28 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
     // 3. Perform one call to each unique instance
     // =====================================================
 
+    /* Frequently called instances (JitFlag::VCallProfile) use a direct call
+       that LLVM may inline. Their callables are identified by address. */
+    std::vector<XXH128_hash_t> direct;
+    for (uint32_t id : vcall->hot) {
+        auto it = std::find(vcall->inst_id.begin(), vcall->inst_id.end(), id);
+        if (callable_depth != 0 || it == vcall->inst_id.end())
+            break;
+        const XXH128_hash_t &hash = vcall->inst_hash[it - vcall->inst_id.begin()];
+        bool found = false;
+        for (const XXH128_hash_t &h : direct)
+            found |= h.high64 == hash.high64 && h.low64 == hash.low64;
+        if (!found)
+            direct.push_back(hash);
+    }
+
     fmt("    br label %l$u_check\n"
         "\nl$u_check:\n"
-        "    %u$u_self = phi <$w x i32> [ %u$u_self_initial, %l$u_start ], [ %u$u_self_next, %l$u_call ]\n",
+        "    %u$u_self = phi <$w x i32> [ %u$u_self_initial, %l$u_start ], [ %u$u_self_next, %l$u_$s ]\n",
         vcall_reg,
         vcall_reg,
-        vcall_reg, vcall_reg, vcall_reg, vcall_reg, vcall_reg);
+        vcall_reg, vcall_reg, vcall_reg, vcall_reg, vcall_reg,
+        direct.empty() ? "call" : "join");
 
     fmt("    %u$u_next = call i32 @llvm.experimental.vector.reduce.umax.v$wi32(<$w x i32> %u$u_self)\n"
         "    %u$u_valid = icmp ne i32 %u$u_next, 0\n"
@@ -1689,10 +1869,28 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
         vcall_reg, vcall_reg // func_1
     );
 
-    // Cast into correctly typed function pointer
-    if (!jitc_llvm_opaque_pointers) {
-        fmt("    %u$u_func = bitcast i8* %u$u_func_1 to void (<$w x i1>",
-                 vcall_reg, vcall_reg);
+    // Count the calls of each instance (JitFlag::VCallProfile)
+    if (profile_reg) {
+        fmt_intrinsic("declare i32 @llvm.experimental.vector.reduce.add.v$wi32(<$w x i32>)");
+        fmt( "    %u$u_inst_0 = select <$w x i1> %u$u_active, <$w x i32> %r$u, <$w x i32> $z\n"
+             "    %u$u_inst = call i32 @llvm.experimental.vector.reduce.umax.v$wi32(<$w x i32> %u$u_inst_0)\n"
+             "    %u$u_count_0 = zext <$w x i1> %u$u_active to <$w x i32>\n"
+             "    %u$u_count = call i32 @llvm.experimental.vector.reduce.add.v$wi32(<$w x i32> %u$u_count_0)\n"
+            "{    %u$u_counter_0 = bitcast i8* %rd$u to i32*\n|}"
+             "    %u$u_counter = getelementptr inbounds i32, {i32*} {%u$u_counter_0|%rd$u}, i32 %u$u_inst\n"
+             "    atomicrmw add {i32*} %u$u_counter, i32 %u$u_count monotonic\n",
+            vcall_reg, vcall_reg, self_reg,
+            vcall_reg, vcall_reg,
+            vcall_reg, vcall_reg,
+            vcall_reg, vcall_reg,
+            vcall_reg, profile_reg,
+            vcall_reg, vcall_reg, profile_reg, vcall_reg,
+            vcall_reg, vcall_reg);
+    }
+
+    // Type of the function pointer (with typed pointers)
+    auto put_func_type = [&]() {
+        fmt("void (<$w x i1>");
 
         if (vcall->use_self)
             fmt(", <$w x i32>");
@@ -1701,23 +1899,63 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
         if (data_reg)
             fmt(", $<i8*$>, <$w x i32>");
 
-        fmt(")*\n");
+        fmt(")*");
+    };
+
+    // Cast into correctly typed function pointer
+    if (!jitc_llvm_opaque_pointers) {
+        fmt("    %u$u_func = bitcast i8* %u$u_func_1 to ", vcall_reg, vcall_reg);
+        put_func_type();
+        put('\n');
     }
 
     // Perform the actual function call
-    fmt("    call void %u$u_func(<$w x i1> %u$u_active",
-        vcall_reg, vcall_reg);
+    auto put_call = [&](const XXH128_hash_t *hash) {
+        if (hash)
+            fmt("    call void @func_$Q$Q(<$w x i1> %u$u_active",
+                hash->high64, hash->low64, vcall_reg);
+        else
+            fmt("    call void %u$u_func(<$w x i1> %u$u_active",
+                vcall_reg, vcall_reg);
 
-    if (vcall->use_self)
-        fmt(", <$w x i32> %r$u", self_reg);
+        if (vcall->use_self)
+            fmt(", <$w x i32> %r$u", self_reg);
 
-    fmt(", {i8*} %buffer");
+        fmt(", {i8*} %buffer");
 
-    if (data_reg)
-        fmt(", $<{i8*}$> %rd$u, <$w x i32> %u$u_offset", data_reg, vcall_reg);
+        if (data_reg)
+            fmt(", $<{i8*}$> %rd$u, <$w x i32> %u$u_offset", data_reg, vcall_reg);
 
-    fmt(")\n"
-        "    %u$u_self_next = select <$w x i1> %u$u_active, <$w x i32> $z, <$w x i32> %u$u_self\n"
+        put(")\n");
+    };
+
+    for (uint32_t i = 0; i < (uint32_t) direct.size(); ++i) {
+        const XXH128_hash_t &hash = direct[i];
+        fmt("    %u$u_direct_$u = icmp eq ", vcall_reg, i);
+        if (jitc_llvm_opaque_pointers)
+            put("ptr");
+        else
+            put_func_type();
+        fmt(" %u$u_func, @func_$Q$Q\n"
+            "    br i1 %u$u_direct_$u, label %l$u_direct_$u, label %l$u_indirect_$u\n"
+            "\nl$u_direct_$u:\n",
+            vcall_reg, hash.high64, hash.low64,
+            vcall_reg, i, vcall_reg, i, vcall_reg, i,
+            vcall_reg, i);
+        put_call(&hash);
+        fmt("    br label %l$u_join\n"
+            "\nl$u_indirect_$u:\n",
+            vcall_reg, vcall_reg, i);
+    }
+
+    put_call(nullptr);
+
+    if (!direct.empty())
+        fmt("    br label %l$u_join\n"
+            "\nl$u_join:\n",
+            vcall_reg, vcall_reg);
+
+    fmt("    %u$u_self_next = select <$w x i1> %u$u_active, <$w x i32> $z, <$w x i32> %u$u_self\n"
         "    br label %l$u_check\n"
         "\nl$u_end:\n",
         vcall_reg, vcall_reg, vcall_reg, vcall_reg,
@@ -1729,22 +1967,20 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
 
     offset = 0;
     for (uint32_t i = 0; i < n_out; ++i) {
-        uint32_t index = vcall->out_nested[i],
-                 index_2 = vcall->out[i];
-        auto it = state.variables.find(index);
-        if (it == state.variables.end())
+        uint32_t index = vcall->out_nested[i];
+        const Variable *v = jitc_var_maybe(index);
+        if (!v)
             continue;
-        uint32_t size = type_size[it->second.type],
+        uint32_t size = type_size[v->type],
                  load_offset = offset;
         offset += size * width;
 
         // Skip if outer access expired
-        auto it2 = state.variables.find(index_2);
-        if (it2 == state.variables.end())
+        const Variable *v2 = jitc_var(vcall->out[i]);
+        if (!v2)
             continue;
-
-        const Variable *v2 = &it2.value();
-        if (v2->reg_index == 0 || v2->param_type == ParamType::Input)
+        const VariableScratch *vs2 = jitc_var_scratch(v2);
+        if (vs2->reg_index == 0 || vs2->param_type == ParamType::Input)
             continue;
 
         VarType vt = (VarType) v2->type;
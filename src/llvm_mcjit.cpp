@@ -5,17 +5,17 @@
 
 static uint32_t jitc_llvm_patch_loc = 0;
 static LLVMExecutionEngineRef m_jitc_llvm_engine = nullptr;
-extern LLVMTargetMachineRef jitc_llvm_tm;
+extern LLVMCompiler jitc_llvm_compiler;
 
 /// Create a MCJIT compilation engine configured for use with Dr.Jit
-LLVMExecutionEngineRef jitc_llvm_engine_create(LLVMModuleRef mod_) {
+LLVMExecutionEngineRef jitc_llvm_engine_create(LLVMCompiler &c, LLVMModuleRef mod_) {
     LLVMMCJITCompilerOptions options;
     options.OptLevel = LLVMCodeGenLevelAggressive;
     options.CodeModel = LLVMCodeModelSmall;
     options.NoFramePointerElim = false;
     options.EnableFastISel = false;
     options.MCJMM = LLVMCreateSimpleMCJITMemoryManager(
-        nullptr,
+        &c.memmgr,
         jitc_llvm_memmgr_allocate,
         jitc_llvm_memmgr_allocate_data,
         jitc_llvm_memmgr_finalize,
@@ -33,7 +33,7 @@ LLVMExecutionEngineRef jitc_llvm_engine_create(LLVMModuleRef mod_) {
         return nullptr;
     }
 
-    jitc_llvm_tm = LLVMGetExecutionEngineTargetMachine(engine);
+    c.tm = LLVMGetExecutionEngineTargetMachine(engine);
 
     if (jitc_llvm_patch_loc) {
         uint32_t *base = (uint32_t *) LLVMGetExecutionEngineTargetMachine(engine);
@@ -45,7 +45,7 @@ LLVMExecutionEngineRef jitc_llvm_engine_create(LLVMModuleRef mod_) {
 
 bool jitc_llvm_mcjit_init() {
 #if defined(DRJIT_DYNAMIC_LLVM) && !defined(__aarch64__)
-    m_jitc_llvm_engine = jitc_llvm_engine_create(nullptr);
+    m_jitc_llvm_engine = jitc_llvm_engine_create(jitc_llvm_compiler, nullptr);
     if (!m_jitc_llvm_engine)
         return false;
 
@@ -105,15 +105,17 @@ void jitc_llvm_mcjit_shutdown() {
         m_jitc_llvm_engine = nullptr;
     }
     jitc_llvm_patch_loc = 0;
-    jitc_llvm_tm = nullptr;
+    jitc_llvm_compiler.tm = nullptr;
 }
 
-void jitc_llvm_mcjit_compile(void *llvm_module,
+/// MCJIT only supports the main compiler instance ('jitc_llvm_compiler')
+void jitc_llvm_mcjit_compile(LLVMCompiler &c, void *llvm_module,
+                             const std::vector<std::string> &names,
                              std::vector<uint8_t*> &symbols) {
     if (m_jitc_llvm_engine)
         LLVMDisposeExecutionEngine(m_jitc_llvm_engine);
 
-    m_jitc_llvm_engine = jitc_llvm_engine_create((LLVMModuleRef) llvm_module);
+    m_jitc_llvm_engine = jitc_llvm_engine_create(c, (LLVMModuleRef) llvm_module);
 
     auto resolve = [&](const char *name) -> uint8_t * {
         uint8_t *p = (uint8_t *) LLVMGetFunctionAddress(m_jitc_llvm_engine, name);
@@ -123,23 +125,6 @@ void jitc_llvm_mcjit_compile(void *llvm_module,
         return p;
     };
 
-    size_t symbol_pos = 0;
-    symbols[symbol_pos++] = resolve(kernel_name);
-
-    /// Does the kernel perform virtual function calls via @callables?
-    if (callable_count_unique) {
-        symbols[symbol_pos++] = resolve("callables");
-
-        for (auto const &kv: globals_map) {
-            if (!kv.first.callable)
-                continue;
-
-            char name_buf[38];
-            snprintf(name_buf, sizeof(name_buf), "func_%016llx%016llx",
-                     (unsigned long long) kv.first.hash.high64,
-                     (unsigned long long) kv.first.hash.low64);
-
-            symbols[symbol_pos++] = resolve(name_buf);
-        }
-    }
+    for (size_t i = 0; i < names.size(); ++i)
+        symbols[i] = resolve(names[i].c_str());
 }
@@ -4,17 +4,16 @@
 #include "log.h"
 #include "eval.h"
 
-static LLVMOrcLLJITRef jitc_llvm_lljit = nullptr;
-static LLVMOrcJITDylibRef jitc_llvm_lljit_dylib = nullptr;
-extern LLVMTargetMachineRef jitc_llvm_tm;
+extern LLVMCompiler jitc_llvm_compiler;
 
-LLVMOrcObjectLayerRef oll_creator(void *, LLVMOrcExecutionSessionRef es, const char *) {
+/// 'ctx' refers to the LLVMCompiler whose memory manager receives the code
+LLVMOrcObjectLayerRef oll_creator(void *ctx, LLVMOrcExecutionSessionRef es, const char *) {
 #if defined(LLVM_VERSION_MAJOR) && LLVM_VERSION_MAJOR < 16
-    (void) es;
+    (void) ctx; (void) es;
     jitc_fail("OrcV2 interface is not usable in LLVM versions < 16");
 #else
     return LLVMOrcCreateRTDyldObjectLinkingLayerWithMCJITMemoryManagerLikeCallbacks(
-        es, nullptr,
+        es, &((LLVMCompiler *) ctx)->memmgr,
         jitc_llvm_memmgr_create_context,
         jitc_llvm_memmgr_notify_terminating,
         jitc_llvm_memmgr_allocate,
@@ -25,10 +24,7 @@ LLVMOrcObjectLayerRef oll_creator(void *, LLVMOrcExecutionSessionRef es, const c
 #endif
 }
 
-bool jitc_llvm_orcv2_init() {
-    if (jitc_llvm_lljit)
-        return true;
-
+bool jitc_llvm_orcv2_create(LLVMCompiler &c) {
     LLVMTargetRef target_ref;
     char *err_str = nullptr;
     if (LLVMGetTargetFromTriple(jitc_llvm_target_triple, &target_ref, &err_str)) {
@@ -47,7 +43,7 @@ bool jitc_llvm_orcv2_init() {
             jitc_llvm_target_features, LLVMCodeGenLevelAggressive, LLVMRelocPIC,
             LLVMCodeModelSmall);
         if (i == 0)
-            jitc_llvm_tm = tm;
+            c.tm = tm;
     }
 
     LLVMOrcJITTargetMachineBuilderRef machine_builder =
@@ -59,36 +55,52 @@ bool jitc_llvm_orcv2_init() {
                                                   machine_builder);
 
     LLVMOrcLLJITBuilderSetObjectLinkingLayerCreator(lljit_builder, oll_creator,
-                                                    (void *) NULL);
+                                                    (void *) &c);
 
-    LLVMErrorRef err = LLVMOrcCreateLLJIT(&jitc_llvm_lljit, lljit_builder);
+    LLVMOrcLLJITRef lljit = nullptr;
+    LLVMErrorRef err = LLVMOrcCreateLLJIT(&lljit, lljit_builder);
     if (err)
         jitc_fail("jit_llvm_compile(): could not create LLJIT: %s",
                   LLVMGetErrorMessage(err));
 
-    jitc_llvm_lljit_dylib = LLVMOrcLLJITGetMainJITDylib(jitc_llvm_lljit);
+    c.lljit = lljit;
+    c.dylib = LLVMOrcLLJITGetMainJITDylib(lljit);
 
     return true;
 }
 
-void jitc_llvm_orcv2_shutdown() {
-    if (!jitc_llvm_lljit)
+void jitc_llvm_orcv2_destroy(LLVMCompiler &c) {
+    if (!c.lljit)
         return;
 
-    LLVMErrorRef err = LLVMOrcDisposeLLJIT(jitc_llvm_lljit);
+    LLVMErrorRef err = LLVMOrcDisposeLLJIT((LLVMOrcLLJITRef) c.lljit);
     if (err)
         jitc_fail("jit_llvm_orcv2_shutdown(): could not dispose LLJIT: %s",
                   LLVMGetErrorMessage(err));
-    LLVMDisposeTargetMachine(jitc_llvm_tm);
+    LLVMDisposeTargetMachine((LLVMTargetMachineRef) c.tm);
+
+    c.lljit = nullptr;
+    c.dylib = nullptr;
+    c.tm = nullptr;
+}
+
+bool jitc_llvm_orcv2_init() {
+    if (jitc_llvm_compiler.lljit)
+        return true;
+    return jitc_llvm_orcv2_create(jitc_llvm_compiler);
+}
 
-    jitc_llvm_lljit = nullptr;
-    jitc_llvm_lljit_dylib = nullptr;
-    jitc_llvm_tm = nullptr;
+void jitc_llvm_orcv2_shutdown() {
+    jitc_llvm_orcv2_destroy(jitc_llvm_compiler);
 }
 
-void jitc_llvm_orcv2_compile(void *llvm_module,
+void jitc_llvm_orcv2_compile(LLVMCompiler &c, void *llvm_module,
+                             const std::vector<std::string> &names,
                              std::vector<uint8_t*> &symbols) {
-    LLVMErrorRef err = LLVMOrcJITDylibClear(jitc_llvm_lljit_dylib);
+    LLVMOrcLLJITRef lljit = (LLVMOrcLLJITRef) c.lljit;
+    LLVMOrcJITDylibRef dylib = (LLVMOrcJITDylibRef) c.dylib;
+
+    LLVMErrorRef err = LLVMOrcJITDylibClear(dylib);
     if (err)
         jitc_fail("jit_llvm_compile(): could not clear dylib: %s",
                   LLVMGetErrorMessage(err));
@@ -98,8 +110,7 @@ void jitc_llvm_orcv2_compile(void *llvm_module,
         LLVMOrcCreateNewThreadSafeModule((LLVMModuleRef) llvm_module, ts_ctx);
     LLVMOrcDisposeThreadSafeContext(ts_ctx);
 
-    err = LLVMOrcLLJITAddLLVMIRModule(jitc_llvm_lljit, jitc_llvm_lljit_dylib,
-                                      ts_mod);
+    err = LLVMOrcLLJITAddLLVMIRModule(lljit, dylib, ts_mod);
 
     if (err)
         jitc_fail("jit_llvm_compile(): could not add module: %s",
@@ -107,29 +118,13 @@ void jitc_llvm_orcv2_compile(void *llvm_module,
 
     auto resolve = [&](const char *name) -> uint8_t * {
         LLVMOrcExecutorAddress p;
-        LLVMErrorRef err = LLVMOrcLLJITLookup(jitc_llvm_lljit, &p, name);
+        LLVMErrorRef err = LLVMOrcLLJITLookup(lljit, &p, name);
         if (err)
             jitc_fail("jit_llvm_compile(): could not resolve symbol: %s",
                       LLVMGetErrorMessage(err));
         return (uint8_t *) p;
     };
 
-    size_t symbol_pos = 0;
-    symbols[symbol_pos++] = resolve(kernel_name);
-
-    /// Does the kernel perform virtual function calls via @callables?
-    if (callable_count_unique) {
-        symbols[symbol_pos++] = resolve("callables");
-
-        for (auto const &kv: globals_map) {
-            if (!kv.first.callable)
-                continue;
-
-            char name_buf[38];
-            snprintf(name_buf, sizeof(name_buf), "func_%016llx%016llx",
-                     (unsigned long long) kv.first.hash.high64,
-                     (unsigned long long) kv.first.hash.low64);
-            symbols[symbol_pos++] = resolve(name_buf);
-        }
-    }
+    for (size_t i = 0; i < names.size(); ++i)
+        symbols[i] = resolve(names[i].c_str());
 }
@@ -0,0 +1,416 @@
+/*
+    src/llvm_tex.cpp -- Texture objects for the LLVM backend
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "llvm_tex.h"
+#include "internal.h"
+#include "log.h"
+#include "var.h"
+#include "op.h"
+#include "eval.h"
+#include <string.h>
+#include <string>
+
+/* Texels are stored in tiles of 4x4 (2D) or 4x4x4 (3D) texels with
+   interleaved channels. The neighborhood accessed by a filtered lookup then
+   mostly falls into the same few cache lines. 1D textures are stored
+   linearly. Lookups are expressed using ordinary gathers and arithmetic,
+   which the LLVM backend vectorizes like any other computation. */
+
+#define DRJIT_LLVM_TEX_TILE_LOG2 2
+#define DRJIT_LLVM_TEX_TILE_MASK ((1u << DRJIT_LLVM_TEX_TILE_LOG2) - 1)
+
+struct DrJitLLVMTexture {
+    size_t ndim;
+    size_t shape[3];
+    /// Number of tiles along each dimension
+    size_t tiles[3];
+    size_t n_channels;
+    int filter_mode;
+    int wrap_mode;
+    /// Variable index of a Float32 array storing the tiled texels
+    uint32_t data;
+
+    /// Offset of the texel at position 'p' in units of texels
+    size_t offset(const size_t *p) const {
+        if (ndim == 1)
+            return p[0];
+
+        size_t tile = 0, inner = 0;
+        for (size_t i = ndim; i-- > 0; ) {
+            tile = tile * tiles[i] + (p[i] >> DRJIT_LLVM_TEX_TILE_LOG2);
+            inner = (inner << DRJIT_LLVM_TEX_TILE_LOG2) |
+                    (p[i] & DRJIT_LLVM_TEX_TILE_MASK);
+        }
+
+        return (tile << (DRJIT_LLVM_TEX_TILE_LOG2 * ndim)) | inner;
+    }
+};
+
+static Ref jitc_llvm_tex_u32(uint32_t value) {
+    return steal(jitc_var_literal(JitBackend::LLVM, VarType::UInt32, &value, 1, 0));
+}
+
+static Ref jitc_llvm_tex_i32(int32_t value) {
+    return steal(jitc_var_literal(JitBackend::LLVM, VarType::Int32, &value, 1, 0));
+}
+
+static Ref jitc_llvm_tex_f32(float value) {
+    return steal(jitc_var_literal(JitBackend::LLVM, VarType::Float32, &value, 1, 0));
+}
+
+void *jitc_llvm_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
+                           int filter_mode, int wrap_mode) {
+    if (ndim < 1 || ndim > 3)
+        jitc_raise("jit_llvm_tex_create(): invalid texture dimension!");
+    else if (n_channels == 0)
+        jitc_raise("jit_llvm_tex_create(): must have at least 1 channel!");
+    else if (filter_mode < 0 || filter_mode > 2)
+        jitc_raise("jit_llvm_tex_create(): invalid filter mode!");
+    else if (wrap_mode < 0 || wrap_mode > 2)
+        jitc_raise("jit_llvm_tex_create(): invalid wrap mode!");
+
+    DrJitLLVMTexture *tex = new DrJitLLVMTexture();
+    tex->ndim = ndim;
+    tex->n_channels = n_channels;
+    tex->filter_mode = filter_mode;
+    tex->wrap_mode = wrap_mode;
+
+    size_t size = n_channels;
+    for (size_t i = 0; i < ndim; ++i) {
+        if (shape[i] == 0) {
+            delete tex;
+            jitc_raise("jit_llvm_tex_create(): texture shape must be nonzero!");
+        }
+        tex->shape[i] = shape[i];
+        tex->tiles[i] = ndim == 1 ? shape[i]
+                                  : (shape[i] + DRJIT_LLVM_TEX_TILE_MASK) >>
+                                        DRJIT_LLVM_TEX_TILE_LOG2;
+        size *= ndim == 1 ? tex->tiles[i]
+                          : (tex->tiles[i] << DRJIT_LLVM_TEX_TILE_LOG2);
+    }
+
+    if (size > 0xFFFFFFFFull) {
+        delete tex;
+        jitc_raise("jit_llvm_tex_create(): texture is too large!");
+    }
+
+    void *ptr = jitc_malloc(AllocType::Host, size * sizeof(float));
+    memset(ptr, 0, size * sizeof(float));
+    tex->data = jitc_var_mem_map(JitBackend::LLVM, VarType::Float32, ptr, size, 1);
+
+    jitc_log(LogLevel::Debug, "jitc_llvm_tex_create(): " DRJIT_PTR " (%s)",
+             (uintptr_t) tex,
+             std::string(jitc_mem_string(size * sizeof(float))).c_str());
+
+    return (void *) tex;
+}
+
+void jitc_llvm_tex_get_shape(size_t ndim, const void *texture_handle,
+                             size_t *shape) {
+    const DrJitLLVMTexture &tex = *((const DrJitLLVMTexture *) texture_handle);
+    if (ndim != tex.ndim)
+        jitc_raise("jit_llvm_tex_get_shape(): invalid texture dimension!");
+
+    for (size_t i = 0; i < ndim; ++i)
+        shape[i] = tex.shape[i];
+    shape[ndim] = tex.n_channels;
+}
+
+/// Copy between a dense array and the tiled texture storage
+static void jitc_llvm_tex_memcpy(const char *name, size_t ndim,
+                                 const size_t *shape,
+                                 const DrJitLLVMTexture &tex, float *dense,
+                                 bool to_texture) {
+    if (ndim != tex.ndim)
+        jitc_raise("%s(): invalid texture dimension!", name);
+    for (size_t i = 0; i < ndim; ++i) {
+        if (shape[i] != tex.shape[i])
+            jitc_raise("%s(): shape mismatch!", name);
+    }
+
+    // The source or target may be used by kernels that are still running
+    jitc_sync_thread(thread_state(JitBackend::LLVM));
+
+    float *data = (float *) jitc_var(tex.data)->data;
+    size_t nc = tex.n_channels, p[3] = { 0, 0, 0 },
+           width = shape[0],
+           height = ndim >= 2 ? shape[1] : 1,
+           depth = ndim == 3 ? shape[2] : 1;
+
+    for (p[2] = 0; p[2] < depth; ++p[2]) {
+        for (p[1] = 0; p[1] < height; ++p[1]) {
+            for (p[0] = 0; p[0] < width; ++p[0]) {
+                float *t = data + tex.offset(p) * nc,
+                      *d = dense + ((p[2] * height + p[1]) * width + p[0]) * nc;
+                if (to_texture)
+                    memcpy(t, d, nc * sizeof(float));
+                else
+                    memcpy(d, t, nc * sizeof(float));
+            }
+        }
+    }
+}
+
+void jitc_llvm_tex_memcpy_d2t(size_t ndim, const size_t *shape,
+                              const void *src_ptr, void *dst_texture_handle) {
+    jitc_llvm_tex_memcpy("jit_llvm_tex_memcpy_d2t", ndim, shape,
+                         *((DrJitLLVMTexture *) dst_texture_handle),
+                         (float *) src_ptr, true);
+}
+
+void jitc_llvm_tex_memcpy_t2d(size_t ndim, const size_t *shape,
+                              const void *src_texture_handle, void *dst_ptr) {
+    jitc_llvm_tex_memcpy("jit_llvm_tex_memcpy_t2d", ndim, shape,
+                         *((const DrJitLLVMTexture *) src_texture_handle),
+                         (float *) dst_ptr, false);
+}
+
+static void jitc_llvm_tex_check(const char *name, size_t ndim,
+                                const DrJitLLVMTexture &tex,
+                                const uint32_t *pos) {
+    if (ndim != tex.ndim)
+        jitc_raise("%s(): invalid texture dimension!", name);
+
+    for (size_t i = 0; i < ndim; ++i) {
+        const Variable *v = jitc_var(pos[i]);
+        if ((VarType) v->type != VarType::Float32)
+            jitc_raise("%s(): type mismatch for arg. %zu (got %s, expected %s)",
+                       name, i, type_name[v->type],
+                       type_name[(int) VarType::Float32]);
+        if ((JitBackend) v->backend != JitBackend::LLVM)
+            jitc_raise("%s(): arg. %zu is not an LLVM variable!", name, i);
+    }
+}
+
+/// Map an integer texel coordinate into the range [0, res) by wrapping
+static Ref jitc_llvm_tex_wrap(int wrap_mode, uint32_t i, uint32_t res) {
+    Ref r = jitc_llvm_tex_i32((int32_t) res),
+        zero = jitc_llvm_tex_i32(0),
+        m;
+
+    if (wrap_mode == 1) {
+        Ref r1 = jitc_llvm_tex_i32((int32_t) res - 1),
+            tmp = steal(jitc_var_max(i, zero));
+        m = steal(jitc_var_min(tmp, r1));
+    } else {
+        // Repeat with a period of 'res', or mirror with a period of '2*res'
+        Ref p = wrap_mode == 0 ? borrow(r)
+                               : jitc_llvm_tex_i32(2 * (int32_t) res),
+            rem = steal(jitc_var_mod(i, p)),
+            neg = steal(jitc_var_lt(rem, zero)),
+            rem_p = steal(jitc_var_add(rem, p));
+        m = steal(jitc_var_select(neg, rem_p, rem));
+
+        if (wrap_mode == 2) {
+            Ref p1 = jitc_llvm_tex_i32(2 * (int32_t) res - 1),
+                flip = steal(jitc_var_ge(m, r)),
+                m_flip = steal(jitc_var_sub(p1, m));
+            m = steal(jitc_var_select(flip, m_flip, m));
+        }
+    }
+
+    return steal(jitc_var_cast(m, VarType::UInt32, 1));
+}
+
+/**
+ * \brief Compute the texel coordinates and filter weights along dimension
+ * 'dim' of a lookup at the normalized position 'pos'. Returns the number of
+ * taps (1, 2, or 4 for nearest, linear, and cubic B-spline filtering).
+ */
+static uint32_t jitc_llvm_tex_taps(const DrJitLLVMTexture &tex, size_t dim,
+                                   uint32_t pos, int filter_mode, Ref *coord,
+                                   Ref *weight) {
+    uint32_t res = (uint32_t) tex.shape[dim];
+    Ref scale = jitc_llvm_tex_f32((float) res),
+        x = steal(jitc_var_mul(pos, scale));
+
+    if (filter_mode == 0) {
+        Ref xf = steal(jitc_var_floor(x)),
+            xi = steal(jitc_var_cast(xf, VarType::Int32, 0));
+        coord[0] = jitc_llvm_tex_wrap(tex.wrap_mode, xi, res);
+        return 1;
+    }
+
+    Ref half = jitc_llvm_tex_f32(.5f);
+    x = steal(jitc_var_sub(x, half));
+
+    Ref xf = steal(jitc_var_floor(x)),
+        f = steal(jitc_var_sub(x, xf)),
+        xi = steal(jitc_var_cast(xf, VarType::Int32, 0)),
+        one = jitc_llvm_tex_f32(1.f);
+
+    uint32_t n_taps = filter_mode == 1 ? 2 : 4;
+    int32_t first = filter_mode == 1 ? 0 : -1;
+
+    for (uint32_t j = 0; j < n_taps; ++j) {
+        Ref shift = jitc_llvm_tex_i32(first + (int32_t) j),
+            xj = steal(jitc_var_add(xi, shift));
+        coord[j] = jitc_llvm_tex_wrap(tex.wrap_mode, xj, res);
+    }
+
+    if (filter_mode == 1) {
+        weight[0] = steal(jitc_var_sub(one, f));
+        weight[1] = borrow(f);
+        return 2;
+    }
+
+    // Uniform cubic B-spline weights
+    Ref g = steal(jitc_var_sub(one, f)),
+        f2 = steal(jitc_var_mul(f, f)),
+        f3 = steal(jitc_var_mul(f2, f)),
+        g2 = steal(jitc_var_mul(g, g)),
+        g3 = steal(jitc_var_mul(g2, g)),
+        c6 = jitc_llvm_tex_f32(1.f / 6.f),
+        c2 = jitc_llvm_tex_f32(.5f),
+        c23 = jitc_llvm_tex_f32(2.f / 3.f),
+        m1 = jitc_llvm_tex_f32(-1.f);
+
+    // w1 = f^3 / 2 - f^2 + 2/3, w2 = 1 - w0 - w1 - w3
+    Ref t0 = steal(jitc_var_fma(f2, m1, c23));
+    weight[0] = steal(jitc_var_mul(g3, c6));
+    weight[1] = steal(jitc_var_fma(f3, c2, t0));
+    weight[3] = steal(jitc_var_mul(f3, c6));
+
+    Ref t1 = steal(jitc_var_add(weight[0], weight[1])),
+        t2 = steal(jitc_var_add(t1, weight[3]));
+    weight[2] = steal(jitc_var_sub(one, t2));
+
+    return 4;
+}
+
+/// Compute the index of channel 0 of the texel at the given coordinates
+static Ref jitc_llvm_tex_index(const DrJitLLVMTexture &tex, const uint32_t *p) {
+    Ref offset;
+
+    if (tex.ndim == 1) {
+        offset = borrow(p[0]);
+    } else {
+        Ref log2 = jitc_llvm_tex_u32(DRJIT_LLVM_TEX_TILE_LOG2),
+            mask = jitc_llvm_tex_u32(DRJIT_LLVM_TEX_TILE_MASK),
+            tile = jitc_llvm_tex_u32(0),
+            inner = jitc_llvm_tex_u32(0);
+
+        for (size_t i = tex.ndim; i-- > 0; ) {
+            Ref n_tiles = jitc_llvm_tex_u32((uint32_t) tex.tiles[i]),
+                t0 = steal(jitc_var_shr(p[i], log2)),
+                t1 = steal(jitc_var_mul(tile, n_tiles)),
+                t2 = steal(jitc_var_and(p[i], mask)),
+                t3 = steal(jitc_var_shl(inner, log2));
+            tile = steal(jitc_var_add(t1, t0));
+            inner = steal(jitc_var_or(t3, t2));
+        }
+
+        Ref shift = jitc_llvm_tex_u32(DRJIT_LLVM_TEX_TILE_LOG2 * (uint32_t) tex.ndim),
+            t0 = steal(jitc_var_shl(tile, shift));
+        offset = steal(jitc_var_or(t0, inner));
+    }
+
+    Ref nc = jitc_llvm_tex_u32((uint32_t) tex.n_channels);
+    return steal(jitc_var_mul(offset, nc));
+}
+
+/// Gather all channels of the texel at the given coordinates
+static void jitc_llvm_tex_fetch(const DrJitLLVMTexture &tex, const uint32_t *p,
+                                Ref *out) {
+    bool value = true;
+    Ref mask = steal(jitc_var_literal(JitBackend::LLVM, VarType::Bool, &value, 1, 0)),
+        index = jitc_llvm_tex_index(tex, p);
+
+    for (size_t ch = 0; ch < tex.n_channels; ++ch) {
+        Ref offset = jitc_llvm_tex_u32((uint32_t) ch),
+            index_ch = steal(jitc_var_add(index, offset));
+        out[ch] = steal(jitc_var_gather(tex.data, index_ch, mask));
+    }
+}
+
+void jitc_llvm_tex_lookup(size_t ndim, const void *texture_handle,
+                          const uint32_t *pos, uint32_t *out) {
+    const DrJitLLVMTexture &tex = *((const DrJitLLVMTexture *) texture_handle);
+    jitc_llvm_tex_check("jit_llvm_tex_lookup", ndim, tex, pos);
+
+    Ref coord[3][4], weight[3][4];
+    uint32_t n_taps = 0;
+    for (size_t i = 0; i < ndim; ++i)
+        n_taps = jitc_llvm_tex_taps(tex, i, pos[i], tex.filter_mode, coord[i],
+                                    weight[i]);
+
+    uint32_t n_combinations = 1;
+    for (size_t i = 0; i < ndim; ++i)
+        n_combinations *= n_taps;
+
+    std::vector<Ref> accum(tex.n_channels), values(tex.n_channels);
+
+    for (uint32_t k = 0; k < n_combinations; ++k) {
+        uint32_t p[3] = { 0, 0, 0 };
+        Ref w;
+
+        for (uint32_t i = 0, k2 = k; i < ndim; ++i, k2 /= n_taps) {
+            uint32_t tap = k2 % n_taps;
+            p[i] = coord[i][tap];
+            if (n_taps > 1)
+                w = w ? steal(jitc_var_mul(w, weight[i][tap]))
+                      : borrow(weight[i][tap]);
+        }
+
+        jitc_llvm_tex_fetch(tex, p, values.data());
+
+        for (size_t ch = 0; ch < tex.n_channels; ++ch) {
+            if (!w)
+                accum[ch] = std::move(values[ch]);
+            else if (!accum[ch])
+                accum[ch] = steal(jitc_var_mul(values[ch], w));
+            else
+                accum[ch] = steal(jitc_var_fma(values[ch], w, accum[ch]));
+        }
+    }
+
+    for (size_t ch = 0; ch < tex.n_channels; ++ch)
+        out[ch] = accum[ch].release();
+}
+
+void jitc_llvm_tex_bilerp_fetch(size_t ndim, const void *texture_handle,
+                                const uint32_t *pos, uint32_t *out) {
+    if (ndim != 2)
+        jitc_raise("jitc_llvm_tex_bilerp_fetch(): only 2D textures are supported!");
+
+    const DrJitLLVMTexture &tex = *((const DrJitLLVMTexture *) texture_handle);
+    jitc_llvm_tex_check("jit_llvm_tex_bilerp_fetch", ndim, tex, pos);
+
+    Ref coord[2][4], weight[2][4];
+    for (size_t i = 0; i < 2; ++i)
+        jitc_llvm_tex_taps(tex, i, pos[i], 1, coord[i], weight[i]);
+
+    // Same order as CUDA's tld4: (0, 1), (1, 1), (1, 0), (0, 0)
+    const uint32_t order[4][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+    std::vector<Ref> values[4];
+
+    for (uint32_t j = 0; j < 4; ++j) {
+        uint32_t p[2] = { coord[0][order[j][0]], coord[1][order[j][1]] };
+        values[j].resize(tex.n_channels);
+        jitc_llvm_tex_fetch(tex, p, values[j].data());
+    }
+
+    for (size_t ch = 0; ch < tex.n_channels; ++ch) {
+        for (uint32_t j = 0; j < 4; ++j)
+            *out++ = values[j][ch].release();
+    }
+}
+
+void jitc_llvm_tex_destroy(void *texture_handle) {
+    if (!texture_handle)
+        return;
+
+    jitc_log(LogLevel::Debug, "jitc_llvm_tex_destroy(" DRJIT_PTR ")",
+             (uintptr_t) texture_handle);
+
+    // Kernels that are still queued hold their own reference to the storage
+    DrJitLLVMTexture *tex = (DrJitLLVMTexture *) texture_handle;
+    jitc_var_dec_ref(tex->data);
+    delete tex;
+}
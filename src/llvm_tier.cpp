@@ -0,0 +1,191 @@
+/*
+    src/llvm_tier.cpp -- Tiered compilation of LLVM kernels
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "llvm.h"
+#include "internal.h"
+#include "log.h"
+#include "io.h"
+#include <stdexcept>
+
+/// Number of launches after which a kernel is recompiled with LLVMTier::Optimized
+static const uint32_t jitc_llvm_tier_up_launches = 128;
+
+struct TierUpPayload {
+    char *source;
+    size_t source_size;
+    XXH128_hash_t hash;
+    std::vector<std::string> names;
+
+    /// Set (while holding 'state.lock') once the task no longer needs the lock
+    bool done = false;
+
+    ~TierUpPayload() { free(source); }
+};
+
+struct TierUpTask {
+    Task *task;
+    TierUpPayload *payload;
+};
+
+struct RetiredKernel {
+    Kernel kernel;
+
+    /// Value of 'jitc_llvm_tier_evals' when the kernel was superseded
+    uint32_t evals;
+};
+
+/// Recompilations that were started by jitc_llvm_tier_up()
+static std::vector<TierUpTask> jitc_llvm_tier_tasks;
+
+/// Superseded kernels that might still be running
+static std::vector<RetiredKernel> jitc_llvm_tier_retired;
+
+/// Number of finished LLVM evaluations (see jitc_llvm_tier_release())
+static uint32_t jitc_llvm_tier_evals = 0;
+
+LLVMTier jitc_llvm_tier_initial() {
+    // Background compilation requires independent compiler instances
+    if (jit_flag(JitFlag::TieredCompile) && jitc_llvm_compile_is_concurrent())
+        return LLVMTier::Fast;
+    return LLVMTier::Default;
+}
+
+bool jitc_llvm_tier_count(Kernel &kernel) {
+    if (kernel.llvm.tier != (uint32_t) LLVMTier::Fast || kernel.pins)
+        return false;
+    return ++kernel.llvm.launches >= jitc_llvm_tier_up_launches;
+}
+
+static void jitc_llvm_tier_run(uint32_t, void *ptr) {
+    TierUpPayload *p = (TierUpPayload *) ptr;
+    Kernel kernel;
+    memset(&kernel, 0, sizeof(Kernel));
+
+    bool success = true;
+    try {
+        jitc_llvm_compile_ir(p->source, p->source_size, p->names, kernel,
+                             LLVMTier::Optimized);
+    } catch (const std::exception &e) {
+        jitc_log(Warn, "jit_llvm_tier_up(): %s", e.what());
+        success = false;
+    }
+
+    lock_guard guard(state.lock);
+    p->done = true;
+
+    KernelKey key(p->source, p->source_size, p->hash, -1, 0);
+    auto it = state.kernel_cache.find(
+        key, KernelHash::compute_hash(p->hash.high64, -1, 0));
+
+    // The kernel may have been evicted in the meantime
+    if (it == state.kernel_cache.end() ||
+        it.value().llvm.tier != (uint32_t) LLVMTier::Compiling) {
+        if (success)
+            jitc_kernel_free(-1, kernel);
+        return;
+    }
+
+    Kernel &old = it.value();
+    if (!success) {
+        old.llvm.tier = (uint32_t) LLVMTier::Default;
+        return;
+    }
+
+    kernel.pins = old.pins;
+    kernel.last_use = old.last_use;
+    state.kernel_cache_size += kernel.size;
+    state.kernel_cache_size -= old.size;
+    jitc_llvm_tier_retired.push_back({ old, jitc_llvm_tier_evals });
+    old = kernel;
+
+    jitc_kernel_write(p->source, (uint32_t) p->source_size, JitBackend::LLVM,
+                      p->hash, kernel);
+    jitc_llvm_write_versions(p->source, p->source_size, p->hash, p->names,
+                             LLVMTier::Optimized);
+
+    jitc_log(Debug, "jit_llvm_tier_up(): replaced kernel %016llx by its "
+             "optimized version (%s).", (unsigned long long) p->hash.high64,
+             std::string(jitc_mem_string(kernel.size)).c_str());
+}
+
+void jitc_llvm_tier_up(const KernelKey &key, Kernel &kernel,
+                       const std::vector<std::string> &names) {
+    kernel.llvm.tier = (uint32_t) LLVMTier::Compiling;
+
+    TierUpPayload *p = new TierUpPayload();
+    p->source = (char *) malloc_check(key.size + 1);
+    memcpy(p->source, key.str, key.size + 1);
+    p->source_size = key.size;
+    p->hash = key.hash;
+    p->names = names;
+
+    jitc_log(Debug, "jit_llvm_tier_up(): recompiling kernel %016llx after "
+             "%u launches ..", (unsigned long long) key.hash.high64,
+             kernel.llvm.launches);
+
+    /* Prune finished recompilations. Their tasks have released 'state.lock'
+       and are about to return, hence waiting for them is cheap. */
+    size_t n = 0;
+    for (const TierUpTask &t : jitc_llvm_tier_tasks) {
+        if (t.payload->done) {
+            task_wait_and_release(t.task);
+            delete t.payload;
+        } else {
+            jitc_llvm_tier_tasks[n++] = t;
+        }
+    }
+    jitc_llvm_tier_tasks.resize(n);
+
+    jitc_llvm_tier_tasks.push_back(
+        { task_submit_dep(nullptr, nullptr, 0, 1, jitc_llvm_tier_run, p), p });
+}
+
+void jitc_llvm_tier_eval_done() {
+    jitc_llvm_tier_evals++;
+}
+
+uint32_t jitc_llvm_tier_evals_done() {
+    return jitc_llvm_tier_evals;
+}
+
+void jitc_llvm_tier_release(uint32_t evals) {
+    /* Launches of a superseded kernel were submitted by evaluations that
+       started before it was retired. Evaluations are serialized, so they have
+       all finished once the counter has advanced past the value recorded at
+       retirement, and the caller waited for all work submitted until then. */
+    size_t n = 0;
+    for (const RetiredKernel &r : jitc_llvm_tier_retired) {
+        if ((int32_t) (evals - r.evals) > 0)
+            jitc_kernel_free(-1, r.kernel);
+        else
+            jitc_llvm_tier_retired[n++] = r;
+    }
+    jitc_llvm_tier_retired.resize(n);
+}
+
+void jitc_llvm_tier_shutdown() {
+    // Finished recompilations may have started further ones in the meantime
+    while (!jitc_llvm_tier_tasks.empty()) {
+        std::vector<TierUpTask> tasks;
+        tasks.swap(jitc_llvm_tier_tasks);
+
+        /* Unlock while synchronizing */ {
+            unlock_guard guard(state.lock);
+            for (const TierUpTask &t : tasks)
+                task_wait_and_release(t.task);
+        }
+
+        for (const TierUpTask &t : tasks)
+            delete t.payload;
+    }
+
+    for (const RetiredKernel &r : jitc_llvm_tier_retired)
+        jitc_kernel_free(-1, r.kernel);
+    jitc_llvm_tier_retired.clear();
+}
@@ -4,7 +4,8 @@
 #include "eval.h"
 #include "op.h"
 #include "profiler.h"
-#include <tsl/robin_set.h>
+#include "traverse.h"
+#include "optimize.h"
 
 struct Loop {
     // A descriptive name
@@ -13,8 +14,8 @@ struct Loop {
     JitBackend backend;
     // Variable index of loop initialization node
     uint32_t init = 0;
-    // Variable index of loop end node
-    uint32_t end = 0;
+    // Variable index of loop end node (not referenced, may expire)
+    WeakRef end;
     /// Variable index of loop condition
     uint32_t cond = 0;
     /// Variable index of side effect placeholder
@@ -35,6 +36,8 @@ struct Loop {
     std::vector<uint32_t> out;
     /// Are there unused loop variables that could be stripped away?
     bool simplify = false;
+    /// Number of iterations per branch back to the loop condition
+    uint32_t unroll = 1;
 
     ~Loop() {
         free(name);
@@ -43,6 +46,9 @@ struct Loop {
 
 static std::vector<Loop *> loops;
 
+/// Upper bound of the unroll factor passed to jit_var_loop()
+static const uint32_t loop_unroll_max = 16;
+
 // Forward declarations
 static void jitc_var_loop_callback(uint32_t index, int free, void *ptr);
 static void jitc_var_loop_assemble_init(const Variable *v, const Extra &extra);
@@ -66,15 +72,15 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
 
     // Determine the variable size
     JitBackend backend = (JitBackend) jitc_var(*indices[0])->backend;
-    uint32_t size = 0;
+    size_t size = 0;
     bool dirty = false;
 
     for (size_t i = 0; i < n_indices; ++i) {
         const Variable *v = jitc_var(*indices[i]);
-        uint32_t vsize = v->size;
+        size_t vsize = v->size;
         if (size != 0 && vsize != 1 && size != 1 && vsize != size)
             jitc_raise("jit_var_loop_init(): loop state variables have an "
-                       "inconsistent size (%u vs %u)!", vsize, size);
+                       "inconsistent size (%zu vs %zu)!", vsize, size);
         if (vsize > size)
             size = vsize;
 
@@ -93,7 +99,6 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
     }
 
     Variable v;
-    v.kind = (uint32_t) VarKind::Stmt;
     v.size = size;
     v.placeholder = 1;
     v.backend = (uint32_t) backend;
@@ -101,7 +106,7 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
     // Copy loop state before entering loop (CUDA)
     if (backend == JitBackend::CUDA) {
         jitc_new_scope(backend);
-        v.stmt = (char *) "mov.$t0 $r0, $r1";
+        v.kind = (uint32_t) VarKind::Copy;
         for (size_t i = 0; i < n_indices; ++i)
             wrap(v, *indices[i]);
     }
@@ -109,15 +114,15 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
     jitc_new_scope(backend);
 
     // Create a special node indicating the loop start
-    Ref result = steal(jitc_var_stmt(backend, VarType::Void, "", 1, 0, nullptr));
-    jitc_var(result)->size = size;
+    Ref result = steal(jitc_var_new_node_0(backend, VarKind::Nop, VarType::Void,
+                                           size, false));
 
     jitc_new_scope(backend);
 
     // Create Phi nodes (LLVM)
     if (backend == JitBackend::LLVM) {
-        v.stmt = (char *) "$r0 = phi <$w x $t0> [ $r0_final, %l_$i2_tail ], "
-                           "[ $r1, %l_$i2_start ]";
+        v.kind = (uint32_t) VarKind::LoopPhi;
+        v.literal = (uint64_t) LoopPhiType::Header;
         for (size_t i = 0; i < n_indices; ++i)
             wrap(v, *indices[i], result);
 
@@ -125,7 +130,7 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
     }
 
 
-    jitc_log(Debug, "jit_var_loop_init(r%u, n_indices=%zu, size=%u)",
+    jitc_log(Debug, "jit_var_loop_init(r%u, n_indices=%zu, size=%zu)",
              (uint32_t) result, n_indices, size);
 
     return result.release();
@@ -133,7 +138,7 @@ uint32_t jitc_var_loop_init(size_t n_indices, uint32_t **indices) {
 
 uint32_t jitc_var_loop_cond(uint32_t loop_init, uint32_t cond,
                             size_t n_indices, uint32_t **indices) {
-    uint32_t size;
+    size_t size;
     JitBackend backend;
     {
         Variable *v = jitc_var(loop_init);
@@ -141,25 +146,35 @@ uint32_t jitc_var_loop_cond(uint32_t loop_init, uint32_t cond,
         backend = (JitBackend) v->backend;
     }
 
-    jitc_new_scope(backend);
+    if (unlikely(cond == 0))
+        jitc_raise("jit_var_loop_cond(): the loop condition is uninitialized!");
 
-    uint32_t dep[2] = { cond, loop_init };
+    jitc_new_scope(backend);
 
-    Ref result =
-        steal(jitc_var_stmt(backend, VarType::Void, "", 1, 2, dep));
+    Ref result;
+    {
+        Variable *v_cond = jitc_var(cond), *v_init = jitc_var(loop_init);
+        result = steal(jitc_var_new_node_2(
+            backend, VarKind::Nop, VarType::Void,
+            std::max(v_cond->size, v_init->size),
+            v_cond->placeholder || v_init->placeholder, cond, v_cond,
+            loop_init, v_init));
+    }
 
     jitc_new_scope(backend);
 
     Variable v;
-    v.kind = (uint32_t) VarKind::Stmt;
     v.size = size;
     v.placeholder = 1;
     v.backend = (uint32_t) backend;
 
     // Create Phi nodes to represent state at the beginning of the loop body
-    v.stmt = (char *) (backend == JitBackend::LLVM
-                 ? "$r0 = phi <$w x $t0> [ $r1, %l_$i2_cond ]"
-                 : "mov.$t0 $r0, $r1");
+    if (backend == JitBackend::LLVM) {
+        v.kind = (uint32_t) VarKind::LoopPhi;
+        v.literal = (uint64_t) LoopPhiType::Body;
+    } else {
+        v.kind = (uint32_t) VarKind::Copy;
+    }
 
     for (size_t i = 0; i < n_indices; ++i)
         wrap(v, *indices[i], loop_init);
@@ -175,7 +190,8 @@ uint32_t jitc_var_loop_cond(uint32_t loop_init, uint32_t cond,
 uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
                        uint32_t loop_cond, size_t n_indices,
                        uint32_t *indices_in, uint32_t **indices,
-                       uint32_t checkpoint, int first_round) {
+                       uint32_t checkpoint, int first_round,
+                       uint32_t unroll) {
     if (n_indices == 0)
         jitc_raise("jit_var_loop(): no loop state variables specified!");
 
@@ -199,6 +215,7 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
     loop->out_body.reserve(n_indices);
     loop->out.reserve(n_indices);
     loop->name = strdup(name);
+    loop->unroll = std::max(1u, std::min(unroll, loop_unroll_max));
     loop->se_count = (uint32_t) se.size() - checkpoint;
     loop->init = loop_init;
     loop->cond = jitc_var(loop_cond)->dep[0];
@@ -208,7 +225,8 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
     // =====================================================
 
     bool placeholder = false;
-    uint32_t size = 1, n_invariant = 0;
+    size_t size = 1;
+    uint32_t n_invariant = 0;
     {
         const Variable *v = jitc_var(loop->cond);
         if ((VarType) v->type != VarType::Bool)
@@ -262,14 +280,14 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
 
         if (size != v1->size && size != 1 && v1->size != 1)
             jitc_raise("jit_var_loop(): initial shape of loop state variable %zu (r%u) "
-                       "is incompatible with the loop (%u vs %u entries)!",
+                       "is incompatible with the loop (%zu vs %zu entries)!",
                        i, index_1, size, v1->size);
 
         size = std::max(size, v1->size);
 
         if (size != vo->size && size != 1 && vo->size != 1)
             jitc_raise("jit_var_loop(): final shape of loop state variable %zu (r%u) "
-                       "is incompatible with the loop (%u vs %u entries)!",
+                       "is incompatible with the loop (%zu vs %zu entries)!",
                        i, index_o, size, vo->size);
         size = std::max(size, vo->size);
 
@@ -285,8 +303,7 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
                     // Rewrite the previously generated phi expression. Needed
                     // in case the loop condition depends on a loop-invariant
                     // variable (see loop test 09_optim_cond)
-                    v2->stmt = (char *) "$r0 = phi <$w x $t0> [ $r0, "
-                                         "%l_$i2_tail ], [ $r1, %l_$i2_start ]";
+                    v2->literal = (uint64_t) LoopPhiType::HeaderInvariant;
                 }
                 jitc_var_inc_ref(index_3);
                 jitc_var_dec_ref(index_1);
@@ -308,7 +325,7 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
 
     jitc_log(InfoSym,
              "jit_var_loop(loop_init=r%u, loop_cond=r%u): loop (\"%s\") with "
-             "%zu loop variable%s, %u side effect%s, %u elements%s%s",
+             "%zu loop variable%s, %u side effect%s, %zu elements%s%s",
              loop_init, loop_cond, name, n_indices, n_indices == 1 ? "" : "s",
              loop->se_count, loop->se_count == 1 ? "" : "s", size, temp,
              placeholder ? " (part of a recorded computation)" : "");
@@ -379,10 +396,16 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
 
     jitc_new_scope(backend);
 
-    uint32_t loop_end_dep[2] = { loop_init, loop_cond };
-    Ref loop_end = steal(
-        jitc_var_stmt(backend, VarType::Void, "", 1, 2, loop_end_dep));
-    loop->end = loop_end;
+    Ref loop_end;
+    {
+        Variable *v_init = jitc_var(loop_init), *v_cond = jitc_var(loop_cond);
+        loop_end = steal(jitc_var_new_node_2(
+            backend, VarKind::Nop, VarType::Void,
+            std::max(v_init->size, v_cond->size),
+            v_init->placeholder || v_cond->placeholder, loop_init, v_init,
+            loop_cond, v_cond));
+    }
+    loop->end = jitc_var_weak(loop_end);
 
     jitc_new_scope(backend);
 
@@ -440,15 +463,13 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
         }
         se.resize(checkpoint);
 
-        uint32_t loop_se_dep[1] = { loop_end };
-        loop_se = steal(
-            jitc_var_stmt(backend, VarType::Void, "", 1, 1, loop_se_dep));
+        loop_se = steal(jitc_var_new_node_1(backend, VarKind::Nop,
+                                            VarType::Void, size, placeholder,
+                                            loop_end, jitc_var(loop_end)));
 
         // Set a label and custom code generation hook
         Variable *v = jitc_var(loop_se);
         v->extra = 1;
-        v->size = size;
-        v->placeholder = placeholder;
         Extra &e = state.extra[loop_se];
         e.n_dep = loop->se_count;
         e.dep = dep;
@@ -464,11 +485,7 @@ uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
 
     {
         Variable v2;
-        v2.kind = (uint32_t) VarKind::Stmt;
-        if (backend == JitBackend::CUDA)
-            v2.stmt = (char *) "mov.$t0 $r0, $r1";
-        else
-            v2.stmt = (char *) "$r0 = bitcast <$w x $t1> $r1 to <$w x $t0>";
+        v2.kind = (uint32_t) VarKind::Copy;
         v2.size = size;
         v2.placeholder = placeholder;
         v2.backend = (uint32_t) backend;
@@ -564,57 +581,39 @@ static void jitc_var_loop_callback(uint32_t index, int free, void *ptr) {
     loop->simplify = true;
 }
 
-static void jitc_var_loop_dfs(tsl::robin_set<uint32_t, UInt32Hasher> &set, uint32_t lowest_index, uint32_t index) {
-    if (!set.insert(index).second)
-        return;
-    // jitc_trace("jitc_var_dfs(r%u)", index);
-
-    const Variable *v = jitc_var(index);
-    for (uint32_t i = 0; i < 4; ++i) {
-        uint32_t index_2 = v->dep[i];
-        if (index_2 >= lowest_index)
-            jitc_var_loop_dfs(set, lowest_index, index_2);
-    }
-
-    if (unlikely(v->extra)) {
-        auto it = state.extra.find(index);
-        if (unlikely(it == state.extra.end()))
-            jitc_fail("jit_var_loop_dfs(): could not find matching 'extra' record!");
-
-        const Extra &extra = it->second;
-        for (uint32_t i = 0; i < extra.n_dep; ++i) {
-            uint32_t index_2 = extra.dep[i];
-            if (index_2 >= lowest_index)
-                jitc_var_loop_dfs(set, lowest_index, index_2);
-        }
-    }
+/// Explicit stack used by jitc_var_loop_dfs()
+static std::vector<DFSFrame> loop_dfs_stack;
+
+/* Variables created before the loop cannot depend on loop variables. Indices
+   are recycled, hence this uses the creation counter to skip them. */
+static void jitc_var_loop_dfs(VisitedSet &set, uint32_t lowest_counter, uint32_t index) {
+    jitc_var_dfs(
+        index, set, loop_dfs_stack,
+        [lowest_counter](uint32_t index_2) {
+            return jitc_var(index_2)->counter >= lowest_counter;
+        },
+        [](uint32_t, const Variable *) { });
 }
 
-static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32Hasher> &visited) {
+static size_t jitc_var_loop_simplify(Loop *loop, VisitedSet &visited) {
     loop->simplify = false;
 
-    if (state.variables.find(loop->end) == state.variables.end())
+    if (!jitc_var(loop->end))
         return 0;
 
     const uint32_t n = (uint32_t) loop->in.size();
 
     /// Determine variable range to be traversed
-    uint32_t lowest_index = 0xFFFFFFFF,
-             highest_index = 0,
+    uint32_t lowest_counter = 0xFFFFFFFF,
              n_freed = 0;
 
     for (uint32_t i = 0; i < n; ++i) {
         uint32_t index = loop->in_cond[i];
         if (index)
-            lowest_index = std::min(lowest_index, index);
-        index = loop->out_body[i];
-        if (index)
-            highest_index = std::max(highest_index, index);
+            lowest_counter = std::min(lowest_counter, jitc_var(index)->counter);
     }
 
     visited.clear();
-    if (highest_index > lowest_index)
-        visited.reserve(highest_index - lowest_index);
 
     // Find all inputs that are reachable from the outputs that are still alive
     for (uint32_t i = 0; i < n; ++i) {
@@ -622,12 +621,12 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
             continue;
         // jitc_trace("jit_var_loop_simplify(): DFS from %u (r%u)", i, loop->out_body[i]);
         visited.insert(loop->in_cond[i]);
-        jitc_var_loop_dfs(visited, lowest_index, loop->out_body[i]);
+        jitc_var_loop_dfs(visited, lowest_counter, loop->out_body[i]);
     }
 
     // Also search from loop condition
     // jitc_trace("jit_var_loop_simplify(): DFS from loop condition (r%u)", loop->cond);
-    jitc_var_loop_dfs(visited, lowest_index, loop->cond);
+    jitc_var_loop_dfs(visited, lowest_counter, loop->cond);
 
     // Find all inputs that are reachable from the side effects
     if (loop->se) {
@@ -636,7 +635,7 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
             const Extra &e = it->second;
             for (uint32_t i = 0; i < e.n_dep; ++i) {
                 // jitc_trace("jit_var_loop_simplify(): DFS from side effect %u (r%u)", i, e.dep[i]);
-                jitc_var_loop_dfs(visited, lowest_index, e.dep[i]);
+                jitc_var_loop_dfs(visited, lowest_counter, e.dep[i]);
             }
         }
     }
@@ -647,9 +646,9 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
         again = false;
         for (uint32_t i = 0; i < n; ++i) {
             if (loop->in_cond[i] &&
-                visited.find(loop->in_cond[i]) != visited.end() &&
-                visited.find(loop->out_body[i]) == visited.end()) {
-                jitc_var_loop_dfs(visited, lowest_index, loop->out_body[i]);
+                visited.contains(loop->in_cond[i]) &&
+                !visited.contains(loop->out_body[i])) {
+                jitc_var_loop_dfs(visited, lowest_counter, loop->out_body[i]);
                 again = true;
             }
         }
@@ -658,7 +657,7 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
     /// Remove loop variables that are never referenced
     for (uint32_t i = 0; i < n; ++i) {
         uint32_t index = loop->in_cond[i];
-        if (index == 0 || visited.find(index) != visited.end())
+        if (index == 0 || visited.contains(index))
             continue;
         n_freed++;
 
@@ -666,7 +665,7 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
                    "variable %u (r%u -> r%u -> r%u)", i, loop->in[i],
                    loop->in_cond[i], loop->in_body[i]);
 
-        Extra &e_end = state.extra[loop->end];
+        Extra &e_end = state.extra[loop->end.index];
         if (unlikely(e_end.dep[n + i] != loop->in_cond[i]))
             jitc_fail("jit_var_loop_simplify: internal error (3)");
         if (unlikely(e_end.dep[i] != loop->out_body[i]))
@@ -690,7 +689,7 @@ static size_t jitc_var_loop_simplify(Loop *loop, tsl::robin_set<uint32_t, UInt32
 static ProfilerRegion profiler_region_var_loop_simplify("jit_var_loop_simplify");
 
 void jitc_var_loop_simplify() {
-    tsl::robin_set<uint32_t, UInt32Hasher> visited;
+    VisitedSet visited;
 
     ProfilerPhase profiler(profiler_region_var_loop_simplify);
     bool progress;
@@ -706,7 +705,7 @@ void jitc_var_loop_simplify() {
 
 static void jitc_var_loop_assemble_init(const Variable *, const Extra &extra) {
     Loop *loop = (Loop *) extra.callback_data;
-    uint32_t loop_reg = jitc_var(loop->init)->reg_index;
+    uint32_t loop_reg = jitc_var_scratch(jitc_var(loop->init))->reg_index;
 
     if (loop->backend == JitBackend::LLVM) {
         buffer.fmt("    br label %%l_%u_start\n", loop_reg);
@@ -721,8 +720,8 @@ static void jitc_var_loop_assemble_init(const Variable *, const Extra &extra) {
 
 static void jitc_var_loop_assemble_cond(const Variable *, const Extra &extra) {
     Loop *loop = (Loop *) extra.callback_data;
-    uint32_t loop_reg = jitc_var(loop->init)->reg_index,
-             mask_reg = jitc_var(loop->cond)->reg_index,
+    uint32_t loop_reg = jitc_var_scratch(jitc_var(loop->init))->reg_index,
+             mask_reg = jitc_var_scratch(jitc_var(loop->cond))->reg_index,
              width = jitc_llvm_vector_width;
 
     if (loop->backend == JitBackend::CUDA) {
@@ -743,10 +742,77 @@ static void jitc_var_loop_assemble_cond(const Variable *, const Extra &extra) {
     buffer.fmt("\nl_%u_body:\n", loop_reg);
 }
 
+/**
+ * \brief Replicate the PTX code of the loop iteration that was just generated
+ *
+ * This covers the code from the loop condition up to the copy of the loop
+ * state at the end of the body, which is appended another 'factor - 1' times.
+ * Every copy re-evaluates the condition and branches to the end of the loop,
+ * so threads that finish early simply leave and there is no remainder loop.
+ * Labels defined within the iteration (nested loops, calls) receive a unique
+ * suffix per copy.
+ */
+static void jitc_var_loop_unroll_cuda(uint32_t loop_reg, uint32_t factor) {
+    char label[32];
+    snprintf(label, sizeof(label), "\nl_%u_cond:", loop_reg);
+
+    // Find the most recent definition (callables may reuse register indices)
+    const char *start = nullptr;
+    for (const char *s = buffer.get(); (s = strstr(s, label)); s++)
+        start = s;
+    if (!start || !(start = strchr(start + 1, '\n')))
+        jitc_fail("jit_var_loop_unroll_cuda(): loop label not found!");
+
+    std::string body(start + 1, buffer.get() + buffer.size());
+
+    auto is_ident = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_' || c == '$';
+    };
+
+    // Collect the labels defined by this iteration
+    std::vector<std::string> labels;
+    for (const char *s = body.c_str(); *s; ) {
+        while (*s == ' ')
+            s++;
+        const char *t = s;
+        while (is_ident(*t))
+            t++;
+        if (t != s && *t == ':')
+            labels.emplace_back(s, t - s);
+        s = strchr(t, '\n');
+        if (!s)
+            break;
+        s++;
+    }
+
+    for (uint32_t k = 1; k < factor; ++k) {
+        for (const char *s = body.c_str(); *s; ) {
+            if (!is_ident(*s)) {
+                buffer.put(*s++);
+                continue;
+            }
+
+            const char *t = s;
+            while (is_ident(*t))
+                t++;
+            buffer.put(s, t - s);
+
+            for (const std::string &l : labels) {
+                if (l.size() == (size_t) (t - s) && strncmp(l.c_str(), s, t - s) == 0) {
+                    buffer.fmt("_u%u", k);
+                    break;
+                }
+            }
+            s = t;
+        }
+    }
+}
+
 static void jitc_var_loop_assemble_end(const Variable *, const Extra &extra) {
     Loop *loop = (Loop *) extra.callback_data;
-    uint32_t loop_reg = jitc_var(loop->init)->reg_index,
-             mask_reg = jitc_var(loop->cond)->reg_index;
+    uint32_t loop_reg = jitc_var_scratch(jitc_var(loop->init))->reg_index,
+             mask_reg = jitc_var_scratch(jitc_var(loop->cond))->reg_index;
 
     if (loop->backend == JitBackend::LLVM)
         buffer.fmt("    br label %%l_%u_tail\n"
@@ -757,39 +823,54 @@ static void jitc_var_loop_assemble_end(const Variable *, const Extra &extra) {
 
     uint32_t width = jitc_llvm_vector_width;
     for (size_t i = 0; i < loop->in_body.size(); ++i) {
-        auto it_in = state.variables.find(loop->in_cond[i]),
-             it_out = state.variables.find(loop->out_body[i]);
+        const Variable *v_in = jitc_var_maybe(loop->in_cond[i]),
+                       *v_out = jitc_var_maybe(loop->out_body[i]);
 
-        if (it_in == state.variables.end())
+        if (!v_in)
             continue;
-        else if (it_out == state.variables.end())
+        else if (!v_out)
             jitc_fail("jit_var_loop_assemble_end(): internal error!");
 
-        const Variable *v_in = &it_in->second,
-                       *v_out = &it_out->second;
-        uint32_t vti = it_in->second.type;
+        uint32_t vti = v_in->type,
+                 reg_in = jitc_var_scratch(v_in)->reg_index,
+                 reg_out = jitc_var_scratch(v_out)->reg_index;
 
         if (loop->backend == JitBackend::LLVM) {
             buffer.fmt("    %s%u_final = select <%u x i1> %%p%u, <%u x %s> %s%u, "
                        "<%u x %s> %s%u\n",
-                       type_prefix[vti], v_in->reg_index, width, mask_reg, width,
-                       type_name_llvm[vti], type_prefix[vti], v_out->reg_index,
-                       width, type_name_llvm[vti], type_prefix[vti],
-                       v_in->reg_index);
+                       type_prefix[vti], reg_in, width, mask_reg, width,
+                       type_name_llvm[vti], type_prefix[vti], reg_out,
+                       width, type_name_llvm[vti], type_prefix[vti], reg_in);
         } else {
             buffer.fmt("    mov.%s %s%u, %s%u;\n", type_name_ptx[vti],
-                       type_prefix[vti], v_in->reg_index, type_prefix[vti],
-                       v_out->reg_index);
+                       type_prefix[vti], reg_in, type_prefix[vti], reg_out);
         }
 
         n_variables++;
         storage_size += type_size[vti];
     }
 
-    if (loop->backend == JitBackend::CUDA)
+    if (loop->backend == JitBackend::CUDA) {
+        if (loop->unroll > 1)
+            jitc_var_loop_unroll_cuda(loop_reg, loop->unroll);
         buffer.fmt("    bra l_%u_cond;\n", loop_reg);
-    else
+    } else if (loop->unroll > 1) {
+        /* Leave the unrolling to LLVM, which keeps the exit test of every
+           copy since the trip count isn't known. The metadata ID must be
+           unique per loop, and identical for loops that share it. */
+        uint32_t md = 5 + 2 * (loop_reg * loop_unroll_max + loop->unroll - 1);
+
+        char global[128];
+        snprintf(global, sizeof(global),
+                 "!%u = distinct !{!%u, !%u}\n"
+                 "!%u = !{!\"llvm.loop.unroll.count\", i32 %u}",
+                 md, md, md + 1, md + 1, loop->unroll);
+        jitc_register_global(global);
+
+        buffer.fmt("    br label %%l_%u_cond, !llvm.loop !%u\n", loop_reg, md);
+    } else {
         buffer.fmt("    br label %%l_%u_cond;\n", loop_reg);
+    }
 
     buffer.fmt("\nl_%u_done:\n", loop_reg);
 
@@ -806,3 +887,101 @@ static void jitc_var_loop_assemble_end(const Variable *, const Extra &extra) {
         loop->simplify = true;
     }
 }
+
+/// Scopes of the init and end nodes of the loops in the kernel being assembled
+static std::vector<std::pair<uint32_t, uint32_t>> hoist_loops;
+
+/// Variables within loops that must remain there
+static VisitedSet hoist_pinned;
+
+/// Can 'v' be computed ahead of the loop containing it?
+static bool jitc_var_loop_hoistable(uint32_t index, const Variable *v) {
+    if (v->placeholder || jitc_optimize_opaque(index, v))
+        return false;
+
+    VarKind kind = (VarKind) v->kind;
+    if (kind == VarKind::Data || kind == VarKind::Literal ||
+        kind == VarKind::Counter)
+        return true;
+
+    // The loop might not run at all, and integer division by zero can trap
+    if ((kind == VarKind::Div || kind == VarKind::Mod) && !jitc_is_float(v))
+        return false;
+
+    // Pure arithmetic, no memory accesses
+    return kind >= VarKind::Neg && kind <= VarKind::Bitcast;
+}
+
+uint32_t jitc_var_loop_hoist(const ScheduledGroup &group) {
+    hoist_loops.clear();
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        uint32_t index = schedule[gi].index;
+        const Variable *v = jitc_var(index);
+        if (!v->extra)
+            continue;
+
+        auto it = state.extra.find(index);
+        if (it == state.extra.end() ||
+            it->second.assemble != jitc_var_loop_assemble_init)
+            continue;
+
+        const Loop *loop = (const Loop *) it->second.callback_data;
+        const Variable *v_end = loop ? jitc_var(loop->end) : nullptr;
+        if (v_end)
+            hoist_loops.emplace_back(v->scope, v_end->scope);
+    }
+
+    if (hoist_loops.empty())
+        return 0;
+
+    /* Variables are ordered by scope, and the dependencies of a variable
+       precede it. A variable without loop-dependent inputs moves to the
+       scope preceding the outermost loop containing it. */
+    hoist_pinned.clear();
+    uint32_t n_hoisted = 0;
+
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        ScheduledVariable &sv = schedule[gi];
+
+        uint32_t target = 0;
+        bool in_loop = false;
+        for (auto [scope_init, scope_end] : hoist_loops) {
+            if (sv.scope > scope_init && sv.scope < scope_end &&
+                (!in_loop || scope_init - 1 < target)) {
+                target = scope_init - 1;
+                in_loop = true;
+            }
+        }
+
+        if (!in_loop)
+            continue;
+
+        const Variable *v = jitc_var(sv.index);
+        bool hoist = jitc_var_loop_hoistable(sv.index, v);
+        for (uint32_t i = 0; i < 4 && hoist; ++i)
+            hoist = !v->dep[i] || !hoist_pinned.contains(v->dep[i]);
+
+        if (hoist) {
+            sv.scope = target;
+            n_hoisted++;
+        } else {
+            hoist_pinned.insert(sv.index);
+        }
+    }
+
+    if (n_hoisted) {
+        std::stable_sort(
+            schedule.begin() + group.start, schedule.begin() + group.end,
+            [](const ScheduledVariable &a, const ScheduledVariable &b) {
+                return a.scope < b.scope;
+            });
+
+        jitc_log(Debug,
+                 "jit_var_loop_hoist(): moved %u loop-invariant variable%s "
+                 "out of %zu loop%s.", n_hoisted, n_hoisted == 1 ? "" : "s",
+                 hoist_loops.size(), hoist_loops.size() == 1 ? "" : "s");
+    }
+
+    return n_hoisted;
+}
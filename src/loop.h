@@ -8,6 +8,18 @@ extern uint32_t jitc_var_loop_cond(uint32_t loop_var_init, uint32_t cond,
 extern uint32_t jitc_var_loop(const char *name, uint32_t loop_init,
                               uint32_t loop_cond, size_t n_indices,
                               uint32_t *indices_in, uint32_t **indices,
-                              uint32_t checkpoint, int first_round);
+                              uint32_t checkpoint, int first_round,
+                              uint32_t unroll);
 
 extern void jitc_var_loop_simplify();
+
+/**
+ * \brief Move loop-invariant computation in front of the recorded loops of a
+ * kernel (\ref JitFlag::LoopOptimize)
+ *
+ * Pure arithmetic that doesn't depend on any loop state variable is
+ * rescheduled so that it runs once instead of in every iteration. Must be
+ * called before register indices are assigned. Returns the number of
+ * variables that were moved.
+ */
+extern uint32_t jitc_var_loop_hoist(const struct ScheduledGroup &group);
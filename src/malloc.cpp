@@ -10,34 +10,115 @@
 #include "internal.h"
 #include "log.h"
 #include "util.h"
+#include "stats.h"
 #include "profiler.h"
+#include "strbuf.h"
+#include "numa.h"
+#include <atomic>
+#include <chrono>
 
-#if !defined(_WIN32)
+#if defined(_WIN32)
+#  include <windows.h>
+#else
 #  include <sys/mman.h>
 #endif
 
-// Try to use huge pages for allocations > 2M (only on Linux)
-#if defined(__linux__)
-#  define DRJIT_HUGEPAGE 1
+#define DRJIT_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/// Device ID of host allocations that are backed by huge pages
+#define DRJIT_HUGEPAGE_DEVICE 0x80
+
+// Number of allocation size classes per power of two
+#define DRJIT_ALLOC_CLASSES 4
+
+/* Per-thread caches ("magazines") of recently released host memory. They
+   are direct-mapped by allocation size and exchange blocks with
+   'state.alloc_free' in batches, so that the churn of small arrays avoids
+   'state.alloc_free_lock' and the hash table lookup. Magazines are only
+   accessed while holding 'state.lock', which also allows
+   jitc_flush_malloc_cache() to drain the magazines of all threads. */
+#define DRJIT_MAGAZINE_COUNT 32
+#define DRJIT_MAGAZINE_SIZE 16
+#define DRJIT_MAGAZINE_MAX_ALLOC (256 * 1024)
+
+struct AllocMagazine {
+    AllocInfo info;
+    uint32_t count;
+    void *ptrs[DRJIT_MAGAZINE_SIZE];
+};
+
+struct AllocThreadCache {
+    AllocMagazine magazines[DRJIT_MAGAZINE_COUNT];
+};
+
+#if defined(_MSC_VER)
+  static __declspec(thread) AllocThreadCache* alloc_thread_cache = nullptr;
 #else
-#  define DRJIT_HUGEPAGE 0
+  static __thread AllocThreadCache* alloc_thread_cache = nullptr;
 #endif
 
-#define DRJIT_HUGEPAGE_SIZE (2 * 1024 * 1024)
+// Size of the chunks that serve temporaries (see jitc_temp_malloc())
+#define DRJIT_TEMP_CHUNK_SIZE (1024 * 1024)
+
+// Number of idle chunks that an arena keeps for later reuse
+#define DRJIT_TEMP_CHUNK_KEEP 4
+
+/// A chunk of memory that serves temporaries by bumping an offset
+struct TempChunk {
+    AllocType type;
+    uint8_t *ptr;
+    size_t size, offset;
+
+    /// Epoch of the last use. The chunk is idle once this epoch has finished.
+    uint64_t epoch;
+
+    /// Holds a single oversized temporary? (released instead of recycled)
+    bool large;
+};
+
+struct TempArena {
+    /// Chunks currently serving temporaries (per allocation type)
+    TempChunk *active[(int) AllocType::Count] { };
+
+    /// Chunks used during the current epoch
+    std::vector<TempChunk *> used;
+
+    /// Chunks used by previous epochs
+    std::vector<TempChunk *> retired;
+
+    /// Chunks referenced by the current and previous CUDA graph capture
+    std::vector<TempChunk *> captured, captured_prev;
+
+    /// Current epoch, and most recent epoch whose work has finished
+    uint64_t epoch = 1;
+    std::atomic<uint64_t> epoch_done { 0 };
+};
+
+/// Marks the end of an epoch in a CUDA stream or in the LLVM task queue
+struct TempFence {
+    TempArena *arena;
+    uint64_t epoch;
+};
+
+/// List of all per-thread caches, protected by 'state.alloc_free_lock'. They
+/// are never released, since threads may continue to use Dr.Jit after a
+/// jit_shutdown() and re-initialization.
+static std::vector<AllocThreadCache *> alloc_thread_caches;
 
 static_assert(
-    sizeof(tsl::detail_robin_hash::bucket_entry<AllocUsedMap::value_type, false>) == 24,
+    sizeof(tsl::detail_robin_hash::bucket_entry<AllocUsedMap::value_type, false>) == 32,
     "AllocUsedMap: incorrect bucket size, likely an issue with padding/packing!");
 
 const char *alloc_type_name[(int) AllocType::Count] = {
-    "host",   "host-async", "host-pinned", "device"
+    "host",   "host-async", "host-pinned", "device", "managed"
 };
 
 const char *alloc_type_name_short[(int) AllocType::Count] = {
     "host       ",
     "host-async ",
     "host-pinned",
-    "device     "
+    "device     ",
+    "managed    "
 };
 
 // Round an unsigned integer up to a power of two
@@ -57,74 +138,262 @@ uint32_t round_pow2(uint32_t x) {
     return x + 1;
 }
 
+/* Round an allocation size up to the next size class. Each power-of-two
+   interval is split into DRJIT_ALLOC_CLASSES equally spaced classes, which
+   bounds the padding to 1/DRJIT_ALLOC_CLASSES of the power of two below
+   'x' while still keeping the number of distinct sizes small enough for
+   freed memory to be reused. 'align' must be a power of two. */
+size_t round_size_class(size_t x, size_t align) {
+    size_t step = round_pow2(x) / (2 * DRJIT_ALLOC_CLASSES);
+    if (step < align)
+        step = align;
+    return (x + step - 1) / step * step;
+}
+
+
+/// Return the magazine of the current thread responsible for 'info' (if any)
+static AllocMagazine *jitc_alloc_magazine(AllocInfo info, size_t size,
+                                          AllocType type) {
+    if ((type != AllocType::Host && type != AllocType::HostAsync) ||
+        size > DRJIT_MAGAZINE_MAX_ALLOC)
+        return nullptr;
+
+    AllocThreadCache *cache = alloc_thread_cache;
+    if (unlikely(!cache)) {
+        cache = (AllocThreadCache *) malloc_check(sizeof(AllocThreadCache));
+        memset(cache, 0, sizeof(AllocThreadCache));
+        lock_guard guard(state.alloc_free_lock);
+        alloc_thread_caches.push_back(cache);
+        alloc_thread_cache = cache;
+    }
+
+    uint32_t slot = (uint32_t) ((info * 0x9E3779B97F4A7C15ull) >> 59);
+    static_assert(DRJIT_MAGAZINE_COUNT == 32, "Update the slot computation!");
+    return &cache->magazines[slot];
+}
 
-static void *aligned_malloc(size_t size) {
+/// Move 'count' blocks from a magazine to 'state.alloc_free'. Requires 'alloc_free_lock'.
+static void jitc_alloc_magazine_spill(AllocMagazine *m, uint32_t count) {
+    std::vector<void *> &list = state.alloc_free[m->info];
+    m->count -= count;
+    list.insert(list.end(), m->ptrs + m->count, m->ptrs + m->count + count);
+}
+
+/// Size of a mapping that backs a huge page allocation of 'size' bytes
+static size_t aligned_huge_size(size_t size) {
+    return (size + DRJIT_HUGEPAGE_SIZE - 1) / DRJIT_HUGEPAGE_SIZE *
+           DRJIT_HUGEPAGE_SIZE;
+}
+
+static void *aligned_malloc(size_t size, bool huge) {
 #if !defined(_WIN32)
     // Use posix_memalign for small allocations and mmap() for big ones
-    if (size < DRJIT_HUGEPAGE_SIZE) {
+    if (!huge && size < DRJIT_HUGEPAGE_SIZE) {
         void *ptr = nullptr;
         int rv = posix_memalign(&ptr, 64, size);
         return rv == 0 ? ptr : nullptr;
-    } else {
-        void *ptr;
+    }
 
-#if DRJIT_HUGEPAGE
-        // Attempt to allocate a 2M page directly
-        ptr = mmap(0, size, PROT_READ | PROT_WRITE,
-                   MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
-        if (ptr != MAP_FAILED)
-            return ptr;
-#endif
+    void *ptr = MAP_FAILED;
 
+    if (!huge) {
         // Allocate 4K pages
         ptr = mmap(0, size, PROT_READ | PROT_WRITE,
                    MAP_PRIVATE | MAP_ANON, -1, 0);
+    } else {
+        size = aligned_huge_size(size);
 
-#if DRJIT_HUGEPAGE
-        // .. and advise the OS to convert to 2M pages
-        if (ptr != MAP_FAILED)
-            madvise(ptr, size, MADV_HUGEPAGE);
+#if defined(MAP_HUGETLB)
+        // Attempt to allocate 2M pages directly from the reserved pool
+        if (state.huge_page_policy == HugePagePolicy::Explicit)
+            ptr = mmap(0, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
 #endif
 
-        return ptr;
+        if (ptr == MAP_FAILED) {
+            /* Transparent huge pages require a 2M-aligned range, hence
+               over-allocate and trim the ends */
+            size_t padded = size + DRJIT_HUGEPAGE_SIZE;
+            uint8_t *base = (uint8_t *) mmap(0, padded, PROT_READ | PROT_WRITE,
+                                             MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (base != (uint8_t *) MAP_FAILED) {
+                uintptr_t addr = (uintptr_t) base,
+                          aligned = (addr + DRJIT_HUGEPAGE_SIZE - 1) &
+                                    ~(uintptr_t) (DRJIT_HUGEPAGE_SIZE - 1);
+                size_t head = aligned - addr, tail = padded - head - size;
+                if (head)
+                    munmap(base, head);
+                if (tail)
+                    munmap(base + head + size, tail);
+                ptr = base + head;
+
+#if defined(MADV_HUGEPAGE)
+                // .. and advise the OS to convert to 2M pages
+                madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+            }
+        }
     }
+
+    if (ptr == MAP_FAILED)
+        return nullptr;
+
+    // Apply the NUMA policy before the pages are first touched
+    jitc_numa_advise(ptr, size);
+
+    return ptr;
 #else
-    return _aligned_malloc(size, 64);
+    if (!huge)
+        return _aligned_malloc(size, 64);
+
+    void *ptr = nullptr;
+    size_t large_page = GetLargePageMinimum();
+
+    // Large pages require the 'SeLockMemoryPrivilege' privilege
+    if (state.huge_page_policy == HugePagePolicy::Explicit && large_page)
+        ptr = VirtualAlloc(nullptr,
+                           (size + large_page - 1) / large_page * large_page,
+                           MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                           PAGE_READWRITE);
+
+    if (!ptr)
+        ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                           PAGE_READWRITE);
+
+    return ptr;
 #endif
 }
 
-static void aligned_free(void *ptr, size_t size) {
+static void aligned_free(void *ptr, size_t size, bool huge) {
 #if !defined(_WIN32)
-    if (size < DRJIT_HUGEPAGE_SIZE)
+    if (huge)
+        munmap(ptr, aligned_huge_size(size));
+    else if (size < DRJIT_HUGEPAGE_SIZE)
         free(ptr);
     else
         munmap(ptr, size);
 #else
     (void) size;
-    _aligned_free(ptr);
+    if (huge)
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    else
+        _aligned_free(ptr);
 #endif
 }
 
+/// Microseconds since an arbitrary point in time (for the profiler)
+static uint64_t jitc_malloc_profile_time() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Start tracking an allocation (JitFlag::MallocProfile)
+static void jitc_malloc_profile_alloc(void *ptr) {
+    AllocProfileRecord &r = state.alloc_profile.records[(uintptr_t) ptr];
+    free(r.label);
+    r = AllocProfileRecord();
+    r.time = jitc_malloc_profile_time();
+}
+
+/// Record all live allocations of 'type' as the new peak snapshot
+static void jitc_malloc_profile_snapshot(AllocType type) {
+    AllocProfile &p = state.alloc_profile;
+    std::vector<AllocProfileSnapshot> &peak = p.peak[(int) type];
+
+    peak.clear();
+    for (auto &kv : state.alloc_used) {
+        auto [size, type_2, device] = alloc_info_decode(kv.second.info);
+        (void) device;
+        if (type_2 != type)
+            continue;
+
+        AllocProfileSnapshot s { size, 0, 0, std::string() };
+        auto it = p.records.find(kv.first);
+        if (it != p.records.end()) {
+            s.index = it->second.index;
+            s.kernel_hash = it->second.kernel_hash;
+            if (it->second.label)
+                s.label = it->second.label;
+        } else {
+            s.label = "(not tracked)";
+        }
+        peak.push_back(std::move(s));
+    }
+
+    p.peak_usage[(int) type] = state.alloc_usage[(int) type];
+}
+
+/// Stop tracking an allocation that is about to be released
+static void jitc_malloc_profile_free(void *ptr, AllocInfo info) {
+    AllocProfile &p = state.alloc_profile;
+    auto [size, type, device] = alloc_info_decode(info);
+    (void) device;
+
+    /* About to descend from a peak: take a snapshot if it exceeds the
+       previous one by more than 1% */
+    size_t usage = state.alloc_usage[(int) type],
+           peak_usage = p.peak_usage[(int) type];
+    if (usage > peak_usage + peak_usage / 100 || p.peak[(int) type].empty())
+        jitc_malloc_profile_snapshot(type);
+
+    auto it = p.records.find((uintptr_t) ptr);
+    if (it == p.records.end())
+        return;
+
+    uint64_t lifetime = jitc_malloc_profile_time() - it->second.time,
+             threshold = 10;
+    uint32_t bin = 0;
+    while (bin < DRJIT_ALLOC_PROFILE_BINS - 1 && lifetime >= threshold) {
+        threshold *= 10;
+        bin++;
+    }
+
+    p.lifetime_count[(int) type][bin]++;
+    p.lifetime_size[(int) type][bin] += size;
+
+    free(it.value().label);
+    p.records.erase(it);
+}
+
+/// Try to take a block from the allocation cache
+static void *jitc_malloc_reuse(AllocInfo ai) {
+    lock_guard guard(state.alloc_free_lock);
+    auto it = state.alloc_free.find(ai);
+    if (it == state.alloc_free.end())
+        return nullptr;
+
+    std::vector<void *> &list = it.value();
+    if (list.empty())
+        return nullptr;
+
+    void *ptr = list.back();
+    list.pop_back();
+    return ptr;
+}
+
+static void jitc_malloc_pressure(AllocType type, size_t size, size_t target);
+
 void* jitc_malloc(AllocType type, size_t size) {
     if (size == 0)
         return nullptr;
 
-    if ((type != AllocType::Host && type != AllocType::HostAsync) ||
-        jitc_llvm_vector_width < 16) {
-        // Round up to the next multiple of 64 bytes
-        size = (size + 63) / 64 * 64;
-    } else {
-        size_t packet_size = jitc_llvm_vector_width * sizeof(double);
-        size = (size + packet_size - 1) / packet_size * packet_size;
-    }
+    size_t requested = size, align = 64;
 
-    /* Round 'size' to the next larger power of two. This is somewhat
-       wasteful, but reduces the number of different sizes that an allocation
-       can have to a manageable amount that facilitates re-use. */
-    size = round_pow2(size);
+    // Round up to the next multiple of 64 bytes or of the LLVM packet size
+    if ((type == AllocType::Host || type == AllocType::HostAsync) &&
+        jitc_llvm_vector_width >= 16)
+        align = jitc_llvm_vector_width * sizeof(double);
+
+    size = (size + align - 1) / align * align;
+
+    /* Round 'size' to the next size class. This is somewhat wasteful, but
+       reduces the number of different sizes that an allocation can have to a
+       manageable amount that facilitates re-use. */
+    size = round_size_class(size, align);
 
     JitBackend backend =
-        (type == AllocType::Device || type == AllocType::HostPinned)
+        (type == AllocType::Device || type == AllocType::HostPinned ||
+         type == AllocType::Managed)
             ? JitBackend::CUDA
             : JitBackend::LLVM;
     ThreadState *ts = nullptr;
@@ -133,39 +402,55 @@ void* jitc_malloc(AllocType type, size_t size) {
     if (backend == JitBackend::CUDA) {
         ts = thread_state(backend);
         device = ts->device;
+    } else if (state.huge_page_policy != HugePagePolicy::Disabled &&
+               size >= state.huge_page_threshold) {
+        // Separate bucket so that huge pages are only reused for large requests
+        device = DRJIT_HUGEPAGE_DEVICE;
     }
 
     AllocInfo ai = alloc_info_encode(size, type, device);
     const char *descr = nullptr;
     void *ptr = nullptr;
+    bool fresh = false;
 
-    /* Try to reuse a freed allocation */ {
-        lock_guard guard(state.alloc_free_lock);
-        auto it = state.alloc_free.find(ai);
-
-        if (it != state.alloc_free.end()) {
-            std::vector<void *> &list = it.value();
-            if (!list.empty()) {
-                ptr = list.back();
-                list.pop_back();
-                descr = "reused";
-            }
-        }
+    // Try to reuse a block from the current thread's cache
+    AllocMagazine *m = jitc_alloc_magazine(ai, size, type);
+    if (m && m->info == ai && m->count > 0) {
+        ptr = m->ptrs[--m->count];
+        descr = "reused, thread cache";
+    }
+
+    // Try to reuse a freed allocation
+    if (!ptr && (ptr = jitc_malloc_reuse(ai)))
+        descr = "reused";
+
+    // Trim the cache when exceeding the soft limit (with 1/8 hysteresis)
+    size_t limit = state.alloc_limit[(int) type];
+    if (unlikely(!ptr && limit &&
+                 state.alloc_allocated[(int) type] + size > limit)) {
+        size_t target = limit - limit / 8;
+        jitc_malloc_pressure(type, size, target > size ? target - size : 0);
+        if ((ptr = jitc_malloc_reuse(ai)))
+            descr = "reused after memory pressure";
     }
 
     // Otherwise, allocate memory
     if (unlikely(!ptr)) {
-        for (int i = 0; i < 2; ++i) {
-            unlock_guard guard(state.lock);
+        bool reused = false;
+        for (int i = 0; i < 3; ++i) {
             /* Temporarily release the main lock */ {
+                unlock_guard guard(state.lock);
                 if (backend != JitBackend::CUDA) {
-                    ptr = aligned_malloc(size);
+                    ptr = aligned_malloc(size, device == DRJIT_HUGEPAGE_DEVICE);
                 } else {
                     scoped_set_context guard_2(ts->context);
                     CUresult ret;
 
                     if (type == AllocType::HostPinned)
                         ret = cuMemAllocHost(&ptr, size);
+                    else if (type == AllocType::Managed)
+                        ret = cuMemAllocManaged((CUdeviceptr *) &ptr, size,
+                                                CU_MEM_ATTACH_GLOBAL);
                     else if (ts->memory_pool)
                         ret = cuMemAllocAsync((CUdeviceptr*) &ptr, size, ts->stream);
                     else
@@ -177,24 +462,48 @@ void* jitc_malloc(AllocType type, size_t size) {
             }
             if (ptr)
                 break;
-            if (i == 0) // free memory, then retry
+
+            if (i == 0) {
+                // Release cached blocks of this type, largest first
+                size_t allocated = state.alloc_allocated[(int) type];
+                jitc_malloc_pressure(type, size,
+                                     allocated > size ? allocated - size : 0);
+                if ((ptr = jitc_malloc_reuse(ai))) {
+                    reused = true;
+                    break;
+                }
+            } else if (i == 1) {
+                // Free all cached memory, then retry
                 jitc_flush_malloc_cache(true);
+            }
         }
-        descr = "new allocation";
 
-        size_t &allocated = state.alloc_allocated[(int) type],
-               &watermark = state.alloc_watermark[(int) type];
+        if (reused) {
+            descr = "reused after memory pressure";
+        } else if (ptr) {
+            descr = "new allocation";
+            fresh = true;
+
+            size_t &allocated = state.alloc_allocated[(int) type],
+                   &watermark = state.alloc_watermark[(int) type];
 
-        allocated += size;
-        watermark = std::max(allocated, watermark);
+            allocated += size;
+            watermark = std::max(allocated, watermark);
+        }
     }
 
     if (unlikely(!ptr))
         jitc_raise("jit_malloc(): out of memory! Could not allocate %zu bytes "
                    "of %s memory.", size, alloc_type_name[(int) type]);
 
-    state.alloc_used.emplace((uintptr_t) ptr, ai);
+    jitc_stat(fresh ? Stat::AllocFresh : Stat::AllocReused);
+
+    state.alloc_used.emplace((uintptr_t) ptr, AllocUsed{ ai, requested });
     state.alloc_usage[(int) type] += size;
+    state.alloc_requested[(int) type] += requested;
+
+    if (unlikely(jitc_flags() & (uint32_t) JitFlag::MallocProfile))
+        jitc_malloc_profile_alloc(ptr);
 
     (void) descr; // don't warn if tracing is disabled
     if (ts)
@@ -207,6 +516,192 @@ void* jitc_malloc(AllocType type, size_t size) {
     return ptr;
 }
 
+/// Physical memory properties and mapping granularity of a CUDA device
+static size_t jitc_malloc_granularity(int device, CUmemAllocationProp &prop) {
+    prop = CUmemAllocationProp();
+    prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+    prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    prop.location.id = state.devices[device].id;
+
+    size_t granularity = 0;
+    cuda_check(cuMemGetAllocationGranularity(&granularity, &prop,
+                                             CU_MEM_ALLOC_GRANULARITY_MINIMUM));
+    return granularity;
+}
+
+/// Map physical memory so that at least 'size' bytes of 'g' are accessible
+static bool jitc_malloc_commit(void *base, AllocGrowable &g, AllocUsed &u,
+                               size_t size) {
+    CUmemAllocationProp prop;
+    size_t granularity = jitc_malloc_granularity(g.device, prop);
+
+    // Grow geometrically to amortize the cost of the mapping operations
+    size_t min_size = (size + granularity - 1) / granularity * granularity,
+           target = std::max(min_size, g.mapped * 2);
+    target = std::min(target, g.reserved);
+
+    CUmemGenericAllocationHandle handle = 0;
+    CUresult rv = CUDA_ERROR_OUT_OF_MEMORY;
+    for (int i = 0; i < 3 && rv != CUDA_SUCCESS; ++i) {
+        if (i == 1) // Only map what is needed right now
+            target = min_size;
+        else if (i == 2) // Free all cached memory, then retry
+            jitc_flush_malloc_cache(true);
+
+        rv = cuMemCreate(&handle, target - g.mapped, &prop, 0);
+        if (rv != CUDA_SUCCESS && rv != CUDA_ERROR_OUT_OF_MEMORY)
+            cuda_check(rv);
+    }
+
+    if (rv != CUDA_SUCCESS)
+        return false;
+
+    size_t chunk = target - g.mapped;
+    CUdeviceptr addr = (CUdeviceptr) ((uint8_t *) base + g.mapped);
+    cuda_check(cuMemMap(addr, chunk, 0, handle, 0));
+
+    CUmemAccessDesc access;
+    access.location = prop.location;
+    access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+    cuda_check(cuMemSetAccess(addr, chunk, &access, 1));
+
+    g.handles.push_back((uint64_t) handle);
+    g.sizes.push_back(chunk);
+    g.mapped = target;
+
+    size_t &usage = state.alloc_usage[(int) AllocType::Device],
+           &allocated = state.alloc_allocated[(int) AllocType::Device],
+           &watermark = state.alloc_watermark[(int) AllocType::Device];
+
+    usage += chunk;
+    allocated += chunk;
+    watermark = std::max(allocated, watermark);
+    u.info = alloc_info_encode(g.mapped, AllocType::Device, g.device);
+
+    return true;
+}
+
+/// Unmap and release a growable allocation. It must no longer be in use.
+static void jitc_malloc_release_growable(void *ptr, const AllocGrowable &g) {
+    uint8_t *addr = (uint8_t *) ptr;
+    for (size_t i = 0; i < g.handles.size(); ++i) {
+        cuda_check(cuMemUnmap((CUdeviceptr) addr, g.sizes[i]));
+        cuda_check(cuMemRelease((CUmemGenericAllocationHandle) g.handles[i]));
+        addr += g.sizes[i];
+    }
+    cuda_check(cuMemAddressFree((CUdeviceptr) ptr, g.reserved));
+}
+
+void *jitc_malloc_reserve(AllocType type, size_t size, size_t capacity) {
+    if (size == 0)
+        return nullptr;
+
+    capacity = std::max(capacity, size);
+
+    ThreadState *ts = nullptr;
+    if (type == AllocType::Device)
+        ts = thread_state(JitBackend::CUDA);
+
+    if (!ts || !state.devices[ts->device].virtual_memory)
+        return jitc_malloc(type, size);
+
+    scoped_set_context guard(ts->context);
+    const char *descr = "reused";
+    void *ptr = nullptr;
+    AllocGrowable g;
+
+    // Try to reuse a released reservation that is large enough
+    std::vector<std::pair<void *, AllocGrowable>> &cache =
+        state.alloc_growable_free;
+    for (size_t i = 0; i < cache.size(); ++i) {
+        if (cache[i].second.device != ts->device ||
+            cache[i].second.reserved < capacity)
+            continue;
+        ptr = cache[i].first;
+        g = std::move(cache[i].second);
+        cache[i] = std::move(cache.back());
+        cache.pop_back();
+        break;
+    }
+
+    if (!ptr) {
+        CUmemAllocationProp prop;
+        size_t granularity = jitc_malloc_granularity(ts->device, prop);
+
+        g.device = ts->device;
+        g.mapped = 0;
+        g.reserved = (capacity + granularity - 1) / granularity * granularity;
+
+        CUdeviceptr base = 0;
+        CUresult rv = cuMemAddressReserve(&base, g.reserved, 0, 0, 0);
+        if (rv != CUDA_SUCCESS) {
+            jitc_log(Warn, "jit_malloc_reserve(): could not reserve %s of "
+                     "virtual memory, falling back to jit_malloc().",
+                     jitc_mem_string(g.reserved));
+            return jitc_malloc(type, size);
+        }
+
+        ptr = (void *) base;
+        descr = "new reservation";
+    } else {
+        // Physical memory of the reused reservation remains mapped
+        state.alloc_usage[(int) type] += g.mapped;
+    }
+
+    AllocUsed &u = state.alloc_used[(uintptr_t) ptr];
+    u = AllocUsed{ alloc_info_encode(g.mapped, type, g.device), size };
+
+    if (g.mapped < size && !jitc_malloc_commit(ptr, g, u, size)) {
+        state.alloc_used.erase((uintptr_t) ptr);
+        state.alloc_usage[(int) type] -= g.mapped;
+        state.alloc_growable_free.emplace_back(ptr, std::move(g));
+        jitc_raise("jit_malloc_reserve(): out of memory! Could not allocate "
+                   "%zu bytes of device memory.", size);
+    }
+
+    state.alloc_requested[(int) type] += size;
+
+    jitc_trace("jit_malloc_reserve(device=%u, size=%zu, capacity=%zu): " DRJIT_PTR
+               " (%s)", g.device, size, g.reserved, (uintptr_t) ptr, descr);
+    (void) descr;
+
+    state.alloc_growable.emplace((uintptr_t) ptr, std::move(g));
+
+    return ptr;
+}
+
+bool jitc_malloc_grow(void *ptr, size_t size) {
+    auto it = state.alloc_used.find((uintptr_t) ptr);
+    if (unlikely(it == state.alloc_used.end()))
+        jitc_raise("jit_malloc_grow(): unknown address " DRJIT_PTR "!",
+                   (uintptr_t) ptr);
+
+    AllocUsed &u = it.value();
+    auto [cur_size, type, device] = alloc_info_decode(u.info);
+    (void) device;
+
+    if (size > cur_size) {
+        auto it2 = state.alloc_growable.find((uintptr_t) ptr);
+        if (it2 == state.alloc_growable.end() || size > it2->second.reserved)
+            return false;
+
+        AllocGrowable &g = it2.value();
+        scoped_set_context guard(state.devices[g.device].context);
+        if (!jitc_malloc_commit(ptr, g, u, size))
+            return false;
+
+        jitc_trace("jit_malloc_grow(" DRJIT_PTR ", size=%zu): mapped %zu bytes",
+                   (uintptr_t) ptr, size, g.mapped);
+    }
+
+    if (size > u.requested) {
+        state.alloc_requested[(int) type] += size - u.requested;
+        u.requested = size;
+    }
+
+    return true;
+}
+
 void jitc_free(void *ptr) {
     if (!ptr)
         return;
@@ -214,13 +709,42 @@ void jitc_free(void *ptr) {
     auto it = state.alloc_used.find((uintptr_t) ptr);
     if (unlikely(it == state.alloc_used.end()))
         jitc_raise("jit_free(): unknown address " DRJIT_PTR "!", (uintptr_t) ptr);
-    AllocInfo info = it->second;
+    AllocInfo info = it->second.info;
+    size_t requested = it->second.requested;
+
+    if (unlikely(!state.alloc_profile.records.empty()))
+        jitc_malloc_profile_free(ptr, info);
+
     state.alloc_used.erase(it);
 
     auto [size, type, device] = alloc_info_decode(info);
     state.alloc_usage[(int) type] -= size;
+    state.alloc_requested[(int) type] -= requested;
+
+    if (unlikely(type == AllocType::Device && !state.alloc_growable.empty())) {
+        auto it2 = state.alloc_growable.find((uintptr_t) ptr);
+        if (it2 != state.alloc_growable.end()) {
+            // Keep the reservation around for jitc_malloc_reserve()
+            state.alloc_growable_free.emplace_back(ptr, std::move(it2.value()));
+            state.alloc_growable.erase(it2);
+            jitc_trace("jit_free(" DRJIT_PTR ", type=%s, device=%i, size=%zu, "
+                       "growable)", (uintptr_t) ptr,
+                       alloc_type_name[(int) type], device, size);
+            return;
+        }
+    }
 
-    if (type != AllocType::HostPinned) {
+    AllocMagazine *m = jitc_alloc_magazine(info, size, type);
+    if (m) {
+        if (m->count > 0 && (m->info != info || m->count == DRJIT_MAGAZINE_SIZE)) {
+            // Return half of a full magazine, or all blocks of another size
+            lock_guard guard(state.alloc_free_lock);
+            jitc_alloc_magazine_spill(m, m->info != info ? m->count
+                                                         : m->count / 2);
+        }
+        m->info = info;
+        m->ptrs[m->count++] = ptr;
+    } else if (type != AllocType::HostPinned) {
         lock_guard guard(state.alloc_free_lock);
         state.alloc_free[info].push_back(ptr);
     } else {
@@ -247,7 +771,8 @@ void jitc_free(void *ptr) {
             r));
     }
 
-    if (type == AllocType::Device || type == AllocType::HostPinned)
+    if (type == AllocType::Device || type == AllocType::HostPinned ||
+        type == AllocType::Managed)
         jitc_trace("jit_free(" DRJIT_PTR ", type=%s, device=%i, size=%zu)",
                    (uintptr_t) ptr, alloc_type_name[(int) type], device, size);
     else
@@ -258,6 +783,393 @@ void jitc_free(void *ptr) {
 void jitc_malloc_clear_statistics() {
     for (int i = 0; i < (int) AllocType::Count; ++i)
         state.alloc_watermark[i] = state.alloc_allocated[i];
+
+    AllocProfile &p = state.alloc_profile;
+    for (int i = 0; i < (int) AllocType::Count; ++i) {
+        p.peak[i].clear();
+        p.peak_usage[i] = 0;
+    }
+    memset(p.lifetime_count, 0, sizeof(p.lifetime_count));
+    memset(p.lifetime_size, 0, sizeof(p.lifetime_size));
+}
+
+void jitc_malloc_profile_tag(void *ptr, uint32_t index, const char *label,
+                             uint64_t kernel_hash) {
+    auto it = state.alloc_profile.records.find((uintptr_t) ptr);
+    if (it == state.alloc_profile.records.end())
+        return;
+
+    AllocProfileRecord &r = it.value();
+    r.index = index;
+    r.kernel_hash = kernel_hash;
+    free(r.label);
+    r.label = label ? strdup(label) : nullptr;
+}
+
+static StringBuffer profile_buffer(0);
+
+const char *jitc_malloc_profile() {
+    AllocProfile &p = state.alloc_profile;
+    StringBuffer &buf = profile_buffer;
+    buf.clear();
+
+    // Bins of the cache statistics
+    const size_t cache_bins[] = { 4096, 65536, 1 << 20, 16 << 20, 256 << 20,
+                                  (size_t) -1 };
+    const char *cache_bin_names[] = { "<= 4 KiB", "<= 64 KiB", "<= 1 MiB",
+                                      "<= 16 MiB", "<= 256 MiB", "larger" };
+    constexpr int CacheBins = (int) (sizeof(cache_bins) / sizeof(size_t));
+    size_t cache_size[(int) AllocType::Count][CacheBins] { },
+           cache_count[(int) AllocType::Count][CacheBins] { };
+
+    auto cache_add = [&](AllocInfo info, size_t count) {
+        auto [size, type, device] = alloc_info_decode(info);
+        (void) device;
+        int bin = 0;
+        while (size > cache_bins[bin])
+            bin++;
+        cache_size[(int) type][bin] += size * count;
+        cache_count[(int) type][bin] += count;
+    };
+
+    /* Critical section */ {
+        lock_guard guard(state.alloc_free_lock);
+        for (auto &kv : state.alloc_free)
+            cache_add(kv.first, kv.second.size());
+        for (AllocThreadCache *cache : alloc_thread_caches)
+            for (AllocMagazine &m : cache->magazines)
+                if (m.count)
+                    cache_add(m.info, m.count);
+    }
+
+    const char *lifetime_names[DRJIT_ALLOC_PROFILE_BINS] = {
+        "< 10 us", "< 100 us", "< 1 ms", "< 10 ms",
+        "< 100 ms", "< 1 s", "< 10 s", ">= 10 s"
+    };
+
+    buf.put("\n  Allocation profile\n");
+    buf.put("  ==================\n");
+
+    if (!(jitc_flags() & (uint32_t) JitFlag::MallocProfile))
+        buf.put("\n  Note: JitFlag::MallocProfile is currently disabled.\n");
+
+    for (int i = 0; i < (int) AllocType::Count; ++i) {
+        AllocType type = (AllocType) i;
+
+        // The current state might be a peak that hasn't been recorded yet
+        size_t peak_usage = p.peak_usage[i];
+        if (state.alloc_usage[i] > peak_usage + peak_usage / 100)
+            jitc_malloc_profile_snapshot(type);
+
+        size_t cached = 0, lifetimes = 0;
+        for (int j = 0; j < CacheBins; ++j)
+            cached += cache_size[i][j];
+        for (int j = 0; j < DRJIT_ALLOC_PROFILE_BINS; ++j)
+            lifetimes += p.lifetime_count[i][j];
+
+        if (p.peak[i].empty() && cached == 0 && lifetimes == 0)
+            continue;
+
+        buf.fmt("\n  %s memory: ", alloc_type_name[i]);
+        buf.fmt("%s in use, ", jitc_mem_string(state.alloc_usage[i]));
+        buf.fmt("%s at the recorded peak, ", jitc_mem_string(p.peak_usage[i]));
+        buf.fmt("%s cached.\n", jitc_mem_string(cached));
+
+        if (!p.peak[i].empty()) {
+            // Aggregate the peak snapshot by origin
+            struct Group {
+                size_t size = 0, count = 0;
+                uint32_t index = 0;
+                uint64_t kernel_hash = 0;
+                const std::string *label = nullptr;
+            };
+
+            std::vector<Group> groups;
+            tsl::robin_map<std::string, size_t> group_map;
+            for (const AllocProfileSnapshot &s : p.peak[i]) {
+                char key[32];
+                snprintf(key, sizeof(key), "%016llx/",
+                         (unsigned long long) s.kernel_hash);
+                std::string k = key + s.label;
+                if (s.label.empty())
+                    k += std::to_string(s.index);
+
+                auto result = group_map.try_emplace(k, groups.size());
+                if (result.second) {
+                    Group g;
+                    g.index = s.index;
+                    g.kernel_hash = s.kernel_hash;
+                    g.label = &s.label;
+                    groups.push_back(g);
+                }
+
+                Group &g = groups[result.first->second];
+                g.size += s.size;
+                g.count++;
+            }
+
+            std::sort(groups.begin(), groups.end(),
+                      [](const Group &a, const Group &b) {
+                          return a.size > b.size;
+                      });
+
+            buf.put("\n    Live at peak     Count     Kernel             Variable\n");
+            buf.put("    -----------------------------------------------------------\n");
+            for (size_t j = 0; j < groups.size() && j < 20; ++j) {
+                const Group &g = groups[j];
+                buf.fmt("    %-16s %-9zu ", jitc_mem_string(g.size), g.count);
+                if (g.kernel_hash)
+                    buf.fmt("%016llx   ", (unsigned long long) g.kernel_hash);
+                else
+                    buf.put("-                  ");
+                if (!g.label->empty())
+                    buf.fmt("%s\n", g.label->c_str());
+                else if (g.index)
+                    buf.fmt("r%u\n", g.index);
+                else
+                    buf.put("-\n");
+            }
+            if (groups.size() > 20)
+                buf.fmt("    (%zu more)\n", groups.size() - 20);
+        }
+
+        if (lifetimes) {
+            buf.put("\n    Lifetime         Count     Size\n");
+            buf.put("    -----------------------------------------------------------\n");
+            for (int j = 0; j < DRJIT_ALLOC_PROFILE_BINS; ++j) {
+                if (!p.lifetime_count[i][j])
+                    continue;
+                buf.fmt("    %-16s %-9zu ", lifetime_names[j],
+                        p.lifetime_count[i][j]);
+                buf.fmt("%s\n", jitc_mem_string(p.lifetime_size[i][j]));
+            }
+        }
+
+        if (cached) {
+            buf.put("\n    Cached (unused)  Count     Size\n");
+            buf.put("    -----------------------------------------------------------\n");
+            for (int j = 0; j < CacheBins; ++j) {
+                if (!cache_count[i][j])
+                    continue;
+                buf.fmt("    %-16s %-9zu ", cache_bin_names[j],
+                        cache_count[i][j]);
+                buf.fmt("%s\n", jitc_mem_string(cache_size[i][j]));
+            }
+        }
+    }
+
+    return buf.get();
+}
+
+/// Find an idle chunk of the right type, or create a new one
+static TempChunk *jitc_temp_chunk(TempArena *a, AllocType type, size_t size) {
+    bool large = size > DRJIT_TEMP_CHUNK_SIZE / 4;
+    TempChunk *c = nullptr;
+
+    if (!large) {
+        uint64_t epoch_done = a->epoch_done.load(std::memory_order_acquire);
+        for (size_t i = 0; i < a->retired.size(); ++i) {
+            TempChunk *r = a->retired[i];
+            if (r->type == type && !r->large && r->epoch <= epoch_done) {
+                a->retired[i] = a->retired.back();
+                a->retired.pop_back();
+                c = r;
+                break;
+            }
+        }
+    }
+
+    if (!c) {
+        c = new TempChunk();
+        c->type = type;
+        c->size = large ? size : DRJIT_TEMP_CHUNK_SIZE;
+        c->ptr = (uint8_t *) jitc_malloc(type, c->size);
+        c->large = large;
+    }
+
+    c->offset = 0;
+    a->used.push_back(c);
+    if (!large)
+        a->active[(int) type] = c;
+
+    return c;
+}
+
+void *jitc_temp_malloc(ThreadState *ts, AllocType type, size_t size) {
+    if (size == 0)
+        return nullptr;
+
+    TempArena *a = ts->temp_arena;
+    if (unlikely(!a))
+        a = ts->temp_arena = new TempArena();
+
+    size = (size + 63) / 64 * 64;
+
+    TempChunk *c = a->active[(int) type];
+    if (!c || c->offset + size > c->size)
+        c = jitc_temp_chunk(a, type, size);
+
+    void *ptr = c->ptr + c->offset;
+    c->offset += size;
+    return ptr;
+}
+
+void jitc_temp_reset(ThreadState *ts) {
+    TempArena *a = ts->temp_arena;
+    if (!a || a->used.empty())
+        return;
+
+    memset(a->active, 0, sizeof(a->active));
+
+    // A captured graph reads its temporaries whenever it is replayed
+    if (ts->graph_capture) {
+        a->captured.insert(a->captured.end(), a->used.begin(), a->used.end());
+        a->used.clear();
+        return;
+    }
+
+    uint64_t epoch = a->epoch++;
+    for (TempChunk *c : a->used) {
+        c->epoch = epoch;
+        a->retired.push_back(c);
+    }
+    a->used.clear();
+
+    // Submit a fence that marks the end of this epoch
+    TempFence fence { a, epoch };
+    if (ts->backend == JitBackend::CUDA) {
+        TempFence *f = (TempFence *) malloc_check(sizeof(TempFence));
+        *f = fence;
+        scoped_set_context guard(ts->context);
+        cuda_check(cuLaunchHostFunc(
+            ts->stream,
+            [](void *p) {
+                TempFence *f2 = (TempFence *) p;
+                f2->arena->epoch_done.store(f2->epoch, std::memory_order_release);
+                free(f2);
+            },
+            f));
+    } else if (jitc_task) {
+        Task *new_task = task_submit_dep(
+            nullptr, &jitc_task, 1, 1,
+            [](uint32_t, void *p) {
+                TempFence *f2 = (TempFence *) p;
+                f2->arena->epoch_done.store(f2->epoch, std::memory_order_release);
+            },
+            &fence, sizeof(TempFence), nullptr, 1);
+        task_release(jitc_task);
+        jitc_task = new_task;
+    } else {
+        a->epoch_done.store(epoch, std::memory_order_release);
+    }
+
+    // Release idle oversized chunks and ones exceeding DRJIT_TEMP_CHUNK_KEEP
+    uint64_t epoch_done = a->epoch_done.load(std::memory_order_acquire);
+    uint32_t kept = 0;
+    for (size_t i = 0; i < a->retired.size(); ) {
+        TempChunk *c = a->retired[i];
+        if (c->epoch <= epoch_done && (c->large || kept++ >= DRJIT_TEMP_CHUNK_KEEP)) {
+            jitc_free(c->ptr);
+            delete c;
+            a->retired[i] = a->retired.back();
+            a->retired.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void jitc_temp_graph_end(ThreadState *ts) {
+    TempArena *a = ts->temp_arena;
+    if (!a)
+        return;
+
+    // The previous graph is no longer replayed once prior launches finish
+    for (TempChunk *c : a->captured_prev) {
+        c->epoch = a->epoch;
+        a->retired.push_back(c);
+    }
+
+    a->captured_prev.swap(a->captured);
+    a->captured.clear();
+}
+
+void jitc_temp_release(ThreadState *ts) {
+    TempArena *a = ts->temp_arena;
+    if (!a)
+        return;
+
+    for (std::vector<TempChunk *> *list :
+         { &a->used, &a->retired, &a->captured, &a->captured_prev }) {
+        for (TempChunk *c : *list) {
+            jitc_free(c->ptr);
+            delete c;
+        }
+    }
+
+    delete a;
+    ts->temp_arena = nullptr;
+}
+
+CUstream jitc_copy_stream_begin(ThreadState *ts) {
+    Device &dev = state.devices[ts->device];
+
+    if (!dev.copy_stream) {
+        cuda_check(cuStreamCreate(&dev.copy_stream, CU_STREAM_NON_BLOCKING));
+        cuda_check(cuEventCreate(&dev.copy_event, CU_EVENT_DISABLE_TIMING));
+    }
+
+    cuda_check(cuEventRecord(dev.copy_event, ts->stream));
+    cuda_check(cuStreamWaitEvent(dev.copy_stream, dev.copy_event, 0));
+    return dev.copy_stream;
+}
+
+void jitc_copy_stream_end(ThreadState *ts) {
+    Device &dev = state.devices[ts->device];
+    cuda_check(cuEventRecord(dev.copy_event, dev.copy_stream));
+    cuda_check(cuStreamWaitEvent(ts->stream, dev.copy_event, 0));
+}
+
+/**
+ * \brief Stream host memory to the device through a ring of pinned buffers
+ *
+ * The host copies chunks into the staging buffers while the DMA engine
+ * transfers previous chunks on a separate copy stream, which also overlaps
+ * with kernels. The host only waits when a staging buffer is still in use. The
+ * thread's stream waits for the transfer via an event, the host doesn't.
+ */
+static void jitc_migrate_pipelined(ThreadState *ts, void *dst, const void *src,
+                                   size_t size) {
+    Device &dev = state.devices[ts->device];
+
+    if (!dev.copy_ring[0]) {
+        for (int i = 0; i < DRJIT_MIGRATE_RING_SIZE; ++i) {
+            cuda_check(cuMemAllocHost(&dev.copy_ring[i], DRJIT_MIGRATE_CHUNK_SIZE));
+            cuda_check(cuEventCreate(&dev.copy_ring_event[i], CU_EVENT_DISABLE_TIMING));
+        }
+    }
+
+    // The destination may be recycled memory still used by queued kernels
+    jitc_copy_stream_begin(ts);
+
+    uint32_t slot = 0;
+    for (size_t offset = 0; offset < size; offset += DRJIT_MIGRATE_CHUNK_SIZE) {
+        size_t chunk = std::min(size - offset, (size_t) DRJIT_MIGRATE_CHUNK_SIZE);
+
+        // Wait until the previous transfer out of this buffer has finished
+        cuda_check(cuEventSynchronize(dev.copy_ring_event[slot]));
+        memcpy(dev.copy_ring[slot], (const uint8_t *) src + offset, chunk);
+
+        cuda_check(cuMemcpyAsync((CUdeviceptr) ((uint8_t *) dst + offset),
+                                 (CUdeviceptr) dev.copy_ring[slot], chunk,
+                                 dev.copy_stream));
+        cuda_check(cuEventRecord(dev.copy_ring_event[slot], dev.copy_stream));
+
+        slot = (slot + 1) % DRJIT_MIGRATE_RING_SIZE;
+    }
+
+    // Subsequent work on the thread's stream waits for the transfer
+    jitc_copy_stream_end(ts);
 }
 
 void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
@@ -268,10 +1180,11 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
     if (unlikely(it == state.alloc_used.end()))
         jitc_raise("jit_malloc_migrate(): unknown address " DRJIT_PTR "!", (uintptr_t) ptr);
 
-    auto [size, src_type, device] = alloc_info_decode(it->second);
+    auto [size, src_type, device] = alloc_info_decode(it->second.info);
 
     JitBackend src_backend =
-        (src_type == AllocType::Device || src_type == AllocType::HostPinned)
+        (src_type == AllocType::Device || src_type == AllocType::HostPinned ||
+         src_type == AllocType::Managed)
             ? JitBackend::CUDA
             : JitBackend::LLVM;
 
@@ -294,11 +1207,14 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
     if ((src_type == AllocType::Host && dst_type == AllocType::HostAsync) ||
         (src_type == AllocType::HostAsync && dst_type == AllocType::Host)) {
         if (move) {
+            size_t requested = it->second.requested;
             state.alloc_usage[(int) src_type] -= size;
             state.alloc_usage[(int) dst_type] += size;
+            state.alloc_requested[(int) src_type] -= requested;
+            state.alloc_requested[(int) dst_type] += requested;
             state.alloc_allocated[(int) src_type] -= size;
             state.alloc_allocated[(int) dst_type] += size;
-            it.value() = alloc_info_encode(size, dst_type, device);
+            it.value().info = alloc_info_encode(size, dst_type, device);
             return ptr;
         } else {
             void *ptr_new = jitc_malloc(dst_type, size);
@@ -328,7 +1244,12 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
               alloc_type_name[(int) dst_type]);
 
     scoped_set_context guard(ts->context);
-    if (src_type == AllocType::Host) {
+    if (src_type == AllocType::Host &&
+        (dst_type == AllocType::Device || dst_type == AllocType::Managed) &&
+        size > DRJIT_MIGRATE_CHUNK_SIZE && !ts->graph_capture) {
+        // Large host -> device migration, stream through pinned buffers
+        jitc_migrate_pipelined(ts, ptr_new, ptr, size);
+    } else if (src_type == AllocType::Host) {
         // Host -> Device memory, create an intermediate host-pinned array
         void *tmp = jitc_malloc(AllocType::HostPinned, size);
         memcpy(tmp, ptr, size);
@@ -336,6 +1257,11 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
                                  (CUdeviceptr) tmp, size,
                                  ts->stream));
         jitc_free(tmp);
+    } else if (src_type == AllocType::Device && dst_type == AllocType::Device &&
+               device != ts->device) {
+        // Peer-to-peer transfer, ordered with respect to both devices
+        PeerCopy copy { ptr_new, ptr, size, ts->device, device };
+        jitc_memcpy_peer_async(&copy, 1);
     } else {
         cuda_check(cuMemcpyAsync((CUdeviceptr) ptr_new,
                                  (CUdeviceptr) ptr, size,
@@ -348,8 +1274,162 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
     return ptr_new;
 }
 
+/// Return cached blocks to the GPU / OS. They must no longer be in use.
+static void jitc_malloc_release(size_t size, AllocType type, int device,
+                                const std::vector<void *> &entries) {
+    switch (type) {
+        case AllocType::Device:
+            if (state.backends & (uint32_t) JitBackend::CUDA) {
+                const Device &dev = state.devices[device];
+                scoped_set_context guard2(dev.context);
+                if (dev.memory_pool) {
+                    for (void *ptr : entries)
+                        cuda_check(cuMemFreeAsync((CUdeviceptr) ptr, dev.stream));
+                } else {
+                    for (void *ptr : entries)
+                        cuda_check(cuMemFree((CUdeviceptr) ptr));
+                }
+            }
+            break;
+
+        case AllocType::Managed:
+            if (state.backends & (uint32_t) JitBackend::CUDA) {
+                const Device &dev = state.devices[device];
+                scoped_set_context guard2(dev.context);
+                for (void *ptr : entries)
+                    cuda_check(cuMemFree((CUdeviceptr) ptr));
+            }
+            break;
+
+        case AllocType::HostPinned:
+            if (state.backends & (uint32_t) JitBackend::CUDA) {
+                const Device &dev = state.devices[device];
+                scoped_set_context guard2(dev.context);
+                for (void *ptr : entries)
+                    cuda_check(cuMemFreeHost(ptr));
+            }
+            break;
+
+        case AllocType::Host:
+        case AllocType::HostAsync:
+            for (void *ptr : entries)
+                aligned_free(ptr, size, device == DRJIT_HUGEPAGE_DEVICE);
+            break;
+
+        default:
+            jitc_fail("jit_flush_malloc_cache(): unsupported allocation type!");
+    }
+}
+
 static bool jitc_flush_malloc_cache_warned = false;
 
+/// Is jitc_malloc_pressure() currently running?
+static bool jitc_malloc_pressure_active = false;
+
+/**
+ * \brief React to memory pressure while allocating 'size' bytes of 'type'
+ *
+ * Releases cached blocks of the given type, largest ones first, until at most
+ * 'target' bytes remain allocated. If that isn't possible, the application's
+ * memory pressure callback (if any) is invoked so that it can drop its own
+ * references to arrays.
+ */
+static void jitc_malloc_pressure(AllocType type, size_t size, size_t target) {
+    if (jitc_malloc_pressure_active)
+        return;
+    jitc_malloc_pressure_active = true;
+
+    size_t allocated = state.alloc_allocated[(int) type];
+
+    if (allocated > target) {
+        // Cached blocks might still be referenced by queued work
+        jitc_sync_all_devices();
+
+        AllocInfoMap trim;
+        size_t trim_count = 0, trim_size = 0;
+
+        /* Critical section */ {
+            lock_guard guard(state.alloc_free_lock);
+
+            std::vector<AllocInfo> keys;
+            for (auto &kv : state.alloc_free) {
+                auto [size_2, type_2, device_2] = alloc_info_decode(kv.first);
+                (void) size_2; (void) device_2;
+                if (type_2 == type && !kv.second.empty())
+                    keys.push_back(kv.first);
+            }
+
+            // The size occupies the high bits of 'AllocInfo'
+            std::sort(keys.begin(), keys.end(), std::greater<AllocInfo>());
+
+            for (AllocInfo key : keys) {
+                std::vector<void *> &list = state.alloc_free[key],
+                                    &out = trim[key];
+                size_t block_size = (size_t) (key >> 16);
+
+                while (!list.empty() && allocated > target) {
+                    out.push_back(list.back());
+                    list.pop_back();
+                    allocated -= block_size;
+                    trim_size += block_size;
+                    trim_count++;
+                }
+
+                if (allocated <= target)
+                    break;
+            }
+        }
+
+        /* Temporarily release the main lock */ {
+            unlock_guard guard(state.lock);
+            for (auto &kv : trim) {
+                auto [size_2, type_2, device_2] = alloc_info_decode(kv.first);
+                jitc_malloc_release(size_2, type_2, device_2, kv.second);
+            }
+        }
+
+        state.alloc_allocated[(int) type] -= trim_size;
+
+        if (trim_count)
+            jitc_log(Debug, "jit_malloc(): memory pressure, released %s of "
+                     "cached %s memory in %zu allocation%s.",
+                     jitc_mem_string(trim_size), alloc_type_name[(int) type],
+                     trim_count, trim_count > 1 ? "s" : "");
+    }
+
+    MemoryPressureCallback callback = state.alloc_pressure_callback;
+    void *payload = state.alloc_pressure_payload;
+
+    if (callback && state.alloc_allocated[(int) type] > target) {
+        unlock_guard guard(state.lock);
+        callback(type, size, payload);
+    }
+
+    jitc_malloc_pressure_active = false;
+}
+
+void jitc_set_huge_page_policy(HugePagePolicy policy, size_t threshold) {
+    if ((uint32_t) policy > (uint32_t) HugePagePolicy::Explicit)
+        jitc_raise("jit_set_huge_page_policy(): invalid policy!");
+
+    state.huge_page_policy = policy;
+    if (threshold)
+        state.huge_page_threshold =
+            std::max(threshold, (size_t) DRJIT_HUGEPAGE_SIZE);
+}
+
+/// Set a soft limit for the memory allocated for a given type
+void jitc_malloc_set_limit(AllocType type, size_t limit) {
+    if ((int) type >= (int) AllocType::Count)
+        jitc_raise("jit_malloc_set_limit(): invalid allocation type!");
+
+    state.alloc_limit[(int) type] = limit;
+
+    size_t target = limit - limit / 8;
+    if (limit && state.alloc_allocated[(int) type] > limit)
+        jitc_malloc_pressure(type, 0, target);
+}
+
 static ProfilerRegion profiler_region_flush_malloc_cache("jit_flush_malloc_cache");
 
 /// Release all unused memory to the GPU / OS
@@ -374,11 +1454,24 @@ void jitc_flush_malloc_cache(bool warn) {
 
     /* Critical section */ {
         lock_guard guard(state.alloc_free_lock);
+
+        // Drain the caches of all threads (they are protected by 'state.lock')
+        for (AllocThreadCache *cache : alloc_thread_caches) {
+            for (AllocMagazine &m : cache->magazines) {
+                if (m.count)
+                    jitc_alloc_magazine_spill(&m, m.count);
+            }
+        }
+
         alloc_free.swap(state.alloc_free);
     }
 
+    std::vector<std::pair<void *, AllocGrowable>> growable_free;
+    growable_free.swap(state.alloc_growable_free);
+
     size_t trim_count[(int) AllocType::Count] = { 0 },
-           trim_size [(int) AllocType::Count] = { 0 };
+           trim_size [(int) AllocType::Count] = { 0 },
+           huge_count = 0, huge_size = 0;
 
     /* Temporarily release the main lock */ {
         unlock_guard guard(state.lock);
@@ -390,39 +1483,21 @@ void jitc_flush_malloc_cache(bool warn) {
             trim_count[(int) type] += entries.size();
             trim_size[(int) type] += size * entries.size();
 
-            switch ((AllocType) type) {
-                case AllocType::Device:
-                    if (state.backends & (uint32_t) JitBackend::CUDA) {
-                        const Device &dev = state.devices[device];
-                        scoped_set_context guard2(dev.context);
-                        if (dev.memory_pool) {
-                            for (void *ptr : entries)
-                                cuda_check(cuMemFreeAsync((CUdeviceptr) ptr, dev.stream));
-                        } else {
-                            for (void *ptr : entries)
-                                cuda_check(cuMemFree((CUdeviceptr) ptr));
-                        }
-                    }
-                    break;
-
-                case AllocType::HostPinned:
-                    if (state.backends & (uint32_t) JitBackend::CUDA) {
-                        const Device &dev = state.devices[device];
-                        scoped_set_context guard2(dev.context);
-                        for (void *ptr : entries)
-                            cuda_check(cuMemFreeHost(ptr));
-                    }
-                    break;
+            if (device == DRJIT_HUGEPAGE_DEVICE &&
+                (type == AllocType::Host || type == AllocType::HostAsync)) {
+                huge_count += entries.size();
+                huge_size += size * entries.size();
+            }
 
-                case AllocType::Host:
-                case AllocType::HostAsync:
-                    for (void *ptr : entries)
-                        aligned_free(ptr, size);
-                    break;
+            jitc_malloc_release(size, type, device, entries);
+        }
 
-                default:
-                    jitc_fail("jit_flush_malloc_cache(): unsupported allocation type!");
-            }
+        for (auto &kv : growable_free) {
+            const AllocGrowable &g = kv.second;
+            scoped_set_context guard2(state.devices[g.device].context);
+            trim_count[(int) AllocType::Device]++;
+            trim_size[(int) AllocType::Device] += g.mapped;
+            jitc_malloc_release_growable(kv.first, g);
         }
     }
 
@@ -442,6 +1517,10 @@ void jitc_flush_malloc_cache(bool warn) {
                     alloc_type_name[i], jitc_mem_string(trim_size[i]),
                     trim_count[i], trim_count[i] > 1 ? "s" : "");
         }
+        if (huge_count)
+            jitc_log(Debug, " - (of which %s in %zu allocation%s used huge pages)",
+                     jitc_mem_string(huge_size), huge_count,
+                     huge_count > 1 ? "s" : "");
     }
 }
 
@@ -450,17 +1529,61 @@ AllocType jitc_malloc_type(void *ptr) {
     auto it = state.alloc_used.find((uintptr_t) ptr);
     if (unlikely(it == state.alloc_used.end()))
         jitc_raise("jit_malloc_type(): unknown address " DRJIT_PTR "!", (uintptr_t) ptr);
-    auto [size, type, device] = alloc_info_decode(it->second);
+    auto [size, type, device] = alloc_info_decode(it->second.info);
     (void) size; (void) device;
     return type;
 }
 
 /// Query the device associated with a memory allocation made using \ref jitc_malloc()
+bool jitc_malloc_prefetch_async(ThreadState *ts, const void *ptr, int device) {
+    auto it = state.alloc_used.find((uintptr_t) ptr);
+    if (it == state.alloc_used.end())
+        return false;
+
+    auto [size, type, device_2] = alloc_info_decode(it->second.info);
+    (void) size; (void) device_2;
+    if (type != AllocType::Managed || !state.devices[ts->device].managed_prefetch)
+        return false;
+
+    CUdevice target = device < 0 ? CU_DEVICE_CPU : state.devices[device].id;
+    cuda_check(cuMemPrefetchAsync((CUdeviceptr) ptr, it->second.requested,
+                                  target, ts->stream));
+    return true;
+}
+
+void jitc_malloc_prefetch(void *ptr, int device) {
+    auto it = state.alloc_used.find((uintptr_t) ptr);
+    if (unlikely(it == state.alloc_used.end()))
+        jitc_raise("jit_malloc_prefetch(): unknown address " DRJIT_PTR "!",
+                   (uintptr_t) ptr);
+
+    if (device >= (int) state.devices.size())
+        jitc_raise("jit_malloc_prefetch(): invalid device index %i!", device);
+
+    if (jitc_malloc_type(ptr) != AllocType::Managed)
+        return;
+
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    scoped_set_context guard(ts->context);
+    if (jitc_malloc_prefetch_async(ts, ptr, device))
+        jitc_trace("jit_malloc_prefetch(" DRJIT_PTR ", device=%i)",
+                   (uintptr_t) ptr, device);
+}
+
+AllocType jitc_malloc_var_type(JitBackend backend) {
+    if (backend != JitBackend::CUDA)
+        return AllocType::HostAsync;
+    else if (jitc_flags() & (uint32_t) JitFlag::ManagedMemory)
+        return AllocType::Managed;
+    else
+        return AllocType::Device;
+}
+
 int jitc_malloc_device(void *ptr) {
     auto it = state.alloc_used.find((uintptr_t) ptr);
     if (unlikely(it == state.alloc_used.end()))
         jitc_raise("jitc_malloc_device(): unknown address " DRJIT_PTR "!", (uintptr_t) ptr);
-    auto [size, type, device] = alloc_info_decode(it->second);
+    auto [size, type, device] = alloc_info_decode(it->second.info);
     (void) size;
 
     if (type == AllocType::Host || type == AllocType::HostAsync)
@@ -472,10 +1595,14 @@ int jitc_malloc_device(void *ptr) {
 void jitc_malloc_shutdown() {
     jitc_flush_malloc_cache(false);
 
+    for (auto &kv : state.alloc_profile.records)
+        free(kv.second.label);
+    state.alloc_profile = AllocProfile();
+
     size_t leak_count[(int) AllocType::Count] = { 0 },
            leak_size [(int) AllocType::Count] = { 0 };
     for (auto kv : state.alloc_used) {
-        auto [size, type, device] = alloc_info_decode(kv.second);
+        auto [size, type, device] = alloc_info_decode(kv.second.info);
         (void) device;
         leak_count[(int) type]++;
         leak_size[(int) type] += size;
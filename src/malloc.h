@@ -12,8 +12,10 @@
 #include <drjit-core/jit.h>
 #include <drjit-core/containers.h>
 #include "hash.h"
+#include <string>
 
 using AllocInfo = uint64_t;
+struct ThreadState;
 
 inline AllocInfo alloc_info_encode(size_t size, AllocType type, int device) {
     return (((uint64_t) size) << 16) + (((uint64_t) type) << 8) +
@@ -26,13 +28,84 @@ inline drjit::dr_tuple<size_t, AllocType, int> alloc_info_decode(AllocInfo value
                            (int) (value & 0xFF));
 }
 
+/// Describes a live allocation
+struct AllocUsed {
+    AllocInfo info;
+
+    /// Number of bytes that were requested (at most the allocation size)
+    size_t requested;
+};
+
+/// Describes a growable device allocation (see \ref jitc_malloc_reserve())
+struct AllocGrowable {
+    /// CUDA device owning the physical memory
+    int device;
+
+    /// Size of the reserved virtual address range
+    size_t reserved;
+
+    /// Prefix of the range that is backed by physical memory
+    size_t mapped;
+
+    /// Physical memory handles and their sizes, in address order
+    std::vector<uint64_t> handles;
+    std::vector<size_t> sizes;
+};
+
+/// Number of lifetime histogram bins (decades from 10 us to 10 s)
+#define DRJIT_ALLOC_PROFILE_BINS 8
+
+/// Origin of an allocation tracked via JitFlag::MallocProfile
+struct AllocProfileRecord {
+    /// Variable that produced the allocation (0 if unknown)
+    uint32_t index = 0;
+
+    /// High 64 bits of the hash of the kernel that produced it (0 if none)
+    uint64_t kernel_hash = 0;
+
+    /// Copy of the variable label (or nullptr)
+    char *label = nullptr;
+
+    /// Time of the allocation in microseconds
+    uint64_t time = 0;
+};
+
+/// Entry of a peak memory snapshot
+struct AllocProfileSnapshot {
+    size_t size;
+    uint32_t index;
+    uint64_t kernel_hash;
+    std::string label;
+};
+
+using AllocProfileMap =
+    tsl::robin_map<uintptr_t, AllocProfileRecord, UInt64Hasher>;
+
+/// State of the allocation profiler (see \ref jitc_malloc_profile())
+struct AllocProfile {
+    /// Origin of live allocations made while profiling
+    AllocProfileMap records;
+
+    /// Per type: all live allocations at the highest peak observed so far
+    std::vector<AllocProfileSnapshot> peak[(int) AllocType::Count];
+    size_t peak_usage[(int) AllocType::Count] { };
+
+    /// Per type: histogram of the lifetimes of released allocations
+    size_t lifetime_count[(int) AllocType::Count][DRJIT_ALLOC_PROFILE_BINS] { };
+    size_t lifetime_size[(int) AllocType::Count][DRJIT_ALLOC_PROFILE_BINS] { };
+};
+
 using AllocInfoMap = tsl::robin_map<AllocInfo, std::vector<void *>, UInt64Hasher>;
-using AllocUsedMap = tsl::robin_map<uintptr_t, AllocInfo, UInt64Hasher>;
+using AllocUsedMap = tsl::robin_map<uintptr_t, AllocUsed, UInt64Hasher>;
+using AllocGrowableMap = tsl::robin_map<uintptr_t, AllocGrowable, UInt64Hasher>;
 
 /// Round to the next power of two
 extern size_t round_pow2(size_t x);
 extern uint32_t round_pow2(uint32_t x);
 
+/// Round to the next size class of the memory allocator
+extern size_t round_size_class(size_t x, size_t align);
+
 /// Descriptive names for the various allocation types
 extern const char *alloc_type_name[(int) AllocType::Count];
 extern const char *alloc_type_name_short[(int) AllocType::Count];
@@ -40,6 +113,19 @@ extern const char *alloc_type_name_short[(int) AllocType::Count];
 /// Allocate the given flavor of memory
 extern void *jitc_malloc(AllocType type, size_t size) JIT_MALLOC;
 
+/**
+ * \brief Allocate 'size' bytes of memory that can later grow in place up to
+ * 'capacity' bytes via \ref jitc_malloc_grow()
+ *
+ * For device memory, this reserves a virtual address range and maps physical
+ * memory into it on demand. Other flavors of memory (and devices without
+ * virtual memory management) fall back to \ref jitc_malloc().
+ */
+extern void *jitc_malloc_reserve(AllocType type, size_t size, size_t capacity);
+
+/// Try to enlarge an allocation in place to 'size' bytes without copying it
+extern bool jitc_malloc_grow(void *ptr, size_t size);
+
 /// Release the given pointer
 extern void jitc_free(void *ptr);
 
@@ -58,5 +144,53 @@ extern AllocType jitc_malloc_type(void *ptr);
 /// Query the device associated with a memory allocation made using \ref jitc_malloc()
 extern int jitc_malloc_device(void *ptr);
 
+/// Prefetch a managed allocation to a device (or the host if 'device' < 0)
+extern void jitc_malloc_prefetch(void *ptr, int device);
+
+/**
+ * \brief Enqueue a prefetch of a managed allocation on the stream of \c ts
+ *
+ * Returns \c false without doing anything when \c ptr does not refer to the
+ * start of a managed allocation or when the device lacks support for
+ * prefetching. The caller must have set the CUDA context.
+ */
+extern bool jitc_malloc_prefetch_async(ThreadState *ts, const void *ptr,
+                                       int device);
+
+/// Memory flavor used to store evaluated variables (cf. JitFlag::ManagedMemory)
+extern AllocType jitc_malloc_var_type(JitBackend backend);
+
 /// Clear the peak memory usage statistics
 extern void jitc_malloc_clear_statistics();
+
+/// Record which variable/kernel produced an allocation (JitFlag::MallocProfile)
+extern void jitc_malloc_profile_tag(void *ptr, uint32_t index,
+                                    const char *label, uint64_t kernel_hash);
+
+/// Return a report of peak memory usage, lifetimes, and cached memory
+extern const char *jitc_malloc_profile();
+
+/// Configure the use of huge pages for large host allocations
+extern void jitc_set_huge_page_policy(HugePagePolicy policy, size_t threshold);
+
+/// Set a soft limit on the memory allocated for a given type
+extern void jitc_malloc_set_limit(AllocType type, size_t limit);
+
+/**
+ * \brief Allocate temporary memory from the arena of a thread state
+ *
+ * This is meant for buffers that are only needed by the work submitted during
+ * a single jitc_eval(). They are handed out by bumping an offset and become
+ * reusable once the work submitted before the next \ref jitc_temp_reset()
+ * has finished. Temporaries must not be passed to \ref jitc_free().
+ */
+extern void *jitc_temp_malloc(ThreadState *ts, AllocType type, size_t size);
+
+/// Recycle all temporaries of 'ts' once the work submitted so far has finished
+extern void jitc_temp_reset(ThreadState *ts);
+
+/// Release temporaries referenced by the previous CUDA graph after a new capture
+extern void jitc_temp_graph_end(ThreadState *ts);
+
+/// Release the arena of 'ts'. Requires that all of its work has finished.
+extern void jitc_temp_release(ThreadState *ts);
@@ -0,0 +1,199 @@
+/*
+    src/numa.cpp -- NUMA-aware memory placement and scheduling (LLVM backend)
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "numa.h"
+#include "internal.h"
+#include "log.h"
+#include <nanothread/nanothread.h>
+
+#if defined(__linux__)
+#  include <sched.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif
+
+NumaPolicy jitc_numa_policy = NumaPolicy::Default;
+uint32_t jitc_numa_nodes = 1;
+
+#if defined(__linux__)
+/// Has the topology been detected?
+static bool jitc_numa_detected = false;
+
+/// OS identifiers of the detected nodes
+static std::vector<uint32_t> jitc_numa_node_id;
+
+/// CPUs associated with each detected node, and with all of them
+static std::vector<cpu_set_t> jitc_numa_cpus;
+static cpu_set_t jitc_numa_cpus_all;
+
+/// Maps CPU indices to (detected) node indices
+static std::vector<uint32_t> jitc_numa_cpu_node;
+
+/// Incremented whenever the policy changes, so that workers update pinning
+static std::atomic<uint32_t> jitc_numa_generation { 1 };
+
+static __thread uint32_t jitc_numa_thread_generation = 0;
+static __thread uint32_t jitc_numa_thread_node_v = 0;
+static __thread bool jitc_numa_thread_pinned = false;
+
+// Avoid a dependency on libnuma
+#define DRJIT_MPOL_INTERLEAVE 3
+
+/// Parse a list like "0-15,32-47" from a sysfs file into 'set'
+static bool jitc_numa_parse_list(const char *path, cpu_set_t &set) {
+    CPU_ZERO(&set);
+    bool found = false;
+
+    char buf[1024];
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    size_t size = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[size] = '\0';
+
+    const char *str = buf;
+
+    while (*str) {
+        char *end = nullptr;
+        unsigned long start = strtoul(str, &end, 10), stop = start;
+        if (end == str)
+            break;
+        str = end;
+        if (*str == '-') {
+            stop = strtoul(str + 1, &end, 10);
+            str = end;
+        }
+        for (unsigned long i = start; i <= stop && i < CPU_SETSIZE; ++i) {
+            CPU_SET(i, &set);
+            found = true;
+        }
+        if (*str == ',')
+            str++;
+        else
+            break;
+    }
+
+    return found;
+}
+
+static void jitc_numa_detect() {
+    if (jitc_numa_detected)
+        return;
+    jitc_numa_detected = true;
+
+    CPU_ZERO(&jitc_numa_cpus_all);
+
+    cpu_set_t online;
+    if (!jitc_numa_parse_list("/sys/devices/system/node/online", online))
+        return;
+
+    char path[64];
+    for (uint32_t id = 0; id < CPU_SETSIZE; ++id) {
+        if (!CPU_ISSET(id, &online))
+            continue;
+
+        cpu_set_t set;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", id);
+        if (!jitc_numa_parse_list(path, set))
+            continue; // Memory-only node
+
+        uint32_t node = (uint32_t) jitc_numa_node_id.size();
+        for (uint32_t i = 0; i < CPU_SETSIZE; ++i) {
+            if (!CPU_ISSET(i, &set))
+                continue;
+            if (jitc_numa_cpu_node.size() <= i)
+                jitc_numa_cpu_node.resize(i + 1, 0);
+            jitc_numa_cpu_node[i] = node;
+            CPU_SET(i, &jitc_numa_cpus_all);
+        }
+
+        jitc_numa_node_id.push_back(id);
+        jitc_numa_cpus.push_back(set);
+    }
+
+    jitc_numa_nodes = std::max((uint32_t) jitc_numa_node_id.size(), 1u);
+    jitc_log(Info, "jit_llvm_set_numa_policy(): detected %u NUMA node%s.",
+             jitc_numa_nodes, jitc_numa_nodes > 1 ? "s" : "");
+}
+
+void jitc_numa_set_policy(NumaPolicy policy) {
+    if ((uint32_t) policy > (uint32_t) NumaPolicy::Local)
+        jitc_raise("jit_llvm_set_numa_policy(): invalid policy!");
+
+    jitc_numa_detect();
+    jitc_numa_policy = policy;
+    jitc_numa_generation++;
+}
+
+uint32_t jitc_numa_node_count() {
+    jitc_numa_detect();
+    return jitc_numa_nodes;
+}
+
+void jitc_numa_advise(void *ptr, size_t size) {
+    if (jitc_numa_policy != NumaPolicy::Interleave || jitc_numa_nodes < 2)
+        return;
+
+    unsigned long mask[CPU_SETSIZE / (8 * sizeof(unsigned long))] { };
+    for (uint32_t id : jitc_numa_node_id)
+        mask[id / (8 * sizeof(unsigned long))] |=
+            1ul << (id % (8 * sizeof(unsigned long)));
+
+    if (syscall(SYS_mbind, ptr, size, DRJIT_MPOL_INTERLEAVE, mask,
+                sizeof(mask) * 8, 0) != 0)
+        jitc_log(Debug, "jit_malloc(): mbind() failed, memory will not be "
+                 "interleaved.");
+}
+
+uint32_t jitc_numa_thread_node() {
+    if (jitc_numa_nodes < 2)
+        return 0;
+
+    uint32_t generation = jitc_numa_generation.load(std::memory_order_relaxed);
+    if (likely(jitc_numa_thread_generation == generation))
+        return jitc_numa_thread_node_v;
+
+    uint32_t id = pool_thread_id();
+    if (id == 0) {
+        // Not a worker thread: leave its affinity alone
+        int cpu = sched_getcpu();
+        return (cpu >= 0 && (size_t) cpu < jitc_numa_cpu_node.size())
+                   ? jitc_numa_cpu_node[cpu] : 0;
+    }
+
+    uint32_t node = 0;
+    if (jitc_numa_policy == NumaPolicy::Local) {
+        node = (id - 1) % jitc_numa_nodes;
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &jitc_numa_cpus[node]) == 0)
+            jitc_numa_thread_pinned = true;
+        else
+            jitc_log(Debug, "jit_llvm_set_numa_policy(): could not pin "
+                     "worker %u to node %u.", id, jitc_numa_node_id[node]);
+    } else if (jitc_numa_thread_pinned) {
+        // Undo a previous pinning
+        sched_setaffinity(0, sizeof(cpu_set_t), &jitc_numa_cpus_all);
+        jitc_numa_thread_pinned = false;
+    }
+
+    jitc_numa_thread_node_v = node;
+    jitc_numa_thread_generation = generation;
+    return node;
+}
+#else
+void jitc_numa_set_policy(NumaPolicy policy) {
+    if ((uint32_t) policy > (uint32_t) NumaPolicy::Local)
+        jitc_raise("jit_llvm_set_numa_policy(): invalid policy!");
+    jitc_numa_policy = policy;
+}
+
+uint32_t jitc_numa_node_count() { return 1; }
+void jitc_numa_advise(void *, size_t) { }
+uint32_t jitc_numa_thread_node() { return 0; }
+#endif
@@ -0,0 +1,92 @@
+/*
+    src/numa.h -- NUMA-aware memory placement and scheduling (LLVM backend)
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <drjit-core/jit.h>
+#include <atomic>
+
+/// Max. number of NUMA nodes considered by the block scheduler
+#define DRJIT_NUMA_MAX_NODES 16
+
+/// Currently active NUMA policy
+extern NumaPolicy jitc_numa_policy;
+
+/// Number of detected NUMA nodes (1 on non-NUMA machines)
+extern uint32_t jitc_numa_nodes;
+
+/// Change the NUMA policy (detects the topology the first time)
+extern void jitc_numa_set_policy(NumaPolicy policy);
+
+/// Return the number of NUMA nodes (detects the topology the first time)
+extern uint32_t jitc_numa_node_count();
+
+/// Apply the NUMA policy to a fresh (not yet touched) mmap()-ed region
+extern void jitc_numa_advise(void *ptr, size_t size);
+
+/**
+ * \brief Return the NUMA node of the calling thread
+ *
+ * With <tt>NumaPolicy::Local</tt>, thread pool workers are pinned to the CPUs
+ * of a node (in round-robin order) the first time they call this function.
+ */
+extern uint32_t jitc_numa_thread_node();
+
+/**
+ * \brief Block-to-node assignment of a parallel kernel launch
+ *
+ * The blocks of a kernel are split into contiguous per-node ranges. Workers
+ * first claim blocks from the range of their own node, and steal from other
+ * nodes once it is exhausted. Since a given array index is always processed
+ * on the same node, first-touch page placement keeps memory node-local across
+ * subsequent kernels.
+ *
+ * The schedule is stored in the task payload, which the thread pool copies
+ * bytewise. This is fine since the atomic counters are lock-free integers.
+ */
+struct NumaSchedule {
+    uint32_t nodes;
+    uint32_t blocks;
+    std::atomic<uint32_t> next[DRJIT_NUMA_MAX_NODES];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+              sizeof(NumaSchedule) % sizeof(void *) == 0,
+              "NumaSchedule: unexpected layout!");
+
+/// Initialize a schedule for 'blocks' blocks
+inline void jitc_numa_schedule_init(NumaSchedule *s, uint32_t blocks) {
+    uint32_t nodes = jitc_numa_nodes < DRJIT_NUMA_MAX_NODES
+                         ? jitc_numa_nodes
+                         : (uint32_t) DRJIT_NUMA_MAX_NODES;
+    s->nodes = nodes;
+    s->blocks = blocks;
+    for (uint32_t i = 0; i < nodes; ++i)
+        s->next[i].store((uint32_t) ((uint64_t) blocks * i / nodes),
+                         std::memory_order_relaxed);
+}
+
+/// Claim the next block to be processed by a worker on node 'node'
+inline uint32_t jitc_numa_schedule_claim(NumaSchedule *s, uint32_t node) {
+    for (uint32_t i = 0; i < s->nodes; ++i) {
+        uint32_t n = (node + i) % s->nodes,
+                 end = (uint32_t) ((uint64_t) s->blocks * (n + 1) / s->nodes);
+
+        // Counters only grow, hence exhausted ranges can be skipped safely
+        if (s->next[n].load(std::memory_order_relaxed) >= end)
+            continue;
+
+        uint32_t index = s->next[n].fetch_add(1, std::memory_order_relaxed);
+        if (index < end)
+            return index;
+    }
+
+    // Unreachable: every task invocation claims exactly one block
+    return (uint32_t) -1;
+}
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "eval.h"
 #include "op.h"
+#include "malloc.h"
 
 #if defined(_MSC_VER)
 #  pragma warning (disable: 4702) // unreachable code
@@ -31,7 +32,7 @@ struct VarInfo {
     VarType type;
 
     /// Output size given the size of the operands
-    uint32_t size;
+    size_t size;
 
     /// Should Dr.Jit try to simplify the operation? (if some operands are literals)
     bool simplify;
@@ -76,7 +77,7 @@ auto jitc_var_check_impl(const char *name, std::index_sequence<Is...>, Args... a
 
     JitBackend backend = JitBackend::Invalid;
     VarType type = VarType::Void;
-    uint32_t size = 0;
+    size_t size = 0;
     const char *err = nullptr;
 
     for (uint32_t i = 0; i < Size; ++i) {
@@ -164,7 +165,7 @@ auto jitc_var_check_impl(const char *name, std::index_sequence<Is...>, Args... a
         for (uint32_t i = 0; i < Size; ++i) {
             if (unlikely(v[i]->size != size && v[i]->size != 1)) {
                 err = "operands have incompatible sizes";
-                size = (uint32_t) -1;
+                size = (size_t) -1;
                 goto fail;
             }
         }
@@ -185,10 +186,10 @@ fail:
         buffer.fmt("r%u%s", dep[i], i + 1 < Size ? ", " : "");
     buffer.fmt("): %s!", err);
 
-    if (size == (uint32_t) -1) {
+    if (size == (size_t) -1) {
         buffer.put(" (sizes: ");
         for (uint32_t i = 0; i < Size; ++i)
-            buffer.fmt("%u%s", dep[i] ? jitc_var(dep[i])->size : 0,
+            buffer.fmt("%zu%s", dep[i] ? jitc_var(dep[i])->size : 0,
                        i + 1 < Size ? ", " : "");
         buffer.put(")");
     }
@@ -221,6 +222,62 @@ template <typename Type> uint64_t v2i(Type value) {
     return result;
 }
 
+float jitc_half_to_float(uint64_t value) {
+    uint32_t h = (uint32_t) value,
+             sign = (h & 0x8000u) << 16,
+             exp = (h >> 10) & 0x1Fu,
+             mant = h & 0x3FFu,
+             bits;
+
+    if (exp == 0x1F) {
+        bits = sign | 0x7F800000u | (mant << 13); // Infinity or NaN
+    } else if (exp) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    } else {
+        // Zero or denormal (mant * 2^-24)
+        float f = (float) mant * 5.9604644775390625e-8f;
+        memcpy(&bits, &f, sizeof(float));
+        bits |= sign;
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
+uint64_t jitc_float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    uint32_t sign = (bits >> 16) & 0x8000u,
+             abs = bits & 0x7FFFFFFFu,
+             h;
+
+    if (abs >= 0x7F800000u) {
+        h = abs > 0x7F800000u ? 0x7E00u : 0x7C00u; // NaN or infinity
+    } else if (abs >= 0x477FF000u) {
+        h = 0x7C00u; // Rounds to a value >= 65520, i.e. overflows
+    } else if (abs < 0x38800000u) {
+        // Denormal half: scale by 2^24 (exact) and round to nearest even
+        float f;
+        memcpy(&f, &abs, sizeof(float));
+        h = (uint32_t) std::nearbyint(f * 16777216.f);
+    } else {
+        // Rebias the exponent and round the mantissa to nearest even
+        h = (abs - (112u << 23) + 0xFFFu + ((abs >> 13) & 1u)) >> 13;
+    }
+
+    return sign | h;
+}
+
+// Variant of v2i() that rounds single precision results to half precision
+template <typename Type> uint64_t v2i_half(Type value) {
+    if constexpr (std::is_same_v<Type, float>)
+        return jitc_float_to_half(value);
+    else
+        return v2i(value);
+}
+
 template <typename Dst, typename Src>
 Dst memcpy_cast(const Src &src) {
     static_assert(sizeof(Src) == sizeof(Dst), "memcpy_cast: size mismatch!");
@@ -246,6 +303,8 @@ JIT_INLINE uint32_t jitc_eval_literal(const VarInfo &info, Func func,
         case VarType::UInt32:  r = v2i(func(i2v<uint32_t>(args->literal)...)); break;
         case VarType::Int64:   r = v2i(func(i2v< int64_t>(args->literal)...)); break;
         case VarType::UInt64:  r = v2i(func(i2v<uint64_t>(args->literal)...)); break;
+        // Half precision literals are evaluated in single precision
+        case VarType::Float16: r = v2i_half(func(jitc_half_to_float(args->literal)...)); break;
         case VarType::Float32: r = v2i(func(i2v<   float>(args->literal)...)); break;
         case VarType::Float64: r = v2i(func(i2v<  double>(args->literal)...)); break;
         default: jitc_fail("jit_eval_literal(): unsupported variable type!");
@@ -1385,6 +1444,7 @@ uint32_t jitc_var_cast(uint32_t a0, VarType target_type, int reinterpret) {
                     case VarType::UInt32:  return v2i((uint32_t) value);
                     case VarType::Int64:   return v2i((int64_t) value);
                     case VarType::UInt64:  return v2i((uint64_t) value);
+                    case VarType::Float16: return jitc_float_to_half((float) value);
                     case VarType::Float32: return v2i((float) value);
                     case VarType::Float64: return v2i((double) value);
                     default: jitc_fail("jit_var_cast(): unsupported variable type!");
@@ -1423,7 +1483,7 @@ static uint32_t jitc_scatter_gather_index(uint32_t source, uint32_t index) {
 
 /// Change all indices/counters in an expression tree to 'new_index'
 static uint32_t jitc_var_reindex(uint32_t var_index, uint32_t new_index,
-                                 uint32_t mask, uint32_t size) {
+                                 uint32_t mask, size_t size) {
     Variable *v = jitc_var(var_index);
 
     if (v->is_data() || (VarType) v->type == VarType::Void)
@@ -1475,16 +1535,7 @@ static uint32_t jitc_var_reindex(uint32_t var_index, uint32_t new_index,
         v2.size = size;
         v2.optix = v->optix;
         v2.placeholder = v->placeholder;
-        if (v->is_stmt()) {
-            if (!v->free_stmt) {
-                v2.stmt = v->stmt;
-            } else {
-                v2.stmt = strdup(v->stmt);
-                v2.free_stmt = 1;
-            }
-        } else {
-            v2.literal = v->literal;
-        }
+        v2.literal = v->literal;
         for (uint32_t i = 0; i < 4; ++i) {
             v2.dep[i] = dep[i];
             jitc_var_inc_ref(dep[i]);
@@ -1798,13 +1849,73 @@ uint32_t jitc_var_scatter(uint32_t target_, uint32_t value, uint32_t index,
     return target.release();
 }
 
+uint32_t jitc_var_compact(uint32_t mask, uint32_t n, const uint32_t *in,
+                          uint32_t *out) {
+    auto [var_info, mask_v] = jitc_var_check("jit_var_compact", mask);
+
+    if ((VarType) mask_v->type != VarType::Bool)
+        jitc_raise("jit_var_compact(): the mask must be a boolean array!");
+
+    JitBackend backend = var_info.backend;
+    size_t size = var_info.size;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        const Variable *v = jitc_var(in[i]);
+        if ((JitBackend) v->backend != backend)
+            jitc_raise("jit_var_compact(): the mask and arrays must use the "
+                       "same backend!");
+        if (v->size != size && v->size != 1 && size != 1)
+            jitc_raise("jit_var_compact(): arrays have incompatible sizes "
+                       "(%zu and %zu)!", size, v->size);
+        size = std::max(size, v->size);
+    }
+
+    // The slots are obtained from a 32-bit counter
+    if (unlikely(size > (size_t) UINT32_MAX))
+        jitc_raise("jit_var_compact(): arrays with more than 2^32-1 entries "
+                   "are not supported (size=%zu)!", size);
+
+    /* Every surviving entry requests a slot from a counter (aggregated per
+       warp/packet, see jitc_*_render_scatter_inc()), which is then shared by
+       the scatters of all arrays. Everything ends up in a single kernel. */
+    uint32_t zero = 0, counter =
+        jitc_var_literal(backend, VarType::UInt32, &zero, 1, 1);
+    uint32_t i = 0;
+
+    try {
+        Ref index = steal(jitc_var_literal(backend, VarType::UInt32, &zero, 1, 0)),
+            slot = steal(jitc_var_scatter_inc(&counter, index, mask));
+
+        AllocType atype = backend == JitBackend::CUDA ? AllocType::Device
+                                                      : AllocType::HostAsync;
+
+        for (; i < n; ++i) {
+            VarType vt = (VarType) jitc_var(in[i])->type;
+            void *ptr = jitc_malloc(atype, (size_t) size * type_size[(int) vt]);
+            Ref target = steal(jitc_var_mem_map(backend, vt, ptr, size, 1));
+            out[i] = jitc_var_scatter(target, in[i], slot, mask, ReduceOp::None);
+        }
+    } catch (...) {
+        jitc_var_dec_ref(counter);
+        for (uint32_t j = 0; j < i; ++j) {
+            jitc_var_dec_ref(out[j]);
+            out[j] = 0;
+        }
+        throw;
+    }
+
+    jitc_log(Debug, "jit_var_compact(r%u, n=%u): counter=r%u", mask, n, counter);
+
+    return counter;
+}
+
 // --------------------------------------------------------------------------
 
 void jitc_var_printf(JitBackend backend, uint32_t mask, const char *fmt,
                      uint32_t narg, const uint32_t *arg) {
     ThreadState *ts = thread_state(backend);
     bool dirty, placeholder;
-    uint32_t size;
+    size_t size;
 
     {
         Variable *mask_v = jitc_var(mask);
@@ -1922,3 +2033,38 @@ uint32_t jitc_var_op(JitOp op, const uint32_t *dep) {
     }
 }
 
+void jitc_var_op_batch(uint32_t size, const JitBatchOp *ops, uint32_t *out) {
+    // Grow the variable storage and LVN hash table once for the program
+    size_t unused = state.unused_variables.size();
+    if (size > unused)
+        state.variables.reserve(state.variables.size() + (size - unused) + 1);
+    state.lvn_map.reserve(state.lvn_map.size() + size);
+
+    uint32_t i = 0;
+    try {
+        for (; i < size; ++i) {
+            const JitBatchOp &o = ops[i];
+            uint32_t dep[3];
+
+            for (uint32_t j = 0; j < 3; ++j) {
+                uint32_t index = o.dep[j];
+                if (index & JIT_BATCH_RESULT(0)) {
+                    index &= ~JIT_BATCH_RESULT(0);
+                    if (unlikely(index >= i))
+                        jitc_raise("jit_var_op_batch(): operation %u refers "
+                                   "to the result of operation %u, which "
+                                   "does not precede it!", i, index);
+                    index = out[index];
+                }
+                dep[j] = index;
+            }
+
+            out[i] = jitc_var_op(o.op, dep);
+        }
+    } catch (...) {
+        for (uint32_t j = 0; j < i; ++j)
+            jitc_var_dec_ref(out[j]);
+        throw;
+    }
+}
+
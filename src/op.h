@@ -14,6 +14,10 @@
 /// Create a variable representing the result of a standard operation
 extern uint32_t jitc_var_op(JitOp ot, const uint32_t *dep);
 
+/// Create the variables of a small SSA program (see jit_var_op_batch())
+extern void jitc_var_op_batch(uint32_t size, const JitBatchOp *ops,
+                              uint32_t *out);
+
 // Asynchronously print to the screen
 extern void jitc_var_printf(JitBackend backend, uint32_t mask,
                             const char *fmt, uint32_t narg,
@@ -36,11 +40,21 @@ extern void jitc_var_scatter_reduce_kahan(uint32_t *target_1,
 /// Atomic scatter-increment
 extern uint32_t jitc_var_scatter_inc(uint32_t *target, uint32_t index, uint32_t mask);
 
+/// Stream compaction of several arrays in a single kernel
+extern uint32_t jitc_var_compact(uint32_t mask, uint32_t n, const uint32_t *in,
+                                 uint32_t *out);
+
 /// Perform an ordinary or reinterpreting cast of the variable 'index'
 extern uint32_t jitc_var_cast(uint32_t index, VarType target_type,
                               int reinterpret);
 
 
+/// Convert a half precision value (stored in the low 16 bits) to single precision
+extern float jitc_half_to_float(uint64_t value);
+
+/// Convert a single precision value to half precision (round to nearest even)
+extern uint64_t jitc_float_to_half(float value);
+
 // Common unary operations
 extern uint32_t jitc_var_neg(uint32_t a0);
 extern uint32_t jitc_var_not(uint32_t a0);
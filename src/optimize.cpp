@@ -0,0 +1,237 @@
+/*
+    src/optimize.cpp -- Optimization pass over scheduled variables
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "optimize.h"
+#include "internal.h"
+#include "var.h"
+#include "log.h"
+#include "traverse.h"
+
+/// Maps value numbering keys to the first variable that computes them
+static LVNMap gvn_map;
+
+/// Maps elided variables to an equivalent variable that is not elided
+static tsl::robin_map<uint32_t, uint32_t, UInt32Hasher> gvn_rep;
+
+/// Variables that are referenced by generated code
+static VisitedSet gvn_live;
+
+static uint32_t jitc_optimize_rep(uint32_t index) {
+    auto it = gvn_rep.find(index);
+    return it == gvn_rep.end() ? index : it->second;
+}
+
+bool jitc_optimize_opaque(uint32_t index, const Variable *v) {
+    if (v->side_effect || v->placeholder || v->vcall_iface || v->optix ||
+        v->write_ptr)
+        return true;
+
+    switch ((VarKind) v->kind) {
+        case VarKind::Nop:
+        case VarKind::Scatter:
+        case VarKind::ScatterInc:
+        case VarKind::ScatterKahan:
+        case VarKind::Printf:
+        case VarKind::Dispatch:
+        case VarKind::TexLookup:
+        case VarKind::TexFetchBilerp:
+        case VarKind::TraceRay:
+        case VarKind::Copy:
+        case VarKind::LoopPhi:
+            return true;
+
+        default:
+            break;
+    }
+
+    if (unlikely(v->extra)) {
+        // Descriptive labels are fine, anything else is not
+        auto it = state.extra.find(index);
+        if (it == state.extra.end())
+            jitc_fail("jit_optimize(): could not find matching 'extra' record!");
+        const Extra &extra = it->second;
+        if (extra.assemble || extra.callback_data || extra.n_dep)
+            return true;
+    }
+
+    return false;
+}
+
+/// Check if 'v' is a literal constant with the given (bit-level) value
+static bool jitc_optimize_is_literal(const Variable *v, uint64_t value) {
+    return v->is_literal() && v->literal == value;
+}
+
+/// Return a variable that computes the same value as 'v', or zero
+static uint32_t jitc_optimize_simplify(const Variable *v) {
+    uint32_t dep[3];
+    const Variable *d[3];
+    for (int i = 0; i < 3; ++i) {
+        dep[i] = jitc_optimize_rep(v->dep[i]);
+        d[i] = dep[i] ? jitc_var(dep[i]) : nullptr;
+    }
+
+    if (!d[0] || !d[1])
+        return 0;
+
+    VarType vt = (VarType) v->type;
+    bool same_type = d[0]->type == v->type && d[1]->type == v->type,
+         is_int = same_type && jitc_is_int(vt),
+         is_bits = same_type && (jitc_is_int(vt) || jitc_is_bool(vt));
+
+    uint32_t result = 0;
+
+    switch ((VarKind) v->kind) {
+        case VarKind::And:
+        case VarKind::Or:
+        case VarKind::Min:
+        case VarKind::Max:
+            if (same_type && dep[0] == dep[1])
+                result = dep[0];  // x & x == x
+            else if ((VarKind) v->kind == VarKind::Or && is_bits)
+                result = jitc_optimize_is_literal(d[1], 0) ? dep[0] :
+                         jitc_optimize_is_literal(d[0], 0) ? dep[1] : 0;
+            break;
+
+        case VarKind::Add:
+        case VarKind::Xor:
+            if (is_int || (is_bits && (VarKind) v->kind == VarKind::Xor))
+                result = jitc_optimize_is_literal(d[1], 0) ? dep[0] :
+                         jitc_optimize_is_literal(d[0], 0) ? dep[1] : 0;
+            break;
+
+        case VarKind::Sub:
+        case VarKind::Shl:
+        case VarKind::Shr:
+            // Note: x - (+0.0) == x also holds for floating point values
+            if ((is_int || (same_type && (VarKind) v->kind == VarKind::Sub)) &&
+                jitc_optimize_is_literal(d[1], 0))
+                result = dep[0];
+            break;
+
+        case VarKind::Mul:
+            if (is_int)
+                result = jitc_optimize_is_literal(d[1], 1) ? dep[0] :
+                         jitc_optimize_is_literal(d[0], 1) ? dep[1] : 0;
+            break;
+
+        case VarKind::Select:
+            if (!d[2] || d[1]->type != v->type || d[2]->type != v->type)
+                break;
+            if (dep[1] == dep[2])
+                result = dep[1];
+            else if (jitc_optimize_is_literal(d[0], 1))
+                result = dep[1];
+            else if (jitc_optimize_is_literal(d[0], 0))
+                result = dep[2];
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
+
+uint32_t jitc_optimize_group(const ScheduledGroup &group) {
+    gvn_map.clear();
+    gvn_rep.clear();
+
+    /* Custom code generation callbacks (loops, etc.) introduce control flow
+       and may reference variables that aren't listed as dependencies. In
+       that case, scopes must be respected and dead code elimination is
+       unsafe. Otherwise, the kernel is straight-line code where every
+       variable dominates the ones following it. */
+    bool opaque = false;
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        uint32_t index = schedule[gi].index;
+        const Variable *v = jitc_var(index);
+        if (v->extra && jitc_optimize_opaque(index, v)) {
+            opaque = true;
+            break;
+        }
+    }
+
+    uint32_t n_merged = 0, n_simplified = 0, n_dead = 0;
+
+    // 1. Value numbering and algebraic simplification
+    for (uint32_t gi = group.start; gi != group.end; ++gi) {
+        uint32_t index = schedule[gi].index;
+        const Variable *v = jitc_var(index);
+        VariableScratch *vs = jitc_var_scratch(v);
+
+        if (vs->param_type == ParamType::Input || jitc_optimize_opaque(index, v))
+            continue;
+
+        uint32_t target = jitc_optimize_simplify(v);
+        bool simplified = target != 0;
+
+        if (!simplified) {
+            VariableKey key(*v);
+            for (int i = 0; i < 4; ++i)
+                key.dep[i] = jitc_optimize_rep(v->dep[i]);
+            if (!opaque)
+                key.scope = 0;
+
+            auto result = gvn_map.try_emplace(key, index);
+            if (result.second)
+                continue;
+            target = result.first.value();
+        }
+
+        // Outputs are still needed, but can be the target of other variables
+        if (vs->param_type == ParamType::Output)
+            continue;
+
+        if (simplified)
+            n_simplified++;
+        else
+            n_merged++;
+
+        gvn_rep[index] = target;
+        vs->reg_index = jitc_var_scratch(jitc_var(target))->reg_index;
+        vs->elide = true;
+    }
+
+    // 2. Dead code elimination
+    if (!opaque) {
+        gvn_live.clear();
+
+        for (uint32_t gi = group.end; gi != group.start; --gi) {
+            uint32_t index = schedule[gi - 1].index;
+            const Variable *v = jitc_var(index);
+            VariableScratch *vs = jitc_var_scratch(v);
+
+            if (vs->elide)
+                continue;
+
+            if (vs->param_type == ParamType::Register &&
+                (VarType) v->type != VarType::Void && !v->side_effect &&
+                !gvn_live.contains(index)) {
+                vs->elide = true;
+                n_dead++;
+                continue;
+            }
+
+            for (int i = 0; i < 4; ++i) {
+                if (v->dep[i])
+                    gvn_live.insert(jitc_optimize_rep(v->dep[i]));
+            }
+        }
+    }
+
+    uint32_t n_elided = (uint32_t) gvn_rep.size() + n_dead;
+    if (n_elided)
+        jitc_log(Debug,
+                 "jit_optimize(): elided %u/%u variables (%u merged, %u "
+                 "simplified, %u dead).", n_elided, group.end - group.start,
+                 n_merged, n_simplified, n_dead);
+
+    return n_elided;
+}
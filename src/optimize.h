@@ -0,0 +1,39 @@
+/*
+    src/optimize.h -- Optimization pass over scheduled variables
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "eval.h"
+
+/**
+ * \brief Does the code generated for a variable depend on more than its kind,
+ * type, dependencies, and literal?
+ *
+ * This is the case for custom code generation, side effects, and for
+ * variables that reference other variables via their 'Extra' record. Such
+ * variables can neither be merged nor moved to another kernel.
+ */
+extern bool jitc_optimize_opaque(uint32_t index, const Variable *v);
+
+/**
+ * \brief Optimize the variables of a kernel before generating code
+ *
+ * Used by jitc_assemble() when \ref JitFlag::KernelOptimize is set. The pass
+ * performs global value numbering (which, unlike \ref JitFlag::ValueNumbering,
+ * also merges equivalent variables from different scopes), simple algebraic
+ * simplification, and dead code elimination.
+ *
+ * The computation graph is not modified: a redundant variable instead takes
+ * over the register of an equivalent variable, and the code generators skip
+ * variables marked via \ref VariableScratch::elide. Must be called after
+ * register indices and parameter types have been assigned.
+ *
+ * Returns the number of elided variables.
+ */
+extern uint32_t jitc_optimize_group(const ScheduledGroup &group);
@@ -42,6 +42,15 @@ extern uint32_t jitc_optix_configure_sbt(const OptixShaderBindingTable *sbt,
 /// Overwrite existing OptiX Shader Binding Table given an index
 extern void jitc_optix_update_sbt(uint32_t index, const OptixShaderBindingTable *sbt);
 
+/// Overwrite a range of records of an existing Shader Binding Table
+extern void jitc_optix_update_sbt_records(uint32_t index, int miss,
+                                          uint32_t offset, uint32_t count,
+                                          const void *records);
+
+/// Upload pending record updates of a Shader Binding Table
+extern void jitc_optix_flush_sbt(ThreadState *ts,
+                                 const OptixShaderBindingTable *sbt);
+
 /// Insert a function call to optixTrace into the program
 extern void jitc_optix_ray_trace(uint32_t nargs, uint32_t *args, uint32_t mask,
                                  uint32_t pipeline, uint32_t sbt);
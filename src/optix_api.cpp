@@ -157,6 +157,9 @@ bool jitc_optix_api_init() {
     LOAD(optixDeviceContextDestroy);
     LOAD(optixDeviceContextSetCacheEnabled);
     LOAD(optixDeviceContextSetCacheLocation);
+    LOAD(optixDeviceContextSetCacheDatabaseSizes);
+    LOAD(optixDeviceContextGetCacheEnabled);
+    LOAD(optixDeviceContextGetCacheDatabaseSizes);
     LOAD(optixModuleCreateFromPTX);
     LOAD(optixModuleCreateFromPTXWithTasks);
     LOAD(optixModuleGetCompilationState);
@@ -197,7 +200,10 @@ void jitc_optix_api_shutdown() {
     #define Z(x) x = nullptr
     Z(optixGetErrorName); Z(optixGetErrorString); Z(optixDeviceContextCreate);
     Z(optixDeviceContextDestroy); Z(optixDeviceContextSetCacheEnabled);
-    Z(optixDeviceContextSetCacheLocation); Z(optixModuleCreateFromPTX);
+    Z(optixDeviceContextSetCacheLocation);
+    Z(optixDeviceContextSetCacheDatabaseSizes);
+    Z(optixDeviceContextGetCacheEnabled);
+    Z(optixDeviceContextGetCacheDatabaseSizes); Z(optixModuleCreateFromPTX);
     Z(optixModuleDestroy); Z(optixProgramGroupCreate);
     Z(optixProgramGroupDestroy); Z(optixPipelineCreate);
     Z(optixPipelineDestroy); Z(optixLaunch); Z(optixSbtRecordPackHeader);
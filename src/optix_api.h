@@ -140,6 +140,12 @@ DR_OPTIX_SYM(
     OptixResult (*optixDeviceContextSetCacheEnabled)(OptixDeviceContext, int));
 DR_OPTIX_SYM(OptixResult (*optixDeviceContextSetCacheLocation)(
     OptixDeviceContext, const char *));
+DR_OPTIX_SYM(OptixResult (*optixDeviceContextSetCacheDatabaseSizes)(
+    OptixDeviceContext, size_t, size_t));
+DR_OPTIX_SYM(
+    OptixResult (*optixDeviceContextGetCacheEnabled)(OptixDeviceContext, int *));
+DR_OPTIX_SYM(OptixResult (*optixDeviceContextGetCacheDatabaseSizes)(
+    OptixDeviceContext, size_t *, size_t *));
 DR_OPTIX_SYM(OptixResult (*optixModuleCreateFromPTX)(
     OptixDeviceContext, const OptixModuleCompileOptions *,
     const OptixPipelineCompileOptions *, const char *, size_t, char *, size_t *,
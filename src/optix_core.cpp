@@ -16,9 +16,33 @@
 #define jitc_optix_check(err) jitc_optix_check_impl((err), __FILE__, __LINE__)
 extern void jitc_optix_check_impl(OptixResult errval, const char *file, const int line);
 
-static bool jitc_optix_cache_hit = false;
+static std::atomic<bool> jitc_optix_cache_hit { false };
 static bool jitc_optix_cache_global_disable = false;
 
+/* Lower bound of the size limits (low/high water mark) of OptiX's module
+   disk cache. Its defaults are small enough that a ray tracing application
+   with many kernel variants evicts entries that are needed at the next start. */
+/// A pending update of a contiguous range of shader binding table records
+struct OptixSbtUpdate {
+    /// Destination in device memory
+    uint8_t *dst;
+    /// Offset and size of the record data in \ref OptixSbtPending::data
+    size_t offset, size;
+};
+
+/// Record updates of a shader binding table awaiting the next launch
+struct OptixSbtPending {
+    std::vector<uint8_t> data;
+    std::vector<OptixSbtUpdate> updates;
+};
+
+/// Pending updates, indexed by the address of the OptixShaderBindingTable
+static tsl::robin_map<uint64_t, OptixSbtPending, UInt64Hasher>
+    jitc_optix_sbt_pending;
+
+static const size_t jitc_optix_cache_low_water  = (size_t) 1 << 30,
+                    jitc_optix_cache_high_water = (size_t) 1 << 31;
+
 void jitc_optix_log(unsigned int level, const char *tag, const char *message, void *) {
     size_t len = strlen(message);
     if (level <= (uint32_t) state.log_level_stderr)
@@ -78,6 +102,35 @@ OptixDeviceContext jitc_optix_context() {
         jitc_optix_check(optixDeviceContextSetCacheLocation(ctx, temp.get()));
 #endif
         jitc_optix_check(optixDeviceContextSetCacheEnabled(ctx, 1));
+
+        /* Compiled modules are stored in the cache keyed by the PTX code
+           (which embeds the kernel hash) and the pipeline compile options, so
+           it matches the (hash, flags) key of the in-memory kernel cache. */
+        int cache_enabled = 0;
+        jitc_optix_check(optixDeviceContextGetCacheEnabled(ctx, &cache_enabled));
+
+        if (!cache_enabled) {
+            // e.g. disabled via the OPTIX_CACHE_MAXSIZE environment variable
+            jitc_optix_cache_global_disable = true;
+        } else if (!getenv("OPTIX_CACHE_MAXSIZE")) {
+            size_t low_water = 0, high_water = 0;
+            jitc_optix_check(optixDeviceContextGetCacheDatabaseSizes(
+                ctx, &low_water, &high_water));
+
+            // A high water mark of zero means that the cache is unbounded
+            if (high_water != 0 && high_water < jitc_optix_cache_high_water) {
+                low_water = std::max(low_water, jitc_optix_cache_low_water);
+                high_water = jitc_optix_cache_high_water;
+                jitc_optix_check(optixDeviceContextSetCacheDatabaseSizes(
+                    ctx, low_water, high_water));
+            }
+
+            jitc_log(Debug,
+                     "jit_optix_context(): disk cache enabled (low/high water "
+                     "mark: %s/%s).",
+                     std::string(jitc_mem_string(low_water)).c_str(),
+                     std::string(jitc_mem_string(high_water)).c_str());
+        }
     }
 
     // =====================================================
@@ -215,6 +268,7 @@ uint32_t jitc_optix_configure_sbt(const OptixShaderBindingTable *sbt,
             return;
         jitc_log(InfoSym, "jit_optix_configure_sbt(): free optix shader binding table");
         OptixShaderBindingTable *sbt = (OptixShaderBindingTable*) ptr;
+        jitc_optix_sbt_pending.erase((uintptr_t) sbt);
         jitc_free(sbt->hitgroupRecordBase);
         jitc_free(sbt->missRecordBase);
         delete sbt;
@@ -225,7 +279,84 @@ uint32_t jitc_optix_configure_sbt(const OptixShaderBindingTable *sbt,
 
 void jitc_optix_update_sbt(uint32_t index, const OptixShaderBindingTable *sbt) {
     Extra &extra = state.extra[index];
-    memcpy(extra.callback_data, sbt, sizeof(OptixShaderBindingTable));
+    OptixShaderBindingTable *p = (OptixShaderBindingTable *) extra.callback_data;
+
+    // Pending record updates refer to the previous table
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    jitc_optix_flush_sbt(ts, p);
+
+    memcpy(p, sbt, sizeof(OptixShaderBindingTable));
+}
+
+void jitc_optix_update_sbt_records(uint32_t index, int miss, uint32_t offset,
+                                   uint32_t count, const void *records) {
+    auto it = state.extra.find(index);
+    if (it == state.extra.end() || !it->second.callback_data)
+        jitc_raise("jit_optix_update_sbt_records(): variable r%u is not a "
+                   "shader binding table!", index);
+
+    const OptixShaderBindingTable *sbt =
+        (const OptixShaderBindingTable *) it->second.callback_data;
+
+    uint8_t *base = (uint8_t *) (miss ? sbt->missRecordBase
+                                      : sbt->hitgroupRecordBase);
+    size_t stride = miss ? sbt->missRecordStrideInBytes
+                         : sbt->hitgroupRecordStrideInBytes,
+           n_records = miss ? sbt->missRecordCount : sbt->hitgroupRecordCount;
+
+    if (!base || (size_t) offset + count > n_records)
+        jitc_raise("jit_optix_update_sbt_records(): records [%u, %u) are out "
+                   "of bounds (the table has %zu %s records)!", offset,
+                   offset + count, n_records, miss ? "miss" : "hitgroup");
+
+    if (count == 0 || !records)
+        return;
+
+    OptixSbtPending &pending = jitc_optix_sbt_pending[(uintptr_t) sbt];
+    size_t size = count * stride;
+
+    OptixSbtUpdate update { base + offset * stride, pending.data.size(), size };
+    pending.data.insert(pending.data.end(), (const uint8_t *) records,
+                        (const uint8_t *) records + size);
+
+    // Merge with the previous update when both are contiguous
+    if (!pending.updates.empty()) {
+        OptixSbtUpdate &prev = pending.updates.back();
+        if (prev.dst + prev.size == update.dst) {
+            prev.size += size;
+            return;
+        }
+    }
+
+    pending.updates.push_back(update);
+}
+
+void jitc_optix_flush_sbt(ThreadState *ts, const OptixShaderBindingTable *sbt) {
+    auto it = jitc_optix_sbt_pending.find((uintptr_t) sbt);
+    if (it == jitc_optix_sbt_pending.end())
+        return;
+
+    const OptixSbtPending &pending = it.value();
+    scoped_set_context guard(ts->context);
+
+    jitc_log(Debug,
+             "jit_optix_flush_sbt(): uploading %s of shader binding table "
+             "records using %zu copies.",
+             std::string(jitc_mem_string(pending.data.size())).c_str(),
+             pending.updates.size());
+
+    // Stage in pinned memory, the release of 'staging' is ordered on the stream
+    uint8_t *staging = (uint8_t *) jitc_malloc(AllocType::HostPinned,
+                                               pending.data.size());
+    memcpy(staging, pending.data.data(), pending.data.size());
+
+    for (const OptixSbtUpdate &u : pending.updates)
+        cuda_check(cuMemcpyAsync((CUdeviceptr) u.dst,
+                                 (CUdeviceptr) (staging + u.offset), u.size,
+                                 ts->stream));
+
+    jitc_free(staging);
+    jitc_optix_sbt_pending.erase(it);
 }
 
 bool jitc_optix_compile(ThreadState *ts, const char *buf, size_t buf_size,
@@ -254,18 +385,13 @@ bool jitc_optix_compile(ThreadState *ts, const char *buf, size_t buf_size,
     OptixDeviceContext &optix_context = state.devices[ts->device].optix_context;
     OptixPipelineData &pipeline = *ts->optix_pipeline;
 
+    /* Module compilation dominates the cost of this function. It is split
+       into tasks that run on the thread pool while the main lock is
+       released. This is safe since the caller (jitc_eval()) holds
+       'state.eval_lock', which protects 'buf' and the assembler state. */
+    CUcontext context = ts->context;
     OptixTask task;
-    int rv = optixModuleCreateFromPTXWithTasks(
-        optix_context, &mco, &pipeline.compile_options, buf, buf_size,
-        error_log, &log_size, &kernel.optix.mod, &task);
-
-    if (rv) {
-        jitc_log(Error, "jit_optix_compile(): "
-                 "optixModuleCreateFromPTXWithTasks() failed. Please see the "
-                 "PTX assembly listing and error message below:\n\n%s\n\n%s",
-                 buf, error_log);
-        jitc_optix_check(rv);
-    }
+    int rv;
 
     std::function<void(OptixTask)> execute_task = [&](OptixTask task) {
         unsigned int max_new_tasks = std::max(pool_size(), 1u);
@@ -278,6 +404,7 @@ bool jitc_optix_compile(ThreadState *ts, const char *buf, size_t buf_size,
         parallel_for(
             drjit::blocked_range<size_t>(0, new_task_count, 1),
             [&](const drjit::blocked_range<size_t> &range) {
+                scoped_set_context guard_2(context);
                 for (auto i = range.begin(); i != range.end(); ++i) {
                     OptixTask new_task = new_tasks[i];
                     execute_task(new_task);
@@ -285,7 +412,23 @@ bool jitc_optix_compile(ThreadState *ts, const char *buf, size_t buf_size,
             }
         );
     };
-    execute_task(task);
+
+    /* Unlock while compiling */ {
+        unlock_guard guard(state.lock);
+        rv = optixModuleCreateFromPTXWithTasks(
+            optix_context, &mco, &pipeline.compile_options, buf, buf_size,
+            error_log, &log_size, &kernel.optix.mod, &task);
+        if (!rv)
+            execute_task(task);
+    }
+
+    if (rv) {
+        jitc_log(Error, "jit_optix_compile(): "
+                 "optixModuleCreateFromPTXWithTasks() failed. Please see the "
+                 "PTX assembly listing and error message below:\n\n%s\n\n%s",
+                 buf, error_log);
+        jitc_optix_check(rv);
+    }
 
     int compilation_state = 0;
     jitc_optix_check(
@@ -387,10 +530,13 @@ bool jitc_optix_compile(ThreadState *ts, const char *buf, size_t buf_size,
     }
 
     log_size = sizeof(error_log);
-    rv = optixPipelineCreate(optix_context, &pipeline.compile_options,
-                             &link_options, pipeline.program_groups.data(),
-                             (unsigned int) pipeline.program_groups.size(),
-                             error_log, &log_size, &kernel.optix.pipeline);
+    /* Unlock while linking */ {
+        unlock_guard guard(state.lock);
+        rv = optixPipelineCreate(optix_context, &pipeline.compile_options,
+                                 &link_options, pipeline.program_groups.data(),
+                                 (unsigned int) pipeline.program_groups.size(),
+                                 error_log, &log_size, &kernel.optix.pipeline);
+    }
     if (rv) {
         jitc_log(Error, "jit_optix_compile(): optixPipelineCreate() failed. "
                  "Please see the PTX assembly listing and error message "
@@ -463,6 +609,7 @@ void jitc_optix_launch(ThreadState *ts, const Kernel &kernel,
                        uint32_t launch_size, const void *args,
                        uint32_t n_args) {
     OptixShaderBindingTable &sbt = *ts->optix_sbt;
+    jitc_optix_flush_sbt(ts, &sbt);
     sbt.raygenRecord = kernel.optix.sbt_record;
 
     if (kernel.optix.pg_count > 1) {
@@ -513,7 +660,8 @@ void jitc_optix_ray_trace(uint32_t n_args, uint32_t *args, uint32_t mask,
     if (n_args < 15)
         jitc_raise("jit_optix_ray_trace(): too few arguments (got %u < 15)", n_args);
 
-    uint32_t np = n_args - 15, size = 0;
+    uint32_t np = n_args - 15;
+    size_t size = 0;
     if (np > 32)
         jitc_raise("jit_optix_ray_trace(): too many payloads (got %u > 32)", np);
 
@@ -560,7 +708,7 @@ void jitc_optix_ray_trace(uint32_t n_args, uint32_t *args, uint32_t mask,
     // Potentially apply any masks on the mask stack
     Ref valid = steal(jitc_var_mask_apply(mask, size));
 
-    jitc_log(InfoSym, "jit_optix_ray_trace(): tracing %u ray%s, %u payload value%s%s.",
+    jitc_log(InfoSym, "jit_optix_ray_trace(): tracing %zu ray%s, %u payload value%s%s.",
              size, size != 1 ? "s" : "", np, np == 1 ? "" : "s",
              placeholder ? " (part of a recorded computation)" : "");
 
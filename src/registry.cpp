@@ -12,12 +12,177 @@
 
 static_assert(sizeof(void*) == 8, "32 bit architectures are not supported!");
 
+/* The functions jitc_registry_get_ptr(), jitc_registry_get_id(), and
+   jitc_registry_attr_data() don't require 'state.lock'. They only access
+   RegistryDomain records and the lookup tables referenced by them, which
+   writers (who do hold the lock) update using atomic operations. Tables that
+   are replaced by larger ones are retired and only released once no reader
+   is active anymore.
+
+   This is a store->load pattern on both sides: readers increment
+   'registry_readers' and then load a table, while writers publish a new
+   table and then load 'registry_readers'. Release/acquire ordering does not
+   prevent the store and the subsequent load from being reordered, hence
+   both sides issue a sequentially consistent fence in between. */
+
+/// Number of lock-free lookups that are currently in progress
+static std::atomic<uint32_t> registry_readers { 0 };
+
+/// Tables that were replaced while readers might still access them
+static std::vector<RegistryTable *> registry_retired;
+static std::vector<RegistryRevTable *> registry_retired_rev;
+
+struct RegistryReadGuard {
+    RegistryReadGuard() {
+        registry_readers++;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    ~RegistryReadGuard() { registry_readers--; }
+};
+
+/// Release retired tables if this is safe
+static void jitc_registry_reclaim(bool force = false) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!force && registry_readers.load() != 0)
+        return;
+    for (RegistryTable *t : registry_retired)
+        delete t;
+    for (RegistryRevTable *t : registry_retired_rev)
+        delete t;
+    registry_retired.clear();
+    registry_retired_rev.clear();
+}
+
+/// Look up (and optionally create) the interned record of a domain
+static RegistryDomain *jitc_registry_domain(Registry *registry,
+                                            const char *domain, bool create) {
+    RegistryDomain *head = registry->domains.load(std::memory_order_acquire);
+    for (RegistryDomain *d = head; d; d = d->next) {
+        if (d->name == domain || strcmp(d->name, domain) == 0)
+            return d;
+    }
+
+    if (!create)
+        return nullptr;
+
+    RegistryDomain *d = new RegistryDomain();
+    d->name = strdup(domain);
+    d->next = head;
+    registry->domains.store(d, std::memory_order_release);
+    return d;
+}
+
+/// Update the dense table of a domain (writers only)
+static void jitc_registry_table_set(RegistryDomain *d, uint32_t id, void *ptr) {
+    RegistryTable *t = d->table.load(std::memory_order_relaxed);
+
+    if (!t || id >= t->size) {
+        if (!ptr)
+            return;
+
+        RegistryTable *t2 = new RegistryTable();
+        t2->size = std::max(id + 1, std::max(16u, t ? t->size * 2u : 0u));
+        t2->ptr.reset(new std::atomic<void *>[t2->size]());
+        for (uint32_t i = 0; t && i < t->size; ++i)
+            t2->ptr[i].store(t->ptr[i].load(std::memory_order_relaxed),
+                             std::memory_order_relaxed);
+
+        d->table.store(t2, std::memory_order_release);
+        if (t)
+            registry_retired.push_back(t);
+        jitc_registry_reclaim();
+        t = t2;
+    }
+
+    t->ptr[id].store(ptr, std::memory_order_release);
+}
+
+static uint32_t jitc_registry_rev_slot(const RegistryRevTable *t, const void *ptr) {
+    return (uint32_t) UInt64Hasher()((uint64_t) (uintptr_t) ptr) & (t->capacity - 1);
+}
+
+/// Record the ID of a pointer in the reverse lookup table (writers only)
+static void jitc_registry_rev_set(Registry *registry, const void *ptr, uint32_t id) {
+    RegistryRevTable *t = registry->rev_table.load(std::memory_order_relaxed);
+
+    if (t) {
+        for (uint32_t i = jitc_registry_rev_slot(t, ptr);; i = (i + 1) & (t->capacity - 1)) {
+            RegistryRevTable::Entry &e = t->entries[i];
+            const void *p = e.ptr.load(std::memory_order_relaxed);
+            if (p == ptr) {
+                e.id.store(id, std::memory_order_release);
+                return;
+            } else if (!p) {
+                break;
+            }
+        }
+    }
+
+    if (!id)
+        return;
+
+    if (!t || (t->used + 1) * 2 > t->capacity) {
+        // Rebuild from the reverse map, which drops removed pointers
+        uint32_t capacity = 64;
+        while (capacity < registry->rev.size() * 4)
+            capacity *= 2;
+
+        RegistryRevTable *t2 = new RegistryRevTable();
+        t2->capacity = capacity;
+        t2->entries.reset(new RegistryRevTable::Entry[capacity]);
+
+        for (auto &kv : registry->rev) {
+            uint32_t i = jitc_registry_rev_slot(t2, kv.first);
+            while (t2->entries[i].ptr.load(std::memory_order_relaxed))
+                i = (i + 1) & (capacity - 1);
+            t2->entries[i].id.store(kv.second.id, std::memory_order_relaxed);
+            t2->entries[i].ptr.store(kv.first, std::memory_order_relaxed);
+            t2->used++;
+        }
+
+        registry->rev_table.store(t2, std::memory_order_release);
+        if (t)
+            registry_retired_rev.push_back(t);
+        jitc_registry_reclaim();
+        return;
+    }
+
+    uint32_t i = jitc_registry_rev_slot(t, ptr);
+    while (t->entries[i].ptr.load(std::memory_order_relaxed))
+        i = (i + 1) & (t->capacity - 1);
+    t->entries[i].id.store(id, std::memory_order_relaxed);
+    t->entries[i].ptr.store(ptr, std::memory_order_release);
+    t->used++;
+}
+
+/// Publish the buffer of an attribute to lock-free readers (writers only)
+static void jitc_registry_attr_set(RegistryDomain *d, const char *name, void *ptr) {
+    RegistryAttr *head = d->attrs.load(std::memory_order_relaxed);
+    for (RegistryAttr *a = head; a; a = a->next) {
+        if (strcmp(a->name, name) == 0) {
+            a->ptr.store(ptr, std::memory_order_release);
+            return;
+        }
+    }
+
+    if (!ptr)
+        return;
+
+    RegistryAttr *a = new RegistryAttr();
+    a->name = strdup(name);
+    a->ptr.store(ptr, std::memory_order_relaxed);
+    a->next = head;
+    d->attrs.store(a, std::memory_order_release);
+}
+
 /// Register a pointer with Dr.Jit's pointer registry
 uint32_t jitc_registry_put(JitBackend backend, const char *domain, void *ptr) {
     if (unlikely(ptr == nullptr))
         jitc_raise("jit_registry_put(): cannot register the null pointer!");
 
     Registry* registry = state.registry(backend);
+    RegistryDomain *d = jitc_registry_domain(registry, domain, true);
+    domain = d->name;
 
     // Create the rev. map. first and throw if the pointer is already registered
     auto it_rev = registry->rev.try_emplace(ptr, RegistryKey(domain, 0));
@@ -53,6 +218,8 @@ uint32_t jitc_registry_put(JitBackend backend, const char *domain, void *ptr) {
 
         // Finally, update reverse mapping
         it_rev.first.value().id = next_avail;
+        jitc_registry_table_set(d, next_avail, ptr);
+        jitc_registry_rev_set(registry, ptr, next_avail);
 
         jitc_trace("jit_registry_put(" DRJIT_PTR ", domain=\"%s\"): %u (reused)",
                   (uintptr_t) ptr, domain, next_avail);
@@ -72,6 +239,8 @@ uint32_t jitc_registry_put(JitBackend backend, const char *domain, void *ptr) {
 
         // Finally, update reverse mapping
         it_rev.first.value().id = counter;
+        jitc_registry_table_set(d, counter, ptr);
+        jitc_registry_rev_set(registry, ptr, counter);
 
         jitc_trace("jit_registry_put(" DRJIT_PTR ", domain=\"%s\"): %u (new)",
                   (uintptr_t) ptr, domain, counter);
@@ -116,6 +285,10 @@ void jitc_registry_remove(JitBackend backend, void *ptr) {
 
     // Remove reverse mapping
     registry->rev.erase(it_rev);
+
+    jitc_registry_table_set(jitc_registry_domain(registry, key.domain, false),
+                            key.id, nullptr);
+    jitc_registry_rev_set(registry, ptr, 0);
 }
 
 /// Query the ID associated a registered pointer
@@ -123,11 +296,29 @@ uint32_t jitc_registry_get_id(JitBackend backend, const void *ptr) {
     if (ptr == nullptr)
         return 0;
 
-    Registry* registry = state.registry(backend);
-    auto it = registry->rev.find(ptr);
-    if (unlikely(it == registry->rev.end()))
+    uint32_t id = 0;
+
+    /* Lock-free lookup */ {
+        RegistryReadGuard guard;
+        const RegistryRevTable *t =
+            state.registry(backend)->rev_table.load(std::memory_order_acquire);
+
+        for (uint32_t i = t ? jitc_registry_rev_slot(t, ptr) : 0; t;
+             i = (i + 1) & (t->capacity - 1)) {
+            const RegistryRevTable::Entry &e = t->entries[i];
+            const void *p = e.ptr.load(std::memory_order_acquire);
+            if (p == ptr) {
+                id = e.id.load(std::memory_order_acquire);
+                break;
+            } else if (!p) {
+                break;
+            }
+        }
+    }
+
+    if (unlikely(id == 0))
         jitc_raise("jit_registry_get_id(): pointer %p could not be found!", ptr);
-    return it.value().id;
+    return id;
 }
 
 /// Query the domain associated a registered pointer
@@ -147,16 +338,17 @@ void *jitc_registry_get_ptr(JitBackend backend, const char *domain, uint32_t id)
     if (id == 0)
         return nullptr;
 
-    Registry* registry = state.registry(backend);
-    auto it = registry->fwd.find(RegistryKey(domain, id));
-    if (unlikely(it == registry->fwd.end()))
+    RegistryReadGuard guard;
+    const RegistryDomain *d =
+        jitc_registry_domain(state.registry(backend), domain, false);
+    if (unlikely(!d))
         return nullptr;
 
-    uintptr_t value = (uintptr_t) it.value();
-    if ((value & 0xFFFFFFFFu) == 0)
+    const RegistryTable *t = d->table.load(std::memory_order_acquire);
+    if (unlikely(!t || id >= t->size))
         return nullptr;
 
-    return (void *) value;
+    return t->ptr[id].load(std::memory_order_acquire);
 }
 
 /// Compact the registry and release unused IDs and attributes
@@ -195,10 +387,14 @@ void jitc_registry_trim() {
             if (registry->fwd.find(RegistryKey(kv.first.domain, 0)) != registry->fwd.end()) {
                 tmp_registry.attributes.insert(kv);
             } else {
+                jitc_registry_attr_set(
+                    jitc_registry_domain(registry, kv.first.domain, false),
+                    kv.first.name, nullptr);
                 if (backend == JitBackend::CUDA)
                     cuda_check(cuMemFree((CUdeviceptr) kv.second.ptr));
                 else
                     free(kv.second.ptr);
+                free(kv.second.host);
             }
         }
 
@@ -225,10 +421,25 @@ void jitc_registry_clean() {
                 cuda_check(cuMemFree((CUdeviceptr) kv.second.ptr));
             else
                 free(kv.second.ptr);
+            free(kv.second.host);
         }
         registry->fwd.clear();
         registry->rev.clear();
         registry->attributes.clear();
+
+        // Domain records stay alive, but their lookup tables are emptied
+        for (RegistryDomain *d = registry->domains.load(); d; d = d->next) {
+            RegistryTable *t = d->table.exchange(nullptr);
+            if (t)
+                registry_retired.push_back(t);
+            for (RegistryAttr *a = d->attrs.load(); a; a = a->next)
+                a->ptr.store(nullptr);
+        }
+
+        RegistryRevTable *t = registry->rev_table.exchange(nullptr);
+        if (t)
+            registry_retired_rev.push_back(t);
+        jitc_registry_reclaim();
     };
 
     if (state.backends & (uint32_t) JitBackend::CUDA)
@@ -240,8 +451,12 @@ void jitc_registry_clean() {
 /// Provide a bound (<=) on the largest ID associated with a domain
 uint32_t jitc_registry_get_max(JitBackend backend, const char *domain) {
     Registry* registry = state.registry(backend);
+    RegistryDomain *d = jitc_registry_domain(registry, domain, false);
+    if (!d)
+        return 0;
+
     // Get the bookkeeping record associated with the domain
-    auto it_head = registry->fwd.find(RegistryKey(domain, 0));
+    auto it_head = registry->fwd.find(RegistryKey(d->name, 0));
     if (unlikely(it_head == registry->fwd.end()))
         return 0;
 
@@ -252,6 +467,26 @@ uint32_t jitc_registry_get_max(JitBackend backend, const char *domain) {
 void jitc_registry_shutdown() {
     jitc_registry_trim();
 
+    auto free_domains = [](JitBackend backend) {
+        Registry* registry = state.registry(backend);
+        RegistryDomain *d = registry->domains.exchange(nullptr);
+        while (d) {
+            RegistryAttr *a = d->attrs.load();
+            while (a) {
+                RegistryAttr *next = a->next;
+                free(a->name);
+                delete a;
+                a = next;
+            }
+            RegistryDomain *next = d->next;
+            delete d->table.load();
+            free(d->name);
+            delete d;
+            d = next;
+        }
+        delete registry->rev_table.exchange(nullptr);
+    };
+
     if (state.backends & (uint32_t) JitBackend::CUDA) {
         Registry* registry = state.registry(JitBackend::CUDA);
         if (!registry->fwd.empty() || !registry->rev.empty())
@@ -277,6 +512,10 @@ void jitc_registry_shutdown() {
                     "%zu attributes!",
                     registry->attributes.size());
     }
+
+    free_domains(JitBackend::CUDA);
+    free_domains(JitBackend::LLVM);
+    jitc_registry_reclaim(true);
 }
 
 void jitc_registry_set_attr(JitBackend backend, void *ptr, const char *name,
@@ -322,6 +561,14 @@ void jitc_registry_set_attr(JitBackend backend, void *ptr, const char *name,
                                 new_size - old_size, ts->stream));
 
             cuda_check(cuMemFree((CUdeviceptr) attr.ptr));
+
+            // Pending changes are uploaded into the new buffer later on
+            void *new_host = malloc_check(new_size);
+            if (old_size != 0)
+                memcpy(new_host, attr.host, old_size);
+            memset((uint8_t *) new_host + old_size, 0, new_size - old_size);
+            free(attr.host);
+            attr.host = new_host;
         } else {
             new_ptr = malloc_check(new_size);
 
@@ -334,30 +581,125 @@ void jitc_registry_set_attr(JitBackend backend, void *ptr, const char *name,
 
         attr.ptr = new_ptr;
         attr.count = new_count;
+        jitc_registry_attr_set(jitc_registry_domain(registry, domain, false),
+                               name, new_ptr);
     }
 
     if (backend == JitBackend::CUDA) {
-        scoped_set_context guard(state.devices[0].context);
-        cuda_check(
-            cuMemcpyAsync((CUdeviceptr)((uint8_t *) attr.ptr + id * isize),
-                          (CUdeviceptr) value, isize, ts->stream));
+        memcpy((uint8_t *) attr.host + id * isize, value, isize);
+
+        // Extend the most recent dirty range if possible
+        auto &dirty = attr.dirty;
+        if (!dirty.empty() && dirty.back().second == id)
+            dirty.back().second++;
+        else if (dirty.empty() || id < dirty.back().first ||
+                 id >= dirty.back().second)
+            dirty.emplace_back(id, id + 1);
+        registry->dirty = true;
     } else {
         memcpy((uint8_t *) attr.ptr + id * isize, value, isize);
     }
 }
 
+void jitc_registry_flush(JitBackend backend) {
+    Registry* registry = state.registry(backend);
+    if (!registry->dirty)
+        return;
+    registry->dirty = false;
+
+    /// Gaps up to this size between dirty ranges are uploaded along with them
+    const size_t merge_gap = 4096;
+
+    // 1. Merge the dirty ranges of all attributes and determine their size
+    std::vector<std::pair<size_t, size_t>> ranges; // (byte offset, size)
+    std::vector<AttributeValue *> attrs;
+    size_t total = 0;
+
+    for (auto &kv : registry->attributes) {
+        AttributeValue &attr = kv.second;
+        auto &dirty = attr.dirty;
+        if (dirty.empty())
+            continue;
+
+        auto push = [&](size_t start, size_t end) {
+            ranges.emplace_back(start, end - start);
+            attrs.push_back(&attr);
+            total += end - start;
+        };
+
+        std::sort(dirty.begin(), dirty.end());
+        size_t start = (size_t) dirty[0].first * attr.isize,
+               end = (size_t) dirty[0].second * attr.isize;
+
+        for (size_t i = 1; i < dirty.size(); ++i) {
+            size_t start_2 = (size_t) dirty[i].first * attr.isize,
+                   end_2 = (size_t) dirty[i].second * attr.isize;
+            if (start_2 > end + merge_gap) {
+                push(start, end);
+                start = start_2;
+            }
+            end = std::max(end, end_2);
+        }
+
+        push(start, end);
+        dirty.clear();
+    }
+
+    if (ranges.empty())
+        return;
+
+    // 2. Stage all changes in pinned memory and upload them on the copy stream
+    ThreadState *ts = thread_state(backend);
+    scoped_set_context guard(ts->context);
+
+    uint8_t *staging = (uint8_t *) jitc_malloc(AllocType::HostPinned, total);
+    CUstream stream = jitc_copy_stream_begin(ts);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        const AttributeValue &attr = *attrs[i];
+        size_t start = ranges[i].first, size = ranges[i].second;
+        memcpy(staging + offset, (uint8_t *) attr.host + start, size);
+        cuda_check(cuMemcpyAsync((CUdeviceptr) ((uint8_t *) attr.ptr + start),
+                                 (CUdeviceptr) (staging + offset), size, stream));
+        offset += size;
+    }
+
+    jitc_copy_stream_end(ts);
+    jitc_free(staging);
+
+    jitc_trace("jit_registry_flush(): uploaded %zu attribute range%s (%zu bytes).",
+               ranges.size(), ranges.size() == 1 ? "" : "s", total);
+}
+
 const void *jitc_registry_attr_data(JitBackend backend, const char *domain,
                                     const char *name) {
-    Registry* registry = state.registry(backend);
-    auto it = registry->attributes.find(AttributeKey(domain, name));
-    if (unlikely(it == registry->attributes.end())) {
-        if (jitc_registry_get_max(backend, domain) > 0) {
-            jitc_log(Warn,
-                     "jit_registry_attr_data(): entry with domain=\"%s\", "
-                     "name=\"%s\" not found!",
-                     domain, name);
+    bool warn = false;
+
+    /* Lock-free lookup */ {
+        RegistryReadGuard guard;
+        const RegistryDomain *d =
+            jitc_registry_domain(state.registry(backend), domain, false);
+
+        for (const RegistryAttr *a = d ? d->attrs.load(std::memory_order_acquire)
+                                       : nullptr; a; a = a->next) {
+            if (strcmp(a->name, name) == 0) {
+                void *ptr = a->ptr.load(std::memory_order_acquire);
+                if (ptr)
+                    return ptr;
+                break;
+            }
         }
-        return nullptr;
+
+        const RegistryTable *t =
+            d ? d->table.load(std::memory_order_acquire) : nullptr;
+        warn = t != nullptr;
     }
-    return it.value().ptr;
+
+    if (warn)
+        jitc_log(Warn,
+                 "jit_registry_attr_data(): entry with domain=\"%s\", "
+                 "name=\"%s\" not found!", domain, name);
+
+    return nullptr;
 }
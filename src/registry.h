@@ -46,6 +46,9 @@ extern void jitc_registry_set_attr(JitBackend backend, void *ptr,
                                    const char *name, const void *value,
                                    size_t size);
 
+/// Upload pending attribute changes (called before kernels may access them)
+extern void jitc_registry_flush(JitBackend backend);
+
 /// Retrieve a pointer to a buffer storing a specific attribute
 extern const void *jitc_registry_attr_data(JitBackend backend,
                                            const char *domain,
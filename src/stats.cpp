@@ -0,0 +1,206 @@
+/*
+    src/stats.cpp -- Always-on counters of the hot paths (see jit_stats())
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "internal.h"
+#include "stats.h"
+#include "var.h"
+#include "log.h"
+#include "strbuf.h"
+#include <algorithm>
+#include <chrono>
+
+#if !defined(_WIN32)
+#  include <execinfo.h>
+#endif
+
+std::atomic<uint64_t> jitc_stats_counters[(int) Stat::Count] { };
+
+void jitc_stats(JitStats *s) {
+    auto get = [](Stat stat) {
+        return jitc_stats_counters[(int) stat].load(std::memory_order_relaxed);
+    };
+
+    s->variables_created = get(Stat::VariablesCreated);
+    s->lvn_hits = get(Stat::LVNHits);
+    s->evals = get(Stat::Evals);
+    s->eval_groups = get(Stat::EvalGroups);
+    s->kernel_launches = (uint64_t) state.kernel_launches;
+    s->kernel_hits = (uint64_t) state.kernel_hits;
+    s->alloc_reused = get(Stat::AllocReused);
+    s->alloc_fresh = get(Stat::AllocFresh);
+    s->bytes_host_to_device = get(Stat::BytesHostToDevice);
+    s->bytes_device_to_host = get(Stat::BytesDeviceToHost);
+    s->implicit_evals = get(Stat::ImplicitEvals);
+    s->implicit_syncs = get(Stat::ImplicitSyncs);
+
+    // Allocated memory that is not in use is held by the allocation cache
+    uint64_t cached = 0;
+    for (int i = 0; i < (int) AllocType::Count; ++i)
+        cached += (uint64_t) (state.alloc_allocated[i] - state.alloc_usage[i]);
+    s->alloc_cached_bytes = cached;
+}
+
+// ==========================================================================
+// Implicit synchronization profiler
+// ==========================================================================
+
+/// Operations with the same name, variable label, and backtrace
+struct ImplicitSyncSite {
+    const char *name;
+    std::string label;
+    int frame_count;
+    void *frames[DRJIT_SYNC_PROFILE_FRAMES];
+
+    /// Number of occurrences, and how many of them had to evaluate the input
+    uint64_t count, evals;
+
+    /// Total time in microseconds
+    uint64_t time;
+};
+
+int jitc_sync_profile_level = 0;
+static std::vector<ImplicitSyncSite> sync_sites;
+static tsl::robin_map<uint64_t, size_t, UInt64Hasher> sync_site_map;
+static thread_local uint32_t sync_depth = 0;
+static StringBuffer sync_buffer(0);
+
+static uint64_t jitc_sync_profile_time() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ImplicitSync::begin(const char *name, uint32_t index) {
+    m_name = name;
+    m_outer = sync_depth++ == 0;
+    if (!m_outer)
+        return;
+
+    m_eval = false;
+    if (index) {
+        const Variable *v = jitc_var(index);
+        m_eval = v->is_node() || (v->is_data() && v->is_dirty());
+        const char *label = jitc_var_label(index);
+        if (label)
+            m_label = label;
+    }
+
+    m_frame_count = 0;
+#if !defined(_WIN32)
+    if (jitc_sync_profile_level > 1)
+        m_frame_count = backtrace(m_frames, DRJIT_SYNC_PROFILE_FRAMES);
+#endif
+
+    m_start = jitc_sync_profile_time();
+}
+
+void ImplicitSync::end() {
+    sync_depth--;
+    if (!m_outer)
+        return;
+
+    uint64_t time = jitc_sync_profile_time() - m_start;
+
+    uint64_t key = XXH3_64bits_withSeed(m_label.data(), m_label.size(),
+                                        (uint64_t) (uintptr_t) m_name);
+    if (m_frame_count)
+        key = XXH3_64bits_withSeed(m_frames, m_frame_count * sizeof(void *), key);
+
+    auto result = sync_site_map.try_emplace(key, sync_sites.size());
+    if (result.second) {
+        ImplicitSyncSite site;
+        site.name = m_name;
+        site.label = m_label;
+        site.frame_count = m_frame_count;
+        memcpy(site.frames, m_frames, sizeof(void *) * m_frame_count);
+        site.count = site.evals = site.time = 0;
+        sync_sites.push_back(std::move(site));
+
+        jitc_log(Warn,
+                 "%s(%s%s%s): implicit synchronization%s (reported once per "
+                 "site, see jit_sync_profile()).", m_name,
+                 m_label.empty() ? "" : "label=\"", m_label.c_str(),
+                 m_label.empty() ? "" : "\"",
+                 m_eval ? " that evaluated the variable" : "");
+    }
+
+    ImplicitSyncSite &site = sync_sites[result.first->second];
+    site.count++;
+    site.evals += m_eval;
+    site.time += time;
+}
+
+void jitc_set_sync_profile(int level) {
+#if defined(_WIN32)
+    if (level > 1)
+        jitc_log(Warn, "jit_set_sync_profile(): backtraces are not supported "
+                       "on Windows.");
+#endif
+    jitc_sync_profile_level = level;
+}
+
+const char *jitc_sync_profile() {
+    StringBuffer &buf = sync_buffer;
+    buf.clear();
+
+    buf.put("\n  Implicit synchronizations\n");
+    buf.put("  =========================\n");
+
+    if (!jitc_sync_profile_level)
+        buf.put("\n  Note: the sync profiler is currently disabled "
+                "(see jit_set_sync_profile()).\n");
+
+    if (sync_sites.empty()) {
+        buf.put("\n  No implicit synchronizations were recorded.\n");
+        return buf.get();
+    }
+
+    std::vector<size_t> order(sync_sites.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [](size_t a, size_t b) {
+        return sync_sites[a].time > sync_sites[b].time;
+    });
+
+    buf.put("\n    Time       Count      Evaluated  Operation              Variable\n");
+    buf.put("    --------------------------------------------------------------------\n");
+
+    for (size_t i = 0; i < order.size() && i < 20; ++i) {
+        const ImplicitSyncSite &s = sync_sites[order[i]];
+        buf.fmt("    %-10s ", jitc_time_string((float) s.time));
+        buf.fmt("%-10llu %-10llu %-22s ", (unsigned long long) s.count,
+                (unsigned long long) s.evals, s.name);
+        if (s.label.empty())
+            buf.put("-\n");
+        else
+            buf.fmt("\"%s\"\n", s.label.c_str());
+
+#if !defined(_WIN32)
+        if (s.frame_count > 1) {
+            // Skip the frame of ImplicitSync::begin()
+            char **symbols = backtrace_symbols((void *const *) s.frames + 1,
+                                               s.frame_count - 1);
+            if (symbols) {
+                for (int j = 0; j < s.frame_count - 1; ++j)
+                    buf.fmt("        #%-2i %s\n", j, symbols[j]);
+                free(symbols);
+            }
+        }
+#endif
+    }
+
+    if (order.size() > 20)
+        buf.fmt("    (%zu more)\n", order.size() - 20);
+
+    return buf.get();
+}
+
+void jitc_sync_profile_clear() {
+    sync_sites.clear();
+    sync_site_map.clear();
+}
@@ -0,0 +1,91 @@
+/*
+    src/stats.h -- Always-on counters of the hot paths (see jit_stats())
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <drjit-core/jit.h>
+#include <atomic>
+#include <string>
+
+/// Counters that are incremented via \ref jitc_stat()
+enum class Stat : uint32_t {
+    VariablesCreated,
+    LVNHits,
+    Evals,
+    EvalGroups,
+    AllocReused,
+    AllocFresh,
+    BytesHostToDevice,
+    BytesDeviceToHost,
+    ImplicitEvals,
+    ImplicitSyncs,
+    Count
+};
+
+extern std::atomic<uint64_t> jitc_stats_counters[(int) Stat::Count];
+
+/// Increase a counter. Some are updated without holding 'state.lock'.
+inline void jitc_stat(Stat stat, uint64_t amount = 1) {
+    jitc_stats_counters[(int) stat].fetch_add(amount, std::memory_order_relaxed);
+}
+
+/// Fill 'stats' with the current value of all counters
+extern void jitc_stats(JitStats *stats);
+
+/// Maximum number of stack frames stored per site by the sync profiler
+#define DRJIT_SYNC_PROFILE_FRAMES 16
+
+/// Level of the implicit synchronization profiler, see jitc_set_sync_profile()
+extern int jitc_sync_profile_level;
+
+/**
+ * \brief Scope of an operation that makes the host wait for the device
+ *
+ * When the implicit synchronization profiler is active, this records the
+ * operation 'name' along with the label of the accessed variable 'index'
+ * (if nonzero), whether the variable had to be evaluated first, the time
+ * spent, and optionally a backtrace. Nested scopes are attributed to the
+ * outermost one. Passing a null pointer as 'name' disables the scope.
+ */
+struct ImplicitSync {
+    ImplicitSync(const char *name, uint32_t index) {
+        if (jitc_sync_profile_level && name)
+            begin(name, index);
+    }
+
+    ~ImplicitSync() {
+        if (m_name)
+            end();
+    }
+
+    ImplicitSync(const ImplicitSync &) = delete;
+    ImplicitSync &operator=(const ImplicitSync &) = delete;
+
+private:
+    void begin(const char *name, uint32_t index);
+    void end();
+
+private:
+    const char *m_name = nullptr;
+    bool m_outer;
+    bool m_eval;
+    uint64_t m_start;
+    int m_frame_count;
+    std::string m_label;
+    void *m_frames[DRJIT_SYNC_PROFILE_FRAMES];
+};
+
+/// Set the level of the sync profiler (0: off, 1: on, 2: with backtraces)
+extern void jitc_set_sync_profile(int level);
+
+/// Return a report of the most costly implicit synchronizations
+extern const char *jitc_sync_profile();
+
+/// Clear the data collected by the sync profiler
+extern void jitc_sync_profile_clear();
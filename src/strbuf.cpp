@@ -4,8 +4,10 @@
 #include "eval.h"
 #include <cstdarg>
 
-/// Global string buffer used to generate PTX/LLVM IR
-StringBuffer buffer { 1024 };
+/* Per-thread string buffer used to generate PTX/LLVM IR. jitc_eval() releases
+   'state.lock' at times, and other threads may then format into their own
+   buffer (e.g. via jitc_var_str()) without clobbering the kernel source. */
+thread_local StringBuffer buffer { 1024 };
 
 static const char num[] = "0123456789abcdef";
 
@@ -229,454 +231,147 @@ size_t StringBuffer::vfmt(const char *fmt, va_list args_) {
     } while (true);
 }
 
-void StringBuffer::fmt_cuda(size_t nargs, const char *fmt, ...) {
-    size_t len = 0;
-
-    va_list args, args2;
-    va_start(args, fmt);
-    va_copy(args2, args);
-
-    // Phase 1: walk through the string and determine its maximal length
-    const char *p = fmt;
+#if !defined(NDEBUG)
+/// Check that a fmt_cuda/fmt_llvm format string consumes 'nargs' arguments
+static void fmt_check(const char *name, const char *fmt, size_t nargs,
+                      const char *consuming, const char *other) {
     size_t arg = 0;
-    char c;
-    while ((c = *p++) != '\0') {
-        if (c != '$') {
-            len++;
-        } else {
-            c = *p++;
-            switch (c) {
-                case 'u': len += MAXSIZE_U32; (void) va_arg(args, uint32_t); arg++; break;
-                case 'U': len += MAXSIZE_U64; (void) va_arg(args, uint64_t); arg++; break;
-                case 'x': len += MAXSIZE_X32; (void) va_arg(args, uint32_t); arg++; break;
-                case 'Q':
-                case 'X': len += MAXSIZE_X64; (void) va_arg(args, uint64_t); arg++; break;
-
-                case 'c': len++; (void) va_arg(args, int); arg++; break;
-
-                case 's':
-                    len += strlen(va_arg(args, const char *));
-                    arg++;
-                    break;
-
-                case 'b':
-                case 't':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_TYPE;
-                    break;
-
-                case 'v':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32 + MAXSIZE_TYPE_PREFIX;
-                    break;
-
-                case 'a':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32;
-                    break;
-
-                case 'l':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_X64 + 2;
-                    break;
-
-                case 'o':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32;
-                    break;
-
-                default:
-                    fprintf(stderr,
-                            "StringBuffer::fmt_cuda(): encountered unsupported "
-                            "character \"$%c\" in format string!\n", c);
-                    abort();
-            }
+    for (const char *p = fmt; *p; ++p) {
+        if (*p != '$')
+            continue;
+        char c = *++p;
+        if (c && strchr(consuming, c)) {
+            arg++;
+        } else if (!c || !strchr(other, c)) {
+            fprintf(stderr,
+                    "StringBuffer::%s(): encountered unsupported "
+                    "character \"$%c\" in format string!\n", name, c);
+            abort();
         }
     }
 
-    va_end(args);
-
     if (nargs != arg) {
         fprintf(stderr,
-                "StringBuffer::fmt_cuda(): given %zu args, format string "
-                "accessed %zu (%s)\n", nargs, arg, fmt);
+                "StringBuffer::%s(): given %zu args, format string "
+                "accessed %zu (%s)\n", name, nargs, arg, fmt);
         abort();
     }
+}
+#endif
 
-    // Enlarge the buffer if necessary
-    if (unlikely(!m_cur || m_cur + len >= m_end))
-        expand(len);
-
-    // Phase 2: convert the string
-    p = fmt;
-    while ((c = *p++) != '\0') {
-        if (c == '$') {
-            switch (*p++) {
-                case 'u': put_u32_unchecked(va_arg(args2, uint32_t)); break;
-                case 'U': put_u64_unchecked(va_arg(args2, uint64_t)); break;
-                case 'x': put_x32_unchecked(va_arg(args2, uint32_t)); break;
-                case 'X': put_x64_unchecked(va_arg(args2, uint64_t)); break;
-                case 'Q': put_q64_unchecked(va_arg(args2, uint64_t)); break;
-
-                case 'c': *m_cur++ = (char) va_arg(args2, int); break;
-
-                case 's': {
-                        const char *s = va_arg(args2, const char *);
-                        put(s, strlen(s));
-                    }
-                    break;
-
-                case 't': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_ptx[v->type]);
-                    }
-                    break;
-
-                case 'b': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_ptx_bin[v->type]);
-                    }
-                    break;
-
-                case 'v': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_prefix[v->type]);
-                        put_u32_unchecked(v->reg_index);
-                    }
-                    break;
+/* Both formatters below work in a single pass: literal text is copied in
+   runs, and space for each '$' item is reserved using the bound
+   MAXSIZE_FMT_ITEM ('$s' goes through put(), which checks by itself). */
 
-                case 'l': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        *m_cur ++= '0';
-                        *m_cur ++= 'x';
-                        put_x64_unchecked(v->literal);
-                    };
-                    break;
+void StringBuffer::fmt_cuda(size_t nargs, const char *fmt, ...) {
+#if !defined(NDEBUG)
+    fmt_check("fmt_cuda", fmt, nargs, "uUxQXcsbtvalo", "");
+#else
+    (void) nargs;
+#endif
 
-                case 'a': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_u32_unchecked(type_size[v->type]);
-                    }
-                    break;
+    va_list args;
+    va_start(args, fmt);
 
-                case 'o': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_u32_unchecked(v->param_offset);
-                    }
-                    break;
+    const char *p = fmt;
+    while (true) {
+        size_t run = strcspn(p, "$");
+        if (run)
+            put(p, run);
+        p += run;
+        if (*p == '\0')
+            break;
 
-                default:
-                    break;
-            }
-        } else {
-            *m_cur ++= c;
+        reserve(MAXSIZE_FMT_ITEM);
+        p++;
+        switch (*p++) {
+            case 'u': put_u32_unchecked(va_arg(args, uint32_t)); break;
+            case 'U': put_u64_unchecked(va_arg(args, uint64_t)); break;
+            case 'x': put_x32_unchecked(va_arg(args, uint32_t)); break;
+            case 'X': put_x64_unchecked(va_arg(args, uint64_t)); break;
+            case 'Q': put_q64_unchecked(va_arg(args, uint64_t)); break;
+
+            case 'c': *m_cur++ = (char) va_arg(args, int); break;
+
+            case 's': {
+                    const char *s = va_arg(args, const char *);
+                    put(s, strlen(s));
+                }
+                break;
+
+            case 't': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_ptx[v->type]);
+                }
+                break;
+
+            case 'b': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_ptx_bin[v->type]);
+                }
+                break;
+
+            case 'v': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_prefix[v->type]);
+                    put_u32_unchecked(jitc_var_scratch(v)->reg_index);
+                }
+                break;
+
+            case 'l': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    *m_cur ++= '0';
+                    *m_cur ++= 'x';
+                    put_x64_unchecked(v->literal);
+                };
+                break;
+
+            case 'a': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_u32_unchecked(type_size[v->type]);
+                }
+                break;
+
+            case 'o': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_u32_unchecked(jitc_var_scratch(v)->param_offset);
+                }
+                break;
+
+            default:
+                break;
         }
     }
-    va_end(args2);
+    va_end(args);
 
     *m_cur = '\0';
 }
 
 void StringBuffer::fmt_llvm(size_t nargs, const char *fmt, ...) {
-    size_t len = 0;
+#if !defined(NDEBUG)
+    fmt_check("fmt_llvm", fmt, nargs, "uUxQXstdbmhTDBMvVlaAo", "{}wz<>");
+#else
+    (void) nargs;
+#endif
 
-    va_list args, args2;
+    va_list args;
     va_start(args, fmt);
-    va_copy(args2, args);
 
-    // Phase 1: walk through the string and determine its maximal length
-    const char *p = fmt;
-    size_t arg = 0;
-    char c;
-    while ((c = *p++) != '\0') {
-        if (c != '$') {
-            len++;
-        } else {
-            c = *p++;
-            switch (c) {
-                case '{':
-                case '}': len += 1; break;
-
-                case 'u': len += MAXSIZE_U32; (void) va_arg(args, uint32_t); arg++; break;
-                case 'U': len += MAXSIZE_U64; (void) va_arg(args, uint64_t); arg++; break;
-                case 'x': len += MAXSIZE_X32; (void) va_arg(args, uint32_t); arg++; break;
-                case 'Q':
-                case 'X': len += MAXSIZE_X64; (void) va_arg(args, uint64_t); arg++; break;
-
-                case 's':
-                    len += strlen(va_arg(args, const char *));
-                    arg++;
-                    break;
-
-                case 'w': len += MAXSIZE_U32; break;
-
-                case 't':
-                case 'd':
-                case 'b':
-                case 'm':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_TYPE;
-                    break;
-
-                case 'h':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_TYPE_ABBREV;
-                    break;
-
-                case 'T':
-                case 'D':
-                case 'B':
-                case 'M':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32 + MAXSIZE_TYPE + 5;
-                    break;
-
-                case 'v':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32 + MAXSIZE_TYPE_PREFIX;
-                    break;
-
-                case 'V':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += 2*MAXSIZE_U32 + MAXSIZE_TYPE_PREFIX + 6;
-                    break;
-
-                case 'l':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_X64 + 2;
-                    break;
-
-                case 'a':
-                case 'A':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32;
-                    break;
-
-                case 'o':
-                    (void) va_arg(args, const Variable *); arg++;
-                    len += MAXSIZE_U32;
-                    break;
-
-                case 'z':
-                    len += 15;
-                    break;
-
-                case '<':
-                    len += MAXSIZE_U32 + 4;
-                    break;
-
-                case '>':
-                    len += 1;
-                    break;
-
-                default:
-                    fprintf(stderr,
-                            "StringBuffer::fmt_llvm(): encountered unsupported "
-                            "character \"$%c\" in format string!\n", c);
-                    abort();
-            }
-        }
-    }
-
-    va_end(args);
-
-    if (nargs != arg) {
-        fprintf(stderr,
-                "StringBuffer::fmt_llvm(): given %zu args, format string "
-                "accessed %zu (%s)\n", nargs, arg, fmt);
-        abort();
-    }
-
-    // Enlarge the buffer if necessary
-    if (unlikely(!m_cur || m_cur + len >= m_end))
-        expand(len);
-
-    // Phase 2: convert the string
     size_t offset = 0;
-    p = fmt;
-    while ((c = *p++) != '\0') {
-        if (c == '$') {
-            switch (*p++) {
-                case '{': *m_cur++= '{'; break;
-                case '}': *m_cur++= '}'; break;
-
-                case 'u': put_u32_unchecked(va_arg(args2, uint32_t)); break;
-                case 'U': put_u64_unchecked(va_arg(args2, uint64_t)); break;
-                case 'x': put_x32_unchecked(va_arg(args2, uint32_t)); break;
-                case 'X': put_x64_unchecked(va_arg(args2, uint64_t)); break;
-                case 'Q': put_q64_unchecked(va_arg(args2, uint64_t)); break;
-
-                case 's': {
-                        const char *s = va_arg(args2, const char *);
-                        put(s, strlen(s));
-                    }
-                    break;
-
-                case 'w':
-                    put_u32_unchecked(jitc_llvm_vector_width);
-                    break;
-
-                case 't': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_llvm[v->type]);
-                    }
-                    break;
-
-                case 'b': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_llvm_bin[v->type]);
-                    }
-                    break;
-
-                case 'd': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_llvm_big[v->type]);
-                    }
-                    break;
-
-
-                case 'h': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_name_llvm_abbrev[v->type]);
-                    }
-                    break;
-
-                case 'm': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        uint32_t type = v->type == (uint32_t) VarType::Bool
-                                            ? (uint32_t) VarType::UInt8
-                                            : v->type;
-                        put_unchecked(type_name_llvm[type]);
-                    }
-                    break;
-
-                case 'T': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                        put_unchecked(type_name_llvm[v->type]);
-                        *m_cur ++= '>';
-                    }
-                    break;
-
-                case 'B': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                        put_unchecked(type_name_llvm_bin[v->type]);
-                        *m_cur ++= '>';
-                    }
-                    break;
-
-                case 'D': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                        put_unchecked(type_name_llvm_big[v->type]);
-                        *m_cur ++= '>';
-                    }
-                    break;
-
-                case 'M': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        uint32_t type = v->type == (uint32_t) VarType::Bool
-                                            ? (uint32_t) VarType::UInt8
-                                            : v->type;
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                        put_unchecked(type_name_llvm[type]);
-                        *m_cur ++= '>';
-                    }
-                    break;
-
-                case 'v': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_unchecked(type_prefix[v->type]);
-                        put_u32_unchecked(v->reg_index);
-                    }
-                    break;
-
-                case 'V': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                        put_unchecked(type_name_llvm[v->type]);
-                        *m_cur ++= '>';
-                        *m_cur ++= ' ';
-                        put_unchecked(type_prefix[v->type]);
-                        put_u32_unchecked(v->reg_index);
-                    }
-                    break;
-
-                case 'l': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        VarType vt = (VarType) v->type;
-                        uint64_t literal = v->literal;
-
-                        if (vt == VarType::Float32) {
-                            float f;
-                            memcpy(&f, &literal, sizeof(float));
-                            double d = f;
-                            memcpy(&literal, &d, sizeof(uint64_t));
-                            vt = VarType::Float64;
-                        }
-
-                        if (vt == VarType::Float64) {
-                            *m_cur ++= '0';
-                            *m_cur ++= 'x';
-                            put_x64_unchecked(literal);
-                        } else {
-                            put_u64_unchecked(literal);
-                        }
-                    };
-                    break;
-
-                case 'a': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_u32_unchecked(v->unaligned ? 1 : type_size[v->type]);
-                    }
-                    break;
-
-                case 'A': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_u32_unchecked(v->unaligned ? 1 : (type_size[v->type] * jitc_llvm_vector_width));
-                    }
-                    break;
-
-                case 'o': {
-                        const Variable *v = va_arg(args2, const Variable *);
-                        put_u32_unchecked(v->param_offset / (uint32_t) sizeof(void *));
-                    }
-                    break;
-
-                case 'z':
-                    put_unchecked("zeroinitializer");
-                    break;
-
-                case '<':
-                    if (callable_depth > 0) {
-                        *m_cur ++= '<';
-                        put_u32_unchecked(jitc_llvm_vector_width);
-                        *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
-                    }
-                    break;
-
-                case '>':
-                    if (callable_depth > 0)
-                        *m_cur ++= '>';
-                    break;
+    const char *p = fmt;
+    while (true) {
+        size_t run = strcspn(p, "${|}");
+        if (run)
+            put(p, run);
+        p += run;
 
-                default:
-                    break;
-            }
+        char c = *p++;
+        if (c == '\0') {
+            break;
         } else if (c == '{') {
             if (jitc_llvm_opaque_pointers)
                 offset = size();
+            continue;
         } else if (c == '|') {
             if (offset) {
                 rewind_to(offset);
@@ -684,18 +379,205 @@ void StringBuffer::fmt_llvm(size_t nargs, const char *fmt, ...) {
             } else {
                 offset = size();
             }
+            continue;
         } else if (c == '}') {
             if (offset) {
                 rewind_to(offset);
                 if (jitc_llvm_opaque_pointers)
-                    put_unchecked("ptr");
+                    put("ptr");
                 offset = 0;
             }
-        } else {
-            *m_cur ++= c;
+            continue;
+        }
+
+        reserve(MAXSIZE_FMT_ITEM);
+        switch (*p++) {
+            case '{': *m_cur++= '{'; break;
+            case '}': *m_cur++= '}'; break;
+
+            case 'u': put_u32_unchecked(va_arg(args, uint32_t)); break;
+            case 'U': put_u64_unchecked(va_arg(args, uint64_t)); break;
+            case 'x': put_x32_unchecked(va_arg(args, uint32_t)); break;
+            case 'X': put_x64_unchecked(va_arg(args, uint64_t)); break;
+            case 'Q': put_q64_unchecked(va_arg(args, uint64_t)); break;
+
+            case 's': {
+                    const char *s = va_arg(args, const char *);
+                    put(s, strlen(s));
+                }
+                break;
+
+            case 'w':
+                put_u32_unchecked(jitc_llvm_vector_width);
+                break;
+
+            case 't': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_llvm[v->type]);
+                }
+                break;
+
+            case 'b': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_llvm_bin[v->type]);
+                }
+                break;
+
+            case 'd': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_llvm_big[v->type]);
+                }
+                break;
+
+
+            case 'h': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_name_llvm_abbrev[v->type]);
+                }
+                break;
+
+            case 'm': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    uint32_t type = v->type == (uint32_t) VarType::Bool
+                                        ? (uint32_t) VarType::UInt8
+                                        : v->type;
+                    put_unchecked(type_name_llvm[type]);
+                }
+                break;
+
+            case 'T': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                    put_unchecked(type_name_llvm[v->type]);
+                    *m_cur ++= '>';
+                }
+                break;
+
+            case 'B': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                    put_unchecked(type_name_llvm_bin[v->type]);
+                    *m_cur ++= '>';
+                }
+                break;
+
+            case 'D': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                    put_unchecked(type_name_llvm_big[v->type]);
+                    *m_cur ++= '>';
+                }
+                break;
+
+            case 'M': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    uint32_t type = v->type == (uint32_t) VarType::Bool
+                                        ? (uint32_t) VarType::UInt8
+                                        : v->type;
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                    put_unchecked(type_name_llvm[type]);
+                    *m_cur ++= '>';
+                }
+                break;
+
+            case 'v': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_unchecked(type_prefix[v->type]);
+                    put_u32_unchecked(jitc_var_scratch(v)->reg_index);
+                }
+                break;
+
+            case 'V': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                    put_unchecked(type_name_llvm[v->type]);
+                    *m_cur ++= '>';
+                    *m_cur ++= ' ';
+                    put_unchecked(type_prefix[v->type]);
+                    put_u32_unchecked(jitc_var_scratch(v)->reg_index);
+                }
+                break;
+
+            case 'l': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    VarType vt = (VarType) v->type;
+                    uint64_t literal = v->literal;
+
+                    if (vt == VarType::Float32) {
+                        float f;
+                        memcpy(&f, &literal, sizeof(float));
+                        double d = f;
+                        memcpy(&literal, &d, sizeof(uint64_t));
+                        vt = VarType::Float64;
+                    }
+
+                    if (vt == VarType::Float64) {
+                        *m_cur ++= '0';
+                        *m_cur ++= 'x';
+                        put_x64_unchecked(literal);
+                    } else if (vt == VarType::Float16) {
+                        // LLVM expects exactly 4 hex digits after '0xH'
+                        *m_cur ++= '0';
+                        *m_cur ++= 'x';
+                        *m_cur ++= 'H';
+                        for (int i = 3; i >= 0; --i)
+                            *m_cur ++= num[(literal >> (4 * i)) & 0xF];
+                    } else {
+                        put_u64_unchecked(literal);
+                    }
+                };
+                break;
+
+            case 'a': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_u32_unchecked(v->unaligned ? 1 : type_size[v->type]);
+                }
+                break;
+
+            case 'A': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_u32_unchecked(v->unaligned ? 1 : (type_size[v->type] * jitc_llvm_vector_width));
+                }
+                break;
+
+            case 'o': {
+                    const Variable *v = va_arg(args, const Variable *);
+                    put_u32_unchecked(jitc_var_scratch(v)->param_offset / (uint32_t) sizeof(void *));
+                }
+                break;
+
+            case 'z':
+                put_unchecked("zeroinitializer");
+                break;
+
+            case '<':
+                if (callable_depth > 0) {
+                    *m_cur ++= '<';
+                    put_u32_unchecked(jitc_llvm_vector_width);
+                    *m_cur ++= ' '; *m_cur ++= 'x'; *m_cur ++= ' ';
+                }
+                break;
+
+            case '>':
+                if (callable_depth > 0)
+                    *m_cur ++= '>';
+                break;
+
+            default:
+                break;
         }
     }
-    va_end(args2);
+    va_end(args);
 
     *m_cur = '\0';
 }
@@ -23,6 +23,9 @@
 // Maximum stringified length of a Dr.Jit type prefix
 #define MAXSIZE_TYPE_PREFIX    3
 
+// Upper bound on the length of a single '$' item of fmt_cuda/fmt_llvm
+#define MAXSIZE_FMT_ITEM       48
+
 /**
  * \brief String buffer class for building large strings sequentially
  *
@@ -209,11 +212,18 @@ private:
      */
     void expand(size_t nbytes);
 
+    /// Like \ref expand(), but only call it when the space is insufficient
+    void reserve(size_t nbytes) {
+        if (unlikely(!m_cur || m_cur + nbytes >= m_end))
+            expand(nbytes);
+    }
+
 private:
     char *m_start, *m_cur, *m_end;
 };
 
-extern StringBuffer buffer;
+/// Per-thread string buffer used to generate PTX/LLVM IR
+extern thread_local StringBuffer buffer;
 
 /// Helper function used to check that fmt_cuda/fmt_llvm process all arguments
 template <typename... Ts> constexpr size_t count_args(const Ts &...) {
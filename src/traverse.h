@@ -0,0 +1,138 @@
+/*
+    src/traverse.h -- Non-recursive traversal of the computation graph
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+#include "var.h"
+#include "log.h"
+
+/**
+ * \brief Set of visited variable indices with a constant-time \ref clear()
+ *
+ * Stores a generation stamp per variable index. An index is contained in the
+ * set if its stamp equals the current generation, hence clearing the set
+ * simply increments the generation counter.
+ */
+struct VisitedSet {
+    /// Remove all entries from the set
+    void clear() {
+        if (unlikely(++m_generation == 0)) {
+            std::fill(m_stamp.begin(), m_stamp.end(), 0u);
+            m_generation = 1;
+        }
+        m_size = 0;
+    }
+
+    /// Insert an index, returns \c false if it was already part of the set
+    bool insert(uint32_t index) {
+        if (unlikely(index >= m_stamp.size()))
+            m_stamp.resize(std::max((size_t) index + 1, state.variables.size()), 0u);
+
+        uint32_t &stamp = m_stamp[index];
+        if (stamp == m_generation)
+            return false;
+
+        stamp = m_generation;
+        m_size++;
+        return true;
+    }
+
+    /// Check if an index is part of the set
+    bool contains(uint32_t index) const {
+        return index < m_stamp.size() && m_stamp[index] == m_generation;
+    }
+
+    /// Return the number of entries
+    size_t size() const { return m_size; }
+
+private:
+    std::vector<uint32_t> m_stamp;
+    uint32_t m_generation = 1;
+    size_t m_size = 0;
+};
+
+/// Stack entry of \ref jitc_var_dfs()
+struct DFSFrame {
+    /// Variable being visited
+    uint32_t index;
+
+    /// Next dependency to be visited (entries >= 4 refer to 'Extra::dep')
+    uint32_t dep;
+
+    /// Supplemental dependencies, looked up once they are needed
+    const Extra *extra;
+};
+
+/**
+ * \brief Depth-first traversal of the computation graph
+ *
+ * Visits 'index' and all of its (transitive) dependencies, including ones
+ * stored in an 'Extra' record, that are not yet part of 'visited'. A
+ * dependency is only followed if <tt>filter(index)</tt> returns \c true.
+ * The function <tt>post(index, v)</tt> is invoked for each visited variable
+ * after all of its dependencies (post-order).
+ *
+ * The traversal uses the explicit stack 'stack' instead of recursion, which
+ * would overflow the call stack on long dependency chains. The callbacks must
+ * not create or free variables.
+ */
+template <typename Filter, typename Post>
+void jitc_var_dfs(uint32_t index, VisitedSet &visited,
+                  std::vector<DFSFrame> &stack, Filter &&filter, Post &&post) {
+    if (!visited.insert(index))
+        return;
+
+    stack.push_back(DFSFrame{ index, 0, nullptr });
+
+    while (!stack.empty()) {
+        DFSFrame &f = stack.back();
+        const Variable *v = jitc_var(f.index);
+        uint32_t next = 0;
+
+        while (f.dep < 4) {
+            uint32_t index_2 = v->dep[f.dep++];
+            if (index_2 == 0) {
+                f.dep = 4;
+                break;
+            }
+            if (filter(index_2) && visited.insert(index_2)) {
+                next = index_2;
+                break;
+            }
+        }
+
+        if (!next && unlikely(v->extra)) {
+            if (!f.extra) {
+                auto it = state.extra.find(f.index);
+                if (unlikely(it == state.extra.end()))
+                    jitc_fail("jit_var_dfs(): could not find matching 'extra' record!");
+                f.extra = &it->second;
+            }
+
+            while (f.dep - 4 < f.extra->n_dep) {
+                uint32_t index_2 = f.extra->dep[f.dep++ - 4];
+                if (index_2 && filter(index_2) && visited.insert(index_2)) {
+                    next = index_2;
+                    break;
+                }
+            }
+        }
+
+        if (next) {
+            // Note: invalidates 'f'
+            stack.push_back(DFSFrame{ next, 0, nullptr });
+            continue;
+        }
+
+        uint32_t index_done = f.index;
+        stack.pop_back();
+        post(index_done, v);
+    }
+}
@@ -7,15 +7,21 @@
     license that can be found in the LICENSE file.
 */
 
+#include <atomic>
 #include <condition_variable>
 #include "internal.h"
 #include "util.h"
+#include "stats.h"
 #include "var.h"
 #include "eval.h"
 #include "log.h"
 #include "vcall.h"
 #include "profiler.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  include <immintrin.h>
+#endif
+
 #if defined(_MSC_VER)
 #  pragma warning (disable: 4146) // unary minus operator applied to unsigned type, result still unsigned
 #endif
@@ -25,7 +31,7 @@ const char *reduction_name[(int) ReduceOp::Count] = { "none", "sum", "mul",
 
 /// Helper function: enqueue parallel CPU task (synchronous or asynchronous)
 template <typename Func>
-void jitc_submit_cpu(KernelType type, Func &&func, uint32_t width,
+void jitc_submit_cpu(KernelType type, Func &&func, size_t width,
                      uint32_t size = 1) {
 
     struct Payload { Func f; };
@@ -34,6 +40,15 @@ void jitc_submit_cpu(KernelType type, Func &&func, uint32_t width,
     static_assert(std::is_trivially_copyable<Payload>::value &&
                   std::is_trivially_destructible<Payload>::value, "Internal error!");
 
+    KernelStatsLaunch stats_launch { };
+    bool stats = jit_flag(JitFlag::KernelStats);
+    if (unlikely(stats)) {
+        stats_launch.backend = JitBackend::LLVM;
+        stats_launch.type = type;
+        stats_launch.size = width;
+        jitc_kernel_stats_begin(stats_launch, nullptr);
+    }
+
     Task *new_task = task_submit_dep(
         nullptr, &jitc_task, 1, size,
         [](uint32_t index, void *payload) { ((Payload *) payload)->f(index); },
@@ -54,10 +69,45 @@ void jitc_submit_cpu(KernelType type, Func &&func, uint32_t width,
         state.kernel_history.append(entry);
     }
 
+    if (unlikely(stats))
+        jitc_kernel_stats_end(stats_launch, nullptr, new_task);
+
     task_release(jitc_task);
     jitc_task = new_task;
 }
 
+/**
+ * \brief Check that an array size can be passed to a precompiled CUDA kernel
+ *
+ * The kernels in 'resources/kernels.cu' use 32-bit sizes and indices.
+ */
+static uint32_t jitc_cuda_size(const char *name, size_t size) {
+    if (unlikely(size > (size_t) UINT32_MAX))
+        jitc_raise("%s(): arrays with more than 2^32-1 entries are not supported "
+                   "by the CUDA backend (size=%zu)!", name, size);
+    return (uint32_t) size;
+}
+
+/// Report an operation that is only implemented by the LLVM backend
+static void jitc_cuda_unsupported(const char *name) {
+    jitc_raise("%s(): this operation is only supported by the LLVM backend!",
+               name);
+}
+
+/// Split 'size' elements into work units that are processed in parallel (LLVM)
+static uint32_t jitc_cpu_work_units(size_t size, size_t &unit_size) {
+    unit_size = size;
+    if (pool_size() <= 1 || size <= DRJIT_POOL_BLOCK_SIZE)
+        return 1;
+    unit_size = DRJIT_POOL_BLOCK_SIZE;
+    size_t units = (size + unit_size - 1) / unit_size;
+    if (unlikely(units > (size_t) UINT32_MAX)) {
+        units = UINT32_MAX;
+        unit_size = (size + units - 1) / units;
+    }
+    return (uint32_t) units;
+}
+
 void jitc_submit_gpu(KernelType type, CUfunction kernel, uint32_t block_count,
                      uint32_t thread_count, uint32_t shared_mem_bytes,
                      CUstream stream, void **args, void **extra,
@@ -73,6 +123,16 @@ void jitc_submit_gpu(KernelType type, CUfunction kernel, uint32_t block_count,
         cuda_check(cuEventRecord((CUevent) entry.event_start, stream));
     }
 
+    KernelStatsLaunch stats_launch { };
+    bool stats = flags & (uint32_t) JitFlag::KernelStats;
+    if (unlikely(stats)) {
+        stats_launch.backend = JitBackend::CUDA;
+        stats_launch.type = type;
+        stats_launch.device = thread_state(JitBackend::CUDA)->device;
+        stats_launch.size = width;
+        jitc_kernel_stats_begin(stats_launch, stream);
+    }
+
     cuda_check(cuLaunchKernel(kernel, block_count, 1, 1, thread_count, 1, 1,
                               shared_mem_bytes, stream, args, extra));
 
@@ -89,28 +149,46 @@ void jitc_submit_gpu(KernelType type, CUfunction kernel, uint32_t block_count,
 
         state.kernel_history.append(entry);
     }
+
+    if (unlikely(stats))
+        jitc_kernel_stats_end(stats_launch, stream, nullptr);
 }
 
 /// Fill a device memory region with constants of a given type
-void jitc_memset_async(JitBackend backend, void *ptr, uint32_t size_,
+/**
+ * \brief Shrink a fill pattern that consists of repeated copies of a
+ * narrower pattern (e.g. zero, or 0x3f803f80), which permits more efficient
+ * memset operations. Updates 'isize' and 'size' and returns the new pattern.
+ */
+static uint64_t jitc_memset_narrow(uint32_t &isize, size_t &size,
+                                   uint64_t value) {
+    while (isize > 1) {
+        uint32_t half = isize / 2;
+        uint64_t mask = (((uint64_t) 1) << (half * 8)) - 1,
+                 lo = value & mask, hi = (value >> (half * 8)) & mask;
+        if (lo != hi)
+            break;
+        value = lo;
+        isize = half;
+        size *= 2;
+    }
+    return value;
+}
+
+void jitc_memset_async(JitBackend backend, void *ptr, size_t size,
                        uint32_t isize, const void *src) {
     if (isize != 1 && isize != 2 && isize != 4 && isize != 8)
         jitc_raise("jit_memset_async(): invalid element size (must be 1, 2, 4, or 8)!");
 
-    jitc_trace("jit_memset_async(" DRJIT_PTR ", isize=%u, size=%u)",
-              (uintptr_t) ptr, isize, size_);
+    jitc_trace("jit_memset_async(" DRJIT_PTR ", isize=%u, size=%zu)",
+              (uintptr_t) ptr, isize, size);
 
-    if (size_ == 0)
+    if (size == 0)
         return;
 
-    size_t size = size_;
-
-    // Try to convert into ordinary memset if possible
-    uint64_t zero = 0;
-    if (memcmp(src, &zero, isize) == 0) {
-        size *= isize;
-        isize = 1;
-    }
+    uint64_t value = 0;
+    memcpy(&value, src, isize);
+    value = jitc_memset_narrow(isize, size, value);
 
     ThreadState *ts = thread_state(backend);
 
@@ -118,73 +196,81 @@ void jitc_memset_async(JitBackend backend, void *ptr, uint32_t size_,
         scoped_set_context guard(ts->context);
         switch (isize) {
             case 1:
-                cuda_check(cuMemsetD8Async((CUdeviceptr) ptr,
-                                           ((uint8_t *) src)[0], size,
-                                           ts->stream));
+                cuda_check(cuMemsetD8Async((CUdeviceptr) ptr, (uint8_t) value,
+                                           size, ts->stream));
                 break;
 
             case 2:
-                cuda_check(cuMemsetD16Async((CUdeviceptr) ptr,
-                                            ((uint16_t *) src)[0], size,
-                                            ts->stream));
+                cuda_check(cuMemsetD16Async((CUdeviceptr) ptr, (uint16_t) value,
+                                            size, ts->stream));
                 break;
 
             case 4:
-                cuda_check(cuMemsetD32Async((CUdeviceptr) ptr,
-                                            ((uint32_t *) src)[0], size,
-                                            ts->stream));
+                cuda_check(cuMemsetD32Async((CUdeviceptr) ptr, (uint32_t) value,
+                                            size, ts->stream));
                 break;
 
-            case 8: {
+            case 8:
+                if (size <= (size_t) UINT32_MAX) {
                     const Device &device = state.devices[ts->device];
-                    uint32_t block_count, thread_count;
-                    device.get_launch_config(&block_count, &thread_count, size_);
-                    void *args[] = { &ptr, &size_, (void *) src };
-                    CUfunction kernel = jitc_cuda_fill_64[device.id];
-                    jitc_submit_gpu(KernelType::Other, kernel, block_count,
-                                    thread_count, 0, ts->stream, args, nullptr,
-                                    size_);
+                    uint32_t size_32 = (uint32_t) size, block_count, thread_count;
+                    device.get_launch_config(&block_count, &thread_count, size_32);
+                    void *args[] = { &ptr, &size_32, &value };
+                    jitc_submit_gpu(KernelType::Other, jitc_cuda_fill_64[device.id],
+                                    block_count, thread_count, 0, ts->stream,
+                                    args, nullptr, size_32);
+                } else {
+                    /* The fill kernel takes a 32-bit size. Instead, write the
+                       two halves of the pattern as strided 2D memsets (pitch
+                       of 8 bytes), which take 64-bit sizes */
+                    for (int i = 0; i < 2; ++i)
+                        cuda_check(cuMemsetD2D32Async(
+                            (CUdeviceptr) ((uint32_t *) ptr + i),
+                            sizeof(uint64_t), (uint32_t) (value >> (32 * i)), 1,
+                            size, ts->stream));
                 }
                 break;
         }
     } else {
-        uint8_t src8[8] { };
-        memcpy(&src8, src, isize);
+        // Large fills are split into work units that run in parallel
+        size_t unit_size;
+        uint32_t units = jitc_cpu_work_units(size, unit_size);
 
         jitc_submit_cpu(KernelType::Other,
-            [ptr, src8, size, isize](uint32_t) {
+            [ptr, value, size, isize, unit_size](uint32_t index) {
+                size_t start = (size_t) index * unit_size,
+                       end = std::min(start + unit_size, size);
+
                 switch (isize) {
                     case 1:
-                        memset(ptr, src8[0], size);
+                        memset((uint8_t *) ptr + start, (uint8_t) value,
+                               end - start);
                         break;
 
                     case 2: {
-                            uint16_t value = ((uint16_t *) src8)[0],
-                                    *p = (uint16_t *) ptr;
-                            for (uint32_t i = 0; i < size; ++i)
-                                p[i] = value;
+                            uint16_t v = (uint16_t) value, *p = (uint16_t *) ptr;
+                            for (size_t i = start; i != end; ++i)
+                                p[i] = v;
                         }
                         break;
 
                     case 4: {
-                            uint32_t value = ((uint32_t *) src8)[0],
-                                    *p = (uint32_t *) ptr;
-                            for (uint32_t i = 0; i < size; ++i)
-                                p[i] = value;
+                            uint32_t v = (uint32_t) value, *p = (uint32_t *) ptr;
+                            for (size_t i = start; i != end; ++i)
+                                p[i] = v;
                         }
                         break;
 
                     case 8: {
-                            uint64_t value = ((uint64_t *) src8)[0],
-                                    *p = (uint64_t *) ptr;
-                            for (uint32_t i = 0; i < size; ++i)
+                            uint64_t *p = (uint64_t *) ptr;
+                            for (size_t i = start; i != end; ++i)
                                 p[i] = value;
                         }
                         break;
                 }
             },
 
-            (uint32_t) size
+            size, units
         );
     }
 }
@@ -194,6 +280,7 @@ void jitc_memcpy(JitBackend backend, void *dst, const void *src, size_t size) {
     ThreadState *ts = thread_state(backend);
 
     // Temporarily release the lock while copying
+    jitc_stat(Stat::ImplicitSyncs);
     jitc_sync_thread(ts);
     if (backend == JitBackend::CUDA) {
         scoped_set_context guard_2(ts->context);
@@ -203,27 +290,143 @@ void jitc_memcpy(JitBackend backend, void *dst, const void *src, size_t size) {
     }
 }
 
+/// Is 'ptr' the start of a host-pinned allocation made via jitc_malloc()?
+static bool jitc_is_host_pinned(const void *ptr) {
+    auto it = state.alloc_used.find((uintptr_t) ptr);
+    if (it == state.alloc_used.end())
+        return false;
+    auto [size, type, device] = alloc_info_decode(it->second.info);
+    (void) size; (void) device;
+    return type == AllocType::HostPinned;
+}
+
 /// Perform an asynchronous copy operation
 void jitc_memcpy_async(JitBackend backend, void *dst, const void *src, size_t size) {
     ThreadState *ts = thread_state(backend);
 
     if (backend == JitBackend::CUDA) {
         scoped_set_context guard(ts->context);
-        cuda_check(cuMemcpyAsync((CUdeviceptr) dst, (CUdeviceptr) src, size,
-                                 ts->stream));
+
+        /* Large transfers between pinned host memory and the device use the
+           copy stream, which keeps the DMA engines busy while kernels run on
+           the auxiliary streams. Events preserve the order of operations. */
+        if (size >= DRJIT_COPY_STREAM_THRESHOLD &&
+            (jitc_is_host_pinned(src) || jitc_is_host_pinned(dst))) {
+            CUstream stream = jitc_copy_stream_begin(ts);
+            cuda_check(cuMemcpyAsync((CUdeviceptr) dst, (CUdeviceptr) src,
+                                     size, stream));
+            jitc_copy_stream_end(ts);
+        } else {
+            cuda_check(cuMemcpyAsync((CUdeviceptr) dst, (CUdeviceptr) src,
+                                     size, ts->stream));
+        }
     } else {
+        // Large copies are split into work units that run in parallel
+        size_t unit_size;
+        uint32_t units = jitc_cpu_work_units((size + 63) / 64, unit_size);
+        unit_size *= 64;
+
         jitc_submit_cpu(
             KernelType::Other,
-            [dst, src, size](uint32_t) {
-                memcpy(dst, src, size);
+            [dst, src, size, unit_size](uint32_t index) {
+                size_t start = (size_t) index * unit_size,
+                       end = std::min(start + unit_size, size);
+                memcpy((uint8_t *) dst + start, (const uint8_t *) src + start,
+                       end - start);
             },
 
-            (uint32_t) size
+            size, units
         );
     }
 }
 
-using Reduction = void (*) (const void *ptr, uint32_t start, uint32_t end, void *out);
+void jitc_memcpy_peer_async(const PeerCopy *copies, uint32_t count) {
+    if (count == 0)
+        return;
+
+    // 1: source device, 2: destination device
+    std::vector<uint8_t> role(state.devices.size(), 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        role[copies[i].src_device] |= 1;
+        role[copies[i].dst_device] |= 2;
+    }
+
+    // Capture the work submitted to the source devices so far
+    for (size_t i = 0; i < role.size(); ++i) {
+        if (!(role[i] & 1))
+            continue;
+        const Device &dev = state.devices[i];
+        scoped_set_context guard(dev.context);
+        cuda_check(cuEventRecord(dev.event, dev.stream));
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const PeerCopy &c = copies[i];
+        const Device &src = state.devices[c.src_device],
+                     &dst = state.devices[c.dst_device];
+        scoped_set_context guard(dst.context);
+        if (c.src_device != c.dst_device)
+            cuda_check(cuStreamWaitEvent(dst.stream, src.event, 0));
+        cuda_check(cuMemcpyPeerAsync(c.dst, dst.context, c.src, src.context,
+                                     c.size, dst.stream));
+    }
+
+    // Later work on the source devices waits for the transfers
+    for (size_t i = 0; i < role.size(); ++i) {
+        if (!(role[i] & 2))
+            continue;
+        const Device &dst = state.devices[i];
+        /* Record */ {
+            scoped_set_context guard(dst.context);
+            cuda_check(cuEventRecord(dst.event, dst.stream));
+        }
+        for (size_t j = 0; j < role.size(); ++j) {
+            if (j == i || !(role[j] & 1))
+                continue;
+            const Device &src = state.devices[j];
+            scoped_set_context guard(src.context);
+            cuda_check(cuStreamWaitEvent(src.stream, dst.event, 0));
+        }
+    }
+}
+
+using Reduction = void (*) (const void *ptr, size_t start, size_t end, void *out);
+
+/**
+ * \brief Reduce the elements <tt>[start, end)</tt> of \c ptr using \c op
+ *
+ * Instead of a single scalar accumulator, the loop maintains 64 bytes worth of
+ * independent accumulators that the compiler keeps in vector registers (e.g.,
+ * one AVX512 or two AVX registers). This removes the serial dependency chain
+ * of the scalar version, and the accumulators are combined via a tree at the
+ * end.
+ */
+template <typename Value, typename Op>
+static void jitc_reduce_block(const void *ptr_, size_t start, size_t end,
+                              Value init, void *out, Op op) {
+    constexpr size_t Lanes = 64 / sizeof(Value);
+    const Value *ptr = (const Value *) ptr_;
+
+    Value acc[Lanes];
+    for (size_t j = 0; j < Lanes; ++j)
+        acc[j] = init;
+
+    size_t i = start;
+    for (; i + Lanes <= end; i += Lanes) {
+        for (size_t j = 0; j < Lanes; ++j)
+            acc[j] = op(acc[j], ptr[i + j]);
+    }
+
+    for (size_t j = 0; i + j < end; ++j)
+        acc[j] = op(acc[j], ptr[i + j]);
+
+    for (size_t n = Lanes / 2; n > 0; n /= 2) {
+        for (size_t j = 0; j < n; ++j)
+            acc[j] = op(acc[j], acc[j + n]);
+    }
+
+    *((Value *) out) = acc[0];
+}
 
 template <typename Value>
 static Reduction jitc_reduce_create(ReduceOp rtype) {
@@ -231,61 +434,51 @@ static Reduction jitc_reduce_create(ReduceOp rtype) {
 
     switch (rtype) {
         case ReduceOp::Add:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const Value *ptr = (const Value *) ptr_;
-                Value result = 0;
-                for (uint32_t i = start; i != end; ++i)
-                    result += ptr[i];
-                *((Value *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                jitc_reduce_block<Value>(
+                    ptr, start, end, Value(0), out,
+                    [](Value a, Value b) { return Value(a + b); });
             };
 
         case ReduceOp::Mul:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const Value *ptr = (const Value *) ptr_;
-                Value result = 1;
-                for (uint32_t i = start; i != end; ++i)
-                    result *= ptr[i];
-                *((Value *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                jitc_reduce_block<Value>(
+                    ptr, start, end, Value(1), out,
+                    [](Value a, Value b) { return Value(a * b); });
             };
 
         case ReduceOp::Max:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const Value *ptr = (const Value *) ptr_;
-                Value result = std::is_integral<Value>::value
-                                   ?  std::numeric_limits<Value>::min()
-                                   : -std::numeric_limits<Value>::infinity();
-                for (uint32_t i = start; i != end; ++i)
-                    result = std::max(result, ptr[i]);
-                *((Value *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                Value init = std::is_integral<Value>::value
+                                 ?  std::numeric_limits<Value>::min()
+                                 : -std::numeric_limits<Value>::infinity();
+                jitc_reduce_block<Value>(
+                    ptr, start, end, init, out,
+                    [](Value a, Value b) { return std::max(a, b); });
             };
 
         case ReduceOp::Min:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const Value *ptr = (const Value *) ptr_;
-                Value result = std::is_integral<Value>::value
-                                   ?  std::numeric_limits<Value>::max()
-                                   :  std::numeric_limits<Value>::infinity();
-                for (uint32_t i = start; i != end; ++i)
-                    result = std::min(result, ptr[i]);
-                *((Value *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                Value init = std::is_integral<Value>::value
+                                 ?  std::numeric_limits<Value>::max()
+                                 :  std::numeric_limits<Value>::infinity();
+                jitc_reduce_block<Value>(
+                    ptr, start, end, init, out,
+                    [](Value a, Value b) { return std::min(a, b); });
             };
 
         case ReduceOp::Or:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const UInt *ptr = (const UInt *) ptr_;
-                UInt result = 0;
-                for (uint32_t i = start; i != end; ++i)
-                    result |= ptr[i];
-                *((UInt *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                jitc_reduce_block<UInt>(
+                    ptr, start, end, UInt(0), out,
+                    [](UInt a, UInt b) { return UInt(a | b); });
             };
 
         case ReduceOp::And:
-            return [](const void *ptr_, uint32_t start, uint32_t end, void *out) {
-                const UInt *ptr = (const UInt *) ptr_;
-                UInt result = (UInt) -1;
-                for (uint32_t i = start; i != end; ++i)
-                    result &= ptr[i];
-                *((UInt *) out) = result;
+            return [](const void *ptr, size_t start, size_t end, void *out) {
+                jitc_reduce_block<UInt>(
+                    ptr, start, end, UInt(-1), out,
+                    [](UInt a, UInt b) { return UInt(a & b); });
             };
 
         default: jitc_raise("jit_reduce_create(): unsupported reduction type!");
@@ -309,16 +502,29 @@ static Reduction jitc_reduce_create(VarType type, ReduceOp rtype) {
 }
 
 void jitc_reduce(JitBackend backend, VarType type, ReduceOp rtype, const void *ptr,
-                uint32_t size, void *out) {
+                size_t size_, void *out) {
     ThreadState *ts = thread_state(backend);
 
-    jitc_log(Debug, "jit_reduce(" DRJIT_PTR ", type=%s, rtype=%s, size=%u)",
+    jitc_log(Debug, "jit_reduce(" DRJIT_PTR ", type=%s, rtype=%s, size=%zu)",
             (uintptr_t) ptr, type_name[(int) type],
-            reduction_name[(int) rtype], size);
+            reduction_name[(int) rtype], size_);
 
     uint32_t tsize = type_size[(int) type];
 
-    if (backend == JitBackend::CUDA) {
+    if (backend == JitBackend::CUDA && size_ > (size_t) UINT32_MAX) {
+        // The reduction kernel takes a 32-bit size, reduce chunks separately
+        size_t chunk_size = (size_t) 1 << 31,
+               chunks = (size_ + chunk_size - 1) / chunk_size;
+        void *temp = jitc_malloc(AllocType::Device, chunks * tsize);
+        for (size_t i = 0; i < chunks; ++i)
+            jitc_reduce(backend, type, rtype,
+                        (const uint8_t *) ptr + i * chunk_size * tsize,
+                        std::min(chunk_size, size_ - i * chunk_size),
+                        (uint8_t *) temp + i * tsize);
+        jitc_reduce(backend, type, rtype, temp, chunks, out);
+        jitc_free(temp);
+    } else if (backend == JitBackend::CUDA) {
+        uint32_t size = (uint32_t) size_;
         scoped_set_context guard(ts->context);
         const Device &device = state.devices[ts->device];
         CUfunction func = jitc_cuda_reductions[(int) rtype][(int) type][device.id];
@@ -356,27 +562,24 @@ void jitc_reduce(JitBackend backend, VarType type, ReduceOp rtype, const void *p
             jitc_free(temp);
         }
     } else {
-        uint32_t block_size = size, blocks = 1;
-        if (pool_size() > 1) {
-            block_size = DRJIT_POOL_BLOCK_SIZE;
-            blocks     = (size + block_size - 1) / block_size;
-        }
+        size_t size = size_, block_size;
+        uint32_t blocks = jitc_cpu_work_units(size, block_size);
 
         void *target = out;
         if (blocks > 1)
-            target = jitc_malloc(AllocType::HostAsync, blocks * tsize);
+            target = jitc_malloc(AllocType::HostAsync, (size_t) blocks * tsize);
 
         Reduction reduction = jitc_reduce_create(type, rtype);
         jitc_submit_cpu(
             KernelType::Reduce,
             [block_size, size, tsize, ptr, reduction, target](uint32_t index) {
-                reduction(ptr, index * block_size,
-                          std::min((index + 1) * block_size, size),
-                          (uint8_t *) target + index * tsize);
+                size_t start = (size_t) index * block_size;
+                reduction(ptr, start, std::min(start + block_size, size),
+                          (uint8_t *) target + (size_t) index * tsize);
             },
 
             size,
-            std::max(1u, blocks));
+            blocks);
 
         if (blocks > 1) {
             jitc_reduce(backend, type, rtype, target, blocks, out);
@@ -386,16 +589,16 @@ void jitc_reduce(JitBackend backend, VarType type, ReduceOp rtype, const void *p
 }
 
 /// 'All' reduction for boolean arrays
-bool jitc_all(JitBackend backend, uint8_t *values, uint32_t size) {
+bool jitc_all(JitBackend backend, uint8_t *values, size_t size) {
     /* When \c size is not a multiple of 4, the implementation will initialize up
        to 3 bytes beyond the end of the supplied range so that an efficient 32 bit
        reduction algorithm can be used. This is fine for allocations made using
        \ref jit_malloc(), which allow for this. */
 
-    uint32_t reduced_size = (size + 3) / 4,
-             trailing     = reduced_size * 4 - size;
+    size_t reduced_size = (size + 3) / 4,
+           trailing     = reduced_size * 4 - size;
 
-    jitc_log(Debug, "jit_all(" DRJIT_PTR ", size=%u)", (uintptr_t) values, size);
+    jitc_log(Debug, "jit_all(" DRJIT_PTR ", size=%zu)", (uintptr_t) values, size);
 
     if (trailing) {
         bool filler = true;
@@ -420,16 +623,16 @@ bool jitc_all(JitBackend backend, uint8_t *values, uint32_t size) {
 }
 
 /// 'Any' reduction for boolean arrays
-bool jitc_any(JitBackend backend, uint8_t *values, uint32_t size) {
+bool jitc_any(JitBackend backend, uint8_t *values, size_t size) {
     /* When \c size is not a multiple of 4, the implementation will initialize up
        to 3 bytes beyond the end of the supplied range so that an efficient 32 bit
        reduction algorithm can be used. This is fine for allocations made using
        \ref jit_malloc(), which allow for this. */
 
-    uint32_t reduced_size = (size + 3) / 4,
-             trailing     = reduced_size * 4 - size;
+    size_t reduced_size = (size + 3) / 4,
+           trailing     = reduced_size * 4 - size;
 
-    jitc_log(Debug, "jit_any(" DRJIT_PTR ", size=%u)", (uintptr_t) values, size);
+    jitc_log(Debug, "jit_any(" DRJIT_PTR ", size=%zu)", (uintptr_t) values, size);
 
     if (trailing) {
         bool filler = false;
@@ -453,18 +656,196 @@ bool jitc_any(JitBackend backend, uint8_t *values, uint32_t size) {
     return result;
 }
 
+/// Pending result of an asynchronous reduction, see \ref jitc_reduce_async()
+struct JitFuture {
+    JitBackend backend;
+    VarType type;
+    ReduceOp rtype;
+
+    /// Number of bytes of 'data' that must be combined (masks, see jitc_any())
+    uint32_t mask_bytes = 0;
+
+    /// Reduction output in pinned (CUDA) or host (LLVM) memory
+    void *data = nullptr;
+
+    /// The result of literal reductions is known right away
+    uint64_t value = 0;
+
+    /// Signaled when the reduction has finished (CUDA)
+    CUevent event = nullptr;
+
+    /// Task that sets 'done' once the reduction has finished (LLVM)
+    Task *task = nullptr;
+    std::atomic<bool> done { false };
+};
+
+JitFuture *jitc_reduce_async(JitBackend backend, VarType type, ReduceOp rtype,
+                             void *ptr, size_t size) {
+    JitFuture *f = new JitFuture();
+    f->backend = backend;
+    f->type = type;
+    f->rtype = rtype;
+
+    jitc_log(Debug, "jit_reduce_async(" DRJIT_PTR ", type=%s, rtype=%s, size=%zu)",
+             (uintptr_t) ptr, type_name[(int) type], reduction_name[(int) rtype],
+             size);
+
+    // The final reduction writes straight into pinned memory (no copy)
+    f->data = jitc_malloc(backend == JitBackend::CUDA ? AllocType::HostPinned
+                                                      : AllocType::HostAsync,
+                          sizeof(uint64_t));
+
+    if (type == VarType::Bool) {
+        // Reduce masks 4 bytes at a time, like jitc_any() and jitc_all()
+        size_t reduced_size = (size + 3) / 4,
+               trailing     = reduced_size * 4 - size;
+
+        if (trailing) {
+            bool filler = rtype == ReduceOp::And;
+            jitc_memset_async(backend, (uint8_t *) ptr + size, trailing,
+                              sizeof(bool), &filler);
+        }
+
+        f->mask_bytes = 4;
+        jitc_reduce(backend, VarType::UInt32, rtype, ptr, reduced_size, f->data);
+    } else {
+        jitc_reduce(backend, type, rtype, ptr, size, f->data);
+    }
+
+    if (backend == JitBackend::CUDA) {
+        ThreadState *ts = thread_state(backend);
+        scoped_set_context guard(ts->context);
+        cuda_check(cuEventCreate(&f->event, CU_EVENT_DISABLE_TIMING));
+        cuda_check(cuEventRecord(f->event, ts->stream));
+    } else {
+        f->task = task_submit_dep(
+            nullptr, &jitc_task, 1, 1,
+            [](uint32_t, void *payload) {
+                (*(JitFuture **) payload)->done.store(true);
+            },
+            &f, sizeof(JitFuture *), nullptr, 0);
+    }
+
+    return f;
+}
+
+JitFuture *jitc_future_literal(JitBackend backend, VarType type,
+                               uint64_t value) {
+    JitFuture *f = new JitFuture();
+    f->backend = backend;
+    f->type = type;
+    f->rtype = ReduceOp::None;
+    f->value = value;
+    f->done.store(true);
+    return f;
+}
+
+bool jitc_future_ready(JitFuture *f) {
+    if (f->event) {
+        ThreadState *ts = thread_state(f->backend);
+        scoped_set_context guard(ts->context);
+        CUresult rv = cuEventQuery(f->event);
+        if (rv == CUDA_ERROR_NOT_READY)
+            return false;
+        cuda_check(rv);
+        return true;
+    }
+
+    return f->done.load();
+}
+
+void jitc_future_get(JitFuture *f, void *out) {
+    if (f->event) {
+        ThreadState *ts = thread_state(f->backend);
+        scoped_set_context guard(ts->context);
+        /* Unlock while synchronizing */ {
+            unlock_guard guard_2(state.lock);
+            cuda_check(cuEventSynchronize(f->event));
+        }
+        cuda_check(cuEventDestroy(f->event));
+    } else if (f->task) {
+        /* Unlock while synchronizing */ {
+            unlock_guard guard(state.lock);
+            task_wait_and_release(f->task);
+        }
+    }
+
+    if (f->data) {
+        memcpy(&f->value, f->data,
+               f->mask_bytes ? f->mask_bytes : type_size[(int) f->type]);
+        jitc_free(f->data);
+    }
+
+    if (f->mask_bytes) {
+        const uint8_t *b = (const uint8_t *) &f->value;
+        bool result = f->rtype == ReduceOp::And
+                          ? (b[0] & b[1] & b[2] & b[3]) != 0
+                          : (b[0] | b[1] | b[2] | b[3]) != 0;
+        memcpy(out, &result, sizeof(bool));
+    } else {
+        memcpy(out, &f->value, type_size[(int) f->type]);
+    }
+
+    delete f;
+}
+
 template <typename T>
-void sum_reduce_1(uint32_t start, uint32_t end, const void *in_, uint32_t index,
+void sum_reduce_1(size_t start, size_t end, const void *in, uint32_t index,
                   void *scratch) {
-    const T *in = (const T *) in_;
-    T accum = T(0);
-    for (uint32_t i = start; i != end; ++i)
-        accum += in[i];
-    ((T*) scratch)[index] = accum;
+    jitc_reduce_block<T>(in, start, end, T(0), (T *) scratch + index,
+                         [](T a, T b) { return T(a + b); });
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+/**
+ * \brief Prefix sum of 32-bit values using SSE2 registers
+ *
+ * Each step scans two registers with 4 elements in place. Both only depend on
+ * the running sum via a single addition, which shortens the dependency chain
+ * from one addition per element to one per 8 elements. Returns the position
+ * where the caller must continue with the remainder.
+ */
+template <typename T, typename Add>
+static size_t sum_reduce_2_sse(size_t i, size_t end, const T *in, T *out,
+                               T &accum, bool exclusive, Add add) {
+    int accum_i;
+    memcpy(&accum_i, &accum, sizeof(T));
+    __m128i carry = _mm_set1_epi32(accum_i);
+
+    for (; i + 8 <= end; i += 8) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *) (in + i)),
+                x1 = _mm_loadu_si128((const __m128i *) (in + i + 4));
+
+        x0 = add(x0, _mm_slli_si128(x0, 4));
+        x1 = add(x1, _mm_slli_si128(x1, 4));
+        x0 = add(x0, _mm_slli_si128(x0, 8));
+        x1 = add(x1, _mm_slli_si128(x1, 8));
+        x1 = add(x1, _mm_shuffle_epi32(x0, _MM_SHUFFLE(3, 3, 3, 3)));
+
+        __m128i incl0 = add(x0, carry), incl1 = add(x1, carry);
+
+        if (exclusive) {
+            // Shift by one element, filling in the preceding sum
+            x0 = _mm_or_si128(_mm_slli_si128(incl0, 4), _mm_srli_si128(carry, 12));
+            x1 = _mm_or_si128(_mm_slli_si128(incl1, 4), _mm_srli_si128(incl0, 12));
+        } else {
+            x0 = incl0;
+            x1 = incl1;
+        }
+
+        _mm_storeu_si128((__m128i *) (out + i), x0);
+        _mm_storeu_si128((__m128i *) (out + i + 4), x1);
+        carry = _mm_shuffle_epi32(incl1, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    accum_i = _mm_cvtsi128_si32(carry);
+    memcpy(&accum, &accum_i, sizeof(T));
+    return i;
 }
+#endif
 
 template <typename T>
-void sum_reduce_2(uint32_t start, uint32_t end, const void *in_, void *out_,
+void sum_reduce_2(size_t start, size_t end, const void *in_, void *out_,
                   uint32_t index, const void *scratch, bool exclusive) {
     const T *in = (const T *) in_;
     T *out = (T *) out_;
@@ -475,14 +856,28 @@ void sum_reduce_2(uint32_t start, uint32_t end, const void *in_, void *out_,
     else
         accum = T(0);
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if constexpr (std::is_same<T, float>::value)
+        start = sum_reduce_2_sse(start, end, in, out, accum, exclusive,
+                                 [](__m128i a, __m128i b) {
+                                     return _mm_castps_si128(_mm_add_ps(
+                                         _mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+                                 });
+    else if constexpr (std::is_same<T, uint32_t>::value)
+        start = sum_reduce_2_sse(start, end, in, out, accum, exclusive,
+                                 [](__m128i a, __m128i b) {
+                                     return _mm_add_epi32(a, b);
+                                 });
+#endif
+
     if (exclusive) {
-        for (uint32_t i = start; i != end; ++i) {
+        for (size_t i = start; i != end; ++i) {
             T value = in[i];
             out[i] = accum;
             accum += value;
         }
     } else {
-        for (uint32_t i = start; i != end; ++i) {
+        for (size_t i = start; i != end; ++i) {
             T value = in[i];
             accum += value;
             out[i] = accum;
@@ -490,7 +885,7 @@ void sum_reduce_2(uint32_t start, uint32_t end, const void *in_, void *out_,
     }
 }
 
-void sum_reduce_1(VarType vt, uint32_t start, uint32_t end, const void *in, uint32_t index, void *scratch) {
+void sum_reduce_1(VarType vt, size_t start, size_t end, const void *in, uint32_t index, void *scratch) {
     switch (vt) {
         case VarType::UInt32:  sum_reduce_1<uint32_t>(start, end, in, index, scratch); break;
         case VarType::UInt64:  sum_reduce_1<uint64_t>(start, end, in, index, scratch); break;
@@ -501,7 +896,7 @@ void sum_reduce_1(VarType vt, uint32_t start, uint32_t end, const void *in, uint
     }
 }
 
-void sum_reduce_2(VarType vt, uint32_t start, uint32_t end, const void *in, void *out, uint32_t index, const void *scratch, bool exclusive) {
+void sum_reduce_2(VarType vt, size_t start, size_t end, const void *in, void *out, uint32_t index, const void *scratch, bool exclusive) {
     switch (vt) {
         case VarType::UInt32:  sum_reduce_2<uint32_t>(start, end, in, out, index, scratch, exclusive); break;
         case VarType::UInt64:  sum_reduce_2<uint64_t>(start, end, in, out, index, scratch, exclusive); break;
@@ -514,8 +909,8 @@ void sum_reduce_2(VarType vt, uint32_t start, uint32_t end, const void *in, void
 
 /// Exclusive prefix sum
 void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
-               const void *in, uint32_t size, void *out) {
-    if (size == 0)
+               const void *in, size_t size_, void *out) {
+    if (size_ == 0)
         return;
     if (vt == VarType::Int32)
         vt = VarType::UInt32;
@@ -524,6 +919,7 @@ void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
     ThreadState *ts = thread_state(backend);
 
     if (backend == JitBackend::CUDA) {
+        uint32_t size = jitc_cuda_size("jit_prefix_sum", size_);
         const Device &device = state.devices[ts->device];
         scoped_set_context guard(ts->context);
 
@@ -607,27 +1003,24 @@ void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
             jitc_free(scratch);
         }
     } else {
-        uint32_t block_size = size, blocks = 1;
-        if (pool_size() > 1) {
-            block_size = DRJIT_POOL_BLOCK_SIZE;
-            blocks     = (size + block_size - 1) / block_size;
-        }
+        size_t size = size_, block_size;
+        uint32_t blocks = jitc_cpu_work_units(size, block_size);
 
         jitc_log(Debug,
                 "jit_prefix_sum(" DRJIT_PTR " -> " DRJIT_PTR
-                ", size=%u, block_size=%u, blocks=%u)",
+                ", size=%zu, block_size=%zu, blocks=%u)",
                 (uintptr_t) in, (uintptr_t) out, size, block_size, blocks);
 
         void *scratch = nullptr;
 
         if (blocks > 1) {
-            scratch = (void *) jitc_malloc(AllocType::HostAsync, blocks * isize);
+            scratch = (void *) jitc_malloc(AllocType::HostAsync, (size_t) blocks * isize);
 
             jitc_submit_cpu(
                 KernelType::Other,
                 [block_size, size, in, vt, scratch](uint32_t index) {
-                    uint32_t start = index * block_size,
-                             end = std::min(start + block_size, size);
+                    size_t start = (size_t) index * block_size,
+                           end = std::min(start + block_size, size);
 
                     sum_reduce_1(vt, start, end, in, index, scratch);
                 },
@@ -639,8 +1032,8 @@ void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
         jitc_submit_cpu(
             KernelType::Other,
             [block_size, size, in, out, vt, scratch, exclusive](uint32_t index) {
-                uint32_t start = index * block_size,
-                         end = std::min(start + block_size, size);
+                size_t start = (size_t) index * block_size,
+                       end = std::min(start + block_size, size);
 
                 sum_reduce_2(vt, start, end, in, out, index, scratch, exclusive);
             },
@@ -651,11 +1044,55 @@ void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
     }
 }
 
+/// Scalar part of jitc_compress(): write the indices of nonzero mask entries
+static uint32_t jitc_compress_block(const uint8_t *in, uint32_t start,
+                                    uint32_t end, uint32_t *out,
+                                    uint32_t accum) {
+    for (uint32_t i = start; i != end; ++i) {
+        uint32_t value = (uint32_t) in[i];
+        if (value)
+            out[accum] = i;
+        accum += value;
+    }
+    return accum;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define DRJIT_COMPRESS_AVX512 1
+
+/// Like jitc_compress_block(), but uses AVX-512 compress-store instructions
+__attribute__((target("avx512f")))
+static uint32_t jitc_compress_block_avx512(const uint8_t *in, uint32_t start,
+                                           uint32_t end, uint32_t *out,
+                                           uint32_t accum) {
+    __m512i index = _mm512_add_epi32(
+                _mm512_set1_epi32((int) start),
+                _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                  13, 14, 15)),
+            step = _mm512_set1_epi32(16);
+
+    uint32_t i = start;
+    for (; end - i >= 16; i += 16) {
+        // The zero-masking variant avoids GCC's -Wmaybe-uninitialized
+        __m512i value = _mm512_maskz_cvtepu8_epi32(
+            (__mmask16) 0xFFFF, _mm_loadu_si128((const __m128i *) (in + i)));
+        __mmask16 active = _mm512_test_epi32_mask(value, value);
+        _mm512_mask_compressstoreu_epi32(out + accum, active, index);
+        accum += (uint32_t) __builtin_popcount((uint32_t) active);
+        index = _mm512_add_epi32(index, step);
+    }
+
+    return jitc_compress_block(in, i, end, out, accum);
+}
+#endif
+
 /// Mask compression
 uint32_t jitc_compress(JitBackend backend, const uint8_t *in, uint32_t size, uint32_t *out) {
     if (size == 0)
         return 0;
 
+    ImplicitSync sync("jit_compress", 0);
+
     ThreadState *ts = thread_state(backend);
 
     if (backend == JitBackend::CUDA) {
@@ -775,9 +1212,17 @@ uint32_t jitc_compress(JitBackend backend, const uint8_t *in, uint32_t size, uin
             jitc_prefix_sum(backend, VarType::UInt32, true, scratch, blocks, scratch);
         }
 
+        // Stream compaction via 'vpcompressd' if the target supports AVX-512
+#if defined(DRJIT_COMPRESS_AVX512)
+        bool avx512 = jitc_llvm_has_feature("avx512f");
+#else
+        bool avx512 = false;
+#endif
+
         jitc_submit_cpu(
             KernelType::Other,
-            [block_size, size, scratch, in, out, &count_out](uint32_t index) {
+            [block_size, size, scratch, in, out, avx512,
+             &count_out](uint32_t index) {
                 uint32_t start = index * block_size,
                          end = std::min(start + block_size, size);
 
@@ -785,12 +1230,13 @@ uint32_t jitc_compress(JitBackend backend, const uint8_t *in, uint32_t size, uin
                 if (scratch)
                     accum = scratch[index];
 
-                for (uint32_t i = start; i != end; ++i) {
-                    uint32_t value = (uint32_t) in[i];
-                    if (value)
-                        out[accum] = i;
-                    accum += value;
-                }
+#if defined(DRJIT_COMPRESS_AVX512)
+                if (avx512)
+                    accum = jitc_compress_block_avx512(in, start, end, out, accum);
+                else
+#endif
+                    accum = jitc_compress_block(in, start, end, out, accum);
+                (void) avx512;
 
                 if (end == size)
                     count_out = accum;
@@ -806,6 +1252,292 @@ uint32_t jitc_compress(JitBackend backend, const uint8_t *in, uint32_t size, uin
     }
 }
 
+/// Reduce contiguous segments of an array delimited by an offset table
+void jitc_segmented_reduce(JitBackend backend, VarType type, ReduceOp rtype,
+                           const void *in, const uint32_t *offsets,
+                           uint32_t segment_count, void *out) {
+    if (backend == JitBackend::CUDA)
+        jitc_cuda_unsupported("jit_segmented_reduce");
+
+    if (segment_count == 0)
+        return;
+
+    jitc_log(Debug,
+             "jit_segmented_reduce(" DRJIT_PTR " -> " DRJIT_PTR
+             ", type=%s, rtype=%s, segments=%u)",
+             (uintptr_t) in, (uintptr_t) out, type_name[(int) type],
+             reduction_name[(int) rtype], segment_count);
+
+    uint32_t tsize = type_size[(int) type];
+    Reduction reduction = jitc_reduce_create(type, rtype);
+
+    // Segments can have any size, give each worker a few work units
+    uint32_t units = std::min(segment_count, std::max(pool_size(), 1u) * 4),
+             unit_size = (segment_count + units - 1) / units;
+    units = (segment_count + unit_size - 1) / unit_size;
+
+    jitc_submit_cpu(
+        KernelType::Reduce,
+        [in, offsets, out, reduction, tsize, unit_size,
+         segment_count](uint32_t index) {
+            uint32_t start = index * unit_size,
+                     end = std::min(start + unit_size, segment_count);
+
+            for (uint32_t i = start; i != end; ++i)
+                reduction(in, offsets[i], offsets[i + 1],
+                          (uint8_t *) out + (size_t) i * tsize);
+        },
+
+        segment_count, units
+    );
+}
+
+/// Reduce the values associated with runs of equal keys
+uint32_t jitc_reduce_by_key(JitBackend backend, VarType type, ReduceOp rtype,
+                            const uint32_t *keys, const void *values,
+                            uint32_t size, uint32_t *keys_out,
+                            void *values_out) {
+    if (backend == JitBackend::CUDA)
+        jitc_cuda_unsupported("jit_reduce_by_key");
+
+    if (size == 0)
+        return 0;
+
+    jitc_log(Debug,
+             "jit_reduce_by_key(" DRJIT_PTR ", " DRJIT_PTR
+             ", type=%s, rtype=%s, size=%u)",
+             (uintptr_t) keys, (uintptr_t) values, type_name[(int) type],
+             reduction_name[(int) rtype], size);
+
+    // 1. Flag the first entry of every run of equal keys
+    uint8_t *heads = (uint8_t *) jitc_malloc(AllocType::HostAsync, size);
+
+    size_t unit_size;
+    uint32_t units = jitc_cpu_work_units(size, unit_size);
+
+    jitc_submit_cpu(
+        KernelType::Other,
+        [keys, heads, size, unit_size](uint32_t index) {
+            size_t start = (size_t) index * unit_size,
+                   end = std::min(start + unit_size, (size_t) size);
+
+            for (size_t i = start; i != end; ++i)
+                heads[i] = (i == 0 || keys[i] != keys[i - 1]) ? 1 : 0;
+        },
+
+        size, units
+    );
+
+    // 2. Turn the flags into segment offsets (this synchronizes)
+    uint32_t *offsets = (uint32_t *) jitc_malloc(
+        AllocType::HostAsync, ((size_t) size + 1) * sizeof(uint32_t));
+    uint32_t count = jitc_compress(backend, heads, size, offsets);
+    jitc_free(heads);
+    jitc_poke(backend, offsets + count, &size, sizeof(uint32_t));
+
+    // 3. Fetch the key of each segment and reduce the associated values
+    units = jitc_cpu_work_units(count, unit_size);
+
+    jitc_submit_cpu(
+        KernelType::Other,
+        [keys, offsets, keys_out, count, unit_size](uint32_t index) {
+            size_t start = (size_t) index * unit_size,
+                   end = std::min(start + unit_size, (size_t) count);
+
+            for (size_t i = start; i != end; ++i)
+                keys_out[i] = keys[offsets[i]];
+        },
+
+        count, units
+    );
+
+    jitc_segmented_reduce(backend, type, rtype, values, offsets, count,
+                          values_out);
+    jitc_free(offsets);
+
+    return count;
+}
+
+/// Number of buckets per pass of the radix sort (8-bit digits)
+static const uint32_t radix_sort_digits = 256;
+
+/// One pass of the parallel LSD radix sort (LLVM backend)
+template <typename Key>
+static void jitc_radix_sort_pass_cpu(const Key *keys_in,
+                                     const uint32_t *values_in, Key *keys_out,
+                                     uint32_t *values_out, uint32_t size,
+                                     uint32_t shift, uint32_t *hist,
+                                     uint32_t units, size_t unit_size) {
+    // 1. Digit histogram of each work unit
+    jitc_submit_cpu(
+        KernelType::Other,
+        [keys_in, size, shift, hist, unit_size](uint32_t index) {
+            size_t start = (size_t) index * unit_size,
+                   end = std::min(start + unit_size, (size_t) size);
+
+            uint32_t *h = hist + (size_t) index * radix_sort_digits;
+            memset(h, 0, radix_sort_digits * sizeof(uint32_t));
+
+            for (size_t i = start; i != end; ++i)
+                h[(uint32_t) (keys_in[i] >> shift) & (radix_sort_digits - 1)]++;
+        },
+
+        size, units
+    );
+
+    /* 2. Exclusive prefix sum in (digit, work unit) order. When all keys share
+          the same digit, the pass doesn't change their order, which is
+          recorded in the last entry of 'hist'. */
+    jitc_submit_cpu(
+        KernelType::Other,
+        [size, hist, units](uint32_t) {
+            uint32_t sum = 0, trivial = 0;
+            for (uint32_t d = 0; d < radix_sort_digits; ++d) {
+                uint32_t start = sum;
+                for (uint32_t u = 0; u < units; ++u) {
+                    uint32_t &value = hist[(size_t) u * radix_sort_digits + d];
+                    uint32_t count = value;
+                    value = sum;
+                    sum += count;
+                }
+                if (sum - start == size)
+                    trivial = 1;
+            }
+            hist[(size_t) units * radix_sort_digits] = trivial;
+        },
+
+        units * radix_sort_digits
+    );
+
+    // 3. Stable scatter of the keys (and values)
+    jitc_submit_cpu(
+        KernelType::Other,
+        [keys_in, values_in, keys_out, values_out, size, shift, hist, units,
+         unit_size](uint32_t index) {
+            size_t start = (size_t) index * unit_size,
+                   end = std::min(start + unit_size, (size_t) size);
+
+            if (hist[(size_t) units * radix_sort_digits]) {
+                memcpy(keys_out + start, keys_in + start,
+                       (end - start) * sizeof(Key));
+                if (values_out && values_in)
+                    memcpy(values_out + start, values_in + start,
+                           (end - start) * sizeof(uint32_t));
+                else if (values_out)
+                    for (size_t i = start; i != end; ++i)
+                        values_out[i] = (uint32_t) i;
+                return;
+            }
+
+            uint32_t offset[radix_sort_digits];
+            memcpy(offset, hist + (size_t) index * radix_sort_digits,
+                   sizeof(offset));
+
+            for (size_t i = start; i != end; ++i) {
+                Key key = keys_in[i];
+                uint32_t j = offset[(uint32_t) (key >> shift) &
+                                    (radix_sort_digits - 1)]++;
+                keys_out[j] = key;
+                if (values_out)
+                    values_out[j] = values_in ? values_in[i] : (uint32_t) i;
+            }
+        },
+
+        size, units
+    );
+}
+
+/**
+ * Stable LSD radix sort of 'keys' (in place), which also applies the sorting
+ * permutation to 'values' (if specified). With 'iota=true', the initial
+ * contents of 'values' are ignored and this produces the permutation itself.
+ */
+static void jitc_radix_sort_impl(VarType type, void *keys, uint32_t *values,
+                                 bool iota, uint32_t size) {
+    uint32_t tsize = type_size[(int) type],
+             passes = tsize; // 8 bits per pass, always an even number
+
+    void *keys_buf[2] = {
+        keys, jitc_malloc(AllocType::HostAsync, (size_t) size * tsize)
+    };
+    uint32_t *values_buf[2] = {
+        values,
+        values ? (uint32_t *) jitc_malloc(AllocType::HostAsync,
+                                          (size_t) size * sizeof(uint32_t))
+               : nullptr
+    };
+
+    size_t unit_size;
+    uint32_t units = jitc_cpu_work_units(size, unit_size);
+    uint32_t *hist = (uint32_t *) jitc_malloc(
+        AllocType::HostAsync,
+        ((size_t) units * radix_sort_digits + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < passes; ++i) {
+        const uint32_t *values_in =
+            (i == 0 && iota) ? nullptr : values_buf[i & 1];
+        uint32_t *values_out = values_buf[(i + 1) & 1];
+
+        if (type == VarType::UInt32)
+            jitc_radix_sort_pass_cpu<uint32_t>(
+                (const uint32_t *) keys_buf[i & 1], values_in,
+                (uint32_t *) keys_buf[(i + 1) & 1], values_out, size, i * 8,
+                hist, units, unit_size);
+        else
+            jitc_radix_sort_pass_cpu<uint64_t>(
+                (const uint64_t *) keys_buf[i & 1], values_in,
+                (uint64_t *) keys_buf[(i + 1) & 1], values_out, size, i * 8,
+                hist, units, unit_size);
+    }
+
+    jitc_free(hist);
+    jitc_free(keys_buf[1]);
+    jitc_free(values_buf[1]);
+}
+
+/// Check the arguments of jitc_radix_sort() and jitc_argsort()
+static void jitc_radix_sort_check(JitBackend backend, const char *name,
+                                  VarType type) {
+    if (backend == JitBackend::CUDA)
+        jitc_cuda_unsupported(name);
+
+    if (type != VarType::UInt32 && type != VarType::UInt64)
+        jitc_raise("%s(): unsupported key type %s (must be UInt32 or UInt64)!",
+                   name, type_name[(int) type]);
+}
+
+void jitc_radix_sort(JitBackend backend, VarType type, void *keys,
+                     uint32_t *values, uint32_t size) {
+    jitc_radix_sort_check(backend, "jit_radix_sort", type);
+    if (size <= 1)
+        return;
+
+    jitc_log(Debug,
+             "jit_radix_sort(" DRJIT_PTR ", values=" DRJIT_PTR
+             ", type=%s, size=%u)",
+             (uintptr_t) keys, (uintptr_t) values, type_name[(int) type], size);
+
+    jitc_radix_sort_impl(type, keys, values, false, size);
+}
+
+void jitc_argsort(JitBackend backend, VarType type, const void *keys,
+                  uint32_t size, uint32_t *perm) {
+    jitc_radix_sort_check(backend, "jit_argsort", type);
+    if (size == 0)
+        return;
+
+    jitc_log(Debug,
+             "jit_argsort(" DRJIT_PTR " -> " DRJIT_PTR ", type=%s, size=%u)",
+             (uintptr_t) keys, (uintptr_t) perm, type_name[(int) type], size);
+
+    size_t keys_size = (size_t) size * type_size[(int) type];
+    void *keys_copy = jitc_malloc(AllocType::HostAsync, keys_size);
+    jitc_memcpy_async(backend, keys_copy, keys, keys_size);
+
+    jitc_radix_sort_impl(type, keys_copy, perm, true, size);
+    jitc_free(keys_copy);
+}
+
 static void cuda_transpose(ThreadState *ts, const uint32_t *in, uint32_t *out,
                            uint32_t rows, uint32_t cols) {
     const Device &device = state.devices[ts->device];
@@ -831,6 +1563,9 @@ static ProfilerRegion profiler_region_mkperm_phase_1("jit_mkperm_phase_1");
 static ProfilerRegion profiler_region_mkperm_phase_2("jit_mkperm_phase_2");
 
 /// Compute a permutation to reorder an integer array into a sorted configuration
+/// Number of buckets per task in the accumulation step of jitc_mkperm() (LLVM)
+static const uint32_t mkperm_chunk_size = 4096;
+
 uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
                      uint32_t bucket_count, uint32_t *perm, uint32_t *offsets) {
     if (size == 0)
@@ -839,6 +1574,7 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
         jitc_fail("jit_mkperm(): bucket_count cannot be zero!");
 
     ProfilerPhase profiler(profiler_region_mkperm);
+    ImplicitSync sync(offsets ? "jit_mkperm" : nullptr, 0);
     ThreadState *ts = thread_state(backend);
 
     if (backend == JitBackend::CUDA) {
@@ -1032,21 +1768,110 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
                 uint32_t *buckets_local = (uint32_t *) malloc_check(bsize);
                 memset(buckets_local, 0, bsize);
 
-                 for (uint32_t i = start; i != end; ++i)
-                     buckets_local[ptr[i]]++;
+                if ((size_t) bucket_count * 4 <= end - start) {
+                    /* Neighboring elements often refer to the same bucket,
+                       and repeated increments of a counter then serialize
+                       through memory. Counting into 4 interleaved histograms
+                       avoids this when they are cheap to merge. */
+                    uint32_t *split = (uint32_t *) malloc_check(bsize * 3);
+                    memset(split, 0, bsize * 3);
+                    uint32_t *h1 = split, *h2 = split + bucket_count,
+                             *h3 = split + 2 * (size_t) bucket_count;
+
+                    uint32_t i = start;
+                    for (; i + 4 <= end; i += 4) {
+                        buckets_local[ptr[i]]++;
+                        h1[ptr[i + 1]]++;
+                        h2[ptr[i + 2]]++;
+                        h3[ptr[i + 3]]++;
+                    }
+                    for (; i != end; ++i)
+                        buckets_local[ptr[i]]++;
+
+                    for (uint32_t j = 0; j < bucket_count; ++j)
+                        buckets_local[j] += h1[j] + h2[j] + h3[j];
+                    free(split);
+                } else {
+                    for (uint32_t i = start; i != end; ++i)
+                        buckets_local[ptr[i]]++;
+                }
 
-                 buckets[index] = buckets_local;
+                buckets[index] = buckets_local;
             },
 
             size, blocks
         );
 
-        // Local accumulation step
+        /* Local accumulation step. With many buckets, it runs in parallel over
+           chunks of buckets, whose totals and number of non-empty buckets are
+           determined first. */
+        uint32_t chunk_size = mkperm_chunk_size,
+                 chunks = (bucket_count + chunk_size - 1) / chunk_size;
+        if (pool_size <= 1 || chunks <= 1) {
+            chunks = 1;
+            chunk_size = bucket_count;
+        }
+
+        uint32_t *chunk_info = nullptr;
+        if (chunks > 1) {
+            chunk_info = (uint32_t *) jitc_malloc(
+                AllocType::HostAsync, sizeof(uint32_t) * 2 * chunks);
+
+            jitc_submit_cpu(
+                KernelType::VCallReduce,
+                [bucket_count, blocks, buckets, chunk_size, chunk_info](uint32_t index) {
+                    uint32_t start = index * chunk_size,
+                             end = std::min(start + chunk_size, bucket_count),
+                             sum = 0, unique_count_local = 0;
+
+                    for (uint32_t i = start; i < end; ++i) {
+                        uint32_t sum_local = 0;
+                        for (uint32_t j = 0; j < blocks; ++j)
+                            sum_local += buckets[j][i];
+                        sum += sum_local;
+                        unique_count_local += sum_local > 0;
+                    }
+
+                    chunk_info[2 * index] = sum;
+                    chunk_info[2 * index + 1] = unique_count_local;
+                },
+
+                size, chunks
+            );
+
+            jitc_submit_cpu(
+                KernelType::VCallReduce,
+                [chunks, chunk_info, &unique_count](uint32_t) {
+                    uint32_t sum = 0, unique_count_local = 0;
+                    for (uint32_t i = 0; i < chunks; ++i) {
+                        uint32_t sum_i = chunk_info[2 * i],
+                                 unique_i = chunk_info[2 * i + 1];
+                        chunk_info[2 * i] = sum;
+                        chunk_info[2 * i + 1] = unique_count_local;
+                        sum += sum_i;
+                        unique_count_local += unique_i;
+                    }
+                    unique_count = unique_count_local;
+                },
+
+                size
+            );
+        }
+
         jitc_submit_cpu(
             KernelType::VCallReduce,
-            [bucket_count, blocks, buckets, offsets, &unique_count](uint32_t) {
-                uint32_t sum = 0, unique_count_local = 0;
-                for (uint32_t i = 0; i < bucket_count; ++i) {
+            [bucket_count, blocks, buckets, offsets, chunk_size, chunk_info,
+             &unique_count](uint32_t index) {
+                uint32_t start = index * chunk_size,
+                         end = std::min(start + chunk_size, bucket_count),
+                         sum = 0, unique_count_local = 0;
+
+                if (chunk_info) {
+                    sum = chunk_info[2 * index];
+                    unique_count_local = chunk_info[2 * index + 1];
+                }
+
+                for (uint32_t i = start; i < end; ++i) {
                     uint32_t sum_local = 0;
                     for (uint32_t j = 0; j < blocks; ++j) {
                         uint32_t value = buckets[j][i];
@@ -1065,10 +1890,11 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
                     }
                 }
 
-                unique_count = unique_count_local;
+                if (!chunk_info)
+                    unique_count = unique_count_local;
             },
 
-            size
+            size, chunks
         );
 
         Task *local_task = jitc_task;
@@ -1097,6 +1923,7 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
 
         // Free memory (happens asynchronously after the above stmt.)
         jitc_free(buckets);
+        jitc_free(chunk_info);
 
         task_wait_and_release(local_task);
 
@@ -1104,13 +1931,13 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
     }
 }
 
-using BlockOp = void (*) (const void *ptr, void *out, uint32_t start, uint32_t end, uint32_t block_size);
+using BlockOp = void (*) (const void *ptr, void *out, size_t start, size_t end, uint32_t block_size);
 
 template <typename Value> static BlockOp jitc_block_copy_create() {
-    return [](const void *in_, void *out_, uint32_t start, uint32_t end, uint32_t block_size) {
+    return [](const void *in_, void *out_, size_t start, size_t end, uint32_t block_size) {
         const Value *in = (const Value *) in_ + start;
         Value *out = (Value *) out_ + start * block_size;
-        for (uint32_t i = start; i != end; ++i) {
+        for (size_t i = start; i != end; ++i) {
             Value value = *in++;
             for (uint32_t j = 0; j != block_size; ++j)
                 *out++ = value;
@@ -1119,10 +1946,10 @@ template <typename Value> static BlockOp jitc_block_copy_create() {
 }
 
 template <typename Value> static BlockOp jitc_block_sum_create() {
-    return [](const void *in_, void *out_, uint32_t start, uint32_t end, uint32_t block_size) {
+    return [](const void *in_, void *out_, size_t start, size_t end, uint32_t block_size) {
         const Value *in = (const Value *) in_ + start * block_size;
         Value *out = (Value *) out_ + start;
-        for (uint32_t i = start; i != end; ++i) {
+        for (size_t i = start; i != end; ++i) {
             Value sum = 0;
             for (uint32_t j = 0; j != block_size; ++j)
                 sum += *in++;
@@ -1167,13 +1994,13 @@ static VarType make_int_type_unsigned(VarType type) {
 
 /// Replicate individual input elements to larger blocks
 void jitc_block_copy(JitBackend backend, enum VarType type, const void *in, void *out,
-                    uint32_t size, uint32_t block_size) {
+                    size_t size, uint32_t block_size) {
     if (block_size == 0)
         jitc_raise("jit_block_copy(): block_size cannot be zero!");
 
     jitc_log(Debug,
             "jit_block_copy(" DRJIT_PTR " -> " DRJIT_PTR
-            ", type=%s, block_size=%u, size=%u)",
+            ", type=%s, block_size=%u, size=%zu)",
             (uintptr_t) in, (uintptr_t) out,
             type_name[(int) type], block_size, size);
 
@@ -1189,33 +2016,30 @@ void jitc_block_copy(JitBackend backend, enum VarType type, const void *in, void
     if (backend == JitBackend::CUDA) {
         scoped_set_context guard(ts->context);
         const Device &device = state.devices[ts->device];
-        size *= block_size;
+        uint32_t size_32 = jitc_cuda_size("jit_block_copy", size * block_size);
 
         CUfunction func = jitc_cuda_block_copy[(int) type][device.id];
         if (!func)
             jitc_raise("jit_block_copy(): no existing kernel for type=%s!",
                       type_name[(int) type]);
 
-        uint32_t thread_count = std::min(size, 1024u),
-                 block_count  = (size + thread_count - 1) / thread_count;
+        uint32_t thread_count = std::min(size_32, 1024u),
+                 block_count  = (size_32 + thread_count - 1) / thread_count;
 
-        void *args[] = { &in, &out, &size, &block_size };
+        void *args[] = { &in, &out, &size_32, &block_size };
         jitc_submit_gpu(KernelType::Other, func, block_count, thread_count, 0,
-                        ts->stream, args, nullptr, size);
+                        ts->stream, args, nullptr, size_32);
     } else {
-        uint32_t work_unit_size = size, work_units = 1;
-        if (pool_size() > 1) {
-            work_unit_size = DRJIT_POOL_BLOCK_SIZE;
-            work_units     = (size + work_unit_size - 1) / work_unit_size;
-        }
+        size_t work_unit_size;
+        uint32_t work_units = jitc_cpu_work_units(size, work_unit_size);
 
         BlockOp op = jitc_block_copy_create(type);
 
         jitc_submit_cpu(
             KernelType::Other,
             [in, out, op, work_unit_size, size, block_size](uint32_t index) {
-                uint32_t start = index * work_unit_size,
-                         end = std::min(start + work_unit_size, size);
+                size_t start = (size_t) index * work_unit_size,
+                       end = std::min(start + work_unit_size, size);
 
                 op(in, out, start, end, block_size);
             },
@@ -1227,13 +2051,13 @@ void jitc_block_copy(JitBackend backend, enum VarType type, const void *in, void
 
 /// Sum over elements within blocks
 void jitc_block_sum(JitBackend backend, enum VarType type, const void *in, void *out,
-                    uint32_t size, uint32_t block_size) {
+                    size_t size, uint32_t block_size) {
     if (block_size == 0)
         jitc_raise("jit_block_sum(): block_size cannot be zero!");
 
     jitc_log(Debug,
             "jit_block_sum(" DRJIT_PTR " -> " DRJIT_PTR
-            ", type=%s, block_size=%u, size=%u)",
+            ", type=%s, block_size=%u, size=%zu)",
             (uintptr_t) in, (uintptr_t) out,
             type_name[(int) type], block_size, size);
 
@@ -1251,35 +2075,31 @@ void jitc_block_sum(JitBackend backend, enum VarType type, const void *in, void
     if (backend == JitBackend::CUDA) {
         scoped_set_context guard(ts->context);
         const Device &device = state.devices[ts->device];
-
-        size *= block_size;
+        uint32_t size_32 = jitc_cuda_size("jit_block_sum", size * block_size);
 
         CUfunction func = jitc_cuda_block_sum[(int) type][device.id];
         if (!func)
             jitc_raise("jit_block_sum(): no existing kernel for type=%s!",
                       type_name[(int) type]);
 
-        uint32_t thread_count = std::min(size, 1024u),
-                 block_count  = (size + thread_count - 1) / thread_count;
+        uint32_t thread_count = std::min(size_32, 1024u),
+                 block_count  = (size_32 + thread_count - 1) / thread_count;
 
-        void *args[] = { &in, &out, &size, &block_size };
+        void *args[] = { &in, &out, &size_32, &block_size };
         cuda_check(cuMemsetD8Async((CUdeviceptr) out, 0, out_size, ts->stream));
         jitc_submit_gpu(KernelType::Other, func, block_count, thread_count, 0,
-                        ts->stream, args, nullptr, size);
+                        ts->stream, args, nullptr, size_32);
     } else {
-        uint32_t work_unit_size = size, work_units = 1;
-        if (pool_size() > 1) {
-            work_unit_size = DRJIT_POOL_BLOCK_SIZE;
-            work_units     = (size + work_unit_size - 1) / work_unit_size;
-        }
+        size_t work_unit_size;
+        uint32_t work_units = jitc_cpu_work_units(size, work_unit_size);
 
         BlockOp op = jitc_block_sum_create(type);
 
         jitc_submit_cpu(
             KernelType::Other,
             [in, out, op, work_unit_size, size, block_size](uint32_t index) {
-                uint32_t start = index * work_unit_size,
-                         end = std::min(start + work_unit_size, size);
+                size_t start = (size_t) index * work_unit_size,
+                       end = std::min(start + work_unit_size, size);
 
                 op(in, out, start, end, block_size);
             },
@@ -1289,6 +2109,71 @@ void jitc_block_sum(JitBackend backend, enum VarType type, const void *in, void
     }
 }
 
+/// Prefix sum over contiguous blocks (i.e., a segmented prefix sum)
+void jitc_block_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
+                           const void *in, size_t size, uint32_t block_size,
+                           void *out) {
+    if (backend == JitBackend::CUDA)
+        jitc_cuda_unsupported("jit_block_prefix_sum");
+
+    if (block_size == 0)
+        jitc_raise("jit_block_prefix_sum(): block_size cannot be zero!");
+
+    if (size == 0)
+        return;
+
+    // A single block is handled by the (decoupled look-back) prefix sum
+    if (block_size >= size) {
+        jitc_prefix_sum(backend, vt, exclusive, in, size, out);
+        return;
+    }
+
+    vt = make_int_type_unsigned(vt);
+    if (vt != VarType::UInt32 && vt != VarType::UInt64 &&
+        vt != VarType::Float32 && vt != VarType::Float64)
+        jitc_raise("jit_block_prefix_sum(): type %s is not supported!",
+                   type_name[(int) vt]);
+
+    uint32_t isize = type_size[(int) vt];
+    size_t block_count = (size + block_size - 1) / block_size;
+
+    jitc_log(Debug,
+             "jit_block_prefix_sum(" DRJIT_PTR " -> " DRJIT_PTR
+             ", type=%s, exclusive=%i, size=%zu, block_size=%u)",
+             (uintptr_t) in, (uintptr_t) out, type_name[(int) vt], exclusive,
+             size, block_size);
+
+    if (block_count <= std::max(pool_size(), 1u)) {
+        // Few large blocks: parallelize within each one
+        for (size_t i = 0; i < block_count; ++i) {
+            size_t offset = i * block_size * isize;
+            jitc_prefix_sum(backend, vt, exclusive, (const uint8_t *) in + offset,
+                            std::min((size_t) block_size, size - i * block_size),
+                            (uint8_t *) out + offset);
+        }
+    } else {
+        // Many blocks: each work unit scans several entire blocks
+        size_t unit_size;
+        jitc_cpu_work_units(size, unit_size);
+        size_t blocks_per_unit = std::max(unit_size / block_size, (size_t) 1);
+        uint32_t work_units = (uint32_t) ((block_count + blocks_per_unit - 1) /
+                                          blocks_per_unit);
+
+        jitc_submit_cpu(
+            KernelType::Other,
+            [in, out, vt, size, block_size, blocks_per_unit,
+             exclusive](uint32_t index) {
+                size_t start = (size_t) index * blocks_per_unit * block_size,
+                       end = std::min(start + blocks_per_unit * block_size, size);
+
+                for (size_t i = start; i < end; i += block_size)
+                    sum_reduce_2(vt, i, std::min(i + block_size, end), in, out,
+                                 0, nullptr, exclusive);
+            },
+            size, work_units);
+    }
+}
+
 /// Asynchronously update a single element in memory
 void jitc_poke(JitBackend backend, void *dst, const void *src, uint32_t size) {
     jitc_log(Debug, "jit_poke(" DRJIT_PTR ", size=%u)", (uintptr_t) dst, size);
@@ -1326,6 +2211,43 @@ void jitc_poke(JitBackend backend, void *dst, const void *src, uint32_t size) {
     }
 }
 
+void jitc_poke_batch(JitBackend backend, PokeRecord *rec, uint32_t size) {
+    jitc_log(Debug, "jit_poke_batch(" DRJIT_PTR ", size=%u)", (uintptr_t) rec,
+             size);
+
+    ThreadState *ts = thread_state(backend);
+    if (backend == JitBackend::CUDA) {
+        scoped_set_context guard(ts->context);
+        const Device &device = state.devices[ts->device];
+        CUfunction func = jitc_cuda_poke_batch[device.id];
+
+        if (func) {
+            uint32_t block_count, thread_count;
+            device.get_launch_config(&block_count, &thread_count, size);
+
+            void *args[] = { &rec, &size };
+            jitc_submit_gpu(KernelType::Other, func, block_count, thread_count,
+                            0, ts->stream, args, nullptr, size);
+        } else {
+            // Older PTX without the batched kernel
+            for (uint32_t i = 0; i < size; ++i)
+                jitc_poke(backend, rec[i].dst, &rec[i].value, rec[i].size);
+        }
+
+        jitc_free(rec);
+    } else {
+        jitc_submit_cpu(
+            KernelType::Other,
+            [rec, size](uint32_t) {
+                for (uint32_t i = 0; i < size; ++i)
+                    memcpy(rec[i].dst, &rec[i].value, rec[i].size);
+                free(rec);
+            },
+
+            size
+        );
+    }
+}
 
 void jitc_vcall_prepare(JitBackend backend, void *dst_, VCallDataRecord *rec_, uint32_t size) {
     ThreadState *ts = thread_state(backend);
@@ -16,22 +16,36 @@
 extern const char *reduction_name[(int) ReduceOp::Count];
 
 /// Fill a device memory region with constants of a given type
-extern void jitc_memset_async(JitBackend backend, void *ptr, uint32_t size,
+extern void jitc_memset_async(JitBackend backend, void *ptr, size_t size,
                               uint32_t isize, const void *src);
 
 /// Reduce the given array to a single value
 extern void jitc_reduce(JitBackend backend, VarType type, ReduceOp rtype,
-                        const void *ptr, uint32_t size, void *out);
+                        const void *ptr, size_t size, void *out);
 
 /// 'All' reduction for boolean arrays
-extern bool jitc_all(JitBackend backend, uint8_t *values, uint32_t size);
+extern bool jitc_all(JitBackend backend, uint8_t *values, size_t size);
 
 /// 'Any' reduction for boolean arrays
-extern bool jitc_any(JitBackend backend, uint8_t *values, uint32_t size);
+extern bool jitc_any(JitBackend backend, uint8_t *values, size_t size);
+
+/// Reduce an array without waiting for the result (masks support And/Or)
+extern JitFuture *jitc_reduce_async(JitBackend backend, VarType type,
+                                    ReduceOp rtype, void *ptr, size_t size);
+
+/// Create an already completed future holding the given value
+extern JitFuture *jitc_future_literal(JitBackend backend, VarType type,
+                                      uint64_t value);
+
+/// Check if the result of an asynchronous reduction is available
+extern bool jitc_future_ready(JitFuture *future);
+
+/// Wait for the result of an asynchronous reduction and release the future
+extern void jitc_future_get(JitFuture *future, void *out);
 
 /// Exclusive prefix sum
 extern void jitc_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
-                            const void *in, uint32_t size, void *out);
+                            const void *in, size_t size, void *out);
 
 /// Mask compression
 extern uint32_t jitc_compress(JitBackend backend, const uint8_t *in, uint32_t size,
@@ -42,23 +56,84 @@ extern uint32_t jitc_mkperm(JitBackend backend, const uint32_t *values, uint32_t
                             uint32_t bucket_count, uint32_t *perm,
                             uint32_t *offsets);
 
+/// Reduce contiguous segments of an array delimited by an offset table
+extern void jitc_segmented_reduce(JitBackend backend, VarType type,
+                                  ReduceOp rtype, const void *in,
+                                  const uint32_t *offsets,
+                                  uint32_t segment_count, void *out);
+
+/// Reduce the values associated with runs of equal keys
+extern uint32_t jitc_reduce_by_key(JitBackend backend, VarType type,
+                                   ReduceOp rtype, const uint32_t *keys,
+                                   const void *values, uint32_t size,
+                                   uint32_t *keys_out, void *values_out);
+
+/// Stable radix sort of 32/64-bit unsigned integer keys with optional values
+extern void jitc_radix_sort(JitBackend backend, VarType type, void *keys,
+                            uint32_t *values, uint32_t size);
+
+/// Compute the stable permutation that sorts the given keys
+extern void jitc_argsort(JitBackend backend, VarType type, const void *keys,
+                         uint32_t size, uint32_t *perm);
+
 /// Perform a synchronous copy operation
 extern void jitc_memcpy(JitBackend backend, void *dst, const void *src, size_t size);
 
 /// Perform an assynchronous copy operation
 extern void jitc_memcpy_async(JitBackend backend, void *dst, const void *src, size_t size);
 
+/// Memory transfer between (potentially different) CUDA devices
+struct PeerCopy {
+    void *dst;
+    const void *src;
+    size_t size;
+    int dst_device;
+    int src_device;
+};
+
+/**
+ * \brief Asynchronously perform a set of transfers between CUDA devices
+ *
+ * Each transfer runs on the stream of its destination device once the work
+ * submitted to the source device's stream has finished. Transfers to
+ * different devices run concurrently. Work that is subsequently submitted to
+ * a source device waits for the transfers, so that the source memory can be
+ * released right away.
+ */
+extern void jitc_memcpy_peer_async(const PeerCopy *copies, uint32_t count);
+
 /// Replicate individual input elements to larger blocks
 extern void jitc_block_copy(JitBackend backend, enum VarType type, const void *in,
-                            void *out, uint32_t size, uint32_t block_size);
+                            void *out, size_t size, uint32_t block_size);
 
 /// Sum over elements within blocks
 extern void jitc_block_sum(JitBackend backend, enum VarType type, const void *in,
-                           void *out, uint32_t size, uint32_t block_size);
+                           void *out, size_t size, uint32_t block_size);
+
+/// Prefix sum over contiguous blocks (i.e., a segmented prefix sum)
+extern void jitc_block_prefix_sum(JitBackend backend, VarType vt, bool exclusive,
+                                  const void *in, size_t size,
+                                  uint32_t block_size, void *out);
 
 /// Asynchronously update a single element in memory
 extern void jitc_poke(JitBackend backend, void *dst, const void *src, uint32_t size);
 
+/// Destination and value of an element update performed by jitc_poke_batch()
+struct PokeRecord {
+    void *dst;
+    uint64_t value;
+    uint32_t size;
+    uint32_t unused;
+};
+
+/**
+ * \brief Asynchronously update many elements in memory with a single kernel
+ *
+ * 'rec' must be allocated via jitc_malloc(AllocType::HostPinned) (CUDA) or
+ * malloc() (LLVM). The function takes ownership and releases it.
+ */
+extern void jitc_poke_batch(JitBackend backend, PokeRecord *rec, uint32_t size);
+
 struct VCallDataRecord;
 /// Initialize the data block consumed by a vcall
 extern void jitc_vcall_prepare(JitBackend backend, void *dst,
@@ -12,8 +12,10 @@
 #include "log.h"
 #include "eval.h"
 #include "util.h"
+#include "stats.h"
 #include "op.h"
 #include "registry.h"
+#include "vcall.h"
 
 // When debugging via valgrind, this will make iterator invalidation more obvious
 // #define DRJIT_VALGRIND 1
@@ -90,9 +92,6 @@ const char *var_kind_name[(int) VarKind::Count] {
     // An evaluated node representing data
     "data",
 
-    // Legacy string-based IR statement
-    "stmt",
-
     // A literal constant
     "literal",
 
@@ -169,18 +168,26 @@ const char *var_kind_name[(int) VarKind::Count] {
     "trace_ray",
 
     // Extract a component from an operation that produced multiple results
-    "extract"
+    "extract",
+
+    // Copy of another variable that must remain a separate register
+    "copy",
+
+    // Phi node of a loop state variable (LLVM)
+    "loop_phi"
 };
 
 
 /// Temporary string buffer for miscellaneous variable-related tasks
 StringBuffer var_buffer(0);
 
-#define jitc_check_size(name, size)                                            \
-    if (unlikely(size > 0xFFFFFFFF))                                           \
+/* LLVM arrays may exceed 2^32 entries. The CUDA backend is limited by its
+   32-bit launch configurations and the precompiled kernels. */
+#define jitc_check_size(name, backend, size)                                   \
+    if (unlikely(size > 0xFFFFFFFF && backend == JitBackend::CUDA))            \
         jitc_raise("%s(): tried to create an array with %zu entries, which "   \
-                   "exceeds the limit of 2^32 == 4294967296 entries.",         \
-                   name, size);
+                   "exceeds the limit of 2^32-1 == 4294967295 entries of the " \
+                   "CUDA backend.", name, size);
 
 /// Cleanup handler, called when the internal/external reference count reaches zero
 void jitc_var_free(uint32_t index, Variable *v) {
@@ -195,10 +202,6 @@ void jitc_var_free(uint32_t index, Variable *v) {
         jitc_lvn_drop(index, v);
     }
 
-    // Free IR string if needed
-    if (unlikely(v->free_stmt))
-        free(v->stmt);
-
     uint32_t dep[4];
     bool write_ptr = v->write_ptr;
     memcpy(dep, v->dep, sizeof(uint32_t) * 4);
@@ -239,11 +242,13 @@ void jitc_var_free(uint32_t index, Variable *v) {
         free(extra.label);
     }
 
-    // Remove from hash table
-    state.variables.erase(index);
+    // Mark the entry as unused and recycle its index
+    state.variables[index] = Variable();
+    state.variables_scratch[index] = VariableScratch();
+    state.unused_variables.push_back(index);
 
 #if defined(DRJIT_VALGRIND)
-    VariableMap var_new(state.variables);
+    VariableVector var_new(state.variables);
     state.variables.swap(var_new);
 #endif
 
@@ -258,10 +263,36 @@ void jitc_var_free(uint32_t index, Variable *v) {
 
 /// Access a variable by ID, terminate with an error if it doesn't exist
 Variable *jitc_var(uint32_t index) {
-    auto it = state.variables.find(index);
-    if (unlikely(it == state.variables.end()))
+    if (unlikely(index >= state.variables.size() ||
+                 state.variables[index].is_unused()))
         jitc_fail("jit_var(r%u): unknown variable!", index);
-    return &it.value();
+    return &state.variables[index];
+}
+
+/// Access a variable by ID, return \c nullptr if it doesn't exist
+Variable *jitc_var_maybe(uint32_t index) {
+    if (index >= state.variables.size() || state.variables[index].is_unused())
+        return nullptr;
+    return &state.variables[index];
+}
+
+/// Resolve a weak reference, return \c nullptr if the variable has expired
+Variable *jitc_var(WeakRef ref) {
+    Variable *v = jitc_var_maybe(ref.index);
+    if (!v || v->counter != ref.counter)
+        return nullptr;
+    return v;
+}
+
+/// Create a weak reference to an existing variable
+WeakRef jitc_var_weak(uint32_t index) {
+    return WeakRef(index, jitc_var(index)->counter);
+}
+
+/// Return the number of currently existing variables
+size_t jitc_var_count() {
+    size_t size = state.variables.size();
+    return size ? size - 1 - state.unused_variables.size() : 0;
 }
 
 /// Increase the external reference count of a given variable
@@ -410,6 +441,9 @@ void jitc_value_print(const Variable *v, bool graphviz = false) {
         break;
 
     switch ((VarType) v->type) {
+        case VarType::Float16:
+            var_buffer.fmt("%g", (double) jitc_half_to_float(v->literal));
+            break;
         case VarType::Float32: JIT_LITERAL_PRINT(float, float, "%g");
         case VarType::Float64: JIT_LITERAL_PRINT(double, double, "%g");
         case VarType::Bool:    JIT_LITERAL_PRINT(bool, int, "%i");
@@ -451,30 +485,38 @@ uint32_t jitc_var_new(Variable &v, bool disable_lvn) {
 
     if (likely(!lvn || lvn_key_inserted)) {
         #if defined(DRJIT_VALGRIND)
-            VariableMap var_new(state.variables);
+            VariableVector var_new(state.variables);
             state.variables.swap(var_new);
         #endif
 
-        // .. nope, it is new.
-        VariableMap::iterator var_it;
-        bool var_inserted = false;
-        do {
-            index = state.variable_index++;
-
-            if (unlikely(index == 0)) // overflow
-                continue;
+        // .. nope, it is new. Reuse the most recently freed index if possible
+        if (likely(!state.unused_variables.empty())) {
+            index = state.unused_variables.back();
+            state.unused_variables.pop_back();
+        } else {
+            if (unlikely(state.variables.empty())) {
+                state.variables.emplace_back(); // index 0 is reserved
+                state.variables_scratch.emplace_back();
+            }
 
-            std::tie(var_it, var_inserted) =
-                state.variables.try_emplace(index, v);
-        } while (!var_inserted);
+            index = (uint32_t) state.variables.size();
+            if (unlikely(index == 0xFFFFFFFFu))
+                jitc_raise("jit_var_new(): exceeded the maximum number of "
+                           "variables!");
 
-        state.variable_watermark = std::max(state.variable_watermark,
-                                            (uint32_t) state.variables.size());
+            state.variables.emplace_back();
+            state.variables_scratch.emplace_back();
+            state.variable_watermark =
+                std::max(state.variable_watermark, index);
+        }
 
         if (lvn_key_inserted)
             key_it.value() = index;
 
-        vo = &var_it.value();
+        vo = &state.variables[index];
+        *vo = v;
+        vo->counter = state.variable_counter++;
+        jitc_stat(Stat::VariablesCreated);
 
         if (unlikely(ts->prefix)) {
             vo->extra = true;
@@ -482,9 +524,7 @@ uint32_t jitc_var_new(Variable &v, bool disable_lvn) {
         }
     } else {
         // .. found a match! Deallocate 'v'.
-        if (v.free_stmt)
-            free(v.stmt);
-
+        jitc_stat(Stat::LVNHits);
         if (likely(!v.write_ptr)) {
             for (int i = 0; i < 4; ++i)
                 jitc_var_dec_ref(v.dep[i]);
@@ -501,7 +541,7 @@ uint32_t jitc_var_new(Variable &v, bool disable_lvn) {
         var_buffer.clear();
         var_buffer.fmt("jit_var_new(%s r%u", type_name[v.type], index);
         if (v.size > 1)
-            var_buffer.fmt("[%u]", v.size);
+            var_buffer.fmt("[%zu]", v.size);
 
         uint32_t n_dep = 0;
         for (int i = 0; i < 4; ++i) {
@@ -519,8 +559,6 @@ uint32_t jitc_var_new(Variable &v, bool disable_lvn) {
             jitc_value_print(&v);
         } else if (v.is_data()) {
             var_buffer.fmt(DRJIT_PTR, (uintptr_t) v.data);
-        } else if (v.is_stmt()) {
-            var_buffer.put(v.stmt, strlen(v.stmt));
         } else if (v.is_node()) {
             var_buffer.fmt("\"%s\" operation", var_kind_name[v.kind]);
         }
@@ -550,7 +588,7 @@ uint32_t jitc_var_literal(JitBackend backend, VarType type, const void *value,
     if (unlikely(size == 0))
         return 0;
 
-    jitc_check_size("jit_var_literal", size);
+    jitc_check_size("jit_var_literal", backend, size);
 
     /* When initializing a value pointer array while recording a virtual
        function, we can leverage the already available `self` variable
@@ -569,17 +607,15 @@ uint32_t jitc_var_literal(JitBackend backend, VarType type, const void *value,
         memcpy(&v.literal, value, type_size[(uint32_t) type]);
         v.kind = (uint32_t) VarKind::Literal;
         v.type = (uint32_t) type;
-        v.size = (uint32_t) size;
+        v.size = size;
         v.backend = (uint32_t) backend;
 
         return jitc_var_new(v);
     } else {
         uint32_t isize = type_size[(int) type];
         void *data =
-            jitc_malloc(backend == JitBackend::CUDA ? AllocType::Device
-                                                    : AllocType::HostAsync,
-                        size * (size_t) isize);
-        jitc_memset_async(backend, data, (uint32_t) size, isize, value);
+            jitc_malloc(jitc_malloc_var_type(backend), size * (size_t) isize);
+        jitc_memset_async(backend, data, size, isize, value);
         return jitc_var_mem_map(backend, type, data, size, 1);
     }
 }
@@ -618,12 +654,13 @@ uint32_t jitc_var_counter(JitBackend backend, size_t size,
         return jitc_var_literal(backend, VarType::UInt32, &zero, 1, 0);
     }
 
-    jitc_check_size("jit_var_counter", size);
+    jitc_check_size("jit_var_counter", backend, size);
     Variable v;
     v.kind = VarKind::Counter;
     v.backend = (uint32_t) backend;
-    v.type = (uint32_t) VarType::UInt32;
-    v.size = (uint32_t) size;
+    // The index of the last entry of larger arrays requires 64 bits
+    v.type = (uint32_t) (size > 0xFFFFFFFF ? VarType::UInt64 : VarType::UInt32);
+    v.size = size;
     return jitc_var_new(v);
 }
 
@@ -644,11 +681,8 @@ uint32_t jitc_var_wrap_vcall(uint32_t index) {
     }
 
     Variable v2;
-    v2.stmt = (char *) (((JitBackend) v->backend == JitBackend::CUDA)
-                            ? "mov.$t0 $r0, $r1"
-                            : "$r0 = bitcast <$w x $t0> $r1 to <$w x $t0>");
     v2.backend = v->backend;
-    v2.kind = (uint32_t) VarKind::Stmt;
+    v2.kind = (uint32_t) VarKind::Copy;
     v2.type = v->type;
     v2.size = 1;
     v2.placeholder = v2.vcall_iface = 1;
@@ -669,71 +703,6 @@ void jitc_new_scope(JitBackend backend) {
     thread_state(backend)->scope = scope_index;
 }
 
-uint32_t jitc_var_stmt(JitBackend backend, VarType vt, const char *stmt,
-                       int stmt_static, uint32_t n_dep,
-                       const uint32_t *dep) {
-    uint32_t size = n_dep == 0 ? 1 : 0;
-    bool dirty = false, uninitialized = false, placeholder = false;
-    Variable *v[4] { };
-
-    if (unlikely(n_dep > 4))
-        jitc_fail("jit_var_stmt(): 0-4 dependent variables supported!");
-
-    for (uint32_t i = 0; i < n_dep; ++i) {
-        if (likely(dep[i])) {
-            Variable *vi = jitc_var(dep[i]);
-            size = std::max(size, vi->size);
-            dirty |= vi->is_dirty();
-            placeholder |= (bool) vi->placeholder;
-            v[i] = vi;
-        } else {
-            uninitialized = true;
-        }
-    }
-
-    if (unlikely(size == 0)) {
-        if (!stmt_static)
-            free((char *) stmt);
-        return 0;
-    } else if (unlikely(uninitialized)) {
-        jitc_raise("jit_var_stmt(): arithmetic involving an "
-                   "uninitialized variable!");
-    }
-
-    for (uint32_t i = 0; i < n_dep; ++i) {
-        if (v[i]->size != size && v[i]->size != 1)
-            jitc_raise("jit_var_stmt(): arithmetic involving arrays of "
-                       "incompatible size!");
-    }
-
-    if (dirty) {
-        jitc_eval(thread_state(backend));
-        dirty = false;
-        for (uint32_t i = 0; i < n_dep; ++i) {
-            v[i] = jitc_var(dep[i]);
-            dirty |= v[i]->is_dirty();
-        }
-        if (dirty)
-            jitc_raise("jit_var_stmt(): variable remains dirty following evaluation!");
-    }
-
-    Variable v2;
-    for (uint32_t i = 0; i < n_dep; ++i) {
-        v2.dep[i] = dep[i];
-        jitc_var_inc_ref(dep[i], v[i]);
-    }
-
-    v2.kind = (uint32_t) VarKind::Stmt;
-    v2.stmt = stmt_static ? (char *) stmt : strdup(stmt);
-    v2.size = size;
-    v2.type = (uint32_t) vt;
-    v2.backend = (uint32_t) backend;
-    v2.free_stmt = stmt_static == 0;
-    v2.placeholder = placeholder;
-
-    return jitc_var_new(v2);
-}
-
 /**
  * \brie Create a new IR node
  *
@@ -745,7 +714,7 @@ uint32_t jitc_var_stmt(JitBackend backend, VarType vt, const char *stmt,
  *   evaluated, and the function checks that this worked as expected.
  */
 uint32_t jitc_var_new_node_0(JitBackend backend, VarKind kind, VarType vt,
-                             uint32_t size, bool placeholder, uint64_t payload) {
+                             size_t size, bool placeholder, uint64_t payload) {
 
     Variable v;
     v.literal = payload;
@@ -759,7 +728,7 @@ uint32_t jitc_var_new_node_0(JitBackend backend, VarKind kind, VarType vt,
 }
 
 uint32_t jitc_var_new_node_1(JitBackend backend, VarKind kind, VarType vt,
-                             uint32_t size, bool placeholder,
+                             size_t size, bool placeholder,
                              uint32_t a0, Variable *v0, uint64_t payload) {
 
     if (unlikely(v0->is_dirty())) {
@@ -785,7 +754,7 @@ uint32_t jitc_var_new_node_1(JitBackend backend, VarKind kind, VarType vt,
 }
 
 uint32_t jitc_var_new_node_2(JitBackend backend, VarKind kind, VarType vt,
-                             uint32_t size, bool placeholder,
+                             size_t size, bool placeholder,
                              uint32_t a0, Variable *v0,
                              uint32_t a1, Variable *v1, uint64_t payload) {
 
@@ -813,7 +782,7 @@ uint32_t jitc_var_new_node_2(JitBackend backend, VarKind kind, VarType vt,
 }
 
 uint32_t jitc_var_new_node_3(JitBackend backend, VarKind kind, VarType vt,
-                             uint32_t size, bool placeholder,
+                             size_t size, bool placeholder,
                              uint32_t a0, Variable *v0, uint32_t a1, Variable *v1,
                              uint32_t a2, Variable *v2, uint64_t payload) {
     if (unlikely(v0->is_dirty() || v1->is_dirty() || v2->is_dirty())) {
@@ -842,7 +811,7 @@ uint32_t jitc_var_new_node_3(JitBackend backend, VarKind kind, VarType vt,
 }
 
 uint32_t jitc_var_new_node_4(JitBackend backend, VarKind kind, VarType vt,
-                             uint32_t size, bool placeholder,
+                             size_t size, bool placeholder,
                              uint32_t a0, Variable *v0, uint32_t a1, Variable *v1,
                              uint32_t a2, Variable *v2, uint32_t a3, Variable *v3,
                              uint64_t payload) {
@@ -898,8 +867,7 @@ AllocType jitc_var_alloc_type(uint32_t index) {
     if (v->is_data())
         return jitc_malloc_type(v->data);
 
-    return (JitBackend) v->backend == JitBackend::CUDA ? AllocType::Device
-                                                       : AllocType::HostAsync;
+    return jitc_malloc_var_type((JitBackend) v->backend);
 }
 
 /// Query the device associated with a variable
@@ -965,7 +933,7 @@ const char *jitc_var_str(uint32_t index) {
             jitc_memcpy((JitBackend) v->backend, dst, src_offset, isize);
         }
 
-        const char *comma = i + 1 < (uint32_t) size ? ", " : "";
+        const char *comma = i + 1 < size ? ", " : "";
         switch ((VarType) v->type) {
             case VarType::Bool:    var_buffer.fmt("%"   PRIu8  "%s", *(( uint8_t *) dst), comma); break;
             case VarType::Int8:    var_buffer.fmt("%"   PRId8  "%s", *((  int8_t *) dst), comma); break;
@@ -976,6 +944,7 @@ const char *jitc_var_str(uint32_t index) {
             case VarType::UInt32:  var_buffer.fmt("%"   PRIu32 "%s", *((uint32_t *) dst), comma); break;
             case VarType::Int64:   var_buffer.fmt("%"   PRId64 "%s", *(( int64_t *) dst), comma); break;
             case VarType::UInt64:  var_buffer.fmt("%"   PRIu64 "%s", *((uint64_t *) dst), comma); break;
+            case VarType::Float16: var_buffer.fmt("%g%s", (double) jitc_half_to_float(*((uint16_t *) dst)), comma); break;
             case VarType::Float32: var_buffer.fmt("%g%s", *((float *) dst), comma); break;
             case VarType::Float64: var_buffer.fmt("%g%s", *((double *) dst), comma); break;
             default: jitc_fail("jit_var_str(): unsupported type!");
@@ -1010,18 +979,17 @@ static void jitc_raise_consumed_error(const char *func, uint32_t index) {
 
 /// Schedule a variable \c index for future evaluation via \ref jit_eval()
 int jitc_var_schedule(uint32_t index) {
-    auto it = state.variables.find(index);
-    if (unlikely(it == state.variables.end()))
+    Variable *v = jitc_var_maybe(index);
+    if (unlikely(!v))
         jitc_raise("jit_var_schedule(r%u): unknown variable!", index);
-    Variable *v = &it.value();
 
     if (unlikely(v->placeholder))
         jitc_raise_placeholder_error("jitc_var_schedule", index);
     if (unlikely(v->consumed))
         jitc_raise_placeholder_error("jitc_var_schedule", index);
 
-    if (v->is_stmt() || v->is_node()) {
-        thread_state(v->backend)->scheduled.push_back(index);
+    if (v->is_node()) {
+        thread_state(v->backend)->scheduled.emplace_back(index, v->counter);
         jitc_log(Debug, "jit_var_schedule(r%u)", index);
         return 1;
     } else if (v->is_dirty()) {
@@ -1040,7 +1008,7 @@ void *jitc_var_ptr(uint32_t index) {
        generating code to do so.. */
     if (v->is_literal())
         jitc_var_eval_literal(index, v);
-    else if (v->is_stmt() || v->is_node())
+    else if (v->is_node())
         jitc_var_eval(index);
 
     return jitc_var(index)->data;
@@ -1049,15 +1017,14 @@ void *jitc_var_ptr(uint32_t index) {
 /// Evaluate a literal constant variable
 void jitc_var_eval_literal(uint32_t index, Variable *v) {
     jitc_log(Debug,
-            "jit_var_eval_literal(r%u): writing %s literal of size %u",
+            "jit_var_eval_literal(r%u): writing %s literal of size %zu",
             index, type_name[v->type], v->size);
 
     jitc_lvn_drop(index, v);
 
     JitBackend backend = (JitBackend) v->backend;
     uint32_t isize = type_size[v->type];
-    void* data = jitc_malloc(backend == JitBackend::CUDA ? AllocType::Device
-                                                         : AllocType::HostAsync,
+    void* data = jitc_malloc(jitc_malloc_var_type(backend),
                              (size_t) v->size * (size_t) isize);
     v = jitc_var(index);
     jitc_memset_async(backend, data, v->size, isize, &v->literal);
@@ -1075,11 +1042,11 @@ int jitc_var_eval(uint32_t index) {
     if (unlikely(v->consumed))
         jitc_raise_consumed_error("jitc_var_eval", index);
 
-    if (v->is_stmt() || v->is_node() || (v->is_data() && v->is_dirty())) {
+    if (v->is_node() || (v->is_data() && v->is_dirty())) {
         ThreadState *ts = thread_state(v->backend);
 
         if (!v->is_data())
-            ts->scheduled.push_back(index);
+            ts->scheduled.emplace_back(index, v->counter);
 
         jitc_eval(ts);
         v = jitc_var(index);
@@ -1097,9 +1064,11 @@ int jitc_var_eval(uint32_t index) {
 
 /// Read a single element of a variable and write it to 'dst'
 void jitc_var_read(uint32_t index, size_t offset, void *dst) {
+    ImplicitSync sync("jit_var_read", index);
     const Variable *v = jitc_var(index);
 
-    if (v->is_stmt() || v->is_node() || (v->is_data() && v->is_dirty())) {
+    if (v->is_node() || (v->is_data() && v->is_dirty())) {
+        jitc_stat(Stat::ImplicitEvals);
         jitc_var_eval(index);
         v = jitc_var(index);
     }
@@ -1108,15 +1077,17 @@ void jitc_var_read(uint32_t index, size_t offset, void *dst) {
         offset = 0;
     else if (unlikely(offset >= (size_t) v->size))
         jitc_raise("jit_var_read(): attempted to access entry %zu in an array of "
-                   "size %u!", offset, v->size);
+                   "size %zu!", offset, v->size);
 
     uint32_t isize = type_size[v->type];
     if (v->is_literal())
         memcpy(dst, &v->literal, isize);
-    else if (v->is_data())
+    else if (v->is_data()) {
+        if ((JitBackend) v->backend == JitBackend::CUDA)
+            jitc_stat(Stat::BytesDeviceToHost, isize);
         jitc_memcpy((JitBackend) v->backend, dst,
                     (const uint8_t *) v->data + offset * isize, isize);
-    else
+    } else
         jitc_fail("jit_var_read(): internal error!");
 }
 
@@ -1135,29 +1106,188 @@ uint32_t jitc_var_write(uint32_t index, size_t offset, const void *src) {
     v = jitc_var(index);
     if (unlikely(offset >= (size_t) v->size))
         jitc_raise("jit_var_write(): attempted to access entry %zu in an array of "
-                   "size %u!", offset, v->size);
+                   "size %zu!", offset, v->size);
 
     uint32_t isize = type_size[v->type];
     uint8_t *dst = (uint8_t *) v->data + offset * isize;
+    if ((JitBackend) v->backend == JitBackend::CUDA)
+        jitc_stat(Stat::BytesHostToDevice, isize);
     jitc_poke((JitBackend) v->backend, dst, src, isize);
 
     return index;
 }
 
+/// Check that all variables of a batch operation use the same backend
+static JitBackend jitc_var_batch_backend(const char *name, uint32_t count,
+                                         const uint32_t *indices,
+                                         const size_t *offsets,
+                                         bool broadcast) {
+    JitBackend backend = (JitBackend) jitc_var(indices[0])->backend;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const Variable *v = jitc_var(indices[i]);
+        if (unlikely((JitBackend) v->backend != backend))
+            jitc_raise("%s(): all variables must use the same backend!", name);
+        if (unlikely((!broadcast || v->size != 1) &&
+                     offsets[i] >= (size_t) v->size))
+            jitc_raise("%s(): attempted to access entry %zu in an array of "
+                       "size %zu!", name, offsets[i], v->size);
+    }
+
+    return backend;
+}
+
+void jitc_var_read_batch(uint32_t count, const uint32_t *indices,
+                         const size_t *offsets, void *const *dst) {
+    if (count == 0)
+        return;
+
+    ImplicitSync sync("jit_var_read_batch", indices[0]);
+    JitBackend backend =
+        jitc_var_batch_backend("jit_var_read_batch", count, indices, offsets,
+                               true);
+
+    // Evaluate all inputs together
+    bool eval = false;
+    for (uint32_t i = 0; i < count; ++i)
+        eval |= jitc_var_schedule(indices[i]) != 0;
+    if (eval) {
+        jitc_stat(Stat::ImplicitEvals);
+        jitc_eval(thread_state(backend));
+    }
+
+    /* Gather the elements into a pinned (CUDA) or host (LLVM) buffer with a
+       single kernel, using 8 bytes per element */
+    bool cuda = backend == JitBackend::CUDA;
+    size_t rec_size = sizeof(VCallDataRecord) * count;
+    VCallDataRecord *rec =
+        (VCallDataRecord *) (cuda ? jitc_malloc(AllocType::HostPinned, rec_size)
+                                  : malloc_check(rec_size));
+    uint8_t *out = (uint8_t *) jitc_malloc(
+        cuda ? AllocType::HostPinned : AllocType::HostAsync,
+        sizeof(uint64_t) * count);
+
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const Variable *v = jitc_var(indices[i]);
+        uint32_t isize = type_size[v->type];
+        size_t offset = v->size == 1 ? 0 : offsets[i];
+
+        if (v->is_literal()) {
+            memcpy(dst[i], &v->literal, isize);
+        } else if (v->is_data() && !v->is_dirty()) {
+            VCallDataRecord &r = rec[n++];
+            r.offset = i * (uint32_t) sizeof(uint64_t);
+            r.size = isize;
+            r.src = (const uint8_t *) v->data + offset * isize;
+        } else {
+            jitc_fail("jit_var_read_batch(): internal error!");
+        }
+    }
+
+    if (n) {
+        jitc_log(Debug, "jit_var_read_batch(): reading %u elements.", n);
+        jitc_vcall_prepare(backend, out, rec, n);
+        jitc_stat(Stat::ImplicitSyncs);
+        jitc_sync_thread();
+        if (cuda)
+            jitc_stat(Stat::BytesDeviceToHost, sizeof(uint64_t) * n);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const Variable *v = jitc_var(indices[i]);
+            if (!v->is_literal())
+                memcpy(dst[i], out + i * sizeof(uint64_t), type_size[v->type]);
+        }
+    } else if (cuda) {
+        jitc_free(rec);
+    } else {
+        free(rec);
+    }
+
+    jitc_free(out);
+}
+
+void jitc_var_write_batch(uint32_t count, const uint32_t *indices,
+                          const size_t *offsets, const void *const *src,
+                          uint32_t *indices_out) {
+    if (count == 0)
+        return;
+
+    JitBackend backend =
+        jitc_var_batch_backend("jit_var_write_batch", count, indices, offsets,
+                               false);
+
+    // Writes to the same variable share a single copy (see jitc_var_write())
+    tsl::robin_map<uint32_t, uint32_t, UInt32Hasher> targets;
+    bool eval = false;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = indices[i];
+        auto it = targets.find(index);
+
+        if (it != targets.end()) {
+            index = it->second;
+            jitc_var_inc_ref(index);
+        } else {
+            Variable *v = jitc_var(index);
+            if (v->is_dirty() || v->ref_count > 1) {
+                // Not safe to directly write to 'v'
+                index = jitc_var_copy(index);
+            } else {
+                jitc_var_inc_ref(index);
+            }
+
+            targets.emplace(indices[i], index);
+            if (jitc_var(index)->is_node())
+                eval |= jitc_var_schedule(index) != 0;
+        }
+
+        indices_out[i] = index;
+    }
+
+    if (eval)
+        jitc_eval(thread_state(backend));
+
+    bool cuda = backend == JitBackend::CUDA;
+    size_t rec_size = sizeof(PokeRecord) * count;
+    PokeRecord *rec =
+        (PokeRecord *) (cuda ? jitc_malloc(AllocType::HostPinned, rec_size)
+                             : malloc_check(rec_size));
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = indices_out[i];
+        uint8_t *data = (uint8_t *) jitc_var_ptr(index);
+        const Variable *v = jitc_var(index);
+        uint32_t isize = type_size[v->type];
+
+        PokeRecord &r = rec[i];
+        r.dst = data + offsets[i] * isize;
+        r.value = 0;
+        r.size = isize;
+        r.unused = 0;
+        memcpy(&r.value, src[i], isize);
+    }
+
+    jitc_log(Debug, "jit_var_write_batch(): writing %u elements.", count);
+    if (cuda)
+        jitc_stat(Stat::BytesHostToDevice, sizeof(PokeRecord) * count);
+    jitc_poke_batch(backend, rec, count);
+}
+
 /// Register an existing variable with the JIT compiler
 uint32_t jitc_var_mem_map(JitBackend backend, VarType type, void *ptr,
                           size_t size, int free) {
     if (unlikely(size == 0))
         return 0;
 
-    jitc_check_size("jit_var_mem_map", size);
+    jitc_check_size("jit_var_mem_map", backend, size);
 
     Variable v;
     v.kind = (uint32_t) VarKind::Data;
     v.type = (uint32_t) type;
     v.backend = (uint32_t) backend;
     v.data = ptr;
-    v.size = (uint32_t) size;
+    v.size = size;
     v.retain_data = free == 0;
 
     if (backend == JitBackend::LLVM) {
@@ -1166,7 +1296,12 @@ uint32_t jitc_var_mem_map(JitBackend backend, VarType type, void *ptr,
         v.unaligned = uintptr_t(ptr) % align != 0;
     }
 
-    return jitc_var_new(v, true);
+    uint32_t index = jitc_var_new(v, true);
+
+    if (unlikely(jitc_flags() & (uint32_t) JitFlag::MallocProfile) && free)
+        jitc_malloc_profile_tag(ptr, index, nullptr, 0);
+
+    return index;
 }
 
 /// Copy a memory region onto the device and return its variable index
@@ -1175,16 +1310,18 @@ uint32_t jitc_var_mem_copy(JitBackend backend, AllocType atype, VarType vtype,
     if (unlikely(size == 0))
         return 0;
 
-    jitc_check_size("jit_var_mem_copy", size);
+    jitc_check_size("jit_var_mem_copy", backend, size);
 
     size_t total_size = (size_t) size * (size_t) type_size[(int) vtype];
     void *target_ptr;
 
     ThreadState *ts = thread_state(backend);
     if (backend == JitBackend::CUDA) {
-        target_ptr = jitc_malloc(AllocType::Device, total_size);
+        target_ptr = jitc_malloc(jitc_malloc_var_type(backend), total_size);
 
         scoped_set_context guard(ts->context);
+        if (atype != AllocType::Device)
+            jitc_stat(Stat::BytesHostToDevice, total_size);
         if (atype == AllocType::HostAsync) {
             jitc_fail("jit_var_mem_copy(): copy from HostAsync to GPU memory not supported!");
         } else if (atype == AllocType::Host) {
@@ -1217,6 +1354,8 @@ uint32_t jitc_var_mem_copy(JitBackend backend, AllocType atype, VarType vtype,
             target_ptr = jitc_malloc_migrate(target_ptr, AllocType::HostAsync, 1);
         } else {
             target_ptr = jitc_malloc(AllocType::HostPinned, total_size);
+            if (atype == AllocType::Device)
+                jitc_stat(Stat::BytesDeviceToHost, total_size);
             cuda_check(cuMemcpyAsync((CUdeviceptr) target_ptr,
                                      (CUdeviceptr) ptr, total_size,
                                      ts->stream));
@@ -1259,10 +1398,7 @@ uint32_t jitc_var_copy(uint32_t index) {
             v2.kind = (uint32_t) VarKind::Literal;
             v2.literal = v->literal;
         } else {
-            v2.kind = (uint32_t) VarKind::Stmt;
-            v2.stmt = (char *) (((JitBackend) v->backend == JitBackend::CUDA)
-                                ? "mov.$t0 $r0, $r1"
-                                : "$r0 = bitcast <$w x $t1> $r1 to <$w x $t0>");
+            v2.kind = (uint32_t) VarKind::Copy;
             v2.dep[0] = index;
             jitc_var_inc_ref(index, v);
         }
@@ -1278,15 +1414,23 @@ uint32_t jitc_var_resize(uint32_t index, size_t size) {
     if (index == 0 && size == 0)
         return 0;
 
-    jitc_check_size("jit_var_resize", size);
-
     Variable *v = jitc_var(index);
+    jitc_check_size("jit_var_resize", (JitBackend) v->backend, size);
     if (unlikely(v->consumed))
         jitc_raise_consumed_error("jitc_var_resize", index);
 
     if (v->size == size) {
         jitc_var_inc_ref(index, v);
         return index; // Nothing to do
+    } else if (v->is_data() && v->ref_count == 1 && size > v->size &&
+               jitc_malloc_grow(v->data, size * type_size[v->type])) {
+        /* Memory was allocated via jit_malloc_reserve() and could be enlarged
+           in place. The new entries are uninitialized. */
+        jitc_log(Debug, "jit_var_resize(r%u, size=%zu): grew in place", index,
+                 size);
+        jitc_var_inc_ref(index, v);
+        v->size = size;
+        return index;
     } else if (v->size != 1 && !v->is_literal()) {
         jitc_raise("jit_var_resize(): variable %u must be scalar or value!", index);
     }
@@ -1303,25 +1447,28 @@ uint32_t jitc_var_resize(uint32_t index, size_t size) {
         // Nobody else holds a reference -- we can directly resize this variable
         jitc_var_inc_ref(index, v);
         jitc_lvn_drop(index, v);
-        v->size = (uint32_t) size;
+        v->size = size;
         jitc_lvn_put(index, v);
         result = index;
     } else if (v->is_literal()) {
         result = jitc_var_literal((JitBackend) v->backend, (VarType) v->type,
                                   &v->literal, size, 0);
     } else {
+        /* Symbolic broadcast that reads the scalar within each kernel (a
+           uniform load for evaluated variables). Unlike jitc_var_copy(), it
+           does not need to be distinct, hence repeated broadcasts of the
+           same variable are merged by local value numbering. Should the
+           result become the target of a scatter, jitc_var_scatter()
+           evaluates it into an N-element buffer at that point. */
         Variable v2;
-        v2.kind = (uint32_t) VarKind::Stmt;
+        v2.kind = (uint32_t) VarKind::Copy;
         v2.type = v->type;
         v2.backend = v->backend;
         v2.placeholder = v->placeholder;
-        v2.size = (uint32_t) size;
+        v2.size = size;
         v2.dep[0] = index;
-        v2.stmt = (char *) (((JitBackend) v->backend == JitBackend::CUDA)
-                            ? "mov.$t0 $r0, $r1"
-                            : "$r0 = bitcast <$w x $t1> $r1 to <$w x $t0>");
         jitc_var_inc_ref(index, v);
-        result = jitc_var_new(v2, true);
+        result = jitc_var_new(v2);
     }
 
     jitc_log(Debug, "jit_var_resize(r%u <- r%u, size=%zu)", result, index, size);
@@ -1373,7 +1520,7 @@ uint32_t jitc_var_migrate(uint32_t src_index, AllocType dst_type) {
             jitc_memset_async(dst_type == AllocType::HostAsync
                                   ? JitBackend::LLVM
                                   : JitBackend::CUDA,
-                              ptr, (uint32_t) size, type_size[v->type], &v->literal);
+                              ptr, size, type_size[v->type], &v->literal);
         }
 
         return jitc_var_mem_map(backend, (VarType) v->type, ptr, v->size, 1);
@@ -1410,7 +1557,7 @@ uint32_t jitc_var_migrate(uint32_t src_index, AllocType dst_type) {
         dst_ptr = jitc_malloc(dst_type, size);
         jitc_memcpy_async(backend, dst_ptr, src_ptr, size);
     } else {
-        auto [size, type, device] = alloc_info_decode(it->second);
+        auto [size, type, device] = alloc_info_decode(it->second.info);
         (void) size; (void) device;
         src_type = type;
         dst_ptr = jitc_malloc_migrate(src_ptr, dst_type, 0);
@@ -1441,7 +1588,194 @@ uint32_t jitc_var_migrate(uint32_t src_index, AllocType dst_type) {
     return dst_index;
 }
 
-uint32_t jitc_var_mask_default(JitBackend backend, uint32_t size) {
+/// Temporarily bind the CUDA thread state to another device
+struct scoped_cuda_device {
+    scoped_cuda_device(ThreadState *ts, int device)
+        : ts(ts), prev(ts->device) {
+        jitc_cuda_bind_device(ts, device, true);
+    }
+    ~scoped_cuda_device() { jitc_cuda_bind_device(ts, prev, false); }
+
+    ThreadState *ts;
+    int prev;
+};
+
+/// Check the arguments of the jitc_var_*shard*() functions
+static void jitc_var_shard_check(const char *name, uint32_t count,
+                                 const int *devices) {
+    if (unlikely(count == 0))
+        jitc_raise("%s(): at least one device must be specified!", name);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (unlikely((size_t) devices[i] >= state.devices.size()))
+            jitc_raise("%s(): device %i must be in the range 0..%i!", name,
+                       devices[i], (int) state.devices.size() - 1);
+    }
+}
+
+/// Evaluate a CUDA variable, ensure that it resides in device memory, and return its device
+static Ref jitc_var_shard_source(uint32_t index, int &device) {
+    Ref ref = borrow(index);
+    jitc_var_eval(index);
+
+    auto it = state.alloc_used.find((uintptr_t) jitc_var(index)->data);
+    if (it != state.alloc_used.end()) {
+        auto [size, type, device_2] = alloc_info_decode(it->second.info);
+        (void) size;
+        if (type == AllocType::Device) {
+            device = device_2;
+            return ref;
+        }
+    }
+
+    // Memory that is mapped or not located on a device
+    ref = steal(jitc_var_migrate(index, AllocType::Device));
+    device = thread_state(JitBackend::CUDA)->device;
+    return ref;
+}
+
+void jitc_var_shard(uint32_t index, uint32_t count, const int *devices,
+                    uint32_t *out) {
+    jitc_var_shard_check("jit_var_shard", count, devices);
+
+    const Variable *v = jitc_var(index);
+    if (unlikely((JitBackend) v->backend != JitBackend::CUDA))
+        jitc_raise("jit_var_shard(r%u): only CUDA variables can be sharded!",
+                   index);
+
+    VarType type = (VarType) v->type;
+    size_t size = v->size, isize = type_size[(int) type];
+    if (unlikely(count > size))
+        jitc_raise("jit_var_shard(r%u): cannot split %zu entries into %u "
+                   "shards!", index, size, count);
+
+    if (v->is_literal()) {
+        uint64_t value = v->literal;
+        for (uint32_t i = 0; i < count; ++i)
+            out[i] = jitc_var_literal(JitBackend::CUDA, type, &value,
+                                      size * (i + 1) / count - size * i / count,
+                                      0);
+        return;
+    }
+
+    int src_device;
+    Ref src = jitc_var_shard_source(index, src_device);
+    const uint8_t *src_ptr = (const uint8_t *) jitc_var(src)->data;
+
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    std::vector<PeerCopy> copies(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t start = size * i / count, end = size * (i + 1) / count;
+        void *ptr;
+
+        /* Allocate on the target device */ {
+            scoped_cuda_device guard(ts, devices[i]);
+            ptr = jitc_malloc(AllocType::Device, (end - start) * isize);
+        }
+
+        copies[i] = PeerCopy{ ptr, src_ptr + start * isize,
+                              (end - start) * isize, devices[i], src_device };
+        out[i] = jitc_var_mem_map(JitBackend::CUDA, type, ptr,
+                                  (uint32_t) (end - start), 1);
+    }
+
+    jitc_memcpy_peer_async(copies.data(), count);
+
+    jitc_log(Debug, "jit_var_shard(r%u): split into %u shards (source device "
+             "%i).", index, count, src_device);
+}
+
+uint32_t jitc_var_unshard(uint32_t count, const uint32_t *indices,
+                          const int *devices) {
+    jitc_var_shard_check("jit_var_unshard", count, devices);
+
+    const Variable *v0 = jitc_var(indices[0]);
+    VarType type = (VarType) v0->type;
+    size_t size = 0, isize = type_size[(int) type];
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const Variable *v = jitc_var(indices[i]);
+        if (unlikely((JitBackend) v->backend != JitBackend::CUDA ||
+                     (VarType) v->type != type))
+            jitc_raise("jit_var_unshard(): all shards must be CUDA variables "
+                       "of the same type!");
+        size += v->size;
+    }
+
+    if (unlikely(size > 0xFFFFFFFFull))
+        jitc_raise("jit_var_unshard(): the combined size (%zu) is too large!",
+                   size);
+
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+
+    // Evaluate the shards on their devices. The kernels run concurrently.
+    for (uint32_t i = 0; i < count; ++i) {
+        const Variable *v = jitc_var(indices[i]);
+        if (v->is_literal() || (v->is_data() && !v->is_dirty()))
+            continue;
+        scoped_cuda_device guard(ts, devices[i]);
+        jitc_var_eval(indices[i]);
+    }
+
+    uint8_t *ptr = (uint8_t *) jitc_malloc(AllocType::Device, size * isize);
+    std::vector<PeerCopy> copies;
+    std::vector<Ref> sources;
+    copies.reserve(count);
+    sources.reserve(count);
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const Variable *v = jitc_var(indices[i]);
+        size_t shard_size = v->size;
+
+        if (v->is_literal()) {
+            jitc_memset_async(JitBackend::CUDA, ptr + offset * isize,
+                              shard_size, (uint32_t) isize, &v->literal);
+        } else {
+            int src_device;
+            sources.push_back(jitc_var_shard_source(indices[i], src_device));
+            copies.push_back(PeerCopy{ ptr + offset * isize,
+                                       jitc_var(sources.back())->data,
+                                       shard_size * isize, ts->device,
+                                       src_device });
+        }
+
+        offset += shard_size;
+    }
+
+    jitc_memcpy_peer_async(copies.data(), (uint32_t) copies.size());
+
+    uint32_t result =
+        jitc_var_mem_map(JitBackend::CUDA, type, ptr, (uint32_t) size, 1);
+
+    jitc_log(Debug, "jit_var_unshard(r%u): combined %u shards.", result, count);
+
+    return result;
+}
+
+uint32_t jitc_var_reduce_shards(ReduceOp reduce_op, uint32_t count,
+                                const uint32_t *indices, const int *devices) {
+    jitc_var_shard_check("jit_var_reduce_shards", count, devices);
+
+    ThreadState *ts = thread_state(JitBackend::CUDA);
+    std::vector<Ref> partial(count);
+    std::vector<uint32_t> partial_indices(count);
+
+    // Per-device reductions, including the evaluation of the shards
+    for (uint32_t i = 0; i < count; ++i) {
+        scoped_cuda_device guard(ts, devices[i]);
+        partial[i] = steal(jitc_var_reduce(indices[i], reduce_op));
+        partial_indices[i] = partial[i];
+    }
+
+    Ref combined = steal(
+        jitc_var_unshard(count, partial_indices.data(), devices));
+
+    return jitc_var_reduce(combined, reduce_op);
+}
+
+uint32_t jitc_var_mask_default(JitBackend backend, size_t size) {
     if (backend == JitBackend::CUDA) {
         bool value = true;
         return jitc_var_literal(backend, VarType::Bool, &value, size, 0);
@@ -1473,7 +1807,7 @@ void jitc_var_mask_push(JitBackend backend, uint32_t index) {
     thread_state(backend)->mask_stack.push_back(index);
 }
 
-uint32_t jitc_var_mask_apply(uint32_t index, uint32_t size) {
+uint32_t jitc_var_mask_apply(uint32_t index, size_t size) {
     const Variable *v = jitc_var(index);
     JitBackend backend = (JitBackend) v->backend;
 
@@ -1483,8 +1817,8 @@ uint32_t jitc_var_mask_apply(uint32_t index, uint32_t size) {
     auto &stack = thread_state(backend)->mask_stack;
     Ref mask;
     if (!stack.empty()) {
-        uint32_t index_2 = stack.back(),
-                 size_2  = jitc_var(index_2)->size;
+        uint32_t index_2 = stack.back();
+        size_t size_2 = jitc_var(index_2)->size;
 
         // Use mask from the mastk stack if its size is compatible
         if (size == 1 || size_2 == 1 || size_2 == size)
@@ -1502,7 +1836,7 @@ uint32_t jitc_var_mask_apply(uint32_t index, uint32_t size) {
         result = jitc_var_resize(index, size);
     }
 
-    jitc_log(Debug, "jit_var_apply_mask(r%u <- r%u, size=%u)", result, index, size);
+    jitc_log(Debug, "jit_var_apply_mask(r%u <- r%u, size=%zu)", result, index, size);
     return result;
 }
 
@@ -1532,6 +1866,8 @@ bool jitc_var_any(uint32_t index) {
     if (v->is_literal())
         return (bool) v->literal;
 
+    ImplicitSync sync("jit_var_any", index);
+
     if (jitc_var_eval(index))
         v = jitc_var(index);
 
@@ -1547,19 +1883,126 @@ bool jitc_var_all(uint32_t index) {
     if (v->is_literal())
         return (bool) v->literal;
 
+    ImplicitSync sync("jit_var_all", index);
+
     if (jitc_var_eval(index))
         v = jitc_var(index);
 
     return jitc_all((JitBackend) v->backend, (uint8_t *) v->data, v->size);
 }
 
-template <typename T> static void jitc_var_reduce_scalar(uint32_t size, void *ptr) {
+template <typename T> static void jitc_var_reduce_scalar(size_t size, void *ptr) {
     T value;
     memcpy(&value, ptr, sizeof(T));
     value = T(value * T(size));
     memcpy(ptr, &value, sizeof(T));
 }
 
+/// Would evaluating 'v' exceed the threshold of jit_set_eval_memory_warning()?
+static bool jitc_var_over_threshold(const Variable *v) {
+    return state.eval_memory_warning &&
+           (size_t) v->size * type_size[v->type] > state.eval_memory_warning;
+}
+
+/**
+ * \brief Can jitc_var_reduce() compute the reduction of 'v' within the kernel
+ * that produces it? (see \ref JitFlag::KernelFusion)
+ *
+ * The kernel then accumulates partial results via atomic scatter-reductions,
+ * and the full array is never written to memory. This requires atomic
+ * operations, which are unavailable for products and for the minimum/maximum
+ * of floating point values. Unevaluated inputs that other variables depend on
+ * are left alone, since they would be computed twice. On the CUDA backend,
+ * the contention of the atomics only pays off when the array would exceed
+ * the memory threshold (see \ref jit_set_eval_memory_warning()).
+ */
+static bool jitc_var_reduce_fusable(const Variable *v, ReduceOp reduce_op) {
+    if (!v->is_node() || v->placeholder || v->size <= 1 || v->ref_count != 1)
+        return false;
+
+    bool over_threshold = jitc_var_over_threshold(v);
+    if ((JitBackend) v->backend == JitBackend::LLVM) {
+        if (!jit_flag(JitFlag::KernelFusion) && !over_threshold)
+            return false;
+    } else if (!over_threshold) {
+        return false;
+    }
+
+    VarType vt = (VarType) v->type;
+    if (type_size[(int) vt] < 4)
+        return false;
+
+    switch (reduce_op) {
+        case ReduceOp::Add:
+            return jitc_is_arithmetic(vt);
+
+        case ReduceOp::Min:
+        case ReduceOp::Max:
+            return jitc_is_int(vt);
+
+        default:
+            return false;
+    }
+}
+
+static uint32_t jitc_var_reduce_fused(uint32_t index, ReduceOp reduce_op) {
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+    size_t size = v->size;
+    uint32_t block_size = DRJIT_POOL_BLOCK_SIZE,
+             blocks = (uint32_t) ((size + block_size - 1) / block_size);
+
+    /* The LLVM backend processes blocks sequentially, hence each one updates
+       its own slot. CUDA threads instead spread their updates over a set of
+       slots interleaved with the thread index to limit their contention. */
+    bool interleave = backend == JitBackend::CUDA;
+    if (interleave) {
+        size_t slots = state.eval_memory_warning / type_size[(int) type];
+        blocks = (uint32_t) std::max(std::min(slots, std::min(size, (size_t) 65536)),
+                                     (size_t) 1);
+        block_size = blocks;
+    }
+
+    // Neutral element of the reduction
+    uint64_t init = 0;
+    bool is_min = reduce_op == ReduceOp::Min;
+    if (is_min || reduce_op == ReduceOp::Max) {
+        switch (type) {
+            case VarType::Int32:  init = (uint32_t) (is_min ? INT32_MAX : INT32_MIN); break;
+            case VarType::UInt32: init = is_min ? UINT32_MAX : 0; break;
+            case VarType::Int64:  init = (uint64_t) (is_min ? INT64_MAX : INT64_MIN); break;
+            case VarType::UInt64: init = is_min ? UINT64_MAX : 0; break;
+            default: break;
+        }
+    }
+
+    jitc_log(Debug, "jit_var_reduce(index=%u, reduce_op=%s): fusing into the "
+             "kernel computing the input (%u slot%s)", index,
+             reduction_name[(int) reduce_op], blocks, blocks == 1 ? "" : "s");
+
+    bool mask_value = true;
+    uint64_t divisor_value = block_size;
+    Ref partial = steal(jitc_var_literal(backend, type, &init, blocks, 0)),
+        counter = steal(jitc_var_counter(backend, size, false)),
+        divisor = steal(jitc_var_literal(backend, (VarType) jitc_var(counter)->type,
+                                         &divisor_value, 1, 0)),
+        slot = steal(interleave ? jitc_var_mod(counter, divisor)
+                                : jitc_var_div(counter, divisor)),
+        mask = steal(jitc_var_literal(backend, VarType::Bool, &mask_value, 1, 0));
+
+    partial = steal(jitc_var_scatter(partial, index, slot, mask, reduce_op));
+    jitc_var_eval(partial);
+
+    if (blocks == 1)
+        return partial.release();
+
+    void *data = jitc_malloc(jitc_malloc_var_type(backend),
+                             (size_t) type_size[(int) type]);
+    jitc_reduce(backend, type, reduce_op, jitc_var(partial)->data, blocks, data);
+    return jitc_var_mem_map(backend, type, data, 1, 1);
+}
+
 uint32_t jitc_var_reduce(uint32_t index, ReduceOp reduce_op) {
     if (unlikely(reduce_op == ReduceOp::And || reduce_op == ReduceOp::Or))
         jitc_raise("jitc_var_reduce: doesn't support And/Or operation!");
@@ -1573,7 +2016,7 @@ uint32_t jitc_var_reduce(uint32_t index, ReduceOp reduce_op) {
 
     if (v->is_literal()) {
         uint64_t value = v->literal;
-        uint32_t size = v->size;
+        size_t size = v->size;
 
         // Tricky cases
         if (size != 1 && (reduce_op == ReduceOp::Add)) {
@@ -1597,26 +2040,57 @@ uint32_t jitc_var_reduce(uint32_t index, ReduceOp reduce_op) {
         return jitc_var_literal(backend, type, &value, 1, 0);
     }
 
+    if (jitc_var_reduce_fusable(v, reduce_op))
+        return jitc_var_reduce_fused(index, reduce_op);
+
     jitc_log(Debug, "jit_var_reduce(index=%u, reduce_op=%s)", index, reduction_name[(int) reduce_op]);
 
     if (jitc_var_eval(index))
         v = jitc_var(index);
 
     uint8_t *values = (uint8_t *) v->data;
-    uint32_t size = v->size;
+    size_t size = v->size;
 
     void *data =
-        jitc_malloc(backend == JitBackend::CUDA ? AllocType::Device
-                                                : AllocType::HostAsync,
+        jitc_malloc(jitc_malloc_var_type(backend),
                     (size_t) type_size[(int) type]);
     jitc_reduce(backend, type, reduce_op, values, size, data);
     return jitc_var_mem_map(backend, type, data, 1, 1);
 }
 
+JitFuture *jitc_var_reduce_async(uint32_t index, ReduceOp reduce_op) {
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+    bool is_mask_op = reduce_op == ReduceOp::And || reduce_op == ReduceOp::Or;
+
+    if (unlikely((type == VarType::Bool) != is_mask_op))
+        jitc_raise("jit_var_reduce_async(r%u): boolean arrays require "
+                   "ReduceOp::And/Or, other types don't support them!", index);
+
+    if (v->is_literal()) {
+        uint64_t value = v->literal;
+        if (type != VarType::Bool) {
+            Ref result = steal(jitc_var_reduce(index, reduce_op));
+            value = jitc_var(result)->literal;
+        }
+        return jitc_future_literal(backend, type, value);
+    }
+
+    jitc_log(Debug, "jit_var_reduce_async(index=%u, reduce_op=%s)", index,
+             reduction_name[(int) reduce_op]);
+
+    if (jitc_var_eval(index))
+        v = jitc_var(index);
+
+    return jitc_reduce_async(backend, type, reduce_op, v->data, v->size);
+}
+
 uint32_t jitc_var_registry_attr(JitBackend backend, VarType type,
                                 const char *domain, const char *name) {
     uint32_t index = 0;
     Registry* registry = state.registry(backend);
+    jitc_registry_flush(backend);
     auto it = registry->attributes.find(AttributeKey(domain, name));
     if (unlikely(it == registry->attributes.end())) {
         if (jitc_registry_get_max(backend, domain) > 0) {
@@ -1640,10 +2114,11 @@ const char *jitc_var_whos() {
     var_buffer.put("\n  =======================================================================\n");
 
     std::vector<uint32_t> indices;
-    indices.reserve(state.variables.size());
-    for (const auto& it : state.variables)
-        indices.push_back(it.first);
-    std::sort(indices.begin(), indices.end());
+    indices.reserve(jitc_var_count());
+    for (uint32_t i = 1; i < (uint32_t) state.variables.size(); ++i) {
+        if (!state.variables[i].is_unused())
+            indices.push_back(i);
+    }
 
     size_t mem_size_evaluated = 0,
            mem_size_unevaluated = 0;
@@ -1667,7 +2142,7 @@ const char *jitc_var_whos() {
                 else
                     var_buffer.put("mapped mem.");
             } else {
-                auto [size, type, device] = alloc_info_decode(it->second);
+                auto [size, type, device] = alloc_info_decode(it->second.info);
                 (void) size;
 
                 if ((AllocType) type == AllocType::Device) {
@@ -1684,7 +2159,7 @@ const char *jitc_var_whos() {
         size_t sz = var_buffer.fmt("  %u", (uint32_t) v->ref_count);
         const char *label = jitc_var_label(index);
 
-        var_buffer.fmt("%*s%-10u%-8s   %s\n", 10 - (int) sz, "", v->size,
+        var_buffer.fmt("%*s%-10zu%-8s   %s\n", 10 - (int) sz, "", v->size,
                    jitc_mem_string(mem_size), label ? label : "");
 
         if (v->is_data())
@@ -1695,7 +2170,6 @@ const char *jitc_var_whos() {
     if (indices.empty())
         var_buffer.put("                       -- No variables registered --\n");
 
-    constexpr size_t BucketSize1 = sizeof(tsl::detail_robin_hash::bucket_entry<VariableMap::value_type, false>);
     constexpr size_t BucketSize2 = sizeof(tsl::detail_robin_hash::bucket_entry<LVNMap::value_type, false>);
 
     var_buffer.put("  =======================================================================\n\n");
@@ -1706,23 +2180,28 @@ const char *jitc_var_whos() {
     var_buffer.fmt("%s unevaluated.\n",
                jitc_mem_string(mem_size_unevaluated));
     var_buffer.fmt("   - Variables created : %u (peak: %u, table size: %s).\n",
-               state.variable_index, state.variable_watermark,
+               state.variable_counter - 1, state.variable_watermark,
                jitc_mem_string(
-                   state.variables.bucket_count() * BucketSize1 +
+                   state.variables.capacity() * sizeof(Variable) +
+                   state.variables_scratch.capacity() * sizeof(VariableScratch) +
+                   state.unused_variables.capacity() * sizeof(uint32_t) +
                    state.lvn_map.bucket_count() * BucketSize2));
     var_buffer.fmt("   - Kernel launches   : %zu (%zu cache hits, "
-               "%zu soft, %zu hard misses).\n\n",
+               "%zu soft, %zu hard misses, %zu evictions).\n\n",
                state.kernel_launches, state.kernel_hits,
-               state.kernel_soft_misses, state.kernel_hard_misses);
+               state.kernel_soft_misses, state.kernel_hard_misses,
+               state.kernel_evictions);
 
     var_buffer.put("  Memory allocator\n");
     var_buffer.put("  ================\n");
     for (int i = 0; i < (int) AllocType::Count; ++i)
-        var_buffer.fmt("   - %-18s: %s/%s used (peak: %s).\n",
+        var_buffer.fmt("   - %-18s: %s/%s used (peak: %s, padding: %s).\n",
                    alloc_type_name[i],
                    std::string(jitc_mem_string(state.alloc_usage[i])).c_str(),
                    std::string(jitc_mem_string(state.alloc_allocated[i])).c_str(),
-                   std::string(jitc_mem_string(state.alloc_watermark[i])).c_str());
+                   std::string(jitc_mem_string(state.alloc_watermark[i])).c_str(),
+                   std::string(jitc_mem_string(state.alloc_usage[i] -
+                                               state.alloc_requested[i])).c_str());
 
     return var_buffer.get();
 }
@@ -1730,11 +2209,12 @@ const char *jitc_var_whos() {
 /// Return a GraphViz representation of registered variables
 const char *jitc_var_graphviz() {
     std::vector<uint32_t> indices;
-    indices.reserve(state.variables.size());
-    for (const auto& it : state.variables)
-        indices.push_back(it.first);
+    indices.reserve(jitc_var_count());
+    for (uint32_t i = 1; i < (uint32_t) state.variables.size(); ++i) {
+        if (!state.variables[i].is_unused())
+            indices.push_back(i);
+    }
 
-    std::sort(indices.begin(), indices.end());
     var_buffer.clear();
     var_buffer.put("digraph {\n"
                    "    rankdir=TB;\n"
@@ -1854,16 +2334,14 @@ const char *jitc_var_graphviz() {
                 var_buffer.put("Evaluated");
                 color = "lightblue2";
             }
-        } else if (v->is_stmt()) {
+        } else if ((VarKind) v->kind == VarKind::Nop) {
+            // Placeholder nodes (loops, side effects) are identified by their label
             if ((VarType) v->type == VarType::Void)
                 color = "yellowgreen";
-
-            if (*v->stmt != '\0') {
-                print_escape(v->stmt);
-                var_buffer.put("\\l");
-            } else if (labeled) {
+            if (labeled)
                 var_buffer.rewind_to(var_buffer.size() - 1);
-            }
+            else
+                var_buffer.put("nop");
         } else {
             const char *name = var_kind_name[v->kind];
             var_buffer.put(name, strlen(name));
@@ -1874,7 +2352,7 @@ const char *jitc_var_graphviz() {
         if (labeled && !color)
             color = "wheat";
 
-        var_buffer.fmt("|{Type: %s %s|Size: %u}|{r%u|Refs: %u}}",
+        var_buffer.fmt("|{Type: %s %s|Size: %zu}|{r%u|Refs: %u}}",
             (JitBackend) v->backend == JitBackend::CUDA ? "cuda" : "llvm",
             type_name_short[v->type], v->size, index,
             (uint32_t) v->ref_count);
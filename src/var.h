@@ -15,10 +15,23 @@
 enum VarKind : uint32_t;
 
 struct Variable;
+struct WeakRef;
 
 /// Look up a variable by its ID
 extern Variable *jitc_var(uint32_t index);
 
+/// Look up a variable by its ID, return \c nullptr if it doesn't exist
+extern Variable *jitc_var_maybe(uint32_t index);
+
+/// Resolve a weak reference, return \c nullptr if the variable has expired
+extern Variable *jitc_var(WeakRef ref);
+
+/// Create a weak reference to an existing variable
+extern WeakRef jitc_var_weak(uint32_t index);
+
+/// Return the number of currently existing variables
+extern size_t jitc_var_count();
+
 /// Create a value constant variable of the given size
 extern uint32_t jitc_var_literal(JitBackend backend, VarType type,
                                  const void *value, size_t size,
@@ -28,36 +41,28 @@ extern uint32_t jitc_var_literal(JitBackend backend, VarType type,
 extern uint32_t jitc_var_counter(JitBackend backend, size_t size,
                                  bool simplify_scalar);
 
-/// Create a variable representing the result of a custom IR statement
-extern uint32_t jitc_var_stmt(JitBackend backend,
-                              VarType type,
-                              const char *stmt,
-                              int stmt_static,
-                              uint32_t n_dep,
-                              const uint32_t *dep);
-
 /// Create a new IR node. Just a wrapper around jitc_var_new without any error checking
 extern uint32_t jitc_var_new_node_0(JitBackend backend, VarKind kind,
-                                    VarType vt, uint32_t size, bool placeholder,
+                                    VarType vt, size_t size, bool placeholder,
                                     uint64_t payload = 0);
 
 extern uint32_t jitc_var_new_node_1(JitBackend backend, VarKind kind,
-                                    VarType vt, uint32_t size, bool placeholder,
+                                    VarType vt, size_t size, bool placeholder,
                                     uint32_t a0, Variable *v0,
                                     uint64_t payload = 0);
 
 extern uint32_t jitc_var_new_node_2(JitBackend backend, VarKind kind,
-                                    VarType vt, uint32_t size, bool placeholder,
+                                    VarType vt, size_t size, bool placeholder,
                                     uint32_t a0, Variable *v0, uint32_t a1, Variable *v1,
                                     uint64_t payload = 0);
 
 extern uint32_t jitc_var_new_node_3(JitBackend backend, VarKind kind,
-                                    VarType vt, uint32_t size, bool placeholder,
+                                    VarType vt, size_t size, bool placeholder,
                                     uint32_t a0, Variable *v0, uint32_t a1, Variable *v1,
                                     uint32_t a2, Variable *v2, uint64_t payload = 0);
 
 extern uint32_t jitc_var_new_node_4(JitBackend backend, VarKind kind,
-                                    VarType vt, uint32_t size, bool placeholder,
+                                    VarType vt, size_t size, bool placeholder,
                                     uint32_t a0, Variable *v0, uint32_t a1, Variable *v1,
                                     uint32_t a2, Variable *v2, uint32_t a3, Variable *v4,
                                     uint64_t payload = 0);
@@ -131,6 +136,19 @@ extern void jitc_var_set_callback(uint32_t index,
 /// Migrate a variable to a different flavor of memory
 extern uint32_t jitc_var_migrate(uint32_t index, AllocType type);
 
+/// Split a CUDA variable into index ranges that reside on different devices
+extern void jitc_var_shard(uint32_t index, uint32_t count, const int *devices,
+                           uint32_t *out);
+
+/// Evaluate shards on their devices and concatenate them on the current one
+extern uint32_t jitc_var_unshard(uint32_t count, const uint32_t *indices,
+                                 const int *devices);
+
+/// Reduce shards on their devices and combine the partial results
+extern uint32_t jitc_var_reduce_shards(ReduceOp reduce_op, uint32_t count,
+                                       const uint32_t *indices,
+                                       const int *devices);
+
 /// Indicate to the JIT compiler that a variable has side effects
 extern void jitc_var_mark_side_effect(uint32_t index);
 
@@ -143,6 +161,15 @@ extern void jitc_var_read(uint32_t index, size_t offset, void *dst);
 /// Reverse of jitc_var_read(). Copy 'src' to a single element of a variable
 extern uint32_t jitc_var_write(uint32_t index, size_t offset, const void *src);
 
+/// Read many elements of (possibly different) variables at once
+extern void jitc_var_read_batch(uint32_t count, const uint32_t *indices,
+                                const size_t *offsets, void *const *dst);
+
+/// Write many elements of (possibly different) variables at once
+extern void jitc_var_write_batch(uint32_t count, const uint32_t *indices,
+                                 const size_t *offsets, const void *const *src,
+                                 uint32_t *indices_out);
+
 /// Schedule a variable \c index for future evaluation via \ref jit_eval()
 extern int jitc_var_schedule(uint32_t index);
 
@@ -186,10 +213,10 @@ extern void jitc_var_mask_push(JitBackend backend, uint32_t index);
 extern void jitc_var_mask_pop(JitBackend backend);
 
 /// Combine the given mask 'index' with the mask stack. 'size' indicates the wavefront size
-extern uint32_t jitc_var_mask_apply(uint32_t index, uint32_t size);
+extern uint32_t jitc_var_mask_apply(uint32_t index, size_t size);
 
 /// Return the default mask
-extern uint32_t jitc_var_mask_default(JitBackend backend, uint32_t size);
+extern uint32_t jitc_var_mask_default(JitBackend backend, size_t size);
 
 /// Start a new scope of the program being recorded
 extern void jitc_new_scope(JitBackend backend);
@@ -203,6 +230,9 @@ extern bool jitc_var_any(uint32_t index);
 /// Reduce a variable to a single value
 extern uint32_t jitc_var_reduce(uint32_t index, ReduceOp reduce_op);
 
+/// Reduce a variable to a single value that is read back asynchronously
+extern JitFuture *jitc_var_reduce_async(uint32_t index, ReduceOp reduce_op);
+
 /// Create a variable containing the buffer storing a specific attribute
 extern uint32_t jitc_var_registry_attr(JitBackend backend, VarType type,
                                        const char *domain, const char *name);
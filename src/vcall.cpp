@@ -13,6 +13,7 @@
 #include "eval.h"
 #include "registry.h"
 #include "util.h"
+#include "stats.h"
 #include "op.h"
 #include "profiler.h"
 #include "vcall.h"
@@ -22,6 +23,138 @@ using CallablesSet = std::set<XXH128_hash_t, XXH128Cmp>;
 
 static std::vector<VCall *> vcalls_assembled;
 
+/// Offset table under construction in jitc_vcall_upload()
+static std::vector<uint64_t> vcall_offset_scratch;
+
+/// Compute a permutation that groups the entries of 'self' by instance
+static uint32_t jitc_var_vcall_perm(uint32_t self, uint32_t n_inst,
+                                    const uint32_t *inst_id) {
+    // A literal 'self' value is already coherent
+    if (jitc_var(self)->is_literal())
+        return 0;
+
+    uint32_t bucket_count = 0;
+    for (uint32_t i = 0; i < n_inst; ++i)
+        bucket_count = std::max(bucket_count, inst_id[i]);
+    bucket_count++;
+
+    jitc_var_eval(self);
+    const Variable *v = jitc_var(self);
+    uint32_t size = (uint32_t) v->size; // CUDA arrays have at most 2^32-1 entries
+
+    uint32_t *perm = (uint32_t *) jitc_malloc(AllocType::Device,
+                                              (size_t) size * sizeof(uint32_t));
+    jitc_mkperm(JitBackend::CUDA, (const uint32_t *) v->data, size,
+                bucket_count, perm, nullptr);
+
+    jitc_log(Debug, "jit_var_vcall(self=r%u): sorted %u entries into %u "
+             "buckets for coherent dispatch.", self, size, bucket_count);
+
+    return jitc_var_mem_map(JitBackend::CUDA, VarType::UInt32, perm, size, 1);
+}
+
+/// Per-instance call counts of a recorded call (JitFlag::VCallProfile)
+struct VCallProfile {
+    /// Counters indexed by instance ID (released once they are read back)
+    uint32_t *counts = nullptr;
+    uint32_t size = 0;
+
+    /// Was 'counts' referenced by a kernel?
+    bool active = false;
+
+    /// Most frequently called instance IDs
+    std::vector<uint32_t> hot;
+};
+
+/// Profiles indexed by a hash of the call's backend, name, and instance IDs
+static tsl::robin_map<uint64_t, VCallProfile, UInt64Hasher> vcall_profiles;
+
+/// Maximum number of instances that are called directly
+static const uint32_t vcall_profile_hot_max = 3;
+
+/// Minimum fraction of the calls that such an instance must receive
+static const double vcall_profile_hot_min = 0.1;
+
+/**
+ * Look up the profile of a call. Returns a pointer variable referencing the
+ * call counters if they still need to be collected. Otherwise, it copies the
+ * most frequently called instances into 'vcall->hot' and returns zero.
+ */
+static uint32_t jitc_var_vcall_profile(ThreadState *ts, VCall *vcall) {
+    JitBackend backend = vcall->backend;
+    uint64_t seed = XXH3_64bits(vcall->name, strlen(vcall->name)) +
+                    (uint64_t) backend;
+    uint64_t key = XXH3_64bits_withSeed(
+        vcall->inst_id.data(), vcall->inst_id.size() * sizeof(uint32_t), seed);
+
+    vcall->profile_key = key;
+    VCallProfile &p = vcall_profiles[key];
+
+    // Reading back or clearing the counters can't be part of a recording
+    bool recording = ts->graph_capture || ts->freeze;
+
+    if (!p.counts && !p.active) {
+        if (recording)
+            return 0;
+
+        for (uint32_t id : vcall->inst_id)
+            p.size = std::max(p.size, id + 1);
+
+        AllocType at = backend == JitBackend::CUDA ? AllocType::Device
+                                                   : AllocType::HostAsync;
+        uint32_t zero = 0;
+        p.counts = (uint32_t *) jitc_malloc(at, p.size * sizeof(uint32_t));
+        jitc_memset_async(backend, p.counts, p.size, sizeof(uint32_t), &zero);
+    }
+
+    if (p.counts) {
+        if (!p.active || recording)
+            return jitc_var_pointer(backend, p.counts, 0, 0);
+
+        std::unique_ptr<uint32_t[]> counts(new uint32_t[p.size]);
+        jitc_memcpy(backend, counts.get(), p.counts, p.size * sizeof(uint32_t));
+        jitc_free(p.counts);
+        p.counts = nullptr;
+
+        uint64_t total = 0;
+        std::vector<uint32_t> order;
+        for (uint32_t i = 1; i < p.size; ++i) {
+            total += counts[i];
+            if (counts[i])
+                order.push_back(i);
+        }
+
+        std::stable_sort(order.begin(), order.end(),
+                         [&counts](uint32_t a, uint32_t b) {
+                             return counts[a] > counts[b];
+                         });
+
+        for (uint32_t id : order) {
+            if (p.hot.size() == vcall_profile_hot_max ||
+                counts[id] < vcall_profile_hot_min * (double) total)
+                break;
+            p.hot.push_back(id);
+        }
+
+        jitc_log(Debug,
+                 "jit_var_vcall(): profile of call (\"%s\") recorded %llu "
+                 "calls, %zu instance%s will be called directly.",
+                 vcall->name, (unsigned long long) total, p.hot.size(),
+                 p.hot.size() == 1 ? "" : "s");
+    }
+
+    vcall->hot = p.hot;
+    return 0;
+}
+
+void jitc_vcall_shutdown() {
+    for (auto &kv : vcall_profiles) {
+        if (kv.second.counts)
+            jitc_free(kv.second.counts);
+    }
+    vcall_profiles.clear();
+}
+
 static void jitc_var_vcall_collect_data(
     tsl::robin_map<uint64_t, uint32_t, UInt64Hasher> &data_map,
     uint32_t &data_offset, uint32_t inst_id, uint32_t index,
@@ -85,8 +218,9 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
         jitc_raise("jit_var_vcall(): list of all output indices must be a "
                    "multiple of the instance count!");
 
-    uint32_t n_out = n_out_nested / n_inst, size = 0,
+    uint32_t n_out = n_out_nested / n_inst,
              in_size_initial = 0, out_size_initial = 0;
+    size_t size = 0;
 
     bool placeholder = false, dirty = false;
 
@@ -189,6 +323,11 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     std::unique_ptr<VCall> vcall(new VCall());
     vcall->backend = backend;
     vcall->name = strdup(name);
+
+    if (backend == JitBackend::CUDA && !placeholder && n_inst > 1 &&
+        jitc_var(self)->size == size && size > 1 &&
+        jit_flag(JitFlag::VCallCoherent))
+        vcall->perm = jitc_var_vcall_perm(self, n_inst, inst_id);
     vcall->n_inst = n_inst;
     vcall->inst_id = std::vector<uint32_t>(inst_id, inst_id + n_inst);
     vcall->inst_hash.resize(n_inst);
@@ -279,7 +418,9 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
                 continue;
 
             const Variable *v = jitc_var(index);
-            bool is_pointer = (VarType) v->type == VarType::Pointer;
+            // Pointers and literals are stored by value (in an 8-byte slot)
+            bool is_pointer = (VarType) v->type == VarType::Pointer ||
+                              v->is_literal();
             p->offset = offset;
             p->size = is_pointer ? 0u : type_size[v->type];
             p->src = is_pointer ? (const void *) v->literal : v->data;
@@ -377,7 +518,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     jitc_log(InfoSym,
              "jit_var_vcall(r%u, self=r%u): call (\"%s\") with %u instance%s, %u "
              "input%s, %u output%s (%u devirtualized), %u side effect%s, %u "
-             "byte%s of call data, %u elements%s%s", (uint32_t) vcall_v, self, name, n_inst,
+             "byte%s of call data, %zu elements%s%s", (uint32_t) vcall_v, self, name, n_inst,
              n_inst == 1 ? "" : "s", n_in, n_in == 1 ? "" : "s", n_out,
              n_out == 1 ? "" : "s", n_devirt, se_count, se_count == 1 ? "" : "s",
              data_size, data_size == 1 ? "" : "s", size,
@@ -403,7 +544,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
                  offset  = (uint32_t) -1;
 
         for (uint32_t i = 0; i < n_out_2; ++i) {
-            if (vcall_2->out[i] == index)
+            if (vcall_2->out[i].index == index)
                 offset = i;
         }
 
@@ -417,13 +558,12 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
             jitc_var_dec_ref(index_2);
             index_2 = 0;
         }
-        vcall_2->out[offset] = 0;
+        vcall_2->out[offset] = WeakRef();
 
         // Check if any input parameters became irrelevant
         for (uint32_t i = 0; i < vcall_2->in.size(); ++i) {
-            uint32_t index_2 = vcall_2->in_nested[i];
-            if (index_2 &&
-                state.variables.find(index_2) == state.variables.end()) {
+            WeakRef ref_2 = vcall_2->in_nested[i];
+            if (ref_2.index && !jitc_var(ref_2)) {
                 Extra *e = &state.extra[vcall_2->id];
                 if (unlikely(e->dep[i] != vcall_2->in[i]))
                     jitc_fail("jit_var_vcall(): internal error! (1)");
@@ -433,7 +573,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
                 e = &state.extra[vcall_2->id]; // may have changed
                 e->dep[i] = 0;
                 vcall_2->in[i] = 0;
-                vcall_2->in_nested[i] = 0;
+                vcall_2->in_nested[i] = WeakRef();
             }
         }
     };
@@ -441,7 +581,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     for (uint32_t i = 0; i < n_out; ++i) {
         uint32_t index = vcall->out_nested[i];
         if (!index) {
-            vcall->out.push_back(0);
+            vcall->out.emplace_back();
             continue;
         }
 
@@ -459,7 +599,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
             extra.callback_internal = true;
         }
 
-        vcall->out.push_back(index_2);
+        vcall->out.push_back(jitc_var_weak(index_2));
         snprintf(temp, sizeof(temp), "VCall: %s [out %u]", name, i);
         jitc_var_set_label(index_2, temp);
         out[i] = index_2;
@@ -484,7 +624,7 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
                 continue;
         }
 
-        vcall->in_nested.push_back(index);
+        vcall->in_nested.emplace_back(index, v->counter);
 
         uint32_t index_2 = v->dep[0];
         vcall->in.push_back(index_2);
@@ -498,9 +638,11 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     };
 
     std::sort(vcall->in.begin(), vcall->in.end(), comp);
-    std::sort(vcall->in_nested.begin(), vcall->in_nested.end(), comp);
+    std::sort(vcall->in_nested.begin(), vcall->in_nested.end(),
+              [&comp](WeakRef r0, WeakRef r1) { return comp(r0.index, r1.index); });
 
-    std::sort(vcall->out.begin(), vcall->out.end(), comp);
+    std::sort(vcall->out.begin(), vcall->out.end(),
+              [&comp](WeakRef r0, WeakRef r1) { return comp(r0.index, r1.index); });
     for (uint32_t i = 0; i < n_inst; ++i)
         std::sort(vcall->out_nested.begin() + (i + 0) * n_out,
                   vcall->out_nested.begin() + (i + 1) * n_out, comp);
@@ -509,6 +651,11 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     // 8. Install code generation and deallocation callbacks
     // =====================================================
 
+    if (jit_flag(JitFlag::VCallProfile) && n_inst > 1)
+        vcall->profile = jitc_var_vcall_profile(ts, vcall.get());
+
+    // The call counters (if any) are an additional dependency
+    uint32_t n_dep = (uint32_t) vcall->in.size() + (vcall->profile ? 1 : 0);
     size_t dep_size = vcall->in.size() * sizeof(uint32_t);
 
     {
@@ -518,12 +665,14 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     }
 
     Extra *e_special = &state.extra[vcall_v];
-    e_special->n_dep = (uint32_t) vcall->in.size();
-    e_special->dep = (uint32_t *) malloc_check(dep_size);
+    e_special->n_dep = n_dep;
+    e_special->dep = (uint32_t *) malloc_check(n_dep * sizeof(uint32_t));
 
     // Steal input dependencies from placeholder arguments
     if (dep_size)
         memcpy(e_special->dep, vcall->in.data(), dep_size);
+    if (vcall->profile)
+        e_special->dep[n_dep - 1] = vcall->profile;
 
     e_special->callback = [](uint32_t, int free, void *ptr) {
         if (free)
@@ -558,7 +707,7 @@ static ProfilerRegion profiler_region_vcall_assemble("jit_var_vcall_assemble");
 /// Called by the JIT compiler when compiling a virtual function call
 void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg, uint32_t mask_reg,
                              uint32_t offset_reg, uint32_t data_reg) {
-    uint32_t vcall_reg = jitc_var(vcall->id)->reg_index;
+    uint32_t vcall_reg = jitc_var_scratch(jitc_var(vcall->id))->reg_index;
 
     ProfilerPhase profiler(profiler_region_vcall_assemble);
 
@@ -568,10 +717,7 @@ void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg, uint32_t mask_reg,
 
     struct JitBackupRecord {
         ScheduledVariable sv;
-        uint32_t param_type : 2;
-        uint32_t output_flag : 1;
-        uint32_t reg_index;
-        uint32_t param_offset;
+        VariableScratch scratch;
     };
 
     std::vector<JitBackupRecord> backup;
@@ -579,8 +725,7 @@ void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg, uint32_t mask_reg,
 
     for (const ScheduledVariable &sv : schedule) {
         const Variable *v = jitc_var(sv.index);
-        backup.push_back(JitBackupRecord{ sv, v->param_type, v->output_flag,
-                                          v->reg_index, v->param_offset });
+        backup.push_back(JitBackupRecord{ sv, *jitc_var_scratch(v) });
     }
 
     int32_t alloca_size_backup = alloca_size;
@@ -601,33 +746,30 @@ void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg, uint32_t mask_reg,
              n_out_active = 0;
 
     for (uint32_t i = 0; i < n_in; ++i) {
-        auto it = state.variables.find(vcall->in[i]);
-        if (it == state.variables.end())
+        Variable *v = jitc_var_maybe(vcall->in[i]);
+        if (!v)
             continue;
 
-        uint32_t size = type_size[it.value().type],
+        uint32_t size = type_size[v->type],
                  offset = in_size;
-        Variable *v = &it.value();
         in_size += size;
         in_align = std::max(size, in_align);
         n_in_active++;
 
         // Transfer parameter offset to instances
-        auto it2 = state.variables.find(vcall->in_nested[i]);
-        if (it2 == state.variables.end())
+        Variable *v2 = jitc_var(vcall->in_nested[i]);
+        if (!v2)
             continue;
 
-        Variable *v2 = &it2.value();
-        v2->param_offset = offset;
-        v2->reg_index = v->reg_index;
+        jitc_var_scratch(v2)->param_offset = offset;
+        jitc_var_scratch(v2)->reg_index = jitc_var_scratch(v)->reg_index;
     }
 
     for (uint32_t i = 0; i < n_out; ++i) {
-        auto it = state.variables.find(vcall->out_nested[i]);
-        if (it == state.variables.end())
+        Variable *v = jitc_var_maybe(vcall->out_nested[i]);
+        if (!v)
             continue;
 
-        Variable *v = &it.value();
         uint32_t size = type_size[v->type];
         out_size += size;
         out_align = std::max(size, out_align);
@@ -667,24 +809,29 @@ void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg, uint32_t mask_reg,
     schedule.clear();
     for (const JitBackupRecord &b : backup) {
         Variable *v = jitc_var(b.sv.index);
-        v->param_type = b.param_type;
-        v->output_flag = b.output_flag;
-        v->reg_index = b.reg_index;
-        v->param_offset = b.param_offset;
+        *jitc_var_scratch(v) = b.scratch;
         schedule.push_back(b.sv);
     }
 
     alloca_size = alloca_size_backup;
     alloca_align = alloca_align_backup;
 
+    /* Calls are only counted (JitFlag::VCallProfile) when they are part of
+       the kernel itself, and not of another callable */
+    uint32_t profile_reg = 0;
+    if (vcall->profile && callable_depth == 0) {
+        profile_reg = jitc_var_scratch(jitc_var(vcall->profile))->reg_index;
+        vcall_profiles[vcall->profile_key].active = true;
+    }
+
     if (vcall->backend == JitBackend::CUDA)
         jitc_var_vcall_assemble_cuda(vcall, vcall_reg, self_reg, mask_reg,
-                                     offset_reg, data_reg, n_out, in_size,
-                                     in_align, out_size, out_align);
+                                     offset_reg, data_reg, profile_reg, n_out,
+                                     in_size, in_align, out_size, out_align);
     else
         jitc_var_vcall_assemble_llvm(vcall, vcall_reg, self_reg, mask_reg,
-                                     offset_reg, data_reg, n_out, in_size,
-                                     in_align, out_size, out_align);
+                                     offset_reg, data_reg, profile_reg, n_out,
+                                     in_size, in_align, out_size, out_align);
 
     jitc_log(
         InfoSym,
@@ -729,10 +876,20 @@ void jitc_var_vcall_collect_data(tsl::robin_map<uint64_t, uint32_t, UInt64Hasher
             jitc_raise(
                 "jit_var_vcall(): the virtual function call associated with "
                 "instance %u accesses an evaluated variable r%u of type "
-                "%s and size %u. However, only *scalar* (size == 1) "
+                "%s and size %zu. However, only *scalar* (size == 1) "
                 "evaluated variables can be accessed while recording "
                 "virtual function calls",
                 inst_id, index, type_name[v->type], v->size);
+    } else if (v->is_literal()) {
+        /* Optionally move literal constants into the call data so that
+           changing them does not require a recompilation. They are written
+           like pointers (as a 64-bit value) and thus occupy an 8-byte slot. */
+        if (v->size == 1 && (VarType) v->type != VarType::Void &&
+            jit_flag(JitFlag::VCallLiteralData)) {
+            uint32_t offset = (data_offset + 7) / 8 * 8;
+            it_and_status.first.value() = offset;
+            data_offset = offset + 8;
+        }
     } else {
         for (uint32_t i = 0; i < 4; ++i) {
             uint32_t index_2 = v->dep[i];
@@ -764,9 +921,14 @@ void jitc_vcall_upload(ThreadState *ts) {
     AllocType at = ts->backend == JitBackend::CUDA ? AllocType::HostPinned
                                                    : AllocType::Host;
 
+    /* Captured graphs and frozen functions replay the upload, which must
+       therefore be part of every recording */
+    bool force = ts->graph_capture || ts->freeze;
+    uint32_t n_skipped = 0;
+
     for (VCall *vcall : vcalls_assembled) {
-        uint64_t *data = (uint64_t *) jitc_malloc(at, vcall->offset_size);
-        memset(data, 0, vcall->offset_size);
+        vcall_offset_scratch.clear();
+        vcall_offset_scratch.resize(vcall->offset_size / sizeof(uint64_t), 0);
 
         for (uint32_t i = 0; i < vcall->n_inst; ++i) {
             auto it = globals_map.find(GlobalKey(vcall->inst_hash[i], true));
@@ -774,26 +936,29 @@ void jitc_vcall_upload(ThreadState *ts) {
                 jitc_fail("jitc_vcall_upload(): could not find callable!");
 
             // high part: instance data offset, low part: callable index
-            data[vcall->inst_id[i]] =
+            vcall_offset_scratch[vcall->inst_id[i]] =
                 (((uint64_t) vcall->data_offset[i]) << 32) |
                 it->second.callable_index;
         }
 
-        jitc_memcpy_async(ts->backend, vcall->offset, data, vcall->offset_size);
-
-        // Free call offset table asynchronously
-        if (vcall->backend == JitBackend::CUDA) {
-            jitc_free(data);
-        } else {
-            Task *new_task = task_submit_dep(
-                nullptr, &jitc_task, 1, 1,
-                [](uint32_t, void *payload) { jit_free(*((void **) payload)); },
-                &data, sizeof(void *), nullptr, 1);
-            task_release(jitc_task);
-            jitc_task = new_task;
+        // Callable indices only change when the kernel contains other callables
+        if (!force && vcall_offset_scratch == vcall->offset_host) {
+            n_skipped++;
+            continue;
         }
+
+        uint64_t *data = (uint64_t *) jitc_temp_malloc(ts, at, vcall->offset_size);
+        memcpy(data, vcall_offset_scratch.data(), vcall->offset_size);
+
+        // The staging buffer is recycled once the copy has finished
+        jitc_memcpy_async(ts->backend, vcall->offset, data, vcall->offset_size);
+        vcall->offset_host.swap(vcall_offset_scratch);
     }
 
+    if (n_skipped)
+        jitc_trace("jitc_vcall_upload(): reused %u/%zu offset tables.",
+                   n_skipped, vcalls_assembled.size());
+
     for (VCall *vcall : vcalls_assembled)
         jitc_var_dec_ref(vcall->id);
     vcalls_assembled.clear();
@@ -823,9 +988,15 @@ VCallBucket *jitc_var_vcall_reduce(JitBackend backend, const char *domain,
     }
 
     // Ensure input index array is fully evaluated
+    ImplicitSync sync("jit_var_vcall_reduce", index);
     jitc_var_eval(index);
 
-    uint32_t size = jitc_var(index)->size;
+    size_t size = jitc_var(index)->size;
+
+    // The permutation is computed by 'jitc_mkperm()' using 32-bit indices
+    if (unlikely(size > (size_t) UINT32_MAX))
+        jitc_raise("jit_var_vcall_reduce(): arrays with more than 2^32-1 "
+                   "entries are not supported (size=%zu)!", size);
 
     if (domain)
         jitc_log(Debug, "jit_vcall(r%u, domain=\"%s\")", index, domain);
@@ -845,7 +1016,7 @@ VCallBucket *jitc_var_vcall_reduce(JitBackend backend, const char *domain,
 
     // Compute permutation
     const uint32_t *self = (const uint32_t *) jitc_var_ptr(index);
-    uint32_t unique_count = jitc_mkperm(backend, self, size,
+    uint32_t unique_count = jitc_mkperm(backend, self, (uint32_t) size,
                                         bucket_count, perm, (uint32_t *) offsets),
              unique_count_out = unique_count;
 
@@ -15,6 +15,9 @@ extern uint32_t jitc_var_vcall(const char *domain, uint32_t self, uint32_t mask,
 
 extern void jitc_vcall_upload(ThreadState *ts);
 
+/// Release the call counters of JitFlag::VCallProfile
+extern void jitc_vcall_shutdown();
+
 extern VCallBucket *jitc_var_vcall_reduce(JitBackend backend,
                                           const char *domain, uint32_t index,
                                           uint32_t *bucket_count_out);
@@ -47,11 +50,11 @@ struct VCall {
 
     /// Input variables at call site
     std::vector<uint32_t> in;
-    /// Input placeholder variables
-    std::vector<uint32_t> in_nested;
+    /// Input placeholder variables (not referenced, may expire)
+    std::vector<WeakRef> in_nested;
 
-    /// Output variables at call site
-    std::vector<uint32_t> out;
+    /// Output variables at call site (not referenced, may expire)
+    std::vector<WeakRef> out;
     /// Output variables *per instance*
     std::vector<uint32_t> out_nested;
 
@@ -67,6 +70,21 @@ struct VCall {
     uint64_t *offset = nullptr;
     size_t offset_size = 0;
 
+    /// Host copy of the offset table last uploaded by jitc_vcall_upload()
+    std::vector<uint64_t> offset_host;
+
+    /// Permutation that sorts the entries by instance (JitFlag::VCallCoherent)
+    uint32_t perm = 0;
+
+    /// Pointer to per-instance call counters (JitFlag::VCallProfile)
+    uint32_t profile = 0;
+
+    /// Key of the associated entry in the profile table
+    uint64_t profile_key = 0;
+
+    /// Instance IDs that are called directly, most frequent first
+    std::vector<uint32_t> hot;
+
     /// Storage in bytes for inputs/outputs before simplifications
     uint32_t in_count_initial = 0;
     uint32_t in_size_initial = 0;
@@ -78,6 +96,7 @@ struct VCall {
     ~VCall() {
         for (uint32_t index : out_nested)
             jitc_var_dec_ref(index);
+        jitc_var_dec_ref(perm);
         clear_side_effects();
         free(name);
     }
@@ -92,6 +111,16 @@ struct VCall {
     }
 };
 
+/// Was the literal 'v' moved into the call data (JitFlag::VCallLiteralData)?
+inline bool jitc_vcall_literal_data(
+    const tsl::robin_map<uint64_t, uint32_t, UInt64Hasher> &data_map,
+    uint32_t inst_id, uint32_t index, const Variable *v) {
+    if (!v->is_literal() || data_map.empty())
+        return false;
+    auto it = data_map.find((uint64_t) index + (((uint64_t) inst_id) << 32));
+    return it != data_map.end() && it->second != (uint32_t) -1;
+}
+
 // Forward declarations
 extern void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg,
                                     uint32_t mask_reg, uint32_t offset_reg,
@@ -101,13 +130,13 @@ extern void jitc_var_vcall_assemble(VCall *vcall, uint32_t self_reg,
 extern void jitc_var_vcall_assemble_cuda(VCall *vcall, uint32_t vcall_reg,
                                          uint32_t self_reg, uint32_t mask_reg,
                                          uint32_t offset_reg, uint32_t data_reg,
-                                         uint32_t n_out, uint32_t in_size,
-                                         uint32_t in_align, uint32_t out_size,
-                                         uint32_t out_align);
+                                         uint32_t profile_reg, uint32_t n_out,
+                                         uint32_t in_size, uint32_t in_align,
+                                         uint32_t out_size, uint32_t out_align);
 
 extern void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
                                          uint32_t self_reg, uint32_t mask_reg,
                                          uint32_t offset_reg, uint32_t data_reg,
-                                         uint32_t n_out, uint32_t in_size,
-                                         uint32_t in_align, uint32_t out_size,
-                                         uint32_t out_align);
+                                         uint32_t profile_reg, uint32_t n_out,
+                                         uint32_t in_size, uint32_t in_align,
+                                         uint32_t out_size, uint32_t out_align);
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <cstring>
 #include <typeinfo>
+#include <thread>
 
 TEST_BOTH(01_creation_destruction_cse) {
     // Test CSE involving normal and evaluated constant literals
@@ -632,6 +633,836 @@ TEST_BOTH(07_and_or_mixed) {
     }
 }
 
+TEST_BOTH(08_parallel_compile) {
+    jit_set_flag(JitFlag::ParallelCompile, 1);
+
+    // Several kernels of different size within the same jit_eval()
+    Float a = arange<Float>(10) * 2.f,
+          b = arange<Float>(20) + 1.f,
+          c = arange<Float>(30) - 3.f,
+          d = arange<Float>(20) * 3.f;
+    jit_var_schedule(a.index());
+    jit_var_schedule(b.index());
+    jit_var_schedule(c.index());
+    jit_var_schedule(d.index());
+    jit_eval();
+
+    jit_assert(all(eq(a, arange<Float>(10) * 2.f)));
+    jit_assert(all(eq(b, arange<Float>(20) + 1.f)));
+    jit_assert(all(eq(c, arange<Float>(30) - 3.f)));
+    jit_assert(all(eq(d, arange<Float>(20) * 3.f)));
+
+    jit_set_flag(JitFlag::ParallelCompile, 0);
+}
+
+TEST_BOTH(09_parallel_streams) {
+    jit_set_flag(JitFlag::ParallelStreams, 1);
+
+    for (int i = 0; i < 2; ++i) {
+        Float a = arange<Float>(100) * 2.f,
+              b = arange<Float>(200) + 1.f,
+              c = arange<Float>(300) - 3.f,
+              d = arange<Float>(400) * 3.f,
+              e = arange<Float>(500) + 4.f;
+        jit_var_schedule(a.index());
+        jit_var_schedule(b.index());
+        jit_var_schedule(c.index());
+        jit_var_schedule(d.index());
+        jit_var_schedule(e.index());
+        jit_eval();
+
+        // Consume the results on the main stream
+        Float f = (a + 1.f) * 2.f;
+        jit_assert(all(eq(f, arange<Float>(100) * 4.f + 2.f)));
+        jit_assert(all(eq(b, arange<Float>(200) + 1.f)));
+        jit_assert(all(eq(c, arange<Float>(300) - 3.f)));
+        jit_assert(all(eq(d, arange<Float>(400) * 3.f)));
+        jit_assert(all(eq(e, arange<Float>(500) + 4.f)));
+    }
+
+    jit_set_flag(JitFlag::ParallelStreams, 0);
+}
+
+TEST_CUDA(10_graph_capture) {
+    for (int i = 0; i < 3; ++i) {
+        Float x = arange<Float>(1000) + Float((float) i);
+        x.eval();
+
+        jit_cuda_graph_begin();
+        Float y = x * 2.f + 1.f,
+              z = x - 1.f;
+        jit_var_schedule(y.index());
+        jit_var_schedule(z.index());
+        jit_eval();
+        int updated = jit_cuda_graph_end();
+
+        // The graph structure stays the same, only the parameters change
+        jit_assert(updated == (i > 0 ? 1 : 0));
+        jit_assert(all(eq(y, x * 2.f + 1.f)));
+        jit_assert(all(eq(z, x - 1.f)));
+    }
+}
+
+TEST_BOTH(11_freeze) {
+    Float x = arange<Float>(1000);
+    x.eval();
+
+    uint32_t in = x.index();
+    jit_freeze_begin(Backend, 1, &in);
+    Float y = x * 2.f + 1.f;
+    y.eval();
+    Float z = y + x;
+    uint32_t out[2] = { y.index(), z.index() };
+    void *f = jit_freeze_end(Backend, 2, out);
+
+    for (int i = 0; i < 3; ++i) {
+        Float x2 = arange<Float>(1000) + Float((float) i);
+        x2.eval();
+        in = x2.index();
+        jit_freeze_replay(f, &in, out);
+        Float y2 = Float::steal(out[0]), z2 = Float::steal(out[1]);
+        jit_assert(all(eq(y2, x2 * 2.f + 1.f)));
+        jit_assert(all(eq(z2, x2 * 3.f + 1.f)));
+    }
+
+    jit_freeze_destroy(f);
+}
+
+TEST_BOTH(12_kernel_hash_only) {
+    jit_set_flag(JitFlag::KernelHashOnly, 1);
+
+    for (int i = 0; i < 2; ++i) {
+        Float x = arange<Float>(100) * 2.f + 1.f;
+        x.eval();
+        jit_assert(all(eq(x, arange<Float>(100) * 2.f + 1.f)));
+    }
+
+    jit_set_flag(JitFlag::KernelHashOnly, 0);
+}
+
+TEST_BOTH(13_kernel_cache_prefetch) {
+    Float x = arange<Float>(100) * 5.f + 2.f;
+    x.eval();
+
+    jit_assert(jit_kernel_cache_manifest("drjit_manifest.txt") > 0);
+    jit_flush_kernel_cache();
+    jit_kernel_cache_prefetch("drjit_manifest.txt");
+
+    Float y = arange<Float>(100) * 5.f + 2.f;
+    jit_assert(all(eq(x, y)));
+    remove("drjit_manifest.txt");
+}
+
+TEST_BOTH(14_kernel_cache_limit) {
+    jit_flush_kernel_cache();
+    jit_set_kernel_cache_limits(0, 2, 0, 0);
+
+    size_t evictions_before = 0, evictions_after = 0;
+    jit_kernel_cache_stats(nullptr, nullptr, nullptr, &evictions_before);
+
+    for (int i = 0; i < 4; ++i) {
+        Float x = arange<Float>(10 + i) * (float) (i + 2);
+        x.eval();
+        jit_assert(x.read(1) == (float) (i + 2));
+    }
+
+    jit_kernel_cache_stats(nullptr, nullptr, nullptr, &evictions_after);
+    jit_assert(evictions_after > evictions_before);
+
+    jit_set_kernel_cache_limits(0, 0, 0, 0);
+}
+
+TEST_BOTH(15_kernel_cache_codec) {
+    jit_set_kernel_cache_codec(KernelCacheCodec::LZ4HC, 12);
+
+    for (int i = 0; i < 2; ++i) {
+        // The second iteration loads the kernel from the disk cache
+        jit_flush_kernel_cache();
+        Float x = arange<Float>(1000) * 3.f + 7.f;
+        jit_assert(x.read(999) == 3004.f);
+    }
+
+    jit_set_kernel_cache_codec(KernelCacheCodec::LZ4);
+}
+
+TEST_BOTH(16_malloc_size_class) {
+    AllocType type = Float::Backend == JitBackend::CUDA ? AllocType::Device
+                                                        : AllocType::HostAsync;
+
+    // Requests in the same size class share freed memory ..
+    void *p1 = jit_malloc(type, 40000000);
+    jit_free(p1);
+    void *p2 = jit_malloc(type, 41000000);
+    jit_assert(p1 == p2);
+
+    // .. which is rounded to eighths of the next power of two (2^26 here)
+    jit_assert(jit_malloc_grow(p2, 5 * (1 << 23)));
+    jit_assert(!jit_malloc_grow(p2, 5 * (1 << 23) + 1));
+    jit_free(p2);
+
+    // Larger sizes use the next class instead of the power of two itself
+    void *p3 = jit_malloc(type, 45000000);
+    jit_assert(jit_malloc_grow(p3, 6 * (1 << 23)));
+    jit_assert(!jit_malloc_grow(p3, 6 * (1 << 23) + 1));
+    jit_free(p3);
+}
+
+TEST_LLVM(17_malloc_thread_cache) {
+    // Small host allocations are recycled through a per-thread cache
+    void *ptrs[40];
+    for (int i = 0; i < 40; ++i)
+        ptrs[i] = jit_malloc(AllocType::Host, 1000);
+    for (int i = 0; i < 40; ++i)
+        jit_free(ptrs[i]);
+
+    void *p = jit_malloc(AllocType::Host, 1000);
+    jit_assert(p == ptrs[39]);
+    jit_free(p);
+
+    // Flushing the allocation cache also drains the per-thread caches
+    jit_flush_malloc_cache();
+    std::thread t([] {
+        void *q = jit_malloc(AllocType::Host, 1000);
+        jit_free(q);
+    });
+    t.join();
+    jit_flush_malloc_cache();
+}
+
+static size_t pressure_calls = 0, pressure_size = 0;
+
+TEST_LLVM(18_malloc_limit) {
+    jit_flush_malloc_cache();
+
+    // Large host allocations bypass the per-thread cache
+    void *a = jit_malloc(AllocType::Host, 1 << 20),
+         *b = jit_malloc(AllocType::Host, 2 << 20);
+    jit_free(b);
+
+    jit_malloc_set_pressure_callback(
+        [](AllocType type, size_t size, void *payload) {
+            jit_assert(type == AllocType::Host && payload == &pressure_calls);
+            pressure_calls++;
+            pressure_size = size;
+        }, &pressure_calls);
+    jit_malloc_set_limit(AllocType::Host, 2 << 20);
+
+    // Exceeding the limit releases 'b' and notifies the application
+    void *c = jit_malloc(AllocType::Host, 4 << 20);
+    jit_assert(pressure_calls == 1 && pressure_size == (4 << 20));
+
+    jit_malloc_set_limit(AllocType::Host, 0);
+    jit_malloc_set_pressure_callback(nullptr, nullptr);
+    jit_free(a);
+    jit_free(c);
+    jit_flush_malloc_cache();
+}
+
+TEST_BOTH(19_malloc_reserve) {
+    AllocType type = Backend == JitBackend::CUDA ? AllocType::Device
+                                                 : AllocType::HostAsync;
+
+    void *ptr = jit_malloc_reserve(type, 1024, 1 << 20);
+    jit_assert(jit_malloc_grow(ptr, 512));
+
+    if (!jit_malloc_grow(ptr, 4096)) {
+        // No support for virtual memory management, fell back to jit_malloc()
+        jit_free(ptr);
+        return;
+    }
+
+    // Data variables backed by a reservation can be enlarged in place
+    UInt32 x = UInt32::steal(
+        jit_var_mem_map(Backend, VarType::UInt32, ptr, 256, 1));
+    UInt32 y = UInt32::steal(jit_var_resize(x.index(), 1 << 18));
+    jit_assert(x.index() == y.index() && y.size() == (1 << 18));
+
+    // .. but not beyond the reserved capacity
+    jit_assert(!jit_malloc_grow(ptr, 64u << 20));
+}
+
+TEST_LLVM(20_numa_policy) {
+    // Results don't depend on how blocks are assigned to NUMA nodes
+    for (NumaPolicy policy : { NumaPolicy::Interleave, NumaPolicy::Local,
+                               NumaPolicy::Default }) {
+        jit_llvm_set_numa_policy(policy);
+        jit_assert(jit_llvm_numa_policy() == policy &&
+                   jit_llvm_numa_nodes() >= 1);
+
+        UInt32 x = arange<UInt32>(1000000);
+        UInt32 y = x * 2u + 1u;
+        jit_assert(all(eq(hsum(y), UInt32((uint32_t) 1000000000000ull))));
+    }
+}
+
+TEST_LLVM(21_huge_pages) {
+    jit_flush_malloc_cache();
+    jit_set_huge_page_policy(HugePagePolicy::Transparent, 4 << 20);
+
+    void *a = jit_malloc(AllocType::Host, 8 << 20);
+    memset(a, 1, 8 << 20);
+    jit_free(a);
+
+    // Huge page regions are reused for other large requests ..
+    void *b = jit_malloc(AllocType::Host, 8 << 20);
+    jit_assert(a == b);
+    jit_free(b);
+
+    // .. but kept separate from regular allocations of the same size
+    jit_set_huge_page_policy(HugePagePolicy::Disabled);
+    void *c = jit_malloc(AllocType::Host, 8 << 20);
+    jit_assert(c != a);
+    jit_free(c);
+
+#if defined(__linux__)
+    jit_set_huge_page_policy(HugePagePolicy::Explicit, 2 << 20);
+#else
+    jit_set_huge_page_policy(HugePagePolicy::Disabled, 2 << 20);
+#endif
+    jit_flush_malloc_cache();
+}
+
+TEST_CUDA(22_migrate_pipelined) {
+    // Large host->device migrations stream through several staging buffers
+    size_t count = 10 << 20;
+    uint32_t *a = (uint32_t *) jit_malloc(AllocType::Host, count * 4);
+    for (size_t i = 0; i < count; ++i)
+        a[i] = (uint32_t) i;
+
+    void *b = jit_malloc_migrate(a, AllocType::Device, 1);
+    uint32_t *c = (uint32_t *) jit_malloc_migrate(b, AllocType::Host, 1);
+    jit_sync_thread();
+
+    for (size_t i = 0; i < count; ++i)
+        jit_assert(c[i] == (uint32_t) i);
+    jit_free(c);
+}
+
+TEST_BOTH(23_malloc_profile) {
+    jit_malloc_clear_statistics();
+    jit_set_flag(JitFlag::MallocProfile, 1);
+
+    UInt32 x = arange<UInt32>(100000) * 3u;
+    set_label(x, "profiled_array");
+    jit_var_eval(x.index());
+
+    UInt32 y = arange<UInt32>(1000) + 1u;
+    jit_var_eval(y.index());
+    y = UInt32();
+
+    // The peak snapshot attributes memory to the label of its producer
+    const char *report = jit_malloc_profile();
+    jit_assert(strstr(report, "profiled_array") != nullptr);
+    jit_assert(strstr(report, "Lifetime") != nullptr);
+
+    jit_set_flag(JitFlag::MallocProfile, 0);
+}
+
+TEST_CUDA(24_managed_memory) {
+    jit_set_flag(JitFlag::ManagedMemory, 1);
+    UInt32 x = arange<UInt32>(1000) * 2u;
+    jit_var_eval(x.index());
+    jit_assert(jit_var_alloc_type(x.index()) == AllocType::Managed);
+
+    // Kernels reading managed memory prefetch it to the device
+    UInt32 y = x + 1u;
+    jit_var_eval(y.index());
+    jit_set_flag(JitFlag::ManagedMemory, 0);
+
+    // The host can access managed memory directly once the GPU is idle
+    jit_malloc_prefetch((void *) jit_var_ptr(y.index()), -1);
+    jit_sync_thread();
+    const uint32_t *p = (const uint32_t *) jit_var_ptr(y.index());
+    for (uint32_t i = 0; i < 1000; ++i)
+        jit_assert(p[i] == 2 * i + 1);
+}
+
+TEST_BOTH(25_var_index_reuse) {
+    // The index of a freed variable is recycled by the next new variable
+    uint32_t index;
+    {
+        UInt32 x = UInt32::counter(10);
+        index = x.index();
+    }
+    jit_assert(!jit_var_exists(index));
+
+    UInt32 y = UInt32::counter(20);
+    jit_assert(y.index() == index);
+    jit_assert(y.read(13) == 13);
+
+    // Scheduled variables that expire before evaluation are skipped
+    UInt32 z = arange<UInt32>(10) + 5u;
+    jit_var_schedule(z.index());
+    z = UInt32();
+    UInt32 w = arange<UInt32>(20) + 7u;
+    jit_eval();
+    jit_assert(w.read(19) == 26);
+}
+
+TEST_BOTH(26_deep_chain) {
+    // Long dependency chains are traversed without recursion
+    UInt32 c = arange<UInt32>(1);
+    for (uint32_t i = 0; i < 20000; ++i)
+        c = c + 1u;
+
+    // 'c' is shared by two outputs of different size
+    UInt32 x = arange<UInt32>(16) + c,
+           y = arange<UInt32>(5) + c;
+    jit_var_schedule(x.index());
+    jit_var_schedule(y.index());
+    jit_eval();
+
+    jit_assert(x.read(3) == 20003);
+    jit_assert(y.read(4) == 20004);
+}
+
+TEST_BOTH(27_kernel_optimize) {
+    jit_set_flag(JitFlag::KernelOptimize, 1);
+
+    // The same expression in two scopes is only computed once
+    UInt32 a = arange<UInt32>(10);
+    UInt32 b = a * 3u + 1u;
+    jit_new_scope(Backend);
+    UInt32 c = a * 3u + 1u;
+
+    // .. which in turn lets the 'select' collapse to one of its operands
+    UInt32 d = select(eq(a & UInt32(1), UInt32(0)), b, c) + c;
+
+    jit_assert(d.read(2) == 14);
+    jit_assert(b.read(3) == 10);
+
+    jit_set_flag(JitFlag::KernelOptimize, 0);
+}
+
+TEST_BOTH(28_kernel_fusion) {
+    jit_set_flag(JitFlag::KernelFusion, 1);
+
+    UInt32 s = arange<UInt32>(1) + 5u;
+    s.eval();
+
+    // The scalar 's2' is computed and written by the kernel of size 100
+    UInt32 s2 = s * 3u,
+           x = arange<UInt32>(100) + s2;
+    jit_var_schedule(s2.index());
+    jit_var_schedule(x.index());
+    jit_eval();
+
+    jit_assert(s2.size() == 1 && s2.read(0) == 15);
+    jit_assert(x.read(2) == 17);
+
+    jit_set_flag(JitFlag::KernelFusion, 0);
+}
+
+TEST_BOTH(29_half_precision) {
+    /// Half precision arithmetic, both evaluated and constant-folded
+    uint16_t one_half = 0x3E00; // 1.5
+    uint32_t c = jit_var_literal(Backend, VarType::Float16, &one_half, 4);
+
+    Float x = arange<Float>(4) * 0.5f;
+    uint32_t xh = jit_var_cast(x.index(), VarType::Float16, 0);
+    uint32_t yh = jit_var_fma(xh, c, c);
+    uint32_t ch = jit_var_mul(c, c);
+    Float y = Float::steal(jit_var_cast(yh, VarType::Float32, 0)),
+          z = Float::steal(jit_var_cast(ch, VarType::Float32, 0));
+    jit_var_dec_ref(xh);
+    jit_var_dec_ref(yh);
+    jit_var_dec_ref(ch);
+    jit_var_dec_ref(c);
+
+    jit_assert(strcmp(y.str(), "[1.5, 2.25, 3, 3.75]") == 0);
+    jit_assert(jit_var_is_literal(z.index()) && z.read(0) == 2.25f);
+}
+
+TEST_BOTH(30_lazy_broadcast) {
+    /// Broadcasting an evaluated scalar is symbolic and lazily merged
+    UInt32 a = arange<UInt32>(1) + 3u;
+    a.eval();
+
+    UInt32 b = UInt32::steal(jit_var_resize(a.index(), 10)),
+           c = UInt32::steal(jit_var_resize(a.index(), 10));
+    jit_assert(b.index() == c.index() && !jit_var_is_evaluated(b.index()));
+
+    UInt32 d = b + arange<UInt32>(10);
+    jit_assert(d.read(9) == 12 && !jit_var_is_evaluated(b.index()));
+}
+
+TEST_BOTH(31_buffer_reuse) {
+    /// An iterative update can store its result in the memory of its input
+    jit_set_flag(JitFlag::BufferReuse, 1);
+
+    UInt32 x = arange<UInt32>(1000);
+    x.eval();
+    void *ptr = jit_var_ptr(x.index());
+
+    x = x * 2u + 1u;
+    x.eval();
+    jit_assert(jit_var_ptr(x.index()) == ptr);
+    jit_assert(x.read(0) == 1 && x.read(999) == 1999);
+
+    // Not possible while another reference to the input exists
+    UInt32 y = x + 1u;
+    y.eval();
+    jit_assert(jit_var_ptr(y.index()) != ptr);
+    jit_assert(x.read(999) == 1999 && y.read(999) == 2000);
+
+    jit_set_flag(JitFlag::BufferReuse, 0);
+}
+
+TEST_LLVM(32_tiered_compile) {
+    /// Hot kernels are optimized in the background, results must not change
+    jit_set_flag(JitFlag::TieredCompile, 1);
+
+    Float x = arange<Float>(1000);
+    x.eval();
+
+    for (int i = 0; i < 300; ++i) {
+        Float y = x * 2.f + 1.f;
+        y.eval();
+        jit_assert(y.read(999) == 1999.f);
+    }
+
+    // Waits for pending recompilations
+    jit_flush_kernel_cache();
+    jit_set_flag(JitFlag::TieredCompile, 0);
+}
+
+TEST_BOTH(33_kernel_cache_uncompressed) {
+    jit_set_kernel_cache_codec(KernelCacheCodec::None);
+
+    for (int i = 0; i < 2; ++i) {
+        // The second iteration maps the LLVM kernel from the disk cache
+        jit_flush_kernel_cache();
+        Float x = arange<Float>(1000) * 5.f + 3.f;
+        jit_assert(x.read(999) == 4998.f);
+    }
+
+    jit_set_kernel_cache_codec(KernelCacheCodec::LZ4);
+}
+
+TEST_LLVM(34_kernel_cache_target_versions) {
+    // Kernels written to the cache are also compiled for a generic CPU
+    jit_llvm_add_target_version("generic", nullptr);
+
+    for (int i = 0; i < 2; ++i) {
+        jit_flush_kernel_cache();
+        Float x = arange<Float>(1000) * 7.f + 2.f;
+        jit_assert(x.read(999) == 6995.f);
+    }
+
+    jit_llvm_add_target_version(nullptr, nullptr);
+}
+
+TEST_BOTH(35_reduce_fused) {
+    // On the LLVM backend, these reductions don't write their inputs to memory
+    jit_set_flag(JitFlag::KernelFusion, 1);
+
+    for (uint32_t size : { 1000u, 100000u }) {
+        UInt32 x = arange<UInt32>(size);
+        jit_assert(hsum(x * 2u + 1u).read(0) == size * size);
+        jit_assert(hmin(Int32(x) - 500).read(0) == -500);
+        jit_assert(hmax(x + 3u).read(0) == size + 2);
+        jit_assert(hsum(Float(x) * 0.f + 1.f).read(0) == (float) size);
+    }
+
+    jit_set_flag(JitFlag::KernelFusion, 0);
+}
+
+TEST_LLVM(36_launch_inline) {
+    // Tiny kernels run on the calling thread, larger ones use the thread pool
+    jit_set_flag(JitFlag::LaunchInline, 1);
+
+    for (uint32_t size : { 1u, 100u, 10000u }) {
+        UInt32 x = arange<UInt32>(size);
+        x.eval();
+        UInt32 y = x * 3u + 1u;
+        y.eval();
+        jit_assert(y.read(size - 1) == (size - 1) * 3u + 1u);
+        jit_assert(hsum(y).read(0) == size * (3u * size - 1u) / 2u);
+    }
+
+    jit_set_flag(JitFlag::LaunchInline, 0);
+}
+
+TEST_CUDA(37_launch_autotune) {
+    // Every launch configuration must produce the same result
+    jit_set_flag(JitFlag::LaunchAutotune, 1);
+
+    Float x = arange<Float>(1u << 22);
+    x.eval();
+
+    for (int i = 0; i < 20; ++i) {
+        Float y = x * 2.f + 1.f;
+        y.eval();
+        jit_assert(y.read(0) == 1.f && y.read(1000) == 2001.f);
+    }
+
+    jit_set_flag(JitFlag::LaunchAutotune, 0);
+}
+
+TEST_BOTH(38_var_batch_access) {
+    UInt32 x = arange<UInt32>(100);
+    Float y = arange<Float>(50) * 2.f, z(5.f);
+
+    // Mix of an evaluated array, an unevaluated one, and a literal
+    x.eval();
+    uint32_t indices[] = { x.index(), y.index(), x.index(), z.index() };
+    size_t offsets[] = { 7, 10, 99, 0 };
+    uint32_t r0 = 0, r2 = 0;
+    float r1 = 0.f, r3 = 0.f;
+    void *dst[] = { &r0, &r1, &r2, &r3 };
+
+    jit_var_read_batch(4, indices, offsets, dst);
+    jit_assert(r0 == 7 && r1 == 20.f && r2 == 99 && r3 == 5.f);
+
+    // Two writes into 'x' share a single copy of the array
+    UInt32 x_ref = x;
+    uint32_t v0 = 1234, v2 = 5678;
+    float v1 = -1.f;
+    const void *src[] = { &v0, &v1, &v2 };
+    uint32_t indices_out[3];
+    jit_var_write_batch(3, indices, offsets, src, indices_out);
+
+    UInt32 x2 = UInt32::steal(indices_out[0]), x3 = UInt32::steal(indices_out[2]);
+    Float y2 = Float::steal(indices_out[1]);
+    jit_assert(x2.index() == x3.index());
+    jit_assert(x2.read(7) == 1234 && x2.read(99) == 5678 && x2.read(8) == 8);
+    jit_assert(y2.read(10) == -1.f && y2.read(11) == 22.f);
+    jit_assert(x_ref.read(7) == 7);
+}
+
+TEST_CUDA(39_var_shard) {
+    // Shards on all devices (several per device when there are few of them)
+    int count = jit_cuda_device_count(), devices[4];
+    for (int i = 0; i < 4; ++i)
+        devices[i] = i % count;
+
+    UInt32 x = arange<UInt32>(1001);
+    uint32_t shards[4], results[4];
+    jit_var_shard(x.index(), 4, devices, shards);
+
+    UInt32 r[4];
+    for (int i = 0; i < 4; ++i) {
+        r[i] = UInt32::steal(shards[i]) * 2u;
+        results[i] = r[i].index();
+    }
+
+    UInt32 y = UInt32::steal(jit_var_unshard(4, results, devices));
+    jit_assert(y.size() == 1001 && y.read(0) == 0 && y.read(1000) == 2000 &&
+               y.read(251) == 502);
+
+    UInt32 sum = UInt32::steal(
+        jit_var_reduce_shards(ReduceOp::Add, 4, results, devices));
+    jit_assert(sum.read(0) == 1001000);
+}
+
+TEST_BOTH(40_literal_params) {
+    // Changing literals are passed as kernel parameters after the second kernel
+    jit_set_flag(JitFlag::LiteralParams, 1);
+
+    Float x = arange<Float>(100);
+    UInt32 y = arange<UInt32>(100);
+    x.eval();
+    y.eval();
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        Float z = x * Float((float) i) + 0.5f;
+        UInt32 w = y + UInt32(i * 10u);
+        jit_eval();
+        jit_assert(z.read(3) == 3.f * (float) i + 0.5f);
+        jit_assert(w.read(99) == 99u + i * 10u);
+    }
+
+    jit_set_flag(JitFlag::LiteralParams, 0);
+}
+
+TEST_BOTH(41_kernel_stats) {
+    // Launches of the same kernel are aggregated into a single record
+    Float x = arange<Float>(1000);
+    x.eval();
+
+    jit_kernel_stats_clear();
+    jit_set_flag(JitFlag::KernelStats, 1);
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        Float y = x * 2.f + 1.f;
+        y.eval();
+        jit_assert(y.read(10) == 21.f);
+    }
+
+    jit_set_flag(JitFlag::KernelStats, 0);
+
+    const char *report = jit_kernel_stats();
+    jit_assert(strstr(report, "Kernels: 1, launches: 3") != nullptr);
+
+    const char *trace = jit_kernel_stats_trace();
+    jit_assert(strstr(trace, "\"traceEvents\"") != nullptr);
+    jit_assert(strstr(trace, "\"cat\": \"kernel\"") != nullptr);
+
+    jit_kernel_stats_clear();
+}
+
+TEST_BOTH(42_stats) {
+    JitStats s0, s1;
+    jit_stats(&s0);
+
+    Float x = arange<Float>(100);
+    Float y = x + 1.f, z = x + 1.f;
+    jit_assert(y.index() == z.index());
+    jit_assert(y.read(5) == 6.f);
+
+    jit_stats(&s1);
+    jit_assert(s1.variables_created > s0.variables_created);
+    jit_assert(s1.lvn_hits > s0.lvn_hits);
+    jit_assert(s1.evals == s0.evals + 1);
+    jit_assert(s1.implicit_evals == s0.implicit_evals + 1);
+    jit_assert(s1.implicit_syncs > s0.implicit_syncs);
+    jit_assert(s1.alloc_reused + s1.alloc_fresh >
+               s0.alloc_reused + s0.alloc_fresh);
+}
+
+TEST_BOTH(43_sync_profile) {
+    jit_sync_profile_clear();
+    jit_set_sync_profile(1);
+
+    Float x = arange<Float>(100) * 2.f;
+    set_label(x, "sync_source");
+    for (int i = 0; i < 3; ++i)
+        jit_assert(x.read(2) == 4.f);
+
+    jit_set_sync_profile(0);
+
+    const char *report = jit_sync_profile();
+    jit_assert(strstr(report, "jit_var_read") != nullptr);
+    jit_assert(strstr(report, "\"sync_source\"") != nullptr);
+
+    jit_sync_profile_clear();
+}
+
+TEST_BOTH(44_rvalue_ops) {
+    Float x = arange<Float>(10);
+    Float y = x * 2.f;
+    uint32_t ref_x = jit_var_ref(x.index()),
+             ref_y = jit_var_ref(y.index());
+
+    // Temporaries hand over their references, named operands keep theirs
+    Float t = x + y;
+    uint32_t t_index = t.index();
+    Float z = std::move(t) * (y - x) + x;
+    jit_assert(t.index() == 0);
+    jit_assert(jit_var_ref(t_index) == 1); // Only referenced by the product
+    jit_assert(jit_var_ref(x.index()) == ref_x + 3);
+    jit_assert(jit_var_ref(y.index()) == ref_y + 2);
+
+    // Compound assignment replaces the variable without keeping it alive
+    Float w = x * y;
+    uint32_t w_index = w.index();
+    w *= 2.f;
+    jit_assert(w.index() != w_index && jit_var_ref(w_index) == 1);
+
+    UInt32 u = arange<UInt32>(10);
+    Mask m = (u < 5u) | (u > 7u);
+
+    jit_assert(strcmp(z.str(), "[0, 4, 14, 30, 52, 80, 114, 154, 200, 252]") == 0);
+    jit_assert(strcmp(w.str(), "[0, 4, 16, 36, 64, 100, 144, 196, 256, 324]") == 0);
+    jit_assert(strcmp(m.str(), "[1, 1, 1, 1, 1, 0, 0, 0, 1, 1]") == 0);
+}
+
+TEST_BOTH(45_op_batch) {
+    Float x = arange<Float>(5), y = Float(2.f);
+
+    // Compute (x + y) * x - y
+    JitBatchOp ops[3] = {
+        { JitOp::Add, { x.index(), y.index(), 0 } },
+        { JitOp::Mul, { JIT_BATCH_RESULT(0), x.index(), 0 } },
+        { JitOp::Sub, { JIT_BATCH_RESULT(1), y.index(), 0 } }
+    };
+
+    uint32_t out[3];
+    jit_var_op_batch(3, ops, out);
+    Float r = Float::steal(out[2]);
+    jit_var_dec_ref(out[0]);
+    jit_var_dec_ref(out[1]);
+    jit_assert(strcmp(r.str(), "[-2, 1, 6, 13, 22]") == 0);
+
+    // Operands may only refer to earlier operations
+    ops[1].dep[0] = JIT_BATCH_RESULT(2);
+    bool failed = false;
+    try {
+        jit_var_op_batch(3, ops, out);
+    } catch (const std::exception &) {
+        failed = true;
+    }
+    jit_assert(failed);
+}
+
+TEST_BOTH(46_dlpack) {
+    Float x = arange<Float>(5) + 1.f;
+
+    // Round trip: the imported variable shares the memory of 'x'
+    DLManagedTensor *tensor = jit_var_dlpack_export(x.index(), nullptr);
+    jit_assert(jit_var_ref(x.index()) == 2);
+
+    /* Release the tensor with the imported variable */ {
+        Float y = Float::steal(jit_var_dlpack_import(tensor, nullptr));
+        jit_assert(jit_var_ptr(y.index()) == jit_var_ptr(x.index()));
+        jit_assert(strcmp(y.str(), "[1, 2, 3, 4, 5]") == 0);
+    }
+
+    jit_assert(jit_var_ref(x.index()) == 1);
+}
+
+TEST_BOTH(47_eval_memory_warning) {
+    jit_set_eval_memory_warning(256);
+    jit_assert(jit_eval_memory_warning() == 256);
+
+    // Reduce without evaluating the (larger) input array
+    UInt32 x = arange<UInt32>(10000);
+    jit_assert(hsum(x * 2u + 1u).read(0) == 10000u * 10000u);
+    jit_assert(hmax(x + 5u).read(0) == 10004u);
+
+    jit_set_eval_memory_warning(0);
+}
+
+TEST_BOTH(48_kernel_cache_threads) {
+    // Threads read and write the disk cache while others change its settings
+    jit_flush_kernel_cache();
+    std::thread threads[4];
+    for (uint32_t t = 0; t < 4; ++t) {
+        threads[t] = std::thread([t] {
+            for (uint32_t i = 0; i < 10; ++i) {
+                uint32_t k = 1000 + t * 10 + i;
+                UInt32 x = arange<UInt32>(100) * k + 1u;
+                jit_assert(x.read(99) == 99u * k + 1u);
+            }
+        });
+    }
+    for (uint32_t i = 0; i < 10; ++i)
+        jit_set_kernel_cache_codec(i % 2 ? KernelCacheCodec::LZ4HC
+                                         : KernelCacheCodec::LZ4);
+    for (std::thread &t : threads)
+        t.join();
+    jit_set_kernel_cache_codec(KernelCacheCodec::LZ4);
+}
+
+TEST_LLVM(49_large_arrays) {
+    // LLVM arrays may hold more than 2^32-1 entries
+    size_t size = ((size_t) 1 << 32) + 5;
+    uint32_t one = 1;
+    UInt32 x = UInt32::steal(jit_var_literal(Backend, VarType::UInt32, &one, size));
+    jit_assert(jit_var_size(x.index()) == size);
+
+    // Their counters need 64-bit indices
+    Array<uint64_t> index = Array<uint64_t>::steal(jit_var_counter(Backend, size));
+    jit_assert(jit_var_type(index.index()) == VarType::UInt64);
+
+    // A fused reduction never materializes the input
+    jit_set_flag(JitFlag::KernelFusion, 1);
+    Array<uint64_t> sum = Array<uint64_t>::steal(
+        jit_var_reduce(index.index(), ReduceOp::Add));
+    jit_set_flag(JitFlag::KernelFusion, 0);
+    jit_assert(sum.read(0) == (uint64_t) size * ((size - 1) / 2));
+}
+
 #if 0
 template <JitBackend Backend, typename... Ts>
 void printf_async(const JitArray<Backend, bool> &mask, const char *fmt,
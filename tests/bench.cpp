@@ -0,0 +1,386 @@
+/*
+    tests/bench.cpp -- Microbenchmarks of the CUDA and LLVM backends
+
+    Usage: drjit-core-bench [-c] [-l] [-r <repeats>] [-j <output.json>] [filter]
+
+    Runs every benchmark on the available backends (or only on CUDA/LLVM when
+    '-c'/'-l' is specified), optionally restricted to names containing
+    'filter'. Each measurement is repeated several times (10 by default), and
+    the median and minimum run time are reported. The '-j' option furthermore
+    writes all results to a JSON file, which makes it possible to compare the
+    performance of two releases.
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <drjit-core/array.h>
+#include <drjit-core/containers.h>
+#include <drjit-core/state.h>
+#include "traits.h"
+#include "ekloop.h"
+
+using namespace drjit;
+
+/// Result of a single benchmark on one backend
+struct BenchResult {
+    std::string name;
+    JitBackend backend;
+    size_t size;
+    double median_ms, min_ms;
+
+    /// Amount of work per run, and its unit (e.g. bytes or kernel launches)
+    double work;
+    const char *unit;
+};
+
+static std::vector<BenchResult> bench_results;
+static uint32_t bench_repeats = 10;
+
+/// Passed to every benchmark, times the body of a measurement
+template <JitBackend Backend> struct Bench {
+    const char *name;
+
+    /**
+     * Run 'func' once to warm up caches (which includes compiling kernels),
+     * and then time 'bench_repeats' further runs. 'work' specifies the amount
+     * of work done by each run (in units of 'unit') to compute a throughput.
+     */
+    template <typename Func>
+    void run(size_t size, double work, const char *unit, Func &&func) {
+        func();
+        jit_sync_thread();
+
+        std::vector<double> times;
+        for (uint32_t i = 0; i < bench_repeats; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            jit_sync_thread();
+            auto end = std::chrono::steady_clock::now();
+            times.push_back(
+                std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        BenchResult r { name, Backend, size, times[times.size() / 2],
+                        times[0], work, unit };
+
+        double rate = r.work / (r.median_ms * 1e-3);
+        const char *prefix = "";
+        if (rate > 1e9) {
+            rate *= 1e-9; prefix = "G";
+        } else if (rate > 1e6) {
+            rate *= 1e-6; prefix = "M";
+        } else if (rate > 1e3) {
+            rate *= 1e-3; prefix = "K";
+        }
+
+        printf(" - %-28s %-5s n=%-9zu %10.3f ms (min %.3f ms), %8.2f %s%s/s\n",
+               name, Backend == JitBackend::CUDA ? "cuda" : "llvm", size,
+               r.median_ms, r.min_ms, rate, prefix, unit);
+        fflush(stdout);
+        bench_results.push_back(r);
+    }
+};
+
+struct BenchEntry {
+    const char *name;
+    void (*cuda)(const char *);
+    void (*llvm)(const char *);
+};
+
+static std::vector<BenchEntry> *benchmarks = nullptr;
+
+static int bench_register(const char *name, void (*cuda)(const char *),
+                          void (*llvm)(const char *)) {
+    if (!benchmarks)
+        benchmarks = new std::vector<BenchEntry>();
+    benchmarks->push_back({ name, cuda, llvm });
+    return 0;
+}
+
+#define BENCH(name)                                                            \
+    template <JitBackend Backend> void bench_##name(Bench<Backend> &b);       \
+    template <JitBackend Backend> void bench_##name##_run(const char *n) {    \
+        Bench<Backend> b { n };                                                \
+        bench_##name<Backend>(b);                                              \
+    }                                                                          \
+    static int bench_##name##_r =                                              \
+        bench_register(#name, bench_##name##_run<JitBackend::CUDA>,            \
+                       bench_##name##_run<JitBackend::LLVM>);                  \
+    template <JitBackend Backend> void bench_##name(Bench<Backend> &b)
+
+template <JitBackend Backend> using Float  = JitArray<Backend, float>;
+template <JitBackend Backend> using UInt32 = JitArray<Backend, uint32_t>;
+template <JitBackend Backend> using Mask   = JitArray<Backend, bool>;
+
+/// Large arrays are smaller on the LLVM backend to keep run times reasonable
+template <JitBackend Backend> static size_t bench_size() {
+    return Backend == JitBackend::CUDA ? (1u << 26) : (1u << 23);
+}
+
+template <JitBackend Backend> static AllocType bench_alloc_type() {
+    return Backend == JitBackend::CUDA ? AllocType::Device : AllocType::Host;
+}
+
+// Tracing throughput: nodes created per second (the result is never evaluated)
+BENCH(trace) {
+    const uint32_t n = 100000;
+    b.run(n, 2.0 * n, "nodes", [&] {
+        Float<Backend> x = arange<Float<Backend>>(16), y = x;
+        for (uint32_t i = 0; i < n; ++i)
+            y = y * 1.0001f + x;
+    });
+}
+
+// Overhead of jit_eval() when the kernel is found in the in-memory cache
+BENCH(eval_cache_hit) {
+    const uint32_t n = 1000;
+    Float<Backend> x = arange<Float<Backend>>(1024);
+    x.eval();
+
+    b.run(1024, n, "launches", [&] {
+        for (uint32_t i = 0; i < n; ++i) {
+            Float<Backend> y = x * 2.f + 1.f;
+            y.eval();
+        }
+    });
+}
+
+// Allocation churn through the memory cache
+BENCH(malloc) {
+    const uint32_t n = 10000;
+    void *ptrs[16];
+
+    b.run(n, n, "allocs", [&] {
+        for (uint32_t i = 0; i < n; i += 16) {
+            for (uint32_t j = 0; j < 16; ++j)
+                ptrs[j] = jit_malloc(bench_alloc_type<Backend>(),
+                                     (size_t) (j + 1) * 4096);
+            for (uint32_t j = 0; j < 16; ++j)
+                jit_free(ptrs[j]);
+        }
+    });
+}
+
+BENCH(reduce) {
+    size_t size = bench_size<Backend>();
+    Float<Backend> x = arange<Float<Backend>>(size);
+    x.eval();
+    void *out = jit_malloc(bench_alloc_type<Backend>(), sizeof(float));
+
+    b.run(size, (double) size * sizeof(float), "B", [&] {
+        jit_reduce(Backend, VarType::Float32, ReduceOp::Add, x.data(), size,
+                   out);
+    });
+
+    jit_free(out);
+}
+
+BENCH(prefix_sum) {
+    size_t size = bench_size<Backend>();
+    UInt32<Backend> x = arange<UInt32<Backend>>(size), y = empty<UInt32<Backend>>(size);
+    x.eval();
+    y.eval();
+
+    b.run(size, 2.0 * size * sizeof(uint32_t), "B", [&] {
+        jit_prefix_sum(Backend, VarType::UInt32, 1, x.data(), size, y.data());
+    });
+}
+
+BENCH(compress) {
+    size_t size = bench_size<Backend>();
+    Mask<Backend> m = eq(arange<UInt32<Backend>>(size) % 2u, 0u);
+    UInt32<Backend> out = empty<UInt32<Backend>>(size);
+    m.eval();
+    out.eval();
+
+    b.run(size, (double) size * (1 + sizeof(uint32_t) / 2.0), "B", [&] {
+        jit_compress(Backend, (const uint8_t *) m.data(), (uint32_t) size,
+                     out.data());
+    });
+}
+
+BENCH(mkperm) {
+    size_t size = bench_size<Backend>();
+    UInt32<Backend> x = arange<UInt32<Backend>>(size) % 256u,
+                    perm = empty<UInt32<Backend>>(size);
+    x.eval();
+    perm.eval();
+
+    b.run(size, 2.0 * size * sizeof(uint32_t), "B", [&] {
+        jit_mkperm(Backend, x.data(), (uint32_t) size, 256, perm.data(),
+                   nullptr);
+    });
+}
+
+struct BenchBase {
+    float scale;
+};
+
+/// Record a call 'self->scale * x + 1' over 'n_inst' instances
+template <JitBackend Backend>
+Float<Backend> bench_vcall(const JitArray<Backend, BenchBase *> &self,
+                           const Float<Backend> &x, uint32_t n_inst) {
+    dr_index_vector indices_out_all;
+    dr_vector<uint32_t> state(n_inst + 1, 0), inst_id(n_inst, 0);
+    Float<Backend> x_wrap = Float<Backend>::steal(jit_var_wrap_vcall(x.index()));
+    uint32_t indices_in[] = { x_wrap.index() }, index_out = 0;
+
+    jit_new_scope(Backend);
+    detail::JitState<Backend> jit_state;
+    jit_state.begin_recording();
+    state[0] = jit_record_checkpoint(Backend);
+
+    for (uint32_t i = 1; i <= n_inst; ++i) {
+        BenchBase *base = (BenchBase *) jit_registry_get_ptr(Backend, "BenchBase", i);
+        jit_state.set_self(i);
+
+        if (Backend == JitBackend::LLVM) {
+            Mask<Backend> vcall_mask = Mask<Backend>::steal(jit_var_vcall_mask(Backend));
+            jit_state.set_mask(vcall_mask.index());
+        }
+
+        Float<Backend> y = x_wrap * base->scale + 1.f;
+        indices_out_all.push_back(y.index());
+        state[i] = jit_record_checkpoint(Backend);
+
+        if (Backend == JitBackend::LLVM)
+            jit_state.clear_mask();
+        inst_id[i - 1] = i;
+    }
+
+    Mask<Backend> mask(true);
+    uint32_t se = jit_var_vcall("BenchBase", self.index(), mask.index(), n_inst,
+                                inst_id.data(), 1, indices_in,
+                                (uint32_t) indices_out_all.size(),
+                                indices_out_all.data(), state.data(), &index_out);
+
+    jit_state.end_recording();
+    jit_var_mark_side_effect(se);
+    jit_new_scope(Backend);
+
+    return Float<Backend>::steal(index_out);
+}
+
+// Virtual function call dispatch, including the call kernel launch
+BENCH(vcall) {
+    const uint32_t n_inst = 8;
+    size_t size = bench_size<Backend>() / 8;
+
+    BenchBase inst[n_inst];
+    for (uint32_t i = 0; i < n_inst; ++i) {
+        inst[i].scale = (float) i;
+        jit_registry_put(Backend, "BenchBase", &inst[i]);
+    }
+
+    JitArray<Backend, BenchBase *> self =
+        (arange<UInt32<Backend>>(size) % n_inst) + 1u;
+    Float<Backend> x = arange<Float<Backend>>(size);
+    self.eval();
+    x.eval();
+
+    b.run(size, (double) size, "calls", [&] {
+        bench_vcall(self, x, n_inst).eval();
+    });
+
+    for (uint32_t i = 0; i < n_inst; ++i)
+        jit_registry_remove(Backend, &inst[i]);
+}
+
+// Recorded loop with 64 iterations per entry
+BENCH(loop) {
+    size_t size = bench_size<Backend>() / 8;
+    Float<Backend> x = arange<Float<Backend>>(size);
+    x.eval();
+
+    b.run(size, 64.0 * size, "iterations", [&] {
+        UInt32<Backend> i = zeros<UInt32<Backend>>(size);
+        Float<Backend> y = x;
+
+        Loop<Mask<Backend>> loop("bench", i, y);
+        while (loop(i < 64u)) {
+            y = y * 0.5f + 1.f;
+            i += 1u;
+        }
+
+        y.eval();
+    });
+}
+
+static void bench_write_json(const char *filename) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Could not create \"%s\"!\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(f, "{\n  \"repeats\": %u,\n  \"benchmarks\": [\n", bench_repeats);
+    for (size_t i = 0; i < bench_results.size(); ++i) {
+        const BenchResult &r = bench_results[i];
+        fprintf(f,
+                "    { \"name\": \"%s\", \"backend\": \"%s\", \"size\": %zu, "
+                "\"median_ms\": %.6f, \"min_ms\": %.6f, \"throughput\": %.6e, "
+                "\"unit\": \"%s/s\" }%s\n",
+                r.name.c_str(),
+                r.backend == JitBackend::CUDA ? "cuda" : "llvm", r.size,
+                r.median_ms, r.min_ms, r.work / (r.median_ms * 1e-3), r.unit,
+                i + 1 < bench_results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int main(int argc, char **argv) {
+    bool bench_cuda = true, bench_llvm = true;
+    const char *json = nullptr, *filter = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-c") == 0) {
+            bench_llvm = false;
+        } else if (strcmp(argv[i], "-l") == 0) {
+            bench_cuda = false;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            bench_repeats = (uint32_t) std::max(atoi(argv[++i]), 1);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else if (argv[i][0] != '-') {
+            filter = argv[i];
+        } else {
+            fprintf(stderr,
+                    "Syntax: %s [-c] [-l] [-r <repeats>] [-j <output.json>] "
+                    "[filter]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    jit_set_log_level_stderr(LogLevel::Warn);
+    jit_init((bench_llvm ? (uint32_t) JitBackend::LLVM : 0) |
+             (bench_cuda ? (uint32_t) JitBackend::CUDA : 0));
+
+    bench_cuda &= (bool) jit_has_backend(JitBackend::CUDA);
+    bench_llvm &= (bool) jit_has_backend(JitBackend::LLVM);
+
+    for (const BenchEntry &e : *benchmarks) {
+        if (filter && !strstr(e.name, filter))
+            continue;
+        if (bench_cuda)
+            e.cuda(e.name);
+        if (bench_llvm)
+            e.llvm(e.name);
+    }
+
+    if (json)
+        bench_write_json(json);
+
+    jit_shutdown();
+    return 0;
+}
@@ -37,6 +37,7 @@ struct Loop<Value, enable_if_t<std::is_scalar_v<Value>>> {
     Loop& operator=(Loop &&) = delete;
 
     void init() { }
+    void set_unroll(uint32_t) { }
     template <typename... Ts> void put(Ts&...) { }
     bool operator()(bool mask) { return mask; }
     template <typename... Args> Loop(const char*, Args&...) { }
@@ -139,6 +140,9 @@ struct Loop<Value, enable_if_jit_array_t<Value>> {
 
     void put() { }
 
+    /// Request that a recorded loop runs 'factor' iterations per back-edge
+    void set_unroll(uint32_t factor) { m_unroll = factor; }
+
     /// Configure the loop variables for recording
     void init() {
         if (!m_record)
@@ -218,7 +222,7 @@ protected:
                 rv = jit_var_loop(m_name.get(), m_loop_init, m_loop_cond,
                                   m_indices.size(), m_indices_prev.data(),
                                   m_indices.data(), m_jit_state.checkpoint(),
-                                  m_state == 2);
+                                  m_state == 2, m_unroll);
 
                 m_state++;
 
@@ -365,6 +369,9 @@ protected:
     /// Index of the symbolic loop state machine
     uint32_t m_state = 0;
 
+    /// Unroll factor passed to jit_var_loop()
+    uint32_t m_unroll = 1;
+
     // --------------- Wavefront mode ---------------
 
     /// Pointers to loop variable indices (AD handles)
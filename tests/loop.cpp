@@ -347,3 +347,58 @@ TEST_BOTH(10_eval_side_effect_in_loop) {
         jit_assert(strcmp(j.str(), "[12, 13, 11]") == 0);
     }
 }
+
+TEST_CUDA(11_loop_persistent) {
+    // Divergent trip counts with persistent threads
+    jit_set_flag(JitFlag::LoopPersistent, 1);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        UInt32 value = arange<UInt32>(100000) + 1, counter = 0;
+
+        Loop<Mask> loop("Collatz", value, counter);
+        while (loop(neq(value, 1))) {
+            Mask is_even = eq(value & UInt32(1), 0);
+            value = select(is_even, value / 2, value*3 + 1);
+            counter += 1;
+        }
+
+        jit_assert(counter.read(0) == 0 && counter.read(26) == 111 &&
+                   counter.read(77030) == 350);
+    }
+
+    jit_set_flag(JitFlag::LoopPersistent, 0);
+}
+
+TEST_BOTH(12_loop_hoist) {
+    // Arithmetic that doesn't depend on the loop state runs before the loop
+    Float x = arange<Float>(10), y = 0;
+    UInt32 i = 0;
+
+    Loop<Mask> loop("Hoist", y, i);
+    while (loop(i < 4)) {
+        Float scale = sqrt(x) * 2.f + 1.f;
+        y += scale * Float(i);
+        i += 1;
+    }
+
+    Float ref = (sqrt(x) * 2.f + 1.f) * 6.f;
+    for (uint32_t j = 0; j < 10; ++j)
+        jit_assert(std::abs(y.read(j) - ref.read(j)) < 1e-4f);
+}
+
+TEST_BOTH(13_loop_unroll) {
+    // Unrolled iterations must respect lanes that exit at different times
+    for (uint32_t unroll : { 1u, 3u, 4u }) {
+        UInt32 x = arange<UInt32>(10), y = 0, i = 0;
+
+        Loop<Mask> loop("Unroll", y, i);
+        loop.set_unroll(unroll);
+        while (loop(i < x)) {
+            y += i;
+            i += 1;
+        }
+
+        for (uint32_t j = 0; j < 10; ++j)
+            jit_assert(y.read(j) == j * (j - 1) / 2 && i.read(j) == j);
+    }
+}
@@ -1,6 +1,7 @@
 #include "test.h"
 #include <cstring>
 #include <algorithm>
+#include <vector>
 
 TEST_BOTH(01_gather) {
     Int32 r = arange<Int32>(100) + 100;
@@ -315,3 +316,58 @@ TEST_BOTH(18_scatter_inc_mask) {
         }
     }
 }
+
+TEST_BOTH(19_scatter_reduce_private) {
+    // Histograms with few bins are accumulated block-locally
+    constexpr uint32_t n = 100000, bins = 37;
+    UInt32 index = arange<UInt32>(n) % UInt32(bins);
+    UInt32 hist_u = zeros<UInt32>(bins);
+    Float hist_f = zeros<Float>(bins);
+    scatter_reduce(ReduceOp::Add, hist_u, UInt32(1), index);
+    scatter_reduce(ReduceOp::Add, hist_f, Float(2), index, neq(index, 3));
+    jit_eval();
+
+    uint32_t out_u[bins];
+    float out_f[bins];
+    jit_memcpy(Backend, out_u, hist_u.data(), sizeof(out_u));
+    jit_memcpy(Backend, out_f, hist_f.data(), sizeof(out_f));
+
+    for (uint32_t i = 0; i < bins; ++i) {
+        uint32_t ref = n / bins + (i < n % bins ? 1 : 0);
+        jit_assert(out_u[i] == ref);
+        jit_assert(out_f[i] == (i == 3 ? 0.f : 2.f * ref));
+    }
+}
+
+TEST_BOTH(20_compact) {
+    // Compact two arrays using a mask computed in the same kernel
+    constexpr uint32_t n = 10000;
+    UInt32 value = arange<UInt32>(n);
+    Float value_f = Float(value) * 2.f;
+    Mask active = eq(value % UInt32(3), 0);
+
+    uint32_t in[2] = { value.index(), value_f.index() }, out[2];
+    UInt32 count = UInt32::steal(jit_var_compact(active.index(), 2, in, out));
+    UInt32 out_u = UInt32::steal(out[0]);
+    Float out_f = Float::steal(out[1]);
+    jit_eval();
+
+    uint32_t m = 0;
+    jit_memcpy(Backend, &m, count.data(), sizeof(uint32_t));
+    jit_assert(m == (n + 2) / 3);
+
+    std::vector<uint32_t> buf_u(n);
+    std::vector<float> buf_f(n);
+    jit_memcpy(Backend, buf_u.data(), out_u.data(), n * sizeof(uint32_t));
+    jit_memcpy(Backend, buf_f.data(), out_f.data(), n * sizeof(float));
+
+    std::vector<uint32_t> order(m);
+    for (uint32_t i = 0; i < m; ++i) {
+        jit_assert(buf_u[i] % 3 == 0 && buf_f[i] == 2.f * buf_u[i]);
+        order[i] = buf_u[i];
+    }
+
+    std::sort(order.begin(), order.end());
+    for (uint32_t i = 0; i < m; ++i)
+        jit_assert(order[i] == 3 * i);
+}
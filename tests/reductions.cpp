@@ -321,6 +321,128 @@ TEST_BOTH(11_mkperm) {
     }
 }
 
+TEST_LLVM(13_block_prefix_sum) {
+    scoped_set_log_level ssll(LogLevel::Info);
+    for (uint32_t size : { 1000u, 100000u, 1000000u }) {
+        for (uint32_t block_size : { 1u, 3u, 1000u, 50000u }) {
+            for (int exclusive = 0; exclusive < 2; ++exclusive) {
+                UInt32 index = arange<UInt32>(size),
+                       result = full<UInt32>(1, size),
+                       ref = index - (index / block_size) * block_size;
+                if (!exclusive)
+                    ref = ref + 1;
+                jit_var_schedule(result.index());
+                jit_var_schedule(ref.index());
+                jit_eval();
+                jit_block_prefix_sum(UInt32::Backend, VarType::UInt32, exclusive,
+                                     result.data(), size, block_size,
+                                     result.data());
+                jit_assert(result == ref);
+            }
+        }
+    }
+}
+
+TEST_LLVM(14_reduce_by_key) {
+    scoped_set_log_level ssll(LogLevel::Info);
+    for (uint32_t size : { 1u, 1000u, 100000u }) {
+        // Runs of 7 equal keys (the last one may be partial)
+        uint32_t *keys       = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t)),
+                 *values     = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t)),
+                 *keys_out   = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t)),
+                 *values_out = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t));
+
+        for (uint32_t i = 0; i < size; ++i) {
+            keys[i] = i / 7 * 3;
+            values[i] = i;
+        }
+
+        uint32_t count = jit_reduce_by_key(JitBackend::LLVM, VarType::UInt32,
+                                           ReduceOp::Add, keys, values, size,
+                                           keys_out, values_out);
+        jit_sync_thread();
+        jit_assert(count == (size + 6) / 7);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t ref = 0;
+            for (uint32_t j = i * 7; j < std::min(i * 7 + 7, size); ++j)
+                ref += j;
+            jit_assert(keys_out[i] == i * 3 && values_out[i] == ref);
+        }
+
+        jit_free(keys);
+        jit_free(values);
+        jit_free(keys_out);
+        jit_free(values_out);
+    }
+}
+
+TEST_LLVM(15_radix_sort) {
+    scoped_set_log_level ssll(LogLevel::Info);
+    for (uint32_t size : { 1u, 1000u, 100000u }) {
+        uint32_t *keys   = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t)),
+                 *values = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t)),
+                 *perm   = (uint32_t *) jit_malloc(AllocType::Host, size * sizeof(uint32_t));
+        uint64_t *keys_64 = (uint64_t *) jit_malloc(AllocType::Host, size * sizeof(uint64_t));
+
+        // Many duplicate keys to check stability, the two upper bytes are zero
+        uint32_t state = 1;
+        for (uint32_t i = 0; i < size; ++i) {
+            state = state * 1664525u + 1013904223u;
+            keys[i] = (state >> 8) % 5000;
+            keys_64[i] = ((uint64_t) (state % 3) << 40) | keys[i];
+            values[i] = i;
+        }
+
+        jit_argsort(JitBackend::LLVM, VarType::UInt64, keys_64, size, perm);
+        jit_radix_sort(JitBackend::LLVM, VarType::UInt32, keys, values, size);
+        jit_sync_thread();
+
+        for (uint32_t i = 1; i < size; ++i) {
+            jit_assert(keys[i - 1] < keys[i] ||
+                       (keys[i - 1] == keys[i] && values[i - 1] < values[i]));
+            uint64_t k0 = keys_64[perm[i - 1]], k1 = keys_64[perm[i]];
+            jit_assert(k0 < k1 || (k0 == k1 && perm[i - 1] < perm[i]));
+        }
+
+        if (size == 1)
+            jit_assert(values[0] == 0 && perm[0] == 0);
+
+        jit_free(keys);
+        jit_free(values);
+        jit_free(perm);
+        jit_free(keys_64);
+    }
+}
+
+TEST_BOTH(16_reduce_async) {
+    using Bool = Array<bool>;
+
+    scoped_set_log_level ssll(LogLevel::Info);
+    for (uint32_t size : { 1u, 1001u, 100000u }) {
+        Bool t = full<Bool>(true, size);
+        UInt32 x = arange<UInt32>(size);
+        jit_var_eval(t.index());
+        t.write(size / 2, false);
+
+        JitFuture *f_all = jit_var_reduce_async(t.index(), ReduceOp::And),
+                  *f_any = jit_var_reduce_async(t.index(), ReduceOp::Or),
+                  *f_sum = jit_var_reduce_async(x.index(), ReduceOp::Add),
+                  *f_lit = jit_var_reduce_async(UInt32(3).index(), ReduceOp::Max);
+
+        bool r_all = true, r_any = false;
+        uint32_t r_sum = 0, r_lit = 0;
+        jit_future_get(f_all, &r_all);
+        jit_future_get(f_any, &r_any);
+        jit_future_get(f_sum, &r_sum);
+        jit_assert(jit_future_ready(f_lit));
+        jit_future_get(f_lit, &r_lit);
+
+        jit_assert(!r_all && r_any == (size > 1) && r_lit == 3);
+        jit_assert(r_sum == (uint32_t) ((uint64_t) size * (size - 1) / 2));
+    }
+}
+
 #if 0
 TEST_BOTH(12_block_ops) {
     Float a(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f);
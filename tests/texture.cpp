@@ -0,0 +1,282 @@
+#include "test.h"
+#include <drjit-core/texture.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// Deterministic pseudorandom numbers in [0, 1)
+static float tex_rand(uint32_t &state) {
+    state = state * 1664525u + 1013904223u;
+    return (float) (state >> 8) / (float) (1u << 24);
+}
+
+/// Reference implementation of the wrap modes (repeat, clamp, mirror)
+static int32_t tex_ref_wrap(int wrap_mode, int32_t i, int32_t res) {
+    if (wrap_mode == 1)
+        return std::min(std::max(i, 0), res - 1);
+
+    int32_t period = wrap_mode == 0 ? res : 2 * res,
+            m = i % period;
+    if (m < 0)
+        m += period;
+    if (wrap_mode == 2 && m >= res)
+        m = 2 * res - 1 - m;
+    return m;
+}
+
+/// Reference texel coordinates and weights along one dimension
+static uint32_t tex_ref_taps(int filter_mode, int wrap_mode, float pos,
+                             int32_t res, int32_t *coord, double *weight) {
+    double x = (double) pos * res;
+    if (filter_mode == 0) {
+        coord[0] = tex_ref_wrap(wrap_mode, (int32_t) std::floor(x), res);
+        weight[0] = 1.0;
+        return 1;
+    }
+
+    x -= .5;
+    double xf = std::floor(x), f = x - xf;
+    int32_t xi = (int32_t) xf;
+
+    if (filter_mode == 1) {
+        coord[0] = tex_ref_wrap(wrap_mode, xi, res);
+        coord[1] = tex_ref_wrap(wrap_mode, xi + 1, res);
+        weight[0] = 1.0 - f;
+        weight[1] = f;
+        return 2;
+    }
+
+    // Uniform cubic B-spline
+    double g = 1.0 - f;
+    weight[0] = g * g * g / 6.0;
+    weight[1] = (3.0 * f * f * f - 6.0 * f * f + 4.0) / 6.0;
+    weight[2] = (-3.0 * f * f * f + 3.0 * f * f + 3.0 * f + 1.0) / 6.0;
+    weight[3] = f * f * f / 6.0;
+    for (int32_t j = 0; j < 4; ++j)
+        coord[j] = tex_ref_wrap(wrap_mode, xi - 1 + j, res);
+    return 4;
+}
+
+/// Reference lookup into a dense row-major array with interleaved channels
+static void tex_ref_lookup(size_t ndim, const size_t *shape, size_t nc,
+                           const float *data, int filter_mode, int wrap_mode,
+                           const float *pos, double *out) {
+    int32_t coord[3][4] = { }; double weight[3][4] = { };
+    uint32_t n_taps[3] = { 1, 1, 1 };
+    for (size_t i = 0; i < ndim; ++i)
+        n_taps[i] = tex_ref_taps(filter_mode, wrap_mode, pos[i],
+                                 (int32_t) shape[i], coord[i], weight[i]);
+
+    size_t width = shape[0],
+           height = ndim >= 2 ? shape[1] : 1;
+
+    for (size_t ch = 0; ch < nc; ++ch)
+        out[ch] = 0.0;
+
+    for (uint32_t k = 0; k < n_taps[2]; ++k) {
+        for (uint32_t j = 0; j < n_taps[1]; ++j) {
+            for (uint32_t i = 0; i < n_taps[0]; ++i) {
+                double w = weight[0][i] * (ndim >= 2 ? weight[1][j] : 1.0) *
+                           (ndim == 3 ? weight[2][k] : 1.0);
+                size_t offset =
+                    (((size_t) coord[2][k] * height + (size_t) coord[1][j]) *
+                         width + (size_t) coord[0][i]) * nc;
+                for (size_t ch = 0; ch < nc; ++ch)
+                    out[ch] += w * data[offset + ch];
+            }
+        }
+    }
+}
+
+/// Perform a texture lookup at the given positions and return the channels
+template <typename Float>
+static std::vector<Float> tex_lookup(size_t ndim, const void *tex,
+                                     const Float *pos, size_t nc) {
+    uint32_t pos_idx[3], out[8];
+    for (size_t i = 0; i < ndim; ++i)
+        pos_idx[i] = pos[i].index();
+    jit_llvm_tex_lookup(ndim, tex, pos_idx, out);
+
+    std::vector<Float> result;
+    for (size_t ch = 0; ch < nc; ++ch) {
+        result.push_back(Float::steal(out[ch]));
+        jit_var_schedule(out[ch]);
+    }
+    jit_eval();
+    return result;
+}
+
+TEST_LLVM(01_roundtrip) {
+    // Shapes that aren't multiples of the tile size in every dimension
+    const size_t shapes[3][3] = { { 13, 1, 1 }, { 7, 5, 1 }, { 5, 3, 6 } };
+
+    for (size_t ndim = 1; ndim <= 3; ++ndim) {
+        for (size_t nc : { 1, 3 }) {
+            const size_t *shape = shapes[ndim - 1];
+            size_t size = nc;
+            for (size_t i = 0; i < ndim; ++i)
+                size *= shape[i];
+
+            std::vector<float> in(size), out(size, -1.f);
+            for (size_t i = 0; i < size; ++i)
+                in[i] = (float) i;
+
+            void *tex = jit_llvm_tex_create(ndim, shape, nc);
+
+            size_t shape_out[4];
+            jit_llvm_tex_get_shape(ndim, tex, shape_out);
+            for (size_t i = 0; i < ndim; ++i)
+                jit_assert(shape_out[i] == shape[i]);
+            jit_assert(shape_out[ndim] == nc);
+
+            jit_llvm_tex_memcpy_d2t(ndim, shape, in.data(), tex);
+            jit_llvm_tex_memcpy_t2d(ndim, shape, tex, out.data());
+            jit_assert(in == out);
+
+            jit_llvm_tex_destroy(tex);
+        }
+    }
+}
+
+TEST_LLVM(02_lookup_1d) {
+    // Hand-computed lookups into the texture [0, 1, 2, 3]
+    const size_t shape[1] = { 4 };
+    const float data[4] = { 0.f, 1.f, 2.f, 3.f };
+    const float pos_h[3] = { 0.f, .5f, 1.f };
+
+    struct { int filter, wrap; float ref[3]; } cases[] = {
+        { 0, 0, { 0.f, 2.f, 0.f } },
+        { 0, 1, { 0.f, 2.f, 3.f } },
+        { 1, 0, { 1.5f, 1.5f, 1.5f } }, // blends texels 3 and 0 at the ends
+        { 1, 1, { 0.f, 1.5f, 3.f } },
+        { 1, 2, { 0.f, 1.5f, 3.f } },
+        { 2, 1, { 1.f / 48.f, 1.5f, 3.f - 1.f / 48.f } }
+    };
+
+    Float pos = Float::copy(pos_h, 3);
+    for (auto &c : cases) {
+        void *tex = jit_llvm_tex_create(1, shape, 1, c.filter, c.wrap);
+        jit_llvm_tex_memcpy_d2t(1, shape, data, tex);
+        std::vector<Float> result = tex_lookup(1, tex, &pos, 1);
+        jit_llvm_tex_destroy(tex);
+
+        for (uint32_t i = 0; i < 3; ++i) {
+            float value = result[0].read(i);
+            if (std::abs(value - c.ref[i]) > 1e-4f)
+                jit_fail("filter=%i, wrap=%i, pos=%f: got %f, expected %f",
+                         c.filter, c.wrap, pos_h[i], value, c.ref[i]);
+        }
+    }
+}
+
+TEST_LLVM(03_lookup_cubic_properties) {
+    // Cubic B-spline filtering reproduces constant and linear functions
+    const size_t shape[2] = { 9, 6 };
+    std::vector<float> data(9 * 6 * 2);
+    for (size_t y = 0; y < 6; ++y) {
+        for (size_t x = 0; x < 9; ++x) {
+            data[(y * 9 + x) * 2 + 0] = 4.f;
+            data[(y * 9 + x) * 2 + 1] = (float) x + 2.f * (float) y;
+        }
+    }
+
+    void *tex = jit_llvm_tex_create(2, shape, 2, 2, 1);
+    jit_llvm_tex_memcpy_d2t(2, shape, data.data(), tex);
+
+    // Stay away from the boundary, where clamping breaks linearity
+    const uint32_t n = 50;
+    std::vector<float> px(n), py(n);
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < n; ++i) {
+        px[i] = (1.5f + 5.f * tex_rand(state)) / 9.f;
+        py[i] = (1.5f + 2.f * tex_rand(state)) / 6.f;
+    }
+
+    Float pos[2] = { Float::copy(px.data(), n), Float::copy(py.data(), n) };
+    std::vector<Float> result = tex_lookup(2, tex, pos, 2);
+    jit_llvm_tex_destroy(tex);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        float ref = px[i] * 9.f - .5f + 2.f * (py[i] * 6.f - .5f);
+        jit_assert(std::abs(result[0].read(i) - 4.f) < 1e-4f);
+        jit_assert(std::abs(result[1].read(i) - ref) < 1e-3f);
+    }
+}
+
+TEST_LLVM(04_lookup_all_modes) {
+    // Compare every filter and wrap mode against the reference in 1D/2D/3D
+    const size_t shapes[3][3] = { { 11, 1, 1 }, { 6, 9, 1 }, { 5, 7, 4 } };
+    const uint32_t n = 200;
+    const size_t nc = 2;
+    uint32_t state = 7;
+
+    for (size_t ndim = 1; ndim <= 3; ++ndim) {
+        const size_t *shape = shapes[ndim - 1];
+        size_t size = nc;
+        for (size_t i = 0; i < ndim; ++i)
+            size *= shape[i];
+
+        std::vector<float> data(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = tex_rand(state);
+
+        // Include positions outside of [0, 1] to exercise the wrap modes
+        std::vector<float> pos_h(ndim * n);
+        for (size_t i = 0; i < ndim * n; ++i)
+            pos_h[i] = 3.f * tex_rand(state) - 1.f;
+
+        Float pos[3];
+        for (size_t i = 0; i < ndim; ++i)
+            pos[i] = Float::copy(pos_h.data() + i * n, n);
+
+        for (int filter = 0; filter < 3; ++filter) {
+            for (int wrap = 0; wrap < 3; ++wrap) {
+                void *tex = jit_llvm_tex_create(ndim, shape, nc, filter, wrap);
+                jit_llvm_tex_memcpy_d2t(ndim, shape, data.data(), tex);
+                std::vector<Float> result = tex_lookup(ndim, tex, pos, nc);
+                jit_llvm_tex_destroy(tex);
+
+                for (uint32_t j = 0; j < n; ++j) {
+                    float p[3];
+                    double ref[nc];
+                    for (size_t i = 0; i < ndim; ++i)
+                        p[i] = pos_h[i * n + j];
+                    tex_ref_lookup(ndim, shape, nc, data.data(), filter, wrap,
+                                   p, ref);
+
+                    for (size_t ch = 0; ch < nc; ++ch) {
+                        float value = result[ch].read(j);
+                        if (std::abs(value - (float) ref[ch]) > 1e-4f)
+                            jit_fail("ndim=%zu, filter=%i, wrap=%i, entry %u, "
+                                     "channel %zu: got %f, expected %f", ndim,
+                                     filter, wrap, j, ch, value, ref[ch]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_LLVM(05_bilerp_fetch) {
+    // The four texels of a bilinear lookup in the order of CUDA's tld4
+    const size_t shape[2] = { 4, 3 };
+    float data[12];
+    for (uint32_t i = 0; i < 12; ++i)
+        data[i] = (float) i;
+
+    void *tex = jit_llvm_tex_create(2, shape, 1, 1, 1);
+    jit_llvm_tex_memcpy_d2t(2, shape, data, tex);
+
+    // Position between the texels (1, 0), (2, 0), (1, 1) and (2, 1)
+    float px = 2.f / 4.f, py = 1.f / 3.f;
+    Float pos[2] = { Float::copy(&px, 1), Float::copy(&py, 1) };
+    uint32_t pos_idx[2] = { pos[0].index(), pos[1].index() }, out[4];
+    jit_llvm_tex_bilerp_fetch(2, tex, pos_idx, out);
+    jit_llvm_tex_destroy(tex);
+
+    const float ref[4] = { 5.f, 6.f, 2.f, 1.f };
+    for (uint32_t i = 0; i < 4; ++i) {
+        Float value = Float::steal(out[i]);
+        jit_assert(value.read(0) == ref[i]);
+    }
+}
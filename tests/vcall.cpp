@@ -2,7 +2,10 @@
 #include "traits.h"
 #include <drjit-core/containers.h>
 #include <drjit-core/state.h>
+#include <atomic>
+#include <thread>
 #include <utility>
+#include <vector>
 
 namespace dr = drjit;
 
@@ -961,3 +964,284 @@ TEST_BOTH(13_load_bool_data) {
         jit_registry_trim();
     }
 }
+
+TEST_CUDA(14_coherent_vcall) {
+    // Entries are processed in sorted order, results must be unaffected
+    struct Base {
+        virtual Float f(Float x) = 0;
+    };
+
+    struct A1 : Base {
+        Float f(Float x) override { return (x + 10) * 2; }
+    };
+
+    struct A2 : Base {
+        Float f(Float x) override { return (x + 100) * 2; }
+    };
+
+    A1 a1;
+    A2 a2;
+    uint32_t i1 = jit_registry_put(Backend, "Base", &a1);
+    uint32_t i2 = jit_registry_put(Backend, "Base", &a2);
+    jit_assert(i1 == 1 && i2 == 2);
+
+    jit_set_flag(JitFlag::VCallCoherent, 1);
+
+    using BasePtr = Array<Base *>;
+    Float x = arange<Float>(10);
+    BasePtr self = arange<UInt32>(10) % 3;
+
+    Float y = vcall(
+        "Base", [](Base *self2, Float x2) { return self2->f(x2); }, self, x);
+    jit_assert(strcmp(y.str(), "[0, 22, 204, 0, 28, 210, 0, 34, 216, 0]") == 0);
+
+    jit_set_flag(JitFlag::VCallCoherent, 0);
+
+    jit_registry_remove(Backend, &a1);
+    jit_registry_remove(Backend, &a2);
+}
+
+TEST_BOTH(15_vcall_literal_data) {
+    // Changing a literal constant of an instance should reuse the kernel
+    struct Base {
+        virtual Float f(Float x) = 0;
+    };
+
+    struct A1 : Base {
+        float scale = 2.f;
+        Float f(Float x) override { return x * scale; }
+    };
+
+    struct A2 : Base {
+        Float f(Float x) override { return x + 1; }
+    };
+
+    A1 a1;
+    A2 a2;
+    uint32_t i1 = jit_registry_put(Backend, "Base", &a1);
+    uint32_t i2 = jit_registry_put(Backend, "Base", &a2);
+    jit_assert(i1 == 1 && i2 == 2);
+
+    jit_set_flag(JitFlag::VCallLiteralData, 1);
+
+    using BasePtr = Array<Base *>;
+    Float x = arange<Float>(6);
+    BasePtr self = arange<UInt32>(6) % 3;
+
+    const char *ref[] = { "[0, 2, 3, 0, 8, 6]", "[0, 3, 3, 0, 12, 6]" };
+    size_t misses[2];
+
+    for (int i = 0; i < 2; ++i) {
+        a1.scale = i == 0 ? 2.f : 3.f;
+
+        Float y = vcall(
+            "Base", [](Base *self2, Float x2) { return self2->f(x2); }, self, x);
+        jit_assert(strcmp(y.str(), ref[i]) == 0);
+
+        size_t soft_misses, hard_misses;
+        jit_kernel_cache_stats(nullptr, &soft_misses, &hard_misses, nullptr);
+        misses[i] = soft_misses + hard_misses;
+    }
+
+    jit_assert(misses[0] == misses[1]);
+
+    jit_set_flag(JitFlag::VCallLiteralData, 0);
+
+    jit_registry_remove(Backend, &a1);
+    jit_registry_remove(Backend, &a2);
+}
+
+TEST_BOTH(16_vcall_profile) {
+    /* The first call is counted, and the later ones call the most
+       frequent instance directly. Results must be unaffected. */
+    struct Base {
+        virtual Float f(Float x) = 0;
+    };
+
+    struct A1 : Base {
+        Float f(Float x) override { return x * 2; }
+    };
+
+    struct A2 : Base {
+        Float f(Float x) override { return x + 1; }
+    };
+
+    A1 a1;
+    A2 a2;
+    uint32_t i1 = jit_registry_put(Backend, "Base", &a1);
+    uint32_t i2 = jit_registry_put(Backend, "Base", &a2);
+    jit_assert(i1 == 1 && i2 == 2);
+
+    jit_set_flag(JitFlag::VCallProfile, 1);
+
+    using BasePtr = Array<Base *>;
+    Float x = arange<Float>(8);
+    BasePtr self = select(eq(arange<UInt32>(8), 5), UInt32(2), UInt32(1));
+
+    for (int i = 0; i < 3; ++i) {
+        Float y = vcall(
+            "Base", [](Base *self2, Float x2) { return self2->f(x2); }, self, x);
+        jit_assert(strcmp(y.str(), "[0, 2, 4, 6, 8, 6, 12, 14]") == 0);
+    }
+
+    jit_set_flag(JitFlag::VCallProfile, 0);
+
+    jit_registry_remove(Backend, &a1);
+    jit_registry_remove(Backend, &a2);
+}
+
+TEST_BOTH(17_registry_lookup) {
+    // Enough pointers to enlarge the lock-free lookup tables several times
+    int data[300];
+    char domain[] = "Registry";
+    for (uint32_t i = 0; i < 300; ++i)
+        jit_assert(jit_registry_put(Backend, domain, data + i) == i + 1);
+
+    for (uint32_t i = 0; i < 300; i += 2)
+        jit_registry_remove(Backend, data + i);
+
+    // Domains are compared by value, not by address
+    for (uint32_t i = 0; i < 300; ++i) {
+        void *ptr = jit_registry_get_ptr(Backend, "Registry", i + 1);
+        jit_assert(ptr == (i % 2 ? data + i : nullptr));
+        if (i % 2)
+            jit_assert(jit_registry_get_id(Backend, data + i) == i + 1);
+    }
+
+    // Removed IDs are reused
+    jit_assert(jit_registry_put(Backend, domain, data) == 299);
+    jit_assert(jit_registry_get_id(Backend, data) == 299);
+    jit_assert(jit_registry_get_ptr(Backend, domain, 299) == data);
+    jit_registry_remove(Backend, data);
+
+    for (uint32_t i = 1; i < 300; i += 2)
+        jit_registry_remove(Backend, data + i);
+    jit_registry_trim();
+}
+
+TEST_BOTH(18_registry_attr) {
+    // Attribute changes become visible to kernels launched afterwards
+    int data[64];
+    for (uint32_t i = 0; i < 64; ++i) {
+        jit_registry_put(Backend, "Attr", data + i);
+        float value = (float) i;
+        jit_registry_set_attr(Backend, data + i, "value", &value, sizeof(float));
+    }
+
+    for (int k = 0; k < 2; ++k) {
+        Float attr = Float::steal(
+            jit_var_registry_attr(Backend, VarType::Float32, "Attr", "value"));
+        Float result = attr * 2.f;
+
+        for (uint32_t i = 0; i < 64; ++i) {
+            float ref = (float) i * (k == 1 && (i == 3 || i == 40) ? -2.f : 2.f);
+            jit_assert(result.read(i + 1) == ref);
+        }
+
+        for (uint32_t i : { 3u, 40u }) {
+            float value = -(float) i;
+            jit_registry_set_attr(Backend, data + i, "value", &value, sizeof(float));
+        }
+    }
+
+    for (uint32_t i = 0; i < 64; ++i)
+        jit_registry_remove(Backend, data + i);
+    jit_registry_trim();
+}
+
+TEST_BOTH(19_registry_concurrent) {
+    /* Lock-free lookups race with registrations that enlarge and retire the
+       lookup tables. Every lookup must either miss or find the right entry */
+    const uint32_t n = 4000;
+    std::unique_ptr<int[]> data(new int[n]);
+    std::atomic<bool> done { false };
+
+    jit_registry_put(Backend, "Concurrent", data.get());
+
+    auto reader = [&]() {
+        while (!done.load()) {
+            for (uint32_t i = 1; i <= n; i += 7) {
+                void *ptr = jit_registry_get_ptr(Backend, "Concurrent", i);
+                jit_assert(!ptr || ptr == data.get() + i - 1);
+                try {
+                    jit_assert(jit_registry_get_id(Backend, data.get() + i - 1) == i);
+                } catch (...) {
+                    // Not registered at the moment
+                }
+            }
+        }
+    };
+
+    std::thread threads[4];
+    for (std::thread &t : threads)
+        t = std::thread(reader);
+
+    for (int k = 0; k < 10; ++k) {
+        for (uint32_t i = 1; i < n; ++i)
+            jit_assert(jit_registry_put(Backend, "Concurrent", data.get() + i) == i + 1);
+        for (uint32_t i = 1; i < n; ++i)
+            jit_registry_remove(Backend, data.get() + i);
+        jit_registry_trim();
+    }
+
+    done.store(true);
+    for (std::thread &t : threads)
+        t.join();
+
+    jit_registry_remove(Backend, data.get());
+    jit_registry_trim();
+}
+
+TEST_BOTH(20_vcall_expired_output) {
+    /* Without JitFlag::VCallOptimize, expired outputs stay part of the call.
+       A new variable that reuses the index of such an output must not be
+       mistaken for it during code generation. */
+    struct Base {
+        virtual dr_tuple<Float, Float> f(Float p1, Float p2) = 0;
+    };
+
+    struct C1 : Base {
+        dr_tuple<Float, Float> f(Float p1, Float p2) override {
+            return { p1 + p2, p1 * p2 };
+        }
+    };
+
+    struct C2 : Base {
+        dr_tuple<Float, Float> f(Float p1, Float p2) override {
+            return { p1 - p2, p1 + 2.f };
+        }
+    };
+
+    C1 c1; C2 c2;
+    jit_registry_put(Backend, "Base", &c1);
+    jit_registry_put(Backend, "Base", &c2);
+
+    jit_set_flag(JitFlag::VCallOptimize, 0);
+
+    Float p1 = dr::opaque<Float>(3), p2 = dr::opaque<Float>(4);
+
+    using BasePtr = Array<Base *>;
+    BasePtr self = arange<UInt32>(6) % 3;
+
+    auto result = vcall(
+        "Base",
+        [](Base *self2, Float p1, Float p2) { return self2->f(p1, p2); },
+        self, p1, p2);
+
+    result.template get<0>() = Float(0);
+
+    // The counter of 'z' reuses the index of the expired output
+    Float z = arange<Float>(6) * 2.f;
+
+    Float &out = result.template get<1>();
+    jit_var_schedule(out.index());
+    jit_var_schedule(z.index());
+    jit_eval();
+
+    jit_assert(strcmp(jit_var_str(out.index()), "[0, 12, 5, 0, 12, 5]") == 0);
+    jit_assert(strcmp(jit_var_str(z.index()), "[0, 2, 4, 6, 8, 10]") == 0);
+
+    jit_set_flag(JitFlag::VCallOptimize, 1);
+    jit_registry_remove(Backend, &c1);
+    jit_registry_remove(Backend, &c2);
+}